@@ -0,0 +1,540 @@
+/*
+ *  File:       BatchRender.cpp
+ *  Summary:   	Console app that renders HyperMandella documents without any UI.
+ *  Written by: Jesse Jones
+ *
+ *	Abstract:	Usage: BatchRender [options] <document> <png file>
+ *				       BatchRender [options] -frames <count> <document>... <png prefix>
+ *					-size <width>x<height>		overrides the document's resolution
+ *					-threads <count>			defaults to the number of processors
+ *					-kernel packet|scalar|estimate	see ERayKernel (defaults to scalar)
+ *					-antialias					anti-alias the edges of the fractal
+ *					-progressive				render the coarse preview passes first
+ *					-frames <count>				render an animation (see below)
+ *					-orbit						animate by orbiting the camera around the point of interest
+ *					-independent				render every frame from scratch
+ *					-lanes <count>				number of frames rendered at once (defaults to the thread count)
+ *
+ *				The document may be an XML file or a PNG written by HyperMandella.
+ *				When rendering an animation the documents are keyframes which are
+ *				spread evenly across the frames (or, with -orbit, a single document
+ *				is orbited once) and the frames are written to <png prefix>0000.png,
+ *				<png prefix>0001.png, etc. The frames are split into one run of
+ *				consecutive frames per lane and the runs are rendered at the same
+ *				time with the threads divided between the lanes.
+ *				When the render finishes the time spent in each phase of the render
+ *				is written to stdout (when more than one thread is used the phase
+ *				times are summed across the threads so they'll add up to more than
+ *				the elapsed time).
+ *
+ *				This is a console target built from the same sources as the app
+ *				(like the Core Tester) so it only runs on the Mac and Windows:
+ *				Whisper has no POSIX file or thread code. It doesn't call InitUI
+ *				so no windows are opened.
+ *
+ *  Copyright  2001 Jesse Jones.
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).
+ *
+ *  Change History (most recent first):
+ *
+ *		$Log: BatchRender.cpp,v $
+ */
+
+#include "AppHeader.h"
+
+#include <cstdio>
+
+#if MAC
+	#include <console.h>
+#endif
+
+#include <IDocReader.h>
+#include <IDocWriter.h>
+#include <XFileSpec.h>
+#include <XFloatConversions.h>
+#include <XIntConversions.h>
+#include <XMiscUtils.h>
+#include <XObjectModel.h>
+#include <XPixMap.h>
+#include <XSystemInfo.h>
+#include <XTrace.h>
+#include <XTraceSinks.h>
+#include <XTranscode.h>
+#include <XURI.h>
+
+#include "CRegisterClasses.h"
+#include "CSequenceRenderer.h"
+#include "ICamera.h"
+#include "IDocInfo.h"
+#include "IRenderer.h"
+
+using namespace Whisper;
+
+
+//-----------------------------------
+//	Types
+//
+struct SOptions {
+	std::vector<std::wstring> inputs;
+	std::wstring	output;					// file name or, for animations, the file name prefix
+
+	XSize			size;					// kZeroSize if the document's resolution should be used
+	int32			threads;
+	ERayKernel		kernel;
+	bool			antiAlias;
+	bool			progressive;
+	
+	uint32			frames;					// zero if we're rendering a still
+	bool			orbit;
+	bool			coherent;
+	int32			lanes;					// number of frames rendered at the same time
+};
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// Init
+//
+//---------------------------------------------------------------
+static void Init()
+{
+#if DEBUG
+	XTraceSink* sink = new XDebuggerSink;
+	XTrace::Instance()->AddSink(sink);
+#endif
+
+	// Unlike the app we don't call InitUI: everything below talks
+	// to the object model and the persistence code.
+	RegisterInterfaces();
+	RegisterImplementations();
+
+	XURI uri(L"resource://Bosses.bXML");
+	XObjectModel::Instance()->LoadBosses(nil, uri);
+
+	RegisterLoaders();
+}
+
+
+//---------------------------------------------------------------
+//
+// Usage
+//
+//---------------------------------------------------------------
+static void Usage()
+{
+	std::fprintf(stderr, "Usage: BatchRender [options] <document> <png file>\n");
+	std::fprintf(stderr, "       BatchRender [options] -frames <count> <document>... <png prefix>\n");
+	std::fprintf(stderr, "    -size <width>x<height>\n");
+	std::fprintf(stderr, "    -threads <count>\n");
+	std::fprintf(stderr, "    -kernel packet|scalar|estimate\n");
+	std::fprintf(stderr, "    -antialias\n");
+	std::fprintf(stderr, "    -progressive\n");
+	std::fprintf(stderr, "    -frames <count>\n");
+	std::fprintf(stderr, "    -orbit\n");
+	std::fprintf(stderr, "    -independent\n");
+	std::fprintf(stderr, "    -lanes <count>\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// ParseOptions
+//
+// Returns false if the command line was malformed.
+//
+//---------------------------------------------------------------
+static bool ParseOptions(int argc, char* argv[], SOptions& options)
+{
+	options.size      = kZeroSize;
+	options.threads   = (int32) XSystemInfo::GetProcessorCount();
+	options.kernel    = kScalarKernel;
+	options.antiAlias = false;
+	options.progressive = false;
+	options.frames    = 0;
+	options.orbit     = false;
+	options.coherent  = true;
+	options.lanes     = 0;
+
+	bool ok = true;
+	std::vector<std::wstring> files;
+
+	for (int i = 1; i < argc && ok; ++i) {
+		std::wstring arg = FromPlatformStr(argv[i]);
+		bool hasValue = i + 1 < argc;
+
+		if (arg == L"-size" && hasValue) {
+			std::wstring value = FromPlatformStr(argv[++i]);
+
+			std::wstring::size_type pos = value.find(L'x');
+			ok = pos != std::wstring::npos;
+			if (ok) {
+				options.size.width  = StrToInt32(value.substr(0, pos));
+				options.size.height = StrToInt32(value.substr(pos + 1));
+				ok = options.size.width > 0 && options.size.height > 0;
+			}
+
+		} else if (arg == L"-threads" && hasValue) {
+			options.threads = StrToInt32(FromPlatformStr(argv[++i]));
+			ok = options.threads > 0;
+
+		} else if (arg == L"-kernel" && hasValue) {
+			std::wstring value = FromPlatformStr(argv[++i]);
+
+			if (value == L"packet")
+				options.kernel = kPacketKernel;
+			else if (value == L"scalar")
+				options.kernel = kScalarKernel;
+			else if (value == L"estimate")
+				options.kernel = kEstimateKernel;
+			else
+				ok = false;
+
+		} else if (arg == L"-antialias") {
+			options.antiAlias = true;
+
+		} else if (arg == L"-progressive") {
+			options.progressive = true;
+
+		} else if (arg == L"-frames" && hasValue) {
+			int32 frames = StrToInt32(FromPlatformStr(argv[++i]));
+			ok = frames > 0;
+			options.frames = (uint32) frames;
+
+		} else if (arg == L"-orbit") {
+			options.orbit = true;
+
+		} else if (arg == L"-independent") {
+			options.coherent = false;
+
+		} else if (arg == L"-lanes" && hasValue) {
+			options.lanes = StrToInt32(FromPlatformStr(argv[++i]));
+			ok = options.lanes > 0;
+
+		} else if (arg.length() > 0 && arg[0] != '-') {
+			files.push_back(arg);
+
+		} else
+			ok = false;
+	}
+
+	if (ok && files.size() >= 2) {
+		options.inputs.assign(files.begin(), files.end() - 1);
+		options.output = files.back();
+
+		if (options.frames == 0)
+			ok = options.inputs.size() == 1 && !options.orbit;
+		else if (options.orbit)
+			ok = options.inputs.size() == 1 && options.frames >= 4;
+		else
+			ok = options.frames >= options.inputs.size();
+
+		if (options.lanes == 0)
+			options.lanes = options.threads;
+
+	} else
+		ok = false;
+
+	return ok;
+}
+
+
+//---------------------------------------------------------------
+//
+// ReadDocument
+//
+//---------------------------------------------------------------
+static void ReadDocument(XBoss* boss, const XFileSpec& spec)
+{
+	PRECONDITION(boss != nil);
+
+	IDocReaderPtr reader;
+
+	OSType type = '????';
+#if MAC
+	type = spec.GetType();
+#endif
+
+	XBoss::iterator iter = boss->begin();
+	while (iter != boss->end() && !reader) {
+		IDocReaderPtr candidate(boss, iter);
+		++iter;
+
+		if (candidate && candidate->CanRead(type, spec.GetExtension()))
+			reader = candidate;
+	}
+
+	if (!reader)
+		throw std::runtime_error(ToUTF8Str(L"Can't read '" + spec.GetName() + L"'."));
+
+	reader->Read(spec);
+}
+
+
+//---------------------------------------------------------------
+//
+// WriteImage
+//
+//---------------------------------------------------------------
+static void WriteImage(XBoss* boss, const XFileSpec& spec)
+{
+	PRECONDITION(boss != nil);
+
+	IDocWriterPtr writer;
+
+	XBoss::iterator iter = boss->begin();
+	while (iter != boss->end() && !writer) {
+		IDocWriterPtr candidate(boss, iter);
+		++iter;
+
+		if (candidate && candidate->GetType().GetType() == 'PNGf')
+			writer = candidate;
+	}
+
+	ASSERT(writer);									// should have a CPngWriter (and the renderer always uses millions of colors)
+	ASSERT(writer->CanWrite());
+
+	writer->Write('PNGf', spec);
+}
+
+
+//---------------------------------------------------------------
+//
+// PrintTime
+//
+//---------------------------------------------------------------
+static void PrintTime(const char* phase, MilliSecond time, MilliSecond total)
+{
+	double percent = total > 0 ? 100.0*time/total : 0.0;
+
+	std::printf("%-16s %8ld ms  %s%%\n", phase, time, ToPlatformStr(DoubleToStr(percent, 5, 1)).c_str());
+}
+
+
+//---------------------------------------------------------------
+//
+// PrintPhases
+//
+//---------------------------------------------------------------
+static void PrintPhases(const SRenderTimes& times)
+{
+	MilliSecond phases = times.rayCasting + times.normals + times.shading + times.antiAliasing;
+
+	PrintTime("ray casting", times.rayCasting, phases);
+	PrintTime("normals", times.normals, phases);
+	PrintTime("shading", times.shading, phases);
+	PrintTime("anti-aliasing", times.antiAliasing, phases);
+}
+
+
+//---------------------------------------------------------------
+//
+// ConfigureRenderer
+//
+//---------------------------------------------------------------
+static void ConfigureRenderer(const IDocInfoPtr& info, const SOptions& options, int32 threads)
+{
+	const SResolution& resolution = info->GetResolution();
+
+	IRendererPtr renderer(info);
+	renderer->Reset(info);
+	renderer->SetResolution(XSize(resolution.width, resolution.height), 32);
+	renderer->SetThreadCount(threads);
+	renderer->SetKernel(options.kernel);
+	renderer->EnableAntiAliasing(options.antiAlias);
+	renderer->EnableProgressive(options.progressive);
+}
+
+
+//---------------------------------------------------------------
+//
+// CreateRenderer
+//
+// Returns a batch renderer boss with the first document loaded
+// and the renderer configured. Call Reset(IDocInfoPtr()) on the
+// renderer when finished to break the cycle between the renderer
+// and the doc info.
+//
+//---------------------------------------------------------------
+static IDocInfoPtr CreateRenderer(const SOptions& options)
+{
+	IDocInfoPtr info(L"Batch Renderer");
+	ReadDocument(info->GetBoss(), XFileSpec(options.inputs[0]));
+
+	SResolution resolution = info->GetResolution();
+	if (options.size != kZeroSize) {
+		resolution.width  = options.size.width;
+		resolution.height = options.size.height;
+		info->SetResolution(resolution, false);
+	}
+
+	ConfigureRenderer(info, options, options.threads);
+
+	return info;
+}
+
+
+//---------------------------------------------------------------
+//
+// Render
+//
+//---------------------------------------------------------------
+static void Render(const SOptions& options)
+{
+	XFileSpec output(options.output);
+
+	MilliSecond startTime = GetMilliSeconds();
+
+	IDocInfoPtr info = CreateRenderer(options);
+	XBoss* boss = info->GetBoss();
+
+	SResolution resolution = info->GetResolution();
+	IRendererPtr renderer(info);
+
+	MilliSecond renderTime = GetMilliSeconds();
+
+	while (!renderer->IsDone())
+		(void) renderer->Render(1000);
+
+	MilliSecond writeTime = GetMilliSeconds();
+
+	WriteImage(boss, output);
+
+	MilliSecond stopTime = GetMilliSeconds();
+
+	// Report where the time went.
+	std::printf("%ld x %ld pixels, %ld threads\n", resolution.width, resolution.height, options.threads);
+	PrintTime("loading", renderTime - startTime, stopTime - startTime);
+	PrintTime("rendering", writeTime - renderTime, stopTime - startTime);
+	PrintTime("writing", stopTime - writeTime, stopTime - startTime);
+	std::printf("\n");
+
+	PrintPhases(renderer->GetTimes());
+
+	renderer->Reset(IDocInfoPtr());					// have to break a cycle
+}
+
+
+//---------------------------------------------------------------
+//
+// RenderSequence
+//
+// Each lane gets its own copy of the document and an equal share
+// of the threads.
+//
+//---------------------------------------------------------------
+static void RenderSequence(const SOptions& options)
+{
+	MilliSecond startTime = GetMilliSeconds();
+
+	int32 numLanes = Min(options.lanes, (int32) options.frames);
+	int32 threads = Max(options.threads/numLanes, 1L);
+
+	IDocInfoPtr info = CreateRenderer(options);
+	IRendererPtr renderer(info);
+	renderer->SetThreadCount(threads);
+
+	CSequenceRenderer sequence(info);
+	sequence.EnableCoherence(options.coherent);
+
+	std::vector<IDocInfoPtr> lanes;
+	for (int32 i = 1; i < numLanes; ++i) {
+		IDocInfoPtr lane(L"Batch Renderer");
+		lane->Reset(IConstDocInfoPtr(info));
+		ConfigureRenderer(lane, options, threads);
+
+		sequence.AddLane(lane);
+		lanes.push_back(lane);
+	}
+
+	if (options.orbit) {
+		sequence.AddOrbit(options.frames);
+
+	} else {
+		uint32 numKeys = options.inputs.size();
+		for (uint32 i = 0; i < numKeys; ++i) {
+			IDocInfoPtr doc = info;
+			if (i > 0) {
+				doc = IDocInfoPtr(L"Batch Renderer");
+				ReadDocument(doc->GetBoss(), XFileSpec(options.inputs[i]));
+			}
+
+			SKeyframe key;
+			key.frame     = numKeys > 1 ? i*(options.frames - 1)/(numKeys - 1) : 0;
+			key.placement = IConstCameraPtr(doc)->GetPlacement();
+			key.fractal   = doc->GetFractalInfo();
+			sequence.AddKeyframe(key);
+		}
+	}
+
+	MilliSecond renderTime = GetMilliSeconds();
+
+	sequence.Render(options.frames, options.output);
+
+	MilliSecond stopTime = GetMilliSeconds();
+
+	// Report where the time went.
+	const SResolution& resolution = info->GetResolution();
+	double perFrame = (double) (stopTime - renderTime)/options.frames;
+
+	std::printf("%lu frames, %ld x %ld pixels, %ld lanes with %ld threads each\n", options.frames, resolution.width, resolution.height, numLanes, threads);
+	PrintTime("loading", renderTime - startTime, stopTime - startTime);
+	PrintTime("rendering", stopTime - renderTime, stopTime - startTime);
+	std::printf("%s ms per frame\n\n", ToPlatformStr(DoubleToStr(perFrame, 1, 1)).c_str());
+
+	PrintPhases(sequence.GetTimes());
+
+	renderer->Reset(IDocInfoPtr());					// have to break a cycle
+	for (uint32 i = 0; i < lanes.size(); ++i)
+		IRendererPtr(lanes[i])->Reset(IDocInfoPtr());
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	Main Entry Point
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// main
+//
+//---------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	int result = 0;
+
+#if MAC
+	argc = ccommand(&argv);							// the Finder doesn't pass a command line so let the user type one in
+#endif
+
+	try {
+		SOptions options;
+		if (ParseOptions(argc, argv, options)) {
+			Init();
+			if (options.frames > 0)
+				RenderSequence(options);
+			else
+				Render(options);
+
+		} else {
+			Usage();
+			result = 2;
+		}
+
+	} catch (const std::exception& e) {
+		std::fprintf(stderr, "BatchRender failed: %s\n", e.what());
+		result = 1;
+
+	} catch (...) {
+		std::fprintf(stderr, "BatchRender failed: unknown exception\n");
+		result = 1;
+	}
+
+	return result;
+}
@@ -50,213 +50,366 @@ CColorEvaluator::~CColorEvaluator()
 //---------------------------------------------------------------
 CColorEvaluator::CColorEvaluator(const std::wstring& formula)
 {		
+	mTypes.resize(3, kVariableRegister);			// x, y, and z
+	mValues.resize(3, 0.0);
+	
 	XAutoPtr<CColorTree> tree(CColorTree::Create(formula));
 	
-	tree->Compile(*this);
+	mResult = tree->Compile(*this);
+	
+	// The span version of Evaluate never writes into the constant
+	// registers so we can initialize them here.
+	uint32 numRegisters = mTypes.size();
+	mBlock.resize(numRegisters*kColorBlockSize, 0.0);
+	
+	for (uint32 reg = 0; reg < numRegisters; ++reg)
+		if (mTypes[reg] == kConstantRegister)
+			std::fill_n(&mBlock[reg*kColorBlockSize], kColorBlockSize, mValues[reg]);
 }
 
 
 //---------------------------------------------------------------
 //
-// CColorEvaluator::Evaluate
+// CColorEvaluator::Evaluate (X3DPoint)
 //
 //---------------------------------------------------------------
 double CColorEvaluator::Evaluate(const X3DPoint& pt)
 {
-	PRECONDITION(mStack.empty());
+	double* values = &mValues[0];
 	
-	double lhs, rhs, result;
+	values[0] = pt.x;
+	values[1] = pt.y;
+	values[2] = pt.z;
 	
-	uint32 count = mTokens.size();
+	uint32 count = mCode.size();
 	for (uint32 index = 0; index < count; ++index) {
-		TokenNum token = mTokens[index];
+		const SInstruction& instruction = mCode[index];
 		
-		switch (token) {
-			case kPowToken:
-				rhs = mStack.top();
-				mStack.pop();
-
-				lhs = mStack.top();
-				mStack.pop();
-				
-				result = pow(lhs, rhs);
-				break;
-				
-			case kAddToken:
-				rhs = mStack.top();
-				mStack.pop();
-
-				lhs = mStack.top();
-				mStack.pop();
-				
-				result = lhs + rhs;
-				break;
-
-			case kMinusToken:
-				rhs = mStack.top();
-				mStack.pop();
-
-				lhs = mStack.top();
-				mStack.pop();
-				
-				result = lhs - rhs;
-				break;
-
-			case kProductToken:
-				rhs = mStack.top();
-				mStack.pop();
-
-				lhs = mStack.top();
-				mStack.pop();
-				
-				result = lhs*rhs;
-				break;
-
-			case kDivideToken:
-				rhs = mStack.top();
-				mStack.pop();
-
-				lhs = mStack.top();
-				mStack.pop();
-				
-				result = lhs/rhs;
-				break;
-
-			case kXVariableToken:
-				result = pt.x;
-				break;
-
-			case kYVariableToken:
-				result = pt.y;
-				break;
-
-			case kZVariableToken:
-				result = pt.z;
-				break;
-
-			case kSinFunctionToken:
-				rhs = mStack.top();
-				mStack.pop();
-				
-				result = sin(rhs);
-				break;
-				
-			case kCosFunctionToken:
-				rhs = mStack.top();
-				mStack.pop();
-				
-				result = cos(rhs);
-				break;
-				
-			case kTanFunctionToken:
-				rhs = mStack.top();
-				mStack.pop();
-				
-				result = tan(rhs);
-				break;
-				
-			case kSqrFunctionToken:
-				rhs = mStack.top();
-				mStack.pop();
-				
-				result = rhs*rhs;
-				break;
-				
-			case kSqrtFunctionToken:
-				rhs = mStack.top();
-				mStack.pop();
-				
-				result = sqrt(rhs);
-				break;
-				
-			case kExpFunctionToken:
-				rhs = mStack.top();
-				mStack.pop();
-				
-				result = exp(rhs);
-				break;
-				
-			case kLnFunctionToken:
-				rhs = mStack.top();
-				mStack.pop();
-				
-				result = log(rhs);
-				break;
-				
-			case kLogFunctionToken:
-				rhs = mStack.top();
-				mStack.pop();
-				
-				result = log10(rhs);
-				break;
-				
-			case kRoundFunctionToken:
-				rhs = mStack.top();
-				mStack.pop();
-				
-				result = round(rhs);
-				break;
-				
-			case kTruncFunctionToken:
-				rhs = mStack.top();
-				mStack.pop();
-				
-				result = trunc(rhs);
-				break;
-				
-			case kAbsFunctionToken:
-				rhs = mStack.top();
-				mStack.pop();
-				
-				result = Abs(rhs);
-				break;
-				
-			case kRandomFunctionToken:
-				rhs = mStack.top();
-				mStack.pop();
-				
-				result = rhs*Random(1.0);
-				break;
-				
-			default:
-				if (token < 0)
-					result = mLiterals[Abs(token) - 1UL];
-				else
-					DEBUGSTR("Bad token in CColorEvaluator::Evaluate:", token);
+		values[instruction.dst] = DoApply(instruction.token, values[instruction.lhs], values[instruction.rhs]);
+	}
+	
+	return values[mResult];
+}
+
+
+//---------------------------------------------------------------
+//
+// CColorEvaluator::Evaluate (const X3DPoint*, uint32, double*)
+//
+// The simple operations are inlined so that the loops vectorize.
+// The transcendental functions are done via DoApply.
+//
+//---------------------------------------------------------------
+void CColorEvaluator::Evaluate(const X3DPoint* pts, uint32 count, double* results)
+{
+	PRECONDITION(pts != nil || count == 0);
+	PRECONDITION(results != nil || count == 0);
+	
+	double* block = &mBlock[0];
+	double* x = block;
+	double* y = block + kColorBlockSize;
+	double* z = block + 2*kColorBlockSize;
+	
+	uint32 numInstructions = mCode.size();
+	
+	for (uint32 start = 0; start < count; start += kColorBlockSize) {
+		uint32 n = Min(count - start, kColorBlockSize);
+		
+		const X3DPoint* points = pts + start;
+		for (uint32 i = 0; i < n; ++i) {
+			x[i] = points[i].x;
+			y[i] = points[i].y;
+			z[i] = points[i].z;
+		}
+		
+		for (uint32 index = 0; index < numInstructions; ++index) {
+			const SInstruction& instruction = mCode[index];
+			
+			double* dst = block + instruction.dst*kColorBlockSize;
+			const double* lhs = block + instruction.lhs*kColorBlockSize;
+			const double* rhs = block + instruction.rhs*kColorBlockSize;
+			
+			uint32 i;
+			switch (instruction.token) {
+				case kAddToken:
+					for (i = 0; i < n; ++i)
+						dst[i] = lhs[i] + rhs[i];
+					break;
+
+				case kMinusToken:
+					for (i = 0; i < n; ++i)
+						dst[i] = lhs[i] - rhs[i];
+					break;
+
+				case kProductToken:
+					for (i = 0; i < n; ++i)
+						dst[i] = lhs[i]*rhs[i];
+					break;
+
+				case kDivideToken:
+					for (i = 0; i < n; ++i)
+						dst[i] = lhs[i]/rhs[i];
+					break;
+
+				case kSqrFunctionToken:
+					for (i = 0; i < n; ++i)
+						dst[i] = lhs[i]*lhs[i];
+					break;
+
+				case kSqrtFunctionToken:
+					for (i = 0; i < n; ++i)
+						dst[i] = sqrt(lhs[i]);
+					break;
+
+				case kAbsFunctionToken:
+					for (i = 0; i < n; ++i)
+						dst[i] = Abs(lhs[i]);
+					break;
+					
+				default:
+					for (i = 0; i < n; ++i)
+						dst[i] = DoApply(instruction.token, lhs[i], rhs[i]);
+			}
 		}
 		
-		mStack.push(result);
+		const double* result = block + mResult*kColorBlockSize;
+		std::copy(result, result + n, results + start);
 	}
+}
+
+#pragma mark ~
+
+//---------------------------------------------------------------
+//
+// CColorEvaluator::EmitVariable							
+//
+//---------------------------------------------------------------
+uint32 CColorEvaluator::EmitVariable(TokenNum token)
+{
+	uint32 reg = 0;
 	
-	result = mStack.top();
-	mStack.pop();
-	POSTCONDITION(mStack.empty());
+	if (token == kXVariableToken)
+		reg = 0;
+	else if (token == kYVariableToken)
+		reg = 1;
+	else if (token == kZVariableToken)
+		reg = 2;
+	else
+		DEBUGSTR("Bad token in CColorEvaluator::EmitVariable:", token);
+		
+	return reg;
+}
+
+
+//---------------------------------------------------------------
+//
+// CColorEvaluator::EmitLiteral							
+//
+//---------------------------------------------------------------
+uint32 CColorEvaluator::EmitLiteral(double number)
+{
+	uint32 reg = this->DoAllocConstant(number);
 	
-	return result;
+	return reg;
+}
+
+
+//---------------------------------------------------------------
+//
+// CColorEvaluator::EmitUnary							
+//
+//---------------------------------------------------------------
+uint32 CColorEvaluator::EmitUnary(TokenNum token, uint32 arg)
+{
+	PRECONDITION(arg < mTypes.size());
+	
+	uint32 reg;
+	
+	if (mTypes[arg] == kConstantRegister && token != kRandomFunctionToken) 
+		reg = this->DoAllocConstant(DoApply(token, mValues[arg], 0.0));
+		
+	else {
+		reg = this->DoAllocTemporary(arg, arg);
+
+		SInstruction instruction;
+		instruction.token = token;
+		instruction.dst   = reg;
+		instruction.lhs   = arg;
+		instruction.rhs   = arg;
+		mCode.push_back(instruction);
+	}
+	
+	return reg;
+}
+
+
+//---------------------------------------------------------------
+//
+// CColorEvaluator::EmitBinary							
+//
+//---------------------------------------------------------------
+uint32 CColorEvaluator::EmitBinary(TokenNum token, uint32 lhs, uint32 rhs)
+{
+	PRECONDITION(lhs < mTypes.size());
+	PRECONDITION(rhs < mTypes.size());
+	
+	uint32 reg;
+	
+	if (mTypes[lhs] == kConstantRegister && mTypes[rhs] == kConstantRegister) 
+		reg = this->DoAllocConstant(DoApply(token, mValues[lhs], mValues[rhs]));
+		
+	else if (token == kPowToken && mTypes[rhs] == kConstantRegister && mValues[rhs] == 2.0)
+		reg = this->EmitUnary(kSqrFunctionToken, lhs);		// pow is exact for this case so we get the same result much faster
+		
+	else {
+		reg = this->DoAllocTemporary(lhs, rhs);
+
+		SInstruction instruction;
+		instruction.token = token;
+		instruction.dst   = reg;
+		instruction.lhs   = lhs;
+		instruction.rhs   = rhs;
+		mCode.push_back(instruction);
+	}
+	
+	return reg;
 }
 
-#pragma mark ~
 
 //---------------------------------------------------------------
 //
-// CColorEvaluator::PushToken							
+// CColorEvaluator::DoAllocConstant							
+//
+// Constant registers are never reused (this is a bit wasteful 
+// when constants are folded, but the formulas are tiny).
 //
 //---------------------------------------------------------------
-void CColorEvaluator::PushToken(TokenNum token)
+uint32 CColorEvaluator::DoAllocConstant(double value)
 {
-	mTokens.push_back(token);
+	mTypes.push_back(kConstantRegister);
+	mValues.push_back(value);
+	
+	return mTypes.size() - 1;
 }
 
 
 //---------------------------------------------------------------
 //
-// CColorEvaluator::PushLiteral							
+// CColorEvaluator::DoAllocTemporary							
+//
+// Returns a register for the result of an operation on arg1 and
+// arg2. Each intermediate value is used exactly once so temporary
+// arguments can be freed (and reused for the result).
 //
 //---------------------------------------------------------------
-void CColorEvaluator::PushLiteral(double number)
+uint32 CColorEvaluator::DoAllocTemporary(uint32 arg1, uint32 arg2)
 {
-	mLiterals.push_back(number);
-	mTokens.push_back(-((int32) mLiterals.size()));
+	if (mTypes[arg1] == kTemporaryRegister)
+		mFreeTemps.push_back(arg1);
+		
+	if (arg2 != arg1 && mTypes[arg2] == kTemporaryRegister)
+		mFreeTemps.push_back(arg2);
+		
+	uint32 reg;
+	if (mFreeTemps.empty()) {
+		mTypes.push_back(kTemporaryRegister);
+		mValues.push_back(0.0);
+		reg = mTypes.size() - 1;
+	
+	} else {
+		reg = mFreeTemps.back();
+		mFreeTemps.pop_back();
+	}
+	
+	return reg;
+}
+
+
+//---------------------------------------------------------------
+//
+// CColorEvaluator::DoApply								[static]
+//
+// Functions use lhs.
+//
+//---------------------------------------------------------------
+double CColorEvaluator::DoApply(TokenNum token, double lhs, double rhs)
+{
+	double result = 0.0;
+	
+	switch (token) {
+		case kPowToken:
+			result = pow(lhs, rhs);
+			break;
+			
+		case kAddToken:
+			result = lhs + rhs;
+			break;
+
+		case kMinusToken:
+			result = lhs - rhs;
+			break;
+
+		case kProductToken:
+			result = lhs*rhs;
+			break;
+
+		case kDivideToken:
+			result = lhs/rhs;
+			break;
+
+		case kSinFunctionToken:
+			result = sin(lhs);
+			break;
+			
+		case kCosFunctionToken:
+			result = cos(lhs);
+			break;
+			
+		case kTanFunctionToken:
+			result = tan(lhs);
+			break;
+			
+		case kSqrFunctionToken:
+			result = lhs*lhs;
+			break;
+			
+		case kSqrtFunctionToken:
+			result = sqrt(lhs);
+			break;
+			
+		case kExpFunctionToken:
+			result = exp(lhs);
+			break;
+			
+		case kLnFunctionToken:
+			result = log(lhs);
+			break;
+			
+		case kLogFunctionToken:
+			result = log10(lhs);
+			break;
+			
+		case kRoundFunctionToken:
+			result = round(lhs);
+			break;
+			
+		case kTruncFunctionToken:
+			result = trunc(lhs);
+			break;
+			
+		case kAbsFunctionToken:
+			result = Abs(lhs);
+			break;
+			
+		case kRandomFunctionToken:
+			result = lhs*Random(1.0);
+			break;
+			
+		default:
+			DEBUGSTR("Bad token in CColorEvaluator::DoApply:", token);
+	}
+	
+	return result;
 }
 
 
@@ -18,8 +18,6 @@
  *		 <1>	 2/15/98	JDJ		Created
  */
 
-#include <stack>
-
 #include <X3DPrimitives.h>
 #include <XLexerGrammar.h>
 
@@ -27,8 +25,15 @@ using namespace Whisper;
 using namespace std;
 
 
+//-----------------------------------
+//	Constants
+//
+const uint32 kColorBlockSize = 64;				// number of points the span version of Evaluate works on at once
+
+
 // ===================================================================================
 //	class CColorEvaluator
+//!		Compiles a color formula into register code that can be quickly evaluated.
 // ===================================================================================
 class CColorEvaluator {
 
@@ -51,22 +56,60 @@ private:
 public:
 			double 		Evaluate(const X3DPoint& pt);
 	
+			void 		Evaluate(const X3DPoint* pts, uint32 count, double* results);
+						/**< Evaluates count points at once. This is considerably faster
+						than calling the single point version for each point because
+						each instruction is applied to kColorBlockSize points using a
+						loop the compiler can vectorize. The results are the same as
+						the single point version (except for the random function which
+						will return different random numbers). */
+						
+			uint32 		GetNumInstructions() const				{return mCode.size();}
+	
 //-----------------------------------
 //	Internal API
 //
 public:
-			void 		PushToken(TokenNum token);
+			uint32 		EmitVariable(TokenNum token);
+						/**< These are called by CColorTree::Compile. They return the 
+						register that will hold the result. Operations on constants 
+						are folded so no code is emitted for them. */
+
+			uint32 		EmitLiteral(double number);
+			
+			uint32 		EmitUnary(TokenNum token, uint32 arg);
 
-			void 		PushLiteral(double number);
+			uint32 		EmitBinary(TokenNum token, uint32 lhs, uint32 rhs);
 	
+private:
+			uint32 		DoAllocConstant(double value);
+			uint32 		DoAllocTemporary(uint32 arg1, uint32 arg2);
+			
+	static	double 		DoApply(TokenNum token, double lhs, double rhs);
+
 //-----------------------------------
-//	Member Data
+//	Types
 //
-protected:
-	vector<TokenNum>				mTokens;
-	vector<double>					mLiterals;
-	stack<double, vector<double> >	mStack;
-};
-
+private:
+	enum ERegisterType {kVariableRegister, kConstantRegister, kTemporaryRegister};
 
+	struct SInstruction {
+		TokenNum	token;
+		uint32		dst;
+		uint32		lhs;
+		uint32		rhs;					// unused for functions
+	};
 
+//-----------------------------------
+//	Member Data
+//
+private:
+	vector<SInstruction>	mCode;
+	uint32					mResult;		// register holding the result
+	
+	vector<ERegisterType>	mTypes;			// indexed by register (x, y, and z are in the first three registers)
+	vector<double>			mValues;		// register values for the single point Evaluate
+	vector<uint32>			mFreeTemps;		// temporary registers that are no longer in use
+	
+	vector<double>			mBlock;			// kColorBlockSize values for each register for the span Evaluate
+};
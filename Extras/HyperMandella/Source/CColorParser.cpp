@@ -132,9 +132,11 @@ CColorTree* CColorTree::Create(const std::wstring& text)
 // CColorTree::Compile
 //
 //---------------------------------------------------------------
-void CColorTree::Compile(CColorEvaluator& evaluator)
+uint32 CColorTree::Compile(CColorEvaluator& evaluator)
 {	
-	this->OnCompile(evaluator);
+	uint32 reg = this->OnCompile(evaluator);
+	
+	return reg;
 }
 
 
@@ -197,17 +199,17 @@ CAddTree::CAddTree(const SToken& token) : CColorTree(token)
 // CAddTree::OnCompile			$$$ use an abstract CDyadicTree class?
 //
 //---------------------------------------------------------------
-void CAddTree::OnCompile(CColorEvaluator& evaluator)
+uint32 CAddTree::OnCompile(CColorEvaluator& evaluator)
 {
 	PRECONDITION(this->GetNumChildren() == 2);
 
 	CColorTree* lhs = dynamic_cast<CColorTree*>(this->GetLeftChild());
 	CColorTree* rhs = dynamic_cast<CColorTree*>(this->GetRightChild());
 	
-	lhs->Compile(evaluator);
-	rhs->Compile(evaluator);
+	uint32 lhsReg = lhs->Compile(evaluator);
+	uint32 rhsReg = rhs->Compile(evaluator);
 	
-	evaluator.PushToken(mToken);
+	return evaluator.EmitBinary(mToken, lhsReg, rhsReg);
 }
 
 #pragma mark -
@@ -242,17 +244,17 @@ CSubtractTree::CSubtractTree(const SToken& token) : CColorTree(token)
 // CSubtractTree::OnCompile
 //
 //---------------------------------------------------------------
-void CSubtractTree::OnCompile(CColorEvaluator& evaluator)
+uint32 CSubtractTree::OnCompile(CColorEvaluator& evaluator)
 {
 	PRECONDITION(this->GetNumChildren() == 2);
 
 	CColorTree* lhs = dynamic_cast<CColorTree*>(this->GetLeftChild());
 	CColorTree* rhs = dynamic_cast<CColorTree*>(this->GetRightChild());
 	
-	lhs->Compile(evaluator);
-	rhs->Compile(evaluator);
+	uint32 lhsReg = lhs->Compile(evaluator);
+	uint32 rhsReg = rhs->Compile(evaluator);
 	
-	evaluator.PushToken(mToken);
+	return evaluator.EmitBinary(mToken, lhsReg, rhsReg);
 }
 
 #pragma mark -
@@ -287,17 +289,17 @@ CMultiplyTree::CMultiplyTree(const SToken& token) : CColorTree(token)
 // CMultiplyTree::OnCompile
 //
 //---------------------------------------------------------------
-void CMultiplyTree::OnCompile(CColorEvaluator& evaluator)
+uint32 CMultiplyTree::OnCompile(CColorEvaluator& evaluator)
 {
 	PRECONDITION(this->GetNumChildren() == 2);
 
 	CColorTree* lhs = dynamic_cast<CColorTree*>(this->GetLeftChild());
 	CColorTree* rhs = dynamic_cast<CColorTree*>(this->GetRightChild());
 	
-	lhs->Compile(evaluator);
-	rhs->Compile(evaluator);
+	uint32 lhsReg = lhs->Compile(evaluator);
+	uint32 rhsReg = rhs->Compile(evaluator);
 	
-	evaluator.PushToken(mToken);
+	return evaluator.EmitBinary(mToken, lhsReg, rhsReg);
 }
 
 #pragma mark -
@@ -332,17 +334,17 @@ CDivideTree::CDivideTree(const SToken& token) : CColorTree(token)
 // CDivideTree::OnCompile
 //
 //---------------------------------------------------------------
-void CDivideTree::OnCompile(CColorEvaluator& evaluator)
+uint32 CDivideTree::OnCompile(CColorEvaluator& evaluator)
 {
 	PRECONDITION(this->GetNumChildren() == 2);
 
 	CColorTree* lhs = dynamic_cast<CColorTree*>(this->GetLeftChild());
 	CColorTree* rhs = dynamic_cast<CColorTree*>(this->GetRightChild());
 	
-	lhs->Compile(evaluator);
-	rhs->Compile(evaluator);
+	uint32 lhsReg = lhs->Compile(evaluator);
+	uint32 rhsReg = rhs->Compile(evaluator);
 	
-	evaluator.PushToken(mToken);
+	return evaluator.EmitBinary(mToken, lhsReg, rhsReg);
 }
 
 #pragma mark -
@@ -377,17 +379,17 @@ CPowTree::CPowTree(const SToken& token) : CColorTree(token)
 // CPowTree::OnCompile
 //
 //---------------------------------------------------------------
-void CPowTree::OnCompile(CColorEvaluator& evaluator)
+uint32 CPowTree::OnCompile(CColorEvaluator& evaluator)
 {
 	PRECONDITION(this->GetNumChildren() == 2);
 
 	CColorTree* lhs = dynamic_cast<CColorTree*>(this->GetLeftChild());
 	CColorTree* rhs = dynamic_cast<CColorTree*>(this->GetRightChild());
 	
-	lhs->Compile(evaluator);
-	rhs->Compile(evaluator);
+	uint32 lhsReg = lhs->Compile(evaluator);
+	uint32 rhsReg = rhs->Compile(evaluator);
 	
-	evaluator.PushToken(mToken);
+	return evaluator.EmitBinary(mToken, lhsReg, rhsReg);
 }
 
 #pragma mark -
@@ -425,39 +427,42 @@ CFunctionTree::CFunctionTree(const SToken& token) : CColorTree(token)
 // CFunctionTree::OnCompile
 //
 //---------------------------------------------------------------
-void CFunctionTree::OnCompile(CColorEvaluator& evaluator)
+uint32 CFunctionTree::OnCompile(CColorEvaluator& evaluator)
 {
 	PRECONDITION(this->GetNumChildren() == 1);
 
 	CColorTree* child = dynamic_cast<CColorTree*>(this->GetLeftChild());
-	child->Compile(evaluator);
-		
+	uint32 arg = child->Compile(evaluator);
+	
+	TokenNum token = kSinFunctionToken;
 	if (mFunction == L"sin") 
-		evaluator.PushToken(kSinFunctionToken);
+		token = kSinFunctionToken;
 	else if (mFunction == L"cos")
-		evaluator.PushToken(kCosFunctionToken);
+		token = kCosFunctionToken;
 	else if (mFunction == L"tan")
-		evaluator.PushToken(kTanFunctionToken);
+		token = kTanFunctionToken;
 	else if (mFunction == L"sqr")
-		evaluator.PushToken(kSqrFunctionToken);
+		token = kSqrFunctionToken;
 	else if (mFunction == L"sqrt")
-		evaluator.PushToken(kSqrtFunctionToken);
+		token = kSqrtFunctionToken;
 	else if (mFunction == L"exp")
-		evaluator.PushToken(kExpFunctionToken);
+		token = kExpFunctionToken;
 	else if (mFunction == L"ln")
-		evaluator.PushToken(kLnFunctionToken);
+		token = kLnFunctionToken;
 	else if (mFunction == L"log")
-		evaluator.PushToken(kLogFunctionToken);
+		token = kLogFunctionToken;
 	else if (mFunction == L"round")
-		evaluator.PushToken(kRoundFunctionToken);
+		token = kRoundFunctionToken;
 	else if (mFunction == L"trunc")
-		evaluator.PushToken(kTruncFunctionToken);
+		token = kTruncFunctionToken;
 	else if (mFunction == L"abs")
-		evaluator.PushToken(kAbsFunctionToken);
+		token = kAbsFunctionToken;
 	else if (mFunction == L"random")
-		evaluator.PushToken(kRandomFunctionToken);
+		token = kRandomFunctionToken;
 	else
 		DEBUGSTR("Bad function in CFunctionTree::OnCompile: ", mFunction);
+		
+	return evaluator.EmitUnary(token, arg);
 }
 
 #pragma mark -
@@ -496,18 +501,22 @@ CVariableTree::CVariableTree(const SToken& token) : CColorTree(token)
 // CVariableTree::OnCompile
 //
 //---------------------------------------------------------------
-void CVariableTree::OnCompile(CColorEvaluator& evaluator)
+uint32 CVariableTree::OnCompile(CColorEvaluator& evaluator)
 {
 	PRECONDITION(this->GetNumChildren() == 0);
 		
+	uint32 reg;
+	
 	if (mVariable == 'X')
-		evaluator.PushToken(kXVariableToken);
+		reg = evaluator.EmitVariable(kXVariableToken);
 	
 	else if (mVariable == 'Y')
-		evaluator.PushToken(kYVariableToken);
+		reg = evaluator.EmitVariable(kYVariableToken);
 	
 	else 
-		evaluator.PushToken(kZVariableToken);
+		reg = evaluator.EmitVariable(kZVariableToken);
+		
+	return reg;
 }
 
 #pragma mark -
@@ -544,11 +553,11 @@ CLiteralTree::CLiteralTree(const SToken& token) : CColorTree(token)
 // CLiteralTree::OnCompile
 //
 //---------------------------------------------------------------
-void CLiteralTree::OnCompile(CColorEvaluator& evaluator)
+uint32 CLiteralTree::OnCompile(CColorEvaluator& evaluator)
 {
 	PRECONDITION(this->GetNumChildren() == 0);
 	
-	evaluator.PushLiteral(mLiteral);
+	return evaluator.EmitLiteral(mLiteral);
 }
 
 #pragma mark -
@@ -102,10 +102,11 @@ public:
 //	New API
 //
 public:
-	virtual void 		Compile(CColorEvaluator& evaluator);
+	virtual uint32 		Compile(CColorEvaluator& evaluator);
+						// Emits code for the tree and returns the register holding the result.
 	
 protected:
-	virtual void 		OnCompile(CColorEvaluator& evaluator) = 0;
+	virtual uint32 		OnCompile(CColorEvaluator& evaluator) = 0;
 
 	static XLexerGrammar* DoCreateGrammar();
 };
@@ -130,7 +131,7 @@ public:
 //	Inherited API
 //
 protected:
-	virtual void 		OnCompile(CColorEvaluator& evaluator);
+	virtual uint32 		OnCompile(CColorEvaluator& evaluator);
 };
 
 
@@ -153,7 +154,7 @@ public:
 //	Inherited API
 //
 protected:
-	virtual void 		OnCompile(CColorEvaluator& evaluator);
+	virtual uint32 		OnCompile(CColorEvaluator& evaluator);
 };
 
 
@@ -176,7 +177,7 @@ public:
 //	Inherited API
 //
 protected:
-	virtual void 		OnCompile(CColorEvaluator& evaluator);
+	virtual uint32 		OnCompile(CColorEvaluator& evaluator);
 };
 
 
@@ -199,7 +200,7 @@ public:
 //	Inherited API
 //
 protected:
-	virtual void 		OnCompile(CColorEvaluator& evaluator);
+	virtual uint32 		OnCompile(CColorEvaluator& evaluator);
 };
 
 
@@ -222,7 +223,7 @@ public:
 //	Inherited API
 //
 protected:
-	virtual void 		OnCompile(CColorEvaluator& evaluator);
+	virtual uint32 		OnCompile(CColorEvaluator& evaluator);
 };
 
 
@@ -251,7 +252,7 @@ public:
 //	Inherited API
 //
 protected:
-	virtual void 		OnCompile(CColorEvaluator& evaluator);
+	virtual uint32 		OnCompile(CColorEvaluator& evaluator);
 
 //-----------------------------------
 //	Member Data
@@ -287,7 +288,7 @@ public:
 //	Inherited API
 //
 protected:
-	virtual void 		OnCompile(CColorEvaluator& evaluator);
+	virtual uint32 		OnCompile(CColorEvaluator& evaluator);
 
 //-----------------------------------
 //	Member Data
@@ -322,7 +323,7 @@ public:
 //	Inherited API
 //
 protected:
-	virtual void 		OnCompile(CColorEvaluator& evaluator);
+	virtual uint32 		OnCompile(CColorEvaluator& evaluator);
 
 //-----------------------------------
 //	Member Data
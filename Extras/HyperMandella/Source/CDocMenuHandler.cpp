@@ -83,9 +83,14 @@
 #include <XFloatConversions.h>
 #include <XIntConversions.h>
 #include <XKeyEvents.h>
+#include <XObjectModel.h>
+#include <XPixMap.h>
 #include <XPreference.h>
 #include <XURI.h>
 
+#include "CColorEvaluator.h"
+#include "CSequenceRenderer.h"
+#include "ICamera.h"
 #include "IColorFormulas.h"
 #include "IComplexDialog.h"
 #include "IDocCommands.h"
@@ -98,6 +103,7 @@
 #include "IPalettes.h"
 #include "IPointLightDialog.h"
 #include "IRandomPalette.h"
+#include "IRenderer.h"
 #include "IShader.h"
 #include "ITemporaryPalettes.h"
 
@@ -153,6 +159,12 @@ private:
 			
 			void 		DoFractalFormula();
 			void 		DoMakeDefault();
+			void 		DoTimeRenderThreads();
+			void 		DoTimeFractalFunctions();
+			void 		DoTimeDistanceEstimation();
+			void 		DoTimeColorFormulas();
+			void 		DoTimeProgressiveRender();
+			void 		DoTimeSequenceRender();
 
 			void 		DoLambertShader();
 			void 		DoPhongShader();
@@ -346,6 +358,42 @@ void CDocMenuHandler::InstallCommands()
 	handler->RegisterCommand(L"Make Default", action, kEnabledIfDocWindow, this);
 #endif
 
+	// Time Render Threads
+#if DEBUG
+	action.Set(this, &CDocMenuHandler::DoTimeRenderThreads);
+	handler->RegisterCommand(L"Time Render Threads", action, kEnabledIfDocWindow, this);
+#endif
+
+	// Time Fractal Functions
+#if DEBUG
+	action.Set(this, &CDocMenuHandler::DoTimeFractalFunctions);
+	handler->RegisterCommand(L"Time Fractal Functions", action, kEnabledIfDocWindow, this);
+#endif
+
+	// Time Distance Estimation
+#if DEBUG
+	action.Set(this, &CDocMenuHandler::DoTimeDistanceEstimation);
+	handler->RegisterCommand(L"Time Distance Estimation", action, kEnabledIfDocWindow, this);
+#endif
+
+	// Time Color Formulas
+#if DEBUG
+	action.Set(this, &CDocMenuHandler::DoTimeColorFormulas);
+	handler->RegisterCommand(L"Time Color Formulas", action, kEnabledIfDocWindow, this);
+#endif
+
+	// Time Progressive Render
+#if DEBUG
+	action.Set(this, &CDocMenuHandler::DoTimeProgressiveRender);
+	handler->RegisterCommand(L"Time Progressive Render", action, kEnabledIfDocWindow, this);
+#endif
+
+	// Time Sequence Render
+#if DEBUG
+	action.Set(this, &CDocMenuHandler::DoTimeSequenceRender);
+	handler->RegisterCommand(L"Time Sequence Render", action, kEnabledIfDocWindow, this);
+#endif
+
 	// Max Dwell
 	action.Set(this, &CDocMenuHandler::DoMaxDwellDialog);
 	handler->RegisterCommand(L"Max Dwell", action, kEnabledIfDocWindow, this);
@@ -558,6 +606,42 @@ void CDocMenuHandler::RemoveCommands()
 	handler->UnRegisterCommand(action);	
 #endif
 
+	// Time Render Threads
+#if DEBUG
+	action.Set(this, &CDocMenuHandler::DoTimeRenderThreads);
+	handler->UnRegisterCommand(action);	
+#endif
+
+	// Time Fractal Functions
+#if DEBUG
+	action.Set(this, &CDocMenuHandler::DoTimeFractalFunctions);
+	handler->UnRegisterCommand(action);	
+#endif
+
+	// Time Distance Estimation
+#if DEBUG
+	action.Set(this, &CDocMenuHandler::DoTimeDistanceEstimation);
+	handler->UnRegisterCommand(action);	
+#endif
+
+	// Time Color Formulas
+#if DEBUG
+	action.Set(this, &CDocMenuHandler::DoTimeColorFormulas);
+	handler->UnRegisterCommand(action);	
+#endif
+
+	// Time Progressive Render
+#if DEBUG
+	action.Set(this, &CDocMenuHandler::DoTimeProgressiveRender);
+	handler->UnRegisterCommand(action);	
+#endif
+
+	// Time Sequence Render
+#if DEBUG
+	action.Set(this, &CDocMenuHandler::DoTimeSequenceRender);
+	handler->UnRegisterCommand(action);	
+#endif
+
 	// Max Dwell
 	action.Set(this, &CDocMenuHandler::DoMaxDwellDialog);
 	handler->UnRegisterCommand(action);	
@@ -1252,6 +1336,418 @@ void CDocMenuHandler::DoMakeDefault()
 }
 
 
+//---------------------------------------------------------------
+//
+// CDocMenuHandler::DoTimeFractalFunctions
+//
+// For each fractal formula this traces the number of dwell evaluations 
+// per second using ComputeDepth (one ray at a time) and ComputeDepths
+// (a packet of rays at a time). It also verifies that both compute the
+// same depths for a grid of rays through the document's camera. Note
+// that the depths will be identical unless the compiler uses x87 
+// extended precision or fused multiply-adds for the scalar code in
+// which case a dwell can occasionally differ on the bailout boundary
+// and the depth will be off by up to one depth step.
+//
+//---------------------------------------------------------------
+#if DEBUG
+void CDocMenuHandler::DoTimeFractalFunctions()
+{	
+	const int32 kGridSize = 48;						// number of dwell evaluations is kGridSize^3
+	const int32 kRaysSize = 64;						// number of rays to check is kRaysSize^2
+	
+	SFractalInfo info = mDoc->GetFractalInfo();
+	
+	IConstCameraPtr camera(mDoc);
+	float viewDepth = camera->GetRange().yon - camera->GetRange().hither;
+	int32 pixelDepth = mDoc->GetResolution().depth;
+	float tolerance = viewDepth/pixelDepth;
+	
+	// Using a depth of one evaluates the formula exactly once per ray
+	// so we can time the dwell evaluations for points in [-2, 2]^3. 
+	std::vector<X3DPoint> points;
+	for (int32 k = 0; k < kGridSize; ++k)
+		for (int32 j = 0; j < kGridSize; ++j)
+			for (int32 i = 0; i < kGridSize; ++i)
+				points.push_back(X3DPoint(4.0f*i/kGridSize - 2.0f, 4.0f*j/kGridSize - 2.0f, 4.0f*k/kGridSize - 2.0f));
+	COMPILE_CHECK(kGridSize % kRayPacketSize == 0);
+	
+	std::vector<X3DVector> rays(points.size(), X3DVector(0.0f, 0.0f, 1.0f));
+	std::vector<float> scalarDepths(points.size());
+	std::vector<float> packetDepths(points.size());
+	
+	// Rays through the camera are used to check that the two methods
+	// compute the same depths.
+	std::vector<X3DPoint> hitherPts;
+	std::vector<X3DVector> eyeRays;
+	for (int32 v = 0; v < kRaysSize; ++v) {
+		for (int32 h = 0; h < kRaysSize; ++h) {
+			hitherPts.push_back(camera->GetHitherPoint(X2DPoint((float) h/kRaysSize, (float) v/kRaysSize)));
+			eyeRays.push_back(camera->GetEyeRay(hitherPts.back()));
+		}
+	}
+	COMPILE_CHECK(kRaysSize % kRayPacketSize == 0);
+
+	XBoss* boss = XObjectModel::Instance()->CreateBoss(L"Fractal Functions");
+	
+	TRACE("Dwell evaluations per second:\n");
+	for (XBoss::iterator iter = boss->begin(); iter != boss->end(); ++iter) {
+		IFractalFunctionPtr function(boss, iter);
+		if (function) {
+			MilliSecond startTime = GetMilliSeconds();
+			for (uint32 i = 0; i < points.size(); ++i)
+				scalarDepths[i] = function->ComputeDepth(info, points[i], rays[i], 1.0f, 1);
+			MilliSecond scalarTime = Max(GetMilliSeconds() - startTime, 1L);
+			
+			startTime = GetMilliSeconds();
+			for (uint32 i = 0; i < points.size(); i += kRayPacketSize)
+				function->ComputeDepths(info, &points[i], &rays[i], kRayPacketSize, 1.0f, 1, &packetDepths[i]);
+			MilliSecond packetTime = Max(GetMilliSeconds() - startTime, 1L);
+			
+			uint32 mismatches = 0;
+			for (uint32 i = 0; i < points.size(); ++i)
+				if (scalarDepths[i] != packetDepths[i])
+					++mismatches;
+			
+			for (uint32 i = 0; i < hitherPts.size(); i += kRayPacketSize) {
+				float depths[kRayPacketSize];
+				function->ComputeDepths(info, &hitherPts[i], &eyeRays[i], kRayPacketSize, viewDepth, pixelDepth, depths);
+				
+				for (uint32 j = 0; j < kRayPacketSize; ++j) {
+					float depth = function->ComputeDepth(info, hitherPts[i + j], eyeRays[i + j], viewDepth, pixelDepth);
+					if (depth != depths[j]) {
+						ASSERT(Abs(depth - depths[j]) <= tolerance);
+						++mismatches;
+					}
+				}
+			}
+			
+			TRACE("   ", function->GetFormula(), ": ", (int32) (1000.0*points.size()/scalarTime), " scalar, ", (int32) (1000.0*points.size()/packetTime), " packet (", mismatches, " results differ)\n");
+		}
+	}
+	TRACE("\n");
+}
+#endif
+
+
+//---------------------------------------------------------------
+//
+// CDocMenuHandler::DoTimeDistanceEstimation
+//
+// For each fractal formula with a distance estimator this casts a
+// grid of rays through the document's camera using ComputeDepth and
+// EstimateDepth and traces the speedup and the number of rays whose
+// depths differ (which should be zero unless the estimator stepped
+// over a thin piece of the fractal).
+//
+//---------------------------------------------------------------
+#if DEBUG
+void CDocMenuHandler::DoTimeDistanceEstimation()
+{	
+	const int32 kRaysSize = 128;					// number of rays to cast is kRaysSize^2
+	
+	SFractalInfo info = mDoc->GetFractalInfo();
+	
+	IConstCameraPtr camera(mDoc);
+	float viewDepth = camera->GetRange().yon - camera->GetRange().hither;
+	int32 pixelDepth = mDoc->GetResolution().depth;
+	
+	std::vector<X3DPoint> hitherPts;
+	std::vector<X3DVector> eyeRays;
+	for (int32 v = 0; v < kRaysSize; ++v) {
+		for (int32 h = 0; h < kRaysSize; ++h) {
+			hitherPts.push_back(camera->GetHitherPoint(X2DPoint((float) h/kRaysSize, (float) v/kRaysSize)));
+			eyeRays.push_back(camera->GetEyeRay(hitherPts.back()));
+		}
+	}
+	
+	std::vector<float> fixedDepths(hitherPts.size());
+	std::vector<float> estimatedDepths(hitherPts.size());
+
+	XBoss* boss = XObjectModel::Instance()->CreateBoss(L"Fractal Functions");
+	
+	TRACE("Distance estimation speedups:\n");
+	for (XBoss::iterator iter = boss->begin(); iter != boss->end(); ++iter) {
+		IFractalFunctionPtr function(boss, iter);
+		if (function && function->HasDistanceEstimator()) {
+			MilliSecond startTime = GetMilliSeconds();
+			for (uint32 i = 0; i < hitherPts.size(); ++i)
+				fixedDepths[i] = function->ComputeDepth(info, hitherPts[i], eyeRays[i], viewDepth, pixelDepth);
+			MilliSecond fixedTime = Max(GetMilliSeconds() - startTime, 1L);
+			
+			startTime = GetMilliSeconds();
+			for (uint32 i = 0; i < hitherPts.size(); ++i)
+				estimatedDepths[i] = function->EstimateDepth(info, hitherPts[i], eyeRays[i], viewDepth, pixelDepth);
+			MilliSecond estimatedTime = Max(GetMilliSeconds() - startTime, 1L);
+			
+			uint32 mismatches = 0;
+			for (uint32 i = 0; i < hitherPts.size(); ++i)
+				if (fixedDepths[i] != estimatedDepths[i])
+					++mismatches;
+			
+			TRACE("   ", function->GetFormula(), ": ", fixedTime, " ms fixed, ", estimatedTime, " ms estimated, ");
+			TRACE(DoubleToStr((double) fixedTime/estimatedTime, 1, 2), "x speedup (", mismatches, " rays differ)\n");
+		}
+	}
+	TRACE("\n");
+}
+#endif
+
+
+//---------------------------------------------------------------
+//
+// CDocMenuHandler::DoTimeColorFormulas
+//
+// Evaluates each of the saved color formulas over a million points
+// one point at a time and a span at a time, traces the times, and
+// counts the points where the two methods disagree (formulas that 
+// use random will always disagree).
+//
+//---------------------------------------------------------------
+#if DEBUG
+void CDocMenuHandler::DoTimeColorFormulas()
+{	
+	const uint32 kGridSize = 1000;					// number of points is kGridSize^2
+	
+	std::vector<X3DPoint> points;
+	points.reserve(kGridSize*kGridSize);
+	for (uint32 j = 0; j < kGridSize; ++j)
+		for (uint32 i = 0; i < kGridSize; ++i)
+			points.push_back(X3DPoint(4.0f*i/kGridSize - 2.0f, 4.0f*j/kGridSize - 2.0f, 2.0f*i/kGridSize - 1.0f));
+	
+	std::vector<double> pointResults(points.size());
+	std::vector<double> spanResults(points.size());
+	
+	IConstColorFormulasPtr formulas(L"Application");
+	
+	TRACE("Evaluating color formulas over ", points.size(), " points:\n");
+	for (uint32 index = 0; index < formulas->GetCount(); ++index) {
+		std::wstring formula = formulas->Get(index);
+		CColorEvaluator expr(formula);
+		
+		MilliSecond startTime = GetMilliSeconds();
+		for (uint32 i = 0; i < points.size(); ++i)
+			pointResults[i] = expr.Evaluate(points[i]);
+		MilliSecond pointTime = GetMilliSeconds() - startTime;
+		
+		startTime = GetMilliSeconds();
+		expr.Evaluate(&points[0], (uint32) points.size(), &spanResults[0]);
+		MilliSecond spanTime = GetMilliSeconds() - startTime;
+		
+		uint32 mismatches = 0;
+		for (uint32 i = 0; i < points.size(); ++i)
+			if (pointResults[i] != spanResults[i] && !(isnan((float) pointResults[i]) && isnan((float) spanResults[i])))
+				++mismatches;
+		
+		TRACE("   ", formula, " (", expr.GetNumInstructions(), " instructions): ", pointTime, " ms by point, ", spanTime, " ms by span, ");
+		TRACE(mismatches, " results differ\n");
+	}
+	TRACE("\n");
+}
+#endif
+
+
+//---------------------------------------------------------------
+//
+// CDocMenuHandler::DoTimeRenderThreads
+//
+// Renders the document at 2048x2048 using 1, 2, 4, 8, and 16 threads,
+// traces the times, and verifies that each image matches the one
+// produced by the single threaded renderer.
+//
+//---------------------------------------------------------------
+#if DEBUG
+void CDocMenuHandler::DoTimeRenderThreads()
+{	
+	const int32 kThreadCounts[] = {1, 2, 4, 8, 16};
+	const uint32 kNumCounts = sizeof(kThreadCounts)/sizeof(kThreadCounts[0]);
+	
+	IRendererPtr renderer(L"Renderer");
+	renderer->Reset(IDocInfoPtr(mDoc));						// unlike OnLoaded this won't anti-alias so we only time the ray casting
+	renderer->SetResolution(XSize(2048, 2048), 32);
+	
+	XPixMapPtr expected;
+	
+	TRACE("Rendering ", mDoc->GetFractalFunction()->GetFormula(), " at 2048x2048:\n");
+	for (uint32 i = 0; i < kNumCounts; ++i) {
+		renderer->SetThreadCount(kThreadCounts[i]);
+		renderer->Reset();
+		
+		MilliSecond startTime = GetMilliSeconds();
+		while (!renderer->IsDone())
+			(void) renderer->Render(250);
+		MilliSecond elapsed = GetMilliSeconds() - startTime;
+		
+		const XPixMap* image = renderer->GetImage();
+		if (i == 0) {
+			expected = XPixMapPtr(image->Clone());
+			TRACE("   1 thread took ", elapsed, " ms\n");
+		
+		} else {
+			XLocker lock1(image);
+			XLocker lock2(expected.Get());
+			
+			uint32 rowBytes = (uint32) (image->GetWidth()*image->GetDepth()/8);
+			for (int32 v = 0; v < image->GetHeight(); ++v)
+				ASSERT(std::memcmp(image->GetBufferAt(0, v), expected->GetBufferAt(0, v), rowBytes) == 0);
+			
+			TRACE("   ", kThreadCounts[i], " threads took ", elapsed, " ms\n");
+		}
+	}
+	TRACE("\n");
+}
+#endif
+
+
+//---------------------------------------------------------------
+//
+// CDocMenuHandler::DoTimeProgressiveRender
+//
+// Renders the document at 1024x1024 in one pass and then using the
+// progressive preview passes. Traces how long it took before each
+// preview was ready and the total times (the progressive render
+// should take no more than about 10% longer than the one pass render).
+// Because the coarse depths are used as lower bounds for the later
+// rays a few pixels may differ so the number of differing pixels is 
+// traced as well.
+//
+//---------------------------------------------------------------
+#if DEBUG
+void CDocMenuHandler::DoTimeProgressiveRender()
+{	
+	const MilliSecond kRenderDelay = 10;			// Render returns after roughly this long so the preview times are a bit pessimistic
+	
+	IRendererPtr renderer(L"Renderer");
+	renderer->Reset(IDocInfoPtr(mDoc));						// unlike OnLoaded this won't anti-alias so we only time the ray casting
+	renderer->SetResolution(XSize(1024, 1024), 32);
+	
+	TRACE("Rendering ", mDoc->GetFractalFunction()->GetFormula(), " at 1024x1024:\n");
+	
+	// One pass
+	renderer->EnableProgressive(false);
+	renderer->Reset();
+	
+	MilliSecond startTime = GetMilliSeconds();
+	while (!renderer->IsDone())
+		(void) renderer->Render(kRenderDelay);
+	MilliSecond onePassTime = Max(GetMilliSeconds() - startTime, 1L);
+	
+	XPixMapPtr expected(renderer->GetImage()->Clone());
+	
+	// Progressive
+	renderer->EnableProgressive(true);
+	renderer->Reset();
+	
+	MilliSecond coarseTime = 0;
+	MilliSecond mediumTime = 0;
+	
+	startTime = GetMilliSeconds();
+	while (!renderer->IsDone()) {
+		(void) renderer->Render(kRenderDelay);
+		
+		if (coarseTime == 0 && renderer->GetPreviewStep() < 4)
+			coarseTime = GetMilliSeconds() - startTime;
+		if (mediumTime == 0 && renderer->GetPreviewStep() < 2)
+			mediumTime = GetMilliSeconds() - startTime;
+	}
+	MilliSecond progressiveTime = Max(GetMilliSeconds() - startTime, 1L);
+	
+	// Compare the images
+	const XPixMap* image = renderer->GetImage();
+	XLocker lock1(image);
+	XLocker lock2(expected.Get());
+	
+	int32 mismatches = 0;
+	for (int32 v = 0; v < image->GetHeight(); ++v)
+		for (int32 h = 0; h < image->GetWidth(); ++h)
+			if (image->GetPixelAt(h, v) != expected->GetPixelAt(h, v))
+				++mismatches;
+	
+	TRACE("   one pass took ", onePassTime, " ms\n");
+	TRACE("   1/16 preview after ", coarseTime, " ms, 1/4 preview after ", mediumTime, " ms\n");
+	TRACE("   progressive took ", progressiveTime, " ms (", DoubleToStr((double) progressiveTime/onePassTime, 1, 2), "x, ", mismatches, " pixels differ)\n");
+	TRACE("\n");
+}
+#endif
+
+
+//---------------------------------------------------------------
+//
+// CDocMenuHandler::DoTimeSequenceRender
+//
+// Renders a 120 frame orbit around the document at 256x256 twice:
+// once with each frame starting from the previous frame's depths
+// and once with every frame rendered from scratch. Traces the time
+// per frame for both along with the number of pixels that differ
+// (the reprojected depths aren't strict bounds).
+//
+//---------------------------------------------------------------
+#if DEBUG
+void CDocMenuHandler::DoTimeSequenceRender()
+{	
+	const uint32 kNumFrames = 120;
+	const int32 kSize = 256;
+	
+	IDocInfoPtr infos[2];
+	for (uint32 i = 0; i < 2; ++i) {
+		infos[i] = IDocInfoPtr(L"Batch Renderer");
+		infos[i]->Reset(IConstDocInfoPtr(mDoc));
+		
+		SResolution resolution = infos[i]->GetResolution();
+		resolution.width  = kSize;
+		resolution.height = kSize;
+		infos[i]->SetResolution(resolution, false);
+		
+		IRendererPtr renderer(infos[i]);
+		renderer->Reset(infos[i]);
+	}
+	
+	CSequenceRenderer coherent(infos[0]);
+	coherent.AddOrbit(kNumFrames);
+	
+	CSequenceRenderer independent(infos[1]);
+	independent.AddOrbit(kNumFrames);
+	independent.EnableCoherence(false);
+	
+	MilliSecond coherentTime = 0;
+	MilliSecond independentTime = 0;
+	int32 mismatches = 0;
+	
+	for (uint32 frame = 0; frame < kNumFrames; ++frame) {
+		MilliSecond startTime = GetMilliSeconds();
+		coherent.RenderFrame(frame);
+		coherentTime += GetMilliSeconds() - startTime;
+		
+		startTime = GetMilliSeconds();
+		independent.RenderFrame(frame);
+		independentTime += GetMilliSeconds() - startTime;
+		
+		const XPixMap* image = coherent.GetRenderer()->GetImage();
+		const XPixMap* expected = independent.GetRenderer()->GetImage();
+		XLocker lock1(image);
+		XLocker lock2(expected);
+		
+		for (int32 v = 0; v < image->GetHeight(); ++v)
+			for (int32 h = 0; h < image->GetWidth(); ++h)
+				if (image->GetPixelAt(h, v) != expected->GetPixelAt(h, v))
+					++mismatches;
+	}
+	
+	coherentTime = Max(coherentTime, 1L);
+	
+	TRACE("Rendering a ", kNumFrames, " frame orbit of ", mDoc->GetFractalFunction()->GetFormula(), " at 256x256:\n");
+	TRACE("   independent frames took ", DoubleToStr((double) independentTime/kNumFrames, 1, 1), " ms per frame\n");
+	TRACE("   coherent frames took ", DoubleToStr((double) coherentTime/kNumFrames, 1, 1), " ms per frame (", DoubleToStr((double) independentTime/coherentTime, 1, 2), "x speedup, ", mismatches, " pixels differ)\n");
+	TRACE("\n");
+	
+	for (uint32 i = 0; i < 2; ++i) {
+		IRendererPtr renderer(infos[i]);
+		renderer->Reset(IDocInfoPtr());						// have to break a cycle
+	}
+}
+#endif
+
+
 //---------------------------------------------------------------
 //
 // CDocMenuHandler::DoMaxDwellDialog
@@ -0,0 +1,198 @@
+/*
+ *  File:       CDoublePacket.h
+ *  Summary:   	Four doubles that are operated on in parallel (using SIMD instructions if possible).
+ *  Written by: Jesse Jones
+ *
+ *	Abstract:	This is used to iterate the fractal formulas for a packet of rays at
+ *				once. If WHISPER_AVX is set the four lanes are held in one AVX register,
+ *				if WHISPER_SSE2 is set they're held in two SSE2 registers, otherwise
+ *				plain doubles are used (which may still be vectorized by the compiler).
+ *				Note that each lane is computed using the same IEEE operations as the
+ *				equivalent scalar code so, as long as the scalar code isn't using x87
+ *				extended precision or fused multiply-adds, the results are identical.
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):
+ *
+ *		$Log: CDoublePacket.h,v $
+ */
+
+#pragma once
+
+#if WHISPER_AVX
+	#include <immintrin.h>
+#elif WHISPER_SSE2
+	#include <emmintrin.h>
+#endif
+
+
+//-----------------------------------
+//	Constants
+//
+const uint32 kPacketSize = 4;
+
+
+// ===================================================================================
+//	class CPacketMask
+//!		Result of comparing two CDoublePackets.
+// ===================================================================================
+class CPacketMask {
+
+public:
+#if WHISPER_AVX
+	explicit				CPacketMask(__m256d mask)						{mBits = (uint32) _mm256_movemask_pd(mask);}
+#elif WHISPER_SSE2
+							CPacketMask(__m128d lo, __m128d hi)				{mBits = (uint32) (_mm_movemask_pd(lo) | (_mm_movemask_pd(hi) << 2));}
+#endif
+	explicit				CPacketMask(uint32 bits)						{mBits = bits;}
+
+			uint32 			GetBits() const									{return mBits;}
+							/**< Bit i is set if the comparison was true for lane i. */
+
+private:
+	uint32	mBits;
+};
+
+
+// ===================================================================================
+//	class CDoublePacket
+//!		Four doubles that are operated on in parallel (using SIMD instructions if possible).
+// ===================================================================================
+class CDoublePacket {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+							CDoublePacket() 								{}
+
+							CDoublePacket(double value);
+							/**< Sets all four lanes to value. Note that this is not explicit
+							so that formulas can mix packets and scalars. */
+
+	static	CDoublePacket 	Load(const double* values);
+							/**< Values need not be aligned. */
+
+			void 			Store(double* values) const;
+
+//-----------------------------------
+//	API
+//
+public:
+	// ----- Assignment operators -----
+			CDoublePacket& 	operator+=(const CDoublePacket& rhs)			{*this = *this + rhs; return *this;}
+			CDoublePacket& 	operator-=(const CDoublePacket& rhs)			{*this = *this - rhs; return *this;}
+			CDoublePacket& 	operator*=(const CDoublePacket& rhs)			{*this = *this * rhs; return *this;}
+			CDoublePacket& 	operator/=(const CDoublePacket& rhs)			{*this = *this / rhs; return *this;}
+
+	// ----- Unary minus -----
+			CDoublePacket 	operator-() const;
+							/**< Flips the sign bit (like the scalar operator -0.0 is returned for 0.0). */
+
+	// ----- Arithmetic -----
+	friend	CDoublePacket 	operator+(const CDoublePacket& lhs, const CDoublePacket& rhs);
+	friend	CDoublePacket 	operator-(const CDoublePacket& lhs, const CDoublePacket& rhs);
+	friend	CDoublePacket 	operator*(const CDoublePacket& lhs, const CDoublePacket& rhs);
+	friend	CDoublePacket 	operator/(const CDoublePacket& lhs, const CDoublePacket& rhs);
+
+	// ----- Relational Operators -----
+	friend	CPacketMask 	operator<(const CDoublePacket& lhs, const CDoublePacket& rhs);
+							/**< Lanes containing NaNs compare false. */
+
+//-----------------------------------
+//	Member Data
+//
+private:
+#if WHISPER_AVX
+	__m256d		mValue;
+#elif WHISPER_SSE2
+	__m128d		mLo;						// lanes 0 and 1
+	__m128d		mHi;						// lanes 2 and 3
+#else
+	double		mValue[kPacketSize];
+#endif
+};
+
+
+// ===================================================================================
+//	Inlines
+// ===================================================================================
+#if WHISPER_AVX
+	inline CDoublePacket::CDoublePacket(double value)									{mValue = _mm256_set1_pd(value);}
+	inline CDoublePacket CDoublePacket::Load(const double* values)						{CDoublePacket result; result.mValue = _mm256_loadu_pd(values); return result;}
+	inline void CDoublePacket::Store(double* values) const								{_mm256_storeu_pd(values, mValue);}
+	inline CDoublePacket CDoublePacket::operator-() const								{CDoublePacket result; result.mValue = _mm256_xor_pd(mValue, _mm256_set1_pd(-0.0)); return result;}
+
+	inline CDoublePacket operator+(const CDoublePacket& lhs, const CDoublePacket& rhs)	{CDoublePacket result; result.mValue = _mm256_add_pd(lhs.mValue, rhs.mValue); return result;}
+	inline CDoublePacket operator-(const CDoublePacket& lhs, const CDoublePacket& rhs)	{CDoublePacket result; result.mValue = _mm256_sub_pd(lhs.mValue, rhs.mValue); return result;}
+	inline CDoublePacket operator*(const CDoublePacket& lhs, const CDoublePacket& rhs)	{CDoublePacket result; result.mValue = _mm256_mul_pd(lhs.mValue, rhs.mValue); return result;}
+	inline CDoublePacket operator/(const CDoublePacket& lhs, const CDoublePacket& rhs)	{CDoublePacket result; result.mValue = _mm256_div_pd(lhs.mValue, rhs.mValue); return result;}
+
+	inline CPacketMask operator<(const CDoublePacket& lhs, const CDoublePacket& rhs)	{return CPacketMask(_mm256_cmp_pd(lhs.mValue, rhs.mValue, _CMP_LT_OQ));}
+
+#elif WHISPER_SSE2
+	inline CDoublePacket::CDoublePacket(double value)									{mLo = mHi = _mm_set1_pd(value);}
+	inline CDoublePacket CDoublePacket::Load(const double* values)						{CDoublePacket result; result.mLo = _mm_loadu_pd(values); result.mHi = _mm_loadu_pd(values + 2); return result;}
+	inline void CDoublePacket::Store(double* values) const								{_mm_storeu_pd(values, mLo); _mm_storeu_pd(values + 2, mHi);}
+	inline CDoublePacket CDoublePacket::operator-() const								{CDoublePacket result; result.mLo = _mm_xor_pd(mLo, _mm_set1_pd(-0.0)); result.mHi = _mm_xor_pd(mHi, _mm_set1_pd(-0.0)); return result;}
+
+	inline CDoublePacket operator+(const CDoublePacket& lhs, const CDoublePacket& rhs)	{CDoublePacket result; result.mLo = _mm_add_pd(lhs.mLo, rhs.mLo); result.mHi = _mm_add_pd(lhs.mHi, rhs.mHi); return result;}
+	inline CDoublePacket operator-(const CDoublePacket& lhs, const CDoublePacket& rhs)	{CDoublePacket result; result.mLo = _mm_sub_pd(lhs.mLo, rhs.mLo); result.mHi = _mm_sub_pd(lhs.mHi, rhs.mHi); return result;}
+	inline CDoublePacket operator*(const CDoublePacket& lhs, const CDoublePacket& rhs)	{CDoublePacket result; result.mLo = _mm_mul_pd(lhs.mLo, rhs.mLo); result.mHi = _mm_mul_pd(lhs.mHi, rhs.mHi); return result;}
+	inline CDoublePacket operator/(const CDoublePacket& lhs, const CDoublePacket& rhs)	{CDoublePacket result; result.mLo = _mm_div_pd(lhs.mLo, rhs.mLo); result.mHi = _mm_div_pd(lhs.mHi, rhs.mHi); return result;}
+
+	inline CPacketMask operator<(const CDoublePacket& lhs, const CDoublePacket& rhs)	{return CPacketMask(_mm_cmplt_pd(lhs.mLo, rhs.mLo), _mm_cmplt_pd(lhs.mHi, rhs.mHi));}
+
+#else
+	inline CDoublePacket::CDoublePacket(double value)									{for (uint32 i = 0; i < kPacketSize; ++i) mValue[i] = value;}
+	inline CDoublePacket CDoublePacket::Load(const double* values)						{CDoublePacket result; for (uint32 i = 0; i < kPacketSize; ++i) result.mValue[i] = values[i]; return result;}
+	inline void CDoublePacket::Store(double* values) const								{for (uint32 i = 0; i < kPacketSize; ++i) values[i] = mValue[i];}
+	inline CDoublePacket CDoublePacket::operator-() const								{CDoublePacket result; for (uint32 i = 0; i < kPacketSize; ++i) result.mValue[i] = -mValue[i]; return result;}
+
+	inline CDoublePacket operator+(const CDoublePacket& lhs, const CDoublePacket& rhs)	{CDoublePacket result; for (uint32 i = 0; i < kPacketSize; ++i) result.mValue[i] = lhs.mValue[i] + rhs.mValue[i]; return result;}
+	inline CDoublePacket operator-(const CDoublePacket& lhs, const CDoublePacket& rhs)	{CDoublePacket result; for (uint32 i = 0; i < kPacketSize; ++i) result.mValue[i] = lhs.mValue[i] - rhs.mValue[i]; return result;}
+	inline CDoublePacket operator*(const CDoublePacket& lhs, const CDoublePacket& rhs)	{CDoublePacket result; for (uint32 i = 0; i < kPacketSize; ++i) result.mValue[i] = lhs.mValue[i] * rhs.mValue[i]; return result;}
+	inline CDoublePacket operator/(const CDoublePacket& lhs, const CDoublePacket& rhs)	{CDoublePacket result; for (uint32 i = 0; i < kPacketSize; ++i) result.mValue[i] = lhs.mValue[i] / rhs.mValue[i]; return result;}
+
+	inline CPacketMask operator<(const CDoublePacket& lhs, const CDoublePacket& rhs)
+	{
+		uint32 bits = 0;
+		for (uint32 i = 0; i < kPacketSize; ++i)
+			if (lhs.mValue[i] < rhs.mValue[i])
+				bits |= 1UL << i;
+
+		return CPacketMask(bits);
+	}
+#endif
+
+
+// ===================================================================================
+//	class CPacketDwells
+//!		Keeps track of the dwell for each lane while a packet is iterated.
+// ===================================================================================
+class CPacketDwells {
+
+public:
+							CPacketDwells(uint32 lanes, uint32* dwells)		{mLive = lanes; mDwells = dwells; mDwell = 0;}
+							/**< Lanes is a bit mask with the lanes that should be iterated. */
+
+							~CPacketDwells()								{this->DoRecord(mLive);}
+
+			uint32 			GetDwell() const								{return mDwell;}
+
+			bool 			Continue(const CPacketMask& inside)				{uint32 live = mLive & inside.GetBits(); this->DoRecord(mLive & ~live); mLive = live; return live != 0;}
+							/**< Lanes that are not inside are retired (once retired a lane
+							stays retired). Returns false if all the lanes have been retired. */
+
+			void 			Next()											{++mDwell;}
+
+private:
+			void 			DoRecord(uint32 lanes)							{for (uint32 i = 0; lanes != 0; ++i, lanes >>= 1) if (lanes & 1) mDwells[i] = mDwell;}
+
+private:
+	uint32	mLive;
+	uint32*	mDwells;
+	uint32	mDwell;
+};
@@ -23,6 +23,7 @@
 
 #include <XOptimize.h>
 
+#include "CDoublePacket.h"
 #include "IDocInfo.h"
 
 
@@ -51,6 +52,8 @@ CFractalFunction::CFractalFunction(XBoss* boss)
 
 	mUsesConstant = false;
 	mUsesLambda   = false;
+	
+	mHasDistanceEstimator = false;
 }
 
 
@@ -82,15 +85,15 @@ float CFractalFunction::ComputeDepth(const SFractalInfo& info, const X3DPoint& s
 	double cz = info.constant.z;
 	double cw = info.constant.w;
 	
+	const CHyperComplex& lambda = info.lambda;
+	
 	double sx = delta*eyeRay.x;
 	double sy = delta*eyeRay.y;
 	double sz = delta*eyeRay.z;	
 
-	mLambda = info.lambda;
-		
 	// Find the first point that's inside the fractal.
 	do {		
-		dwell = this->OnComputeDwell(px, py, pz, pw, cx, cy, cz, cw, bailout, maxDwell);	// $$$ last I checked performance was measurably better if a function pointer is used instead of a virtual method
+		dwell = this->OnComputeDwell(px, py, pz, pw, cx, cy, cz, cw, lambda, bailout, maxDwell);	// $$$ last I checked performance was measurably better if a function pointer is used instead of a virtual method
 																							// $$$ since we're not currently supporting plugins we could even write some assembler PPC glue to skip the call to ptr_glue
 		px += sx;						
 		py += sy;
@@ -98,33 +101,246 @@ float CFractalFunction::ComputeDepth(const SFractalInfo& info, const X3DPoint& s
 	} while (dwell < maxDwell && ++count < pixels);
 	
 	// If we hit the fractal then do a binary search to get a better
-	// depth estimate. (Note that the profiler says that this contributes
-	// essentially nothing to the render time).
+	// depth estimate.
 	double depth = INFINITY;
-	if (dwell >= maxDwell) {
-		depth = delta*count;
+	if (dwell >= maxDwell)
+		depth = this->DoRefineDepth(info, startPt, eyeRay, delta, count);
+	
+	return (float) depth;
+}
+
 
-		if (count > 0) {
-			const double kThreshold = delta/64.0;
+//---------------------------------------------------------------
+//
+// CFractalFunction::ComputeDepths
+//
+// Same as ComputeDepth except that up to kPacketSize rays march
+// together so that the formula can be iterated using SIMD
+// instructions. Rays that hit the fractal or the yon plane drop
+// out of the packet while the others continue on.
+//
+//---------------------------------------------------------------
+void CFractalFunction::ComputeDepths(const SFractalInfo& info, const X3DPoint* startPts, const X3DVector* eyeRays, uint32 count, float viewDepth, int32 pixelDepth, float* depths) const
+{	
+	PRECONDITION(startPts != nil);
+	PRECONDITION(eyeRays != nil);
+	PRECONDITION(count > 0 && count <= kPacketSize);
+	PRECONDITION(depths != nil);
+	COMPILE_CHECK(kPacketSize == kRayPacketSize);
 	
-			while (delta > kThreshold) {
-				delta = scalbn(delta, -1);
-				if (dwell >= maxDwell)
-					depth -= delta;
-				else
-					depth += delta;
+	double delta = viewDepth/pixelDepth;
+	ASSERT(delta > 0.0);
 
-				px = startPt.x + depth*eyeRay.x;
-				py = startPt.y + depth*eyeRay.y;
-				pz = startPt.z + depth*eyeRay.z;
+	uint32 maxDwell = info.maxDwell;
+	uint32 pixels   = (uint32) pixelDepth;
+	
+	double px[kPacketSize], py[kPacketSize], pz[kPacketSize];
+	double sx[kPacketSize], sy[kPacketSize], sz[kPacketSize];
+	uint32 counts[kPacketSize], dwells[kPacketSize];
+	
+	for (uint32 i = 0; i < kPacketSize; ++i) {
+		uint32 j = i < count ? i : 0;				// unused lanes are never iterated, but it's simpler if they have sane values
+		
+		PRECONDITION(Equal(eyeRays[j].LengthSquared(), 1.0));
 
-				dwell = this->OnComputeDwell(px, py, pz, pw, cx, cy, cz, cw, bailout, maxDwell);
+		px[i] = startPts[j].x;
+		py[i] = startPts[j].y;
+		pz[i] = startPts[j].z;
+		
+		sx[i] = delta*eyeRays[j].x;
+		sy[i] = delta*eyeRays[j].y;
+		sz[i] = delta*eyeRays[j].z;
+		
+		counts[i] = 0;
+		dwells[i] = 0;
+	}
+
+	// Find the first point along each ray that's inside the fractal.
+	uint32 lanes = (1UL << count) - 1;				// rays that are still marching
+	uint32 hits  = 0;
+	
+	while (lanes != 0) {
+		this->OnComputeDwells(px, py, pz, info.w, info.constant.x, info.constant.y, info.constant.z, info.constant.w, info.lambda, info.bailout, maxDwell, lanes, dwells);
+		
+		for (uint32 i = 0; i < count; ++i) {
+			uint32 lane = 1UL << i;
+			
+			if (lanes & lane) {
+				px[i] += sx[i];						
+				py[i] += sy[i];
+				pz[i] += sz[i];
+			
+				if (dwells[i] >= maxDwell) {
+					hits  |= lane;
+					lanes &= ~lane;
+				
+				} else if (++counts[i] >= pixels)
+					lanes &= ~lane;
 			}
-		}	
+		}
+	}
+	
+	// Refine the depths for the rays that hit the fractal.
+	for (uint32 i = 0; i < count; ++i) {
+		double depth = INFINITY;
+		if (hits & (1UL << i))
+			depth = this->DoRefineDepth(info, startPts[i], eyeRays[i], delta, counts[i]);
+			
+		depths[i] = (float) depth;
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CFractalFunction::EstimateDepth
+//
+// Same as ComputeDepth except that we skip over whole depth steps
+// when the distance estimate says the fractal is far away. The
+// points are still advanced by adding the step vector so that the
+// points we do evaluate are exactly the ones ComputeDepth would
+// have evaluated.
+//
+//---------------------------------------------------------------
+float CFractalFunction::EstimateDepth(const SFractalInfo& info, const X3DPoint& startPt, const X3DVector& eyeRay, float viewDepth, int32 pixelDepth) const
+{	
+	PRECONDITION(Equal(eyeRay.LengthSquared(), 1.0));
+	
+	if (!mHasDistanceEstimator)
+		return this->ComputeDepth(info, startPt, eyeRay, viewDepth, pixelDepth);
+	
+	const double kStepScale   = 0.5;			// the estimate isn't a strict lower bound so we only step part of the way
+	const double kNearSurface = 4.0;			// use the fixed steps when the estimate is within this many steps of the surface
+	
+	double delta = viewDepth/pixelDepth;
+	ASSERT(delta > 0.0);
+
+	double bailout  = info.bailout;
+	uint32 maxDwell = info.maxDwell;
+	uint32 pixels   = (uint32) pixelDepth;
+	uint32 count    = 0;
+	uint32 dwell    = 0;
+	
+	double px = startPt.x;
+	double py = startPt.y;
+	double pz = startPt.z;
+	double pw = info.w;
+		
+	double cx = info.constant.x;
+	double cy = info.constant.y;
+	double cz = info.constant.z;
+	double cw = info.constant.w;
+	
+	const CHyperComplex& lambda = info.lambda;
+	
+	double sx = delta*eyeRay.x;
+	double sy = delta*eyeRay.y;
+	double sz = delta*eyeRay.z;	
+
+	// Find the first point that's inside the fractal.
+	while (true) {		
+		double distance = this->OnEstimateDistance(px, py, pz, pw, cx, cy, cz, cw, lambda, bailout, maxDwell, dwell);
+		if (dwell >= maxDwell)
+			break;
+		
+		uint32 steps = 1;
+		if (distance > kNearSurface*delta)
+			steps = (uint32) Min(kStepScale*distance/delta, (double) pixels);
+		
+		count += steps;
+		if (count >= pixels)
+			break;
+			
+		for (uint32 i = 0; i < steps; ++i) {
+			px += sx;						
+			py += sy;
+			pz += sz;
+		}
 	}
 	
+	double depth = INFINITY;
+	if (dwell >= maxDwell)
+		depth = this->DoRefineDepth(info, startPt, eyeRay, delta, count);
+	
 	return (float) depth;
 }
 
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// CFractalFunction::OnComputeDwells
+//
+//---------------------------------------------------------------
+void CFractalFunction::OnComputeDwells(const double* x, const double* y, const double* z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const
+{
+	for (uint32 i = 0; i < kPacketSize; ++i)
+		if (lanes & (1UL << i))
+			dwells[i] = this->OnComputeDwell(x[i], y[i], z[i], w, cx, cy, cz, cw, lambda, bailout, maxDwell);
+}
+
+
+//---------------------------------------------------------------
+//
+// CFractalFunction::OnEstimateDistance
+//
+//---------------------------------------------------------------
+double CFractalFunction::OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& dwell) const
+{
+	dwell = this->OnComputeDwell(x, y, z, w, cx, cy, cz, cw, lambda, bailout, maxDwell);
+	
+	return 0.0;
+}
+
+
+//---------------------------------------------------------------
+//
+// CFractalFunction::DoRefineDepth
+//
+// Called after the march along eyeRay landed inside the fractal
+// after count steps. Does a binary search to get a better depth 
+// estimate. (Note that the profiler says that this contributes
+// essentially nothing to the render time).
+//
+//---------------------------------------------------------------
+double CFractalFunction::DoRefineDepth(const SFractalInfo& info, const X3DPoint& startPt, const X3DVector& eyeRay, double delta, uint32 count) const
+{
+	double bailout  = info.bailout;
+	uint32 maxDwell = info.maxDwell;
+	uint32 dwell    = maxDwell;
+	
+	double pw = info.w;
+		
+	double cx = info.constant.x;
+	double cy = info.constant.y;
+	double cz = info.constant.z;
+	double cw = info.constant.w;
+
+	const CHyperComplex& lambda = info.lambda;
+
+	double depth = delta*count;
+
+	if (count > 0) {
+		const double kThreshold = delta/64.0;
+
+		while (delta > kThreshold) {
+			delta = scalbn(delta, -1);
+			if (dwell >= maxDwell)
+				depth -= delta;
+			else
+				depth += delta;
+
+			double px = startPt.x + depth*eyeRay.x;
+			double py = startPt.y + depth*eyeRay.y;
+			double pz = startPt.z + depth*eyeRay.z;
+
+			dwell = this->OnComputeDwell(px, py, pz, pw, cx, cy, cz, cw, lambda, bailout, maxDwell);
+		}
+	}	
+	
+	return depth;
+}
 
 
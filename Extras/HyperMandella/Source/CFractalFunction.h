@@ -44,12 +44,33 @@ public:
 	virtual bool 		UsesLambda() const						{return mUsesLambda;}
 			
 	virtual float 		ComputeDepth(const SFractalInfo& info, const X3DPoint& startPt, const X3DVector& eyeRay, float viewDepth, int32 depth) const;
+	virtual void 		ComputeDepths(const SFractalInfo& info, const X3DPoint* startPts, const X3DVector* eyeRays, uint32 count, float viewDepth, int32 depth, float* depths) const;
+
+	virtual bool 		HasDistanceEstimator() const			{return mHasDistanceEstimator;}
+	virtual float 		EstimateDepth(const SFractalInfo& info, const X3DPoint& startPt, const X3DVector& eyeRay, float viewDepth, int32 depth) const;
 
 //-----------------------------------
 //	Internal API
 //
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const = 0;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const = 0;
+
+	virtual void 		OnComputeDwells(const double* x, const double* y, const double* z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const;
+						/**< Computes the dwells for the kPacketSize points in x, y, and z.
+						Lanes is a bit mask with the points that need to be computed (the
+						other dwells are left untouched). The default calls OnComputeDwell
+						for each lane. Subclasses should override this with a CDoublePacket
+						version of their formula that returns the same dwells. */
+
+	virtual double 		OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& dwell) const;
+						/**< Sets dwell to what OnComputeDwell would return and returns an
+						estimate of the distance from the point to the fractal (or zero if
+						the point is inside the fractal or there is no estimate). The
+						default calls OnComputeDwell and returns zero. Subclasses that
+						override this should set mHasDistanceEstimator. */
+
+private:
+			double 		DoRefineDepth(const SFractalInfo& info, const X3DPoint& startPt, const X3DVector& eyeRay, double delta, uint32 count) const;
 
 //-----------------------------------
 //	Member Data
@@ -57,7 +78,6 @@ protected:
 protected:
 	bool 					mUsesConstant;
 	bool 					mUsesLambda;
-
-	mutable CHyperComplex	mLambda;
+	bool 					mHasDistanceEstimator;
 };
 
@@ -11,6 +11,16 @@
  *				2) To add a new formula define a new class here and add a new item
  *				to the Formula menu in Menus.xml. 
  *
+ *				3) The polynomial formulas also override OnComputeDwells with a
+ *				CDoublePacket version that iterates four rays at once. These must
+ *				do the same operations in the same order as OnComputeDwell so that
+ *				the packet and scalar code compute the same dwells.
+ *
+ *				4) The polynomial formulas also override OnEstimateDistance. This
+ *				has to compute the same dwell as OnComputeDwell and also tracks
+ *				an upper bound on the squared magnitude of the derivative so that
+ *				EstimateDepth can skip over empty space.
+ *
  *  Copyright  1998 Jesse Jones. All Rights Reserved.
  *
  *  Change History (most recent first):	
@@ -30,6 +40,7 @@
 
 #include <XOptimize.h>
 
+#include "CDoublePacket.h"
 #include "CQuaternion.h"
 #include "IDocInfo.h"
 
@@ -47,7 +58,8 @@ inline double sqr(double x)	{return x*x;}
 // lhs = lhs + rhs
 //
 //---------------------------------------------------------------
-inline void AddQ(double& lhsX, double& lhsY, double& lhsZ, double& lhsW, double rhsX, double rhsY, double rhsZ, double rhsW)
+template <class T>
+inline void AddQ(T& lhsX, T& lhsY, T& lhsZ, T& lhsW, T rhsX, T rhsY, T rhsZ, T rhsW)
 {
 	lhsX += rhsX;
 	lhsY += rhsY;
@@ -63,12 +75,13 @@ inline void AddQ(double& lhsX, double& lhsY, double& lhsZ, double& lhsW, double
 // lhs = lhs * rhs
 //
 //---------------------------------------------------------------
-inline void MultQ(double& lhsX, double& lhsY, double& lhsZ, double& lhsW, double rhsX, double rhsY, double rhsZ, double rhsW)
+template <class T>
+inline void MultQ(T& lhsX, T& lhsY, T& lhsZ, T& lhsW, T rhsX, T rhsY, T rhsZ, T rhsW)
 {
-	double xx = lhsX*rhsX - lhsY*rhsY - lhsZ*rhsZ - lhsW*rhsW;
-	double yy = lhsY*rhsX + lhsX*rhsY + lhsW*rhsZ - lhsZ*rhsW;
-	double zz = lhsZ*rhsX - lhsW*rhsY + lhsX*rhsZ + lhsY*rhsW;
-	double ww = lhsW*rhsX + lhsZ*rhsY - lhsY*rhsZ + lhsX*rhsW;
+	T xx = lhsX*rhsX - lhsY*rhsY - lhsZ*rhsZ - lhsW*rhsW;
+	T yy = lhsY*rhsX + lhsX*rhsY + lhsW*rhsZ - lhsZ*rhsW;
+	T zz = lhsZ*rhsX - lhsW*rhsY + lhsX*rhsZ + lhsY*rhsW;
+	T ww = lhsW*rhsX + lhsZ*rhsY - lhsY*rhsZ + lhsX*rhsW;
 
 	lhsX = xx;
 	lhsY = yy;
@@ -84,9 +97,10 @@ inline void MultQ(double& lhsX, double& lhsY, double& lhsZ, double& lhsW, double
 // result = rhs*rhs
 //
 //---------------------------------------------------------------
-inline void SqrQ(double& resultX, double& resultY, double& resultZ, double& resultW, double rhsX, double rhsY, double rhsZ, double rhsW)
+template <class T>
+inline void SqrQ(T& resultX, T& resultY, T& resultZ, T& resultW, T rhsX, T rhsY, T rhsZ, T rhsW)
 {
-	double temp = rhsX + rhsX;
+	T temp = rhsX + rhsX;
 
 	resultX = rhsX*rhsX - (rhsY*rhsY + rhsZ*rhsZ + rhsW*rhsW);
 	resultY = rhsY*temp;
@@ -127,7 +141,8 @@ inline void DivideQ(double& lhsX, double& lhsY, double& lhsZ, double& lhsW, doub
 // lhs = lhs + rhs
 //
 //---------------------------------------------------------------
-inline void AddH(double& lhsX, double& lhsY, double& lhsZ, double& lhsW, double rhsX, double rhsY, double rhsZ, double rhsW)
+template <class T>
+inline void AddH(T& lhsX, T& lhsY, T& lhsZ, T& lhsW, T rhsX, T rhsY, T rhsZ, T rhsW)
 {
 	lhsX += rhsX;
 	lhsY += rhsY;
@@ -143,12 +158,13 @@ inline void AddH(double& lhsX, double& lhsY, double& lhsZ, double& lhsW, double
 // lhs = lhs * rhs
 //
 //---------------------------------------------------------------
-inline void MultH(double& lhsX, double& lhsY, double& lhsZ, double& lhsW, double rhsX, double rhsY, double rhsZ, double rhsW)
+template <class T>
+inline void MultH(T& lhsX, T& lhsY, T& lhsZ, T& lhsW, T rhsX, T rhsY, T rhsZ, T rhsW)
 {
-	double xx = lhsX*rhsX - lhsY*rhsY - lhsZ*rhsZ + lhsW*rhsW;
-	double yy = lhsY*rhsX + lhsX*rhsY - lhsW*rhsZ - lhsZ*rhsW;
-	double zz = lhsZ*rhsX - lhsW*rhsY + lhsX*rhsZ - lhsY*rhsW;
-	double ww = lhsW*rhsX + lhsZ*rhsY + lhsY*rhsZ + lhsX*rhsW;
+	T xx = lhsX*rhsX - lhsY*rhsY - lhsZ*rhsZ + lhsW*rhsW;
+	T yy = lhsY*rhsX + lhsX*rhsY - lhsW*rhsZ - lhsZ*rhsW;
+	T zz = lhsZ*rhsX - lhsW*rhsY + lhsX*rhsZ - lhsY*rhsW;
+	T ww = lhsW*rhsX + lhsZ*rhsY + lhsY*rhsZ + lhsX*rhsW;
 
 	lhsX = xx;
 	lhsY = yy;
@@ -164,12 +180,13 @@ inline void MultH(double& lhsX, double& lhsY, double& lhsZ, double& lhsW, double
 // result = rhs*rhs
 //
 //---------------------------------------------------------------
-inline void SqrH(double& resultX, double& resultY, double& resultZ, double& resultW, double rhsX, double rhsY, double rhsZ, double rhsW)
+template <class T>
+inline void SqrH(T& resultX, T& resultY, T& resultZ, T& resultW, T rhsX, T rhsY, T rhsZ, T rhsW)
 {
-	double xx = rhsX*rhsX - rhsY*rhsY - rhsZ*rhsZ + rhsW*rhsW;
-	double yy = rhsX*rhsY - rhsZ*rhsW;
-	double zz = rhsX*rhsZ - rhsY*rhsW;
-	double ww = rhsX*rhsW + rhsY*rhsZ;
+	T xx = rhsX*rhsX - rhsY*rhsY - rhsZ*rhsZ + rhsW*rhsW;
+	T yy = rhsX*rhsY - rhsZ*rhsW;
+	T zz = rhsX*rhsZ - rhsY*rhsW;
+	T ww = rhsX*rhsW + rhsY*rhsZ;
 
 	resultX = xx;
 	resultY = yy + yy;
@@ -443,6 +460,33 @@ static void CoshH(double& resultX, double& resultY, double& resultZ, double& res
 
 #pragma mark -
 
+// ===================================================================================
+//	Distance Estimation
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// DistanceEstimate
+//
+// Returns 0.5*|q|*ln|q|/|q'| where q is the first point in the orbit
+// outside the bailout and q' is the derivative of q with respect to
+// the starting point. Both arguments are squared magnitudes. Returns
+// zero if the estimate is meaningless (eg the bailout is less than
+// one or the derivative overflowed).
+//
+//---------------------------------------------------------------
+inline double DistanceEstimate(double mag, double derivMag)
+{
+	double distance = 0.0;
+	
+	if (mag > 1.0 && derivMag > 0.0 && derivMag < INFINITY)
+		distance = 0.25*sqrt(mag)*log(mag)/sqrt(derivMag);
+		
+	return distance;
+}
+
+#pragma mark -
+
 // ===================================================================================
 //	class CSqrQ
 // ===================================================================================
@@ -454,7 +498,9 @@ public:
 	virtual std::wstring GetFormula() const			{return L"q^2 + c";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
+	virtual void 		OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const;
+	virtual double 		OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CSqrQ)
@@ -468,6 +514,8 @@ CSqrQ::CSqrQ(XBoss* boss) : CFractalFunction(boss)
 {
 	mUsesConstant = true;
 	mUsesLambda   = false;
+
+	mHasDistanceEstimator = true;
 }
 
 
@@ -478,7 +526,7 @@ CSqrQ::CSqrQ(XBoss* boss) : CFractalFunction(boss)
 // q = q^2 + c
 //
 //---------------------------------------------------------------
-uint32 CSqrQ::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CSqrQ::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -508,6 +556,99 @@ uint32 CSqrQ::OnComputeDwell(double x, double y, double z, double w, double cx,
 	return dwell;
 }
 
+
+//---------------------------------------------------------------
+//
+// CSqrQ::OnComputeDwells								
+//
+// q = q^2 + c
+//
+//---------------------------------------------------------------
+void CSqrQ::OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const
+{	
+	CDoublePacket x = CDoublePacket::Load(inX);
+	CDoublePacket y = CDoublePacket::Load(inY);
+	CDoublePacket z = CDoublePacket::Load(inZ);
+	CDoublePacket w = inW;
+	
+	CDoublePacket cx = inCX;
+	CDoublePacket cy = inCY;
+	CDoublePacket cz = inCZ;
+	CDoublePacket cw = inCW;
+	
+	CDoublePacket bailout = inBailout;
+	CDoublePacket mag = 0.0;
+	
+	CPacketDwells dwell(lanes, dwells);
+
+	while (dwell.GetDwell() < maxDwell && dwell.Continue(mag < bailout)) {
+		CDoublePacket temp = x + x;
+		
+		CDoublePacket x2 = x*x;
+		CDoublePacket y2 = y*y;
+		CDoublePacket z2 = z*z;
+		CDoublePacket w2 = w*w;
+		
+		x = x2 - (y2 + z2 + w2);
+		y *= temp;
+		z *= temp;
+		w *= temp;
+
+		x += cx;
+		y += cy;
+		z += cz;
+		w += cw;
+
+		mag = x2 + y2 + z2 + w2;
+		dwell.Next();
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CSqrQ::OnEstimateDistance								
+//
+// q = q^2 + c
+//
+// q' = q'*q + q*q' so |q'| grows by at most 2|q| (quaternion
+// multiplication preserves magnitudes).
+//
+//---------------------------------------------------------------
+double CSqrQ::OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const
+{	
+	uint32 dwell = 0;
+	double mag = 0.0;
+	double deriv = 1.0;					// |q'|^2
+	
+	while (dwell < maxDwell && mag < bailout) {
+		double temp = x + x;
+		
+		double x2 = x*x;
+		double y2 = y*y;
+		double z2 = z*z;
+		double w2 = w*w;
+		
+		x = x2 - (y2 + z2 + w2);
+		y *= temp;
+		z *= temp;
+		w *= temp;
+
+		x += cx;
+		y += cy;
+		z += cz;
+		w += cw;
+
+		mag = x2 + y2 + z2 + w2;	// cheat a bit and use the values from the previous iteration
+		deriv *= 4.0*mag;
+		++dwell;
+	}
+	
+	outDwell = dwell;
+	
+	return dwell < maxDwell ? DistanceEstimate(x*x + y*y + z*z + w*w, deriv) : 0.0;
+}
+
 #pragma mark -
 
 // ===================================================================================
@@ -521,7 +662,9 @@ public:
 	virtual std::wstring GetFormula() const			{return L"q^3 + c";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
+	virtual void 		OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const;
+	virtual double 		OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CCubeQ)
@@ -535,6 +678,8 @@ CCubeQ::CCubeQ(XBoss* boss) : CFractalFunction(boss)
 {
 	mUsesConstant = true;
 	mUsesLambda   = false;
+
+	mHasDistanceEstimator = true;
 }
 
 
@@ -545,7 +690,7 @@ CCubeQ::CCubeQ(XBoss* boss) : CFractalFunction(boss)
 // q = q^3 + c
 //
 //---------------------------------------------------------------
-uint32 CCubeQ::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CCubeQ::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -578,6 +723,77 @@ uint32 CCubeQ::OnComputeDwell(double x, double y, double z, double w, double cx,
 	return dwell;
 }
 
+
+//---------------------------------------------------------------
+//
+// CCubeQ::OnComputeDwells								
+//
+// q = q^3 + c
+//
+//---------------------------------------------------------------
+void CCubeQ::OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const
+{	
+	CDoublePacket x = CDoublePacket::Load(inX);
+	CDoublePacket y = CDoublePacket::Load(inY);
+	CDoublePacket z = CDoublePacket::Load(inZ);
+	CDoublePacket w = inW;
+	
+	CDoublePacket cx = inCX;
+	CDoublePacket cy = inCY;
+	CDoublePacket cz = inCZ;
+	CDoublePacket cw = inCW;
+	
+	CDoublePacket bailout = inBailout;
+	CDoublePacket mag = 0.0;
+	
+	CPacketDwells dwell(lanes, dwells);
+
+	CDoublePacket tx, ty, tz, tw;
+	while (dwell.GetDwell() < maxDwell && dwell.Continue(mag < bailout)) {
+		SqrQ(tx, ty, tz, tw, x, y, z, w);
+		MultQ(x, y, z, w, tx, ty, tz, tw);
+		AddQ(x, y, z, w, cx, cy, cz, cw);
+
+		mag = x*x + y*y + z*z + w*w;
+		dwell.Next();
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CCubeQ::OnEstimateDistance								
+//
+// q = q^3 + c
+//
+// |q'| grows by at most 3|q|^2.
+//
+//---------------------------------------------------------------
+double CCubeQ::OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const
+{	
+	uint32 dwell = 0;
+	double mag = 0.0;
+	double deriv = 1.0;					// |q'|^2
+	double old = x*x + y*y + z*z + w*w;	// |q|^2 before the iteration
+
+	double tx, ty, tz, tw;
+	while (dwell < maxDwell && mag < bailout) {
+		SqrQ(tx, ty, tz, tw, x, y, z, w);
+		MultQ(x, y, z, w, tx, ty, tz, tw);
+		AddQ(x, y, z, w, cx, cy, cz, cw);
+
+		mag = x*x + y*y + z*z + w*w;
+		deriv *= 9.0*old*old;
+		old = mag;
+
+		++dwell;
+	}
+	
+	outDwell = dwell;
+	
+	return dwell < maxDwell ? DistanceEstimate(mag, deriv) : 0.0;
+}
+
 #pragma mark -
 
 // ===================================================================================
@@ -591,7 +807,9 @@ public:
 	virtual std::wstring GetFormula() const					{return L"q^4 + c";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
+	virtual void 		OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const;
+	virtual double 		OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CQuadQ)
@@ -605,6 +823,8 @@ CQuadQ::CQuadQ(XBoss* boss) : CFractalFunction(boss)
 {
 	mUsesConstant = true;
 	mUsesLambda   = false;
+
+	mHasDistanceEstimator = true;
 }
 
 
@@ -615,7 +835,7 @@ CQuadQ::CQuadQ(XBoss* boss) : CFractalFunction(boss)
 // q = q^4 + c
 //
 //---------------------------------------------------------------
-uint32 CQuadQ::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CQuadQ::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -649,6 +869,75 @@ uint32 CQuadQ::OnComputeDwell(double x, double y, double z, double w, double cx,
 	return dwell;
 }
 
+
+//---------------------------------------------------------------
+//
+// CQuadQ::OnComputeDwells								
+//
+// q = q^4 + c
+//
+//---------------------------------------------------------------
+void CQuadQ::OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const
+{	
+	CDoublePacket x = CDoublePacket::Load(inX);
+	CDoublePacket y = CDoublePacket::Load(inY);
+	CDoublePacket z = CDoublePacket::Load(inZ);
+	CDoublePacket w = inW;
+	
+	CDoublePacket cx = inCX;
+	CDoublePacket cy = inCY;
+	CDoublePacket cz = inCZ;
+	CDoublePacket cw = inCW;
+	
+	CDoublePacket bailout = inBailout;
+	CDoublePacket mag = 0.0;
+	
+	CPacketDwells dwell(lanes, dwells);
+
+	while (dwell.GetDwell() < maxDwell && dwell.Continue(mag < bailout)) {
+		SqrQ(x, y, z, w, x, y, z, w);
+		SqrQ(x, y, z, w, x, y, z, w);
+		AddQ(x, y, z, w, cx, cy, cz, cw);
+
+		mag = x*x + y*y + z*z + w*w;
+		dwell.Next();
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CQuadQ::OnEstimateDistance								
+//
+// q = q^4 + c
+//
+// |q'| grows by at most 4|q|^3.
+//
+//---------------------------------------------------------------
+double CQuadQ::OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const
+{	
+	uint32 dwell = 0;
+	double mag = 0.0;
+	double deriv = 1.0;					// |q'|^2
+	double old = x*x + y*y + z*z + w*w;	// |q|^2 before the iteration
+
+	while (dwell < maxDwell && mag < bailout) {
+		SqrQ(x, y, z, w, x, y, z, w);
+		SqrQ(x, y, z, w, x, y, z, w);
+		AddQ(x, y, z, w, cx, cy, cz, cw);
+
+		mag = x*x + y*y + z*z + w*w;
+		deriv *= 16.0*old*old*old;
+		old = mag;
+
+		++dwell;
+	}
+	
+	outDwell = dwell;
+	
+	return dwell < maxDwell ? DistanceEstimate(mag, deriv) : 0.0;
+}
+
 #pragma mark -
 
 // ===================================================================================
@@ -662,7 +951,9 @@ public:
 	virtual std::wstring GetFormula() const					{return L"c*q*(1 - q)";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
+	virtual void 		OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const;
+	virtual double 		OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CLambdaQ)
@@ -676,6 +967,8 @@ CLambdaQ::CLambdaQ(XBoss* boss) : CFractalFunction(boss)
 {
 	mUsesConstant = true;
 	mUsesLambda   = false;
+
+	mHasDistanceEstimator = true;
 }
 
 
@@ -686,7 +979,7 @@ CLambdaQ::CLambdaQ(XBoss* boss) : CFractalFunction(boss)
 // q = c*q*(1 - q)
 //
 //---------------------------------------------------------------
-uint32 CLambdaQ::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CLambdaQ::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -709,6 +1002,86 @@ uint32 CLambdaQ::OnComputeDwell(double x, double y, double z, double w, double c
 	return dwell;
 }
 
+
+//---------------------------------------------------------------
+//
+// CLambdaQ::OnComputeDwells								
+//
+// q = c*q*(1 - q)
+//
+//---------------------------------------------------------------
+void CLambdaQ::OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const
+{	
+	CDoublePacket x = CDoublePacket::Load(inX);
+	CDoublePacket y = CDoublePacket::Load(inY);
+	CDoublePacket z = CDoublePacket::Load(inZ);
+	CDoublePacket w = inW;
+	
+	CDoublePacket cx = inCX;
+	CDoublePacket cy = inCY;
+	CDoublePacket cz = inCZ;
+	CDoublePacket cw = inCW;
+	
+	CDoublePacket bailout = inBailout;
+	CDoublePacket mag = 0.0;
+	
+	CPacketDwells dwell(lanes, dwells);
+
+	CDoublePacket tx, ty, tz, tw;
+	while (dwell.GetDwell() < maxDwell && dwell.Continue(mag < bailout)) {
+		tx = 1.0 - x;
+		ty = -y;
+		tz = -z;
+		tw = -w;
+		
+		MultQ(x, y, z, w, cx, cy, cz, cw);
+		MultQ(x, y, z, w, tx, ty, tz, tw);
+
+		mag = x*x + y*y + z*z + w*w;
+		dwell.Next();
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CLambdaQ::OnEstimateDistance								
+//
+// q = c*q*(1 - q)
+//
+// q' = c*(q'*(1 - q) - q*q') so |q'| grows by at most
+// |c|*(|1 - q| + |q|) and (a + b)^2 <= 2*(a^2 + b^2).
+//
+//---------------------------------------------------------------
+double CLambdaQ::OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const
+{	
+	uint32 dwell = 0;
+	double mag = 0.0;
+	double deriv = 1.0;					// |q'|^2
+	double cmag = cx*cx + cy*cy + cz*cz + cw*cw;
+
+	double tx, ty, tz, tw;
+	while (dwell < maxDwell && mag < bailout) {
+		tx = 1.0 - x;
+		ty = -y;
+		tz = -z;
+		tw = -w;
+		
+		deriv *= 2.0*cmag*(tx*tx + ty*ty + tz*tz + tw*tw + x*x + y*y + z*z + w*w);
+
+		MultQ(x, y, z, w, cx, cy, cz, cw);
+		MultQ(x, y, z, w, tx, ty, tz, tw);
+
+		mag = x*x + y*y + z*z + w*w;
+
+		++dwell;
+	}
+	
+	outDwell = dwell;
+	
+	return dwell < maxDwell ? DistanceEstimate(mag, deriv) : 0.0;
+}
+
 #pragma mark -
 
 // ===================================================================================
@@ -722,7 +1095,7 @@ public:
 	virtual std::wstring GetFormula() const						{return L"Potts1q";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CPotts1Q)
@@ -746,7 +1119,7 @@ CPotts1Q::CPotts1Q(XBoss* boss) : CFractalFunction(boss)
 // q = [(q^2 + c - 1)/(2*q + c - 2)]^2
 //
 //---------------------------------------------------------------
-uint32 CPotts1Q::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CPotts1Q::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -803,7 +1176,7 @@ public:
 	virtual std::wstring GetFormula() const					{return L"Potts2q";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CPotts2Q)
@@ -829,7 +1202,7 @@ CPotts2Q::CPotts2Q(XBoss* boss) : CFractalFunction(boss)
 // q     = (num/denom)^2
 //
 //---------------------------------------------------------------
-uint32 CPotts2Q::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CPotts2Q::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -906,7 +1279,9 @@ public:
 	virtual std::wstring GetFormula() const						{return L"h^2 + c";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
+	virtual void 		OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const;
+	virtual double 		OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CSqrH)
@@ -920,6 +1295,8 @@ CSqrH::CSqrH(XBoss* boss) : CFractalFunction(boss)
 {
 	mUsesConstant = true;
 	mUsesLambda   = false;
+
+	mHasDistanceEstimator = true;
 }
 
 
@@ -930,7 +1307,7 @@ CSqrH::CSqrH(XBoss* boss) : CFractalFunction(boss)
 // h = h^2 + c
 //
 //---------------------------------------------------------------
-uint32 CSqrH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CSqrH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {		
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -963,6 +1340,105 @@ uint32 CSqrH::OnComputeDwell(double x, double y, double z, double w, double cx,
 	return dwell;
 }
 
+
+//---------------------------------------------------------------
+//
+// CSqrH::OnComputeDwells								
+//
+// h = h^2 + c
+//
+//---------------------------------------------------------------
+void CSqrH::OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const
+{	
+	CDoublePacket x = CDoublePacket::Load(inX);
+	CDoublePacket y = CDoublePacket::Load(inY);
+	CDoublePacket z = CDoublePacket::Load(inZ);
+	CDoublePacket w = inW;
+	
+	CDoublePacket cx = inCX;
+	CDoublePacket cy = inCY;
+	CDoublePacket cz = inCZ;
+	CDoublePacket cw = inCW;
+	
+	CDoublePacket bailout = inBailout;
+	CDoublePacket mag = 0.0;
+	
+	CPacketDwells dwell(lanes, dwells);
+
+	while (dwell.GetDwell() < maxDwell && dwell.Continue(mag < bailout)) {
+		CDoublePacket x2 = x*x;			
+		CDoublePacket y2 = y*y;			
+		CDoublePacket z2 = z*z;
+		CDoublePacket w2 = w*w;
+		
+		CDoublePacket xx = x2 - y2 - z2 + w2;
+		CDoublePacket yy = x*y - z*w;
+		CDoublePacket zz = x*z - y*w;
+		CDoublePacket ww = x*w + y*z;
+
+		x = xx;
+		y = yy + yy;
+		z = zz + zz;
+		w = ww + ww;
+
+		x += cx;
+		y += cy;
+		z += cz;
+		w += cw;
+
+		mag = x2 + y2 + z2 + w2;
+		dwell.Next();
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CSqrH::OnEstimateDistance								
+//
+// h = h^2 + c
+//
+// Hypercomplex multiplication doesn't preserve magnitudes,
+// but |a*b|^2 <= 2*|a|^2*|b|^2 so |h'|^2 grows by at most 8|h|^2.
+//
+//---------------------------------------------------------------
+double CSqrH::OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const
+{	
+	uint32 dwell = 0;
+	double mag = 0.0;
+	double deriv = 1.0;					// |h'|^2
+	
+	while (dwell < maxDwell && mag < bailout) {
+		double x2 = x*x;			
+		double y2 = y*y;			
+		double z2 = z*z;
+		double w2 = w*w;
+
+		double xx = x2 - y2 - z2 + w2;
+		double yy = x*y - z*w;
+		double zz = x*z - y*w;
+		double ww = x*w + y*z;
+
+		x = xx;
+		y = yy + yy;
+		z = zz + zz;
+		w = ww + ww;
+
+		x += cx;
+		y += cy;
+		z += cz;
+		w += cw;
+
+		mag = x2 + y2 + z2 + w2;	// cheat a bit and use the values from the previous iteration
+		deriv *= 8.0*mag;
+		++dwell;
+	}
+	
+	outDwell = dwell;
+	
+	return dwell < maxDwell ? DistanceEstimate(x*x + y*y + z*z + w*w, deriv) : 0.0;
+}
+
 #pragma mark -
 
 // ===================================================================================
@@ -976,7 +1452,9 @@ public:
 	virtual std::wstring GetFormula() const						{return L"h^3 + c";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
+	virtual void 		OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const;
+	virtual double 		OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CCubeH)
@@ -990,6 +1468,8 @@ CCubeH::CCubeH(XBoss* boss) : CFractalFunction(boss)
 {
 	mUsesConstant = true;
 	mUsesLambda   = false;
+
+	mHasDistanceEstimator = true;
 }
 
 
@@ -1000,7 +1480,7 @@ CCubeH::CCubeH(XBoss* boss) : CFractalFunction(boss)
 // h = h^3 + c
 //
 //---------------------------------------------------------------
-uint32 CCubeH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CCubeH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -1019,6 +1499,77 @@ uint32 CCubeH::OnComputeDwell(double x, double y, double z, double w, double cx,
 	return dwell;
 }
 
+
+//---------------------------------------------------------------
+//
+// CCubeH::OnComputeDwells								
+//
+// h = h^3 + c
+//
+//---------------------------------------------------------------
+void CCubeH::OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const
+{	
+	CDoublePacket x = CDoublePacket::Load(inX);
+	CDoublePacket y = CDoublePacket::Load(inY);
+	CDoublePacket z = CDoublePacket::Load(inZ);
+	CDoublePacket w = inW;
+	
+	CDoublePacket cx = inCX;
+	CDoublePacket cy = inCY;
+	CDoublePacket cz = inCZ;
+	CDoublePacket cw = inCW;
+	
+	CDoublePacket bailout = inBailout;
+	CDoublePacket mag = 0.0;
+	
+	CPacketDwells dwell(lanes, dwells);
+
+	CDoublePacket tx, ty, tz, tw;
+	while (dwell.GetDwell() < maxDwell && dwell.Continue(mag < bailout)) {
+		SqrH(tx, ty, tz, tw, x, y, z, w);
+		MultH(x, y, z, w, tx, ty, tz, tw);
+		AddH(x, y, z, w, cx, cy, cz, cw);
+
+		mag = x*x + y*y + z*z + w*w;
+		dwell.Next();
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CCubeH::OnEstimateDistance								
+//
+// h = h^3 + c
+//
+// |h'|^2 grows by at most 9*4*|h|^4 (see CSqrH).
+//
+//---------------------------------------------------------------
+double CCubeH::OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const
+{	
+	uint32 dwell = 0;
+	double mag = 0.0;
+	double deriv = 1.0;					// |h'|^2
+	double old = x*x + y*y + z*z + w*w;	// |h|^2 before the iteration
+						
+	double tx, ty, tz, tw;
+	while (dwell < maxDwell && mag < bailout) {
+		SqrH(tx, ty, tz, tw, x, y, z, w);
+		MultH(x, y, z, w, tx, ty, tz, tw);
+		AddH(x, y, z, w, cx, cy, cz, cw);
+
+		mag = x*x + y*y + z*z + w*w;
+		deriv *= 36.0*old*old;
+		old = mag;
+
+		++dwell;
+	}
+	
+	outDwell = dwell;
+	
+	return dwell < maxDwell ? DistanceEstimate(mag, deriv) : 0.0;
+}
+
 #pragma mark -
 
 // ===================================================================================
@@ -1032,7 +1583,9 @@ public:
 	virtual std::wstring GetFormula() const						{return L"h^4 + c";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
+	virtual void 		OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const;
+	virtual double 		OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CQuadH)
@@ -1046,6 +1599,8 @@ CQuadH::CQuadH(XBoss* boss) : CFractalFunction(boss)
 {
 	mUsesConstant = true;
 	mUsesLambda   = false;
+
+	mHasDistanceEstimator = true;
 }
 
 
@@ -1056,7 +1611,7 @@ CQuadH::CQuadH(XBoss* boss) : CFractalFunction(boss)
 // h = h^4 + c
 //
 //---------------------------------------------------------------
-uint32 CQuadH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CQuadH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -1074,6 +1629,75 @@ uint32 CQuadH::OnComputeDwell(double x, double y, double z, double w, double cx,
 	return dwell;
 }
 
+
+//---------------------------------------------------------------
+//
+// CQuadH::OnComputeDwells								
+//
+// h = h^4 + c
+//
+//---------------------------------------------------------------
+void CQuadH::OnComputeDwells(const double* inX, const double* inY, const double* inZ, double inW, double inCX, double inCY, double inCZ, double inCW, const CHyperComplex& lambda, double inBailout, uint32 maxDwell, uint32 lanes, uint32* dwells) const
+{	
+	CDoublePacket x = CDoublePacket::Load(inX);
+	CDoublePacket y = CDoublePacket::Load(inY);
+	CDoublePacket z = CDoublePacket::Load(inZ);
+	CDoublePacket w = inW;
+	
+	CDoublePacket cx = inCX;
+	CDoublePacket cy = inCY;
+	CDoublePacket cz = inCZ;
+	CDoublePacket cw = inCW;
+	
+	CDoublePacket bailout = inBailout;
+	CDoublePacket mag = 0.0;
+	
+	CPacketDwells dwell(lanes, dwells);
+
+	while (dwell.GetDwell() < maxDwell && dwell.Continue(mag < bailout)) {
+		SqrH(x, y, z, w, x, y, z, w);
+		SqrH(x, y, z, w, x, y, z, w);
+		AddH(x, y, z, w, cx, cy, cz, cw);
+
+		mag = x*x + y*y + z*z + w*w;
+		dwell.Next();
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CQuadH::OnEstimateDistance								
+//
+// h = h^4 + c
+//
+// |h'|^2 grows by at most 16*8*|h|^6 (see CSqrH).
+//
+//---------------------------------------------------------------
+double CQuadH::OnEstimateDistance(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell, uint32& outDwell) const
+{	
+	uint32 dwell = 0;
+	double mag = 0.0;
+	double deriv = 1.0;					// |h'|^2
+	double old = x*x + y*y + z*z + w*w;	// |h|^2 before the iteration
+
+	while (dwell < maxDwell && mag < bailout) {
+		SqrH(x, y, z, w, x, y, z, w);
+		SqrH(x, y, z, w, x, y, z, w);
+		AddH(x, y, z, w, cx, cy, cz, cw);
+
+		mag = x*x + y*y + z*z + w*w;
+		deriv *= 128.0*old*old*old;
+		old = mag;
+
+		++dwell;
+	}
+	
+	outDwell = dwell;
+	
+	return dwell < maxDwell ? DistanceEstimate(mag, deriv) : 0.0;
+}
+
 #pragma mark -
 
 // ===================================================================================
@@ -1087,7 +1711,7 @@ public:
 	virtual std::wstring GetFormula() const						{return L"h^e + c";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CEPwrH)
@@ -1111,7 +1735,7 @@ CEPwrH::CEPwrH(XBoss* boss) : CFractalFunction(boss)
 // h = h^e + c
 //
 //---------------------------------------------------------------
-uint32 CEPwrH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CEPwrH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -1141,7 +1765,7 @@ public:
 	virtual std::wstring GetFormula() const						{return L"h^pi + c";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CPiPwrH)
@@ -1165,7 +1789,7 @@ CPiPwrH::CPiPwrH(XBoss* boss) : CFractalFunction(boss)
 // h = h^pi + c
 //
 //---------------------------------------------------------------
-uint32 CPiPwrH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CPiPwrH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -1195,7 +1819,7 @@ public:
 	virtual std::wstring GetFormula() const						{return L"sqrt(h^4) + c";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CSqrtH)
@@ -1219,7 +1843,7 @@ CSqrtH::CSqrtH(XBoss* boss) : CFractalFunction(boss)
 // h = sqrt(h^4) + c
 //
 //---------------------------------------------------------------
-uint32 CSqrtH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CSqrtH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -1266,7 +1890,7 @@ public:
 	virtual std::wstring GetFormula() const						{return L"Potts1h";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CPotts1H)
@@ -1290,7 +1914,7 @@ CPotts1H::CPotts1H(XBoss* boss) : CFractalFunction(boss)
 // h = [(h^2 + c - 1)/(2*h + c - 2)]^2
 //
 //---------------------------------------------------------------
-uint32 CPotts1H::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CPotts1H::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -1331,7 +1955,7 @@ public:
 	virtual std::wstring GetFormula() const						{return L"Potts2h";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CPotts2H)
@@ -1357,7 +1981,7 @@ CPotts2H::CPotts2H(XBoss* boss) : CFractalFunction(boss)
 // h     = (num/denom)^2
 //
 //---------------------------------------------------------------
-uint32 CPotts2H::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CPotts2H::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -1434,7 +2058,7 @@ public:
 	virtual std::wstring GetFormula() const							{return L"l*e^h + c";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CExpH)
@@ -1458,15 +2082,15 @@ CExpH::CExpH(XBoss* boss) : CFractalFunction(boss)
 // h = l*e^h + c
 //
 //---------------------------------------------------------------
-uint32 CExpH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CExpH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
 	
-	double lx = mLambda.x;
-	double ly = mLambda.y;
-	double lz = mLambda.z;
-	double lw = mLambda.w;
+	double lx = lambda.x;
+	double ly = lambda.y;
+	double lz = lambda.z;
+	double lw = lambda.w;
 
 	double tx, ty, tz, tw;
 	while (dwell < maxDwell && mag < bailout) {
@@ -1499,7 +2123,7 @@ public:
 	virtual std::wstring GetFormula() const					{return L"h^2 + sin(h) + c";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CSinSqrH)
@@ -1523,7 +2147,7 @@ CSinSqrH::CSinSqrH(XBoss* boss) : CFractalFunction(boss)
 // h = h^2 + sin(h) + c	
 //
 //---------------------------------------------------------------
-uint32 CSinSqrH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CSinSqrH::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {	
 	uint32 dwell = 0;
 	double mag = 0.0;
@@ -1573,7 +2197,7 @@ public:
 	virtual std::wstring  GetFormula() const					{return L"Sphere";}
 
 protected:
-	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const;
+	virtual uint32 		OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const;
 };
 
 DEFINE_INTERFACE_FACTORY(CSphere)
@@ -1595,7 +2219,7 @@ CSphere::CSphere(XBoss* boss) : CFractalFunction(boss)
 // CSphere::OnComputeDwell							
 //
 //---------------------------------------------------------------
-uint32 CSphere::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, double bailout, uint32 maxDwell) const
+uint32 CSphere::OnComputeDwell(double x, double y, double z, double w, double cx, double cy, double cz, double cw, const CHyperComplex& lambda, double bailout, uint32 maxDwell) const
 {			
 	UNUSED(w);
 	UNUSED(cw);
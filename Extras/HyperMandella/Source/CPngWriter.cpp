@@ -138,7 +138,7 @@ void CPngWriter::Write(OSType type, const XFileSpec& spec) const
 	IConstRendererPtr renderer = this->DoGetRenderer();
 	const XPixMap* pixels = renderer->GetImage();
 	
-	XPNGExporter exporter;
+	XPNGExporter exporter(0.0, false, XPNGExporter::kDefaultCompression, 0);	// compress with all the processors
 	exporter.Export(spec, pixels, 'HypM', 'PNGf');	
 	
 	// Write the fractal info
@@ -194,13 +194,20 @@ XHandle CPngWriter::GetPreviewData() const
 //
 // CPngWriter::DoGetRenderer
 //
+// Documents render into a child window so we have to search the
+// hierarchy, but the batch renderer's boss has its own renderer.
+//
 //---------------------------------------------------------------
 IConstRendererPtr CPngWriter::DoGetRenderer() const
 {
-	IConstHierarchyPtr node(this);	// $$ This is a bit cheesy...
+	IConstRendererPtr renderer(this);
+	
+	if (!renderer) {
+		IConstHierarchyPtr node(this);	// $$ This is a bit cheesy...
 
-	XCallback1<bool, IHierarchyPtr> predicate(MatchInterface<IRenderer>());
-	IConstRendererPtr renderer = node->FindChild(predicate);
+		XCallback1<bool, IHierarchyPtr> predicate(MatchInterface<IRenderer>());
+		renderer = node->FindChild(predicate);
+	}
 	
 	return renderer;
 }
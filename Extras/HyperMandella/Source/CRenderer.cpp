@@ -52,15 +52,24 @@
 #include "AppHeader.h"
 #include "IRenderer.h"
 
+#include <map>
+#include <vector>
+
 #include <IChildNode.h>
 #include <IDocument.h>
 #include <IHierarchy.h>
 #include <ILoaded.h>
 #include <XArray.h>
+#include <XAtomicCounter.h>
 #include <XAutoPtr.h>
+#include <XBind.h>
+#include <XIOU.h>
 #include <XMiscUtils.h>
 #include <XPixMap.h>
 #include <XPreference.h>
+#include <XSystemInfo.h>
+#include <XThread.h>
+#include <XUnitTest.h>
 
 #include "CColorEvaluator.h"
 #include "CDissolve.h"
@@ -83,7 +92,18 @@
 const float kNotComputed = (float) -INFINITY;
 const float kHitYonPlane = (float) +INFINITY;
 
-const int32 kSuperSampleSize = 9;				// best if a multiple of 3
+const int32 kCoarseSampleSize = 3;				// edge pixels are first sampled with a kCoarseSampleSize x kCoarseSampleSize grid
+const int32 kSuperSampleSize  = 9;				// if the colors vary too much a kSuperSampleSize x kSuperSampleSize grid is used
+
+const float kMaxSampleVariance = 0.002f;		// the coarse samples are good enough if the variance of every color channel is less than this
+
+const int32 kTileSize = 64;						// when multithreaded each thread renders kTileSize x kTileSize tiles
+const int32 kDissolveBatch = 64;				// the single threaded scalar path reads the clock once per kDissolveBatch pixels
+
+const int32 kMaxPreviewStep = 4;				// the first progressive pass casts rays for every kMaxPreviewStep'th pixel
+const float kMaxBoundSlope  = 2.0f;				// coarse depths are only good lower bounds if the surface isn't much steeper than this
+
+const int32 kReprojectRadius = 1;				// reprojected depths within this many pixels are used for a pixel's lower bound
 
 
 // ===================================================================================
@@ -103,6 +123,71 @@ inline bool InsideSet(float depth)
 }
 
 
+//---------------------------------------------------------------
+//
+// ComputeNormal
+//
+// Like CRenderer::DoComputeNormal except that it works with an
+// arbitrary grid of points. Neighbors that aren't on the fractal
+// should be nil.
+//
+//---------------------------------------------------------------
+static X3DVector ComputeNormal(const X3DPoint& center, const X3DPoint* left, const X3DPoint* top, const X3DPoint* right, const X3DPoint* bottom)
+{
+	X3DVector normalV = kZero3DVector;
+	
+	if (left != nil && top != nil)
+		normalV += CrossProduct(X3DVector(*left - center), X3DVector(center - *top));
+	
+	if (right != nil && top != nil)
+		normalV += CrossProduct(X3DVector(center - *right), X3DVector(*top - center));
+	
+	if (right != nil && bottom != nil)
+		normalV += CrossProduct(X3DVector(*right - center), X3DVector(center - *bottom));
+	
+	if (left != nil && bottom != nil)
+		normalV += CrossProduct(X3DVector(center - *left), X3DVector(*bottom - center));
+	
+	return normalV;
+}
+
+
+//---------------------------------------------------------------
+//
+// ComputeVariance
+//
+// Returns the largest variance of the three color channels.
+//
+//---------------------------------------------------------------
+static float ComputeVariance(const XRGBColor* colors, int32 count)
+{
+	PRECONDITION(colors != nil);
+	PRECONDITION(count > 0);
+	
+	double red = 0.0, green = 0.0, blue = 0.0;
+	for (int32 i = 0; i < count; ++i) {
+		red   += colors[i].red;
+		green += colors[i].green;
+		blue  += colors[i].blue;
+	}
+	
+	red   /= count;
+	green /= count;
+	blue  /= count;
+	
+	double redVar = 0.0, greenVar = 0.0, blueVar = 0.0;
+	for (int32 i = 0; i < count; ++i) {
+		redVar   += (colors[i].red - red)*(colors[i].red - red);
+		greenVar += (colors[i].green - green)*(colors[i].green - green);
+		blueVar  += (colors[i].blue - blue)*(colors[i].blue - blue);
+	}
+	
+	double variance = Max(redVar, Max(greenVar, blueVar))/count;
+	
+	return (float) variance;
+}
+
+
 //---------------------------------------------------------------
 //
 // Interpolate
@@ -171,8 +256,16 @@ public:
 	virtual int32 		Render(MilliSecond delay);
 	
 	virtual void 		SetResolution(const XSize& resolution, int32 depth);
+	virtual void 		SetThreadCount(int32 count);
+	virtual void 		SetKernel(ERayKernel kernel);
+	virtual void 		EnableAntiAliasing(bool enable);
+	virtual void 		EnableProgressive(bool enable);
+	virtual int32 		GetPreviewStep() const;
+	virtual void 		EnableReprojection(bool enable);
 
 	virtual const XPixMap* GetImage() const;
+	virtual const XArray<float>& GetDepths() const;
+	virtual SRenderTimes GetTimes() const;
 
 	virtual void 		Reset(const IDocInfoPtr& doc);
 	virtual void 		Reset();
@@ -183,36 +276,96 @@ protected:
 	virtual void 		OnAdopted();
 	virtual void 		OnOrphaned();
 
+//-----------------------------------
+//	Types
+//
+private:
+	struct SEdgeSamples {
+		std::vector<float> coarse;				// depths for the kCoarseSampleSize grid (empty until the rays are cast)
+		std::vector<float> fine;				// depths for the kSuperSampleSize grid (empty until the rays are cast)
+	};
+	
+	typedef std::map<int32, SEdgeSamples> SampleRow;	// keyed by h
+	
+	struct SAntiAlias {
+		bool			enabled;
+		XAtomicCounter	nextRow;				// next row that needs to be antialiased (may exceed the image height)
+		std::vector<SampleRow> samples;			// sample depths for the edge pixels in each row (kept when reshading)
+	};
+	
+	struct SPreview {
+		bool			enabled;
+		int32			step;					// grid spacing of the current pass (1 once the previews are done)
+		bool			shading;				// true once the rays for the current pass have been cast
+		XAtomicCounter	nextRow;				// next grid row for the current pass (may exceed the row count)
+	};
+	
+	struct STilesResult {
+		int32			count;					// number of pixels (or rows) rendered
+		SRenderTimes	times;
+	};
+	
+	struct SRayKey {							// everything the depths depend on
+		IConstFractalFunctionPtr function;
+		SFractalInfo	fractal;
+		int32			pixelDepth;
+		float			viewDepth;
+		bool			orthographic;			// if true the hither points are an affine function of the pixel and the eye rays are all zAxis
+		X3DVector		zAxis;
+		X3DPoint		origin;					// hither point for pixel (0, 0)
+		X3DVector		hStep;					// hither point for pixel (1, 0) minus origin
+		X3DVector		vStep;
+		XSize			size;
+		
+		bool			SameRays(const SRayKey& rhs) const;
+		bool			SameMarch(const SRayKey& rhs) const;
+	};
+
 //-----------------------------------
 //	Internal API
 //
 private:
 			void 		DoReset(const SDocumentMessage& message);
+			bool 		DoIsCastingDone() const;
+			bool 		DoUseTiles() const;
 			
+			void 		DoResetAntiAliaser(bool reshading);
+			void 		DoResetPreview(bool reshading);
+			
+			SRayKey 	DoGetRayKey() const;
+			XArray<float>* DoCreateSeeds(const SRayKey& oldKey, const XArray<float>& oldDepths) const;
+			XArray<float>* DoCreateBounds(const SRayKey& oldKey, const XArray<float>& oldDepths) const;
+			
+			int32 		DoRunThreads(const XCallback2<void, XIOU<STilesResult>&, MilliSecond>& function, MilliSecond stopTime);
+			void 		DoRenderTilesThread(XIOU<STilesResult>& result, MilliSecond stopTime);
+			
+			void 		DoPreviewThread(XIOU<STilesResult>& result, MilliSecond stopTime);
+			void 		DoNextPreviewPhase();
+			void 		DoDiscardBoundedSeeds();
+			void 		DoCastPreviewRow(const IConstFractalFunctionPtr& function, int32 v, int32 step);
+			void 		DoShadePreviewRow(const IConstShaderPtr& shader, CColorEvaluator& expr, int32 v, int32 step);
+			float 		DoGetLowerBound(int32 h, int32 v) const;
+			int32 		DoRenderTile(const IConstShaderPtr& shader, const IConstFractalFunctionPtr& function, CColorEvaluator& expr, int32 index, SRenderTimes& times);
+
+			bool 		DoUsePackets(const IConstFractalFunctionPtr& function) const;
 			X3DVector 	DoNeighborhoodCast(const IConstFractalFunctionPtr& function, int32 h, int32 v);
-			X3DVector 	DoRayCast(const IConstFractalFunctionPtr& function, int32 h, int32 v);
-			void 		DoRender(const IConstShaderPtr& shader, int32 h, int32 v, const X3DVector& viewV);
-
-			XRGBColor 	DoGetDiffuseColor(int32 h, int32 v) const;
-			X3DVector 	DoComputeNormal(int32 h, int32 v) const;
-			X3DPoint 	DoGetPoint(int32 h, int32 v) const;
+			X3DVector 	DoRayCast(const IConstFractalFunctionPtr& function, XArray<float>& depths, int32 h, int32 v);
+			void 		DoRayCastPacket(const IConstFractalFunctionPtr& function, XArray<float>& depths, int32 h, int32 v, int32 step, uint32 count);
+			void 		DoRender(const IConstShaderPtr& shader, CColorEvaluator& expr, const X3DVector& normalV, const XArray<float>& depths, int32 h, int32 v, const X3DVector& viewV);
+			XRGBColor 	DoGetColor(const IConstShaderPtr& shader, double colorIndex, const X3DVector& normalV, const XArray<float>& depths, int32 h, int32 v, const X3DVector& viewV);
+
+			XRGBColor 	DoGetDiffuseColor(double colorIndex) const;
+			X3DVector 	DoGetNormal(const XArray<float>& depths, int32 h, int32 v, const X3DVector& viewV) const;
+			X3DVector 	DoComputeNormal(const XArray<float>& depths, int32 h, int32 v) const;
+			X3DPoint 	DoGetPoint(const XArray<float>& depths, int32 h, int32 v) const;
 			
+			void 		DoAntiAliasThread(XIOU<STilesResult>& result, MilliSecond stopTime);
+			XRGBColor 	DoSuperSample(const IConstShaderPtr& shader, const IConstFractalFunctionPtr& function, CColorEvaluator& expr, int32 h, int32 v);
+			void 		DoSampleGrid(const IConstShaderPtr& shader, const IConstFractalFunctionPtr& function, CColorEvaluator& expr, int32 h, int32 v, int32 size, std::vector<float>& depths, XRGBColor* colors);
 			bool 		DoIsEdgePixel(int32 h, int32 v) const;
-			XRGBColor 	DoFilter(const XPixMap* image) const;
+			XRGBColor 	DoFilter(const XRGBColor* colors, int32 size) const;
 			
 
-//-----------------------------------
-//	Types
-//
-private:
-	struct SAntiAlias {
-		bool			enabled;
-		IDocInfoPtr		doc;	
-		ICameraPtr		camera;
-		IRendererPtr	renderer;
-		XPoint			pt;						// next point that needs to be antialiased
-	};
-
 //-----------------------------------
 //	Member Data
 //
@@ -230,11 +383,25 @@ private:
 	
 	XPixMap*			mImage;
 	XArray<float>*		mDepths;				// distance from view pixel to the fractal surface
+	XArray<float>*		mSeeds;					// depths left over from the last render that are still valid (may be nil)
+	XArray<float>*		mBounds;				// lower bounds reprojected from the last render (may be nil)
+	XArray<bool>*		mBoundedSeeds;			// preview depths that were marched from a coarse lower bound (nil unless previewing)
+	bool				mReproject;
+	SRayKey				mRayKey;				// inputs used to compute mDepths
 	CDissolve			mDissolve;				// randomly generates rays to be evaluated
 	int32				mCount;					// number of rays that have been generated
+	
+	int32				mThreadCount;
+	int32				mTilesWide;				// tiles are used instead of mDissolve if DoUseTiles returns true
+	int32				mTilesHigh;
+	XAtomicCounter		mNextTile;				// index of the next tile to render (may exceed the tile count)
+	
+	ERayKernel			mKernel;
 		
 	MilliSecond			mElapsedTime;			
+	SRenderTimes		mTimes;
 	SAntiAlias			mAntiAliaser;
+	SPreview			mPreview;				// if enabled mSeeds holds the coarse depths
 	
 #if PROFILE_RENDER
 	MProfiler*			mRenderProfile;
@@ -252,14 +419,14 @@ CRenderer::~CRenderer()
 {
 	delete mImage;
 	delete mDepths;
+	delete mSeeds;
+	delete mBounds;
+	delete mBoundedSeeds;
 	delete mColorExpr;
 
 #if PROFILE_RENDER
 	delete mRenderProfile;
 #endif
-
-	if (mAntiAliaser.doc)
-		mAntiAliaser.renderer->Reset(IDocInfoPtr());		// have to break a cycle
 }
 
 
@@ -275,17 +442,32 @@ CRenderer::CRenderer(XBoss* boss) : mDissolve(kZeroSize)
 	IChildNode::DoSetBoss(boss);
 			
 	mDepths = nil;	
+	mSeeds  = nil;
+	mBounds = nil;
+	mBoundedSeeds = nil;
 	mImage  = nil;
 	mColorExpr = nil;
 
 	mCount = 0;	
 	mElapsedTime = 0;
-	mAntiAliaser.pt = kZeroPt;
+	
+	mThreadCount = 1;
+	mKernel = kScalarKernel;
+	mTilesWide = 0;
+	mTilesHigh = 0;
 	mAntiAliaser.enabled = false;
+	mPreview.enabled = false;
+	mPreview.step = 1;
+	mPreview.shading = false;
+	mReproject = false;
 
 #if PROFILE_RENDER
 	mRenderProfile = nil;
 #endif
+
+	mRayKey.pixelDepth   = 0;
+	mRayKey.viewDepth    = 0.0f;
+	mRayKey.orthographic = false;
 }
 
 
@@ -316,9 +498,19 @@ void CRenderer::Reset()
 	mImage->Erase(0);
 	mDepths->Set(kNotComputed);
 	
+	delete mSeeds;
+	delete mBounds;
+	mSeeds = nil;
+	mBounds = nil;
+	
+	this->DoResetAntiAliaser(false);
+	this->DoResetPreview(false);
+	
 	mDissolve.Reset();
 	mCount = 0;
 	mElapsedTime = 0;
+	mTimes = SRenderTimes();
+	mNextTile = 0;
 }
 
 						
@@ -335,6 +527,30 @@ const XPixMap* CRenderer::GetImage() const
 }
 
 
+//---------------------------------------------------------------
+//
+// CRenderer::GetDepths
+//
+//---------------------------------------------------------------
+const XArray<float>& CRenderer::GetDepths() const
+{
+	PRECONDITION(mDepths != nil);
+	
+	return *mDepths;
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::GetTimes
+//
+//---------------------------------------------------------------
+SRenderTimes CRenderer::GetTimes() const
+{
+	return mTimes;
+}
+
+
 //---------------------------------------------------------------
 //
 // CRenderer::IsDone
@@ -344,8 +560,8 @@ bool CRenderer::IsDone() const
 {
 	bool done = false;
 	
-	if (mDissolve.IsDone())
-		if (!mAntiAliaser.enabled || mAntiAliaser.pt.y >= mResolution.height)
+	if (this->DoIsCastingDone())
+		if (!mAntiAliaser.enabled || mAntiAliaser.nextRow >= mResolution.height)
 			done = true;
 	
 	return done;
@@ -359,7 +575,7 @@ bool CRenderer::IsDone() const
 //---------------------------------------------------------------
 void CRenderer::SetResolution(const XSize& resolution, int32 depth)
 {
-	if (resolution != mResolution.GetSize() || mImage == nil) {
+	if (resolution != mResolution.GetSize() || mImage == nil || depth != mImage->GetDepth()) {
 		XAutoPtr<XPixMap> image(new XPixMap(resolution, nil, depth));	
 		image->Erase(0);
 
@@ -369,35 +585,129 @@ void CRenderer::SetResolution(const XSize& resolution, int32 depth)
 		delete mDepths;
 		mImage = image.Release();	
 		mDepths = depths;	
+		
+		delete mSeeds;							// wrong size
+		delete mBounds;
+		mSeeds = nil;
+		mBounds = nil;
 
 		mWidthStep  = 1.0f/resolution.width;
 		mHeightStep = 1.0f/resolution.height;
 			
 		mDissolve = CDissolve(resolution);
 		mCount = 0;
+		
+		mTilesWide = (resolution.width + kTileSize - 1)/kTileSize;
+		mTilesHigh = (resolution.height + kTileSize - 1)/kTileSize;
+		mNextTile = 0;
 			
 		mResolution.width  = resolution.width;
 		mResolution.height = resolution.height;
 		
-		mAntiAliaser.doc.Release();
-		mAntiAliaser.pt = kZeroPt;
+		this->DoResetAntiAliaser(false);
+		this->DoResetPreview(false);
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::SetThreadCount
+//
+//---------------------------------------------------------------
+void CRenderer::SetThreadCount(int32 count)
+{
+	PRECONDITION(count >= 1);
+	
+	if (count != mThreadCount) {
+		mThreadCount = count;
+		
+		if (mImage != nil)
+			this->Reset();			// tiles and mDissolve don't track the same pixels so we have to start over
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::SetKernel
+//
+//---------------------------------------------------------------
+void CRenderer::SetKernel(ERayKernel kernel)
+{
+	if (kernel != mKernel) {
+		mKernel = kernel;
+		
+		if (mImage != nil)
+			this->Reset();			// distance estimation can produce slightly different depths (and packets use tiles instead of mDissolve)
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::EnableAntiAliasing
+//
+//---------------------------------------------------------------
+void CRenderer::EnableAntiAliasing(bool enable)
+{
+	mAntiAliaser.enabled = enable;
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::EnableProgressive
+//
+//---------------------------------------------------------------
+void CRenderer::EnableProgressive(bool enable)
+{
+	if (enable != mPreview.enabled) {
+		mPreview.enabled = enable;
+		
+		if (mImage != nil)
+			this->Reset();			// the preview passes have to start with an empty image
 	}
 }
 
 
+//---------------------------------------------------------------
+//
+// CRenderer::GetPreviewStep
+//
+//---------------------------------------------------------------
+int32 CRenderer::GetPreviewStep() const
+{
+	return mPreview.step;
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::EnableReprojection
+//
+//---------------------------------------------------------------
+void CRenderer::EnableReprojection(bool enable)
+{
+	mReproject = enable;
+}
+
+
 //---------------------------------------------------------------
 //
 // CRenderer::Render
 //
-// $$$ Need to anti-alias (might be able to do this by creating
-// $$$ a render boss that's a subset of the Document boss)
+// If progressive rendering is enabled we start with the coarse 
+// preview passes. Once all the rays have been cast the pixels on 
+// the edges of the fractal are anti-aliased (if anti-aliasing is 
+// enabled).
 //
 //---------------------------------------------------------------
 int32 CRenderer::Render(MilliSecond delay)
 {		
 	PRECONDITION(mImage != nil);
 	
-	XLocker lock(mImage);				// speeds up SetPixelAt (and disables purging)
+	XLocker lock(mImage);				// speeds up SetColorsAt (and disables purging)
 
 	MilliSecond startTime = GetMilliSeconds();
 	MilliSecond stopTime = GetMilliSeconds() + delay;
@@ -405,84 +715,65 @@ int32 CRenderer::Render(MilliSecond delay)
 	MilliSecond time = startTime;
 	int32 percent;
 
-	if (!mDissolve.IsDone()) {
-		IConstShaderPtr shader = mDocInfo->GetShader();
-		IConstFractalFunctionPtr function = mDocInfo->GetFractalFunction();
+	if (mPreview.step > 1) {
+		XCallback2<void, XIOU<STilesResult>&, MilliSecond> function(this, &CRenderer::DoPreviewThread);
+		(void) this->DoRunThreads(function, stopTime);
+		
+		this->DoNextPreviewPhase();
+		
+		time = GetMilliSeconds();
+		percent = 0;
 
-		while (time < stopTime && !mDissolve.IsDone()) {			
-			XPoint nextRay = mDissolve.GetPoint();
+	} else if (!this->DoIsCastingDone()) {
+		if (this->DoUseTiles()) {
+			XCallback2<void, XIOU<STilesResult>&, MilliSecond> function(this, &CRenderer::DoRenderTilesThread);
+			mCount += this->DoRunThreads(function, stopTime);
 			
-			X3DVector eyeRay = this->DoNeighborhoodCast(function, nextRay.x, nextRay.y);		
-			this->DoRender(shader, nextRay.x, nextRay.y, -eyeRay);
-						
-			mDissolve.FindNext();
-			++mCount;
-
 			time = GetMilliSeconds();
-		}
 		
-		percent = (int32) (100.0*mCount/mResolution.GetSize().GetArea());	// use float since int32 can overflow for big images
-
-	} else if (mAntiAliaser.enabled && mAntiAliaser.pt.y < mResolution.height) {		
-		IConstCameraPtr oldCamera(mDocInfo);
+		} else {
+			IConstShaderPtr shader = mDocInfo->GetShader();
+			IConstFractalFunctionPtr function = mDocInfo->GetFractalFunction();
 
-		if (!mAntiAliaser.doc) {
-			mAntiAliaser.doc = IDocInfoPtr(L"AntiAliaser");	
-			mAntiAliaser.doc->Reset(mDocInfo);
-			
-			SCameraRange range;
-			range.hither = 0.0f;
-			range.yon    = oldCamera->GetRange().yon - oldCamera->GetRange().hither;
-
-			ICameraPtr camera(mAntiAliaser.doc);
-			camera->SetRange(range, false);
-
-			IOrthographicCameraPtr ortho(mAntiAliaser.doc);
-			ortho->SetViewSize(X2DSize(2.0f*mWidthStep, 2.0f*mHeightStep), false);
-			
-			SResolution resolution;
-			resolution.width  = kSuperSampleSize;
-			resolution.height = kSuperSampleSize;
-			resolution.depth  = mDocInfo->GetResolution().depth;
-			mAntiAliaser.doc->SetResolution(resolution, false);
+			XPoint rays[kDissolveBatch];
+			X3DVector eyeRays[kDissolveBatch];
+			X3DVector normals[kDissolveBatch];
 			
-			mAntiAliaser.camera = ICameraPtr(mAntiAliaser.doc);		// don't want to do queries in time critical code...
-			mAntiAliaser.renderer = IRendererPtr(mAntiAliaser.doc);
-			mAntiAliaser.renderer->Reset(mAntiAliaser.doc);
-		}			
-
-		const XPixMap* image = mAntiAliaser.renderer->GetImage();
-		XLocker lock1(image);
-		XLocker lock2(mImage);
-	
-		SCameraPlacement placement = oldCamera->GetPlacement();
+			while (time < stopTime && !mDissolve.IsDone()) {			
+				int32 count = 0;
+				while (count < kDissolveBatch && !mDissolve.IsDone()) {
+					rays[count] = mDissolve.GetPoint();
+					eyeRays[count] = this->DoNeighborhoodCast(function, rays[count].x, rays[count].y);		
+					
+					mDissolve.FindNext();
+					++count;
+				}
+				MilliSecond castTime = GetMilliSeconds();
 				
-		while (time < stopTime && mAntiAliaser.pt.y < mResolution.height) {	
-			if (this->DoIsEdgePixel(mAntiAliaser.pt.x, mAntiAliaser.pt.y)) {	
-
-				X2DPoint pixel(mAntiAliaser.pt.x*mWidthStep, mAntiAliaser.pt.y*mHeightStep);
-				placement.location = oldCamera->GetHitherPoint(pixel);
-				mAntiAliaser.camera->SetPlacement(placement, false, false);			
+				for (int32 i = 0; i < count; ++i)
+					normals[i] = this->DoGetNormal(*mDepths, rays[i].x, rays[i].y, -eyeRays[i]);
+				MilliSecond normalTime = GetMilliSeconds();
 				
-				mAntiAliaser.renderer->Reset();
-				while (!mAntiAliaser.renderer->IsDone())
-					mAntiAliaser.renderer->Render(1000);
-					
-				XRGBColor color = this->DoFilter(image);
-				int32 value = mImage->ColorToPixel(color.GetOSColor());
-				mImage->SetPixelAt(mAntiAliaser.pt.x, mAntiAliaser.pt.y, value);
-			}
-						
-			mAntiAliaser.pt.x++;
-			if (mAntiAliaser.pt.x >= mResolution.width) {
-				mAntiAliaser.pt.x = 0;
-				mAntiAliaser.pt.y++;
+				for (int32 i = 0; i < count; ++i)
+					this->DoRender(shader, *mColorExpr, normals[i], *mDepths, rays[i].x, rays[i].y, -eyeRays[i]);
+				mCount += count;
+
+				MilliSecond now = GetMilliSeconds();
+				mTimes.rayCasting += castTime - time;
+				mTimes.normals    += normalTime - castTime;
+				mTimes.shading    += now - normalTime;
+				time = now;
 			}
-
-			time = GetMilliSeconds();
 		}
 		
-		percent = (int32) (100.0*mAntiAliaser.pt.y/mResolution.height);	
+		percent = (int32) (100.0*mCount/mResolution.GetSize().GetArea());	// use float since int32 can overflow for big images
+
+	} else if (mAntiAliaser.enabled && mAntiAliaser.nextRow < mResolution.height) {		
+		XCallback2<void, XIOU<STilesResult>&, MilliSecond> function(this, &CRenderer::DoAntiAliasThread);
+		(void) this->DoRunThreads(function, stopTime);
+		
+		time = GetMilliSeconds();
+		percent = (int32) (100.0*Min((int32) mAntiAliaser.nextRow, mResolution.height)/mResolution.height);	
 
 	} else {
 		percent = 100;
@@ -513,6 +804,19 @@ void CRenderer::OnLoaded()
 	mDocInfo = IDocInfoPtr(doc);  
 	mCamera = ICameraPtr(doc);  
 	mAntiAliaser.enabled = true;
+	
+	XPreference<int32> threads(L"Render Threads", 0);
+	mThreadCount = *threads > 0 ? *threads : (int32) XSystemInfo::GetProcessorCount();
+	
+	XPreference<bool> estimate(L"Distance Estimation", false);
+	XPreference<bool> packets(L"Packet Rays", false);
+	if (*estimate)
+		mKernel = kEstimateKernel;
+	else
+		mKernel = *packets ? kPacketKernel : kScalarKernel;
+	
+	XPreference<bool> progressive(L"Progressive Render", false);
+	mPreview.enabled = *progressive;
 	   
 	IDocument::Callback callback(this, &CRenderer::DoReset);
 	doc->AddCallback(callback);
@@ -553,14 +857,77 @@ void CRenderer::OnOrphaned()
 #pragma mark ~
 #endif
 
+//---------------------------------------------------------------
+//
+// CRenderer::SRayKey::SameMarch
+//
+// Returns true if a ray starting at a given hither point will hit
+// the same depth for both keys.
+//
+//---------------------------------------------------------------
+bool CRenderer::SRayKey::SameMarch(const SRayKey& rhs) const
+{
+	bool same = function == rhs.function && fractal == rhs.fractal && pixelDepth == rhs.pixelDepth && viewDepth == rhs.viewDepth;
+	
+	if (same)
+		same = orthographic && rhs.orthographic && zAxis == rhs.zAxis;
+	
+	return same;
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::SRayKey::SameRays
+//
+// Returns true if every pixel has the same depth for both keys.
+//
+//---------------------------------------------------------------
+bool CRenderer::SRayKey::SameRays(const SRayKey& rhs) const
+{
+	bool same = this->SameMarch(rhs);
+	
+	if (same)
+		same = size == rhs.size && origin == rhs.origin && hStep == rhs.hStep && vStep == rhs.vStep;
+	
+	return same;
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
 //---------------------------------------------------------------
 //
 // CRenderer::DoReset
 //
+// The depths take almost all of the time so we try to hang onto
+// them. If only the shading inputs (the shader info, lights, 
+// palette, or color formula) changed every depth is still valid
+// and the render becomes a quick reshading pass. If the camera
+// was panned or zoomed the old depths are used for the pixels
+// whose rays match old rays (see DoCreateSeeds). Otherwise we
+// have to start from scratch (although if reprojection is enabled
+// the old depths can still tell us where to start marching, see
+// DoCreateBounds).
+//
 //---------------------------------------------------------------
 void CRenderer::DoReset(const SDocumentMessage& message)
 {
 	if (message.change == kChangedDocument) {
+		SRayKey oldKey = mRayKey;
+		XAutoPtr<XArray<float> > oldDepths;
+		if (mDepths != nil) {
+			oldDepths.Reset(new XArray<float>(*mDepths));
+			
+			if (mSeeds != nil) {						// if the last render didn't finish there may be seeds that haven't been used yet
+				for (int32 v = 0; v < oldDepths->GetHeight(); ++v)
+					for (int32 h = 0; h < oldDepths->GetWidth(); ++h)
+						if (oldDepths->Get(h, v) == kNotComputed)
+							oldDepths->Set(h, v, mSeeds->Get(h, v));
+			}
+		}
+
 		const SResolution& resolution = mDocInfo->GetResolution();
 
 		XPreference<bool> useMillions(L"Use Millions of Colors", true);
@@ -576,111 +943,940 @@ void CRenderer::DoReset(const SDocumentMessage& message)
 		mFractalInfo = mDocInfo->GetFractalInfo();
 		mPalette = mDocInfo->GetPalette();
 		
-		mImage->Erase(0);
+		mRayKey = this->DoGetRayKey();
+		
+		delete mSeeds;
+		delete mBounds;
+		mSeeds = nil;
+		mBounds = nil;
+		
+		bool reshading = oldDepths.Get() != nil && mRayKey.SameRays(oldKey);
+		if (reshading)
+			mSeeds = oldDepths.Release();				// only the shading changed so we can leave the old image up while we reshade
+			
+		else {
+			if (oldDepths.Get() != nil) {
+				mSeeds = this->DoCreateSeeds(oldKey, *oldDepths);
+				if (mReproject)
+					mBounds = this->DoCreateBounds(oldKey, *oldDepths);
+			}
+			mImage->Erase(0);
+		}
+		
 		mDepths->Set(kNotComputed);
+		this->DoResetAntiAliaser(reshading);
+		this->DoResetPreview(reshading);
 		
 		mDissolve.Reset();
 		mCount = 0;
 		mElapsedTime = 0;
+		mTimes = SRenderTimes();
+		mNextTile = 0;
 	}
 }
 
-#include <XOptimize.h>	
 
 //---------------------------------------------------------------
 //
-// CRenderer::DoNeighborhoodCast
+// CRenderer::DoIsCastingDone
 //
 //---------------------------------------------------------------
-X3DVector CRenderer::DoNeighborhoodCast(const IConstFractalFunctionPtr& function, int32 h, int32 v)
-{	
-	if (h > 0 && mDepths->Get(h - 1, v) == kNotComputed) 
-		(void) this->DoRayCast(function, h - 1, v);			// do these so we can compute the normal at (h, v)
-	
-	if (h + 1 < mResolution.width && mDepths->Get(h + 1, v) == kNotComputed) 
-		(void) this->DoRayCast(function, h + 1, v);
-	
-	if (v > 0 && mDepths->Get(h, v - 1) == kNotComputed) 
-		(void) this->DoRayCast(function, h, v - 1);
+bool CRenderer::DoIsCastingDone() const
+{
+	bool done;
 	
-	if (v + 1 < mResolution.height && mDepths->Get(h, v + 1) == kNotComputed) 
-		(void) this->DoRayCast(function, h, v + 1);
-
-	X3DVector eyeRay = this->DoRayCast(function, h, v);
+	if (mPreview.step > 1)
+		done = false;
+	else if (this->DoUseTiles())
+		done = mNextTile >= mTilesWide*mTilesHigh;
+	else
+		done = mDissolve.IsDone();
 	
-	return eyeRay;
+	return done;
 }
 
 
 //---------------------------------------------------------------
 //
-// CRenderer::DoRayCast
+// CRenderer::DoResetAntiAliaser
+//
+// Casting the super-sampled rays for the edge pixels is the slow
+// part of anti-aliasing so when we're only reshading we keep the
+// sample depths from the last pass (the edge pixels and the rays
+// through them are the same).
 //
 //---------------------------------------------------------------
-X3DVector CRenderer::DoRayCast(const IConstFractalFunctionPtr& function, int32 h, int32 v)
+void CRenderer::DoResetAntiAliaser(bool reshading)
 {
-	X2DPoint pixel(h*mWidthStep, v*mHeightStep);
-			
-	X3DPoint hitherPt = mCamera->GetHitherPoint(pixel);
-	X3DVector eyeRay = mCamera->GetEyeRay(hitherPt);
+	mAntiAliaser.nextRow = 0;
+	
+	if (!reshading || mAntiAliaser.samples.size() != (uint32) mResolution.height) {
+		mAntiAliaser.samples.clear();
+		mAntiAliaser.samples.resize((uint32) mResolution.height);
+	}
+}
 
-	if (mDepths->Get(h, v) == kNotComputed) {		
-		float viewDepth = mCamera->GetRange().yon - mCamera->GetRange().hither;
 
-		float depth = function->ComputeDepth(mFractalInfo, hitherPt, eyeRay, viewDepth, mResolution.depth);
-		ASSERT(depth >= 0.0);
-		
-		mDepths->Set(h, v, depth);
-	}
+//---------------------------------------------------------------
+//
+// CRenderer::DoResetPreview
+//
+// There's no point in doing the preview passes if we're only
+// reshading (every depth is already in mSeeds). Otherwise the
+// preview depths are written into mSeeds.
+//
+//---------------------------------------------------------------
+void CRenderer::DoResetPreview(bool reshading)
+{
+	mPreview.step = mPreview.enabled && !reshading ? kMaxPreviewStep : 1;
+	mPreview.shading = false;
+	mPreview.nextRow = 0;
 	
-	return eyeRay;
+	delete mBoundedSeeds;
+	mBoundedSeeds = nil;
+	
+	if (mPreview.step > 1) {
+		if (mSeeds == nil)
+			mSeeds = new XArray<float>(mResolution.GetSize(), kNotComputed);
+		mBoundedSeeds = new XArray<bool>(mResolution.GetSize(), false);
+	}
 }
 
 
 //---------------------------------------------------------------
 //
-// CRenderer::DoRender
+// CRenderer::DoGetRayKey
 //
 //---------------------------------------------------------------
-void CRenderer::DoRender(const IConstShaderPtr& shader, int32 h, int32 v, const X3DVector& viewV)
+CRenderer::SRayKey CRenderer::DoGetRayKey() const
 {
-#if PROFILE_RENDER
-	if (mRenderProfile != nil)
-		mRenderProfile->Enable();
-#endif
+	SRayKey key;
 	
-	float depth = mDepths->Get(h, v);
-	ASSERT(depth != kNotComputed);
+	IConstOrthographicCameraPtr ortho(mCamera);
 	
-	XRGBColor color;
+	key.function     = mDocInfo->GetFractalFunction();
+	key.fractal      = mFractalInfo;
+	key.pixelDepth   = mResolution.depth;
+	key.viewDepth    = mCamera->GetRange().yon - mCamera->GetRange().hither;
+	key.orthographic = ortho.Get() != nil;
+	key.zAxis        = mCamera->GetZAxis();
+	key.origin       = mCamera->GetHitherPoint(X2DPoint(0.0f, 0.0f));
+	key.hStep        = X3DVector(mCamera->GetHitherPoint(X2DPoint(mWidthStep, 0.0f)) - key.origin);
+	key.vStep        = X3DVector(mCamera->GetHitherPoint(X2DPoint(0.0f, mHeightStep)) - key.origin);
+	key.size         = mResolution.GetSize();
+	
+	return key;
+}
 
-	if (depth != kHitYonPlane) {		
-		// Compute the normal for (h, v).
-		X3DVector normalV = this->DoComputeNormal(h, v);
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoCreateSeeds
+//
+// With an orthographic camera every ray points along the z axis
+// so, if the rays are marched the same way, a new pixel has the
+// same depth as an old pixel if their hither points match. This
+// happens for most of the pixels when the camera pans by whole
+// pixels and for some of the pixels when the camera zooms (eg
+// every other row and column when zooming in by two). Returns
+// nil if none of the old depths can be used.
+//
+//---------------------------------------------------------------
+XArray<float>* CRenderer::DoCreateSeeds(const SRayKey& oldKey, const XArray<float>& oldDepths) const
+{
+	XArray<float>* seeds = nil;
+	
+	if (mRayKey.SameMarch(oldKey) && oldKey.size == oldDepths.GetSize()) {
+		const double kTolerance = 1.0e-3;				// fraction of an old pixel
 		
-		if (normalV == kZero3DVector)			// if none of the neighbors are in the set we'll use a normal that points away from the eye
-			normalV = -viewV;
+		double hLength = oldKey.hStep.LengthSquared();
+		double vLength = oldKey.vStep.LengthSquared();
+		double zLength = sqrt(Min(hLength, vLength));	// zAxis is a unit vector so this scales z to pixels
+		
+		X3DVector delta(mRayKey.origin - oldKey.origin);
+		
+		XAutoPtr<XArray<float> > temp(new XArray<float>(mRayKey.size, kNotComputed));
+		int32 count = 0;
+		
+		for (int32 v = 0; v < mRayKey.size.height; ++v) {
+			for (int32 h = 0; h < mRayKey.size.width; ++h) {
+				X3DVector offset = delta + h*mRayKey.hStep + v*mRayKey.vStep;
+				
+				double x = DotProduct(offset, oldKey.hStep)/hLength;
+				double y = DotProduct(offset, oldKey.vStep)/vLength;
+				double z = DotProduct(offset, oldKey.zAxis)/zLength;
+				
+				int32 oldH = (int32) floor(x + 0.5);
+				int32 oldV = (int32) floor(y + 0.5);
+				
+				if (oldH >= 0 && oldH < oldKey.size.width && oldV >= 0 && oldV < oldKey.size.height)
+					if (Abs(x - oldH) < kTolerance && Abs(y - oldV) < kTolerance && Abs(z) < kTolerance) {
+						float depth = oldDepths.Get(oldH, oldV);
+						if (depth != kNotComputed) {
+							temp->Set(h, v, depth);
+							++count;
+						}
+					}
+			}
+		}
+		
+		if (count > 0)
+			seeds = temp.Release();
+	}
+	
+	return seeds;
+}
 
-		normalV = Normalize(normalV);
 
-		// Compute the color at (h, v).
-		XRGBColor diffuseColor = this->DoGetDiffuseColor(h, v);
+//---------------------------------------------------------------
+//
+// CRenderer::DoCreateBounds
+//
+// Used when rendering animations. Each old depth is turned into a
+// point on the fractal which is projected into the new view. If the
+// camera (and the fractal) only changed a little the surface seen 
+// through a new pixel will be near the points that landed around 
+// the pixel so the smallest of their depths (backed off by the depth 
+// change a surface of slope kMaxBoundSlope could have across the 
+// neighborhood) is used as the starting point for the pixel's march.
+// Pixels without any nearby points get a zero bound. Like the preview
+// bounds these aren't strict bounds: a bit of the fractal that wasn't
+// visible in the last frame can be missed if it pops up in front of 
+// the old surface. Returns nil if none of the old points are visible.
+//
+//---------------------------------------------------------------
+XArray<float>* CRenderer::DoCreateBounds(const SRayKey& oldKey, const XArray<float>& oldDepths) const
+{
+	XArray<float>* bounds = nil;
+	
+	if (mRayKey.orthographic && oldKey.orthographic && mRayKey.function == oldKey.function && oldKey.size == oldDepths.GetSize()) {
+		double hLength = mRayKey.hStep.LengthSquared();
+		double vLength = mRayKey.vStep.LengthSquared();
+		
+		// Project the old points into the new view.
+		XArray<float> nearest(mRayKey.size, kHitYonPlane);
+		int32 count = 0;
+		
+		X3DVector delta(oldKey.origin - mRayKey.origin);
+		
+		for (int32 v = 0; v < oldKey.size.height; ++v) {
+			for (int32 h = 0; h < oldKey.size.width; ++h) {
+				float depth = oldDepths.Get(h, v);
+				if (InsideSet(depth)) {
+					X3DVector offset = delta + h*oldKey.hStep + v*oldKey.vStep + depth*oldKey.zAxis;
+					
+					int32 newH = (int32) floor(DotProduct(offset, mRayKey.hStep)/hLength + 0.5);
+					int32 newV = (int32) floor(DotProduct(offset, mRayKey.vStep)/vLength + 0.5);
+					float newDepth = (float) DotProduct(offset, mRayKey.zAxis);
+					
+					if (newH >= 0 && newH < mRayKey.size.width && newV >= 0 && newV < mRayKey.size.height)
+						if (newDepth < nearest.Get(newH, newV)) {
+							nearest.Set(newH, newV, newDepth);
+							++count;
+						}
+				}
+			}
+		}
+		
+		// Each pixel's bound is the nearest point around the pixel.
+		if (count > 0) {
+			double pixelSize = sqrt(Max(hLength, vLength));
+			float margin = (float) (kMaxBoundSlope*(2*kReprojectRadius + 1)*pixelSize);
+			
+			XAutoPtr<XArray<float> > temp(new XArray<float>(mRayKey.size, 0.0f));
+			
+			for (int32 v = 0; v < mRayKey.size.height; ++v) {
+				int32 top    = Max(v - kReprojectRadius, 0L);
+				int32 bottom = Min(v + kReprojectRadius + 1, mRayKey.size.height);
+				
+				for (int32 h = 0; h < mRayKey.size.width; ++h) {
+					int32 left  = Max(h - kReprojectRadius, 0L);
+					int32 right = Min(h + kReprojectRadius + 1, mRayKey.size.width);
+					
+					float depth = kHitYonPlane;
+					for (int32 y = top; y < bottom; ++y)
+						for (int32 x = left; x < right; ++x)
+							depth = Min(depth, nearest.Get(x, y));
+					
+					if (depth != kHitYonPlane)
+						temp->Set(h, v, Max(depth - margin, 0.0f));
+				}
+			}
+			
+			bounds = temp.Release();
+		}
+	}
+	
+	return bounds;
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoUseTiles
+//
+// mDissolve hands out scattered pixels one at a time so it can't
+// be used with the worker threads or with ray packets (which need
+// runs of adjacent pixels). In those cases the image is rendered
+// a tile at a time (on the main thread if there are no workers).
+// Note that the kernel, the thread count, and the fractal function
+// can only change via a Reset.
+//
+//---------------------------------------------------------------
+bool CRenderer::DoUseTiles() const
+{
+	bool tiles = mThreadCount > 1 || (mDocInfo && this->DoUsePackets(mDocInfo->GetFractalFunction()));
+	
+	return tiles;
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoRunThreads
+//
+// Calls function from mThreadCount threads (including the main
+// thread). The function should grab pieces of the image until 
+// they're all done or stopTime is reached. We always wait for the 
+// worker threads to finish so nothing touches mImage or mDepths
+// between calls to Render. Returns the sum of the counts.
+//
+//---------------------------------------------------------------
+int32 CRenderer::DoRunThreads(const XCallback2<void, XIOU<STilesResult>&, MilliSecond>& function, MilliSecond stopTime)
+{
+	PRECONDITION(mThreadCount >= 1);
+	
+	std::vector<XIOU<STilesResult> > results;				// note that we can't use the size constructor because copies of an IOU share state
+	results.reserve(numeric_cast<uint32>(mThreadCount));
+	for (int32 i = 0; i < mThreadCount; ++i)
+		results.push_back(XIOU<STilesResult>());
+	
+	for (uint32 i = 1; i < results.size(); ++i) {
+		XCallback0<void> temp = Bind2(function, results[i], stopTime);
+		XThread::ErrorHandler errors(&results[i], &XIOU<STilesResult>::Abort);
+		
+		XThread* thread = XThread::Create(temp, errors);
+		thread->Start();
+		thread->RemoveReference();
+	}
+	
+	try {
+		function(results[0], stopTime);
+		
+	} catch (const std::exception& e) {
+		results[0].Abort(&e);						// can't throw until the workers are done with mImage
+		
+	} catch (...) {
+		results[0].Abort(nil);
+	}
+	
+	bool aborted = false;
+	std::wstring errorText;
+	int32 count = 0;
+	
+	for (uint32 i = 0; i < results.size(); ++i) {
+		results[i].Wait();
+		
+		if (results[i].Redeemable()) {
+			STilesResult result = results[i].Redeem();
+			count += result.count;
+			mTimes += result.times;
+		
+		} else if (!aborted) {
+			aborted = true;
+			errorText = results[i].GetAbortText();
+		}
+	}
+	
+	if (aborted)
+		throw std::runtime_error(ToUTF8Str(errorText));
+		
+	return count;
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoRenderTilesThread
+//
+// Grabs tiles until they're all rendered or stopTime is reached.
+// Note that the interfaces used below are safe to call from
+// multiple threads, but the color evaluator isn't so each thread
+// uses its own.
+//
+//---------------------------------------------------------------
+void CRenderer::DoRenderTilesThread(XIOU<STilesResult>& result, MilliSecond stopTime)
+{
+	IConstShaderPtr shader = mDocInfo->GetShader();
+	IConstFractalFunctionPtr function = mDocInfo->GetFractalFunction();
+	CColorEvaluator expr(mDocInfo->GetShaderInfo().colorFormula);
+	
+	int32 numTiles = mTilesWide*mTilesHigh;
+	
+	STilesResult tiles;
+	tiles.count = 0;
+	
+	while (GetMilliSeconds() < stopTime) {
+		int32 index = ++mNextTile - 1;
+		if (index >= numTiles)
+			break;
+			
+		tiles.count += this->DoRenderTile(shader, function, expr, index, tiles.times);
+	}
+	
+	result.Fulfill(tiles);
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoPreviewThread
+//
+// Grabs rows of the current preview grid until they're all done
+// or stopTime is reached. The rays for every row are cast before
+// any of the rows are shaded so that the normals can use the rows
+// above and below.
+//
+//---------------------------------------------------------------
+void CRenderer::DoPreviewThread(XIOU<STilesResult>& result, MilliSecond stopTime)
+{
+	IConstShaderPtr shader = mDocInfo->GetShader();
+	IConstFractalFunctionPtr function = mDocInfo->GetFractalFunction();
+	CColorEvaluator expr(mDocInfo->GetShaderInfo().colorFormula);
+	
+	int32 step = mPreview.step;
+	int32 numRows = (mResolution.height + step - 1)/step;
+	
+	STilesResult rows;
+	rows.count = 0;
+	
+	MilliSecond time = GetMilliSeconds();
+	while (time < stopTime) {
+		int32 row = ++mPreview.nextRow - 1;
+		if (row >= numRows)
+			break;
+		
+		if (mPreview.shading)
+			this->DoShadePreviewRow(shader, expr, row*step, step);
+		else
+			this->DoCastPreviewRow(function, row*step, step);
+		++rows.count;
+		
+		MilliSecond now = GetMilliSeconds();
+		if (mPreview.shading)
+			rows.times.shading += now - time;
+		else
+			rows.times.rayCasting += now - time;
+		time = now;
+	}
+	
+	result.Fulfill(rows);
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoNextPreviewPhase
+//
+// Called after the preview threads finish. If every row of the 
+// current grid has been processed we either start shading the grid
+// or move on to the next finer grid.
+//
+//---------------------------------------------------------------
+void CRenderer::DoNextPreviewPhase()
+{
+	PRECONDITION(mPreview.step > 1);
+	
+	int32 numRows = (mResolution.height + mPreview.step - 1)/mPreview.step;
+	
+	if (mPreview.nextRow >= numRows) {
+		if (mPreview.shading) {
+			mPreview.step /= 2;
+			mPreview.shading = false;
+			
+			if (mPreview.step == 1)
+				this->DoDiscardBoundedSeeds();
+		
+		} else
+			mPreview.shading = true;
+			
+		mPreview.nextRow = 0;
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoDiscardBoundedSeeds
+//
+// Called when the previews are done. The preview depths that were
+// marched from one of DoGetLowerBound's heuristic bounds may have
+// skipped over part of the fractal so they're cast again (from the
+// hither plane) by the full resolution pass.
+//
+//---------------------------------------------------------------
+void CRenderer::DoDiscardBoundedSeeds()
+{
+	PRECONDITION(mSeeds != nil);
+	PRECONDITION(mBoundedSeeds != nil);
+	
+	for (int32 v = 0; v < mResolution.height; ++v)
+		for (int32 h = 0; h < mResolution.width; ++h)
+			if (mBoundedSeeds->Get(h, v))
+				mSeeds->Set(h, v, kNotComputed);
+				
+	delete mBoundedSeeds;
+	mBoundedSeeds = nil;
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoCastPreviewRow
+//
+// Computes the depths for every step'th pixel in row v. The depths
+// are stored in mSeeds so the later passes will reuse them (the
+// pixels that were computed by the coarser grid are skipped by
+// DoRayCastPacket). Depths that started from a lower bound are
+// flagged in mBoundedSeeds.
+//
+//---------------------------------------------------------------
+void CRenderer::DoCastPreviewRow(const IConstFractalFunctionPtr& function, int32 v, int32 step)
+{
+	PRECONDITION(mSeeds != nil);
+	PRECONDITION(v % step == 0);
+	
+	int32 count = (mResolution.width + step - 1)/step;
+	
+	if (this->DoUsePackets(function)) {
+		for (int32 i = 0; i < count; i += kRayPacketSize)
+			this->DoRayCastPacket(function, *mSeeds, i*step, v, step, Min((uint32) (count - i), kRayPacketSize));
+			
+	} else {
+		for (int32 i = 0; i < count; ++i)
+			(void) this->DoRayCast(function, *mSeeds, i*step, v);
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoShadePreviewRow
+//
+// Shades every step'th pixel in row v using normals computed from 
+// the neighboring grid points and fills in a step x step block of
+// the image with the color.
+//
+//---------------------------------------------------------------
+void CRenderer::DoShadePreviewRow(const IConstShaderPtr& shader, CColorEvaluator& expr, int32 v, int32 step)
+{
+	PRECONDITION(mSeeds != nil);
+	PRECONDITION(v % step == 0);
+	
+	const XArray<float>& depths = *mSeeds;
+	
+	std::vector<X3DPoint> inside;
+	std::vector<double> colorIndexes;
+	inside.reserve(numeric_cast<uint32>(mResolution.width/step + 1));
+	
+	for (int32 h = 0; h < mResolution.width; h += step) {
+		if (InsideSet(depths(h, v)))
+			inside.push_back(this->DoGetPoint(depths, h, v));
+	}
+	
+	colorIndexes.resize(inside.size());
+	if (!inside.empty())
+		expr.Evaluate(&inside[0], (uint32) inside.size(), &colorIndexes[0]);		// it's a lot faster to evaluate the color formula for the whole row at once
+	
+	std::vector<XRGBColor> colors((uint32) mResolution.width);
+	
+	uint32 index = 0;
+	for (int32 h = 0; h < mResolution.width; h += step) {
+		XRGBColor color = kRGBBlack;
+		
+		if (InsideSet(depths(h, v))) {
+			const X3DPoint& pt = inside[index];
+			
+			X3DPoint left, top, right, bottom;
+			bool hasLeft   = h - step >= 0 && InsideSet(depths(h - step, v));
+			bool hasRight  = h + step < mResolution.width && InsideSet(depths(h + step, v));
+			bool hasTop    = v - step >= 0 && InsideSet(depths(h, v - step));
+			bool hasBottom = v + step < mResolution.height && InsideSet(depths(h, v + step));
+			
+			if (hasLeft)
+				left = this->DoGetPoint(depths, h - step, v);
+			if (hasRight)
+				right = this->DoGetPoint(depths, h + step, v);
+			if (hasTop)
+				top = this->DoGetPoint(depths, h, v - step);
+			if (hasBottom)
+				bottom = this->DoGetPoint(depths, h, v + step);
+			
+			X2DPoint pixel(h*mWidthStep, v*mHeightStep);
+			X3DVector viewV = -mCamera->GetEyeRay(mCamera->GetHitherPoint(pixel));
+			
+			X3DVector normalV = ComputeNormal(pt, hasLeft ? &left : nil, hasTop ? &top : nil, hasRight ? &right : nil, hasBottom ? &bottom : nil);
+			if (normalV == kZero3DVector)
+				normalV = -viewV;
+			normalV = Normalize(normalV);
+			
+			XRGBColor diffuseColor = this->DoGetDiffuseColor(colorIndexes[index++]);
+			
+			XRGBColor shaderColor = shader->GetColor(IConstDocInfoPtr(mDocInfo), diffuseColor, pt, normalV, viewV);
+			color = Normalize(shaderColor);
+		}
+		
+		int32 right = Min(h + step, mResolution.width);
+		for (int32 x = h; x < right; ++x)
+			colors[(uint32) x] = color;
+	}
+	
+	int32 bottom = Min(v + step, mResolution.height);
+	for (int32 y = v; y < bottom; ++y)
+		mImage->SetColorsAt(0, y, &colors[0], (uint32) mResolution.width);
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoGetLowerBound
+//
+// Returns a depth that the ray for (h, v) can start marching from.
+// During the preview passes, if the four corners of the next coarser
+// preview grid cell that contains (h, v) all hit the fractal then
+// it's very likely that the ray through (h, v) will hit the fractal
+// near them. This isn't a true bound (a spike could poke up between
+// the grid points) so we back off by the depth change a surface of
+// slope kMaxBoundSlope could have across the cell, and the full
+// resolution pass doesn't use it at all (see DoDiscardBoundedSeeds).
+// If there are bounds reprojected from the last render the larger
+// bound is used. Returns zero if there is no bound.
+//
+//---------------------------------------------------------------
+float CRenderer::DoGetLowerBound(int32 h, int32 v) const
+{
+	float bound = 0.0f;
+	
+	int32 grid = 2*mPreview.step;
+	if (mPreview.step > 1 && grid <= kMaxPreviewStep && mSeeds != nil) {
+		int32 left = h - h % grid;
+		int32 top  = v - v % grid;
+		int32 right  = left + grid < mResolution.width ? left + grid : left;
+		int32 bottom = top + grid < mResolution.height ? top + grid : top;
+		
+		float d1 = mSeeds->Get(left, top);
+		float d2 = mSeeds->Get(right, top);
+		float d3 = mSeeds->Get(left, bottom);
+		float d4 = mSeeds->Get(right, bottom);
+		if (InsideSet(d1) && InsideSet(d2) && InsideSet(d3) && InsideSet(d4)) {	// Min would drop corners that hit the yon plane
+			float depth = Min(Min(d1, d2), Min(d3, d4));
+			float cellSize = (float) (grid*sqrt(Max(mRayKey.hStep.LengthSquared(), mRayKey.vStep.LengthSquared())));
+			bound = Max(depth - kMaxBoundSlope*cellSize, 0.0f);
+		}
+	}
+	
+	if (mBounds != nil)
+		bound = Max(bound, mBounds->Get(h, v));
+	
+	return bound;
+}
+
+#include <XOptimize.h>	
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoRenderTile
+//
+// Renders the tile at index (tiles are numbered in row major order)
+// and returns the number of pixels that were rendered. The depths
+// are computed into a local array that includes a one pixel halo
+// around the tile so that the normals can be computed without
+// touching pixels owned by other threads. The halo pixels are also
+// computed by the neighboring tiles, but with 64x64 tiles this only
+// adds about 6% to the number of rays cast. Because a pixel's depth
+// depends only on its position and a pixel's color depends only on
+// its depth and its four neighbors' depths the image is identical
+// to the one produced by the single threaded code. The rays, normals,
+// and colors are computed in separate passes over the tile so that
+// the time spent in each phase can be added to times.
+//
+//---------------------------------------------------------------
+int32 CRenderer::DoRenderTile(const IConstShaderPtr& shader, const IConstFractalFunctionPtr& function, CColorEvaluator& expr, int32 index, SRenderTimes& times)
+{
+	PRECONDITION(index >= 0 && index < mTilesWide*mTilesHigh);
+	
+	int32 left = (index % mTilesWide)*kTileSize;
+	int32 top  = (index/mTilesWide)*kTileSize;
+	XRect tile(left, top, Min(left + kTileSize, mResolution.width), Min(top + kTileSize, mResolution.height));
+	
+	XRect halo(Max(tile.left - 1, 0L), Max(tile.top - 1, 0L), Min(tile.right + 1, mResolution.width), Min(tile.bottom + 1, mResolution.height));
+	XArray<float> depths(halo, kNotComputed);
+	
+	MilliSecond startTime = GetMilliSeconds();
+	
+	bool packets = this->DoUsePackets(function);
+	for (int32 v = halo.top; v < halo.bottom; ++v) {
+		bool outsideV = v < tile.top || v >= tile.bottom;
+		
+		int32 left  = outsideV ? tile.left : halo.left;					// the normals don't use the corners
+		int32 right = outsideV ? tile.right : halo.right;
+		
+		if (packets) {
+			for (int32 h = left; h < right; h += kRayPacketSize)
+				this->DoRayCastPacket(function, depths, h, v, 1, Min((uint32) (right - h), kRayPacketSize));
+				
+		} else {
+			for (int32 h = left; h < right; ++h)				// estimated rays take different sized steps so there's no point in marching them together
+				(void) this->DoRayCast(function, depths, h, v);
+		}
+	}
+	
+	MilliSecond castTime = GetMilliSeconds();
+	
+	XArray<X3DVector> viewVs(tile, kZero3DVector);
+	XArray<X3DVector> normals(tile, kZero3DVector);
+	
+	for (int32 v = tile.top; v < tile.bottom; ++v) {
+		for (int32 h = tile.left; h < tile.right; ++h) {
+			X3DVector viewV = -this->DoRayCast(function, depths, h, v);		// the depth has already been computed so this just returns the eye ray
+			
+			viewVs.Set(h, v, viewV);
+			normals.Set(h, v, this->DoGetNormal(depths, h, v, viewV));
+		}
+	}
+	
+	MilliSecond normalTime = GetMilliSeconds();
+	
+	X3DPoint points[kTileSize];
+	double colorIndexes[kTileSize];
+	XRGBColor colors[kTileSize];
+	
+	for (int32 v = tile.top; v < tile.bottom; ++v) {
+		uint32 count = 0;
+		for (int32 h = tile.left; h < tile.right; ++h) {
+			if (InsideSet(depths(h, v)))
+				points[count++] = this->DoGetPoint(depths, h, v);
+		}
+		
+		expr.Evaluate(points, count, colorIndexes);					// it's a lot faster to evaluate the color formula for the whole row at once
+		
+		count = 0;
+		for (int32 h = tile.left; h < tile.right; ++h) {
+			double colorIndex = InsideSet(depths(h, v)) ? colorIndexes[count++] : 0.0;
+			colors[h - tile.left] = this->DoGetColor(shader, colorIndex, normals(h, v), depths, h, v, viewVs(h, v));
+			
+			mDepths->Set(h, v, depths(h, v));				// the anti-aliaser uses these
+		}
+		
+		mImage->SetColorsAt(tile.left, v, colors, (uint32) tile.GetWidth());
+	}
+	
+	MilliSecond stopTime = GetMilliSeconds();
+	
+	times.rayCasting += castTime - startTime;
+	times.normals    += normalTime - castTime;
+	times.shading    += stopTime - normalTime;
+	
+	return tile.GetArea();
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoUsePackets
+//
+//---------------------------------------------------------------
+bool CRenderer::DoUsePackets(const IConstFractalFunctionPtr& function) const
+{
+	bool packets = mKernel == kPacketKernel || (mKernel == kEstimateKernel && !function->HasDistanceEstimator());
+	
+	return packets;
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoNeighborhoodCast
+//
+//---------------------------------------------------------------
+X3DVector CRenderer::DoNeighborhoodCast(const IConstFractalFunctionPtr& function, int32 h, int32 v)
+{	
+	if (h > 0 && mDepths->Get(h - 1, v) == kNotComputed) 
+		(void) this->DoRayCast(function, *mDepths, h - 1, v);	// do these so we can compute the normal at (h, v)
+	
+	if (h + 1 < mResolution.width && mDepths->Get(h + 1, v) == kNotComputed) 
+		(void) this->DoRayCast(function, *mDepths, h + 1, v);
+	
+	if (v > 0 && mDepths->Get(h, v - 1) == kNotComputed) 
+		(void) this->DoRayCast(function, *mDepths, h, v - 1);
+	
+	if (v + 1 < mResolution.height && mDepths->Get(h, v + 1) == kNotComputed) 
+		(void) this->DoRayCast(function, *mDepths, h, v + 1);
+
+	X3DVector eyeRay = this->DoRayCast(function, *mDepths, h, v);
+	
+	return eyeRay;
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoRayCast
+//
+//---------------------------------------------------------------
+X3DVector CRenderer::DoRayCast(const IConstFractalFunctionPtr& function, XArray<float>& depths, int32 h, int32 v)
+{
+	X2DPoint pixel(h*mWidthStep, v*mHeightStep);
+			
+	X3DPoint hitherPt = mCamera->GetHitherPoint(pixel);
+	X3DVector eyeRay = mCamera->GetEyeRay(hitherPt);
+
+	if (depths.Get(h, v) == kNotComputed) {		
+		float depth = mSeeds != nil ? mSeeds->Get(h, v) : kNotComputed;
+		
+		if (depth == kNotComputed) {
+			float viewDepth = mCamera->GetRange().yon - mCamera->GetRange().hither;
+			
+			float delta = viewDepth/mResolution.depth;				// skip whole depth steps so we evaluate the same points
+			int32 skipped = Min((int32) (this->DoGetLowerBound(h, v)/delta), mResolution.depth - 1);
+			float offset = skipped*delta;
+			X3DPoint startPt = hitherPt + offset*eyeRay;
+			
+			if (skipped > 0 && mBoundedSeeds != nil)
+				mBoundedSeeds->Set(h, v, true);
+	
+			if (mKernel == kEstimateKernel)
+				depth = function->EstimateDepth(mFractalInfo, startPt, eyeRay, viewDepth - offset, mResolution.depth - skipped);
+			else
+				depth = function->ComputeDepth(mFractalInfo, startPt, eyeRay, viewDepth - offset, mResolution.depth - skipped);
+			
+			if (depth != kHitYonPlane)
+				depth += offset;
+		}
+		ASSERT(depth >= 0.0);
+		
+		depths.Set(h, v, depth);
+	}
+	
+	return eyeRay;
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoRayCastPacket
+//
+// Computes the depths for count pixels starting at (h, v) and
+// spaced step pixels apart. Adjacent rays tend to take the same 
+// number of steps so this lets the fractal function keep its SIMD
+// lanes busy. Pixels with seeds are skipped. The packet starts 
+// marching at the smallest of the rays' lower bounds.
+//
+//---------------------------------------------------------------
+void CRenderer::DoRayCastPacket(const IConstFractalFunctionPtr& function, XArray<float>& depths, int32 h, int32 v, int32 step, uint32 count)
+{
+	PRECONDITION(count > 0 && count <= kRayPacketSize);
+	
+	X3DPoint hitherPts[kRayPacketSize];
+	X3DVector eyeRays[kRayPacketSize];
+	float rayDepths[kRayPacketSize];
+	int32 columns[kRayPacketSize];
+	
+	uint32 rays = 0;
+	float bound = INFINITY;
+	for (uint32 i = 0; i < count; ++i) {
+		int32 column = h + step*(int32) i;
+		
+		float seed = mSeeds != nil ? mSeeds->Get(column, v) : kNotComputed;
+		if (seed != kNotComputed) {
+			depths.Set(column, v, seed);
+		
+		} else {
+			X2DPoint pixel(column*mWidthStep, v*mHeightStep);
+			
+			hitherPts[rays] = mCamera->GetHitherPoint(pixel);
+			eyeRays[rays] = mCamera->GetEyeRay(hitherPts[rays]);
+			columns[rays++] = column;
+			
+			bound = Min(bound, this->DoGetLowerBound(column, v));
+		}
+	}
+
+	if (rays > 0) {
+		float viewDepth = mCamera->GetRange().yon - mCamera->GetRange().hither;
+		
+		float delta = viewDepth/mResolution.depth;
+		int32 skipped = Min((int32) (bound/delta), mResolution.depth - 1);
+		float offset = skipped*delta;
+		for (uint32 i = 0; i < rays; ++i) {
+			hitherPts[i] += offset*eyeRays[i];
+			
+			if (skipped > 0 && mBoundedSeeds != nil)
+				mBoundedSeeds->Set(columns[i], v, true);
+		}
+			
+		function->ComputeDepths(mFractalInfo, hitherPts, eyeRays, rays, viewDepth - offset, mResolution.depth - skipped, rayDepths);
+		
+		for (uint32 i = 0; i < rays; ++i) {
+			ASSERT(rayDepths[i] >= 0.0);
+			
+			float depth = rayDepths[i] != kHitYonPlane ? rayDepths[i] + offset : kHitYonPlane;
+			depths.Set(columns[i], v, depth);
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoRender (CColorEvaluator&)
+//
+//---------------------------------------------------------------
+void CRenderer::DoRender(const IConstShaderPtr& shader, CColorEvaluator& expr, const X3DVector& normalV, const XArray<float>& depths, int32 h, int32 v, const X3DVector& viewV)
+{
+	double colorIndex = 0.0;
+	if (InsideSet(depths.Get(h, v)))
+		colorIndex = expr.Evaluate(this->DoGetPoint(depths, h, v));
+		
+	XRGBColor color = this->DoGetColor(shader, colorIndex, normalV, depths, h, v, viewV);
+	mImage->SetColorsAt(h, v, &color, 1);
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoGetColor
+//
+//---------------------------------------------------------------
+XRGBColor CRenderer::DoGetColor(const IConstShaderPtr& shader, double colorIndex, const X3DVector& normalV, const XArray<float>& depths, int32 h, int32 v, const X3DVector& viewV)
+{
+#if PROFILE_RENDER
+	if (mRenderProfile != nil)
+		mRenderProfile->Enable();
+#endif
+	
+	float depth = depths.Get(h, v);
+	ASSERT(depth != kNotComputed);
+	
+	XRGBColor color;
+
+	if (depth != kHitYonPlane) {		
+		XRGBColor diffuseColor = this->DoGetDiffuseColor(colorIndex);
 				
-		X3DPoint pt = this->DoGetPoint(h, v);
+		X3DPoint pt = this->DoGetPoint(depths, h, v);
 
 		XRGBColor shaderColor = shader->GetColor(IConstDocInfoPtr(mDocInfo), diffuseColor, pt, normalV, viewV);
 		color = Normalize(shaderColor);
 	
 	} else
 		color = kRGBBlack;
-	
-	int32 pixel = mImage->ColorToPixel(color.GetOSColor());
-	mImage->SetPixelAt((int16) h, (int16) v, pixel);
 
 #if PROFILE_RENDER
 	if (mRenderProfile != nil)
 		mRenderProfile->Disable();
 #endif
+
+	return color;
 }
 
 
@@ -689,9 +1885,9 @@ void CRenderer::DoRender(const IConstShaderPtr& shader, int32 h, int32 v, const
 // CRenderer::DoGetPoint
 //
 //---------------------------------------------------------------
-X3DPoint CRenderer::DoGetPoint(int32 h, int32 v) const
+X3DPoint CRenderer::DoGetPoint(const XArray<float>& depths, int32 h, int32 v) const
 {
-	float depth = mDepths->Get(h, v);
+	float depth = depths.Get(h, v);
 	ASSERT(InsideSet(depth));
 	
 	X2DPoint pixel(h*mWidthStep, v*mHeightStep);
@@ -703,6 +1899,34 @@ X3DPoint CRenderer::DoGetPoint(int32 h, int32 v) const
 }
 
 
+//---------------------------------------------------------------
+//
+// CRenderer::DoGetNormal
+//
+// Returns the normalized normal for (h, v) or the zero vector if
+// the ray for (h, v) didn't hit the fractal.
+//
+//---------------------------------------------------------------
+X3DVector CRenderer::DoGetNormal(const XArray<float>& depths, int32 h, int32 v, const X3DVector& viewV) const
+{
+	X3DVector normalV = kZero3DVector;
+	
+	float depth = depths.Get(h, v);
+	ASSERT(depth != kNotComputed);
+	
+	if (depth != kHitYonPlane) {		
+		normalV = this->DoComputeNormal(depths, h, v);
+		
+		if (normalV == kZero3DVector)			// if none of the neighbors are in the set we'll use a normal that points away from the eye
+			normalV = -viewV;
+
+		normalV = Normalize(normalV);
+	}
+	
+	return normalV;
+}
+
+
 //---------------------------------------------------------------
 //
 // CRenderer::DoComputeNormal
@@ -741,24 +1965,24 @@ X3DPoint CRenderer::DoGetPoint(int32 h, int32 v) const
 // $$we'll get a somewhat bogus normal.
 //
 //---------------------------------------------------------------
-X3DVector CRenderer::DoComputeNormal(int32 h, int32 v) const
+X3DVector CRenderer::DoComputeNormal(const XArray<float>& depths, int32 h, int32 v) const
 {
 	X3DVector normalV = kZero3DVector;
 
-	X3DPoint center = this->DoGetPoint(h, v);
+	X3DPoint center = this->DoGetPoint(depths, h, v);
 
 	if (h > 0 && v > 0 && h + 1 < mResolution.width && v + 1 < mResolution.height &&
-		InsideSet(mDepths->Get(h - 1, v)) && InsideSet(mDepths->Get(h, v - 1)) &&
-		InsideSet(mDepths->Get(h + 1, v)) && InsideSet(mDepths->Get(h, v + 1))) {
+		InsideSet(depths.Get(h - 1, v)) && InsideSet(depths.Get(h, v - 1)) &&
+		InsideSet(depths.Get(h + 1, v)) && InsideSet(depths.Get(h, v + 1))) {
 
 		// Typically a point on the fractal is not on the edge of
 		// the window and is surrounded by other points on the
 		// fractal so we can compute the normal with the optimized
 		// code below.
-		X3DPoint left   = this->DoGetPoint(h - 1, v);
-		X3DPoint right  = this->DoGetPoint(h + 1, v);
-		X3DPoint top    = this->DoGetPoint(h, v - 1);
-		X3DPoint bottom = this->DoGetPoint(h, v + 1);
+		X3DPoint left   = this->DoGetPoint(depths, h - 1, v);
+		X3DPoint right  = this->DoGetPoint(depths, h + 1, v);
+		X3DPoint top    = this->DoGetPoint(depths, h, v - 1);
+		X3DPoint bottom = this->DoGetPoint(depths, h, v + 1);
 
 		double lx = left.x - center.x;
 		double ly = left.y - center.y;
@@ -805,20 +2029,20 @@ X3DVector CRenderer::DoComputeNormal(int32 h, int32 v) const
 		X3DVector normal4 = kZero3DVector;
 		
 		if (h > 0 && v > 0) 
-			if (InsideSet(mDepths->Get(h - 1, v)) && InsideSet(mDepths->Get(h, v - 1)))
-				normal1 = CrossProduct(X3DVector(this->DoGetPoint(h - 1, v) - center), X3DVector(center - this->DoGetPoint(h, v - 1)));
+			if (InsideSet(depths.Get(h - 1, v)) && InsideSet(depths.Get(h, v - 1)))
+				normal1 = CrossProduct(X3DVector(this->DoGetPoint(depths, h - 1, v) - center), X3DVector(center - this->DoGetPoint(depths, h, v - 1)));
 		
 		if (h + 1 < mResolution.width && v > 0) 
-			if (InsideSet(mDepths->Get(h + 1, v)) && InsideSet(mDepths->Get(h, v - 1)))
-				normal2 = CrossProduct(X3DVector(center - this->DoGetPoint(h + 1, v)), X3DVector(this->DoGetPoint(h, v - 1) - center));
+			if (InsideSet(depths.Get(h + 1, v)) && InsideSet(depths.Get(h, v - 1)))
+				normal2 = CrossProduct(X3DVector(center - this->DoGetPoint(depths, h + 1, v)), X3DVector(this->DoGetPoint(depths, h, v - 1) - center));
 		
 		if (h + 1 < mResolution.width && v + 1 < mResolution.height) 
-			if (InsideSet(mDepths->Get(h + 1, v)) && InsideSet(mDepths->Get(h, v + 1)))
-				normal3 = CrossProduct(X3DVector(this->DoGetPoint(h + 1, v) - center), X3DVector(center - this->DoGetPoint(h, v + 1)));
+			if (InsideSet(depths.Get(h + 1, v)) && InsideSet(depths.Get(h, v + 1)))
+				normal3 = CrossProduct(X3DVector(this->DoGetPoint(depths, h + 1, v) - center), X3DVector(center - this->DoGetPoint(depths, h, v + 1)));
 		
 		if (h > 0 && v + 1 < mResolution.height) 
-			if (InsideSet(mDepths->Get(h - 1, v)) && InsideSet(mDepths->Get(h, v + 1)))
-				normal4 = CrossProduct(X3DVector(center - this->DoGetPoint(h - 1, v)), X3DVector(this->DoGetPoint(h, v + 1) - center));
+			if (InsideSet(depths.Get(h - 1, v)) && InsideSet(depths.Get(h, v + 1)))
+				normal4 = CrossProduct(X3DVector(center - this->DoGetPoint(depths, h - 1, v)), X3DVector(this->DoGetPoint(depths, h, v + 1) - center));
 		
 		// The normal at (h, v) is then the average of the four surrounding
 		// normals (we don't divide by the number of normals because the
@@ -835,12 +2059,8 @@ X3DVector CRenderer::DoComputeNormal(int32 h, int32 v) const
 // CRenderer::DoGetDiffuseColor		
 //
 //---------------------------------------------------------------
-XRGBColor CRenderer::DoGetDiffuseColor(int32 h, int32 v) const
+XRGBColor CRenderer::DoGetDiffuseColor(double index) const
 {	
-	X3DPoint pt = this->DoGetPoint(h, v);
-	
-	double index = mColorExpr->Evaluate(pt);
-	
 	index = fmod(index, 1.0);
 	if (index < 0.0)
 		index += 1.0;
@@ -857,6 +2077,192 @@ XRGBColor CRenderer::DoGetDiffuseColor(int32 h, int32 v) const
 }
 
 
+//---------------------------------------------------------------
+//
+// CRenderer::DoAntiAliasThread
+//
+// Grabs rows until they're all anti-aliased or stopTime is reached.
+// Only the edge pixels (and the sample depths) for a row are changed
+// and the depths aren't touched so the threads don't step on each other.
+//
+//---------------------------------------------------------------
+void CRenderer::DoAntiAliasThread(XIOU<STilesResult>& result, MilliSecond stopTime)
+{
+	IConstShaderPtr shader = mDocInfo->GetShader();
+	IConstFractalFunctionPtr function = mDocInfo->GetFractalFunction();
+	CColorEvaluator expr(mDocInfo->GetShaderInfo().colorFormula);
+	
+	STilesResult rows;
+	rows.count = 0;
+	
+	MilliSecond time = GetMilliSeconds();
+	while (time < stopTime) {
+		int32 v = ++mAntiAliaser.nextRow - 1;
+		if (v >= mResolution.height)
+			break;
+			
+		for (int32 h = 0; h < mResolution.width; ++h) {
+			if (this->DoIsEdgePixel(h, v)) {	
+				XRGBColor color = this->DoSuperSample(shader, function, expr, h, v);
+				mImage->SetColorsAt(h, v, &color, 1);
+			}
+		}
+		
+		++rows.count;
+		
+		MilliSecond now = GetMilliSeconds();
+		rows.times.antiAliasing += now - time;
+		time = now;
+	}
+	
+	result.Fulfill(rows);
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoSuperSample
+//
+// Returns the filtered color for the edge pixel at (h, v). Most
+// edge pixels are fine with a few samples so we start with a
+// coarse grid and only switch to the fine grid if the coarse 
+// samples disagree.
+//
+//---------------------------------------------------------------
+XRGBColor CRenderer::DoSuperSample(const IConstShaderPtr& shader, const IConstFractalFunctionPtr& function, CColorEvaluator& expr, int32 h, int32 v)
+{
+	XRGBColor colors[kSuperSampleSize*kSuperSampleSize];
+	
+	SEdgeSamples& samples = mAntiAliaser.samples[(uint32) v][h];
+	
+	int32 size = kCoarseSampleSize;
+	this->DoSampleGrid(shader, function, expr, h, v, size, samples.coarse, colors);
+	
+	if (ComputeVariance(colors, size*size) > kMaxSampleVariance) {
+		size = kSuperSampleSize;
+		this->DoSampleGrid(shader, function, expr, h, v, size, samples.fine, colors);
+	}
+	
+	XRGBColor color = this->DoFilter(colors, size);
+	
+	return color;
+}
+
+
+//---------------------------------------------------------------
+//
+// CRenderer::DoSampleGrid
+//
+// Shades a size x size grid of stratified samples spread over the 
+// filter's support (which is two pixels wide and centered on (h, v)).
+// The rays are cast directly through the fractal function. One more
+// ring of samples is cast so that we can compute normals for the 
+// samples on the edge of the grid. If depths isn't empty it holds
+// the depths from an earlier pass and the rays aren't recast.
+//
+//---------------------------------------------------------------
+void CRenderer::DoSampleGrid(const IConstShaderPtr& shader, const IConstFractalFunctionPtr& function, CColorEvaluator& expr, int32 h, int32 v, int32 size, std::vector<float>& depths, XRGBColor* colors)
+{
+	PRECONDITION(size > 0 && size <= kSuperSampleSize);
+	PRECONDITION(depths.empty() || depths.size() == (uint32) ((size + 2)*(size + 2)));
+	PRECONDITION(colors != nil);
+	
+	const int32 kMaxWidth = kSuperSampleSize + 2;
+	
+	X3DPoint hitherPts[kMaxWidth*kMaxWidth];
+	X3DVector eyeRays[kMaxWidth*kMaxWidth];
+	X3DPoint points[kMaxWidth*kMaxWidth];
+	
+	// Find the rays.
+	int32 width = size + 2;
+	int32 count = width*width;
+	double spacing = 2.0/size;
+	
+	for (int32 row = 0; row < width; ++row) {
+		double dy = (row - 0.5)*spacing - 1.0;
+		
+		for (int32 col = 0; col < width; ++col) {
+			double dx = (col - 0.5)*spacing - 1.0;
+			
+			int32 index = row*width + col;
+			X2DPoint pixel((float) ((h + dx)*mWidthStep), (float) ((v + dy)*mHeightStep));
+			
+			hitherPts[index] = mCamera->GetHitherPoint(pixel);
+			eyeRays[index] = mCamera->GetEyeRay(hitherPts[index]);
+		}
+	}
+	
+	// Cast them (unless we're reshading).
+	if (depths.empty()) {
+		float temp[kMaxWidth*kMaxWidth];
+		
+		float viewDepth = mCamera->GetRange().yon - mCamera->GetRange().hither;
+		if (this->DoUsePackets(function)) {
+			for (int32 index = 0; index < count; index += kRayPacketSize) {
+				uint32 n = Min((uint32) (count - index), kRayPacketSize);
+				function->ComputeDepths(mFractalInfo, hitherPts + index, eyeRays + index, n, viewDepth, mResolution.depth, temp + index);
+			}
+			
+		} else {
+			for (int32 index = 0; index < count; ++index) {
+				if (mKernel == kEstimateKernel)
+					temp[index] = function->EstimateDepth(mFractalInfo, hitherPts[index], eyeRays[index], viewDepth, mResolution.depth);
+				else
+					temp[index] = function->ComputeDepth(mFractalInfo, hitherPts[index], eyeRays[index], viewDepth, mResolution.depth);
+			}
+		}
+		
+		depths.assign(temp, temp + count);
+	}
+	
+	X3DVector zAxis = mCamera->GetZAxis();
+	for (int32 index = 0; index < count; ++index)
+		if (InsideSet(depths[index]))
+			points[index] = hitherPts[index] + depths[index]*zAxis;
+	
+	// Evaluate the color formula for the samples that hit the fractal.
+	X3DPoint inside[kSuperSampleSize*kSuperSampleSize];
+	double colorIndexes[kSuperSampleSize*kSuperSampleSize];
+	
+	uint32 numInside = 0;
+	for (int32 row = 1; row <= size; ++row)
+		for (int32 col = 1; col <= size; ++col)
+			if (InsideSet(depths[row*width + col]))
+				inside[numInside++] = points[row*width + col];
+	
+	expr.Evaluate(inside, numInside, colorIndexes);
+	
+	// Shade the samples.
+	numInside = 0;
+	for (int32 row = 1; row <= size; ++row) {
+		for (int32 col = 1; col <= size; ++col) {
+			int32 index = row*width + col;
+			
+			XRGBColor color = kRGBBlack;
+			if (InsideSet(depths[index])) {
+				const X3DPoint* left   = InsideSet(depths[index - 1]) ? points + index - 1 : nil;
+				const X3DPoint* right  = InsideSet(depths[index + 1]) ? points + index + 1 : nil;
+				const X3DPoint* top    = InsideSet(depths[index - width]) ? points + index - width : nil;
+				const X3DPoint* bottom = InsideSet(depths[index + width]) ? points + index + width : nil;
+				
+				X3DVector viewV = -eyeRays[index];
+				X3DVector normalV = ComputeNormal(points[index], left, top, right, bottom);
+				if (normalV == kZero3DVector)
+					normalV = -viewV;
+				normalV = Normalize(normalV);
+				
+				XRGBColor diffuseColor = this->DoGetDiffuseColor(colorIndexes[numInside++]);
+				
+				XRGBColor shaderColor = shader->GetColor(IConstDocInfoPtr(mDocInfo), diffuseColor, points[index], normalV, viewV);
+				color = Normalize(shaderColor);
+			}
+			
+			colors[(row - 1)*size + col - 1] = color;
+		}
+	}
+}
+
+
 //---------------------------------------------------------------
 //
 // CRenderer::DoIsEdgePixel	
@@ -896,28 +2302,26 @@ bool CRenderer::DoIsEdgePixel(int32 h, int32 v) const
 //
 // CRenderer::DoFilter
 //
-// Returns a color for the kSuperSampleSize x kSuperSampleSize
-// image computed during the anti-alias phase. The box filter
+// Returns a color for the size x size grid of samples computed 
+// by DoSampleGrid. The box filter
 // returns a simple average for those pixels which isn't too good
 // because the high frequency components cause aliasing. The
 // Mitchell and Netravali filter is a 2D low-passs filter so the
 // aliasing effects are less pronounced.
 //
 //---------------------------------------------------------------
-XRGBColor CRenderer::DoFilter(const XPixMap* image) const
+XRGBColor CRenderer::DoFilter(const XRGBColor* colors, int32 size) const
 {	
-	PRECONDITION(image != nil);
-	PRECONDITION(image->GetWidth() == kSuperSampleSize);
-	PRECONDITION(image->GetHeight() == kSuperSampleSize);
+	PRECONDITION(colors != nil);
+	PRECONDITION(size > 0 && size <= kSuperSampleSize);
 	
 	XRGBColor result(0.0f, 0.0f, 0.0f);
 
 #if 0
 	// Box filter
-	for (int16 row = 0; row < kSuperSampleSize; row++) {
-		for (int16 col = 0; col < kSuperSampleSize; col++) {
-			int32 value = image->GetPixelAt(col, row);
-			XRGBColor color = image->PixelToColor(value);
+	for (int32 row = 0; row < size; row++) {
+		for (int32 col = 0; col < size; col++) {
+			const XRGBColor& color = colors[row*size + col];
 			
 			result.red   += color.red;
 			result.green += color.green;
@@ -925,7 +2329,7 @@ XRGBColor CRenderer::DoFilter(const XPixMap* image) const
 		}
 	}
 
-	float volume = kSuperSampleSize*kSuperSampleSize;
+	float volume = size*size;
 	
 	result.red   /= volume;
 	result.green /= volume;
@@ -938,15 +2342,15 @@ XRGBColor CRenderer::DoFilter(const XPixMap* image) const
 	
 	double volume = 0.0; 
 	
-	double scaleFactor = 4.0/sqrt(2.0*kSuperSampleSize*kSuperSampleSize);	// so r <= 2.0
-	for (int16 row = 0; row < kSuperSampleSize; row++) {
-		double dy = row - 0.5f*kSuperSampleSize;
+	double spacing = 2.0/size;
+	double scaleFactor = sqrt(2.0);								// the samples are within a pixel of (h, v) so this makes r <= 2.0
+	for (int32 row = 0; row < size; row++) {
+		double dy = (row + 0.5)*spacing - 1.0;
 		
-		for (int16 col = 0; col < kSuperSampleSize; col++) {
-			int32 value = image->GetPixelAt(col, row);
-			XRGBColor color = image->PixelToColor(value);
+		for (int32 col = 0; col < size; col++) {
+			const XRGBColor& color = colors[row*size + col];
 			
-			double dx = col - 0.5*kSuperSampleSize;
+			double dx = (col + 0.5)*spacing - 1.0;
 			double r = sqrt(dx*dx + dy*dy);
 			r *= scaleFactor;
 			ASSERT(r <= 2.0);
@@ -975,4 +2379,312 @@ XRGBColor CRenderer::DoFilter(const XPixMap* image) const
 	return result;
 }
 
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class ZRendererTest
+// ===================================================================================
+#if DEBUG
+class ZRendererTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~ZRendererTest();
+	
+						ZRendererTest();
+						
+//-----------------------------------
+//	API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+private:
+			void 		DoTestKernels(const IDocInfoPtr& info, const IRendererPtr& renderer);
+			void 		DoTestProgressive(const IRendererPtr& renderer);
+			void 		DoTestReshade(const IDocInfoPtr& info, const IRendererPtr& renderer);
+			void 		DoTestReprojection(const IDocInfoPtr& info, const IRendererPtr& renderer);
+
+	static	XArray<float> DoRender(const IRendererPtr& renderer);
+	static	std::vector<uint32> DoGetPixels(const IRendererPtr& renderer);
+};
+
+static ZRendererTest sRendererTest;
+
+//---------------------------------------------------------------
+//
+// ZRendererTest::~ZRendererTest
+//
+//---------------------------------------------------------------
+ZRendererTest::~ZRendererTest()
+{
+}
+
+	
+//---------------------------------------------------------------
+//
+// ZRendererTest::ZRendererTest
+//
+//---------------------------------------------------------------
+ZRendererTest::ZRendererTest() : XUnitTest(L"HyperMandella", L"Renderer")
+{
+}
+
+						
+//---------------------------------------------------------------
+//
+// ZRendererTest::OnTest
+//
+// Renders the default document at a small size using a renderer
+// that isn't attached to a window.
+//
+//---------------------------------------------------------------
+void ZRendererTest::OnTest()
+{
+	IDocInfoPtr info(L"Batch Renderer");
+	
+	SResolution resolution = info->GetResolution();
+	resolution.width  = 96;
+	resolution.height = 72;
+	resolution.depth  = 128;
+	info->SetResolution(resolution, false);
+	
+	IRendererPtr renderer(info);
+	renderer->Reset(info);
+	
+	this->DoTestKernels(info, renderer);
+	this->DoTestProgressive(renderer);
+	this->DoTestReshade(info, renderer);
+	this->DoTestReprojection(info, renderer);
+
+	renderer->Reset(IDocInfoPtr());					// have to break a cycle
+}
+
+
+//---------------------------------------------------------------
+//
+// ZRendererTest::DoTestKernels
+//
+// The packet kernel marches the same points as the scalar kernel
+// so it should find the same hits and the depths should agree to
+// within 1% of a marching step (they're refined using the same
+// bisection but the packet code may round differently).
+//
+//---------------------------------------------------------------
+void ZRendererTest::DoTestKernels(const IDocInfoPtr& info, const IRendererPtr& renderer)
+{
+	ICameraPtr camera(info);
+	float viewDepth = camera->GetRange().yon - camera->GetRange().hither;
+	const float kTolerance = 0.01f*viewDepth/info->GetResolution().depth;
+	
+	const int32 threads[] = {1, 2};
+	
+	for (uint32 i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+		renderer->SetKernel(kScalarKernel);
+		renderer->SetThreadCount(threads[i]);
+		renderer->Reset();
+		XArray<float> expected = DoRender(renderer);
+		
+		renderer->SetKernel(kPacketKernel);
+		XArray<float> actual = DoRender(renderer);
+		
+		int32 hits = 0;
+		int32 mismatches = 0;
+		for (int32 v = 0; v < expected.GetHeight(); ++v) {
+			for (int32 h = 0; h < expected.GetWidth(); ++h) {
+				if (InsideSet(expected(h, v))) {
+					++hits;
+					if (!InsideSet(actual(h, v)) || Abs(actual(h, v) - expected(h, v)) > kTolerance)
+						++mismatches;
+					
+				} else if (actual(h, v) != expected(h, v))
+					++mismatches;
+			}
+		}
+		ASSERT(hits > 0);
+		ASSERT(mismatches == 0);
+	}
+	
+	renderer->SetKernel(kScalarKernel);
+}
+
+
+//---------------------------------------------------------------
+//
+// ZRendererTest::DoTestProgressive
+//
+// The preview passes shouldn't change the final depths at all.
+//
+//---------------------------------------------------------------
+void ZRendererTest::DoTestProgressive(const IRendererPtr& renderer)
+{
+	const ERayKernel kernels[] = {kScalarKernel, kPacketKernel};
+	const int32 threads[] = {1, 2};
+	
+	for (uint32 i = 0; i < sizeof(kernels)/sizeof(kernels[0]); ++i) {
+		for (uint32 j = 0; j < sizeof(threads)/sizeof(threads[0]); ++j) {
+			renderer->SetKernel(kernels[i]);
+			renderer->SetThreadCount(threads[j]);
+
+			renderer->EnableProgressive(false);
+			renderer->Reset();
+			XArray<float> expected = DoRender(renderer);
+			
+			renderer->EnableProgressive(true);
+			ASSERT(renderer->GetPreviewStep() == kMaxPreviewStep);
+			XArray<float> actual = DoRender(renderer);
+			
+			int32 hits = 0;
+			for (int32 v = 0; v < expected.GetHeight(); ++v)
+				for (int32 h = 0; h < expected.GetWidth(); ++h)
+					if (InsideSet(expected(h, v)))
+						++hits;
+			ASSERT(hits > 0);
+			
+			ASSERT(actual == expected);
+		}
+	}
+
+	renderer->EnableProgressive(false);
+}
+
+
+//---------------------------------------------------------------
+//
+// ZRendererTest::DoTestReshade
+//
+// Changing the palette shouldn't recast any rays (including the
+// anti-aliasing samples) but the image should be the same as if
+// we'd started from scratch.
+//
+//---------------------------------------------------------------
+void ZRendererTest::DoTestReshade(const IDocInfoPtr& info, const IRendererPtr& renderer)
+{
+	XColorTable oldPalette = info->GetPalette();
+	std::wstring oldName = info->GetPaletteName();
+	
+	renderer->SetThreadCount(2);
+	renderer->EnableAntiAliasing(true);
+	renderer->Reset();
+	(void) DoRender(renderer);
+	
+	XColorTable palette = oldPalette;
+	uint32 count = palette.GetSize();
+	for (uint32 index = 0; index < count; ++index)
+		palette.SetColor(index, oldPalette.GetColor(count - index - 1));
+	info->SetPalette(palette, L"Reversed");
+	
+	renderer->Reset(info);							// should be a reshade
+	ASSERT(renderer->GetPreviewStep() == 1);
+	(void) DoRender(renderer);
+	std::vector<uint32> actual = DoGetPixels(renderer);
+	
+	renderer->Reset();
+	(void) DoRender(renderer);
+	std::vector<uint32> expected = DoGetPixels(renderer);
+	
+	ASSERT(actual == expected);
+	
+	info->SetPalette(oldPalette, oldName);
+	renderer->EnableAntiAliasing(false);
+	renderer->Reset(info);
+}
+
+
+//---------------------------------------------------------------
+//
+// ZRendererTest::DoTestReprojection
+//
+// Renders a frame orbited a bit from the last frame twice: once
+// starting from the reprojected depths and once from scratch. The
+// reprojected bounds aren't strict so a few rays may skip past a
+// thin bit of the fractal, but the other rays march through the
+// same depth steps so their depths should agree to within 1% of a
+// step. No more than 1% of the pixels are allowed to differ.
+//
+//---------------------------------------------------------------
+void ZRendererTest::DoTestReprojection(const IDocInfoPtr& info, const IRendererPtr& renderer)
+{
+	ICameraPtr camera(info);
+	SCameraPlacement oldPlacement = camera->GetPlacement();
+	
+	float viewDepth = camera->GetRange().yon - camera->GetRange().hither;
+	const float kTolerance = 0.01f*viewDepth/info->GetResolution().depth;
+	
+	renderer->SetThreadCount(2);
+	renderer->EnableReprojection(true);
+	renderer->Reset();
+	(void) DoRender(renderer);
+	
+	camera->OrbitY(3.0);							// one frame of a 120 frame orbit
+	renderer->Reset(info);
+	XArray<float> coherent = DoRender(renderer);
+	
+	renderer->Reset();
+	XArray<float> independent = DoRender(renderer);
+	
+	int32 hits = 0;
+	int32 mismatches = 0;
+	for (int32 v = 0; v < independent.GetHeight(); ++v) {
+		for (int32 h = 0; h < independent.GetWidth(); ++h) {
+			if (InsideSet(independent(h, v))) {
+				++hits;
+				if (!InsideSet(coherent(h, v)) || Abs(coherent(h, v) - independent(h, v)) > kTolerance)
+					++mismatches;
+				
+			} else if (coherent(h, v) != independent(h, v))
+				++mismatches;
+		}
+	}
+	ASSERT(hits > 0);
+	ASSERT(mismatches <= independent.GetWidth()*independent.GetHeight()/100);
+	
+	camera->SetPlacement(oldPlacement);
+	renderer->EnableReprojection(false);
+	renderer->Reset(info);
+}
+
+
+//---------------------------------------------------------------
+//
+// ZRendererTest::DoRender								[static]
+//
+//---------------------------------------------------------------
+XArray<float> ZRendererTest::DoRender(const IRendererPtr& renderer)
+{
+	while (!renderer->IsDone())
+		(void) renderer->Render(1000);
+		
+	return renderer->GetDepths();
+}
+
+
+//---------------------------------------------------------------
+//
+// ZRendererTest::DoGetPixels							[static]
+//
+//---------------------------------------------------------------
+std::vector<uint32> ZRendererTest::DoGetPixels(const IRendererPtr& renderer)
+{
+	const XPixMap* image = renderer->GetImage();
+	XLocker lock(image);
+	
+	std::vector<uint32> pixels;
+	pixels.reserve((uint32) (image->GetWidth()*image->GetHeight()));
+	
+	for (int32 v = 0; v < image->GetHeight(); ++v)
+		for (int32 h = 0; h < image->GetWidth(); ++h)
+			pixels.push_back(image->GetPixelAt(h, v));
+		
+	return pixels;
+}
+#endif	// DEBUG
+
 
@@ -0,0 +1,432 @@
+/*
+ *  File:       CSequenceRenderer.cpp
+ *  Summary:   	Renders animations by interpolating between keyframes.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: CSequenceRenderer.cpp,v $
+ */
+
+#include "AppHeader.h"
+#include "CSequenceRenderer.h"
+
+#include <deque>
+
+#include <XAutoPtr.h>
+#include <XBind.h>
+#include <XFileSpec.h>
+#include <XImageExporters.h>
+#include <XIntConversions.h>
+#include <XPixMap.h>
+#include <XThread.h>
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// Slerp
+//
+// Spherical interpolation between two unit vectors.
+//
+//---------------------------------------------------------------
+static X3DVector Slerp(const X3DVector& from, const X3DVector& to, double t)
+{
+	double cosTheta = MinMax(-1.0, DotProduct(from, to), 1.0);
+	ASSERT(cosTheta > -0.9999);						// keyframes need to be less than 180 degrees apart
+
+	double theta = acos(cosTheta);
+
+	X3DVector result;
+	if (theta < 1.0e-4)
+		result = Normalize(from + t*(to - from));
+	else
+		result = (sin((1.0 - t)*theta)/sin(theta))*from + (sin(t*theta)/sin(theta))*to;
+
+	return result;
+}
+
+
+//---------------------------------------------------------------
+//
+// Interpolate (SCameraPlacement)
+//
+// The location is interpolated around the point of interest so
+// that the camera stays the same distance away when orbiting.
+//
+//---------------------------------------------------------------
+static SCameraPlacement Interpolate(const SCameraPlacement& from, const SCameraPlacement& to, double t)
+{
+	SCameraPlacement placement;
+
+	placement.pointOfInterest = from.pointOfInterest + t*X3DVector(to.pointOfInterest - from.pointOfInterest);
+
+	X3DVector fromOffset(from.location - from.pointOfInterest);
+	X3DVector toOffset(to.location - to.pointOfInterest);
+
+	double distance = fromOffset.Length() + t*(toOffset.Length() - fromOffset.Length());
+	placement.location = placement.pointOfInterest + distance*Slerp(Normalize(fromOffset), Normalize(toOffset), t);
+
+	placement.upVector = Slerp(Normalize(from.upVector), Normalize(to.upVector), t);
+
+	return placement;
+}
+
+
+//---------------------------------------------------------------
+//
+// Interpolate (SFractalInfo)
+//
+//---------------------------------------------------------------
+static SFractalInfo Interpolate(const SFractalInfo& from, const SFractalInfo& to, double t)
+{
+	SFractalInfo info;
+
+	info.w        = (float) (from.w + t*(to.w - from.w));
+	info.constant = from.constant + t*(to.constant - from.constant);
+	info.lambda   = from.lambda + t*(to.lambda - from.lambda);
+	info.bailout  = (float) (from.bailout + t*(to.bailout - from.bailout));
+	info.maxDwell = (uint32) (from.maxDwell + t*((double) to.maxDwell - from.maxDwell) + 0.5);
+
+	return info;
+}
+
+
+//---------------------------------------------------------------
+//
+// WaitFor
+//
+//---------------------------------------------------------------
+static void WaitFor(XIOU<bool>& result)
+{
+	result.Wait();
+
+	if (!result.Redeemable())
+		throw std::runtime_error(ToUTF8Str(result.GetAbortText()));
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class CSequenceRenderer
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// CSequenceRenderer::~CSequenceRenderer
+//
+//---------------------------------------------------------------
+CSequenceRenderer::~CSequenceRenderer()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// CSequenceRenderer::CSequenceRenderer
+//
+//---------------------------------------------------------------
+CSequenceRenderer::CSequenceRenderer(const IDocInfoPtr& info) : mInfo(info), mCamera(info), mRenderer(info)
+{
+	PRECONDITION(mInfo);
+	PRECONDITION(mCamera);
+	PRECONDITION(mRenderer);
+
+	mLanes.push_back(SLane(info));
+	mCoherent = true;
+}
+
+
+//---------------------------------------------------------------
+//
+// CSequenceRenderer::AddKeyframe
+//
+//---------------------------------------------------------------
+void CSequenceRenderer::AddKeyframe(const SKeyframe& key)
+{
+	PRECONDITION(mKeys.empty() || key.frame > mKeys.back().frame);
+
+	mKeys.push_back(key);
+}
+
+
+//---------------------------------------------------------------
+//
+// CSequenceRenderer::AddOrbit
+//
+//---------------------------------------------------------------
+void CSequenceRenderer::AddOrbit(uint32 numFrames)
+{
+	PRECONDITION(numFrames >= 4);
+
+	const uint32 kNumSteps = 4;						// consecutive keyframes need to be less than 180 degrees apart
+
+	SCameraPlacement oldPlacement = mCamera->GetPlacement();
+
+	SKeyframe key;
+	key.fractal = mInfo->GetFractalInfo();
+
+	for (uint32 i = 0; i <= kNumSteps; ++i) {
+		key.frame = i*numFrames/kNumSteps;
+		key.placement = mCamera->GetPlacement();
+		this->AddKeyframe(key);
+
+		mCamera->OrbitY(360.0/kNumSteps, false);
+	}
+
+	mCamera->SetPlacement(oldPlacement, true, false);
+}
+
+
+//---------------------------------------------------------------
+//
+// CSequenceRenderer::GetFrame
+//
+//---------------------------------------------------------------
+SKeyframe CSequenceRenderer::GetFrame(uint32 frame) const
+{
+	PRECONDITION(!mKeys.empty());
+
+	SKeyframe result;
+
+	if (frame <= mKeys.front().frame)
+		result = mKeys.front();
+
+	else if (frame >= mKeys.back().frame)
+		result = mKeys.back();
+
+	else {
+		uint32 i = 1;
+		while (mKeys[i].frame <= frame)
+			++i;
+
+		const SKeyframe& from = mKeys[i - 1];
+		const SKeyframe& to = mKeys[i];
+		double t = (double) (frame - from.frame)/(to.frame - from.frame);
+
+		result.placement = Interpolate(from.placement, to.placement, t);
+		result.fractal = Interpolate(from.fractal, to.fractal, t);
+	}
+
+	result.frame = frame;
+
+	return result;
+}
+
+
+//---------------------------------------------------------------
+//
+// CSequenceRenderer::EnableCoherence
+//
+//---------------------------------------------------------------
+void CSequenceRenderer::EnableCoherence(bool enable)
+{
+	mCoherent = enable;
+}
+
+
+//---------------------------------------------------------------
+//
+// CSequenceRenderer::AddLane
+//
+//---------------------------------------------------------------
+void CSequenceRenderer::AddLane(const IDocInfoPtr& info)
+{
+	PRECONDITION(info);
+	PRECONDITION(ICameraPtr(info));
+	PRECONDITION(IRendererPtr(info));
+
+	mLanes.push_back(SLane(info));
+}
+
+
+//---------------------------------------------------------------
+//
+// CSequenceRenderer::RenderFrame
+//
+//---------------------------------------------------------------
+void CSequenceRenderer::RenderFrame(uint32 frame)
+{
+	this->DoRenderFrame(mLanes[0], frame, mTimes);
+}
+
+
+//---------------------------------------------------------------
+//
+// CSequenceRenderer::Render
+//
+// Each frame starts with the previous frame's depths so a lane has
+// to render its frames in order. But the lanes don't share anything
+// so the runs are rendered at the same time (the first run on this
+// thread and the others on worker threads).
+//
+//---------------------------------------------------------------
+void CSequenceRenderer::Render(uint32 numFrames, const std::wstring& prefix)
+{
+	PRECONDITION(numFrames > 0);
+
+	uint32 numLanes = Min(numFrames, (uint32) mLanes.size());
+
+	std::vector<XIOU<SRenderTimes> > results;		// note that we can't use the size constructor because copies of an IOU share state
+	results.reserve(numLanes);
+	for (uint32 i = 0; i < numLanes; ++i)
+		results.push_back(XIOU<SRenderTimes>());
+
+	XCallback3<void, XIOU<SRenderTimes>&, SRun, std::wstring> function(this, &CSequenceRenderer::DoRenderRun);
+
+	SRun run;
+	for (uint32 i = 1; i < numLanes; ++i) {
+		run.lane  = i;
+		run.first = i*numFrames/numLanes;
+		run.last  = (i + 1)*numFrames/numLanes;
+
+		XCallback0<void> temp = Bind3(function, results[i], run, prefix);
+		XThread::ErrorHandler errors(&results[i], &XIOU<SRenderTimes>::Abort);
+
+		XThread* thread = XThread::Create(temp, errors);
+		thread->Start();
+		thread->RemoveReference();
+	}
+
+	run.lane  = 0;
+	run.first = 0;
+	run.last  = numFrames/numLanes;
+
+	try {
+		function(results[0], run, prefix);
+
+	} catch (const std::exception& e) {
+		results[0].Abort(&e);						// can't throw until the other lanes are done
+
+	} catch (...) {
+		results[0].Abort(nil);
+	}
+
+	bool aborted = false;
+	std::wstring errorText;
+
+	for (uint32 i = 0; i < results.size(); ++i) {
+		results[i].Wait();
+
+		if (results[i].Redeemable()) {
+			mTimes += results[i].Redeem();
+
+		} else if (!aborted) {
+			aborted = true;
+			errorText = results[i].GetAbortText();
+		}
+	}
+
+	if (aborted)
+		throw std::runtime_error(ToUTF8Str(errorText));
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// CSequenceRenderer::DoRenderFrame
+//
+//---------------------------------------------------------------
+void CSequenceRenderer::DoRenderFrame(const SLane& lane, uint32 frame, SRenderTimes& times) const
+{
+	SKeyframe key = this->GetFrame(frame);
+
+	lane.camera->SetPlacement(key.placement, true, false);
+	lane.info->SetFractalInfo(key.fractal, false);
+
+	lane.renderer->EnableReprojection(mCoherent);
+	lane.renderer->Reset(lane.info);
+	if (!mCoherent)
+		lane.renderer->Reset();						// drop any depths that happen to match the last frame
+
+	while (!lane.renderer->IsDone())
+		(void) lane.renderer->Render(1000);
+
+	times += lane.renderer->GetTimes();
+}
+
+
+//---------------------------------------------------------------
+//
+// CSequenceRenderer::DoRenderRun
+//
+// Renders frames [run.first, run.last) using one lane. Rendering
+// is overlapped with writing: each image is copied and handed off
+// to a thread which compresses it and writes it out.
+//
+//---------------------------------------------------------------
+void CSequenceRenderer::DoRenderRun(XIOU<SRenderTimes>& result, SRun run, std::wstring prefix)
+{
+	const uint32 kMaxPendingFrames = 2;				// limits the memory used by frames waiting to be written
+
+	const SLane& lane = mLanes[run.lane];
+	SRenderTimes times;
+
+	std::deque<XIOU<bool> > pending;
+
+	try {
+		for (uint32 frame = run.first; frame < run.last; ++frame) {
+			this->DoRenderFrame(lane, frame, times);
+
+			XAutoPtr<XPixMap> image(lane.renderer->GetImage()->Clone());
+			std::wstring path = prefix + UInt32ToStr(frame, 4, '0') + L".png";
+
+			XIOU<bool> written;
+			XCallback3<void, XIOU<bool>&, XPixMap*, std::wstring> temp(&CSequenceRenderer::DoWriteFrame);
+			XCallback0<void> function = Bind3(temp, written, image.Get(), path);
+			XThread::ErrorHandler errors(&written, &XIOU<bool>::Abort);
+
+			XThread* thread = XThread::Create(function, errors);
+			thread->Start();
+			thread->RemoveReference();
+			(void) image.Release();					// the thread owns the image now
+
+			pending.push_back(written);
+			while (pending.size() > kMaxPendingFrames) {
+				WaitFor(pending.front());
+				pending.pop_front();
+			}
+		}
+
+	} catch (...) {
+		for (uint32 i = 0; i < pending.size(); ++i)
+			pending[i].Wait();						// can't leave until the threads are done with the images
+		throw;
+	}
+
+	while (!pending.empty()) {
+		WaitFor(pending.front());
+		pending.pop_front();
+	}
+
+	result.Fulfill(times);
+}
+
+
+//---------------------------------------------------------------
+//
+// CSequenceRenderer::DoWriteFrame								[static]
+//
+//---------------------------------------------------------------
+void CSequenceRenderer::DoWriteFrame(XIOU<bool>& result, XPixMap* image, std::wstring path)
+{
+	XAutoPtr<XPixMap> deleter(image);
+
+	XPNGExporter exporter;
+	exporter.Export(XFileSpec(path), image, 'HypM', 'PNGf');
+
+	result.Fulfill(true);
+}
+
+
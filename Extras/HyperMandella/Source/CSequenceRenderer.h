@@ -0,0 +1,152 @@
+/*
+ *  File:       CSequenceRenderer.h
+ *  Summary:   	Renders animations by interpolating between keyframes.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: CSequenceRenderer.h,v $
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <XIOU.h>
+
+#include "ICamera.h"
+#include "IDocInfo.h"
+#include "IRenderer.h"
+
+using namespace Whisper;
+using namespace std;
+
+
+//-----------------------------------
+//	Types
+//
+struct SKeyframe {
+	uint32				frame;				// the frame the keyframe is shown at
+	SCameraPlacement	placement;
+	SFractalInfo		fractal;
+};
+
+
+// ===================================================================================
+//	class CSequenceRenderer
+//!		Renders animations by interpolating between keyframes.
+// ===================================================================================
+class CSequenceRenderer {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+			 			~CSequenceRenderer();
+
+						CSequenceRenderer(const IDocInfoPtr& info);
+						/**< info's boss should also have an ICamera and an IRenderer (eg the
+						"Batch Renderer" boss). The keyframes only change the camera placement
+						and the fractal info: the formula, shader, palette, lights, etc are
+						the same for every frame. */
+
+private:
+						CSequenceRenderer(const CSequenceRenderer& rhs);
+
+			CSequenceRenderer& operator=(const CSequenceRenderer& rhs);
+
+//-----------------------------------
+//	API
+//
+public:
+			void 		AddKeyframe(const SKeyframe& key);
+						/**< Keyframes must be added in increasing frame order. */
+
+			void 		AddOrbit(uint32 numFrames);
+						/**< Adds keyframes that orbit the camera once around its point of
+						interest (about the camera's y axis) using the info's current camera
+						and fractal. Frame numFrames is the same as frame zero so render
+						[0, numFrames) to get a seamless loop. */
+
+			SKeyframe 	GetFrame(uint32 frame) const;
+						/**< Interpolates between the keyframes on either side of frame.
+						The camera location is interpolated around the point of interest so
+						orbits stay circular (consecutive keyframes should be less than 180
+						degrees apart). */
+
+			void 		EnableCoherence(bool enable);
+						/**< If enabled (the default) each frame's rays start marching near
+						the surface found by the previous frame (see IRenderer::EnableReprojection).
+						If disabled every frame is rendered from scratch. */
+
+			void 		AddLane(const IDocInfoPtr& info);
+						/**< Adds another renderer for Render to use. info's boss should be a
+						copy of the info passed to the ctor (see IDocInfo::Reset) and its
+						renderer should be configured the same way (typically each lane's
+						renderer gets a share of the processors). Render splits the frames
+						into one run of consecutive frames per lane and renders the runs at
+						the same time. Coherence only applies within a run so the first frame
+						of each run is rendered from scratch. */
+
+			void 		RenderFrame(uint32 frame);
+						/**< Renders one frame into the renderer's image (the lanes aren't used). */
+
+			void 		Render(uint32 numFrames, const std::wstring& prefix);
+						/**< Renders frames [0, numFrames) and writes them out as PNG files
+						named prefix0000.png, prefix0001.png, etc. Each lane renders its run
+						of frames on its own thread and the files are written by worker
+						threads so frame n is compressed and written while frame n+1 is
+						rendered. */
+
+			IRendererPtr GetRenderer() const				{return mRenderer;}
+
+			SRenderTimes GetTimes() const					{return mTimes;}
+						/**< Returns the renderers' phase times summed over every frame
+						rendered so far. */
+
+//-----------------------------------
+//	Types
+//
+private:
+	struct SLane {
+		IDocInfoPtr		info;
+		ICameraPtr		camera;
+		IRendererPtr	renderer;
+		
+						SLane(const IDocInfoPtr& doc) : info(doc), camera(doc), renderer(doc) {}
+	};
+	
+	struct SRun {
+		uint32			lane;					// index into mLanes
+		uint32			first;					// the frames are [first, last)
+		uint32			last;
+		
+		bool			operator==(const SRun& rhs) const	{return lane == rhs.lane && first == rhs.first && last == rhs.last;}
+	};
+
+//-----------------------------------
+//	Internal API
+//
+private:
+			void 		DoRenderFrame(const SLane& lane, uint32 frame, SRenderTimes& times) const;
+			void 		DoRenderRun(XIOU<SRenderTimes>& result, SRun run, std::wstring prefix);
+	static	void 		DoWriteFrame(XIOU<bool>& result, XPixMap* image, std::wstring path);
+
+//-----------------------------------
+//	Member Data
+//
+private:
+	IDocInfoPtr				mInfo;
+	ICameraPtr				mCamera;
+	IRendererPtr			mRenderer;
+	std::vector<SLane>		mLanes;				// the first lane uses the above interfaces
+
+	std::vector<SKeyframe>	mKeys;
+	bool					mCoherent;
+	SRenderTimes			mTimes;
+};
+
+
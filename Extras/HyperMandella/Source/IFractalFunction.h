@@ -37,6 +37,12 @@ using namespace std;
 struct SFractalInfo;
 
 
+//-----------------------------------
+//	Constants
+//
+const uint32 kRayPacketSize = 4;					// max number of rays ComputeDepths can march at once
+
+
 // ===================================================================================
 //	class IFractalFunction
 //!		Interface used to iterate fractal formulas.
@@ -54,7 +60,23 @@ public:
 	virtual float 		ComputeDepth(const SFractalInfo& info, const X3DPoint& startPt, const X3DVector& eyeRay, float viewDepth, int32 depth) const = 0;
 						/**< Returns INFINITY if the fractal surface wasn't hit or the
 						distance from startPt to the surface if it was. */
-						
+
+	virtual void 		ComputeDepths(const SFractalInfo& info, const X3DPoint* startPts, const X3DVector* eyeRays, uint32 count, float viewDepth, int32 depth, float* depths) const = 0;
+						/**< Computes count (<= kRayPacketSize) depths at once. The results
+						are the same as calling ComputeDepth for each ray, but this is
+						considerably faster, especially if the rays are adjacent. */
+
+	virtual bool 		HasDistanceEstimator() const = 0;
+						/**< Returns true if EstimateDepth is able to skip over empty space. */
+
+	virtual float 		EstimateDepth(const SFractalInfo& info, const X3DPoint& startPt, const X3DVector& eyeRay, float viewDepth, int32 depth) const = 0;
+						/**< Like ComputeDepth except that a distance estimate is used to take
+						large steps when the ray is far from the fractal. Near the surface
+						the same fixed steps as ComputeDepth are used so the result is
+						normally identical (although the estimate isn't a strict bound so
+						very thin pieces of the fractal may occasionally be stepped over).
+						If HasDistanceEstimator returns false this is ComputeDepth. */
+
 	virtual std::wstring GetFormula() const = 0;
 						/**< Returns something like "q^2 + c". */
 };
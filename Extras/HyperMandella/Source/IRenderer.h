@@ -45,9 +45,32 @@ typedef XInterfacePtr<IDocInfo> IDocInfoPtr;
 namespace Whisper {
 	class XPixMap;
 	class XSize;
+	template <class T> class XArray;
 }
 
 
+//-----------------------------------
+//	Types
+//
+enum ERayKernel {
+	kPacketKernel,			// march kRayPacketSize rays at once using IFractalFunction::ComputeDepths
+	kScalarKernel,			// march one ray at a time using IFractalFunction::ComputeDepth
+	kEstimateKernel			// use IFractalFunction::EstimateDepth (falls back to packets if the function has no estimator)
+};
+
+
+struct SRenderTimes {
+	MilliSecond		rayCasting;
+	MilliSecond		normals;
+	MilliSecond		shading;				// includes the color formula
+	MilliSecond		antiAliasing;
+	
+					SRenderTimes() : rayCasting(0), normals(0), shading(0), antiAliasing(0) {}
+					
+	SRenderTimes& 	operator+=(const SRenderTimes& rhs)	{rayCasting += rhs.rayCasting; normals += rhs.normals; shading += rhs.shading; antiAliasing += rhs.antiAliasing; return *this;}
+};
+
+
 // ===================================================================================
 //	class IRenderer
 //!		Interface used to draw a fractal into a pixmap.
@@ -69,11 +92,64 @@ public:
 						/**< Call this to override the doc info resolution and pixel depth 
 						(eg if you want to draw a thumbnail). */
 
+	virtual void 		SetThreadCount(int32 count) = 0;
+						/**< If count is larger than one the image is split into tiles which
+						are rendered by count threads (the output is identical to the single
+						threaded renderer). Changing the count restarts the render. Defaults
+						to the "Render Threads" preference (or the number of processors if
+						the preference is zero). */
+
+	virtual void 		SetKernel(ERayKernel kernel) = 0;
+						/**< Changes the code used to march the rays (this restarts the render).
+						Defaults to kEstimateKernel if the "Distance Estimation" preference is
+						set, kPacketKernel if the "Packet Rays" preference is set, and
+						kScalarKernel otherwise. */
+
+	virtual void 		EnableAntiAliasing(bool enable) = 0;
+						/**< Anti-aliasing is enabled by default for renderers attached to a
+						document and disabled for renderers initialized via Reset. */
+
+	virtual void 		EnableProgressive(bool enable) = 0;
+						/**< If enabled rays are first cast for every fourth pixel, then for
+						every other pixel, and then for the remaining pixels. The coarse
+						grids are shaded and scaled up so the user gets a rough image of the
+						fractal quickly. The finer previews start marching near the surface
+						found by the coarser grid, which can miss thin features, so those
+						depths are cast again by the full resolution pass (the depths from the
+						first grid are reused). The final depths are the same as without the
+						previews. Defaults to the "Progressive Render" preference (which is off
+						by default) for renderers attached to a document and is disabled for
+						renderers initialized via Reset. */
+						
+	virtual int32 		GetPreviewStep() const = 0;
+						/**< Returns the grid spacing of the preview pass that is being rendered
+						(4 or 2). Returns 1 once the full resolution pass has started (or if
+						progressive rendering is disabled). */
+
+	virtual void 		EnableReprojection(bool enable) = 0;
+						/**< If enabled and the camera or fractal changes the old depths are
+						projected into the new view and used to start each ray's march near
+						the surface. This is a big win for animations where consecutive frames
+						are similar, but the bounds aren't strict so a bit of the fractal that
+						wasn't visible in the previous frame can occasionally be missed.
+						Disabled by default. Takes effect at the next Reset. */
+
+	virtual SRenderTimes GetTimes() const = 0;
+						/**< Returns the time spent in each phase since the render was last
+						reset. When multiple threads are used the times are summed across 
+						the threads. */
+
 	virtual const XPixMap* GetImage() const = 0;
 
+	virtual const XArray<float>& GetDepths() const = 0;
+						/**< Returns the distance along each pixel's eye ray from the hither
+						plane to the fractal. Rays that missed the fractal are +INFINITY and
+						pixels that haven't been cast yet are -INFINITY. */
+
 	virtual void 		Reset(const IDocInfoPtr& doc) = 0;
 	virtual void 		Reset() = 0;
-						/**< Used when anti-aliasing. */ 
+						/**< Used by the batch renderer (which doesn't have a document to
+						attach the renderer to). */ 
 };
 
 typedef XInterfacePtr<IRenderer> IRendererPtr;
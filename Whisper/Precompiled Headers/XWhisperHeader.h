@@ -106,6 +106,30 @@
 #define ASSERTS_THROW				0			
 #endif
 
+#ifndef WHISPER_SSE2							// set to 1 if the Intel SSE2 intrinsics in <emmintrin.h> can be used
+	#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+		#define WHISPER_SSE2		1
+	#else
+		#define WHISPER_SSE2		0
+	#endif
+#endif
+
+#ifndef WHISPER_SSSE3							// set to 1 if the SSSE3 intrinsics in <tmmintrin.h> can be used (eg pshufb)
+	#if defined(__SSSE3__) || defined(__AVX__)
+		#define WHISPER_SSSE3		1
+	#else
+		#define WHISPER_SSSE3		0
+	#endif
+#endif
+
+#ifndef WHISPER_AVX								// set to 1 if the AVX intrinsics in <immintrin.h> can be used (eg 256 bit doubles)
+	#if defined(__AVX__)
+		#define WHISPER_AVX			1
+	#else
+		#define WHISPER_AVX			0
+	#endif
+#endif
+
 #ifndef WHISPER_OPERATOR_NEW
 #if !MULTI_FRAGMENT_APP
 #define WHISPER_OPERATOR_NEW 		1
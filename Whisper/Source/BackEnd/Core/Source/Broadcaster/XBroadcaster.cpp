@@ -19,11 +19,47 @@
 #include <XWhisperHeader.h>
 #include <XBroadcaster.h>
 
+#include <vector>
+
+#include <XAtomicCounter.h>
 #include <XDebug.h>
 #include <XMiscUtils.h>
 
 namespace Whisper {
 
+
+// ===================================================================================
+//	Internal Types
+// ===================================================================================
+
+//-----------------------------------
+//	SListener
+//
+// Listener lists share these so that flagging a listener as removed
+// is seen by broadcasts using older lists.
+//
+struct XBaseBroadcasterMixin::SListener {
+	XBaseListenerMixin*	listener;
+	volatile bool		removed;
+	XAtomicCounter		refCount;				// number of lists containing the listener
+	
+						SListener(XBaseListenerMixin* l) : listener(l), removed(false)	{}
+};
+
+
+//-----------------------------------
+//	SListenerList
+//
+// Never changed after it's been installed into a broadcaster.
+//
+struct XBaseBroadcasterMixin::SListenerList {
+	XAtomicCounter			refCount;			// one for the broadcaster and one for each broadcast in progress
+	std::vector<SListener*>	listeners;
+};
+
+#if __MWERKS__
+#pragma mark -
+#endif
  
 // ===================================================================================
 //	class XBaseBroadcasterMixin
@@ -37,8 +73,6 @@ namespace Whisper {
 XBaseBroadcasterMixin::~XBaseBroadcasterMixin()
 {
 	this->RemoveAllListeners();
-	
-	delete mListeners;
 }
 
 	
@@ -51,7 +85,7 @@ XBaseBroadcasterMixin::XBaseBroadcasterMixin()
 {
 	mBroadcasterEnabled = true;
 	
-	mListeners = new std::list<XBaseListenerMixin*>;
+	mListeners = nil;
 }
 
 
@@ -62,13 +96,9 @@ XBaseBroadcasterMixin::XBaseBroadcasterMixin()
 //---------------------------------------------------------------
 XBaseBroadcasterMixin::XBaseBroadcasterMixin(const XBaseBroadcasterMixin& rhs)
 {
-	UNUSED(rhs);
-	
-	XEnterCriticalSection enter(mBroadcasterMutex);
-
 	mBroadcasterEnabled = rhs.mBroadcasterEnabled;
 	
-	mListeners = new std::list<XBaseListenerMixin*>;
+	mListeners = nil;
 }
 
 	
@@ -84,7 +114,7 @@ XBaseBroadcasterMixin& XBaseBroadcasterMixin::operator=(const XBaseBroadcasterMi
 
 		mBroadcasterEnabled = rhs.mBroadcasterEnabled;
 		
-		mListeners->erase(mListeners->begin(), mListeners->end());
+		this->RemoveAllListeners();
 	}
 	
 	return *this;
@@ -111,7 +141,7 @@ bool XBaseBroadcasterMixin::HasListeners() const
 {
 	XEnterCriticalSection enter(mBroadcasterMutex);
 
-	bool has = !mListeners->empty();
+	bool has = mListeners != nil;
 	
 	return has;
 }
@@ -126,14 +156,17 @@ void XBaseBroadcasterMixin::RemoveAllListeners()
 {
 	XEnterCriticalSection enter(mBroadcasterMutex);
 
-	std::list<XBaseListenerMixin*>::iterator iter = mListeners->begin();
-	while (iter != mListeners->end()) {
-		XBaseListenerMixin* listener = *iter++;
-	
-		listener->DoRemoveBroadcaster(this);
+	if (mListeners != nil) {
+		const std::vector<SListener*>& listeners = mListeners->listeners;
+		for (uint32 index = 0; index < listeners.size(); ++index) {
+			SListener* entry = listeners[index];
+			entry->removed = true;
+		
+			entry->listener->DoRemoveBroadcaster(this);
+		}
+		
+		this->DoSetListeners(nil);
 	}
-
-	mListeners->erase(mListeners->begin(), mListeners->end());
 }
 
 #if __MWERKS__
@@ -150,17 +183,28 @@ void XBaseBroadcasterMixin::DoAddListener(XBaseListenerMixin* listener)
 	PRECONDITION(listener != nil);
 
 	XEnterCriticalSection enter(mBroadcasterMutex);
-	PRECONDITION(std::find(mListeners->begin(), mListeners->end(), listener) == mListeners->end());
 	
-	listener->DoAddBroadcaster(this);
-
+	SListenerList* list = DoCopyListeners(mListeners, nil);
+	
 	try {
-		mListeners->push_back(listener);
+		SListener* entry = new SListener(listener);
+		++entry->refCount;
 		
+		try {
+			list->listeners.push_back(entry);
+		} catch (...) {
+			delete entry;
+			throw;
+		}
+
+		listener->DoAddBroadcaster(this);		// PRECONDITIONs that the listener hasn't already been added
+
 	} catch (...) {
-		listener->DoRemoveBroadcaster(this);
+		DoReleaseListeners(list);
 		throw;
 	}
+
+	this->DoSetListeners(list);
 }
 
 
@@ -168,16 +212,32 @@ void XBaseBroadcasterMixin::DoAddListener(XBaseListenerMixin* listener)
 //
 // XBaseBroadcasterMixin::DoRemoveListener
 //
+// The old list may still be in use by broadcasts on other threads
+// (or by a broadcast further up the stack) so the listener is
+// flagged before it's dropped.
+//
 //---------------------------------------------------------------
 void XBaseBroadcasterMixin::DoRemoveListener(XBaseListenerMixin* listener)
 {
 	PRECONDITION(listener != nil);
 
 	XEnterCriticalSection enter(mBroadcasterMutex);
-
-	PRECONDITION(std::find(mListeners->begin(), mListeners->end(), listener) != mListeners->end());
+	PRECONDITION(mListeners != nil);
+	
+	const std::vector<SListener*>& listeners = mListeners->listeners;
 	
-	mListeners->remove(listener);
+	SListener* entry = nil;
+	for (uint32 index = 0; index < listeners.size() && entry == nil; ++index)
+		if (listeners[index]->listener == listener)
+			entry = listeners[index];
+	PRECONDITION(entry != nil);
+
+	SListenerList* list = nil;
+	if (listeners.size() > 1)
+		list = DoCopyListeners(mListeners, listener);
+	
+	entry->removed = true;
+	this->DoSetListeners(list);
 	
 	listener->DoRemoveBroadcaster(this);
 }
@@ -190,17 +250,124 @@ void XBaseBroadcasterMixin::DoRemoveListener(XBaseListenerMixin* listener)
 //---------------------------------------------------------------
 void XBaseBroadcasterMixin::DoBroadcasting(const void* message) const
 {
-	if (this->IsBroadcasting()) {
-		XEnterCriticalSection enter(mBroadcasterMutex);
+	if (this->IsBroadcasting() && mListeners != nil) {
+		SListenerList* list = this->DoAcquireListeners();
+		
+		if (list != nil) {
+			try {
+				const std::vector<SListener*>& listeners = list->listeners;
+				for (uint32 index = 0; index < listeners.size(); ++index) {
+					SListener* entry = listeners[index];
+				
+					if (!entry->removed && entry->listener->IsListening())
+						this->DoBroadcast(entry->listener, message);
+				}
+				
+			} catch (...) {
+				DoReleaseListeners(list);
+				throw;
+			}
+
+			DoReleaseListeners(list);
+		}
+	}
+}
+
 
-		std::list<XBaseListenerMixin*>::const_iterator iter = mListeners->begin();
-		while (iter != mListeners->end()) {
-			XBaseListenerMixin* listener = *iter++;
+//---------------------------------------------------------------
+//
+// XBaseBroadcasterMixin::DoAcquireListeners
+//
+// Returns the current list with an extra reference (or nil). This
+// is the only time broadcasting needs the lock.
+//
+//---------------------------------------------------------------
+XBaseBroadcasterMixin::SListenerList* XBaseBroadcasterMixin::DoAcquireListeners() const
+{
+	XEnterCriticalSection enter(mBroadcasterMutex);
+
+	SListenerList* list = mListeners;
+	if (list != nil)
+		++list->refCount;
+	
+	return list;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBaseBroadcasterMixin::DoReleaseListeners					[static]
+//
+//---------------------------------------------------------------
+void XBaseBroadcasterMixin::DoReleaseListeners(SListenerList* list)
+{
+	PRECONDITION(list != nil);
+	
+	if (--list->refCount == 0) {
+		const std::vector<SListener*>& listeners = list->listeners;
+		for (uint32 index = 0; index < listeners.size(); ++index) {
+			SListener* entry = listeners[index];
+			
+			if (--entry->refCount == 0)
+				delete entry;
+		}
+		
+		delete list;
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XBaseBroadcasterMixin::DoCopyListeners						[static]
+//
+// Returns a new list (with one reference) containing everything in
+// list except for the except listener. List and except may be nil.
+//
+//---------------------------------------------------------------
+XBaseBroadcasterMixin::SListenerList* XBaseBroadcasterMixin::DoCopyListeners(const SListenerList* list, const XBaseListenerMixin* except)
+{
+	SListenerList* copy = new SListenerList;
+	++copy->refCount;
+	
+	if (list != nil) {
+		try {
+			copy->listeners.reserve(list->listeners.size() + 1);
+		} catch (...) {
+			delete copy;
+			throw;
+		}
+		
+		const std::vector<SListener*>& listeners = list->listeners;
+		for (uint32 index = 0; index < listeners.size(); ++index) {
+			SListener* entry = listeners[index];
 			
-			if (listener->IsListening())
-				this->DoBroadcast(listener, message);
+			if (entry->listener != except) {
+				++entry->refCount;
+				copy->listeners.push_back(entry);		// can't throw because of the reserve
+			}
 		}
 	}
+	
+	return copy;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBaseBroadcasterMixin::DoSetListeners
+//
+// Installs list (which may be nil) and releases the broadcaster's
+// reference to the old list. The mutex must be held.
+//
+//---------------------------------------------------------------
+void XBaseBroadcasterMixin::DoSetListeners(SListenerList* list)
+{
+	SListenerList* old = mListeners;
+	mListeners = list;
+	
+	if (old != nil)
+		DoReleaseListeners(old);
 }
 
 
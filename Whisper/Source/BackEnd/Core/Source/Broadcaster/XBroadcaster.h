@@ -42,7 +42,13 @@ namespace Whisper {
 /*!		This class allows an object to broadcast messages to one or more listeners. This 
  *		is a good idea because it reduces coupling between classes: the  broadcaster 
  *		doesn't need to know anything about its listeners. The base classes use templates 
- *		so an arbitrary amount of information can be broadcast to the listeners. */
+ *		so an arbitrary amount of information can be broadcast to the listeners.
+ *
+ *		The listeners are stored in an immutable reference counted array. Adding or removing
+ *		a listener swaps in a new array so broadcasts only hold the lock long enough to grab
+ *		the current array: listeners are called without any locks held and several threads
+ *		can broadcast at once. A listener that's removed (or deleted) while a broadcast is in
+ *		progress won't be called by that broadcast unless the call had already started. */
 // ===================================================================================
 class CORE_EXPORT XBaseBroadcasterMixin {
 
@@ -80,6 +86,13 @@ public:
 			
 			bool		HasListeners() const;
 
+//-----------------------------------
+//	Internal Types
+//
+private:
+	struct SListener;
+	struct SListenerList;
+
 //-----------------------------------
 //	Internal API
 //
@@ -92,13 +105,20 @@ protected:
 			
 	virtual void 		DoBroadcast(XBaseListenerMixin* listener, const void* message) const = 0;
 
+private:
+			SListenerList* DoAcquireListeners() const;
+	static	void 		DoReleaseListeners(SListenerList* list);
+	
+	static	SListenerList* DoCopyListeners(const SListenerList* list, const XBaseListenerMixin* except);
+			void 		DoSetListeners(SListenerList* list);
+
 //-----------------------------------
 //	Member Data
 //
 private:	
-	std::list<XBaseListenerMixin*>*	mListeners;
-	bool							mBroadcasterEnabled;
-	mutable XCriticalSection		mBroadcasterMutex;
+	SListenerList* volatile		mListeners;				// nil if there are no listeners
+	bool						mBroadcasterEnabled;
+	mutable XCriticalSection	mBroadcasterMutex;
 };
 
 
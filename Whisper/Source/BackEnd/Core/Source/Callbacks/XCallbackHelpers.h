@@ -24,6 +24,8 @@
 
 #pragma once
 
+#include <cstring>
+
 #include <XReferenceCounted.h>
 
 namespace Whisper {
@@ -51,6 +53,177 @@ struct ReturnValue<void> {
 
 
 
+// ===================================================================================
+//	XCallbackStorage
+// ===================================================================================
+class XUnknownClass;
+typedef void (XUnknownClass::*XUnknownMethod)();	// member pointers to incomplete classes use the most general (and largest) representation
+
+template <typename OBJECT, typename METHOD>
+struct XMethodPayload {
+	OBJECT*	object;
+	METHOD 	method;
+};
+
+union XCallbackStorage {							// big enough for a function pointer or an object pointer and a method pointer
+	const void*		pointer;						// the helper (for callbacks that didn't fit)
+	void 			(*function)();
+	XUnknownMethod	method;
+	double			align;
+	unsigned char	bytes[sizeof(XMethodPayload<XUnknownClass, XUnknownMethod>)];
+};
+
+
+template <int FITS>
+struct XInlineTag {
+};
+
+
+template <typename T>
+struct XCanInlineFunction {							// functors may have state so only function pointers are stored inline
+	enum {value = false};
+};
+
+template <typename T>
+struct XCanInlineFunction<T*> {
+	enum {value = sizeof(T*) <= sizeof(XCallbackStorage)};
+};
+
+
+template <typename OBJECT, typename METHOD>
+struct XCanInlineMethod {
+	enum {value = sizeof(XMethodPayload<OBJECT, METHOD>) <= sizeof(XCallbackStorage)};
+};
+
+
+template <typename FUNCTION>
+inline bool InitPayload(XCallbackStorage& payload, FUNCTION function, XInlineTag<true>)
+{
+	std::memset(&payload, 0, sizeof(payload));
+	*reinterpret_cast<FUNCTION*>(payload.bytes) = function;
+	
+	return true;
+}
+
+template <typename FUNCTION>
+inline bool InitPayload(XCallbackStorage&, FUNCTION, XInlineTag<false>)
+{
+	return false;
+}
+
+
+template <typename OBJECT, typename METHOD>
+inline bool InitPayload(XCallbackStorage& payload, OBJECT* object, METHOD method, XInlineTag<true>)
+{
+	std::memset(&payload, 0, sizeof(payload));
+	XMethodPayload<OBJECT, METHOD>* p = reinterpret_cast<XMethodPayload<OBJECT, METHOD>*>(payload.bytes); 
+	p->object = object; 
+	p->method = method;
+	
+	return true;
+}
+
+template <typename OBJECT, typename METHOD>
+inline bool InitPayload(XCallbackStorage&, OBJECT*, METHOD, XInlineTag<false>)
+{
+	return false;
+}
+
+
+// ===================================================================================
+//	XCallbackData
+// ===================================================================================
+template <typename INVOKER, typename HELPER>
+class XCallbackData { 
+
+public:
+						~XCallbackData()						{if (mHelper != nil) mHelper->RemoveReference();}
+
+						XCallbackData() : mInvoke(nil), mHelper(nil)	{std::memset(&mStorage, 0, sizeof(mStorage));}
+
+						XCallbackData(const XCallbackData& rhs) : mInvoke(rhs.mInvoke), mHelper(rhs.mHelper), mStorage(rhs.mStorage)	{if (mHelper != nil) mHelper->AddReference();}
+
+			XCallbackData& operator=(const XCallbackData& rhs)	{if (rhs.mHelper != nil) rhs.mHelper->AddReference(); if (mHelper != nil) mHelper->RemoveReference(); mInvoke = rhs.mInvoke; mHelper = rhs.mHelper; mStorage = rhs.mStorage; return *this;}
+
+public:
+						template <typename FUNCTION>
+			void 		InitFunction(INVOKER invoke, FUNCTION function)		{ASSERT(mInvoke == nil); ASSERT(function != nil); mInvoke = invoke; (void) InitPayload(mStorage, function, XInlineTag<true>());}
+
+						template <typename OBJECT, typename METHOD>
+			void 		InitMethod(INVOKER invoke, OBJECT* object, METHOD method)	{ASSERT(mInvoke == nil); ASSERT(object != nil); ASSERT(method != nil); mInvoke = invoke; (void) InitPayload(mStorage, object, method, XInlineTag<true>());}
+
+			void 		InitHelper(INVOKER invoke, HELPER* helper)	{ASSERT(mInvoke == nil); ASSERT(helper != nil); mInvoke = invoke; mHelper = helper; mStorage.pointer = helper;}
+
+			INVOKER 	GetInvoker() const						{return mInvoke;}
+			const XCallbackStorage& GetStorage() const			{return mStorage;}
+
+			bool 		operator==(const XCallbackData& rhs) const;
+			bool 		operator<(const XCallbackData& rhs) const;
+						// Callbacks are compared by target so an inline callback matches a helper
+						// wrapping the same function or method. The invokers aren't compared because
+						// their addresses can differ between code fragments and DLLs.
+
+private:
+	enum EKind {kUnset, kPayload, kHelper};
+
+			EKind 		DoGetKey(XCallbackStorage& key) const;
+			const HELPER* DoGetHelper() const					{return static_cast<const HELPER*>(mStorage.pointer);}
+
+private:
+	INVOKER					mInvoke;				// nil if the callback hasn't been set
+	XReferenceCountedMixin*	mHelper;				// nil unless the callback didn't fit into mStorage
+	XCallbackStorage		mStorage;				// zero filled so that callbacks can be compared with memcmp
+};
+
+
+template <typename INVOKER, typename HELPER>
+bool XCallbackData<INVOKER, HELPER>::operator==(const XCallbackData& rhs) const
+{
+	XCallbackStorage lhsKey, rhsKey;
+	EKind lhsKind = this->DoGetKey(lhsKey);
+	EKind rhsKind = rhs.DoGetKey(rhsKey);
+	
+	bool equal = lhsKind == rhsKind;
+	if (equal && lhsKind == kHelper)
+		equal = this->DoGetHelper()->Equal(rhs.DoGetHelper());
+	else if (equal)
+		equal = std::memcmp(&lhsKey, &rhsKey, sizeof(lhsKey)) == 0;
+		
+	return equal;
+}
+
+
+template <typename INVOKER, typename HELPER>
+bool XCallbackData<INVOKER, HELPER>::operator<(const XCallbackData& rhs) const
+{
+	XCallbackStorage lhsKey, rhsKey;
+	EKind lhsKind = this->DoGetKey(lhsKey);
+	EKind rhsKind = rhs.DoGetKey(rhsKey);
+	
+	return lhsKind < rhsKind || (lhsKind == rhsKind && std::memcmp(&lhsKey, &rhsKey, sizeof(lhsKey)) < 0);
+}
+
+
+template <typename INVOKER, typename HELPER>
+typename XCallbackData<INVOKER, HELPER>::EKind XCallbackData<INVOKER, HELPER>::DoGetKey(XCallbackStorage& key) const
+{
+	EKind kind = kPayload;
+	
+	if (mHelper == nil) {
+		key = mStorage;					// zero filled if the callback hasn't been set
+		if (mInvoke == nil)
+			kind = kUnset;
+	
+	} else if (!this->DoGetHelper()->GetPayload(key)) {
+		std::memset(&key, 0, sizeof(key));
+		key.pointer = mStorage.pointer;
+		kind = kHelper;
+	}
+	
+	return kind;
+}
+
+
 // ===================================================================================
 //	Callback0
 // ===================================================================================
@@ -71,6 +244,9 @@ public:
 	virtual RETURN_TYPE Call() const = 0;
 
 	virtual bool 		Equal(const XBaseCallback0* rhs) const = 0;
+
+	virtual bool 		GetPayload(XCallbackStorage&) const		{return false;}
+						// If the callback would fit inline this fills in the inline representation.
 };
 
 
@@ -83,6 +259,8 @@ public:
 	virtual RETURN_TYPE Call() const 							{return mFunction();}
 		
 	virtual bool 		Equal(const XBaseCallback0<RETURN_TYPE>* rhs) const {if (const XCCallback0<FUNCTION, RETURN_TYPE>* f = dynamic_cast<const XCCallback0<FUNCTION, RETURN_TYPE>*>(rhs)) return mFunction == f->mFunction; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mFunction, XInlineTag<XCanInlineFunction<FUNCTION>::value>());}
 		
 private:
 	FUNCTION	mFunction;
@@ -98,6 +276,8 @@ public:
 	virtual RETURN_TYPE Call() const 									{return (mObject->*mMethod)();}
 		
 	virtual bool 		Equal(const XBaseCallback0<RETURN_TYPE>* rhs) const {if (const XObjCallback0<OBJECT, METHOD, RETURN_TYPE>* f = dynamic_cast<const XObjCallback0<OBJECT, METHOD, RETURN_TYPE>*>(rhs)) return mObject == f->mObject && mMethod == f->mMethod; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mObject, mMethod, XInlineTag<XCanInlineMethod<OBJECT, METHOD>::value>());}
 		
 private:
 	OBJECT*	mObject;
@@ -114,6 +294,8 @@ public:
 	virtual void 		Call() const 							{mFunction();}
 		
 	virtual bool 		Equal(const XBaseCallback0<void>* rhs) const {if (const XCCallback0<FUNCTION, void>* f = dynamic_cast<const XCCallback0<FUNCTION, void>*>(rhs)) return mFunction == f->mFunction; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mFunction, XInlineTag<XCanInlineFunction<FUNCTION>::value>());}
 		
 private:
 	FUNCTION	mFunction;
@@ -129,6 +311,8 @@ public:
 	virtual void 		Call() const 									{(mObject->*mMethod)();}
 		
 	virtual bool 		Equal(const XBaseCallback0<void>* rhs) const {if (const XObjCallback0<OBJECT, METHOD, void>* f = dynamic_cast<const XObjCallback0<OBJECT, METHOD, void>*>(rhs)) return mObject == f->mObject && mMethod == f->mMethod; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mObject, mMethod, XInlineTag<XCanInlineMethod<OBJECT, METHOD>::value>());}
 		
 private:
 	OBJECT*	mObject;
@@ -156,6 +340,9 @@ public:
 	virtual RETURN_TYPE Call(ARG1 arg1) const = 0;
 
 	virtual bool 		Equal(const XBaseCallback1* rhs) const = 0;
+
+	virtual bool 		GetPayload(XCallbackStorage&) const		{return false;}
+						// If the callback would fit inline this fills in the inline representation.
 };
 
 
@@ -168,6 +355,8 @@ public:
 	virtual RETURN_TYPE Call(ARG1 arg1) const 					{return mFunction(arg1);}
 		
 	virtual bool 		Equal(const XBaseCallback1<RETURN_TYPE, ARG1>* rhs) const 	{if (const XCCallback1<FUNCTION, RETURN_TYPE, ARG1>* f = dynamic_cast<const XCCallback1<FUNCTION, RETURN_TYPE, ARG1>*>(rhs)) return mFunction == f->mFunction; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mFunction, XInlineTag<XCanInlineFunction<FUNCTION>::value>());}
 		
 private:
 	FUNCTION	mFunction;
@@ -183,6 +372,8 @@ public:
 	virtual RETURN_TYPE Call(ARG1 arg1) const 							{return (mObject->*mMethod)(arg1);}
 		
 	virtual bool 		Equal(const XBaseCallback1<RETURN_TYPE, ARG1>* rhs) const {if (const XObjCallback1<OBJECT, METHOD, RETURN_TYPE, ARG1>* f = dynamic_cast<const XObjCallback1<OBJECT, METHOD, RETURN_TYPE, ARG1>*>(rhs)) return mObject == f->mObject && mMethod == f->mMethod; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mObject, mMethod, XInlineTag<XCanInlineMethod<OBJECT, METHOD>::value>());}
 		
 private:
 	OBJECT*	mObject;
@@ -199,6 +390,8 @@ public:
 	virtual void 		Call(ARG1 arg1) const 					{mFunction(arg1);}
 		
 	virtual bool 		Equal(const XBaseCallback1<void, ARG1>* rhs) const 	{if (const XCCallback1<FUNCTION, void, ARG1>* f = dynamic_cast<const XCCallback1<FUNCTION, void, ARG1>*>(rhs)) return mFunction == f->mFunction; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mFunction, XInlineTag<XCanInlineFunction<FUNCTION>::value>());}
 		
 private:
 	FUNCTION	mFunction;
@@ -214,6 +407,8 @@ public:
 	virtual void 		Call(ARG1 arg1) const 							{(mObject->*mMethod)(arg1);}
 		
 	virtual bool 		Equal(const XBaseCallback1<void, ARG1>* rhs) const {if (const XObjCallback1<OBJECT, METHOD, void, ARG1>* f = dynamic_cast<const XObjCallback1<OBJECT, METHOD, void, ARG1>*>(rhs)) return mObject == f->mObject && mMethod == f->mMethod; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mObject, mMethod, XInlineTag<XCanInlineMethod<OBJECT, METHOD>::value>());}
 		
 private:
 	OBJECT*	mObject;
@@ -241,6 +436,9 @@ public:
 	virtual RETURN_TYPE Call(ARG1 arg1, ARG2 arg2) const = 0;
 
 	virtual bool 		Equal(const XBaseCallback2* rhs) const = 0;
+
+	virtual bool 		GetPayload(XCallbackStorage&) const		{return false;}
+						// If the callback would fit inline this fills in the inline representation.
 };
 
 
@@ -253,6 +451,8 @@ public:
 	virtual RETURN_TYPE Call(ARG1 arg1, ARG2 arg2) const 	{return mFunction(arg1, arg2);}
 		
 	virtual bool 		Equal(const XBaseCallback2<RETURN_TYPE, ARG1, ARG2>* rhs) const {if (const XCCallback2<FUNCTION, RETURN_TYPE, ARG1, ARG2>* f = dynamic_cast<const XCCallback2<FUNCTION, RETURN_TYPE, ARG1, ARG2>*>(rhs)) return mFunction == f->mFunction; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mFunction, XInlineTag<XCanInlineFunction<FUNCTION>::value>());}
 		
 private:
 	FUNCTION	mFunction;
@@ -268,6 +468,8 @@ public:
 	virtual RETURN_TYPE Call(ARG1 arg1, ARG2 arg2) const 				{return (mObject->*mMethod)(arg1, arg2);}
 		
 	virtual bool 		Equal(const XBaseCallback2<RETURN_TYPE, ARG1, ARG2>* rhs) const {if (const XObjCallback2<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2>* f = dynamic_cast<const XObjCallback2<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2>*>(rhs)) return mObject == f->mObject && mMethod == f->mMethod; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mObject, mMethod, XInlineTag<XCanInlineMethod<OBJECT, METHOD>::value>());}
 		
 private:
 	OBJECT*	mObject;
@@ -284,6 +486,8 @@ public:
 	virtual void 		Call(ARG1 arg1, ARG2 arg2) const 	{mFunction(arg1, arg2);}
 		
 	virtual bool 		Equal(const XBaseCallback2<void, ARG1, ARG2>* rhs) const {if (const XCCallback2<FUNCTION, void, ARG1, ARG2>* f = dynamic_cast<const XCCallback2<FUNCTION, void, ARG1, ARG2>*>(rhs)) return mFunction == f->mFunction; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mFunction, XInlineTag<XCanInlineFunction<FUNCTION>::value>());}
 		
 private:
 	FUNCTION	mFunction;
@@ -299,6 +503,8 @@ public:
 	virtual void 		Call(ARG1 arg1, ARG2 arg2) const 				{(mObject->*mMethod)(arg1, arg2);}
 		
 	virtual bool 		Equal(const XBaseCallback2<void, ARG1, ARG2>* rhs) const {if (const XObjCallback2<OBJECT, METHOD, void, ARG1, ARG2>* f = dynamic_cast<const XObjCallback2<OBJECT, METHOD, void, ARG1, ARG2>*>(rhs)) return mObject == f->mObject && mMethod == f->mMethod; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mObject, mMethod, XInlineTag<XCanInlineMethod<OBJECT, METHOD>::value>());}
 		
 private:
 	OBJECT*	mObject;
@@ -326,6 +532,9 @@ public:
 	virtual RETURN_TYPE Call(ARG1 arg1, ARG2 arg2, ARG3 arg3) const = 0;
 
 	virtual bool 		Equal(const XBaseCallback3* rhs) const = 0;
+
+	virtual bool 		GetPayload(XCallbackStorage&) const		{return false;}
+						// If the callback would fit inline this fills in the inline representation.
 };
 
 
@@ -338,6 +547,8 @@ public:
 	virtual RETURN_TYPE Call(ARG1 arg1, ARG2 arg2, ARG3 arg3) const	{return mFunction(arg1, arg2, arg3);}
 		
 	virtual bool 		Equal(const XBaseCallback3<RETURN_TYPE, ARG1, ARG2, ARG3>* rhs) const 	{if (const XCCallback3<FUNCTION, RETURN_TYPE, ARG1, ARG2, ARG3>* f = dynamic_cast<const XCCallback3<FUNCTION, RETURN_TYPE, ARG1, ARG2, ARG3>*>(rhs)) return mFunction == f->mFunction; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mFunction, XInlineTag<XCanInlineFunction<FUNCTION>::value>());}
 		
 private:
 	FUNCTION	mFunction;
@@ -353,6 +564,8 @@ public:
 	virtual RETURN_TYPE Call(ARG1 arg1, ARG2 arg2, ARG3 arg3) const 	{return (mObject->*mMethod)(arg1, arg2, arg3);}
 		
 	virtual bool 		Equal(const XBaseCallback3<RETURN_TYPE, ARG1, ARG2, ARG3>* rhs) const {if (const XObjCallback3<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2, ARG3>* f = dynamic_cast<const XObjCallback3<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2, ARG3>*>(rhs)) return mObject == f->mObject && mMethod == f->mMethod; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mObject, mMethod, XInlineTag<XCanInlineMethod<OBJECT, METHOD>::value>());}
 		
 private:
 	OBJECT*	mObject;
@@ -369,6 +582,8 @@ public:
 	virtual void 		Call(ARG1 arg1, ARG2 arg2, ARG3 arg3) const	{mFunction(arg1, arg2, arg3);}
 		
 	virtual bool 		Equal(const XBaseCallback3<void, ARG1, ARG2, ARG3>* rhs) const 	{if (const XCCallback3<FUNCTION, void, ARG1, ARG2, ARG3>* f = dynamic_cast<const XCCallback3<FUNCTION, void, ARG1, ARG2, ARG3>*>(rhs)) return mFunction == f->mFunction; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mFunction, XInlineTag<XCanInlineFunction<FUNCTION>::value>());}
 		
 private:
 	FUNCTION	mFunction;
@@ -384,6 +599,8 @@ public:
 	virtual void 		Call(ARG1 arg1, ARG2 arg2, ARG3 arg3) const 	{(mObject->*mMethod)(arg1, arg2, arg3);}
 		
 	virtual bool 		Equal(const XBaseCallback3<void, ARG1, ARG2, ARG3>* rhs) const {if (const XObjCallback3<OBJECT, METHOD, void, ARG1, ARG2, ARG3>* f = dynamic_cast<const XObjCallback3<OBJECT, METHOD, void, ARG1, ARG2, ARG3>*>(rhs)) return mObject == f->mObject && mMethod == f->mMethod; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mObject, mMethod, XInlineTag<XCanInlineMethod<OBJECT, METHOD>::value>());}
 		
 private:
 	OBJECT*	mObject;
@@ -411,6 +628,9 @@ public:
 	virtual RETURN_TYPE Call(ARG1 arg1, ARG2 arg2, ARG3 arg3, ARG4 arg4) const = 0;
 
 	virtual bool 		Equal(const XBaseCallback4* rhs) const = 0;
+
+	virtual bool 		GetPayload(XCallbackStorage&) const		{return false;}
+						// If the callback would fit inline this fills in the inline representation.
 };
 
 
@@ -423,6 +643,8 @@ public:
 	virtual RETURN_TYPE Call(ARG1 arg1, ARG2 arg2, ARG3 arg3, ARG4 arg4) const 	{return mFunction(arg1, arg2, arg3, arg4);}
 		
 	virtual bool 		Equal(const XBaseCallback4<RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>* rhs) const {if (const XCCallback4<FUNCTION, RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>* f = dynamic_cast<const XCCallback4<FUNCTION, RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>*>(rhs)) return mFunction == f->mFunction; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mFunction, XInlineTag<XCanInlineFunction<FUNCTION>::value>());}
 		
 private:
 	FUNCTION	mFunction;
@@ -438,6 +660,8 @@ public:
 	virtual RETURN_TYPE Call(ARG1 arg1, ARG2 arg2, ARG3 arg3, ARG4 arg4) const 	{return (mObject->*mMethod)(arg1, arg2, arg3, arg4);}
 		
 	virtual bool 		Equal(const XBaseCallback4<RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>* rhs) const {if (const XObjCallback4<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>* f = dynamic_cast<const XObjCallback4<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>*>(rhs)) return mObject == f->mObject && mMethod == f->mMethod; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mObject, mMethod, XInlineTag<XCanInlineMethod<OBJECT, METHOD>::value>());}
 		
 private:
 	OBJECT*	mObject;
@@ -454,6 +678,8 @@ public:
 	virtual void 		Call(ARG1 arg1, ARG2 arg2, ARG3 arg3, ARG4 arg4) const 	{mFunction(arg1, arg2, arg3, arg4);}
 		
 	virtual bool 		Equal(const XBaseCallback4<void, ARG1, ARG2, ARG3, ARG4>* rhs) const {if (const XCCallback4<FUNCTION, void, ARG1, ARG2, ARG3, ARG4>* f = dynamic_cast<const XCCallback4<FUNCTION, void, ARG1, ARG2, ARG3, ARG4>*>(rhs)) return mFunction == f->mFunction; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mFunction, XInlineTag<XCanInlineFunction<FUNCTION>::value>());}
 		
 private:
 	FUNCTION	mFunction;
@@ -469,6 +695,8 @@ public:
 	virtual void 		Call(ARG1 arg1, ARG2 arg2, ARG3 arg3, ARG4 arg4) const 	{(mObject->*mMethod)(arg1, arg2, arg3, arg4);}
 		
 	virtual bool 		Equal(const XBaseCallback4<void, ARG1, ARG2, ARG3, ARG4>* rhs) const {if (const XObjCallback4<OBJECT, METHOD, void, ARG1, ARG2, ARG3, ARG4>* f = dynamic_cast<const XObjCallback4<OBJECT, METHOD, void, ARG1, ARG2, ARG3, ARG4>*>(rhs)) return mObject == f->mObject && mMethod == f->mMethod; else return false;}
+
+	virtual bool 		GetPayload(XCallbackStorage& payload) const	{return InitPayload(payload, mObject, mMethod, XInlineTag<XCanInlineMethod<OBJECT, METHOD>::value>());}
 		
 private:
 	OBJECT*	mObject;
@@ -476,6 +704,171 @@ private:
 };
 
 
+// ===================================================================================
+//	Invoker0
+// ===================================================================================
+template <typename FUNCTION, typename RETURN_TYPE>
+struct XCInvoker0 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage)		{return (*reinterpret_cast<const FUNCTION*>(storage.bytes))();}
+};
+
+
+template <typename OBJECT, typename METHOD, typename RETURN_TYPE>
+struct XObjInvoker0 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage)		{const XMethodPayload<OBJECT, METHOD>* p = reinterpret_cast<const XMethodPayload<OBJECT, METHOD>*>(storage.bytes); return (p->object->*p->method)();}
+};
+
+
+template <typename FUNCTION>
+struct XCInvoker0<FUNCTION, void> {
+	static void 		Invoke(const XCallbackStorage& storage)		{(*reinterpret_cast<const FUNCTION*>(storage.bytes))();}
+};
+
+
+template <typename OBJECT, typename METHOD>
+struct XObjInvoker0<OBJECT, METHOD, void> {
+	static void 		Invoke(const XCallbackStorage& storage)		{const XMethodPayload<OBJECT, METHOD>* p = reinterpret_cast<const XMethodPayload<OBJECT, METHOD>*>(storage.bytes); (p->object->*p->method)();}
+};
+
+
+template <typename RETURN_TYPE>
+struct XHelperInvoker0 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage)		{return static_cast<const XBaseCallback0<RETURN_TYPE>*>(storage.pointer)->Call();}
+};
+
+
+// ===================================================================================
+//	Invoker1
+// ===================================================================================
+template <typename FUNCTION, typename RETURN_TYPE, typename ARG1>
+struct XCInvoker1 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage, ARG1 arg1)		{return (*reinterpret_cast<const FUNCTION*>(storage.bytes))(arg1);}
+};
+
+
+template <typename OBJECT, typename METHOD, typename RETURN_TYPE, typename ARG1>
+struct XObjInvoker1 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage, ARG1 arg1)		{const XMethodPayload<OBJECT, METHOD>* p = reinterpret_cast<const XMethodPayload<OBJECT, METHOD>*>(storage.bytes); return (p->object->*p->method)(arg1);}
+};
+
+
+template <typename FUNCTION, typename ARG1>
+struct XCInvoker1<FUNCTION, void, ARG1> {
+	static void 		Invoke(const XCallbackStorage& storage, ARG1 arg1)		{(*reinterpret_cast<const FUNCTION*>(storage.bytes))(arg1);}
+};
+
+
+template <typename OBJECT, typename METHOD, typename ARG1>
+struct XObjInvoker1<OBJECT, METHOD, void, ARG1> {
+	static void 		Invoke(const XCallbackStorage& storage, ARG1 arg1)		{const XMethodPayload<OBJECT, METHOD>* p = reinterpret_cast<const XMethodPayload<OBJECT, METHOD>*>(storage.bytes); (p->object->*p->method)(arg1);}
+};
+
+
+template <typename RETURN_TYPE, typename ARG1>
+struct XHelperInvoker1 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage, ARG1 arg1)		{return static_cast<const XBaseCallback1<RETURN_TYPE, ARG1>*>(storage.pointer)->Call(arg1);}
+};
+
+
+// ===================================================================================
+//	Invoker2
+// ===================================================================================
+template <typename FUNCTION, typename RETURN_TYPE, typename ARG1, typename ARG2>
+struct XCInvoker2 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2)		{return (*reinterpret_cast<const FUNCTION*>(storage.bytes))(arg1, arg2);}
+};
+
+
+template <typename OBJECT, typename METHOD, typename RETURN_TYPE, typename ARG1, typename ARG2>
+struct XObjInvoker2 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2)		{const XMethodPayload<OBJECT, METHOD>* p = reinterpret_cast<const XMethodPayload<OBJECT, METHOD>*>(storage.bytes); return (p->object->*p->method)(arg1, arg2);}
+};
+
+
+template <typename FUNCTION, typename ARG1, typename ARG2>
+struct XCInvoker2<FUNCTION, void, ARG1, ARG2> {
+	static void 		Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2)		{(*reinterpret_cast<const FUNCTION*>(storage.bytes))(arg1, arg2);}
+};
+
+
+template <typename OBJECT, typename METHOD, typename ARG1, typename ARG2>
+struct XObjInvoker2<OBJECT, METHOD, void, ARG1, ARG2> {
+	static void 		Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2)		{const XMethodPayload<OBJECT, METHOD>* p = reinterpret_cast<const XMethodPayload<OBJECT, METHOD>*>(storage.bytes); (p->object->*p->method)(arg1, arg2);}
+};
+
+
+template <typename RETURN_TYPE, typename ARG1, typename ARG2>
+struct XHelperInvoker2 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2)		{return static_cast<const XBaseCallback2<RETURN_TYPE, ARG1, ARG2>*>(storage.pointer)->Call(arg1, arg2);}
+};
+
+
+// ===================================================================================
+//	Invoker3
+// ===================================================================================
+template <typename FUNCTION, typename RETURN_TYPE, typename ARG1, typename ARG2, typename ARG3>
+struct XCInvoker3 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2, ARG3 arg3)		{return (*reinterpret_cast<const FUNCTION*>(storage.bytes))(arg1, arg2, arg3);}
+};
+
+
+template <typename OBJECT, typename METHOD, typename RETURN_TYPE, typename ARG1, typename ARG2, typename ARG3>
+struct XObjInvoker3 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2, ARG3 arg3)		{const XMethodPayload<OBJECT, METHOD>* p = reinterpret_cast<const XMethodPayload<OBJECT, METHOD>*>(storage.bytes); return (p->object->*p->method)(arg1, arg2, arg3);}
+};
+
+
+template <typename FUNCTION, typename ARG1, typename ARG2, typename ARG3>
+struct XCInvoker3<FUNCTION, void, ARG1, ARG2, ARG3> {
+	static void 		Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2, ARG3 arg3)		{(*reinterpret_cast<const FUNCTION*>(storage.bytes))(arg1, arg2, arg3);}
+};
+
+
+template <typename OBJECT, typename METHOD, typename ARG1, typename ARG2, typename ARG3>
+struct XObjInvoker3<OBJECT, METHOD, void, ARG1, ARG2, ARG3> {
+	static void 		Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2, ARG3 arg3)		{const XMethodPayload<OBJECT, METHOD>* p = reinterpret_cast<const XMethodPayload<OBJECT, METHOD>*>(storage.bytes); (p->object->*p->method)(arg1, arg2, arg3);}
+};
+
+
+template <typename RETURN_TYPE, typename ARG1, typename ARG2, typename ARG3>
+struct XHelperInvoker3 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2, ARG3 arg3)		{return static_cast<const XBaseCallback3<RETURN_TYPE, ARG1, ARG2, ARG3>*>(storage.pointer)->Call(arg1, arg2, arg3);}
+};
+
+
+// ===================================================================================
+//	Invoker4
+// ===================================================================================
+template <typename FUNCTION, typename RETURN_TYPE, typename ARG1, typename ARG2, typename ARG3, typename ARG4>
+struct XCInvoker4 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2, ARG3 arg3, ARG4 arg4)		{return (*reinterpret_cast<const FUNCTION*>(storage.bytes))(arg1, arg2, arg3, arg4);}
+};
+
+
+template <typename OBJECT, typename METHOD, typename RETURN_TYPE, typename ARG1, typename ARG2, typename ARG3, typename ARG4>
+struct XObjInvoker4 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2, ARG3 arg3, ARG4 arg4)		{const XMethodPayload<OBJECT, METHOD>* p = reinterpret_cast<const XMethodPayload<OBJECT, METHOD>*>(storage.bytes); return (p->object->*p->method)(arg1, arg2, arg3, arg4);}
+};
+
+
+template <typename FUNCTION, typename ARG1, typename ARG2, typename ARG3, typename ARG4>
+struct XCInvoker4<FUNCTION, void, ARG1, ARG2, ARG3, ARG4> {
+	static void 		Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2, ARG3 arg3, ARG4 arg4)		{(*reinterpret_cast<const FUNCTION*>(storage.bytes))(arg1, arg2, arg3, arg4);}
+};
+
+
+template <typename OBJECT, typename METHOD, typename ARG1, typename ARG2, typename ARG3, typename ARG4>
+struct XObjInvoker4<OBJECT, METHOD, void, ARG1, ARG2, ARG3, ARG4> {
+	static void 		Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2, ARG3 arg3, ARG4 arg4)		{const XMethodPayload<OBJECT, METHOD>* p = reinterpret_cast<const XMethodPayload<OBJECT, METHOD>*>(storage.bytes); (p->object->*p->method)(arg1, arg2, arg3, arg4);}
+};
+
+
+template <typename RETURN_TYPE, typename ARG1, typename ARG2, typename ARG3, typename ARG4>
+struct XHelperInvoker4 {
+	static RETURN_TYPE 	Invoke(const XCallbackStorage& storage, ARG1 arg1, ARG2 arg2, ARG3 arg3, ARG4 arg4)		{return static_cast<const XBaseCallback4<RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>*>(storage.pointer)->Call(arg1, arg2, arg3, arg4);}
+};
+
+
 #if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
 	#pragma export reset
 #endif
@@ -44,11 +44,13 @@ namespace Whisper {
 //!		Callback class for functions with no arguments/
 /*!		This is a reimplementation of Rich Hickey's callback library. There are two 
  *		major differences. The first is that I'm using templatized ctors so makeFunctor 
- *		like functions are no longer neccesary. The second is that I don't stuff pointers 
- *		into a non-template base class. Instead callbacks are executed with a single 
- *		virtual function call. This eliminates a bunch of nasty casts, removes some 
- *		platform specific code for variable sized member function pointers, and IMO 
- *		results in more readable code.
+ *		like functions are no longer neccesary. The second is that I don't stuff pointers
+ *		into a non-template base class. Instead the function pointer or the object and
+ *		method pointers are stored inside the callback and executed through a static
+ *		function templatized on their types. Constructing and copying these callbacks
+ *		doesn't allocate memory or touch a reference count. Callbacks that don't fit (ie
+ *		the ones created by the Bind functions) are allocated on the heap and executed
+ *		with a virtual function call.
  *
  *		Note that the standard C++ library also provides wrappers around member function 
  *		pointers (eg mem_fun_t). However these classes are insufficiently general: there's 
@@ -86,31 +88,30 @@ class XCallback0 {
 public:
 	typedef RETURN_TYPE result_type;
 	typedef Internals::XBaseCallback0<RETURN_TYPE> Helper;
+	typedef RETURN_TYPE (*Invoker)(const Internals::XCallbackStorage& storage);
 
 //-----------------------------------
 //	Initialization/Destruction
 //
 public:
-						~XCallback0()							{if (mCallback != nil) mCallback->RemoveReference();}
-						
-						XCallback0() : mCallback(nil)			{}
+						XCallback0()							{}
 	
 #if __MWERKS__ == 0x2405		// $$$ Pro 7 messes up copy ctors when a template method is present
 						template <typename R>
-						XCallback0(R (*function)()) : mCallback(new Internals::XCCallback0<R (*)(), RETURN_TYPE>(function))	{}
+						XCallback0(R (*function)())	{this->DoInitFunction(function, Internals::XInlineTag<Internals::XCanInlineFunction<R (*)()>::value>());}
 #else
 						template <class FUNCTION>
-						XCallback0(FUNCTION function) : mCallback(new Internals::XCCallback0<FUNCTION, RETURN_TYPE>(function))	{}
+						XCallback0(FUNCTION function)			{this->DoInitFunction(function, Internals::XInlineTag<Internals::XCanInlineFunction<FUNCTION>::value>());}
 #endif
 
 						template <class OBJECT, class METHOD>
-						XCallback0(OBJECT* object, METHOD method) : mCallback(new Internals::XObjCallback0<OBJECT, METHOD, RETURN_TYPE>(object, method))	{}
+						XCallback0(OBJECT* object, METHOD method)	{this->DoInitMethod(object, method, Internals::XInlineTag<Internals::XCanInlineMethod<OBJECT, METHOD>::value>());}
 						
-						XCallback0(Helper* callback, int, int) : mCallback(callback)	{ASSERT(callback != nil);}
+						XCallback0(Helper* callback, int, int)	{this->DoInitHelper(callback);}
 	
-						XCallback0(const XCallback0& rhs)		{if (rhs.mCallback != nil) rhs.mCallback->AddReference(); mCallback = rhs.mCallback;}
+						XCallback0(const XCallback0& rhs) : mData(rhs.mData)	{}
 						
-			XCallback0& operator=(const XCallback0& rhs) 		{if (mCallback != rhs.mCallback) {if (rhs.mCallback != nil) rhs.mCallback->AddReference(); if (mCallback != nil) mCallback->RemoveReference(); mCallback = rhs.mCallback;} return *this;}
+			XCallback0& operator=(const XCallback0& rhs) 		{mData = rhs.mData; return *this;}
 
 						template <class OBJECT, class METHOD>
 			void 		Set(OBJECT* object, METHOD method) 		{(void) this->operator=(XCallback0(object, method));}
@@ -119,19 +120,37 @@ public:
 //	API
 //
 public:
-			RETURN_TYPE operator()() const						{ASSERT(mCallback != nil); return mCallback->Call();}
+			RETURN_TYPE operator()() const	{ASSERT(mData.GetInvoker() != nil); return mData.GetInvoker()(mData.GetStorage());}
 
-			bool 		IsValid() const							{return mCallback != nil;}
+			bool 		IsValid() const							{return mData.GetInvoker() != nil;}
 			
-			bool 		operator==(const XCallback0& rhs) const	{return (mCallback == nil && rhs.mCallback == nil) || (mCallback != nil && mCallback->Equal(rhs.mCallback));}
+			bool 		operator==(const XCallback0& rhs) const	{return mData == rhs.mData;}
 			bool 		operator!=(const XCallback0& rhs) const	{return !this->operator==(rhs);}
-			bool 		operator<(const XCallback0& rhs) const	{return mCallback < rhs.mCallback;}
+			bool 		operator<(const XCallback0& rhs) const	{return mData < rhs.mData;}
+
+//-----------------------------------
+//	Internal API
+//
+private:
+						template <class FUNCTION>
+			void 		DoInitFunction(FUNCTION function, Internals::XInlineTag<true>)	{mData.InitFunction(&Internals::XCInvoker0<FUNCTION, RETURN_TYPE>::Invoke, function);}
+
+						template <class FUNCTION>
+			void 		DoInitFunction(FUNCTION function, Internals::XInlineTag<false>)	{this->DoInitHelper(new Internals::XCCallback0<FUNCTION, RETURN_TYPE>(function));}
+
+						template <class OBJECT, class METHOD>
+			void 		DoInitMethod(OBJECT* object, METHOD method, Internals::XInlineTag<true>)	{mData.InitMethod(&Internals::XObjInvoker0<OBJECT, METHOD, RETURN_TYPE>::Invoke, object, method);}
+
+						template <class OBJECT, class METHOD>
+			void 		DoInitMethod(OBJECT* object, METHOD method, Internals::XInlineTag<false>)	{this->DoInitHelper(new Internals::XObjCallback0<OBJECT, METHOD, RETURN_TYPE>(object, method));}
+
+			void 		DoInitHelper(Helper* callback)			{mData.InitHelper(&Internals::XHelperInvoker0<RETURN_TYPE>::Invoke, callback);}
 
 //-----------------------------------
 //	Member Data
 //
 private:
-	Helper*	mCallback;
+	Internals::XCallbackData<Invoker, Helper>	mData;
 };
 
 
@@ -149,31 +168,30 @@ public:
 	typedef RETURN_TYPE result_type;
 	typedef ARG1 		argument_type;
 	typedef Internals::XBaseCallback1<RETURN_TYPE, ARG1> Helper;
+	typedef RETURN_TYPE (*Invoker)(const Internals::XCallbackStorage& storage, ARG1);
 
 //-----------------------------------
 //	Initialization/Destruction
 //
 public:
-						~XCallback1()							{if (mCallback != nil) mCallback->RemoveReference();}
-						
-						XCallback1() : mCallback(nil)			{}
-
+						XCallback1()							{}
+	
 #if __MWERKS__ == 0x2405		// $$$ Pro 7 messes up copy ctors when a template method is present
 						template <typename R, typename A1>
-						XCallback1(R (*function)(A1)) : mCallback(new Internals::XCCallback1<R (*)(A1), RETURN_TYPE, ARG1>(function))	{}
+						XCallback1(R (*function)(A1))	{this->DoInitFunction(function, Internals::XInlineTag<Internals::XCanInlineFunction<R (*)(A1)>::value>());}
 #else
 						template <class FUNCTION>
-						XCallback1(FUNCTION function) : mCallback(new Internals::XCCallback1<FUNCTION, RETURN_TYPE, ARG1>(function))	{}
+						XCallback1(FUNCTION function)			{this->DoInitFunction(function, Internals::XInlineTag<Internals::XCanInlineFunction<FUNCTION>::value>());}
 #endif
 
 						template <class OBJECT, class METHOD>
-						XCallback1(OBJECT* object, METHOD method) : mCallback(new Internals::XObjCallback1<OBJECT, METHOD, RETURN_TYPE, ARG1>(object, method))	{}
+						XCallback1(OBJECT* object, METHOD method)	{this->DoInitMethod(object, method, Internals::XInlineTag<Internals::XCanInlineMethod<OBJECT, METHOD>::value>());}
 						
-						XCallback1(Helper* callback, int, int) : mCallback(callback)	{ASSERT(callback != nil);}
+						XCallback1(Helper* callback, int, int)	{this->DoInitHelper(callback);}
 	
-						XCallback1(const XCallback1& rhs)		{if (rhs.mCallback != nil) rhs.mCallback->AddReference(); mCallback = rhs.mCallback;}
+						XCallback1(const XCallback1& rhs) : mData(rhs.mData)	{}
 						
-			XCallback1& operator=(const XCallback1& rhs) 		{if (mCallback != rhs.mCallback) {if (rhs.mCallback != nil) rhs.mCallback->AddReference(); if (mCallback != nil) mCallback->RemoveReference(); mCallback = rhs.mCallback;} return *this;}
+			XCallback1& operator=(const XCallback1& rhs) 		{mData = rhs.mData; return *this;}
 
 						template <class OBJECT, class METHOD>
 			void 		Set(OBJECT* object, METHOD method) 		{(void) this->operator=(XCallback1(object, method));}
@@ -182,19 +200,37 @@ public:
 //	API
 //
 public:
-			RETURN_TYPE operator()(ARG1 arg1) const				{ASSERT(mCallback != nil); return mCallback->Call(arg1);}
+			RETURN_TYPE operator()(ARG1 arg1) const	{ASSERT(mData.GetInvoker() != nil); return mData.GetInvoker()(mData.GetStorage(), arg1);}
 
-			bool 		IsValid() const							{return mCallback != nil;}
+			bool 		IsValid() const							{return mData.GetInvoker() != nil;}
 			
-			bool 		operator==(const XCallback1& rhs) const	{return (mCallback == nil && rhs.mCallback == nil) || (mCallback != nil && mCallback->Equal(rhs.mCallback));}
+			bool 		operator==(const XCallback1& rhs) const	{return mData == rhs.mData;}
 			bool 		operator!=(const XCallback1& rhs) const	{return !this->operator==(rhs);}
-			bool 		operator<(const XCallback1& rhs) const	{return mCallback < rhs.mCallback;}
+			bool 		operator<(const XCallback1& rhs) const	{return mData < rhs.mData;}
+
+//-----------------------------------
+//	Internal API
+//
+private:
+						template <class FUNCTION>
+			void 		DoInitFunction(FUNCTION function, Internals::XInlineTag<true>)	{mData.InitFunction(&Internals::XCInvoker1<FUNCTION, RETURN_TYPE, ARG1>::Invoke, function);}
+
+						template <class FUNCTION>
+			void 		DoInitFunction(FUNCTION function, Internals::XInlineTag<false>)	{this->DoInitHelper(new Internals::XCCallback1<FUNCTION, RETURN_TYPE, ARG1>(function));}
+
+						template <class OBJECT, class METHOD>
+			void 		DoInitMethod(OBJECT* object, METHOD method, Internals::XInlineTag<true>)	{mData.InitMethod(&Internals::XObjInvoker1<OBJECT, METHOD, RETURN_TYPE, ARG1>::Invoke, object, method);}
+
+						template <class OBJECT, class METHOD>
+			void 		DoInitMethod(OBJECT* object, METHOD method, Internals::XInlineTag<false>)	{this->DoInitHelper(new Internals::XObjCallback1<OBJECT, METHOD, RETURN_TYPE, ARG1>(object, method));}
+
+			void 		DoInitHelper(Helper* callback)			{mData.InitHelper(&Internals::XHelperInvoker1<RETURN_TYPE, ARG1>::Invoke, callback);}
 
 //-----------------------------------
 //	Member Data
 //
 private:
-	Helper*	mCallback;
+	Internals::XCallbackData<Invoker, Helper>	mData;
 };
 
 
@@ -213,31 +249,30 @@ public:
 	typedef ARG1 		first_argument_type;
 	typedef ARG2 		second_argument_type;
 	typedef Internals::XBaseCallback2<RETURN_TYPE, ARG1, ARG2> Helper;
+	typedef RETURN_TYPE (*Invoker)(const Internals::XCallbackStorage& storage, ARG1, ARG2);
 
 //-----------------------------------
 //	Initialization/Destruction
 //
 public:
-						~XCallback2()							{if (mCallback != nil) mCallback->RemoveReference();}
-						
-						XCallback2() : mCallback(nil)			{}
+						XCallback2()							{}
 	
 #if __MWERKS__ == 0x2405		// $$$ Pro 7 messes up copy ctors when a template method is present
 						template <typename R, typename A1, typename A2>
-						XCallback2(R (*function)(A1, A2)) : mCallback(new Internals::XCCallback2<R (*)(A1, A2), RETURN_TYPE, ARG1, ARG2>(function))	{}
+						XCallback2(R (*function)(A1, A2))	{this->DoInitFunction(function, Internals::XInlineTag<Internals::XCanInlineFunction<R (*)(A1, A2)>::value>());}
 #else
 						template <class FUNCTION>
-						XCallback2(FUNCTION function) : mCallback(new Internals::XCCallback2<FUNCTION, RETURN_TYPE, ARG1, ARG2>(function))	{}
+						XCallback2(FUNCTION function)			{this->DoInitFunction(function, Internals::XInlineTag<Internals::XCanInlineFunction<FUNCTION>::value>());}
 #endif
 
 						template <class OBJECT, class METHOD>
-						XCallback2(OBJECT* object, METHOD method) : mCallback(new Internals::XObjCallback2<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2>(object, method))	{}
+						XCallback2(OBJECT* object, METHOD method)	{this->DoInitMethod(object, method, Internals::XInlineTag<Internals::XCanInlineMethod<OBJECT, METHOD>::value>());}
 						
-						XCallback2(Helper* callback, int, int) : mCallback(callback)	{ASSERT(callback != nil);}
+						XCallback2(Helper* callback, int, int)	{this->DoInitHelper(callback);}
 	
-						XCallback2(const XCallback2& rhs)		{if (rhs.mCallback != nil) rhs.mCallback->AddReference(); mCallback = rhs.mCallback;}
+						XCallback2(const XCallback2& rhs) : mData(rhs.mData)	{}
 						
-			XCallback2& operator=(const XCallback2& rhs) 		{if (mCallback != rhs.mCallback) {if (rhs.mCallback != nil) rhs.mCallback->AddReference(); if (mCallback != nil) mCallback->RemoveReference(); mCallback = rhs.mCallback;} return *this;}
+			XCallback2& operator=(const XCallback2& rhs) 		{mData = rhs.mData; return *this;}
 
 						template <class OBJECT, class METHOD>
 			void 		Set(OBJECT* object, METHOD method) 		{(void) this->operator=(XCallback2(object, method));}
@@ -246,19 +281,37 @@ public:
 //	API
 //
 public:
-			RETURN_TYPE operator()(ARG1 arg1, ARG2 arg2) const	{ASSERT(mCallback != nil); return mCallback->Call(arg1, arg2);}
+			RETURN_TYPE operator()(ARG1 arg1, ARG2 arg2) const	{ASSERT(mData.GetInvoker() != nil); return mData.GetInvoker()(mData.GetStorage(), arg1, arg2);}
 
-			bool 		IsValid() const							{return mCallback != nil;}
-
-			bool 		operator==(const XCallback2& rhs) const	{return (mCallback == nil && rhs.mCallback == nil) || (mCallback != nil && mCallback->Equal(rhs.mCallback));}
+			bool 		IsValid() const							{return mData.GetInvoker() != nil;}
+			
+			bool 		operator==(const XCallback2& rhs) const	{return mData == rhs.mData;}
 			bool 		operator!=(const XCallback2& rhs) const	{return !this->operator==(rhs);}
-			bool 		operator<(const XCallback2& rhs) const	{return mCallback < rhs.mCallback;}
+			bool 		operator<(const XCallback2& rhs) const	{return mData < rhs.mData;}
+
+//-----------------------------------
+//	Internal API
+//
+private:
+						template <class FUNCTION>
+			void 		DoInitFunction(FUNCTION function, Internals::XInlineTag<true>)	{mData.InitFunction(&Internals::XCInvoker2<FUNCTION, RETURN_TYPE, ARG1, ARG2>::Invoke, function);}
+
+						template <class FUNCTION>
+			void 		DoInitFunction(FUNCTION function, Internals::XInlineTag<false>)	{this->DoInitHelper(new Internals::XCCallback2<FUNCTION, RETURN_TYPE, ARG1, ARG2>(function));}
+
+						template <class OBJECT, class METHOD>
+			void 		DoInitMethod(OBJECT* object, METHOD method, Internals::XInlineTag<true>)	{mData.InitMethod(&Internals::XObjInvoker2<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2>::Invoke, object, method);}
+
+						template <class OBJECT, class METHOD>
+			void 		DoInitMethod(OBJECT* object, METHOD method, Internals::XInlineTag<false>)	{this->DoInitHelper(new Internals::XObjCallback2<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2>(object, method));}
+
+			void 		DoInitHelper(Helper* callback)			{mData.InitHelper(&Internals::XHelperInvoker2<RETURN_TYPE, ARG1, ARG2>::Invoke, callback);}
 
 //-----------------------------------
 //	Member Data
 //
 private:
-	Helper*	mCallback;
+	Internals::XCallbackData<Invoker, Helper>	mData;
 };
 
 
@@ -278,31 +331,30 @@ public:
 	typedef ARG2 		second_argument_type;
 	typedef ARG3 		third_argument_type;
 	typedef Internals::XBaseCallback3<RETURN_TYPE, ARG1, ARG2, ARG3> Helper;
+	typedef RETURN_TYPE (*Invoker)(const Internals::XCallbackStorage& storage, ARG1, ARG2, ARG3);
 
 //-----------------------------------
 //	Initialization/Destruction
 //
 public:
-						~XCallback3()							{if (mCallback != nil) mCallback->RemoveReference();}
-						
-						XCallback3() : mCallback(nil)			{}
+						XCallback3()							{}
 	
 #if __MWERKS__ == 0x2405		// $$$ Pro 7 messes up copy ctors when a template method is present
 						template <typename R, typename A1, typename A2, typename A3>
-						XCallback3(R (*function)(A1, A2, A3)) : mCallback(new Internals::XCCallback3<R (*)(A1, A2, A3), RETURN_TYPE, ARG1, ARG2, ARG3>(function))	{}
+						XCallback3(R (*function)(A1, A2, A3))	{this->DoInitFunction(function, Internals::XInlineTag<Internals::XCanInlineFunction<R (*)(A1, A2, A3)>::value>());}
 #else
 						template <class FUNCTION>
-						XCallback3(FUNCTION function) : mCallback(new Internals::XCCallback3<FUNCTION, RETURN_TYPE, ARG1, ARG2, ARG3>(function))	{}
+						XCallback3(FUNCTION function)			{this->DoInitFunction(function, Internals::XInlineTag<Internals::XCanInlineFunction<FUNCTION>::value>());}
 #endif
 
 						template <class OBJECT, class METHOD>
-						XCallback3(OBJECT* object, METHOD method) : mCallback(new Internals::XObjCallback3<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2, ARG3>(object, method))	{}
+						XCallback3(OBJECT* object, METHOD method)	{this->DoInitMethod(object, method, Internals::XInlineTag<Internals::XCanInlineMethod<OBJECT, METHOD>::value>());}
 						
-						XCallback3(Helper* callback, int, int) : mCallback(callback)	{ASSERT(callback != nil);}
+						XCallback3(Helper* callback, int, int)	{this->DoInitHelper(callback);}
 	
-						XCallback3(const XCallback3& rhs)		{if (rhs.mCallback != nil) rhs.mCallback->AddReference(); mCallback = rhs.mCallback;}
+						XCallback3(const XCallback3& rhs) : mData(rhs.mData)	{}
 						
-			XCallback3& operator=(const XCallback3& rhs) 		{if (mCallback != rhs.mCallback) {if (rhs.mCallback != nil) rhs.mCallback->AddReference(); if (mCallback != nil) mCallback->RemoveReference(); mCallback = rhs.mCallback;} return *this;}
+			XCallback3& operator=(const XCallback3& rhs) 		{mData = rhs.mData; return *this;}
 
 						template <class OBJECT, class METHOD>
 			void 		Set(OBJECT* object, METHOD method) 		{(void) this->operator=(XCallback3(object, method));}
@@ -311,19 +363,37 @@ public:
 //	API
 //
 public:
-			RETURN_TYPE operator()(ARG1 arg1, ARG2 arg2, ARG3 arg3) const		{ASSERT(mCallback != nil); return mCallback->Call(arg1, arg2, arg3);}
-
-			bool 		IsValid() const							{return mCallback != nil;}
+			RETURN_TYPE operator()(ARG1 arg1, ARG2 arg2, ARG3 arg3) const	{ASSERT(mData.GetInvoker() != nil); return mData.GetInvoker()(mData.GetStorage(), arg1, arg2, arg3);}
 
-			bool 		operator==(const XCallback3& rhs) const	{return (mCallback == nil && rhs.mCallback == nil) || (mCallback != nil && mCallback->Equal(rhs.mCallback));}
+			bool 		IsValid() const							{return mData.GetInvoker() != nil;}
+			
+			bool 		operator==(const XCallback3& rhs) const	{return mData == rhs.mData;}
 			bool 		operator!=(const XCallback3& rhs) const	{return !this->operator==(rhs);}
-			bool 		operator<(const XCallback3& rhs) const	{return mCallback < rhs.mCallback;}
+			bool 		operator<(const XCallback3& rhs) const	{return mData < rhs.mData;}
+
+//-----------------------------------
+//	Internal API
+//
+private:
+						template <class FUNCTION>
+			void 		DoInitFunction(FUNCTION function, Internals::XInlineTag<true>)	{mData.InitFunction(&Internals::XCInvoker3<FUNCTION, RETURN_TYPE, ARG1, ARG2, ARG3>::Invoke, function);}
+
+						template <class FUNCTION>
+			void 		DoInitFunction(FUNCTION function, Internals::XInlineTag<false>)	{this->DoInitHelper(new Internals::XCCallback3<FUNCTION, RETURN_TYPE, ARG1, ARG2, ARG3>(function));}
+
+						template <class OBJECT, class METHOD>
+			void 		DoInitMethod(OBJECT* object, METHOD method, Internals::XInlineTag<true>)	{mData.InitMethod(&Internals::XObjInvoker3<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2, ARG3>::Invoke, object, method);}
+
+						template <class OBJECT, class METHOD>
+			void 		DoInitMethod(OBJECT* object, METHOD method, Internals::XInlineTag<false>)	{this->DoInitHelper(new Internals::XObjCallback3<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2, ARG3>(object, method));}
+
+			void 		DoInitHelper(Helper* callback)			{mData.InitHelper(&Internals::XHelperInvoker3<RETURN_TYPE, ARG1, ARG2, ARG3>::Invoke, callback);}
 
 //-----------------------------------
 //	Member Data
 //
 private:
-	Helper*	mCallback;
+	Internals::XCallbackData<Invoker, Helper>	mData;
 };
 
 
@@ -344,52 +414,69 @@ public:
 	typedef ARG3 		third_argument_type;
 	typedef ARG4		fourth_argument_type;
 	typedef Internals::XBaseCallback4<RETURN_TYPE, ARG1, ARG2, ARG3, ARG4> Helper;
+	typedef RETURN_TYPE (*Invoker)(const Internals::XCallbackStorage& storage, ARG1, ARG2, ARG3, ARG4);
 
 //-----------------------------------
 //	Initialization/Destruction
 //
 public:
-						~XCallback4()							{if (mCallback != nil) mCallback->RemoveReference();}
-						
-						XCallback4() : mCallback(nil)			{}
+						XCallback4()							{}
 	
 #if __MWERKS__ == 0x2405		// $$$ Pro 7 messes up copy ctors when a template method is present
 						template <typename R, typename A1, typename A2, typename A3, typename A4>
-						XCallback4(R (*function)(A1, A2, A3, A4)) : mCallback(new Internals::XCCallback4<R (*)(A1, A2, A3, A4), RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>(function))	{}
+						XCallback4(R (*function)(A1, A2, A3, A4))	{this->DoInitFunction(function, Internals::XInlineTag<Internals::XCanInlineFunction<R (*)(A1, A2, A3, A4)>::value>());}
 #else
 						template <class FUNCTION>
-						XCallback4(FUNCTION function) : mCallback(new Internals::XCCallback4<FUNCTION, RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>(function))	{}
+						XCallback4(FUNCTION function)			{this->DoInitFunction(function, Internals::XInlineTag<Internals::XCanInlineFunction<FUNCTION>::value>());}
 #endif
 
 						template <class OBJECT, class METHOD>
-						XCallback4(OBJECT* object, METHOD method) : mCallback(new Internals::XObjCallback4<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>(object, method))	{}
+						XCallback4(OBJECT* object, METHOD method)	{this->DoInitMethod(object, method, Internals::XInlineTag<Internals::XCanInlineMethod<OBJECT, METHOD>::value>());}
 						
-						XCallback4(Helper* callback, int, int) : mCallback(callback)	{ASSERT(callback != nil);}
+						XCallback4(Helper* callback, int, int)	{this->DoInitHelper(callback);}
 	
-						XCallback4(const XCallback4& rhs)		{if (rhs.mCallback != nil) rhs.mCallback->AddReference(); mCallback = rhs.mCallback;}
+						XCallback4(const XCallback4& rhs) : mData(rhs.mData)	{}
 						
-			XCallback4& operator=(const XCallback4& rhs) 		{if (mCallback != rhs.mCallback) {if (rhs.mCallback != nil) rhs.mCallback->AddReference(); if (mCallback != nil) mCallback->RemoveReference(); mCallback = rhs.mCallback;} return *this;}
+			XCallback4& operator=(const XCallback4& rhs) 		{mData = rhs.mData; return *this;}
+
 						template <class OBJECT, class METHOD>
 			void 		Set(OBJECT* object, METHOD method) 		{(void) this->operator=(XCallback4(object, method));}
 
-
 //-----------------------------------
 //	API
 //
 public:
-			RETURN_TYPE operator()(ARG1 arg1, ARG2 arg2, ARG3 arg3, ARG4 arg4) const	{ASSERT(mCallback != nil); return mCallback->Call(arg1, arg2, arg3, arg4);}
-
-			bool 		IsValid() const							{return mCallback != nil;}
+			RETURN_TYPE operator()(ARG1 arg1, ARG2 arg2, ARG3 arg3, ARG4 arg4) const	{ASSERT(mData.GetInvoker() != nil); return mData.GetInvoker()(mData.GetStorage(), arg1, arg2, arg3, arg4);}
 
-			bool 		operator==(const XCallback4& rhs) const	{return (mCallback == nil && rhs.mCallback == nil) || (mCallback != nil && mCallback->Equal(rhs.mCallback));}
+			bool 		IsValid() const							{return mData.GetInvoker() != nil;}
+			
+			bool 		operator==(const XCallback4& rhs) const	{return mData == rhs.mData;}
 			bool 		operator!=(const XCallback4& rhs) const	{return !this->operator==(rhs);}
-			bool 		operator<(const XCallback4& rhs) const	{return mCallback < rhs.mCallback;}
+			bool 		operator<(const XCallback4& rhs) const	{return mData < rhs.mData;}
+
+//-----------------------------------
+//	Internal API
+//
+private:
+						template <class FUNCTION>
+			void 		DoInitFunction(FUNCTION function, Internals::XInlineTag<true>)	{mData.InitFunction(&Internals::XCInvoker4<FUNCTION, RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>::Invoke, function);}
+
+						template <class FUNCTION>
+			void 		DoInitFunction(FUNCTION function, Internals::XInlineTag<false>)	{this->DoInitHelper(new Internals::XCCallback4<FUNCTION, RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>(function));}
+
+						template <class OBJECT, class METHOD>
+			void 		DoInitMethod(OBJECT* object, METHOD method, Internals::XInlineTag<true>)	{mData.InitMethod(&Internals::XObjInvoker4<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>::Invoke, object, method);}
+
+						template <class OBJECT, class METHOD>
+			void 		DoInitMethod(OBJECT* object, METHOD method, Internals::XInlineTag<false>)	{this->DoInitHelper(new Internals::XObjCallback4<OBJECT, METHOD, RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>(object, method));}
+
+			void 		DoInitHelper(Helper* callback)			{mData.InitHelper(&Internals::XHelperInvoker4<RETURN_TYPE, ARG1, ARG2, ARG3, ARG4>::Invoke, callback);}
 
 //-----------------------------------
 //	Member Data
 //
 private:
-	Helper*	mCallback;
+	Internals::XCallbackData<Invoker, Helper>	mData;
 };
 
 
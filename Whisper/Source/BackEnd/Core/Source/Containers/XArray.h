@@ -129,6 +129,67 @@ public:
 									
 			void 		Clear()									{this->SetShape(kZeroRect);}
 	//@}
+
+	//! @name Fast Access
+	//@{
+			const T& 	GetUnsafe(int32 col, int32 row) const	{return mElements[(col - mShape.left) + (row - mShape.top)*(mShape.right - mShape.left)];}
+			T& 			GetUnsafe(int32 col, int32 row)			{return mElements[(col - mShape.left) + (row - mShape.top)*(mShape.right - mShape.left)];}
+						/**< Like operator() except that the indices are never checked (not
+						even in debug builds) so use these in tight loops that have already
+						validated their indices. */
+
+			const T* 	GetRowPtr(int32 row) const				{ASSERT(row >= mShape.top && row < mShape.bottom); return mElements + (row - mShape.top)*mShape.GetWidth();}
+			T* 			GetRowPtr(int32 row)					{ASSERT(row >= mShape.top && row < mShape.bottom); return mElements + (row - mShape.top)*mShape.GetWidth();}
+						/**< Returns a pointer to the first element in the row (ie the element
+						at GetShape().left). Rows are contiguous and the array is stored in
+						row major order so GetRowPtr(row) + GetWidth() == GetRowPtr(row + 1). */
+
+			const T* 	GetBuffer() const						{return mElements;}
+			T* 			GetBuffer()								{return mElements;}
+	//@}
+
+	//! @name Bulk Operations
+	//@{
+			template <class UNARY>
+			void 		Transform(UNARY op)
+						{
+							T* elements = mElements;
+							int32 count = mShape.GetArea();
+							for (int32 index = 0; index < count; ++index)		// simple counted loop so the compiler can vectorize it
+								elements[index] = op(elements[index]);
+						}
+						/**< Replaces each element with op(element). */
+
+			template <class BINARY>
+			T 			Reduce(const T& init, BINARY op) const
+						{
+							const T* elements = mElements;
+							int32 count = mShape.GetArea();
+							int32 index = 0;
+
+							T result = init;
+							if (count >= 8) {								// use four independent accumulators to break the dependency chain
+								T a0 = op(elements[0], elements[1]), a1 = op(elements[2], elements[3]);
+								T a2 = op(elements[4], elements[5]), a3 = op(elements[6], elements[7]);
+								for (index = 8; index + 4 <= count; index += 4) {
+									a0 = op(a0, elements[index]);
+									a1 = op(a1, elements[index + 1]);
+									a2 = op(a2, elements[index + 2]);
+									a3 = op(a3, elements[index + 3]);
+								}
+								result = op(result, op(op(a0, a1), op(a2, a3)));
+							}
+
+							for (; index < count; ++index)
+								result = op(result, elements[index]);
+
+							return result;
+						}
+						/**< Returns op(...op(op(init, e0), e1)..., eN). Note that op must be
+						associative and commutative because the elements are not combined
+						in order (eg use std::plus<float>() to sum a depth buffer or a
+						functor that returns the smaller argument to find the minimum). */
+	//@}
 			
 	//! @name Comparison Operators
 	//@{
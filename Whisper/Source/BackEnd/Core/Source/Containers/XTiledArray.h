@@ -0,0 +1,162 @@
+/*
+ *  File:       XTiledArray.h
+ *  Summary:   	2D array stored in square blocks to improve locality for neighborhood access.
+ *  Written by: Jesse Jones
+ *
+ *	Notes:		XArray stores its elements in row major order so code that looks at an
+ *				element's neighbors above and below (eg a stencil over a depth buffer)
+ *				touches a different cache line for every row. XTiledArray stores the
+ *				elements in 8x8 blocks so most neighbors are within a cache line or two.
+ *				Whether this is actually a win depends heavily on the processor: the
+ *				hardware prefetchers on newer machines often make the row major layout
+ *				just as fast (and XArray::GetRowPtr is always faster for scanline loops)
+ *				so run XArrayUnitTest's stencil timings before switching.
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XTiledArray.h,v $
+ */
+
+#pragma once
+
+#include <XArray.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class XTiledArray
+//!		2D array stored in square blocks to improve locality for neighborhood access.
+// ===================================================================================
+template <class T> class XTiledArray {
+	
+//-----------------------------------
+//	Types
+//
+public:
+	typedef T					value_type;
+	typedef value_type& 		reference;
+    typedef const value_type&	const_reference;    
+    typedef value_type*			pointer;
+    typedef const value_type*	const_pointer;
+
+	typedef STD::size_t			size_type;
+	typedef STD::ptrdiff_t		difference_type;
+
+	enum {kBlockShift = 3, kBlockSize = 1 << kBlockShift, kBlockMask = kBlockSize - 1, kBlockArea = kBlockSize*kBlockSize};
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+			 			~XTiledArray();
+
+						XTiledArray(const XSize& dim = kZeroSize, const T& initial = T());
+						
+						XTiledArray(const XRect& shape, const T& initial = T());
+						/**< topLeft is taken to be the minimum elements indices.
+						botRight is taken to be one past the maximum element indices. */
+
+	explicit			XTiledArray(const XArray<T>& rhs);
+
+						XTiledArray(const XTiledArray& rhs);
+						
+			XTiledArray& operator=(const XTiledArray& rhs);
+			XTiledArray& operator=(const XArray<T>& rhs);
+																		
+//-----------------------------------
+//	API
+//
+public:
+	//! @name Dimensions
+	//@{		
+			XRect	 	GetShape() const						{return mShape;}
+			
+			XSize 		GetSize() const							{return mShape.GetSize();}
+			int32 		GetWidth() const						{return mShape.GetWidth();}
+			int32 		GetHeight() const						{return mShape.GetHeight();}
+			
+			bool 		IsEmpty() const							{return mShape == kZeroRect;}
+			
+			void 		SetShape(const XRect& shape, const T& newValue = T());
+						/**< Unlike XArray the old elements are not preserved. */
+	//@}
+
+	//! @name Access
+	//@{
+			const T& 	operator()(int32 col, int32 row) const;
+			T& 			operator()(int32 col, int32 row);
+						
+			const T& 	Get(int32 col, int32 row) const			{return this->operator()(col, row);}
+			T& 			Get(int32 col, int32 row)				{return this->operator()(col, row);}
+						
+			const T& 	GetUnsafe(int32 col, int32 row) const	{return mElements[this->DoGetIndex(col, row)];}
+			T& 			GetUnsafe(int32 col, int32 row)			{return mElements[this->DoGetIndex(col, row)];}
+						/**< No range checking (even in debug builds). */
+
+			void 		Set(const T& elem)						{std::fill_n(mElements, this->DoGetCapacity(), elem);}
+			void 		Set(int32 col, int32 row, const T& elem){this->operator()(col, row) = elem;}
+
+			void 		CopyTo(XArray<T>& array) const;
+						/**< Resizes array to our shape and copies our elements into it. */
+	//@}
+
+	//! @name Bulk Operations
+	//@{
+			template <class UNARY>
+			void 		Transform(UNARY op)
+						{
+							T* elements = mElements;
+							int32 count = this->DoGetCapacity();		// the padding is transformed too which is harmless and keeps the loop simple
+							for (int32 index = 0; index < count; ++index)
+								elements[index] = op(elements[index]);
+						}
+						/**< Replaces each element with op(element). */
+	//@}
+			
+	//! @name Comparison Operators
+	//@{
+			bool 		operator==(const XTiledArray& rhs) const;
+			bool 		operator!=(const XTiledArray& rhs) const	{return !this->operator==(rhs);}
+	//@}
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			int32 		DoGetIndex(int32 col, int32 row) const
+						{
+							int32 h = col - mShape.left;
+							int32 v = row - mShape.top;
+							return (((v >> kBlockShift)*mBlocksPerRow + (h >> kBlockShift)) << 2*kBlockShift) + ((v & kBlockMask) << kBlockShift) + (h & kBlockMask);
+						}
+						
+			int32 		DoGetCapacity() const					{return mBlocksPerRow*mBlocksPerCol*kBlockArea;}
+			
+			void 		DoReset(const XRect& shape, const T& initial);
+
+//-----------------------------------
+//	Member Data
+//
+private:
+	XRect	mShape;
+	int32	mBlocksPerRow;
+	int32	mBlocksPerCol;
+	T*		mElements;			// row major array of kBlockSize x kBlockSize blocks (the last row and column of blocks are padded)
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
+
+#include <XTiledArray.inc>
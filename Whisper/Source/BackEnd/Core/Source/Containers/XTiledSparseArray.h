@@ -0,0 +1,361 @@
+/*
+ *  File:		XTiledSparseArray.h
+ *  Summary:	Sparse 2D array that stores dense tiles in a hash table.
+ *  Written by:	Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XTiledSparseArray.h,v $
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <XRect.h>
+
+namespace Whisper {
+
+
+//-----------------------------------
+//	Forward References
+//
+class XInStream;
+class XOutStream;
+
+template <class T> class XTiledSparseArray;
+
+template <class T> XInStream& 	operator>>(XInStream& stream, XTiledSparseArray<T>& c);
+template <class T> XOutStream& 	operator<<(XOutStream& stream, const XTiledSparseArray<T>& c);
+
+
+// ===================================================================================
+//	class XTiledSparseArray
+//!		Sparse 2D array that stores dense tiles in a hash table.
+/*!		This has the same interface as XSparseArray, but instead of a std::map keyed by
+ *		XPoint the elements are stored in 16x16 tiles that live in an open addressing hash
+ *		table keyed by the tile coordinate. Lookups are a hash and (usually) one probe
+ *		instead of a tree walk and neighboring elements share a tile so scanning rows or
+ *		rectangles is cheap. The trade off is that a lone element costs a full tile so
+ *		this is best suited for arrays whose elements are clumped together or that are
+ *		more than a fraction of a percent full. The streaming format is identical to
+ *		XSparseArray's so the two classes can read each other's data. */
+// ===================================================================================
+template <class T> class XTiledSparseArray {
+
+//-----------------------------------
+//	Types
+//
+public:
+	typedef T					value_type;
+	typedef value_type& 		reference;
+    typedef const value_type&	const_reference;
+    typedef value_type*			pointer;
+    typedef const value_type*	const_pointer;
+
+	typedef STD::size_t			size_type;
+	typedef STD::ptrdiff_t		difference_type;
+
+	enum {kTileShift = 4, kTileSize = 1 << kTileShift, kTileMask = kTileSize - 1, kTileArea = kTileSize*kTileSize};
+
+	struct SMemoryUsage {
+		uint32	tiles;				//!< number of allocated tiles
+		uint32	slots;				//!< size of the hash table
+		uint32	elements;			//!< number of elements that don't equal the default value
+		uint32	bytes;				//!< total number of bytes used by the array (including the object itself)
+	};
+
+protected:
+	struct STile {
+		int32	col;				// tile coordinates (ie element coordinates >> kTileShift)
+		int32	row;
+		T*		elements;			// kTileArea elements in row major order, nil if the slot is empty
+	};
+
+	typedef std::vector<STile> TileTable;
+
+	struct SLessTile {
+		bool operator()(const STile* lhs, const STile* rhs) const	{return lhs->row < rhs->row || (lhs->row == rhs->row && lhs->col < rhs->col);}
+	};
+
+//-----------------------------------
+//	Iterators
+//
+public:
+	// ----- iterator -----
+    class const_iterator;
+	class iterator : public std::iterator<std::forward_iterator_tag, T> {
+
+		friend class XTiledSparseArray;
+		friend class const_iterator;
+
+	protected:
+					iterator(XTiledSparseArray* array, uint32 slot, uint32 index) : mArray(array), mSlot(slot), mIndex(index) {}
+
+	public:
+					iterator() : mArray(nil) 					{}
+
+		reference 	operator*() const							{ASSERT(mSlot < mArray->mTiles.size()); return mArray->mTiles[mSlot].elements[mIndex];}
+
+		iterator& 	operator++()								{mArray->DoAdvance(mSlot, mIndex); return *this;}
+		iterator 	operator++(int)								{iterator temp = *this; ++*this; return temp;}
+
+		int32 		GetCol() const								{ASSERT(mSlot < mArray->mTiles.size()); return mArray->mTiles[mSlot].col*kTileSize +(int32) (mIndex & kTileMask);}
+		int32 		GetRow() const								{ASSERT(mSlot < mArray->mTiles.size()); return mArray->mTiles[mSlot].row*kTileSize +(int32) (mIndex >> kTileShift);}
+
+		bool 		operator==(const iterator& rhs) const		{ASSERT(mArray == rhs.mArray); return mSlot == rhs.mSlot && mIndex == rhs.mIndex;}
+		bool 		operator!=(const iterator& rhs) const		{return !(*this == rhs);}
+
+	protected:
+		XTiledSparseArray*	mArray;
+		uint32				mSlot;
+		uint32				mIndex;
+	};
+
+	// ----- const_iterator -----
+	class const_iterator : public std::iterator<std::forward_iterator_tag, T> {
+
+		friend class XTiledSparseArray;
+
+	protected:
+						const_iterator(const XTiledSparseArray* array, uint32 slot, uint32 index) : mArray(array), mSlot(slot), mIndex(index) {}
+
+	public:
+						const_iterator() : mArray(nil) 				{}
+						const_iterator(const iterator& rhs) : mArray(rhs.mArray), mSlot(rhs.mSlot), mIndex(rhs.mIndex) {}
+
+		const_reference operator*() const							{ASSERT(mSlot < mArray->mTiles.size()); return mArray->mTiles[mSlot].elements[mIndex];}
+
+		const_iterator& operator++()								{mArray->DoAdvance(mSlot, mIndex); return *this;}
+		const_iterator 	operator++(int)								{const_iterator temp = *this; ++*this; return temp;}
+
+		int32 			GetCol() const								{ASSERT(mSlot < mArray->mTiles.size()); return mArray->mTiles[mSlot].col*kTileSize +(int32) (mIndex & kTileMask);}
+		int32 			GetRow() const								{ASSERT(mSlot < mArray->mTiles.size()); return mArray->mTiles[mSlot].row*kTileSize +(int32) (mIndex >> kTileShift);}
+
+		bool 			operator==(const const_iterator& rhs) const	{ASSERT(mArray == rhs.mArray); return mSlot == rhs.mSlot && mIndex == rhs.mIndex;}
+		bool 			operator!=(const const_iterator& rhs) const	{return !(*this == rhs);}
+
+	protected:
+		const XTiledSparseArray*	mArray;
+		uint32						mSlot;
+		uint32						mIndex;
+	};
+
+	// ----- const_span_iterator -----
+	//! Walks a rectangle in row major order a run of elements at a time.
+	/*! Each span covers the part of a row that falls within one tile so a whole row
+	 *	of a rectangle can be processed with one hash lookup per kTileSize elements.
+	 *	If the tile hasn't been allocated GetElements returns nil (all of the elements
+	 *	in the span equal the default value). */
+	class const_span_iterator {
+
+		friend class XTiledSparseArray;
+
+	protected:
+						const_span_iterator(const XTiledSparseArray* array, const XRect& rect, int32 row) : mArray(array), mRect(rect), mCol(rect.left), mRow(row) {this->DoFind();}
+
+	public:
+						const_span_iterator() : mArray(nil)			{}
+
+		int32 			GetCol() const								{return mCol;}
+		int32 			GetRow() const								{return mRow;}
+		uint32 			GetCount() const							{return mCount;}
+						/**< Number of elements in the span (1 to kTileSize). */
+
+		const T* 		GetElements() const							{return mElements;}
+						/**< Returns nil if all of the elements in the span are sparse. */
+
+		const_reference operator[](uint32 index) const				{ASSERT(index < mCount); return mElements != nil ? mElements[index] : mArray->mDefaultValue;}
+
+		const_span_iterator& operator++()
+			{
+				ASSERT(mRow < mRect.bottom);
+
+				mCol += (int32) mCount;
+				if (mCol >= mRect.right) {
+					mCol = mRect.left;
+					++mRow;
+				}
+				this->DoFind();
+
+				return *this;
+			}
+		const_span_iterator operator++(int)							{const_span_iterator temp = *this; ++*this; return temp;}
+
+		bool 			operator==(const const_span_iterator& rhs) const	{ASSERT(mArray == rhs.mArray); return mRow == rhs.mRow && mCol == rhs.mCol;}
+		bool 			operator!=(const const_span_iterator& rhs) const	{return !(*this == rhs);}
+
+	protected:
+		void			DoFind()
+			{
+				if (mRow < mRect.bottom && mCol < mRect.right) {
+					int32 offset = mCol & kTileMask;
+					mCount = (uint32) Min(kTileSize - offset, mRect.right - mCol);
+
+					const STile* tile = mArray->DoFindTile(mCol >> kTileShift, mRow >> kTileShift);
+					mElements = tile != nil ? tile->elements + ((mRow & kTileMask) << kTileShift) + offset : nil;
+
+				} else {
+					mCol = mRect.left;
+					mRow = mRect.bottom;
+					mCount = 0;
+					mElements = nil;
+				}
+			}
+
+	protected:
+		const XTiledSparseArray*	mArray;
+		XRect						mRect;
+		int32						mCol;
+		int32						mRow;
+		uint32						mCount;
+		const T*					mElements;
+	};
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+			 			~XTiledSparseArray();
+
+						XTiledSparseArray(const T& initial = T());
+
+						XTiledSparseArray(const XSize& dim, const T& initial = T());
+						/**< Sets mDefaultValue to initial. */
+
+						XTiledSparseArray(const XRect& shape, const T& initial = T());
+						/**< topLeft is taken to be the minimum elements indices.
+						botRight is taken to be one past the maximum element indices. */
+
+						XTiledSparseArray(const XTiledSparseArray& rhs);
+
+			XTiledSparseArray& operator=(const XTiledSparseArray& rhs);
+
+//-----------------------------------
+//	API
+//
+public:
+	//! @name Dimensions
+	//@{
+			XRect	 	GetShape() const						{return mShape;}
+
+			XSize 		GetDim() const							{return mShape.GetSize();}
+
+			void 		SetShape(const XRect& shape);
+						/**< Elements outside the new shape are discarded. */
+
+			void 		SetDim(const XSize& dim)				{this->SetShape(XRect(kZeroPt, dim));}
+	//@}
+
+	//! @name Access
+	//@{
+			const T& 	operator()(int32 col, int32 row) const;
+
+			T& 			operator()(int32 col, int32 row);
+						/**< May allocate a new tile. */
+
+			void 		Force(int32 col, int32 row, const T& elem);
+						/**< If the (col, row) is outside the array the array will be expanded. */
+
+			void 		Erase(const iterator& iter)				{*iter = mDefaultValue;}
+
+			void 		Clear();
+	//@}
+
+	//! @name Bulk Access
+	//@{
+			const_span_iterator begin_spans(const XRect& rect) const	{ASSERT(mShape.Contains(rect)); return const_span_iterator(this, rect, rect.top);}
+								/**< To scan a row use XRect(left, row, right, row + 1). */
+
+			const_span_iterator end_spans(const XRect& rect) const		{ASSERT(mShape.Contains(rect)); return const_span_iterator(this, rect, rect.bottom);}
+
+			void 		CopyRow(int32 row, int32 left, int32 right, T* dst) const;
+						/**< Copies the elements in [left, right) into dst. */
+
+			void 		Fill(const XRect& rect, const T& elem);
+						/**< Sets every element in rect to elem (tiles aren't allocated
+						if elem is the default value). */
+	//@}
+
+	//! @name Misc
+	//@{
+			bool 		IsSparse(int32 col, int32 row) const	{return (*this)(col, row) == mDefaultValue;}
+						/**< Returns true if the element equals mDefaultValue. */
+
+			iterator 	Find(int32 col, int32 row);
+						/**< If the element isn't sparse the returned iterator points to it.
+						Otherwise the iterator == end(). */
+
+			const_iterator Find(int32 col, int32 row) const;
+
+			void 		Reduce();
+						/**< Frees tiles whose elements all equal mDefaultValue. */
+
+			SMemoryUsage GetMemoryUsage() const;
+	//@}
+
+	//! @name Iterating
+	//@{
+			iterator 		begin()								{uint32 slot = 0, index = 0; this->DoFirst(slot, index); return iterator(this, slot, index);}
+							/**< Note that these only return elements that do not equal mDefaultValue.
+							Elements are returned in tile order, not row major order. */
+
+			iterator 		end()								{return iterator(this, mTiles.size(), 0);}
+
+			const_iterator 	begin() const						{uint32 slot = 0, index = 0; this->DoFirst(slot, index); return const_iterator(this, slot, index);}
+
+			const_iterator 	end() const							{return const_iterator(this, mTiles.size(), 0);}
+	//@}
+
+	//! @name Streaming
+	//@{
+#if MSVC >= 1100
+	friend 	XInStream& 	operator>>(XInStream& stream, XTiledSparseArray<T>& c);	// these are defined in XStreaming.h
+
+	friend	XOutStream& operator<<(XOutStream& stream, const XTiledSparseArray<T>& c);
+#else
+	friend 	XInStream& 	operator>> <T>(XInStream& stream, XTiledSparseArray<T>& c);	// these are defined in XStreaming.h
+
+	friend	XOutStream& operator<< <T>(XOutStream& stream, const XTiledSparseArray<T>& c);
+#endif
+	//@}
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+	static	uint32 		DoHash(int32 col, int32 row)			{uint32 h = (uint32) col*0x9E3779B1UL ^ (uint32) row*0x85EBCA6BUL; return h ^ (h >> 16);}
+
+			const STile* DoFindTile(int32 col, int32 row) const;
+
+			STile& 		DoGetTile(int32 col, int32 row);
+
+			void 		DoRehash(uint32 capacity);
+
+			void 		DoRelease();
+
+			void 		DoFirst(uint32& slot, uint32& index) const;
+
+			void 		DoAdvance(uint32& slot, uint32& index) const;
+
+			void 		DoGetSortedTiles(std::vector<const STile*>& tiles) const;
+
+//-----------------------------------
+//	Member Data
+//
+protected:
+	XRect			mShape;
+	TileTable		mTiles;				// size is zero or a power of two
+	uint32			mTileCount;			// number of allocated tiles
+	mutable uint32	mLastSlot;			// speeds up scans (most lookups hit the same tile as the last one)
+	T				mDefaultValue;
+};
+
+
+}	// namespace Whisper
+
+
+#include <XTiledSparseArray.inc>
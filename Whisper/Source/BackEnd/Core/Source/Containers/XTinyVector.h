@@ -22,6 +22,8 @@
 #pragma once
 
 #include <Iterator>
+#include <memory>
+#include <new>
 
 #include <XDebug.h>
 #include <XTypes.h>
@@ -29,11 +31,44 @@
 namespace Whisper {
 
 
+// ===================================================================================
+//	class XTinyStorage
+//!		Raw suitably aligned storage for BYTES bytes (used by XTinyVector).
+// ===================================================================================
+template <uint32 BYTES> class XTinyStorage {
+
+public:
+			void* 		GetBuffer()								{return mData.bytes;}
+			const void* GetBuffer() const						{return mData.bytes;}
+
+protected:
+	union {
+		uint8		bytes[BYTES];
+		double		alignDouble;				// these force the buffer to be aligned for anything a tiny vector will hold
+		int64		alignInt;
+		void*		alignPtr;
+	} mData;
+};
+
+
+template <> class XTinyStorage<0> {			// zero sized arrays are illegal and we don't want to pay for storage we'll never use
+
+public:
+			void* 		GetBuffer()								{return nil;}
+			const void* GetBuffer() const						{return nil;}
+};
+
+
 // ===================================================================================
 //	class XTinyVector
 //!		Simple very lightweight vector class.
+/*!		Up to N elements are stored inside the object so small vectors (eg scratch buffers
+ *		on the stack) don't touch the heap at all. Larger vectors use the heap and grow
+ *		geometrically. Note that, like new T[n], elements created by the size constructor
+ *		and resize(n) are default initialized so PODs are left uninitialized (use the
+ *		versions that take a value to fill the elements). */
 // ===================================================================================
-template <class T> class XTinyVector {
+template <class T, uint32 N = 0> class XTinyVector {
 
 //-----------------------------------
 //	Types
@@ -63,11 +98,14 @@ public:
 //	Initialization/Destruction
 //
 public:
-						~XTinyVector()							{delete [] mData;}
+						~XTinyVector();
 							
-						XTinyVector()							{mSize = 0; mData = new T[mSize];}
+						XTinyVector();
+
+	explicit			XTinyVector(uint32 size);
+						/**< Elements are default initialized (PODs aren't initialized at all). */
 
-	explicit			XTinyVector(uint32 size)				{mSize = size; mData = new T[mSize];}
+						XTinyVector(uint32 size, const T& value);
 
 						XTinyVector(const XTinyVector& rhs);
 						
@@ -80,6 +118,19 @@ public:
 	// ----- Size -----
 			bool 		empty() const							{return mSize == 0;}
 			uint32 		size() const							{return mSize;}
+			uint32 		capacity() const						{return mCapacity;}
+			bool 		is_inline() const						{return mData == mStorage.GetBuffer();}
+						/**< Returns true if the elements are stored inside the object. */
+
+			void 		reserve(uint32 capacity);
+
+			void 		resize(uint32 size);
+						/**< New elements are default initialized. */
+
+			void 		resize(uint32 size, const T& value);
+
+			void 		clear()									{this->DoDestroy(mData, mSize); mSize = 0;}
+						/**< Note that this doesn't release the heap buffer. */
 						
 	// ----- Access -----
 			T&			operator[](uint32 index)				{ASSERT(index < mSize); return mData[index];}	
@@ -94,6 +145,18 @@ public:
 			T* 			buffer() 								{return mData;}
 			const T* 	buffer() const							{return mData;}
 
+	// ----- Mutators -----
+			void 		push_back(const T& value);
+
+			void 		pop_back()								{ASSERT(mSize > 0); mData[--mSize].~T();}
+
+			iterator 	insert(iterator pos, const T& value);
+						/**< Returns an iterator pointing to the new element. */
+
+			iterator 	erase(iterator pos)						{return this->erase(pos, pos + 1);}
+			iterator 	erase(iterator first, iterator last);
+						/**< Returns an iterator pointing to the element after the erased elements. */
+
 	// ----- Comparisons -----
 			bool 		operator==(const XTinyVector& rhs) const;
 			bool 		operator!=(const XTinyVector& rhs) const	{return !this->operator==(rhs);}
@@ -114,19 +177,43 @@ public:
 			const_reverse_iterator 	rend() const				{return const_reverse_iterator(this->begin());}
 
 	// ----- Misc -----
-			void 					swap(XTinyVector<T>& rhs);
+			void 					swap(XTinyVector& rhs);
+									/**< Constant time if both vectors are on the heap. This is
+									also the cheap way to move a vector into another. */
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		DoReserve(uint32 capacity);
+			void 		DoFreeBuffer();
+
+	static	void 		DoConstruct(T* first, uint32 count);
+
+	static	void 		DoDestroy(T* first, uint32 count);
 
 //-----------------------------------
 //	Member Data
 //
 protected:
-	uint32	mSize;
-	T*		mData;
+	uint32					mSize;
+	uint32					mCapacity;
+	T*						mData;				// points into mStorage or to a heap buffer
+	XTinyStorage<N*sizeof(T)>	mStorage;
 };
 
 
+// ===================================================================================
+//	Global Functions
+// ===================================================================================
+template <class T, uint32 N>
+inline void swap(XTinyVector<T, N>& lhs, XTinyVector<T, N>& rhs)
+{
+	lhs.swap(rhs);
+}
+
+
 }	// namespace Whisper
 
 
 #include <XTinyVector.inc>
-
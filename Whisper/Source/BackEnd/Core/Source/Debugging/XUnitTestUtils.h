@@ -0,0 +1,38 @@
+/*
+ *  File:       XUnitTestUtils.h
+ *  Summary:   	Helpers shared by the unit tests and benchmarks.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XUnitTestUtils.h,v $
+ */
+
+#pragma once
+
+#include <XNumbers.h>
+
+#if DEBUG
+namespace Whisper {
+
+
+// ===================================================================================
+//	Timing
+// ===================================================================================
+inline double	GetRate(double count, MilliSecond elapsed, double units = 1.0)	{return count/(units*Max(elapsed, 1L)/1000.0);}
+				// Returns the number of units processed per second, eg pass 1.0e6
+				// for units to get millions per second. Elapsed times of zero are
+				// treated as one millisecond.
+
+
+// ===================================================================================
+//	Test Data
+// ===================================================================================
+inline void		FillRandom(uint8* buffer, uint32 bytes)							{for (uint32 i = 0; i < bytes; ++i) buffer[i] = (uint8) Random(256L);}
+
+
+}		// namespace Whisper
+#endif	// DEBUG
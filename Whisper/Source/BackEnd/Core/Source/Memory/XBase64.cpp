@@ -17,189 +17,317 @@
 #include <XWhisperHeader.h>
 #include <XBase64.h>
 
+#include <cstring>
+#include <stdexcept>
+
+#include <XLocker.h>
 #include <XNumbers.h>
+#include <XStringUtils.h>
+
+#if WHISPER_SSSE3
+	#include <tmmintrin.h>
+#endif
 
 namespace Whisper {
 
 
+//-----------------------------------
+//	Internal Constants
+//
+const uint8 kInvalidChar = 0xFF;
+const uint8 kPadChar     = 0xFE;
+
+
 //-----------------------------------
 //	Internal Variables
 //
-static char encodingTable[64] = {
+static const char kEncodingTable[64] = {
 	'A','B','C','D','E','F','G','H','I','J','K','L','M','N','O','P',
 	'Q','R','S','T','U','V','W','X','Y','Z','a','b','c','d','e','f',
 	'g','h','i','j','k','l','m','n','o','p','q','r','s','t','u','v',
 	'w','x','y','z','0','1','2','3','4','5','6','7','8','9','+','/'
 };
 
+static const uint8 kDecodingTable[256] = {		// kInvalidChar for characters outside the alphabet, kPadChar for '='
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFE, 0xFF, 0xFF,
+	0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+	0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
 
 // ===================================================================================
 //	Internal Functions
-//		This code is based on Dave Winer's code from "www.scripting.com/midas/base64".
+//		The scalar code was originally based on Dave Winer's code from 
+//		"www.scripting.com/midas/base64". The SSSE3 code uses Wojciech Mula's
+//		pshufb based algorithms (see "http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html").
 // ===================================================================================
 
 //---------------------------------------------------------------
 //
-// Encode
+// ThrowBadBase64
 //
 //---------------------------------------------------------------
-static std::string Encode(const void* buffer, uint32 bytes, int16 linelength) 
-{ 
-	PRECONDITION(linelength <= 76);		// JDJ required by RFC2045 
-
-	std::string text;
-	
-	uint32 inbuf[3], outbuf[4];
-	int16 charsonline = 0;
-	uint32 ixtext = 0;
-	uint32 lentext = bytes;
-	
-	const unsigned char* data = static_cast<const unsigned char*>(buffer);
-
-	while (true) {
-		if (lentext <= ixtext)
-			break;
-
-		for (uint32 i = 0; i < 3; i++) { 
-			uint32 ix = ixtext + i;
-
-			if (ix < lentext)
-				inbuf [i] = data[ix];
-			else
-				inbuf [i] = 0;
-		}
-
-		outbuf[0] = (inbuf[0] & 0xFC) >> 2;
-		outbuf[1] = ((inbuf[0] & 0x03) << 4) | ((inbuf[1] & 0xF0) >> 4);
-		outbuf[2] = ((inbuf[1] & 0x0F) << 2) | ((inbuf[2] & 0xC0) >> 6);
-		outbuf[3] = inbuf[2] & 0x3F;
-
-		uint32 origsize = text.length();
-		text.resize(origsize + 4);				// $$ this looks inefficient
-
-		uint32 ctremaining = lentext - ixtext;
-
-		int16 ctcopy = 4;
-		switch (ctremaining) {
-			case 1: 
-				ctcopy = 2; 
-				break;
-
-			case 2: 
-				ctcopy = 3; 
-				break;
-		} 
-
-		for (uint32 i = 0; i < ctcopy; i++)	
-			text[origsize + i] = encodingTable[outbuf[i]];
-
-		for (uint32 i = ctcopy; i < 4; i++)
-			text[origsize + i] = '=';
-
-		ixtext += 3;
-		charsonline += 4;
-
-		if (linelength > 0) { 					// DW 4/8/97 -- 0 means no line breaks
-			if (charsonline >= linelength) {
-				charsonline = 0;
+static void ThrowBadBase64()
+{
+	throw std::invalid_argument(ToUTF8Str(LoadWhisperString(L"The base64 text was malformed.")));
+}
 
-				origsize = text.length();
-				text.resize(origsize + 1);
 
-				text[origsize] = '\n';
-			}
-		}
-	} 
+//---------------------------------------------------------------
+//
+// EncodeBlock
+//
+// Encodes count complete 3-byte quanta into 4*count characters.
+//
+//---------------------------------------------------------------
+static void EncodeBlock(const uint8* src, uint32 count, char* dst)
+{
+#if WHISPER_SSSE3
+	const __m128i shuffle  = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+	const __m128i mask0    = _mm_set1_epi32(0x0FC0FC00);
+	const __m128i mul0     = _mm_set1_epi32(0x04000040);
+	const __m128i mask1    = _mm_set1_epi32(0x003F03F0);
+	const __m128i mul1     = _mm_set1_epi32(0x01000010);
+	const __m128i fiftyOne = _mm_set1_epi8(51);
+	const __m128i twentySix = _mm_set1_epi8(26);
+	const __m128i thirteen = _mm_set1_epi8(13);
+	const __m128i offsets  = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, 
+										   '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+	while (count >= 6) {						// we load 16 bytes but only use 12 so we need 18 bytes to stay inside the buffer
+		__m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		in = _mm_shuffle_epi8(in, shuffle);	
+		
+		__m128i hi = _mm_mulhi_epu16(_mm_and_si128(in, mask0), mul0);		// split the 24 bit groups into four 6 bit indices
+		__m128i lo = _mm_mullo_epi16(_mm_and_si128(in, mask1), mul1);
+		__m128i indices = _mm_or_si128(hi, lo);
+		
+		__m128i reduced = _mm_subs_epu8(indices, fiftyOne);					// map the indices onto the offsets table
+		__m128i less = _mm_cmpgt_epi8(twentySix, indices);
+		reduced = _mm_or_si128(reduced, _mm_and_si128(less, thirteen));
+		
+		__m128i chars = _mm_add_epi8(_mm_shuffle_epi8(offsets, reduced), indices);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), chars);
+		
+		src += 12;
+		dst += 16;
+		count -= 4;
+	}
+#endif
 
-	return text;
+	while (count--) {
+		uint32 bits = (uint32) ((src[0] << 16) | (src[1] << 8) | src[2]);
+		
+		dst[0] = kEncodingTable[(bits >> 18) & 0x3F];
+		dst[1] = kEncodingTable[(bits >> 12) & 0x3F];
+		dst[2] = kEncodingTable[(bits >> 6) & 0x3F];
+		dst[3] = kEncodingTable[bits & 0x3F];
+		
+		src += 3;
+		dst += 4;
+	}
 }
 
 
 //---------------------------------------------------------------
 //
-// Decode
+// EncodeTail
+//
+// Encodes the last one or two bytes (with padding).
 //
 //---------------------------------------------------------------
-static XHandle Decode(const std::string& text) 
-{ 
-	XHandle data;
+static void EncodeTail(const uint8* src, uint32 bytes, char* dst)
+{
+	PRECONDITION(bytes == 1 || bytes == 2);
 	
-	uint32 inbuf[4], outbuf[3];
-	bool flendtext = false;
-
-	uint32 ixtext = 0;
-	uint32 lentext = text.length();
-	int16 ixinbuf = 0;
-
-	while (true) {
-		if (ixtext >= lentext)
-			break;
-
-		bool flignore = false;
-
-		char ch = text[ixtext++];
-		if (ch >= 'A' && ch <= 'Z')
-			ch = numeric_cast<char>(ch - 'A');
-
-		else if (ch >= 'a' && ch <= 'z')
-			ch = numeric_cast<char>(ch - 'a' + 26);
-
-		else if (ch >= '0' && ch <= '9')
-			ch = numeric_cast<char>(ch - '0' + 52);
-
-		else if (ch == '+')
-			ch = 62;
-
-		else if (ch == '=') 		// no op -- can't ignore this one
-			flendtext = true;
-
-		else if (ch == '/')
-			ch = 63;
-
-		else
-			flignore = true; 		// JDJ seems lame, but this is required by RFC2045
-
-		if (!flignore) {
-			int16 ctcharsinbuf = 3;
-			bool flbreak = false;
-
-			if (flendtext) {
-				if (ixinbuf == 0)
-					break;
-
-				if ((ixinbuf == 1) || (ixinbuf == 2))
-					ctcharsinbuf = 1;
-				else
-					ctcharsinbuf = 2;
+	uint32 bits = (uint32) (src[0] << 16);
+	if (bytes == 2)
+		bits |= (uint32) (src[1] << 8);
+	
+	dst[0] = kEncodingTable[(bits >> 18) & 0x3F];
+	dst[1] = kEncodingTable[(bits >> 12) & 0x3F];
+	dst[2] = bytes == 2 ? kEncodingTable[(bits >> 6) & 0x3F] : '=';
+	dst[3] = '=';
+}
 
-				ixinbuf = 3;
 
-				flbreak = true;
-			}
+//---------------------------------------------------------------
+//
+// DecodeBlock
+//
+// Decodes as many 16 character blocks as possible. Returns the
+// number of characters consumed (processing stops at the first
+// block that contains a character outside the base64 alphabet).
+//
+//---------------------------------------------------------------
+#if WHISPER_SSSE3
+static uint32 DecodeBlock(const char* src, uint32 chars, uint8* dst)
+{
+	const __m128i lutLo   = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m128i lutHi   = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i nibbles = _mm_set1_epi8(0x0F);
+	const __m128i slash   = _mm_set1_epi8(0x2F);
+	const __m128i merge0  = _mm_set1_epi32(0x01400140);
+	const __m128i merge1  = _mm_set1_epi32(0x00011000);
+	const __m128i pack    = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	const __m128i zero    = _mm_setzero_si128();
+
+	uint32 consumed = 0;
+	while (chars - consumed >= 16) {
+		__m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + consumed));
+		
+		__m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), nibbles);
+		__m128i loNibbles = _mm_and_si128(in, nibbles);
+		__m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+		__m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+		if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), zero)) != 0)
+			break;													// padding, line break, or garbage
+		
+		__m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(in, slash), hiNibbles));
+		__m128i sextets = _mm_add_epi8(in, roll);
+		
+		__m128i merged = _mm_madd_epi16(_mm_maddubs_epi16(sextets, merge0), merge1);
+		__m128i bytes = _mm_shuffle_epi8(merged, pack);
+		
+		int last = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8));		// only 12 of the 16 bytes are valid
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst), bytes);
+		std::memcpy(dst + 8, &last, 4);
+		
+		consumed += 16;
+		dst += 12;
+	}
+	
+	return consumed;
+}
+#endif
 
-			inbuf[ixinbuf++] = ch;
 
-			if (ixinbuf == 4) {
-				ixinbuf = 0;
+//---------------------------------------------------------------
+//
+// DecodeStrict
+//
+//---------------------------------------------------------------
+static uint32 DecodeStrict(const char* text, uint32 chars, uint8* dst)
+{
+	if (chars % 4 != 0)
+		ThrowBadBase64();
 
-				outbuf[0] = (inbuf[0] << 2) | ((inbuf[1] & 0x30) >> 4);
-				outbuf[1] = ((inbuf[1] & 0x0F) << 4) | ((inbuf[2] & 0x3C) >> 2);
-				outbuf[2] = ((inbuf[2] & 0x03) << 6) | (inbuf[3] & 0x3F);
+	const uint8* table = kDecodingTable;
+	uint8* start = dst;
+	
+	uint32 padding = 0;
+	if (chars > 0 && text[chars - 1] == '=')
+		padding = (chars > 1 && text[chars - 2] == '=') ? 2u : 1u;
+	uint32 body = padding > 0 ? chars - 4 : chars;		// the last quantum is handled separately if it's padded
+
+	uint32 i = 0;
+#if WHISPER_SSSE3
+	i = DecodeBlock(text, body, dst);
+	dst += 3*(i/4);
+#endif
 
-				uint32 origsize = data.GetSize();
-				data.SetSize(origsize + ctcharsinbuf);		// $$ this looks inefficient
+	for (; i < body; i += 4) {
+		uint32 a = table[(uint8) text[i]];
+		uint32 b = table[(uint8) text[i + 1]];
+		uint32 c = table[(uint8) text[i + 2]];
+		uint32 d = table[(uint8) text[i + 3]];
+		if ((a | b | c | d) >= 64)						// invalid characters and pads both have the high bits set
+			ThrowBadBase64();
+		
+		uint32 bits = (a << 18) | (b << 12) | (c << 6) | d;
+		dst[0] = (uint8) (bits >> 16);
+		dst[1] = (uint8) (bits >> 8);
+		dst[2] = (uint8) bits;
+		dst += 3;
+	}
+	
+	if (padding > 0) {
+		uint32 a = table[(uint8) text[body]];
+		uint32 b = table[(uint8) text[body + 1]];
+		uint32 c = padding == 1 ? table[(uint8) text[body + 2]] : 0;
+		if ((a | b | c) >= 64)
+			ThrowBadBase64();
+		
+		uint32 bits = (a << 18) | (b << 12) | (c << 6);
+		*dst++ = (uint8) (bits >> 16);
+		if (padding == 1)
+			*dst++ = (uint8) (bits >> 8);
+	}
+	
+	return numeric_cast<uint32>(dst - start);
+}
 
-				for (uint32 i = 0; i < ctcharsinbuf; i++) 
-					data.GetUnsafePtr()[origsize + i] = numeric_cast<unsigned char>(outbuf[i]);
-			}
 
-			if (flbreak)
+//---------------------------------------------------------------
+//
+// DecodeLenient
+//
+//---------------------------------------------------------------
+static uint32 DecodeLenient(const char* text, uint32 chars, uint8* dst)
+{
+	const uint8* table = kDecodingTable;
+	uint8* start = dst;
+	
+	uint32 bits = 0;
+	uint32 count = 0;
+	
+	uint32 i = 0;
+	while (i < chars) {
+#if WHISPER_SSSE3
+		if (count == 0 && chars - i >= 16) {			// use the fast path until we hit a line break
+			uint32 consumed = DecodeBlock(text + i, chars - i, dst);
+			i += consumed;
+			dst += 3*(consumed/4);
+			
+			if (i >= chars)
 				break;
 		}
-	} 
+#endif
 
-	return data;
-} 
+		uint32 value = table[(uint8) text[i++]];
+		if (value < 64) {
+			bits = (bits << 6) | value;
+			if (++count == 4) {
+				dst[0] = (uint8) (bits >> 16);
+				dst[1] = (uint8) (bits >> 8);
+				dst[2] = (uint8) bits;
+				dst += 3;
+				
+				bits = 0;
+				count = 0;
+			}
+
+		} else if (value == kPadChar)
+			break;
+	}
+	
+	if (count == 1) {									// the old decoder emitted a byte for a lone character so we do too (the missing bits are zero)
+		*dst++ = (uint8) (bits << 2);
+		
+	} else if (count == 2) {
+		*dst++ = (uint8) (bits >> 4);
+		
+	} else if (count == 3) {
+		*dst++ = (uint8) (bits >> 10);
+		*dst++ = (uint8) (bits >> 2);
+	}
+	
+	return numeric_cast<uint32>(dst - start);
+}
 
 #if __MWERKS__
 #pragma mark -
@@ -211,14 +339,18 @@ static XHandle Decode(const std::string& text)
 
 //---------------------------------------------------------------
 //
-// EncodeBase64
+// EncodeBase64 (void*, uint32)
 //
 //---------------------------------------------------------------
 std::string EncodeBase64(const void* buffer, uint32 bytes)
 {
 	PRECONDITION(buffer != nil || bytes == 0);
 	
-	std::string text = Encode(buffer, bytes, 60);
+	std::string text(GetBase64EncodedSize(bytes, kBase64LineLength), '\0');
+	if (!text.empty()) {
+		uint32 chars = EncodeBase64(buffer, bytes, &text[0], kBase64LineLength);
+		ASSERT(chars == text.length());
+	}
 		
 	return text;
 }
@@ -226,16 +358,121 @@ std::string EncodeBase64(const void* buffer, uint32 bytes)
 
 //---------------------------------------------------------------
 //
-// DecodeBase64
+// DecodeBase64 (string)
 //
 //---------------------------------------------------------------
 XHandle DecodeBase64(const std::string& text)
 {
-	XHandle data = Decode(text);
+	XHandle data(GetBase64DecodedSize(text.length()));
+	
+	uint32 bytes = 0;
+	{
+	XLocker lock(data);
+		bytes = DecodeBase64(text.c_str(), text.length(), data.GetPtr(), kLenientBase64);
+	}
+	
+	data.SetSize(bytes);
 	
 	return data;
 }
 
 
-}	// namespace Whisper
+//---------------------------------------------------------------
+//
+// GetBase64EncodedSize
+//
+//---------------------------------------------------------------
+uint32 GetBase64EncodedSize(uint32 bytes, uint32 lineLength)
+{
+	PRECONDITION(lineLength % 4 == 0);
+	PRECONDITION(lineLength <= 76);					// required by RFC2045 
+	
+	uint32 chars = 4*((bytes + 2)/3);
+	if (lineLength > 0)
+		chars += chars/lineLength;
+		
+	return chars;
+}
 
+
+//---------------------------------------------------------------
+//
+// EncodeBase64 (void*, uint32, char*, uint32)
+//
+//---------------------------------------------------------------
+uint32 EncodeBase64(const void* buffer, uint32 bytes, char* text, uint32 lineLength)
+{
+	PRECONDITION(buffer != nil || bytes == 0);
+	PRECONDITION(text != nil || bytes == 0);
+	PRECONDITION(lineLength % 4 == 0);
+	
+	const uint8* src = static_cast<const uint8*>(buffer);
+	char* dst = text;
+	
+	uint32 quanta = bytes/3;
+	uint32 perLine = lineLength > 0 ? lineLength/4 : quanta;
+	
+	while (quanta > 0) {
+		uint32 count = Min(quanta, perLine);
+		EncodeBlock(src, count, dst);
+		
+		src += 3*count;
+		dst += 4*count;
+		quanta -= count;
+		
+		if (count == perLine && lineLength > 0)
+			*dst++ = '\n';
+	}
+	
+	uint32 tail = bytes % 3;
+	if (tail > 0) {
+		EncodeTail(src, tail, dst);
+		dst += 4;
+		
+		if (lineLength > 0 && (bytes/3) % perLine == perLine - 1)	// the padded quantum filled up the last line
+			*dst++ = '\n';
+	}
+	
+	uint32 chars = numeric_cast<uint32>(dst - text);
+	POSTCONDITION(chars == GetBase64EncodedSize(bytes, lineLength));
+	
+	return chars;
+}
+
+
+//---------------------------------------------------------------
+//
+// GetBase64DecodedSize
+//
+//---------------------------------------------------------------
+uint32 GetBase64DecodedSize(uint32 chars)
+{
+	return 3*((chars + 3)/4);
+}
+
+
+//---------------------------------------------------------------
+//
+// DecodeBase64 (char*, uint32, void*, EBase64Mode)
+//
+//---------------------------------------------------------------
+uint32 DecodeBase64(const char* text, uint32 chars, void* buffer, EBase64Mode mode)
+{
+	PRECONDITION(text != nil || chars == 0);
+	PRECONDITION(buffer != nil || chars == 0);
+	
+	uint8* dst = static_cast<uint8*>(buffer);
+	
+	uint32 bytes;
+	if (mode == kStrictBase64)
+		bytes = DecodeStrict(text, chars, dst);
+	else
+		bytes = DecodeLenient(text, chars, dst);
+		
+	POSTCONDITION(bytes <= GetBase64DecodedSize(chars));
+	
+	return bytes;
+}
+
+
+}	// namespace Whisper
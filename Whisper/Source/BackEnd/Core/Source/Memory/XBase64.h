@@ -25,12 +25,50 @@ namespace Whisper {
 #endif
 
 
+//-----------------------------------
+//	Constants
+//
+enum EBase64Mode {
+	kStrictBase64,				//!< text must consist solely of base64 characters with padding only at the end (std::invalid_argument is thrown otherwise)
+	kLenientBase64				//!< characters outside the base64 alphabet (eg line breaks) are skipped (this is what RFC 2045 requires)
+};
+
+const uint32 kBase64LineLength = 60;	//!< line length used by the std::string versions
+
+
 // ===================================================================================
 //	Allocations
 // ===================================================================================
 CORE_EXPORT	std::string EncodeBase64(const void* buffer, uint32 bytes);
+						/**< Lines are kBase64LineLength characters long. */
 
 CORE_EXPORT	XHandle 	DecodeBase64(const std::string& text);
+						/**< Uses kLenientBase64. */
+
+
+// ===================================================================================
+//	Caller Buffers
+//		These never allocate memory and use SSSE3 code when WHISPER_SSSE3 is set.
+// ===================================================================================
+CORE_EXPORT uint32		GetBase64EncodedSize(uint32 bytes, uint32 lineLength = 0);
+						/**< Returns the exact number of characters EncodeBase64 will write.
+						lineLength must be a multiple of four, zero means no line breaks. */
+
+CORE_EXPORT uint32		EncodeBase64(const void* buffer, uint32 bytes, char* text, uint32 lineLength = 0);
+						/**< text must be able to hold GetBase64EncodedSize(bytes, lineLength)
+						characters. Returns the number of characters written (text isn't
+						null terminated). */
+
+CORE_EXPORT uint32		GetBase64DecodedSize(uint32 chars);
+						/**< Returns an upper bound on the number of bytes chars characters
+						will decode into (padding and skipped characters make the actual
+						size smaller). */
+
+CORE_EXPORT uint32		DecodeBase64(const char* text, uint32 chars, void* buffer, EBase64Mode mode = kLenientBase64);
+						/**< buffer must be able to hold GetBase64DecodedSize(chars) bytes.
+						Returns the number of bytes written. In lenient mode decoding stops
+						at the first '=' and a partial quantum at the end (even a lone
+						character) is decoded as if the missing bits were zero. */
 
 
 #if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
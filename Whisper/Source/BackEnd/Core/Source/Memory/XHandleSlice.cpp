@@ -0,0 +1,200 @@
+/*
+ *  File:       XHandleSlice.cpp
+ *  Summary:   	Read-only view of part of an XHandle that shares the handle's memory.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XHandleSlice.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XHandleSlice.h>
+
+#include <XDebug.h>
+#include <XMemUtils.h>
+
+namespace Whisper {
+
+
+// ===================================================================================
+//	class XHandleSlice
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// XHandleSlice::~XHandleSlice
+//
+//---------------------------------------------------------------
+XHandleSlice::~XHandleSlice()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XHandleSlice::XHandleSlice (XHandle)
+//
+//---------------------------------------------------------------
+XHandleSlice::XHandleSlice(const XHandle& hand) : mHandle(hand)
+{
+	mOffset = 0;
+	mBytes = ULONG_MAX;
+}
+
+
+//---------------------------------------------------------------
+//
+// XHandleSlice::XHandleSlice (XHandle, uint32, uint32)
+//
+//---------------------------------------------------------------
+XHandleSlice::XHandleSlice(const XHandle& hand, uint32 offset, uint32 bytes) : mHandle(hand)
+{
+	PRECONDITION(offset <= hand.GetSize());
+	PRECONDITION(bytes == ULONG_MAX || bytes <= hand.GetSize() - offset);
+
+	mOffset = offset;
+	mBytes = bytes;
+}
+
+
+//---------------------------------------------------------------
+//
+// XHandleSlice::XHandleSlice (XHandleSlice)
+//
+//---------------------------------------------------------------
+XHandleSlice::XHandleSlice(const XHandleSlice& rhs) : mHandle(rhs.mHandle)
+{
+	mOffset = rhs.mOffset;
+	mBytes = rhs.mBytes;
+}
+
+
+//---------------------------------------------------------------
+//
+// XHandleSlice::operator=
+//
+//---------------------------------------------------------------
+XHandleSlice& XHandleSlice::operator=(const XHandleSlice& rhs)
+{
+	if (this != &rhs) {
+		mHandle = rhs.mHandle;
+		mOffset = rhs.mOffset;
+		mBytes = rhs.mBytes;
+	}
+	
+	return *this;
+}
+
+
+//---------------------------------------------------------------
+//
+// XHandleSlice::GetSize
+//
+//---------------------------------------------------------------
+uint32 XHandleSlice::GetSize() const
+{
+	uint32 size = mHandle.GetSize();
+	ASSERT(mOffset <= size);
+	
+	if (mBytes != ULONG_MAX) {
+		ASSERT(mBytes <= size - mOffset);
+		size = mBytes;
+		
+	} else
+		size -= mOffset;
+	
+	return size;
+}
+
+
+//---------------------------------------------------------------
+//
+// XHandleSlice::GetSlice
+//
+//---------------------------------------------------------------
+XHandleSlice XHandleSlice::GetSlice(uint32 offset, uint32 bytes) const
+{
+	PRECONDITION(offset <= this->GetSize());
+	PRECONDITION(bytes == ULONG_MAX || bytes <= this->GetSize() - offset);
+	
+	if (bytes == ULONG_MAX && mBytes != ULONG_MAX)		// slices of fixed size slices must also be fixed size
+		bytes = mBytes - offset;
+	
+	return XHandleSlice(mHandle, mOffset + offset, bytes);
+}
+
+
+//---------------------------------------------------------------
+//
+// XHandleSlice::GetCopy
+//
+//---------------------------------------------------------------
+XHandle XHandleSlice::GetCopy() const
+{
+	uint32 bytes = this->GetSize();
+	
+	XHandle result(bytes);
+	BlockMoveData(this->GetUnsafePtr(), result.GetUnsafePtr(), bytes);
+	
+	return result;
+}
+
+
+//---------------------------------------------------------------
+//
+// XHandleSlice::operator==
+//
+//---------------------------------------------------------------
+bool XHandleSlice::operator==(const XHandleSlice& rhs) const
+{
+	uint32 bytes = this->GetSize();
+	
+	bool equal = bytes == rhs.GetSize();
+	if (equal && this->GetUnsafePtr() != rhs.GetUnsafePtr())
+		equal = EqualMemory(this->GetUnsafePtr(), rhs.GetUnsafePtr(), bytes);
+	
+	return equal;
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XHandleSlice::Lock
+//
+//---------------------------------------------------------------
+void XHandleSlice::Lock(bool moveHigh)
+{
+	mHandle.Lock(moveHigh);
+}
+
+
+//---------------------------------------------------------------
+//
+// XHandleSlice::Unlock
+//
+//---------------------------------------------------------------
+void XHandleSlice::Unlock()
+{
+	mHandle.Unlock();
+}
+
+
+//---------------------------------------------------------------
+//
+// XHandleSlice::IsLocked
+//
+//---------------------------------------------------------------
+bool XHandleSlice::IsLocked() const
+{
+	return mHandle.IsLocked();
+}
+
+
+}	// namespace Whisper
@@ -0,0 +1,117 @@
+/*
+ *  File:       XHandleSlice.h
+ *  Summary:   	Read-only view of part of an XHandle that shares the handle's memory.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XHandleSlice.h,v $
+ */
+
+#pragma once
+
+#include <climits>
+
+#include <XHandle.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class XHandleSlice
+//!		Read-only view of part of an XHandle that shares the handle's memory.
+/*!		Slices are cheap to create and copy: they bump the handle's reference count 
+ *		instead of copying any bytes. This makes them handy for things like parsing 
+ *		data that follows a header without duplicating the data. Note that the slice 
+ *		keeps the handle alive, but if someone else shrinks the handle the slice will 
+ *		wind up pointing past the end (this is checked in debug builds). */
+// ===================================================================================
+class CORE_EXPORT XHandleSlice : public XBaseLockableMixin {
+
+	typedef XBaseLockableMixin Inherited;
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual 			~XHandleSlice();
+
+						XHandleSlice(const XHandle& hand);
+						/**< The slice covers the entire handle (and tracks the handle's
+						size if the handle is resized). */
+
+						XHandleSlice(const XHandle& hand, uint32 offset, uint32 bytes = ULONG_MAX);
+						/**< If bytes is ULONG_MAX the slice extends to the end of the handle. */
+
+						XHandleSlice(const XHandleSlice& rhs);
+
+			XHandleSlice& operator=(const XHandleSlice& rhs);
+	
+//-----------------------------------
+//	API
+//
+public:
+	//! @name Access
+	//@{
+			const uint8* GetPtr() const								{ASSERT(mHandle.IsLocked()); return mHandle.GetUnsafePtr() + mOffset;}
+
+			const uint8* GetUnsafePtr() const						{return mHandle.GetUnsafePtr() + mOffset;}
+						/**< The handle may not be locked so be careful! */
+						
+			uint32 		GetSize() const;
+			
+			uint32 		GetOffset() const							{return mOffset;}
+						/**< Offset of the first byte in the slice from the start of the handle. */
+
+			const XHandle& GetHandle() const						{return mHandle;}
+						/**< Returns the entire handle. */
+	//@}
+
+	//! @name Misc
+	//@{
+			XHandleSlice GetSlice(uint32 offset, uint32 bytes = ULONG_MAX) const;
+						/**< Returns a slice of this slice (offset is relative to the start 
+						of this slice). Like the constructor this doesn't copy the bytes. */
+
+			XHandle 	GetCopy() const;
+						/**< Returns a new handle containing a copy of the slice's bytes.
+						Use this if you need to modify the bytes. */
+						
+			bool		operator==(const XHandleSlice& rhs) const;
+						/**< Byte by byte comparison. */
+
+			bool		operator!=(const XHandleSlice& rhs) const	{return !this->operator==(rhs);}
+	//@}
+
+//-----------------------------------
+//	Inherited API
+//
+public:
+	virtual void 		Lock(bool moveHigh = kDontMoveHigh);
+
+	virtual void 		Unlock();
+
+	virtual bool 		IsLocked() const;
+	
+//-----------------------------------
+//	Member Data
+//
+protected:
+	XHandle		mHandle;
+	uint32		mOffset;
+	uint32		mBytes;				// ULONG_MAX if the slice extends to the end of the handle
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
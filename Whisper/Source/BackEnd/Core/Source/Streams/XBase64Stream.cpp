@@ -0,0 +1,502 @@
+/*
+ *  File:       XBase64Stream.cpp
+ *  Summary:   	Stream adaptors that convert binary data to and from base64 text on the fly.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XBase64Stream.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XBase64Stream.h>
+
+#include <climits>
+#include <stdexcept>
+
+#include <XDebug.h>
+#include <XExceptions.h>
+#include <XMemUtils.h>
+#include <XNumbers.h>
+#include <XStringUtils.h>
+
+namespace Whisper {
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// ThrowBadBase64
+//
+//---------------------------------------------------------------
+static void ThrowBadBase64()
+{
+	throw std::invalid_argument(ToUTF8Str(LoadWhisperString(L"The base64 text was malformed.")));
+}
+
+
+//---------------------------------------------------------------
+//
+// IsBase64Char
+//
+//---------------------------------------------------------------
+inline bool IsBase64Char(char ch)
+{
+	return (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') || ch == '+' || ch == '/';
+}
+
+
+//---------------------------------------------------------------
+//
+// GetQuantumBytes
+//
+// Returns the number of bytes count base64 characters (sans
+// padding) decode into. Like DecodeBase64 a lone character at
+// the end decodes into a byte.
+//
+//---------------------------------------------------------------
+inline uint32 GetQuantumBytes(uint32 count)
+{
+	uint32 bytes = 3*(count/4);
+
+	if (count % 4 == 1 || count % 4 == 2)
+		bytes += 1;
+	else if (count % 4 == 3)
+		bytes += 2;
+
+	return bytes;
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ========================================================================================
+//	class XBase64InStream
+// ========================================================================================
+
+//---------------------------------------------------------------
+//
+// XBase64InStream::~XBase64InStream
+//
+//---------------------------------------------------------------
+XBase64InStream::~XBase64InStream()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64InStream::XBase64InStream
+//
+//---------------------------------------------------------------
+XBase64InStream::XBase64InStream(XInStream& text, EBase64Mode mode, bool raw) : XInStream(raw), mText(text)
+{
+	mMode = mode;
+	mStartPos = mText.GetPosition();
+
+	this->DoReset();
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64InStream::GetLength
+//
+//---------------------------------------------------------------
+uint32 XBase64InStream::GetLength() const
+{
+	if (mLength == ULONG_MAX) {
+		uint32 symbols = 0;
+		for (uint32 i = 0; i < mCarryCount; ++i)
+			if (IsBase64Char(mCarry[i]))			// in strict mode the carry may include padding
+				++symbols;
+
+		if (!mFinished && !mSawPadding) {
+			uint32 oldPos = mText.GetPosition();
+			uint32 length = mText.GetLength();
+
+			char text[kTextChunk];
+			bool done = false;
+			while (!done && mText.GetPosition() < length) {
+				uint32 count = Min(length - mText.GetPosition(), (uint32) kTextChunk);
+				mText.ReadBytes(text, count);
+
+				for (uint32 i = 0; i < count && !done; ++i) {
+					if (IsBase64Char(text[i]))
+						++symbols;
+					else if (text[i] == '=')
+						done = true;
+				}
+			}
+
+			mText.SetPosition(oldPos);
+		}
+
+		mLength = mPos + (mDataCount - mDataPos) + GetQuantumBytes(symbols);
+	}
+
+	return mLength;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64InStream::GetPosition
+//
+//---------------------------------------------------------------
+uint32 XBase64InStream::GetPosition() const
+{
+	return mPos;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64InStream::SetPosition
+//
+//---------------------------------------------------------------
+void XBase64InStream::SetPosition(uint32 newPosition)
+{
+	if (newPosition < mPos) {
+		mText.SetPosition(mStartPos);
+		this->DoReset();
+	}
+
+	while (mPos < newPosition) {
+		if (mDataPos == mDataCount && !this->DoFillBuffer())
+			throw std::runtime_error(ToUTF8Str(LoadWhisperString(L"Internal Error: XBase64InStream::SetPosition went past eof.")));
+
+		uint32 count = Min(newPosition - mPos, mDataCount - mDataPos);
+		mDataPos += count;
+		mPos += count;
+	}
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XBase64InStream::OnReadBytes
+//
+//---------------------------------------------------------------
+void XBase64InStream::OnReadBytes(void* dst, uint32 bytes)
+{
+	PRECONDITION(dst != nil);
+
+	uint8* buffer = static_cast<uint8*>(dst);
+	while (bytes > 0) {
+		if (mDataPos == mDataCount && !this->DoFillBuffer())
+			throw std::runtime_error(ToUTF8Str(LoadWhisperString(L"Internal Error: XBase64InStream::ReadBytes went past eof.")));
+
+		uint32 count = Min(bytes, mDataCount - mDataPos);
+		BlockMoveData(mData + mDataPos, buffer, count);
+
+		mDataPos += count;
+		mPos += count;
+		buffer += count;
+		bytes -= count;
+	}
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XBase64InStream::DoReset
+//
+//---------------------------------------------------------------
+void XBase64InStream::DoReset()
+{
+	mPos = 0;
+	mFinished = false;
+	mSawPadding = false;
+	mSymbols = 0;
+	mPadsLeft = 0;
+
+	mCarryCount = 0;
+	mDataPos = 0;
+	mDataCount = 0;
+
+	mLength = ULONG_MAX;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64InStream::DoFillBuffer
+//
+// Decodes the next chunk of text into mData. Returns false if
+// there's nothing left to decode.
+//
+//---------------------------------------------------------------
+bool XBase64InStream::DoFillBuffer()
+{
+	PRECONDITION(mDataPos == mDataCount);
+
+	mDataPos = 0;
+	mDataCount = 0;
+
+	char text[kTextChunk + 4];
+	while (mDataCount == 0 && !mFinished) {
+		BlockMoveData(mCarry, text, mCarryCount);
+		uint32 count = mCarryCount;
+		mCarryCount = 0;
+
+		uint32 available = mText.GetLength() - mText.GetPosition();
+		uint32 chunk = Min(available, (uint32) kTextChunk);
+		if (chunk > 0) {
+			mText.ReadBytes(text + count, chunk);
+
+			uint32 used = 0;
+			count += this->DoCompact(text + count, chunk, used);
+			if (used < chunk)
+				mText.SetPosition(mText.GetPosition() - (chunk - used));	// leave whatever follows the padding in mText
+		}
+
+		if (mText.GetPosition() >= mText.GetLength())
+			mFinished = true;
+
+		if (!mFinished) {								// only decode complete quanta until we hit the end
+			mCarryCount = count % 4;
+			count -= mCarryCount;
+			BlockMoveData(text + count, mCarry, mCarryCount);
+		}
+
+		mDataCount = DecodeBase64(text, count, mData, mMode);
+		ASSERT(mDataCount <= kDataChunk);
+	}
+
+	return mDataCount > 0;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64InStream::DoCompact
+//
+// In lenient mode this strips out characters that aren't part
+// of the base64 alphabet. In strict mode the text is validated
+// (so errors are caught even if the padding and the bad text
+// wind up in different chunks). In both modes we stop after the
+// padding: used is set to the number of characters consumed so
+// the caller can push the rest back into mText.
+//
+//---------------------------------------------------------------
+uint32 XBase64InStream::DoCompact(char* text, uint32 chars, uint32& used)
+{
+	uint32 count = 0;
+
+	uint32 i = 0;
+	while (i < chars && !mFinished) {
+		char ch = text[i];
+
+		if (mSawPadding) {
+			if (ch == '=' && mPadsLeft > 0) {		// the padding may be split across chunks
+				if (mMode == kStrictBase64)
+					text[count++] = ch;
+				--mPadsLeft;
+				++i;
+
+			} else if (mMode == kStrictBase64 && mPadsLeft > 0)
+				ThrowBadBase64();
+
+			if (mPadsLeft == 0 || ch != '=')
+				mFinished = true;
+
+		} else if (IsBase64Char(ch)) {
+			text[count++] = ch;
+			mSymbols = (mSymbols + 1) % 4;
+			++i;
+
+		} else if (ch == '=') {
+			if (mMode == kStrictBase64 && mSymbols < 2)
+				ThrowBadBase64();
+
+			mSawPadding = true;
+			mPadsLeft = mSymbols >= 2 ? 4 - mSymbols : 1;	// the lenient decoder stops at a single '=' no matter what
+
+		} else if (mMode == kStrictBase64)
+			ThrowBadBase64();
+
+		else
+			++i;
+	}
+
+	used = i;
+
+	return count;
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ========================================================================================
+//	class XBase64OutStream
+// ========================================================================================
+
+//---------------------------------------------------------------
+//
+// XBase64OutStream::~XBase64OutStream
+//
+//---------------------------------------------------------------
+XBase64OutStream::~XBase64OutStream()
+{
+	if (!mFlushed) {
+		try {
+			this->Flush();
+
+		} catch (...) {
+			DEBUGSTR("XBase64OutStream::~XBase64OutStream couldn't flush the stream!");
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64OutStream::XBase64OutStream
+//
+//---------------------------------------------------------------
+XBase64OutStream::XBase64OutStream(XOutStream& text, uint32 lineLength, bool raw) : XOutStream(raw), mText(text)
+{
+	PRECONDITION(lineLength % 4 == 0);
+	PRECONDITION(lineLength <= kTextChunk);
+
+	mLineLength = lineLength;
+	mColumn = 0;
+
+	mPendingCount = 0;
+	mBufferCount = 0;
+
+	mBytes = 0;
+	mFlushed = false;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64OutStream::Flush
+//
+//---------------------------------------------------------------
+void XBase64OutStream::Flush()
+{
+	if (!mFlushed) {
+		if (mPendingCount > 0) {
+			if (mBufferCount + 4 > kTextChunk)
+				this->DoWriteText();
+
+			mBufferCount += EncodeBase64(mPending, mPendingCount, mBuffer + mBufferCount);
+			mPendingCount = 0;
+
+			mColumn += 4;
+			if (mColumn == mLineLength) {
+				mBuffer[mBufferCount++] = '\n';
+				mColumn = 0;
+			}
+		}
+
+		this->DoWriteText();
+		mFlushed = true;
+	}
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XBase64OutStream::OnWriteBytes
+//
+//---------------------------------------------------------------
+void XBase64OutStream::OnWriteBytes(const void* src, uint32 bytes)
+{
+	PRECONDITION(src != nil);
+	PRECONDITION(!mFlushed);
+
+	const uint8* data = static_cast<const uint8*>(src);
+	mBytes += bytes;
+
+	if (mPendingCount > 0) {
+		while (mPendingCount < 3 && bytes > 0) {
+			mPending[mPendingCount++] = *data++;
+			--bytes;
+		}
+
+		if (mPendingCount == 3) {
+			this->DoEncode(mPending, 1);
+			mPendingCount = 0;
+		}
+	}
+
+	uint32 quanta = bytes/3;
+	this->DoEncode(data, quanta);
+
+	data += 3*quanta;
+	bytes -= 3*quanta;
+
+	while (bytes--)
+		mPending[mPendingCount++] = *data++;
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XBase64OutStream::DoEncode
+//
+//---------------------------------------------------------------
+void XBase64OutStream::DoEncode(const uint8* src, uint32 quanta)
+{
+	while (quanta > 0) {
+		if (mBufferCount + 4 > kTextChunk)
+			this->DoWriteText();
+
+		uint32 count = Min(quanta, (kTextChunk - mBufferCount)/4);
+		if (mLineLength > 0)
+			count = Min(count, (mLineLength - mColumn)/4);
+
+		mBufferCount += EncodeBase64(src, 3*count, mBuffer + mBufferCount);
+		src += 3*count;
+		quanta -= count;
+
+		if (mLineLength > 0) {
+			mColumn += 4*count;
+			if (mColumn == mLineLength) {
+				mBuffer[mBufferCount++] = '\n';
+				mColumn = 0;
+			}
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64OutStream::DoWriteText
+//
+//---------------------------------------------------------------
+void XBase64OutStream::DoWriteText()
+{
+	if (mBufferCount > 0) {
+		mText.WriteBytes(mBuffer, mBufferCount);
+		mBufferCount = 0;
+	}
+}
+
+
+}	// namespace Whisper
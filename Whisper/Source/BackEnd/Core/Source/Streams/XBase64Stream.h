@@ -0,0 +1,189 @@
+/*
+ *  File:       XBase64Stream.h
+ *  Summary:   	Stream adaptors that convert binary data to and from base64 text on the fly.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XBase64Stream.h,v $
+ */
+
+#pragma once
+
+#include <XBase64.h>
+#include <XStream.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ========================================================================================
+//	class XBase64InStream
+//!		Input stream that decodes base64 text read from another stream.
+/*!		Text is pulled from the source stream in small chunks so large blobs can be decoded
+ *		without allocating a second copy of the data. Decoding stops right after the padding
+ *		so anything that follows the base64 text can still be read from the source stream
+ *		(text that needs no padding is decoded up to the end of the source). Note that the
+ *		first call to GetLength has to scan the rest of the source stream and that seeking
+ *		backwards is linear. */
+// ========================================================================================
+class CORE_EXPORT XBase64InStream : public XInStream {
+
+	typedef XInStream Inherited;
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual 			~XBase64InStream();
+
+	explicit			XBase64InStream(XInStream& text, EBase64Mode mode = kLenientBase64, bool raw = kRaw);
+						/**< Decoding starts at text's current position. Defaults to not
+						including a stream header. */
+
+private:
+						XBase64InStream(const XBase64InStream& rhs);
+
+			XBase64InStream& operator=(const XBase64InStream& rhs);
+
+//-----------------------------------
+//	Inherited API
+//
+public:
+	virtual uint32		GetLength() const;
+
+	virtual uint32		GetPosition() const;
+
+	virtual void		SetPosition(uint32 newPosition);
+
+protected:
+	virtual void 		OnReadBytes(void* dst, uint32 bytes);
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		DoReset();
+
+			bool 		DoFillBuffer();
+
+			uint32 		DoCompact(char* text, uint32 chars, uint32& used);
+
+//-----------------------------------
+//	Internal Constants
+//
+protected:
+	enum {kTextChunk = 4096, kDataChunk = 3*(kTextChunk + 4)/4};
+
+//-----------------------------------
+//	Member Data
+//
+protected:
+	XInStream&		mText;
+	EBase64Mode		mMode;
+	uint32			mStartPos;			// position of the first character in mText
+
+	uint32			mPos;				// number of decoded bytes that have been read
+	bool			mFinished;			// true if we've hit the padding or the end of mText
+	bool			mSawPadding;
+	uint32			mSymbols;			// number of base64 characters seen so far (mod 4)
+	uint32			mPadsLeft;			// number of '=' characters we still expect
+
+	char			mCarry[4];			// base64 characters that didn't form a complete quantum
+	uint32			mCarryCount;
+
+	uint8			mData[kDataChunk];	// decoded bytes that haven't been read yet
+	uint32			mDataPos;
+	uint32			mDataCount;
+
+	mutable uint32	mLength;			// ULONG_MAX until GetLength is called
+};
+
+
+// ========================================================================================
+//	class XBase64OutStream
+//!		Output stream that writes the base64 encoding of the data to another stream.
+/*!		Data is encoded in small chunks so large blobs can be encoded without allocating
+ *		a second copy of the data. The text is identical to what EncodeBase64 produces
+ *		with the same line length. Flush must be called (or the stream destroyed) to
+ *		write out the last partial quantum. */
+// ========================================================================================
+class CORE_EXPORT XBase64OutStream : public XOutStream {
+
+	typedef XOutStream Inherited;
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual 			~XBase64OutStream();
+
+	explicit			XBase64OutStream(XOutStream& text, uint32 lineLength = kBase64LineLength, bool raw = kRaw);
+						/**< lineLength must be a multiple of four, zero means no line breaks.
+						Defaults to not including a stream header. */
+
+private:
+						XBase64OutStream(const XBase64OutStream& rhs);
+
+			XBase64OutStream& operator=(const XBase64OutStream& rhs);
+
+//-----------------------------------
+//	New API
+//
+public:
+			void 		Flush();
+						/**< Writes out any pending bytes along with the padding. Nothing
+						else can be written after this is called. */
+
+			uint32 		GetBytesWritten() const						{return mBytes;}
+
+//-----------------------------------
+//	Inherited API
+//
+protected:
+	virtual void 		OnWriteBytes(const void* src, uint32 bytes);
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		DoEncode(const uint8* src, uint32 quanta);
+
+			void 		DoWriteText();
+
+//-----------------------------------
+//	Internal Constants
+//
+protected:
+	enum {kTextChunk = 4096};
+
+//-----------------------------------
+//	Member Data
+//
+protected:
+	XOutStream&		mText;
+	uint32			mLineLength;
+	uint32			mColumn;			// number of characters on the current line
+
+	uint8			mPending[3];		// bytes that don't form a complete quantum
+	uint32			mPendingCount;
+
+	char			mBuffer[kTextChunk + 1];	// extra byte is for a trailing line break
+	uint32			mBufferCount;
+
+	uint32			mBytes;
+	bool			mFlushed;
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
@@ -26,6 +26,12 @@
 namespace Whisper {
 
 
+//-----------------------------------
+//	Constants
+//
+const uint32 kMinGrowth = 256;					// don't bother resizing for less than this
+
+
 // ========================================================================================
 //	class XInHandleStream
 // ========================================================================================
@@ -42,12 +48,25 @@ XInHandleStream::~XInHandleStream()
 
 //---------------------------------------------------------------
 //
-// XInHandleStream::XInHandleStream
+// XInHandleStream::XInHandleStream (XHandle, uint32, bool)
+//
+//---------------------------------------------------------------
+XInHandleStream::XInHandleStream(const XHandle& hand, uint32 startPos, bool raw) : XInStream(raw), mSlice(hand)
+{
+	PRECONDITION(startPos < mSlice.GetSize() || (startPos == 0 && mSlice.GetSize() == 0));
+
+	mPos = startPos;
+}
+
+
+//---------------------------------------------------------------
+//
+// XInHandleStream::XInHandleStream (XHandleSlice, uint32, bool)
 //
 //---------------------------------------------------------------
-XInHandleStream::XInHandleStream(const XHandle& hand, uint32 startPos, bool raw) : XInStream(raw), mHandle(hand)
+XInHandleStream::XInHandleStream(const XHandleSlice& slice, uint32 startPos, bool raw) : XInStream(raw), mSlice(slice)
 {
-	PRECONDITION(startPos < mHandle.GetSize() || (startPos == 0 && mHandle.GetSize() == 0));
+	PRECONDITION(startPos < mSlice.GetSize() || (startPos == 0 && mSlice.GetSize() == 0));
 
 	mPos = startPos;
 }
@@ -60,7 +79,7 @@ XInHandleStream::XInHandleStream(const XHandle& hand, uint32 startPos, bool raw)
 //---------------------------------------------------------------
 uint32 XInHandleStream::GetLength() const
 {
-	return mHandle.GetSize();
+	return mSlice.GetSize();
 }
 
 
@@ -82,7 +101,7 @@ uint32 XInHandleStream::GetPosition() const
 //---------------------------------------------------------------
 void XInHandleStream::SetPosition(uint32 newPosition)
 {
-	PRECONDITION(newPosition <= mHandle.GetSize());
+	PRECONDITION(newPosition <= mSlice.GetSize());
 
 	mPos = newPosition;
 }
@@ -100,9 +119,9 @@ void XInHandleStream::OnReadBytes(void* dst, uint32 bytes)
 {
 	PRECONDITION(dst != nil);
 	
-	uint32 size = mHandle.GetSize();
+	uint32 size = mSlice.GetSize();
 	if (mPos + bytes <= size) {
-		BlockMoveData(mHandle.GetUnsafePtr() + mPos, dst, bytes);
+		BlockMoveData(mSlice.GetUnsafePtr() + mPos, dst, bytes);
 
 		mPos += bytes;
 
@@ -167,6 +186,18 @@ XHandle XOutHandleStream::GetHandle() const
 	return result;
 }
 
+
+//---------------------------------------------------------------
+//
+// XOutHandleStream::Reserve
+//
+//---------------------------------------------------------------
+void XOutHandleStream::Reserve(uint32 bytes)
+{
+	if (mPos + bytes > mHandle.GetSize())
+		mHandle.SetSize(mPos + bytes);
+}
+
 #if __MWERKS__
 #pragma mark 
 #endif
@@ -198,7 +229,7 @@ void XOutHandleStream::OnWriteBytes(const void* src, uint32 bytes)
 void XOutHandleStream::DoExpandHandle(uint32 requiredSize)
 {
 	try {
-		uint32 size = Max(2*mHandle.GetSize(), requiredSize);
+		uint32 size = Max(2*mHandle.GetSize(), requiredSize + kMinGrowth);
 		mHandle.SetSize(size);
 
 	} catch (...) {
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <XHandle.h>
+#include <XHandleSlice.h>
 #include <XStream.h>
 
 namespace Whisper {
@@ -48,11 +49,17 @@ public:
 	explicit			XInHandleStream(const XHandle& hand, uint32 startPos = 0, bool raw = kRaw);
 						/**< Defaults to not including a stream header. */
 												
+	explicit			XInHandleStream(const XHandleSlice& slice, uint32 startPos = 0, bool raw = kRaw);
+						/**< Reads from part of a handle without copying it. Positions and
+						the stream length are relative to the slice. */
+												
 //-----------------------------------
 //	New API
 //
 public:
-			XHandle 	GetHandle() const							{return mHandle;}
+			XHandle 	GetHandle() const							{return mSlice.GetHandle();}
+			
+			const XHandleSlice& GetSlice() const					{return mSlice;}
 
 //-----------------------------------
 //	Inherited API
@@ -71,8 +78,8 @@ protected:
 //	Member Data
 //
 protected:
-	XHandle		mHandle;
-	uint32		mPos;
+	XHandleSlice	mSlice;
+	uint32			mPos;
 };
 
 
@@ -101,7 +108,23 @@ public:
 //
 public:
 			XHandle 	GetHandle() const;
+						/**< Note that this trims the handle to the number of bytes written
+						so the next write will have to grow it again. Use GetSlice if you
+						want to look at the data before you've finished writing. */
 
+			XHandleSlice GetSlice() const							{return XHandleSlice(mHandle, 0, mPos);}
+						/**< Returns the bytes written so far without copying or trimming. */
+						
+			uint32 		GetPosition() const							{return mPos;}
+			
+			uint32 		GetCapacity() const							{return mHandle.GetSize();}
+						/**< Number of bytes that can be written before the handle has to grow. */
+			
+			void 		Reserve(uint32 bytes);
+						/**< Ensures that the next bytes worth of writes won't resize the handle.
+						If you know roughly how much you're going to write this avoids the 
+						copying as the handle grows. */
+						
 //-----------------------------------
 //	Inherited API
 //
@@ -113,6 +136,8 @@ protected:
 //
 protected:
 	virtual void 		DoExpandHandle(uint32 requiredSize);
+						/**< Grows the handle geometrically so that N bytes worth of small
+						writes cost O(N) copying. */
 
 //-----------------------------------
 //	Member Data
@@ -0,0 +1,185 @@
+/*
+ *  File:       XRopeStream.cpp
+ *  Summary:   	Output stream that writes into a list of fixed buffers instead of one growing buffer.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XRopeStream.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XRopeStream.h>
+
+#include <XDebug.h>
+#include <XMemUtils.h>
+#include <XNumbers.h>
+
+namespace Whisper {
+
+
+//-----------------------------------
+//	Constants
+//
+const uint32 kMaxSegmentBytes = 1024L*1024L;
+
+
+// ========================================================================================
+//	class XOutRopeStream
+// ========================================================================================
+
+//---------------------------------------------------------------
+//
+// XOutRopeStream::~XOutRopeStream
+//
+//---------------------------------------------------------------
+XOutRopeStream::~XOutRopeStream()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XOutRopeStream::XOutRopeStream
+//
+//---------------------------------------------------------------
+XOutRopeStream::XOutRopeStream(uint32 segmentBytes, bool raw) : XOutStream(raw)
+{
+	PRECONDITION(segmentBytes > 0);
+	
+	mFirstBytes = segmentBytes;
+	mNextBytes = segmentBytes;
+	mLength = 0;
+}
+
+
+//---------------------------------------------------------------
+//
+// XOutRopeStream::Reserve
+//
+//---------------------------------------------------------------
+void XOutRopeStream::Reserve(uint32 bytes)
+{
+	if (mSegments.empty() || mSegments.back().used + bytes > mSegments.back().data.GetSize())
+		this->DoAddSegment(bytes);
+}
+
+
+//---------------------------------------------------------------
+//
+// XOutRopeStream::CopyTo
+//
+//---------------------------------------------------------------
+void XOutRopeStream::CopyTo(void* dst) const
+{
+	PRECONDITION(dst != nil || mLength == 0);
+	
+	uint8* ptr = static_cast<uint8*>(dst);
+	for (uint32 index = 0; index < mSegments.size(); ++index) {
+		const SSegment& segment = mSegments[index];
+		
+		BlockMoveData(segment.data.GetPtr(), ptr, segment.used);
+		ptr += segment.used;
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XOutRopeStream::GetHandle
+//
+//---------------------------------------------------------------
+XHandle XOutRopeStream::GetHandle() const
+{
+	XHandle result(mLength);
+	this->CopyTo(result.GetUnsafePtr());
+	
+	return result;
+}
+
+
+//---------------------------------------------------------------
+//
+// XOutRopeStream::WriteTo
+//
+//---------------------------------------------------------------
+void XOutRopeStream::WriteTo(XOutStream& stream) const
+{
+	PRECONDITION(&stream != this);
+	
+	for (uint32 index = 0; index < mSegments.size(); ++index) {
+		const SSegment& segment = mSegments[index];
+		
+		stream.WriteBytes(segment.data.GetPtr(), segment.used);
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XOutRopeStream::Clear
+//
+//---------------------------------------------------------------
+void XOutRopeStream::Clear()
+{
+	mSegments.clear();
+	
+	mNextBytes = mFirstBytes;
+	mLength = 0;
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XOutRopeStream::OnWriteBytes
+//
+//---------------------------------------------------------------
+void XOutRopeStream::OnWriteBytes(const void* src, uint32 bytes)
+{
+	PRECONDITION(src != nil);
+	
+	const uint8* ptr = static_cast<const uint8*>(src);
+	while (bytes > 0) {
+		if (mSegments.empty() || mSegments.back().used == mSegments.back().data.GetSize())
+			this->DoAddSegment(1);
+			
+		SSegment& segment = mSegments.back();
+		uint32 count = Min(bytes, segment.data.GetSize() - segment.used);
+		
+		BlockMoveData(ptr, segment.data.GetPtr() + segment.used, count);
+		segment.used += count;
+		
+		mLength += count;
+		ptr += count;
+		bytes -= count;
+	}
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XOutRopeStream::DoAddSegment
+//
+//---------------------------------------------------------------
+void XOutRopeStream::DoAddSegment(uint32 minBytes)
+{
+	SSegment segment;
+	segment.data.SetSize(Max(mNextBytes, minBytes));
+	segment.used = 0;
+	
+	mSegments.push_back(segment);
+	
+	mNextBytes = Min(2*mNextBytes, Max(kMaxSegmentBytes, mFirstBytes));
+}
+
+
+}	// namespace Whisper
@@ -0,0 +1,120 @@
+/*
+ *  File:       XRopeStream.h
+ *  Summary:   	Output stream that writes into a list of fixed buffers instead of one growing buffer.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XRopeStream.h,v $
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <XHandle.h>
+#include <XPointer.h>
+#include <XStream.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ========================================================================================
+//	class XOutRopeStream
+//!		Output stream that writes into a list of fixed buffers instead of one growing buffer.
+/*!		XOutHandleStream has to copy everything it has written whenever its handle grows.
+ *		XOutRopeStream allocates a new segment instead so bytes are never moved once they're 
+ *		written. This makes it a better choice when building large blobs in memory that
+ *		will be written to a file or another stream. */
+// ========================================================================================
+class CORE_EXPORT XOutRopeStream : public XOutStream {
+
+	typedef XOutStream Inherited;
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual 			~XOutRopeStream();
+	
+	explicit			XOutRopeStream(uint32 segmentBytes = 4*1024L, bool raw = kRaw);
+						/**< Defaults to not including a stream header. segmentBytes is the size
+						of the first segment: subsequent segments double in size (up to a
+						maximum of 1MB). */
+						
+//-----------------------------------
+//	New API
+//
+public:
+			uint32 		GetLength() const							{return mLength;}
+						/**< Number of bytes written. */
+			
+			uint32 		GetSegmentCount() const						{return mSegments.size();}
+			
+			const uint8* GetSegmentPtr(uint32 index) const			{PRECONDITION(index < mSegments.size()); return mSegments[index].data.GetPtr();}
+
+			uint32 		GetSegmentSize(uint32 index) const			{PRECONDITION(index < mSegments.size()); return mSegments[index].used;}
+						/**< Returns the number of bytes written into the segment (the
+						last segment is normally only partially used). */
+			
+			void 		Reserve(uint32 bytes);
+						/**< Ensures that the next bytes worth of writes go into one segment
+						(eg so that they can be parsed in place). */
+
+			void 		CopyTo(void* dst) const;
+						/**< dst must have room for GetLength() bytes. */
+
+			XHandle 	GetHandle() const;
+						/**< Copies the segments into a new handle. */
+			
+			void 		WriteTo(XOutStream& stream) const;
+						/**< Writes the segments to stream (eg a file stream) without
+						flattening them first. */
+						
+			void 		Clear();
+						/**< Releases all the segments. */
+						
+//-----------------------------------
+//	Inherited API
+//
+protected:
+	virtual void 		OnWriteBytes(const void* src, uint32 bytes);
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		DoAddSegment(uint32 minBytes);
+
+//-----------------------------------
+//	Internal Types
+//
+protected:
+	struct SSegment {
+		XPointer	data;
+		uint32		used;
+	};
+
+//-----------------------------------
+//	Member Data
+//
+protected:
+	std::vector<SSegment>	mSegments;
+	uint32					mFirstBytes;
+	uint32					mNextBytes;		// size of the next segment we allocate
+	uint32					mLength;
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
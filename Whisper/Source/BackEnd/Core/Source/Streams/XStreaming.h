@@ -32,6 +32,7 @@
 #include <XSet.h>
 #include <XSparseArray.h>
 #include <XStream.h>
+#include <XTiledSparseArray.h>
 #include <XTinyVector.h>
 
 namespace Whisper {
@@ -132,13 +133,12 @@ XOutStream& operator<<(XOutStream& stream, const std::map<KEY, VALUE, COMP>& col
 //		It would be possible to merge some of these into a more generic template function
 //		but that would often lead to compiler ambiguities.
 // ========================================================================================
-template <class T> XInStream& operator>>(XInStream& stream, XTinyVector<T>& collection)
+template <class T, uint32 N> XInStream& operator>>(XInStream& stream, XTinyVector<T, N>& collection)
 {
 	uint32 size;
 	stream >> size;
 	
-	if (size != collection.size())		// tiny vectors aren't resizable
-		throw std::runtime_error(ToUTF8Str(LoadWhisperString(L"Internal Error: Tiny vector sizes don't match.")));
+	collection.resize(size);
 		
 	for (uint32 i = 0; i < size; ++i) {
 		T value;
@@ -219,12 +219,12 @@ template <class KEY, class VALUE, class COMP> XInStream& operator>>(XInStream& s
 }
 
 
-template <class T> XOutStream& operator<<(XOutStream& stream, const XTinyVector<T>& collection)
+template <class T, uint32 N> XOutStream& operator<<(XOutStream& stream, const XTinyVector<T, N>& collection)
 {
 	uint32 size = collection.size();
 	stream << size;
 	
-	std::vector<T>::const_iterator iter = collection.begin();
+	XTinyVector<T, N>::const_iterator iter = collection.begin();
 	while (iter != collection.end()) {
 		const T& value = *iter++;
 
@@ -321,6 +321,71 @@ XOutStream& operator<<(XOutStream& stream, const XSparseArray<T>& c)
 }
 
 
+template <class T>
+XInStream& operator>>(XInStream& stream, XTiledSparseArray<T>& c)		// uses the same format as XSparseArray
+{
+	XRect shape;
+	uint32 size;
+	stream >> shape >> size;
+
+	std::vector<std::pair<XPoint, T> > elements;	// the default value comes last so we can't fill in the tiles yet
+	elements.reserve(size);
+
+	while (size--) {
+		XPoint cell;
+		T value;
+		stream >> cell >> value;
+
+		elements.push_back(std::pair<XPoint, T>(cell, value));
+	}
+
+	T defaultValue;
+	stream >> defaultValue;
+
+	c.Clear();
+	c.mShape = shape;
+	c.mDefaultValue = defaultValue;
+
+	for (uint32 index = 0; index < elements.size(); ++index)
+		c(elements[index].first.x, elements[index].first.y) = elements[index].second;
+
+	return stream;
+}
+
+template <class T>
+XOutStream& operator<<(XOutStream& stream, const XTiledSparseArray<T>& c)	// elements are written in row major order like XSparseArray's
+{
+	typedef XTiledSparseArray<T> Array;
+
+	std::vector<const Array::STile*> tiles;
+	c.DoGetSortedTiles(tiles);
+
+	stream << c.mShape << c.GetMemoryUsage().elements;
+
+	uint32 first = 0;
+	while (first < tiles.size()) {
+		uint32 last = first;							// tiles [first, last) are in the same band of rows
+		while (last < tiles.size() && tiles[last]->row == tiles[first]->row)
+			++last;
+
+		for (int32 y = 0; y < Array::kTileSize; ++y) {
+			for (uint32 index = first; index < last; ++index) {
+				const T* elements = tiles[index]->elements + (y << Array::kTileShift);
+
+				for (int32 x = 0; x < Array::kTileSize; ++x) {
+					if (elements[x] != c.mDefaultValue)
+						stream << XPoint(tiles[index]->col*Array::kTileSize + x, tiles[index]->row*Array::kTileSize + y) << elements[x];
+				}
+			}
+		}
+
+		first = last;
+	}
+
+	return (stream << c.mDefaultValue);
+}
+
+
 template <class T>
 XInStream& operator>>(XInStream& stream, XArray<T>& c)			
 {
@@ -536,7 +536,7 @@ std::wstring ConvertToUpperCase(const std::wstring& inStr)
 		int32 count = ::LCMapStringW(locale, flags, inStr.c_str(), (int32) inStr.length(), nil, 0);
 		ThrowIf(count == 0);
 
-		XTinyVector<wchar_t> temp(count+1UL);
+		XTinyVector<wchar_t, 256> temp(count+1UL);		// most strings will fit on the stack
 		int32 succeeded = ::LCMapStringW(locale, flags, inStr.c_str(), (int32) inStr.length(), temp.buffer(), count);
 		ThrowIf(!succeeded);
 
@@ -47,6 +47,12 @@
 
 namespace Whisper {
 
+//-----------------------------------
+//	Constants
+//
+const uint32 kInlineChars = 256;			// strings shorter than this are converted without allocating a scratch buffer
+
+
 //-----------------------------------
 //	Variables
 //
@@ -172,7 +178,7 @@ std::wstring FromPlatformStr(const char* str, uint32 length, XTextTranscoder* ov
 	XTextTranscoder* transcoder = GetPlatformTranscoder(override);
 	uint32 dstLen = transcoder->GetDstBytes(str, srcLen)/2;
 	
-	XTinyVector<wchar_t> buffer(dstLen);
+	XTinyVector<wchar_t, kInlineChars> buffer(dstLen);
 	uint32 len = transcoder->ConvertToUTF16(str, srcLen, buffer.buffer(), dstLen*sizeof(wchar_t))/2;
 	
 	return std::wstring(buffer.buffer(), len);
@@ -195,7 +201,7 @@ std::wstring FromUTF8Str(const char* str, uint32 length)
 	XTextTranscoder* transcoder = GetUTF8Transcoder();
 	uint32 dstLen = transcoder->GetDstBytes(str, srcLen)/2;
 	
-	XTinyVector<wchar_t> buffer(dstLen);
+	XTinyVector<wchar_t, kInlineChars> buffer(dstLen);
 	uint32 len = transcoder->ConvertToUTF16(str, srcLen, buffer.buffer(), dstLen*sizeof(wchar_t))/2;
 	
 	return std::wstring(buffer.buffer(), len);
@@ -242,7 +248,7 @@ std::wstring FromPascalStr(const unsigned char* str, uint32 length)
 	uint32 srcLen = std::min((uint32) str[0], length);
 	uint32 dstLen = transcoder->GetDstBytes((const char*) str+1, srcLen)/2;
 	
-	XTinyVector<wchar_t> buffer(dstLen);
+	XTinyVector<wchar_t, kInlineChars> buffer(dstLen);
 	uint32 len = transcoder->ConvertToUTF16((const char*) str+1, srcLen, buffer.buffer(), dstLen*sizeof(wchar_t))/2;
 	
 	return std::wstring(buffer.buffer(), len);
@@ -271,7 +277,7 @@ std::wstring FromCarbonStr(CFStringRef str, uint32 inLength)
 		result.assign((wchar_t*) chars, length);
 	
 	} else {		
-		XTinyVector<wchar_t> buffer(length);
+		XTinyVector<wchar_t, kInlineChars> buffer(length);
 
 		CFRange range;
 		range.location = 0;
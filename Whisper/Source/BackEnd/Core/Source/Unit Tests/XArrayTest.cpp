@@ -0,0 +1,310 @@
+/*
+ *  File:       XArrayTest.cpp
+ *  Summary:   	Unit test and benchmark for the dense 2D array classes.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XArrayTest.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XArrayTest.h>
+
+#include <functional>
+#include <vector>
+
+#include <XArray.h>
+#include <XDebug.h>
+#include <XMiscUtils.h>
+#include <XNumbers.h>
+#include <XTiledArray.h>
+
+namespace Whisper {
+#if DEBUG
+
+
+//-----------------------------------
+//	Constants
+//
+const int32  kTimingSize   = 1024;
+const uint32 kTimingPasses = 8;
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// SMinimum
+//
+//---------------------------------------------------------------
+struct SMinimum {
+	int32 operator()(int32 lhs, int32 rhs) const	{return lhs < rhs ? lhs : rhs;}
+};
+
+
+//---------------------------------------------------------------
+//
+// SDouble
+//
+//---------------------------------------------------------------
+struct SDouble {
+	float operator()(float value) const				{return 2.0f*value;}
+};
+
+
+//---------------------------------------------------------------
+//
+// Stencil
+//
+// The five point neighborhood CRenderer::DoNeighborhoodCast
+// looks at.
+//
+//---------------------------------------------------------------
+template <class ARRAY>
+inline float Stencil(const ARRAY& array, int32 col, int32 row)
+{
+	return array.GetUnsafe(col, row) + array.GetUnsafe(col - 1, row) + array.GetUnsafe(col + 1, row) + array.GetUnsafe(col, row - 1) + array.GetUnsafe(col, row + 1);
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class XArrayUnitTest
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// XArrayUnitTest::~XArrayUnitTest
+//
+//---------------------------------------------------------------
+XArrayUnitTest::~XArrayUnitTest()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XArrayUnitTest::XArrayUnitTest
+//
+//---------------------------------------------------------------
+XArrayUnitTest::XArrayUnitTest() : XUnitTest(L"Backend", L"Arrays")
+{
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XArrayUnitTest::OnTest
+//
+//---------------------------------------------------------------
+void XArrayUnitTest::OnTest()
+{
+	this->DoTestAccess();
+	this->DoTestBulk();
+	this->DoTimeStencil();
+
+	TRACE("Completed array test.\n\n");
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XArrayUnitTest::DoTestAccess
+//
+//---------------------------------------------------------------
+void XArrayUnitTest::DoTestAccess()
+{
+	for (int32 pass = 0; pass < 20; ++pass) {
+		XRect shape;										// odd sizes and negative origins exercise the padding and index math
+		shape.left   = Random(-20L, 20L);
+		shape.top    = Random(-20L, 20L);
+		shape.right  = shape.left + Random(1L, 40L);
+		shape.bottom = shape.top + Random(1L, 40L);
+		
+		XArray<int32> array(shape, -1);
+		for (int32 row = shape.top; row < shape.bottom; ++row)
+			for (int32 col = shape.left; col < shape.right; ++col)
+				array(col, row) = Random(1000L);
+				
+		// row pointers and the unchecked accessors should agree with operator()
+		for (int32 row = shape.top; row < shape.bottom; ++row) {
+			const int32* ptr = array.GetRowPtr(row);
+			for (int32 col = shape.left; col < shape.right; ++col) {
+				ASSERT(ptr[col - shape.left] == array(col, row));
+				ASSERT(array.GetUnsafe(col, row) == array(col, row));
+			}
+		}
+		
+		XArray<int32> copy(array);
+		ASSERT(copy == array);
+		
+		// the tiled array should hold the same elements
+		XTiledArray<int32> tiled(array);
+		ASSERT(tiled.GetShape() == shape);
+		for (int32 row = shape.top; row < shape.bottom; ++row)
+			for (int32 col = shape.left; col < shape.right; ++col)
+				ASSERT(tiled(col, row) == array(col, row));
+		
+		XTiledArray<int32> tiledCopy(tiled);
+		ASSERT(tiledCopy == tiled);
+		
+		tiledCopy(shape.left, shape.top) += 1;
+		ASSERT(tiledCopy != tiled);
+		
+		XArray<int32> result;
+		tiled.CopyTo(result);
+		ASSERT(result == array);
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XArrayUnitTest::DoTestBulk
+//
+//---------------------------------------------------------------
+void XArrayUnitTest::DoTestBulk()
+{
+	for (int32 width = 1; width < 20; ++width) {
+		XArray<int32> array(XSize(width, 3));
+		
+		int32 sum = 0;
+		int32 minimum = LONG_MAX;
+		for (int32 row = 0; row < 3; ++row) {
+			for (int32 col = 0; col < width; ++col) {
+				int32 value = Random(-1000L, 1000L);
+				array(col, row) = value;
+				
+				sum += value;
+				minimum = Min(minimum, value);
+			}
+		}
+		
+		ASSERT(array.Reduce(0, std::plus<int32>()) == sum);
+		ASSERT(array.Reduce(LONG_MAX, SMinimum()) == minimum);
+		ASSERT(array.Reduce(-5000, SMinimum()) == -5000);
+	}
+	
+	XArray<float> depths(XSize(37, 11), 1.5f);
+	depths.Transform(SDouble());
+	ASSERT(depths.Reduce(0.0f, std::plus<float>()) == 3.0f*37*11);
+	
+	XTiledArray<float> tiled(XSize(37, 11), 1.5f);
+	tiled.Transform(SDouble());
+	
+	XArray<float> result;
+	tiled.CopyTo(result);
+	ASSERT(result == depths);
+}
+
+
+//---------------------------------------------------------------
+//
+// XArrayUnitTest::DoTimeStencil
+//
+// Times the five point stencil over a kTimingSize x kTimingSize
+// depth buffer. The scanline order is what most loops use, the
+// random order approximates the scattered access pattern of the
+// renderer's progressive passes.
+//
+//---------------------------------------------------------------
+void XArrayUnitTest::DoTimeStencil()
+{
+	XArray<float> array(XSize(kTimingSize, kTimingSize));
+	for (int32 row = 0; row < kTimingSize; ++row) {
+		float* ptr = array.GetRowPtr(row);
+		for (int32 col = 0; col < kTimingSize; ++col)
+			ptr[col] = (float) Random(1000L);
+	}
+	
+	XTiledArray<float> tiled(array);
+	
+	std::vector<XPoint> order;							// build the random order up front so we don't time Random
+	order.reserve((kTimingSize - 2)*(kTimingSize - 2));
+	for (int32 row = 1; row < kTimingSize - 1; ++row)
+		for (int32 col = 1; col < kTimingSize - 1; ++col)
+			order.push_back(XPoint(col, row));
+	for (uint32 i = order.size() - 1; i > 0; --i)
+		std::swap(order[i], order[(uint32) Random((int32) i + 1)]);
+		
+	// scanline order
+	float sum1 = 0.0f;
+	MilliSecond start = GetMilliSeconds();
+	for (uint32 pass = 0; pass < kTimingPasses; ++pass)
+		for (int32 row = 1; row < kTimingSize - 1; ++row)
+			for (int32 col = 1; col < kTimingSize - 1; ++col)
+				sum1 += array(col, row) + array(col - 1, row) + array(col + 1, row) + array(col, row - 1) + array(col, row + 1);
+	MilliSecond checkedTime = GetMilliSeconds() - start;
+
+	float sum2 = 0.0f;
+	start = GetMilliSeconds();
+	for (uint32 pass = 0; pass < kTimingPasses; ++pass) {
+		for (int32 row = 1; row < kTimingSize - 1; ++row) {
+			const float* above = array.GetRowPtr(row - 1);
+			const float* ptr   = array.GetRowPtr(row);
+			const float* below = array.GetRowPtr(row + 1);
+			for (int32 col = 1; col < kTimingSize - 1; ++col)
+				sum2 += ptr[col] + ptr[col - 1] + ptr[col + 1] + above[col] + below[col];
+		}
+	}
+	MilliSecond rowTime = GetMilliSeconds() - start;
+	
+	float sum3 = 0.0f;
+	start = GetMilliSeconds();
+	for (uint32 pass = 0; pass < kTimingPasses; ++pass)
+		for (int32 row = 1; row < kTimingSize - 1; ++row)
+			for (int32 col = 1; col < kTimingSize - 1; ++col)
+				sum3 += Stencil(tiled, col, row);
+	MilliSecond tiledTime = GetMilliSeconds() - start;
+	
+	// random order
+	float sum4 = 0.0f;
+	start = GetMilliSeconds();
+	for (uint32 pass = 0; pass < kTimingPasses; ++pass)
+		for (uint32 i = 0; i < order.size(); ++i)
+			sum4 += Stencil(array, order[i].x, order[i].y);
+	MilliSecond randomTime = GetMilliSeconds() - start;
+	
+	float sum5 = 0.0f;
+	start = GetMilliSeconds();
+	for (uint32 pass = 0; pass < kTimingPasses; ++pass)
+		for (uint32 i = 0; i < order.size(); ++i)
+			sum5 += Stencil(tiled, order[i].x, order[i].y);
+	MilliSecond randomTiledTime = GetMilliSeconds() - start;
+	
+	// bulk ops
+	start = GetMilliSeconds();
+	float total = 0.0f;
+	for (uint32 pass = 0; pass < kTimingPasses; ++pass)
+		total += array.Reduce(0.0f, std::plus<float>());
+	MilliSecond reduceTime = GetMilliSeconds() - start;
+	
+	TRACE("Stencil timing (", kTimingSize, "x", kTimingSize, " floats x ", kTimingPasses, "):\n");
+	TRACE("   operator():         ", checkedTime, " ms\n");
+	TRACE("   GetRowPtr:          ", rowTime, " ms\n");
+	TRACE("   tiled:              ", tiledTime, " ms\n");
+	TRACE("   random (row major): ", randomTime, " ms\n");
+	TRACE("   random (tiled):     ", randomTiledTime, " ms\n");
+	TRACE("   Reduce:             ", reduceTime, " ms\n");
+	
+	ASSERT(sum1 > 0.0f && sum2 > 0.0f && sum3 > 0.0f && sum4 > 0.0f && sum5 > 0.0f && total > 0.0f);	// make sure the loops aren't optimized away
+}
+
+
+#endif	// DEBUG
+}		// namespace Whisper
+
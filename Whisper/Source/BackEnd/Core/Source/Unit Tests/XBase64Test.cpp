@@ -0,0 +1,364 @@
+/*
+ *  File:       XBase64Test.cpp
+ *  Summary:   	Unit test and benchmark for the base64 encoder/decoder.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XBase64Test.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XBase64Test.h>
+
+#include <cstring>
+#include <stdexcept>
+
+#include <XBase64.h>
+#include <XBase64Stream.h>
+#include <XDebug.h>
+#include <XHandleStream.h>
+#include <XLocker.h>
+#include <XMemUtils.h>
+#include <XMiscUtils.h>
+#include <XNumbers.h>
+#include <XUnitTestUtils.h>
+
+namespace Whisper {
+#if DEBUG
+
+
+//-----------------------------------
+//	Constants
+//
+const uint32 kTimingBytes = 8L*1024L*1024L;
+const uint32 kTimingPasses = 8;
+
+const double kGigabyte = 1024.0*1024.0*1024.0;
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// CreateHandle
+//
+//---------------------------------------------------------------
+static XHandle CreateHandle(const char* text, uint32 chars)
+{
+	XHandle data(chars);
+	{
+	XLocker lock(data);
+		BlockMoveData(text, data.GetPtr(), chars);
+	}
+
+	return data;
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class XBase64UnitTest
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// XBase64UnitTest::~XBase64UnitTest
+//
+//---------------------------------------------------------------
+XBase64UnitTest::~XBase64UnitTest()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64UnitTest::XBase64UnitTest
+//
+//---------------------------------------------------------------
+XBase64UnitTest::XBase64UnitTest() : XUnitTest(L"Backend", L"Base64")
+{
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XBase64UnitTest::OnTest
+//
+//---------------------------------------------------------------
+void XBase64UnitTest::OnTest()
+{
+	this->DoTestBuffers();
+	this->DoTestModes();
+	this->DoTestStreams();
+	this->DoTestStreamPadding();
+	this->DoTimeCodecs();
+
+	TRACE("Completed base64 test.\n\n");
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XBase64UnitTest::DoTestBuffers
+//
+//---------------------------------------------------------------
+void XBase64UnitTest::DoTestBuffers()
+{
+	uint8 data[256];
+	char text[512];
+	uint8 decoded[3*sizeof(text)/4];				// GetBase64DecodedSize counts the line breaks too
+
+	FillRandom(data, sizeof(data));
+
+	for (uint32 bytes = 0; bytes < sizeof(data); ++bytes) {
+		for (uint32 lineLength = 0; lineLength <= 76; lineLength += 4) {
+			uint32 chars = EncodeBase64(data, bytes, text, lineLength);
+			ASSERT(chars == GetBase64EncodedSize(bytes, lineLength));
+			ASSERT(GetBase64DecodedSize(chars) <= sizeof(decoded));
+
+			uint32 count = DecodeBase64(text, chars, decoded, kLenientBase64);
+			ASSERT(count == bytes);
+			ASSERT(EqualMemory(data, decoded, bytes));
+
+			if (lineLength == 0) {
+				count = DecodeBase64(text, chars, decoded, kStrictBase64);
+				ASSERT(count == bytes);
+				ASSERT(EqualMemory(data, decoded, bytes));
+			}
+		}
+
+		std::string str = EncodeBase64(data, bytes);			// the std::string version should match the caller buffer version
+		uint32 chars = EncodeBase64(data, bytes, text, kBase64LineLength);
+		ASSERT(str == std::string(text, chars));
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64UnitTest::DoTestModes
+//
+//---------------------------------------------------------------
+void XBase64UnitTest::DoTestModes()
+{
+	uint8 buffer[64];
+
+	// lenient mode skips characters that aren't in the alphabet
+	const char* spaced = "SGVs\r\nbG8g V29y\tbGQh";
+	uint32 bytes = DecodeBase64(spaced, std::strlen(spaced), buffer, kLenientBase64);
+	ASSERT(bytes == 12);
+	ASSERT(EqualMemory(buffer, "Hello World!", 12));
+
+	// and stops at the padding
+	bytes = DecodeBase64("SGk=garbage", 11, buffer, kLenientBase64);
+	ASSERT(bytes == 2);
+	ASSERT(EqualMemory(buffer, "Hi", 2));
+
+	// a lone character at the end still decodes into a byte (as it did before the SIMD code)
+	bytes = DecodeBase64("SGVsQ=", 6, buffer, kLenientBase64);
+	ASSERT(bytes == 4);
+	ASSERT(EqualMemory(buffer, "Hel@", 4));
+
+	bytes = DecodeBase64("SGVsQ", 5, buffer, kLenientBase64);
+	ASSERT(bytes == 4);
+	ASSERT(EqualMemory(buffer, "Hel@", 4));
+
+	// strict mode rejects everything else
+	const char* bad[] = {"SGVs\nbG8g", "SGk", "SG=k", "SGk=SGk=", "S*Vs"};
+	for (uint32 i = 0; i < sizeof(bad)/sizeof(bad[0]); ++i) {
+		bool threw = false;
+		try {
+			(void) DecodeBase64(bad[i], std::strlen(bad[i]), buffer, kStrictBase64);
+		} catch (const std::invalid_argument&) {
+			threw = true;
+		}
+		ASSERT(threw);
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64UnitTest::DoTestStreams
+//
+//---------------------------------------------------------------
+void XBase64UnitTest::DoTestStreams()
+{
+	const uint32 kBytes = 50000;
+
+	XHandle data(kBytes);
+	{
+	XLocker lock(data);
+		FillRandom(data.GetPtr(), kBytes);
+	}
+
+	// write the data out in odd sized chunks
+	XOutHandleStream text;
+	{
+	XBase64OutStream encoder(text);
+	XLocker lock(data);
+		uint32 offset = 0;
+		while (offset < kBytes) {
+			uint32 count = Min(Random(1UL, 5000UL), kBytes - offset);
+			encoder.WriteBytes(data.GetPtr() + offset, count);
+			offset += count;
+		}
+		ASSERT(encoder.GetBytesWritten() == kBytes);
+	}
+
+	// the text should be identical to what EncodeBase64 produces
+	XHandle encoded = text.GetHandle();
+	{
+	XLocker lock1(data);
+	XLocker lock2(encoded);
+		std::string expected = EncodeBase64(data.GetPtr(), kBytes);
+		ASSERT(expected.length() == encoded.GetSize());
+		ASSERT(EqualMemory(expected.c_str(), encoded.GetPtr(), encoded.GetSize()));
+	}
+
+	// and should read back in the same odd sized chunks
+	XInHandleStream source(encoded);
+	XBase64InStream decoder(source);
+	ASSERT(decoder.GetLength() == kBytes);
+
+	XHandle result(kBytes);
+	{
+	XLocker lock(result);
+		uint32 offset = 0;
+		while (!decoder.AtEnd()) {
+			uint32 count = Min(Random(1UL, 5000UL), kBytes - offset);
+			decoder.ReadBytes(result.GetPtr() + offset, count);
+			offset += count;
+		}
+		ASSERT(offset == kBytes);
+	}
+	ASSERT(result == data);
+
+	// seeking backwards restarts the decode
+	uint8 byte;
+	decoder.SetPosition(1234);
+	decoder.ReadBytes(&byte, 1);
+	ASSERT(byte == data.GetUnsafePtr()[1234]);
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64UnitTest::DoTestStreamPadding
+//
+// XBase64InStream has to stop right after the padding so that
+// the text following the base64 block can still be read.
+//
+//---------------------------------------------------------------
+void XBase64UnitTest::DoTestStreamPadding()
+{
+	uint8 buffer[64];
+
+	const char* texts[]    = {"SGk=\nrest", "SA==rest", "SGk=rest", "SGVsbG8=SGk=", "SGVsQ"};
+	const char* decoded[]  = {"Hi", "H", "Hi", "Hello", "Hel@"};
+	const char* rests[]    = {"\nrest", "rest", "rest", "SGk=", ""};
+	EBase64Mode modes[]    = {kLenientBase64, kLenientBase64, kStrictBase64, kStrictBase64, kLenientBase64};
+
+	for (uint32 i = 0; i < sizeof(texts)/sizeof(texts[0]); ++i) {
+		XInHandleStream source(CreateHandle(texts[i], std::strlen(texts[i])));
+		XBase64InStream decoder(source, modes[i]);
+
+		uint32 bytes = std::strlen(decoded[i]);
+		ASSERT(decoder.GetLength() == bytes);
+
+		decoder.ReadBytes(buffer, bytes);
+		ASSERT(EqualMemory(buffer, decoded[i], bytes));
+		ASSERT(decoder.AtEnd());
+
+		uint32 count = source.GetLength() - source.GetPosition();
+		ASSERT(count == std::strlen(rests[i]));
+		source.ReadBytes(buffer, count);
+		ASSERT(EqualMemory(buffer, rests[i], count));
+	}
+
+	// the padding can straddle two chunks of source text (the leading
+	// space puts the first '=' at the end of the first chunk)
+	const uint32 kBytes = 3070;
+	uint8 data[kBytes];
+	FillRandom(data, kBytes);
+
+	std::string text = " " + std::string(GetBase64EncodedSize(kBytes), '\0') + "tail";
+	uint32 chars = EncodeBase64(data, kBytes, &text[1]);
+	ASSERT(chars == 4096 && text[4095] == '=' && text[4096] == '=');
+
+	XInHandleStream source(CreateHandle(text.c_str(), text.length()));
+	XBase64InStream decoder(source);
+	ASSERT(decoder.GetLength() == kBytes);
+
+	uint8 result[kBytes];
+	decoder.ReadBytes(result, kBytes);
+	ASSERT(EqualMemory(result, data, kBytes));
+	ASSERT(decoder.AtEnd());
+
+	ASSERT(source.GetLength() - source.GetPosition() == 4);
+	source.ReadBytes(buffer, 4);
+	ASSERT(EqualMemory(buffer, "tail", 4));
+}
+
+
+//---------------------------------------------------------------
+//
+// XBase64UnitTest::DoTimeCodecs
+//
+//---------------------------------------------------------------
+void XBase64UnitTest::DoTimeCodecs()
+{
+	XHandle data(kTimingBytes);
+	XHandle text(GetBase64EncodedSize(kTimingBytes, kBase64LineLength));
+
+	XLocker lock1(data);
+	XLocker lock2(text);
+	FillRandom(data.GetPtr(), kTimingBytes);
+
+	char* chars = reinterpret_cast<char*>(text.GetPtr());
+
+	MilliSecond start = GetMilliSeconds();
+	for (uint32 i = 0; i < kTimingPasses; ++i)
+		(void) EncodeBase64(data.GetPtr(), kTimingBytes, chars, 0);
+	MilliSecond strictEncode = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kTimingPasses; ++i)
+		(void) DecodeBase64(chars, GetBase64EncodedSize(kTimingBytes), data.GetPtr(), kStrictBase64);
+	MilliSecond strictDecode = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kTimingPasses; ++i)
+		(void) EncodeBase64(data.GetPtr(), kTimingBytes, chars, kBase64LineLength);
+	MilliSecond lineEncode = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kTimingPasses; ++i)
+		(void) DecodeBase64(chars, text.GetSize(), data.GetPtr(), kLenientBase64);
+	MilliSecond lenientDecode = GetMilliSeconds() - start;
+
+	TRACE("Base64 timing (", kTimingBytes/(1024*1024), "MB x ", kTimingPasses, "):\n");
+	TRACE("   encode:              ", GetRate((double) kTimingBytes*kTimingPasses, strictEncode, kGigabyte), " GB/s\n");
+	TRACE("   encode (line breaks): ", GetRate((double) kTimingBytes*kTimingPasses, lineEncode, kGigabyte), " GB/s\n");
+	TRACE("   decode (strict):      ", GetRate((double) kTimingBytes*kTimingPasses, strictDecode, kGigabyte), " GB/s\n");
+	TRACE("   decode (lenient):     ", GetRate((double) kTimingBytes*kTimingPasses, lenientDecode, kGigabyte), " GB/s\n");
+}
+
+
+#endif	// DEBUG
+}		// namespace Whisper
+
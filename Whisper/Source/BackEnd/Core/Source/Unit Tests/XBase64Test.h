@@ -0,0 +1,62 @@
+/*
+ *  File:       XBase64Test.h
+ *  Summary:   	Unit test and benchmark for the base64 encoder/decoder.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XBase64Test.h,v $
+ */
+
+#pragma once
+
+#include <XUnitTest.h>
+
+#if DEBUG
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class XBase64UnitTest
+// ===================================================================================	
+class XBase64UnitTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~XBase64UnitTest();
+	
+						XBase64UnitTest();
+						
+//-----------------------------------
+//	API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+private:
+			void 		DoTestBuffers();
+			void 		DoTestModes();
+			void 		DoTestStreams();
+			void 		DoTestStreamPadding();
+			void 		DoTimeCodecs();
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}		// namespace Whisper
+#endif	// DEBUG
@@ -0,0 +1,421 @@
+/*
+ *  File:       XBroadcasterTest.cpp
+ *  Summary:   	XBroadcasterMixin unit test and contention benchmark.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XBroadcasterTest.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XBroadcasterTest.h>
+
+#include <vector>
+
+#include <XAtomicCounter.h>
+#include <XBind.h>
+#include <XDebug.h>
+#include <XListener.h>
+#include <XMiscUtils.h>
+#include <XNumbers.h>
+#include <XThread.h>
+#include <XUnitTestUtils.h>
+
+#if MAC
+	#include <MSystemInfo.h>
+#endif
+
+namespace Whisper {
+#if DEBUG
+
+
+//-----------------------------------
+//	Internal Constants
+//
+const uint32 kNumThreads    = 8;
+const uint32 kNumListeners  = 8;
+const uint32 kNumChurners   = 4;
+const uint32 kNumBroadcasts = 200000;				// per thread
+
+
+// ===================================================================================
+//	Internal Types
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// CCounter
+//
+//---------------------------------------------------------------
+class CCounter : public XListenerMixin<int32> {
+
+public:
+						CCounter()								{}
+
+	virtual void 		OnBroadcast(const int32& message)		{UNUSED(message); ++mCount;}
+
+public:
+	XAtomicCounter		mCount;
+};
+
+
+//---------------------------------------------------------------
+//
+// CRemover
+//
+// Removes (or deletes) a listener the first time it's called.
+//
+//---------------------------------------------------------------
+class CRemover : public XListenerMixin<int32> {
+
+public:
+						CRemover(XBroadcasterMixin<int32>* broadcaster, CCounter* victim, bool kill) : mBroadcaster(broadcaster), mVictim(victim), mKill(kill) {}
+
+	virtual void 		OnBroadcast(const int32& message);
+
+private:
+	XBroadcasterMixin<int32>*	mBroadcaster;
+	CCounter*					mVictim;
+	bool						mKill;
+};
+
+
+void CRemover::OnBroadcast(const int32& message)
+{
+	UNUSED(message);
+
+	if (mVictim != nil) {
+		if (mKill)
+			delete mVictim;						// removes itself from the broadcaster
+		else
+			mBroadcaster->RemoveListener(mVictim);
+		mVictim = nil;
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// COneShot
+//
+// Removes itself the first time it's called and adds another
+// listener.
+//
+//---------------------------------------------------------------
+class COneShot : public XListenerMixin<int32> {
+
+public:
+						COneShot(XBroadcasterMixin<int32>* broadcaster, CCounter* next) : mBroadcaster(broadcaster), mNext(next), mCount(0) {}
+
+	virtual void 		OnBroadcast(const int32& message);
+
+public:
+	XBroadcasterMixin<int32>*	mBroadcaster;
+	CCounter*					mNext;
+	int32						mCount;
+};
+
+
+void COneShot::OnBroadcast(const int32& message)
+{
+	UNUSED(message);
+
+	++mCount;
+
+	mBroadcaster->RemoveListener(this);
+	mBroadcaster->AddListener(mNext);
+}
+
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class XBroadcasterTest
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// XBroadcasterTest::~XBroadcasterTest
+//
+//---------------------------------------------------------------
+XBroadcasterTest::~XBroadcasterTest()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XBroadcasterTest::XBroadcasterTest
+//
+//---------------------------------------------------------------
+XBroadcasterTest::XBroadcasterTest() : XUnitTest(L"Backend", L"Broadcaster")
+{
+	mDone = false;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBroadcasterTest::OnTest
+//
+//---------------------------------------------------------------
+void XBroadcasterTest::OnTest()
+{
+	this->DoTestListeners();
+	this->DoTestRemoval();
+
+#if MAC
+	if (!MSystemInfo::HasThreadMgr()) {
+		TRACE("Skipped the broadcaster benchmark (the Thread Manager isn't installed).\n\n");
+		return;
+	}
+#endif
+
+	this->DoTime();
+
+	TRACE("Completed broadcaster test.\n\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// XBroadcasterTest::DoTestListeners
+//
+//---------------------------------------------------------------
+void XBroadcasterTest::DoTestListeners()
+{
+	XBroadcasterMixin<int32> broadcaster;
+	ASSERT(!broadcaster.HasListeners());
+
+	broadcaster.Broadcast(1);
+
+	CCounter a, b, c;
+	broadcaster.AddListener(&a);
+	broadcaster.AddListener(&b);
+	ASSERT(broadcaster.HasListeners());
+
+	broadcaster.Broadcast(1);
+	ASSERT(a.mCount == 1);
+	ASSERT(b.mCount == 1);
+
+	broadcaster.AddListener(&c);
+	broadcaster.RemoveListener(&a);
+	broadcaster.Broadcast(1);
+	ASSERT(a.mCount == 1);
+	ASSERT(b.mCount == 2);
+	ASSERT(c.mCount == 1);
+
+	b.DisableListening();
+	broadcaster.DisableBroadcasting();
+	broadcaster.Broadcast(1);
+	ASSERT(c.mCount == 1);
+
+	broadcaster.EnableBroadcasting();
+	broadcaster.Broadcast(1);
+	ASSERT(b.mCount == 2);
+	ASSERT(c.mCount == 2);
+	b.EnableListening();
+
+	{
+	CCounter d;
+	broadcaster.AddListener(&d);
+	}
+	broadcaster.Broadcast(1);					// d removed itself when it was destroyed
+	ASSERT(b.mCount == 3);
+
+	broadcaster.RemoveAllListeners();
+	ASSERT(!broadcaster.HasListeners());
+
+	broadcaster.Broadcast(1);
+	ASSERT(b.mCount == 3);
+	ASSERT(c.mCount == 3);
+
+	// Listeners remove themselves when the broadcaster goes away.
+	{
+	XBroadcasterMixin<int32> temp;
+	temp.AddListener(&a);
+	temp.AddListener(&b);
+	}
+	broadcaster.AddListener(&a);
+	broadcaster.Broadcast(1);
+	ASSERT(a.mCount == 2);
+}
+
+
+//---------------------------------------------------------------
+//
+// XBroadcasterTest::DoTestRemoval
+//
+// Listeners that are removed or deleted during a broadcast aren't
+// called and listeners that are added aren't called until the next
+// broadcast.
+//
+//---------------------------------------------------------------
+void XBroadcasterTest::DoTestRemoval()
+{
+	XBroadcasterMixin<int32> broadcaster;
+
+	CCounter first, last;
+	CCounter* victim = new CCounter;
+	CCounter* killed = new CCounter;
+	CRemover remover(&broadcaster, victim, false);
+	CRemover killer(&broadcaster, killed, true);
+
+	broadcaster.AddListener(&first);
+	broadcaster.AddListener(&remover);
+	broadcaster.AddListener(&killer);
+	broadcaster.AddListener(victim);
+	broadcaster.AddListener(killed);
+	broadcaster.AddListener(&last);
+
+	broadcaster.Broadcast(1);
+	ASSERT(first.mCount == 1);
+	ASSERT(victim->mCount == 0);
+	ASSERT(last.mCount == 1);
+
+	broadcaster.Broadcast(1);
+	ASSERT(first.mCount == 2);
+	ASSERT(last.mCount == 2);
+
+	delete victim;
+
+	// One shot listeners
+	CCounter next;
+	COneShot once(&broadcaster, &next);
+	broadcaster.AddListener(&once);
+
+	broadcaster.Broadcast(1);
+	ASSERT(once.mCount == 1);
+	ASSERT(next.mCount == 0);
+
+	broadcaster.Broadcast(1);
+	ASSERT(once.mCount == 1);
+	ASSERT(next.mCount == 1);
+}
+
+
+//---------------------------------------------------------------
+//
+// XBroadcasterTest::DoTime
+//
+// Several threads broadcast to the same listeners while another
+// thread keeps adding and removing listeners. The stable listeners
+// should see every broadcast.
+//
+//---------------------------------------------------------------
+void XBroadcasterTest::DoTime()
+{
+	CCounter listeners[kNumListeners];
+	for (uint32 i = 0; i < kNumListeners; ++i)
+		mBroadcaster.AddListener(listeners + i);
+
+	// Single thread
+	MilliSecond start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumBroadcasts; ++i)
+		mBroadcaster.Broadcast(1);
+	MilliSecond single = GetMilliSeconds() - start;
+
+	// Many threads
+	XIOU<uint32> churned;
+	std::vector<XIOU<uint32> > broadcasts;
+	for (uint32 i = 0; i < kNumThreads; ++i)
+		broadcasts.push_back(XIOU<uint32>());		// XIOU's are references so we can't use the vector fill ctor
+	mDone = false;
+
+	start = GetMilliSeconds();
+	{
+	XCallback1<void, XIOU<uint32>&> temp(this, &XBroadcasterTest::DoChurnLoop);
+	XThread::ErrorHandler errors(&churned, &XIOU<uint32>::Abort);
+
+	XThread* thread = XThread::Create(Bind1(temp, churned), errors);
+	thread->Start();
+	thread->RemoveReference();
+	}
+
+	for (uint32 i = 0; i < kNumThreads; ++i) {
+		XCallback1<void, XIOU<uint32>&> temp(this, &XBroadcasterTest::DoBroadcastLoop);
+		XThread::ErrorHandler errors(&broadcasts[i], &XIOU<uint32>::Abort);
+
+		XThread* thread = XThread::Create(Bind1(temp, broadcasts[i]), errors);
+		thread->Start();
+		thread->RemoveReference();
+	}
+
+	uint32 total = 0;
+	for (uint32 i = 0; i < kNumThreads; ++i) {
+		broadcasts[i].Wait();
+		ASSERT(broadcasts[i].Redeemable());
+
+		total += broadcasts[i].Redeem();
+	}
+	MilliSecond multiple = GetMilliSeconds() - start;
+
+	mDone = true;
+	churned.Wait();
+	ASSERT(churned.Redeemable());
+
+	for (uint32 i = 0; i < kNumListeners; ++i)
+		ASSERT(listeners[i].mCount == (int32) (kNumBroadcasts + total));
+
+	mBroadcaster.RemoveAllListeners();
+
+	TRACE("Broadcasting to ", kNumListeners, " listeners (broadcasts per second):\n");
+	TRACE("   1 thread: ", GetRate(kNumBroadcasts, single), "\n");
+	TRACE("   ", kNumThreads, " threads: ", GetRate(total, multiple), " (", churned.Redeem(), " listeners added and removed)\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// XBroadcasterTest::DoBroadcastLoop
+//
+//---------------------------------------------------------------
+void XBroadcasterTest::DoBroadcastLoop(XIOU<uint32>& result)
+{
+	for (uint32 i = 0; i < kNumBroadcasts; ++i) {
+		mBroadcaster.Broadcast(1);
+
+		if ((i & 0xFF) == 0)
+			XThread::Yield();
+	}
+
+	result.Fulfill(kNumBroadcasts);
+}
+
+
+//---------------------------------------------------------------
+//
+// XBroadcasterTest::DoChurnLoop
+//
+// Note that the churners are removed, but not deleted, while other
+// threads are broadcasting (a listener that's removed while another
+// thread is calling it isn't waited for).
+//
+//---------------------------------------------------------------
+void XBroadcasterTest::DoChurnLoop(XIOU<uint32>& result)
+{
+	CCounter churners[kNumChurners];
+	uint32 count = 0;
+
+	while (!mDone) {
+		for (uint32 i = 0; i < kNumChurners; ++i)
+			mBroadcaster.AddListener(churners + i);
+
+		for (uint32 i = 0; i < kNumChurners; ++i)
+			mBroadcaster.RemoveListener(churners + i);
+
+		count += kNumChurners;
+		XThread::Yield();
+	}
+
+	result.Fulfill(count);
+}
+
+#endif	// DEBUG
+}		// namespace Whisper
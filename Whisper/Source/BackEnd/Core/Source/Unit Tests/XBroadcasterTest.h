@@ -0,0 +1,72 @@
+/*
+ *  File:       XBroadcasterTest.h
+ *  Summary:   	XBroadcasterMixin unit test and contention benchmark.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XBroadcasterTest.h,v $
+ */
+
+#pragma once
+
+#include <XBroadcaster.h>
+#include <XIOU.h>
+#include <XUnitTest.h>
+
+#if DEBUG
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class XBroadcasterTest
+// ===================================================================================	
+class XBroadcasterTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~XBroadcasterTest();
+	
+						XBroadcasterTest();
+						
+//-----------------------------------
+//	Inherited API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+private:
+			void 		DoTestListeners();
+			void 		DoTestRemoval();
+			
+			void 		DoTime();
+			void 		DoBroadcastLoop(XIOU<uint32>& result);
+			void 		DoChurnLoop(XIOU<uint32>& result);
+
+//-----------------------------------
+//	Member Data
+//
+private:
+	XBroadcasterMixin<int32>	mBroadcaster;		// used by DoTime
+	volatile bool				mDone;
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}		// namespace Whisper
+#endif	// DEBUG
@@ -24,13 +24,39 @@
 #include <XWhisperHeader.h>
 #include <XCallbacksTest.h>
 
+#include <XBind.h>
 #include <XCallbacks.h>
 #include <XDebug.h>
+#include <XMiscUtils.h>
+#include <XNumbers.h>
+#include <XUnitTestUtils.h>
 
 namespace Whisper {
 #if DEBUG
 
 
+//-----------------------------------
+//	Internal Constants
+//
+const uint32 kNumCalls = 2000000;
+
+
+// ===================================================================================
+//	Internal Types
+// ===================================================================================
+struct SAccumulator {
+	int32	total;
+	
+			SAccumulator() : total(0)		{}
+			
+	int32 	Add(int32 x)					{total += x; return total;}
+};
+
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
 // ===================================================================================
 //	class XCallbacksTest
 // ===================================================================================
@@ -70,6 +96,8 @@ void XCallbacksTest::OnTest()
 	this->DoFunction1Test();
 	this->Do2PlusTests();
 	this->DoVoidReturnTests();
+	this->DoEqualityTests();
+	this->DoTime();
 	
 	TRACE("Completed callbacks test.\n\n");
 }
@@ -249,6 +277,138 @@ void XCallbacksTest::DoVoidReturnTests()
 	ASSERT(mValue == 3);		
 }
 
+
+
+//---------------------------------------------------------------
+//
+// XCallbacksTest::DoEqualityTests
+//
+//---------------------------------------------------------------
+void XCallbacksTest::DoEqualityTests()
+{
+	typedef XCallback1<int32, int32> Callback;
+	
+	Callback empty;
+	ASSERT(!empty.IsValid());
+	ASSERT(empty == Callback());
+
+	// Functions
+	Callback function(XCallbacksTest::DoIdentity);
+	ASSERT(function.IsValid());
+	ASSERT(function != empty);
+	ASSERT(function == Callback(XCallbacksTest::DoIdentity));
+	ASSERT(function != Callback(XCallbacksTest::DoNegate));
+
+	// Methods
+	SAccumulator a, b;
+	Callback method(this, &XCallbacksTest::DoSubtract1);
+	ASSERT(method == Callback(this, &XCallbacksTest::DoSubtract1));
+	ASSERT(method != Callback(this, &XCallbacksTest::DoAdd));
+	ASSERT(Callback(&a, &SAccumulator::Add) == Callback(&a, &SAccumulator::Add));
+	ASSERT(Callback(&a, &SAccumulator::Add) != Callback(&b, &SAccumulator::Add));
+	ASSERT(method != function);
+	ASSERT((method < function) != (function < method));
+
+	// Copies
+	Callback copy(method);
+	ASSERT(copy == method);
+	ASSERT(copy(5) == 5);
+	
+	copy = function;
+	ASSERT(copy == function);
+	ASSERT(copy(5) == 5);
+	
+	copy = empty;
+	ASSERT(!copy.IsValid());
+
+	// Helpers wrapping a function or method compare equal to the inline form
+	typedef int32 (*Function)(int32);
+	typedef int32 (XCallbacksTest::*Method)(int32);
+	Callback wrappedFunction(new Internals::XCCallback1<Function, int32, int32>(XCallbacksTest::DoIdentity), 0, 0);
+	Callback wrappedMethod(new Internals::XObjCallback1<XCallbacksTest, Method, int32, int32>(this, &XCallbacksTest::DoSubtract1), 0, 0);
+	ASSERT(wrappedFunction == function);
+	ASSERT(function == wrappedFunction);
+	ASSERT(!(wrappedFunction < function) && !(function < wrappedFunction));
+	ASSERT(wrappedFunction != Callback(XCallbacksTest::DoNegate));
+	ASSERT(wrappedMethod == method);
+	ASSERT(method == wrappedMethod);
+	ASSERT(!(wrappedMethod < method) && !(method < wrappedMethod));
+	ASSERT(wrappedMethod != Callback(this, &XCallbacksTest::DoAdd));
+	ASSERT(wrappedMethod != wrappedFunction);
+	ASSERT(wrappedFunction != empty);
+
+	// Bound callbacks (these use the heap)
+	XCallback2<int32, int32, int32> sum(XCallbacksTest::Do2Sum);
+	Callback bound = Bind1(sum, 10, kUnbound);
+	ASSERT(bound(3) == 13);
+	ASSERT(bound == Bind1(sum, 10, kUnbound));
+	ASSERT(bound != Bind1(sum, 20, kUnbound));
+	ASSERT(bound != function);
+	ASSERT(bound != wrappedFunction);
+	ASSERT(function != bound);
+
+	copy = bound;
+	ASSERT(copy == bound);
+	ASSERT(copy(4) == 14);
+}
+
+
+//---------------------------------------------------------------
+//
+// XCallbacksTest::DoTime
+//
+//---------------------------------------------------------------
+void XCallbacksTest::DoTime()
+{
+	int32 sum = 0;
+	
+	// Construct
+	MilliSecond start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumCalls; ++i) {
+		XCallback1<int32, int32> callback(this, &XCallbacksTest::DoAdd);
+		sum += callback.IsValid();
+	}
+	MilliSecond construct = GetMilliSeconds() - start;
+
+	// Copy
+	XCallback1<int32, int32> callback(this, &XCallbacksTest::DoAdd);
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumCalls; ++i) {
+		XCallback1<int32, int32> copy(callback);
+		sum += copy.IsValid();
+	}
+	MilliSecond copy = GetMilliSeconds() - start;
+
+	// Invoke
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumCalls; ++i) 
+		sum += callback((int32) i);
+	MilliSecond invoke = GetMilliSeconds() - start;
+
+	XCallback1<int32, int32> function(XCallbacksTest::DoIdentity);
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumCalls; ++i) 
+		sum += function((int32) i);
+	MilliSecond invokeFunction = GetMilliSeconds() - start;
+
+	// Bound
+	XCallback2<int32, int32, int32> temp(XCallbacksTest::Do2Sum);
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumCalls; ++i) {
+		XCallback1<int32, int32> bound = Bind1(temp, 1, kUnbound);
+		sum += bound.IsValid();
+	}
+	MilliSecond bind = GetMilliSeconds() - start;
+	
+	TRACE("Callbacks (operations per second):\n");
+	TRACE("   construct method: ", GetRate(kNumCalls, construct), "\n");
+	TRACE("   copy method: ", GetRate(kNumCalls, copy), "\n");
+	TRACE("   invoke method: ", GetRate(kNumCalls, invoke), "\n");
+	TRACE("   invoke function: ", GetRate(kNumCalls, invokeFunction), "\n");
+	TRACE("   Bind1 (allocates): ", GetRate(kNumCalls, bind), "\n");
+	TRACE("   (", sum, ")\n");
+}
+
 #endif	// DEBUG
 }		// namespace Whisper
 
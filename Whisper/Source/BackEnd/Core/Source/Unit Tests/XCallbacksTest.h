@@ -78,6 +78,12 @@ protected:
 	static	void 		DoFoo(const char* x)		{(void) x;}
 
 			void 		Do2PlusTests();
+			void 		DoEqualityTests();
+			void 		DoTime();
+	static	int32 		DoIdentity(int32 x)							{return x;}
+	static	int32 		DoNegate(int32 x)							{return -x;}
+			int32 		DoAdd(int32 x)								{mValue += x; return mValue;}
+
 	static	int32 		Do2Sum(int32 x, int32 y)					{return x + y;}
 	static	int32 		Do3Sum(int32 x, int32 y, int32 z)			{return x + y + z;}
 	static	int32 		Do4Sum(int32 x, int32 y, int32 z, int32 w)	{return x + y + z + w;}
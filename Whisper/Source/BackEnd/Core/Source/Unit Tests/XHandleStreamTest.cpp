@@ -0,0 +1,241 @@
+/*
+ *  File:       XHandleStreamTest.cpp
+ *  Summary:   	Unit test and benchmark for the handle and rope streams.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XHandleStreamTest.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XHandleStreamTest.h>
+
+#include <XDebug.h>
+#include <XHandle.h>
+#include <XHandleSlice.h>
+#include <XHandleStream.h>
+#include <XLocker.h>
+#include <XMemUtils.h>
+#include <XMiscUtils.h>
+#include <XNumbers.h>
+#include <XRopeStream.h>
+#include <XStreaming.h>
+#include <XUnitTestUtils.h>
+
+namespace Whisper {
+#if DEBUG
+
+
+//-----------------------------------
+//	Constants
+//
+const uint32 kTimingWrites = 1000000L;
+
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class XHandleStreamUnitTest
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// XHandleStreamUnitTest::~XHandleStreamUnitTest
+//
+//---------------------------------------------------------------
+XHandleStreamUnitTest::~XHandleStreamUnitTest()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XHandleStreamUnitTest::XHandleStreamUnitTest
+//
+//---------------------------------------------------------------
+XHandleStreamUnitTest::XHandleStreamUnitTest() : XUnitTest(L"Backend", L"Handle Streams")
+{
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XHandleStreamUnitTest::OnTest
+//
+//---------------------------------------------------------------
+void XHandleStreamUnitTest::OnTest()
+{
+	this->DoTestSlices();
+	this->DoTestRope();
+	this->DoTimeWrites();
+
+	TRACE("Completed handle stream test.\n\n");
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XHandleStreamUnitTest::DoTestSlices
+//
+//---------------------------------------------------------------
+void XHandleStreamUnitTest::DoTestSlices()
+{
+	// write a header followed by some data
+	XOutHandleStream outStream;
+	outStream << (uint32) 0xDEADBEEF << (int32) 100 << std::wstring(L"hello");
+	
+	uint32 offset = outStream.GetPosition();
+	for (int32 i = 0; i < 100; ++i)
+		outStream << i;
+		
+	// slices share the handle's memory
+	XHandle data = outStream.GetHandle();
+	XHandleSlice slice(data, offset);
+	ASSERT(slice.GetSize() == data.GetSize() - offset);
+	ASSERT(slice.GetUnsafePtr() == data.GetUnsafePtr() + offset);
+	ASSERT(slice.GetHandle().GetUnsafePtr() == data.GetUnsafePtr());
+	
+	// and can be streamed from without copying
+	XInHandleStream inStream(slice);
+	ASSERT(inStream.GetLength() == slice.GetSize());
+	for (int32 i = 0; i < 100; ++i) {
+		int32 value;
+		inStream >> value;
+		ASSERT(value == i);
+	}
+	ASSERT(inStream.GetPosition() == inStream.GetLength());
+	
+	// slices of slices are relative to the parent slice
+	XHandleSlice sub = slice.GetSlice(10*sizeof(int32), 5*sizeof(int32));
+	ASSERT(sub.GetOffset() == offset + 10*sizeof(int32));
+	ASSERT(sub.GetSize() == 5*sizeof(int32));
+	
+	XHandle copy = sub.GetCopy();
+	ASSERT(copy.GetSize() == sub.GetSize());
+	ASSERT(copy.GetUnsafePtr() != sub.GetUnsafePtr());
+	ASSERT(XHandleSlice(copy) == sub);
+	
+	{
+	XLocker lock(sub);
+		ASSERT(sub.GetPtr() == data.GetUnsafePtr() + sub.GetOffset());
+	}
+	
+	// GetSlice on an output stream doesn't trim the handle
+	XOutHandleStream outStream2(64);
+	outStream2 << (int32) 1;
+	XHandleSlice written = outStream2.GetSlice();
+	ASSERT(written.GetSize() == sizeof(int32));
+	ASSERT(outStream2.GetCapacity() == 64);
+	
+	outStream2.Reserve(1000);
+	ASSERT(outStream2.GetCapacity() >= 1000 + sizeof(int32));
+}
+
+
+//---------------------------------------------------------------
+//
+// XHandleStreamUnitTest::DoTestRope
+//
+//---------------------------------------------------------------
+void XHandleStreamUnitTest::DoTestRope()
+{
+	const uint32 kBytes = 100000;
+
+	XHandle data(kBytes);
+	FillRandom(data.GetUnsafePtr(), kBytes);
+
+	// write the data in odd sized chunks
+	XOutRopeStream rope(100);
+	XOutHandleStream flat;
+	
+	uint32 offset = 0;
+	while (offset < kBytes) {
+		uint32 count = Min(Random(1UL, 5000UL), kBytes - offset);
+		rope.WriteBytes(data.GetUnsafePtr() + offset, count);
+		offset += count;
+		
+		if (Random(10L) == 0 && offset + 200 <= kBytes) {
+			rope.Reserve(200);					// reserved bytes should wind up in one segment
+			uint32 segments = rope.GetSegmentCount();
+			rope.WriteBytes(data.GetUnsafePtr() + offset, 200);
+			ASSERT(rope.GetSegmentCount() == segments);
+			offset += 200;
+		}
+	}
+	ASSERT(rope.GetLength() == kBytes);
+	
+	// segments should never move
+	const uint8* first = rope.GetSegmentPtr(0);
+	rope.WriteBytes(data.GetUnsafePtr(), kBytes);
+	ASSERT(rope.GetSegmentPtr(0) == first);
+	ASSERT(rope.GetLength() == 2*kBytes);
+	
+	// and should flatten to the original data
+	XHandle result = rope.GetHandle();
+	ASSERT(result.GetSize() == 2*kBytes);
+	ASSERT(EqualMemory(result.GetUnsafePtr(), data.GetUnsafePtr(), kBytes));
+	ASSERT(EqualMemory(result.GetUnsafePtr() + kBytes, data.GetUnsafePtr(), kBytes));
+	
+	rope.WriteTo(flat);
+	ASSERT(flat.GetHandle() == result);
+	
+	rope.Clear();
+	ASSERT(rope.GetLength() == 0);
+	ASSERT(rope.GetSegmentCount() == 0);
+}
+
+
+//---------------------------------------------------------------
+//
+// XHandleStreamUnitTest::DoTimeWrites
+//
+//---------------------------------------------------------------
+void XHandleStreamUnitTest::DoTimeWrites()
+{
+	MilliSecond start = GetMilliSeconds();
+	{
+	XOutHandleStream stream;
+		for (uint32 i = 0; i < kTimingWrites; ++i)
+			stream << i;
+	}
+	MilliSecond growTime = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	{
+	XOutHandleStream stream;
+		stream.Reserve(kTimingWrites*sizeof(uint32));
+		for (uint32 i = 0; i < kTimingWrites; ++i)
+			stream << i;
+	}
+	MilliSecond reserveTime = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	{
+	XOutRopeStream stream;
+		for (uint32 i = 0; i < kTimingWrites; ++i)
+			stream << i;
+	}
+	MilliSecond ropeTime = GetMilliSeconds() - start;
+
+	TRACE("Stream timing (", kTimingWrites, " uint32 writes):\n");
+	TRACE("   XOutHandleStream:           ", growTime, " ms\n");
+	TRACE("   XOutHandleStream (Reserve): ", reserveTime, " ms\n");
+	TRACE("   XOutRopeStream:             ", ropeTime, " ms\n");
+}
+
+
+#endif	// DEBUG
+}		// namespace Whisper
+
@@ -0,0 +1,60 @@
+/*
+ *  File:       XHandleStreamTest.h
+ *  Summary:   	Unit test and benchmark for the handle and rope streams.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XHandleStreamTest.h,v $
+ */
+
+#pragma once
+
+#include <XUnitTest.h>
+
+#if DEBUG
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class XHandleStreamUnitTest
+// ===================================================================================	
+class XHandleStreamUnitTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~XHandleStreamUnitTest();
+	
+						XHandleStreamUnitTest();
+						
+//-----------------------------------
+//	API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+private:
+			void 		DoTestSlices();
+			void 		DoTestRope();
+			void 		DoTimeWrites();
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}		// namespace Whisper
+#endif	// DEBUG
@@ -21,16 +21,22 @@
 #include <XWhisperHeader.h>
 #include <XRegisterCoreTests.h>
 
+#include <XArrayTest.h>
+#include <XBase64Test.h>
 #include <XBindTest.h>
+#include <XBroadcasterTest.h>
 #include <XCallbacksTest.h>
 #include <XFloatConversionsTest.h>
+#include <XHandleStreamTest.h>
 #include <XIntConversionsTest.h>
 #include <XIOUTest.h>
 #include <XMemUtilsTest.h>
 #include <XNumbersTest.h>
+#include <XSparseArrayTest.h>
 #include <XStreamingTest.h>
 #include <XStringUtilsTest.h>
 #include <XTextTranscodersTest.h>		
+#include <XTinyVectorTest.h>
 
 #if DEBUG
 namespace Whisper {
@@ -53,14 +59,20 @@ void RegisterCoreTests()
 {
 	static XNumbersTest 		sNumbersTest;
 	static XMemUtilsUnitTest 	sMemUtilsTest;
+	static XBase64UnitTest 		sBase64Test;
 	static XTranscoderUnitTest 	sTranscoderTest;
 	static XStringUtilsUnitTest sStringUtilsTest;
 	static XIntConvUnitTest 	sIntConvTest;
 	static XFloatConvUnitTest 	sFloatConvTest;
 	static XStreamUnitTest 		sStreamTest;
+	static XHandleStreamUnitTest sHandleStreamTest;
+	static XSparseArrayUnitTest sSparseArrayTest;
+	static XArrayUnitTest 		sArrayTest;
+	static XTinyVectorUnitTest	sTinyVectorTest;
 	static XCallbacksTest 		sCallbacksTest;
 	static XBindTest 			sBindTest;
 	static XIOUTest 			sIOUTest;
+	static XBroadcasterTest 	sBroadcasterTest;
 }
 
 
@@ -0,0 +1,318 @@
+/*
+ *  File:       XSparseArrayTest.cpp
+ *  Summary:   	Unit test and benchmark for the sparse array classes.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XSparseArrayTest.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XSparseArrayTest.h>
+
+#include <XDebug.h>
+#include <XHandle.h>
+#include <XHandleStream.h>
+#include <XLocker.h>
+#include <XMemUtils.h>
+#include <XMiscUtils.h>
+#include <XNumbers.h>
+#include <XSparseArray.h>
+#include <XStreaming.h>
+#include <XTiledSparseArray.h>
+
+namespace Whisper {
+#if DEBUG
+
+
+//-----------------------------------
+//	Constants
+//
+const int32  kTimingSize     = 1024;
+const uint32 kTimingAccesses = 1000000L;
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// GetMapBytes
+//
+// Rough estimate of the memory used by XSparseArray (a red-black
+// tree node has three pointers and a color).
+//
+//---------------------------------------------------------------
+static uint32 GetMapBytes(uint32 elements)
+{
+	return sizeof(XSparseArray<int32>) + elements*(sizeof(XPoint) + sizeof(int32) + 4*sizeof(void*));
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class XSparseArrayUnitTest
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// XSparseArrayUnitTest::~XSparseArrayUnitTest
+//
+//---------------------------------------------------------------
+XSparseArrayUnitTest::~XSparseArrayUnitTest()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XSparseArrayUnitTest::XSparseArrayUnitTest
+//
+//---------------------------------------------------------------
+XSparseArrayUnitTest::XSparseArrayUnitTest() : XUnitTest(L"Backend", L"Sparse Arrays")
+{
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XSparseArrayUnitTest::OnTest
+//
+//---------------------------------------------------------------
+void XSparseArrayUnitTest::OnTest()
+{
+	this->DoTestAccess();
+	this->DoTestStreaming();
+
+	this->DoTimeArrays(0.001);
+	this->DoTimeArrays(0.01);
+	this->DoTimeArrays(0.1);
+	this->DoTimeArrays(0.5);
+
+	TRACE("Completed sparse array test.\n\n");
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XSparseArrayUnitTest::DoTestAccess
+//
+//---------------------------------------------------------------
+void XSparseArrayUnitTest::DoTestAccess()
+{
+	XRect shape(-50, -40, 250, 160);				// negative indices exercise the tile rounding
+
+	XSparseArray<int32> sparse(shape, 7);
+	XTiledSparseArray<int32> tiled(shape, 7);
+
+	for (uint32 i = 0; i < 5000; ++i) {
+		int32 col = Random(shape.left, shape.right);
+		int32 row = Random(shape.top, shape.bottom);
+		int32 value = Random(5L, 10L);
+
+		sparse(col, row) = value;
+		tiled(col, row) = value;
+	}
+
+	// element access
+	uint32 count = 0;
+	for (int32 row = shape.top; row < shape.bottom; ++row) {
+		for (int32 col = shape.left; col < shape.right; ++col) {
+			const XTiledSparseArray<int32>& constTiled = tiled;
+			ASSERT(constTiled(col, row) == sparse(col, row));
+			ASSERT(tiled.IsSparse(col, row) == (sparse(col, row) == 7));
+
+			if (!tiled.IsSparse(col, row))
+				++count;
+		}
+	}
+	ASSERT(tiled.GetMemoryUsage().elements == count);
+
+	// element iterators
+	uint32 visited = 0;
+	XTiledSparseArray<int32>::iterator iter = tiled.begin();
+	while (iter != tiled.end()) {
+		ASSERT(*iter != 7);
+		ASSERT(*iter == sparse(iter.GetCol(), iter.GetRow()));
+		++iter;
+		++visited;
+	}
+	ASSERT(visited == count);
+
+	// span iterators
+	XRect rect(-33, -7, 201, 99);
+	XTiledSparseArray<int32>::const_span_iterator spans = tiled.begin_spans(rect);
+	while (spans != tiled.end_spans(rect)) {
+		for (uint32 i = 0; i < spans.GetCount(); ++i)
+			ASSERT(spans[i] == sparse(spans.GetCol() + (int32) i, spans.GetRow()));
+		++spans;
+	}
+
+	int32 row[300];
+	tiled.CopyRow(17, shape.left, shape.right, row);
+	for (int32 col = shape.left; col < shape.right; ++col)
+		ASSERT(row[col - shape.left] == sparse(col, 17));
+
+	// bulk writes and Reduce
+	tiled.Fill(XRect(0, 0, 100, 100), 3);
+	ASSERT(tiled(99, 99) == 3);
+
+	XTiledSparseArray<int32> copy = tiled;
+	copy.Fill(XRect(0, 0, 100, 100), 7);
+	ASSERT(copy(50, 50) == 7);
+	ASSERT(tiled(50, 50) == 3);
+
+	uint32 tiles = copy.GetMemoryUsage().tiles;
+	copy.Reduce();
+	ASSERT(copy.GetMemoryUsage().tiles < tiles);
+	ASSERT(copy(50, 50) == 7);
+
+	// shapes
+	copy.SetShape(XRect(10, 10, 50, 50));
+	for (iter = copy.begin(); iter != copy.end(); ++iter)
+		ASSERT(XRect(10, 10, 50, 50).Contains(XPoint(iter.GetCol(), iter.GetRow())));
+
+	copy.Force(60, 70, 1);
+	ASSERT(copy.GetShape() == XRect(10, 10, 61, 71));
+	ASSERT(copy(60, 70) == 1);
+}
+
+
+//---------------------------------------------------------------
+//
+// XSparseArrayUnitTest::DoTestStreaming
+//
+//---------------------------------------------------------------
+void XSparseArrayUnitTest::DoTestStreaming()
+{
+	XRect shape(-20, -20, 500, 300);
+
+	XSparseArray<int32> sparse(shape, -1);
+	XTiledSparseArray<int32> tiled(shape, -1);
+
+	for (uint32 i = 0; i < 2000; ++i) {
+		int32 col = Random(shape.left, shape.right);
+		int32 row = Random(shape.top, shape.bottom);
+		int32 value = Random(1000L);
+
+		sparse(col, row) = value;
+		tiled(col, row) = value;
+	}
+	sparse.Reduce();
+
+	// the tiled array should write out exactly the same bytes as the reduced sparse array
+	XOutHandleStream sparseStream, tiledStream;
+	sparseStream << sparse;
+	tiledStream << tiled;
+
+	XHandle sparseData = sparseStream.GetHandle();
+	XHandle tiledData = tiledStream.GetHandle();
+	ASSERT(sparseData == tiledData);
+
+	// and either one can read the other's data
+	XTiledSparseArray<int32> tiled2;
+	XInHandleStream inStream(sparseData);
+	inStream >> tiled2;
+
+	XSparseArray<int32> sparse2;
+	XInHandleStream inStream2(tiledData);
+	inStream2 >> sparse2;
+
+	ASSERT(tiled2.GetShape() == shape);
+	ASSERT(sparse2.GetShape() == shape);
+	for (int32 row = shape.top; row < shape.bottom; ++row) {
+		for (int32 col = shape.left; col < shape.right; ++col) {
+			ASSERT(tiled2(col, row) == sparse(col, row));
+			ASSERT(sparse2(col, row) == sparse(col, row));
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XSparseArrayUnitTest::DoTimeArrays
+//
+//---------------------------------------------------------------
+void XSparseArrayUnitTest::DoTimeArrays(double fill)
+{
+	XSize size(kTimingSize, kTimingSize);
+	uint32 elements = (uint32) (fill*kTimingSize*kTimingSize);
+
+	XSparseArray<int32> sparse(size, 0);
+	XTiledSparseArray<int32> tiled(size, 0);
+
+	// fill
+	MilliSecond start = GetMilliSeconds();
+	for (uint32 i = 0; i < elements; ++i)
+		sparse(Random(kTimingSize), Random(kTimingSize)) = 1;
+	MilliSecond sparseFill = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < elements; ++i)
+		tiled(Random(kTimingSize), Random(kTimingSize)) = 1;
+	MilliSecond tiledFill = GetMilliSeconds() - start;
+
+	// random access
+	const XSparseArray<int32>& constSparse = sparse;
+	const XTiledSparseArray<int32>& constTiled = tiled;
+
+	int32 sparseSum = 0;
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kTimingAccesses; ++i)
+		sparseSum += constSparse(Random(kTimingSize), Random(kTimingSize));
+	MilliSecond sparseRandom = GetMilliSeconds() - start;
+
+	int32 tiledSum = 0;
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kTimingAccesses; ++i)
+		tiledSum += constTiled(Random(kTimingSize), Random(kTimingSize));
+	MilliSecond tiledRandom = GetMilliSeconds() - start;
+
+	// row scans
+	sparseSum = 0;
+	start = GetMilliSeconds();
+	for (int32 row = 0; row < kTimingSize; ++row)
+		for (int32 col = 0; col < kTimingSize; ++col)
+			sparseSum += constSparse(col, row);
+	MilliSecond sparseScan = GetMilliSeconds() - start;
+
+	tiledSum = 0;
+	start = GetMilliSeconds();
+	XRect rect(0, 0, kTimingSize, kTimingSize);
+	XTiledSparseArray<int32>::const_span_iterator iter = tiled.begin_spans(rect);
+	XTiledSparseArray<int32>::const_span_iterator last = tiled.end_spans(rect);
+	for (; iter != last; ++iter) {
+		const int32* data = iter.GetElements();
+		if (data != nil)
+			for (uint32 i = 0; i < iter.GetCount(); ++i)
+				tiledSum += data[i];
+	}
+	MilliSecond tiledScan = GetMilliSeconds() - start;
+	ASSERT(sparseSum == tiledSum);
+
+	XTiledSparseArray<int32>::SMemoryUsage usage = tiled.GetMemoryUsage();
+
+	TRACE("Sparse array timing (", kTimingSize, "x", kTimingSize, " at ", 100.0*fill, "% full):\n");
+	TRACE("   fill:          map ", sparseFill, " ms, tiled ", tiledFill, " ms\n");
+	TRACE("   random access: map ", sparseRandom, " ms, tiled ", tiledRandom, " ms\n");
+	TRACE("   row scans:     map ", sparseScan, " ms, tiled ", tiledScan, " ms\n");
+	TRACE("   memory:        map ~", GetMapBytes(usage.elements)/1024, " KB, tiled ", usage.bytes/1024, " KB (", usage.tiles, " tiles)\n");
+}
+
+
+#endif	// DEBUG
+}		// namespace Whisper
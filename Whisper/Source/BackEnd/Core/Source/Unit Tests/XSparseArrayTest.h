@@ -0,0 +1,60 @@
+/*
+ *  File:       XSparseArrayTest.h
+ *  Summary:   	Unit test and benchmark for the sparse array classes.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XSparseArrayTest.h,v $
+ */
+
+#pragma once
+
+#include <XUnitTest.h>
+
+#if DEBUG
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class XSparseArrayUnitTest
+// ===================================================================================	
+class XSparseArrayUnitTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~XSparseArrayUnitTest();
+	
+						XSparseArrayUnitTest();
+						
+//-----------------------------------
+//	API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+private:
+			void 		DoTestAccess();
+			void 		DoTestStreaming();
+			void 		DoTimeArrays(double fill);
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}		// namespace Whisper
+#endif	// DEBUG
@@ -18,7 +18,10 @@
 #include <XWhisperHeader.h>
 #include <XTextTranscodersTest.h>		
 
+#include <XMiscUtils.h>
 #include <XTextTranscoders.h>
+#include <XTinyVector.h>
+#include <XTranscode.h>
 
 namespace Whisper {
 #if DEBUG
@@ -60,6 +63,7 @@ void XTranscoderUnitTest::OnTest()
 	this->DoMacTest();
 	this->DoWinTest();
 	this->DoUTF8Test();
+	this->DoTimeConversions();
 
 	TRACE("Completed text transcoder test.\n\n");
 }
@@ -232,6 +236,56 @@ void XTranscoderUnitTest::DoUTF8Test()
 	ASSERT(std::strncmp(utf8, buffer2, std::strlen(utf8)) == 0);
 }
 
+
+
+//---------------------------------------------------------------
+//
+// XTranscoderUnitTest::DoTimeConversions
+//
+// Compares FromUTF8Str (which uses an inline scratch buffer for
+// short strings) with the old code which always allocated the
+// scratch buffer on the heap.
+//
+//---------------------------------------------------------------
+void XTranscoderUnitTest::DoTimeConversions()
+{
+	const uint32 kIterations = 100000L;
+	
+	XUTF8Transcoder transcoder;
+
+	std::string shortStr = "ellipsis (\xE2\x80\xA6) divide (\xC3\xB7)";
+	std::string longStr;
+	while (longStr.length() < 4096)
+		longStr += shortStr;
+
+	const char* strs[] = {shortStr.c_str(), longStr.c_str()};
+	for (uint32 i = 0; i < 2; ++i) {
+		const char* str = strs[i];
+		uint32 srcLen = std::strlen(str);
+		
+		uint32 checksum1 = 0;
+		MilliSecond start = GetMilliSeconds();
+		for (uint32 j = 0; j < kIterations; ++j) {
+			uint32 dstLen = transcoder.GetDstBytes(str, srcLen)/2;
+	
+			XTinyVector<wchar_t> buffer(dstLen);
+			uint32 len = transcoder.ConvertToUTF16(str, srcLen, buffer.buffer(), dstLen*sizeof(wchar_t))/2;
+	
+			checksum1 += std::wstring(buffer.buffer(), len).length();
+		}
+		MilliSecond heapTime = GetMilliSeconds() - start;
+
+		uint32 checksum2 = 0;
+		start = GetMilliSeconds();
+		for (uint32 j = 0; j < kIterations; ++j)
+			checksum2 += FromUTF8Str(str, srcLen).length();
+		MilliSecond inlineTime = GetMilliSeconds() - start;
+		
+		ASSERT(checksum1 == checksum2);
+		TRACE("FromUTF8Str (", srcLen, " bytes x ", kIterations, "): heap buffer ", heapTime, " ms, inline buffer ", inlineTime, " ms\n");
+	}
+}
+
 #endif	// DEBUG
 
 
@@ -55,6 +55,7 @@ private:
 			void 		DoMacTest();
 			void 		DoWinTest();
 			void 		DoUTF8Test();
+			void 		DoTimeConversions();
 };
 
 
@@ -0,0 +1,367 @@
+/*
+ *  File:       XTinyVectorTest.cpp
+ *  Summary:   	XTinyVector unit test.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XTinyVectorTest.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XTinyVectorTest.h>
+
+#include <stdexcept>
+
+#include <XDebug.h>
+#include <XTinyVector.h>
+
+namespace Whisper {
+#if DEBUG
+
+
+// ===================================================================================
+//	Internal Types
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// CCounted
+//
+// Keeps track of the number of live instances so we can check
+// that the vector constructs and destroys exactly what it should.
+//
+//---------------------------------------------------------------
+class CCounted {
+
+public:
+						~CCounted()								{--msLive;}
+
+						CCounted() : mValue(0)					{++msLive;}
+						CCounted(int32 value) : mValue(value)	{++msLive;}
+						CCounted(const CCounted& rhs);
+
+			CCounted& 	operator=(const CCounted& rhs)			{mValue = rhs.mValue; return *this;}
+
+			bool 		operator==(const CCounted& rhs) const	{return mValue == rhs.mValue;}
+			bool 		operator<(const CCounted& rhs) const	{return mValue < rhs.mValue;}
+
+			int32 		GetValue() const						{return mValue;}
+
+public:
+	static int32		msLive;
+	static int32		msCopiesLeft;			// copy ctor throws when this reaches zero (if it's positive)
+
+private:
+	int32				mValue;
+};
+
+int32 CCounted::msLive       = 0;
+int32 CCounted::msCopiesLeft = -1;
+
+
+CCounted::CCounted(const CCounted& rhs) : mValue(rhs.mValue)
+{
+	if (msCopiesLeft > 0 && --msCopiesLeft == 0)
+		throw std::runtime_error("copy failed");
+
+	++msLive;
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class XTinyVectorUnitTest
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// XTinyVectorUnitTest::~XTinyVectorUnitTest
+//
+//---------------------------------------------------------------
+XTinyVectorUnitTest::~XTinyVectorUnitTest()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XTinyVectorUnitTest::XTinyVectorUnitTest
+//
+//---------------------------------------------------------------
+XTinyVectorUnitTest::XTinyVectorUnitTest() : XUnitTest(L"Backend", L"Tiny Vector")
+{
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XTinyVectorUnitTest::OnTest
+//
+//---------------------------------------------------------------
+void XTinyVectorUnitTest::OnTest()
+{
+	this->DoTestGrowth();
+	this->DoTestCopy();
+	this->DoTestInsertErase();
+	this->DoTestLifetimes();
+	this->DoTestExceptions();
+
+	TRACE("Completed tiny vector test.\n\n");
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XTinyVectorUnitTest::DoTestGrowth
+//
+//---------------------------------------------------------------
+void XTinyVectorUnitTest::DoTestGrowth()
+{
+	XTinyVector<int32, 4> v;
+	ASSERT(v.empty());
+	ASSERT(v.is_inline());
+	ASSERT(v.capacity() == 4);
+
+	for (int32 i = 0; i < 4; ++i)
+		v.push_back(i);
+	ASSERT(v.is_inline());					// exactly full still fits inline
+
+	v.push_back(4);
+	ASSERT(!v.is_inline());
+	ASSERT(v.capacity() >= 5);
+	for (int32 i = 0; i < 5; ++i)
+		ASSERT(v[(uint32) i] == i);
+
+	// pushing one of our own elements must work even when the buffer moves
+	while (v.size() < v.capacity())
+		v.push_back(7);
+	v.push_back(v.front());
+	ASSERT(v.back() == 0);
+
+	uint32 capacity = v.capacity();
+	v.clear();
+	ASSERT(v.empty());
+	ASSERT(v.capacity() == capacity);		// clear keeps the heap buffer
+
+	v.reserve(100);
+	ASSERT(v.capacity() == 100);
+	v.reserve(10);
+	ASSERT(v.capacity() == 100);			// reserve never shrinks
+
+	v.resize(3, 9);
+	ASSERT(v.size() == 3 && v[0] == 9 && v[2] == 9);
+	v.resize(1);
+	ASSERT(v.size() == 1 && v.front() == 9);
+
+	XTinyVector<int32> heap(3, 5);			// no inline storage at all
+	ASSERT(!heap.is_inline());
+	ASSERT(heap.size() == 3 && heap[1] == 5);
+}
+
+
+//---------------------------------------------------------------
+//
+// XTinyVectorUnitTest::DoTestCopy
+//
+//---------------------------------------------------------------
+void XTinyVectorUnitTest::DoTestCopy()
+{
+	XTinyVector<int32, 4> small(3, 1);
+	XTinyVector<int32, 4> large(20, 2);
+
+	XTinyVector<int32, 4> a(small);
+	ASSERT(a.is_inline());
+	ASSERT(a == small);
+
+	XTinyVector<int32, 4> b(large);
+	ASSERT(!b.is_inline());
+	ASSERT(b == large);
+
+	b = small;								// shrinks in place
+	ASSERT(b == small);
+	a = large;								// inline to heap
+	ASSERT(a == large);
+	ASSERT(!a.is_inline());
+
+	const XTinyVector<int32, 4>& alias = a;
+	a = alias;								// self assignment
+	ASSERT(a == large);
+
+	// swap works for every combination of inline and heap buffers
+	XTinyVector<int32, 4> c(small);
+	XTinyVector<int32, 4> d(large);
+	c.swap(d);
+	ASSERT(c == large && d == small);
+	d.swap(c);
+	ASSERT(c == small && d == large);
+
+	XTinyVector<int32, 4> e(large);
+	e[0] = 99;
+	e.swap(d);
+	ASSERT(d[0] == 99 && e == large);
+
+	ASSERT(small < large);
+	ASSERT(small != large);
+}
+
+
+//---------------------------------------------------------------
+//
+// XTinyVectorUnitTest::DoTestInsertErase
+//
+//---------------------------------------------------------------
+void XTinyVectorUnitTest::DoTestInsertErase()
+{
+	XTinyVector<int32, 4> v;
+	v.insert(v.end(), 3);
+	v.insert(v.begin(), 1);
+	v.insert(v.begin() + 1, 2);
+	ASSERT(v.size() == 3 && v[0] == 1 && v[1] == 2 && v[2] == 3);
+
+	for (int32 i = 0; i < 10; ++i)			// grows onto the heap
+		v.insert(v.begin(), -i);
+	ASSERT(v.size() == 13);
+	ASSERT(v.front() == -9);
+	ASSERT(v.back() == 3);
+
+	int32* pos = v.insert(v.begin() + 5, v.back());		// inserting one of our own elements
+	ASSERT(*pos == 3);
+	ASSERT(v[5] == 3 && v[6] == -4);
+
+	pos = v.erase(v.begin() + 5);
+	ASSERT(*pos == -4);
+	ASSERT(v.size() == 13);
+
+	pos = v.erase(v.begin(), v.begin() + 10);
+	ASSERT(pos == v.begin());
+	ASSERT(v.size() == 3 && v[0] == 1 && v[1] == 2 && v[2] == 3);
+
+	pos = v.erase(v.begin() + 1, v.begin() + 1);
+	ASSERT(v.size() == 3);
+
+	pos = v.erase(v.begin() + 2, v.end());
+	ASSERT(pos == v.end());
+	ASSERT(v.size() == 2 && v.back() == 2);
+}
+
+
+//---------------------------------------------------------------
+//
+// XTinyVectorUnitTest::DoTestLifetimes
+//
+//---------------------------------------------------------------
+void XTinyVectorUnitTest::DoTestLifetimes()
+{
+	ASSERT(CCounted::msLive == 0);
+
+	{
+	XTinyVector<CCounted, 4> v;
+	ASSERT(CCounted::msLive == 0);			// inline storage doesn't construct anything
+
+	for (int32 i = 0; i < 10; ++i)
+		v.push_back(CCounted(i));
+	ASSERT(CCounted::msLive == 10);
+
+	v.pop_back();
+	ASSERT(CCounted::msLive == 9);
+
+	v.insert(v.begin() + 2, CCounted(42));
+	ASSERT(CCounted::msLive == 10);
+	ASSERT(v[2].GetValue() == 42 && v[3].GetValue() == 2);
+
+	v.erase(v.begin(), v.begin() + 3);
+	ASSERT(CCounted::msLive == 7);
+	ASSERT(v.front().GetValue() == 2);
+
+	XTinyVector<CCounted, 4> copy(v);
+	ASSERT(CCounted::msLive == 14);
+
+	copy.resize(2);
+	ASSERT(CCounted::msLive == 9);
+
+	copy = v;
+	ASSERT(CCounted::msLive == 14);
+
+	v.clear();
+	ASSERT(CCounted::msLive == 7);
+
+	v.resize(3, CCounted(5));
+	ASSERT(CCounted::msLive == 10);
+	}
+
+	ASSERT(CCounted::msLive == 0);
+}
+
+
+//---------------------------------------------------------------
+//
+// XTinyVectorUnitTest::DoTestExceptions
+//
+// Elements that were constructed before a copy fails must be
+// destroyed and the vector must be left unchanged.
+//
+//---------------------------------------------------------------
+void XTinyVectorUnitTest::DoTestExceptions()
+{
+	XTinyVector<CCounted, 2> source;
+	for (int32 i = 0; i < 8; ++i)
+		source.push_back(CCounted(i));
+	ASSERT(CCounted::msLive == 8);
+
+	// copy ctor (onto the heap)
+	bool threw = false;
+	CCounted::msCopiesLeft = 5;
+	try {
+		XTinyVector<CCounted, 2> copy(source);
+	} catch (const std::runtime_error&) {
+		threw = true;
+	}
+	CCounted::msCopiesLeft = -1;
+	ASSERT(threw);
+	ASSERT(CCounted::msLive == 8);
+
+	// growing
+	threw = false;
+	CCounted::msCopiesLeft = 3;
+	try {
+		source.reserve(100);
+	} catch (const std::runtime_error&) {
+		threw = true;
+	}
+	CCounted::msCopiesLeft = -1;
+	ASSERT(threw);
+	ASSERT(CCounted::msLive == 8);
+	ASSERT(source.size() == 8 && source.capacity() < 100);
+	for (int32 i = 0; i < 8; ++i)
+		ASSERT(source[(uint32) i].GetValue() == i);
+
+	// size ctor
+	threw = false;
+	CCounted::msCopiesLeft = 4;
+	try {
+		XTinyVector<CCounted, 2> filled(10, CCounted(1));
+	} catch (const std::runtime_error&) {
+		threw = true;
+	}
+	CCounted::msCopiesLeft = -1;
+	ASSERT(threw);
+	ASSERT(CCounted::msLive == 8);
+
+	source.clear();
+	ASSERT(CCounted::msLive == 0);
+}
+
+#endif	// DEBUG
+}		// namespace Whisper
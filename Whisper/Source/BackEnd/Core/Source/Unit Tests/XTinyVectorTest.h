@@ -0,0 +1,62 @@
+/*
+ *  File:       XTinyVectorTest.h
+ *  Summary:   	XTinyVector unit test.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XTinyVectorTest.h,v $
+ */
+
+#pragma once
+
+#include <XUnitTest.h>
+
+#if DEBUG
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class XTinyVectorUnitTest
+// ===================================================================================
+class XTinyVectorUnitTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~XTinyVectorUnitTest();
+
+						XTinyVectorUnitTest();
+
+//-----------------------------------
+//	API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+private:
+			void 		DoTestGrowth();
+			void 		DoTestCopy();
+			void 		DoTestInsertErase();
+			void 		DoTestLifetimes();
+			void 		DoTestExceptions();
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}		// namespace Whisper
+#endif	// DEBUG
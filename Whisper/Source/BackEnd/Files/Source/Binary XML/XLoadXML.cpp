@@ -25,6 +25,7 @@
 
 #include <XAutoPtr.h>
 #include <XCompress.h> 
+#include <XHandleSlice.h>
 #include <XHandleStream.h>
 #include <XLocker.h>
 #include <XMiscUtils.h>
@@ -48,37 +49,32 @@ namespace Whisper {
 //---------------------------------------------------------------
 void Load(XXMLDoc& xml, const XResource& data)
 {
-	XXMLDoc doc;
-	
-	{
 	XLocker lock(data);	
-		uint32* temp = (uint32*) data.GetPtr();
-		XHandle unzipped;
+		
+	uint32 header[3];										// copy the header so we don't byte swap the resource's data
+	BlockMoveData(data.GetPtr(), header, sizeof(header));
 		
 #if !BIG_ENDIAN
-		Whisper::ByteSwap(temp[0]);
-		Whisper::ByteSwap(temp[1]);
-		Whisper::ByteSwap(temp[2]);
+	Whisper::ByteSwap(header[0]);
+	Whisper::ByteSwap(header[1]);
+	Whisper::ByteSwap(header[2]);
 #endif
 
-		uint32 offset = 0;
-		if (temp[1]) {
-			unzipped.SetSize(temp[2]);
-			XLocker lock(unzipped);
-			
+	if (header[1]) {
+		XHandle unzipped(header[2]);
+		{
+		XLocker lock2(unzipped);
 			uint32 dstLen = unzipped.GetSize();
-			Unzip(data.GetPtr() + 3*sizeof(uint32), data.GetSize() - 3*sizeof(uint32), unzipped.GetPtr(), &dstLen);
+			Unzip(data.GetPtr() + sizeof(header), data.GetSize() - sizeof(header), unzipped.GetPtr(), &dstLen);
 			ASSERT(dstLen == unzipped.GetSize());
-
-		} else {
-			unzipped = data.GetHandle();
-			offset = 3*sizeof(uint32);
-		}
-		
-		{
-		XInHandleStream stream(unzipped, offset, kCooked);	
-			stream >> xml;
 		}
+
+		XInHandleStream stream(unzipped, 0, kCooked);	
+		stream >> xml;
+
+	} else {
+		XInHandleStream stream(XHandleSlice(data.GetHandle(), sizeof(header)), 0, kCooked);	// parse the data in place
+		stream >> xml;
 	}
 }
 
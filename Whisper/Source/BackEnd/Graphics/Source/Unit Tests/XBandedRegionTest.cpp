@@ -0,0 +1,422 @@
+/*
+ *  File:       XBandedRegionTest.cpp
+ *  Summary:	Unit test and benchmark for XBandedRegion.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XBandedRegionTest.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XBandedRegionTest.h>
+
+#include <vector>
+
+#include <XBandedRegion.h>
+#include <XNumbers.h>
+#include <XRegion.h>
+
+namespace Whisper {
+#if DEBUG
+
+
+//-----------------------------------
+//	Internal Constants
+//
+const int32 kGridSize = 40;				// the correctness tests compare against a grid of bools
+
+const uint32 kTimingPasses = 20;
+
+
+//-----------------------------------
+//	Internal Types
+//
+typedef std::vector<bool> Grid;
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// GetRandomRects
+//
+//---------------------------------------------------------------
+static std::vector<XRect> GetRandomRects(uint32 count, int32 size, int32 maxExtent)
+{
+	std::vector<XRect> rects(count);
+	
+	for (uint32 i = 0; i < count; ++i) {
+		int32 left = Random(size);
+		int32 top  = Random(size);
+		rects[i] = XRect(left, top, Min(left + Random(maxExtent), size), Min(top + Random(maxExtent), size));
+	}
+	
+	return rects;
+}
+
+
+//---------------------------------------------------------------
+//
+// GetRandomRegion
+//
+//---------------------------------------------------------------
+static XBandedRegion GetRandomRegion()
+{
+	uint32 count = (uint32) Random(10L);
+	std::vector<XRect> rects = GetRandomRects(count, kGridSize, 12);
+	
+	return XBandedRegion(count > 0 ? &rects[0] : nil, count);
+}
+
+
+//---------------------------------------------------------------
+//
+// GetGrid
+//
+// Rasterizes the region using the rectangles (not Contains).
+//
+//---------------------------------------------------------------
+static Grid GetGrid(const XBandedRegion& rgn)
+{
+	Grid grid(kGridSize*kGridSize, false);
+	
+	const XRect* rects = rgn.GetRects();
+	for (uint32 i = 0; i < rgn.GetNumRects(); ++i)
+		for (int32 v = rects[i].top; v < rects[i].bottom; ++v)
+			for (int32 h = rects[i].left; h < rects[i].right; ++h)
+				grid[(uint32) (v*kGridSize + h)] = true;
+	
+	return grid;
+}
+
+
+//---------------------------------------------------------------
+//
+// GetRegion (Grid)
+//
+// Builds a region a pixel at a time.
+//
+//---------------------------------------------------------------
+static XBandedRegion GetRegion(const Grid& grid)
+{
+	std::vector<XRect> pixels;
+	for (int32 v = 0; v < kGridSize; ++v)
+		for (int32 h = 0; h < kGridSize; ++h)
+			if (grid[(uint32) (v*kGridSize + h)])
+				pixels.push_back(XRect(h, v, h + 1, v + 1));
+	
+	return XBandedRegion(pixels.empty() ? nil : &pixels[0], (uint32) pixels.size());
+}
+
+
+//---------------------------------------------------------------
+//
+// TimeOperations
+//
+//---------------------------------------------------------------
+static void TimeOperations(const char* name, const XBandedRegion& lhs, const XBandedRegion& rhs)
+{
+	XBandedRegion result;
+	
+	MilliSecond start = GetMilliSeconds();
+	for (uint32 pass = 0; pass < kTimingPasses; ++pass)
+		result = lhs + rhs;
+	MilliSecond unionTime = GetMilliSeconds() - start;
+	
+	start = GetMilliSeconds();
+	for (uint32 pass = 0; pass < kTimingPasses; ++pass)
+		result = lhs & rhs;
+	MilliSecond sectTime = GetMilliSeconds() - start;
+	
+	start = GetMilliSeconds();
+	for (uint32 pass = 0; pass < kTimingPasses; ++pass)
+		result = lhs - rhs;
+	MilliSecond diffTime = GetMilliSeconds() - start;
+	
+	start = GetMilliSeconds();
+	for (uint32 pass = 0; pass < kTimingPasses; ++pass)
+		result = lhs ^ rhs;
+	MilliSecond xorTime = GetMilliSeconds() - start;
+	
+	TRACE("   ", name, " (", lhs.GetNumRects(), " and ", rhs.GetNumRects(), " rects): ");
+	TRACE("union ", (double) unionTime/kTimingPasses, " ms, intersection ", (double) sectTime/kTimingPasses, " ms, ");
+	TRACE("difference ", (double) diffTime/kTimingPasses, " ms, xor ", (double) xorTime/kTimingPasses, " ms (", result.GetNumRects(), " rects)\n");
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class XBandedRegionTest
+// ===================================================================================	
+
+//---------------------------------------------------------------
+//
+// XBandedRegionTest::~XBandedRegionTest
+//
+//---------------------------------------------------------------
+XBandedRegionTest::~XBandedRegionTest()
+{
+}
+
+	
+//---------------------------------------------------------------
+//
+// XBandedRegionTest::XBandedRegionTest
+//
+//---------------------------------------------------------------
+XBandedRegionTest::XBandedRegionTest() : XUnitTest(L"Graphics", L"Banded Regions")
+{
+}
+
+						
+//---------------------------------------------------------------
+//
+// XBandedRegionTest::OnTest
+//
+//---------------------------------------------------------------
+void XBandedRegionTest::OnTest()
+{
+	this->DoTestOperations();
+	this->DoTestHitTesting();
+	this->DoTestShapes();
+
+	TRACE("Banded region timing:\n");
+	this->DoTimeRandom(1000);
+	this->DoTimeRandom(10000);
+	this->DoTimePathological();
+
+	TRACE("Completed banded region test.\n\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegionTest::DoTestOperations
+//
+// Checks the set operations against a grid of bools and checks
+// that the results are canonical (ie the same as building the
+// region up a pixel at a time).
+//
+//---------------------------------------------------------------
+void XBandedRegionTest::DoTestOperations()
+{
+	for (uint32 pass = 0; pass < 500; ++pass) {
+		XBandedRegion lhs = GetRandomRegion();
+		XBandedRegion rhs = GetRandomRegion();
+		
+		Grid lhsGrid = GetGrid(lhs);
+		Grid rhsGrid = GetGrid(rhs);
+		
+		XBandedRegion results[4];
+		results[0] = lhs + rhs;
+		results[1] = lhs & rhs;
+		results[2] = lhs - rhs;
+		results[3] = lhs ^ rhs;
+		
+		for (uint32 op = 0; op < 4; ++op) {
+			Grid grid = GetGrid(results[op]);
+			
+			for (uint32 i = 0; i < grid.size(); ++i) {
+				bool expected = false;
+				if (op == 0)
+					expected = lhsGrid[i] || rhsGrid[i];
+				else if (op == 1)
+					expected = lhsGrid[i] && rhsGrid[i];
+				else if (op == 2)
+					expected = lhsGrid[i] && !rhsGrid[i];
+				else
+					expected = lhsGrid[i] != rhsGrid[i];
+				ASSERT(grid[i] == expected);
+			}
+			
+			ASSERT(results[op] == GetRegion(grid));
+		}
+		
+		ASSERT((lhs + rhs) - (lhs & rhs) == results[3]);
+		ASSERT(lhs + XPoint(3, -2) - XPoint(3, -2) == lhs);
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegionTest::DoTestHitTesting
+//
+//---------------------------------------------------------------
+void XBandedRegionTest::DoTestHitTesting()
+{
+	for (uint32 pass = 0; pass < 200; ++pass) {
+		XBandedRegion rgn = GetRandomRegion();
+		Grid grid = GetGrid(rgn);
+		
+		for (int32 v = 0; v < kGridSize; ++v)
+			for (int32 h = 0; h < kGridSize; ++h)
+				ASSERT(rgn.Contains(XPoint(h, v)) == grid[(uint32) (v*kGridSize + h)]);
+		ASSERT(!rgn.Contains(XPoint(-1, 0)));
+		ASSERT(!rgn.Contains(XPoint(0, kGridSize)));
+		
+		for (uint32 i = 0; i < 20; ++i) {
+			int32 left = Random(kGridSize);
+			int32 top  = Random(kGridSize);
+			XRect rect(left, top, Min(left + 1 + Random(6L), kGridSize), Min(top + 1 + Random(6L), kGridSize));
+			
+			bool all = true, any = false;
+			for (int32 v = rect.top; v < rect.bottom; ++v) {
+				for (int32 h = rect.left; h < rect.right; ++h) {
+					all = all && grid[(uint32) (v*kGridSize + h)];
+					any = any || grid[(uint32) (v*kGridSize + h)];
+				}
+			}
+			
+			ASSERT(rgn.Contains(rect) == all);
+			ASSERT(rgn.Intersects(rect) == any);
+		}
+		
+		XRect bounds = rgn.GetEnclosingRect();
+		if (!rgn.IsEmpty()) {
+			ASSERT((rgn & XBandedRegion(bounds)) == rgn);
+			ASSERT(rgn.Intersects(bounds));
+		}
+			
+		XRegion osRgn = rgn.GetRegion();
+		ASSERT(osRgn.IsEmpty() == rgn.IsEmpty());
+		for (int32 v = 0; v < kGridSize; v += 3)
+			for (int32 h = 0; h < kGridSize; h += 3)
+				ASSERT(osRgn.Contains(XPoint(h, v)) == rgn.Contains(XPoint(h, v)));
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegionTest::DoTestShapes
+//
+//---------------------------------------------------------------
+void XBandedRegionTest::DoTestShapes()
+{
+	XRect rect(5, 7, 25, 19);
+	
+	XBandedRegion square(rect, 0, 0);
+	ASSERT(square == XBandedRegion(rect));
+	ASSERT(square.GetNumRects() == 1);
+	
+	XPoint vertices[4] = {XPoint(5, 7), XPoint(25, 7), XPoint(25, 19), XPoint(5, 19)};
+	ASSERT(XBandedRegion(vertices, 4) == square);
+	
+	XBandedRegion round(rect, 8, 6);
+	ASSERT(round.GetEnclosingRect() == rect);
+	ASSERT(!round.Contains(XPoint(rect.left, rect.top)));
+	ASSERT(round.Contains(XRect(rect.left, rect.top + 3, rect.right, rect.bottom - 3)));
+	
+	XBandedRegion ellipse(XPoint(20, 20), 16, 10);
+	ASSERT(ellipse.GetEnclosingRect() == XRect(12, 15, 28, 25));
+	ASSERT(ellipse.Contains(XPoint(20, 20)));
+	ASSERT(!ellipse.Contains(XPoint(12, 15)));
+	ASSERT(ellipse - XPoint(20, 20) + XPoint(20, 20) == ellipse);
+	
+	XPoint star[5] = {XPoint(20, 2), XPoint(30, 35), XPoint(4, 14), XPoint(36, 14), XPoint(10, 35)};
+	XBandedRegion filled(star, 5);
+	ASSERT(filled.Contains(XPoint(20, 20)));				// the center is filled with the winding rule
+	ASSERT(!filled.Contains(XPoint(20, 34)));
+	
+	XBandedRegion moved = ellipse;
+	moved.MoveTo(kZeroPt);
+	ASSERT(moved.GetEnclosingRect() == XRect(0, 0, 16, 10));
+	
+	moved.MakeEmpty();
+	ASSERT(moved.IsEmpty());
+	ASSERT(moved.GetEnclosingRect() == kZeroRect);
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegionTest::DoTimeRandom
+//
+//---------------------------------------------------------------
+void XBandedRegionTest::DoTimeRandom(uint32 count)
+{
+	const int32 kSize = 2048;
+	
+	std::vector<XRect> rects1 = GetRandomRects(count, kSize, 64);
+	std::vector<XRect> rects2 = GetRandomRects(count, kSize, 64);
+	
+	MilliSecond start = GetMilliSeconds();
+	XBandedRegion lhs(&rects1[0], count);
+	MilliSecond bandedTime = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	XRegion osRgn(&rects1[0], count);
+	MilliSecond osTime = GetMilliSeconds() - start;
+
+	TRACE("   building from ", count, " random rects: ", bandedTime, " ms (XRegion took ", osTime, " ms)\n");
+
+	XBandedRegion rhs(&rects2[0], count);
+	TimeOperations("random", lhs, rhs);
+	
+	const uint32 kNumPoints = 100000;
+	uint32 hits = 0;
+	
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumPoints; ++i)
+		if (lhs.Contains(XPoint(Random(kSize), Random(kSize))))
+			++hits;
+	MilliSecond containsTime = GetMilliSeconds() - start;
+	
+	TRACE("   ", kNumPoints, " point hit tests: ", containsTime, " ms (", hits, " hits)\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegionTest::DoTimePathological
+//
+// A checkerboard has the most rectangles per band, a staircase
+// has a band per row, and combs produce a grid when they're
+// intersected.
+//
+//---------------------------------------------------------------
+void XBandedRegionTest::DoTimePathological()
+{
+	const int32 kCells = 256;
+	const int32 kCellSize = 4;
+	
+	std::vector<XRect> rects;
+	for (int32 v = 0; v < kCells; ++v)
+		for (int32 h = v % 2; h < kCells; h += 2)
+			rects.push_back(XRect(h*kCellSize, v*kCellSize, (h + 1)*kCellSize, (v + 1)*kCellSize));
+			
+	MilliSecond start = GetMilliSeconds();
+	XBandedRegion checkerboard(&rects[0], (uint32) rects.size());
+	MilliSecond buildTime = GetMilliSeconds() - start;
+	TRACE("   building a ", rects.size(), " square checkerboard: ", buildTime, " ms\n");
+	
+	TimeOperations("checkerboard vs shifted checkerboard", checkerboard, checkerboard + XPoint(kCellSize, 0));
+	
+	rects.clear();
+	for (int32 v = 0; v < kCells*kCellSize; ++v)
+		rects.push_back(XRect(0, v, v + 1, v + 1));
+	XBandedRegion staircase(&rects[0], (uint32) rects.size());
+	
+	TimeOperations("staircase vs checkerboard", staircase, checkerboard);
+	
+	std::vector<XRect> columns, rows;
+	for (int32 i = 0; i < kCells; i += 2) {
+		columns.push_back(XRect(i*kCellSize, 0, (i + 1)*kCellSize, kCells*kCellSize));
+		rows.push_back(XRect(0, i*kCellSize, kCells*kCellSize, (i + 1)*kCellSize));
+	}
+	
+	TimeOperations("vertical comb vs horizontal comb", XBandedRegion(&columns[0], (uint32) columns.size()), XBandedRegion(&rows[0], (uint32) rows.size()));
+}
+
+
+#endif	// DEBUG
+}		// namespace Whisper
@@ -0,0 +1,63 @@
+/*
+ *  File:       XBandedRegionTest.h
+ *  Summary:	Unit test and benchmark for XBandedRegion.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XBandedRegionTest.h,v $
+ */
+
+#pragma once
+
+#include <XUnitTest.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class XBandedRegionTest
+// ===================================================================================	
+#if DEBUG
+class XBandedRegionTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~XBandedRegionTest();
+	
+						XBandedRegionTest();
+						
+//-----------------------------------
+//	Inherited API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		DoTestOperations();
+			void 		DoTestHitTesting();
+			void 		DoTestShapes();
+			void 		DoTimeRandom(uint32 count);
+			void 		DoTimePathological();
+};
+#endif
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
+
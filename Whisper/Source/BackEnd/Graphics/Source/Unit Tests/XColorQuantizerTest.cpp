@@ -0,0 +1,394 @@
+/*
+ *  File:       XColorQuantizerTest.cpp
+ *  Summary:	Unit test and benchmark for XColorQuantizer.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XColorQuantizerTest.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XColorQuantizerTest.h>
+
+#include <cmath>
+#include <vector>
+
+#include <XColorQuantizer.h>
+#include <XNumbers.h>
+#include <XUnitTestUtils.h>
+
+namespace Whisper {
+#if DEBUG
+
+
+//-----------------------------------
+//	Internal Constants
+//
+const int32 kTimingWidth  = 3840;			// 4K UHD
+const int32 kTimingHeight = 2160;
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// GetBlockError
+//
+// Returns the average difference between the mean red component
+// of 8x8 blocks in the original and quantized images. Dithering
+// should make this small even when the palette is coarse.
+//
+//---------------------------------------------------------------
+static double GetBlockError(const XPixMap& original, const XPixMap& quantized)
+{
+	XLocker lock1(original);
+	XLocker lock2(quantized);
+
+	const XColorTable* colors = quantized.GetColors();
+
+	double error = 0.0;
+	int32 count = 0;
+
+	for (int32 top = 0; top + 8 <= original.GetHeight(); top += 8) {
+		for (int32 left = 0; left + 8 <= original.GetWidth(); left += 8) {
+			double sum1 = 0.0;
+			double sum2 = 0.0;
+
+			for (int32 v = top; v < top + 8; ++v) {
+				for (int32 h = left; h < left + 8; ++h) {
+					XRGBColor color = original.PixelToColor(original.GetPixelAt(h, v));
+					sum1 += color.red;
+					sum2 += colors->GetColor(quantized.GetPixelAt(h, v)).red;
+				}
+			}
+
+			error += std::fabs(sum1 - sum2)/64.0;
+			++count;
+		}
+	}
+
+	return 255.0*error/count;
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class XColorQuantizerTest
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// XColorQuantizerTest::~XColorQuantizerTest
+//
+//---------------------------------------------------------------
+XColorQuantizerTest::~XColorQuantizerTest()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizerTest::XColorQuantizerTest
+//
+//---------------------------------------------------------------
+XColorQuantizerTest::XColorQuantizerTest() : XUnitTest(L"Graphics", L"Color Quantizer")
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizerTest::OnTest
+//
+//---------------------------------------------------------------
+void XColorQuantizerTest::OnTest()
+{
+	this->DoTestExact(32);
+#if WIN
+	this->DoTestExact(24);						// QuickDraw doesn't have 24-bit GWorlds
+#endif
+	this->DoTestExact(16);
+	this->DoTestDither();
+	this->DoTestPacking(1);
+	this->DoTestPacking(4);
+
+	TRACE("Quantizing ", kTimingWidth, "x", kTimingHeight, " images to 256 colors:\n");
+	XPixMapPtr image = this->DoCreateSynthetic(kTimingWidth, kTimingHeight);
+	this->DoTime(*image.Get(), "synthetic");
+
+	image = this->DoCreateRendered(kTimingWidth, kTimingHeight);
+	this->DoTime(*image.Get(), "rendered");
+
+	TRACE("Completed color quantizer test.\n\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizerTest::DoTestExact
+//
+// An image with no more colors than the palette should come back
+// unchanged. The colors survive a trip through 5-bit channels and
+// red and blue differ so that swapped channels are caught.
+//
+//---------------------------------------------------------------
+void XColorQuantizerTest::DoTestExact(int32 depth)
+{
+	const XRGBColor kColors[4] = {XRGBColor(1.0, 0.0, 0.0), XRGBColor(0.0, 1.0, 0.0), XRGBColor(16/255.0, 33/255.0, 247/255.0), XRGBColor(132/255.0, 132/255.0, 132/255.0)};
+
+	XPixMap image(XSize(64, 64), nil, depth);
+	{
+	XLocker lock(image);
+	for (int32 v = 0; v < 64; ++v)
+		for (int32 h = 0; h < 64; ++h)
+			image.SetColorsAt(h, v, &kColors[2*(v/32) + h/32], 1);
+	}
+
+	XColorQuantizer quantizer(image, 4);
+	ASSERT(quantizer.GetNumColors() == 4);
+	ASSERT(quantizer.GetColors().GetSize() == 4);
+
+	XPixMap result(image.GetSize(), &quantizer.GetColors(), 8);
+	quantizer.Quantize(image, result, false);
+
+	XLocker lock(result);
+	for (int32 v = 0; v < 64; ++v) {
+		for (int32 h = 0; h < 64; ++h) {
+			XRGBColor expected = kColors[2*(v/32) + h/32];
+			XRGBColor actual = quantizer.GetColors().GetColor(result.GetPixelAt(h, v));
+
+			ASSERT(std::fabs(expected.red - actual.red) < 0.5/255.0);
+			ASSERT(std::fabs(expected.green - actual.green) < 0.5/255.0);
+			ASSERT(std::fabs(expected.blue - actual.blue) < 0.5/255.0);
+		}
+	}
+
+	// An image with one color gets a one color palette (padded out
+	// with black).
+	XPixMap gray(XSize(16, 16), nil, depth);
+	{
+	XLocker lock2(gray);
+	for (int32 v = 0; v < 16; ++v)
+		for (int32 h = 0; h < 16; ++h)
+			gray.SetColorsAt(h, v, &kColors[3], 1);
+	}
+
+	XColorQuantizer quantizer2(gray, 16);
+	ASSERT(quantizer2.GetNumColors() == 1);
+	ASSERT(quantizer2.GetColors().GetSize() == 16);
+	ASSERT(quantizer2.GetIndex(kColors[3]) == 0);
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizerTest::DoTestDither
+//
+// Quantizes a gray ramp to a handful of colors. Without dithering
+// the blocks are off by about half the step between palette entries.
+// With dithering the local averages should be close to the original.
+//
+//---------------------------------------------------------------
+void XColorQuantizerTest::DoTestDither()
+{
+	XPixMap image(XSize(256, 64), nil, 32);
+	{
+	XLocker lock(image);
+
+	std::vector<XRGBColor> colors(256);
+	for (uint32 h = 0; h < 256; ++h)
+		colors[h] = XRGBColor(h/255.0, h/255.0, 1.0 - h/255.0);
+
+	for (int32 v = 0; v < 64; ++v)
+		image.SetColorsAt(0, v, &colors[0], 256);
+	}
+
+	XColorQuantizer quantizer(image, 16);
+
+	XPixMap plain(image.GetSize(), &quantizer.GetColors(), 8);
+	quantizer.Quantize(image, plain, false);
+
+	XPixMap dithered(image.GetSize(), &quantizer.GetColors(), 8);
+	quantizer.Quantize(image, dithered, true);
+
+	double plainError    = GetBlockError(image, plain);
+	double ditheredError = GetBlockError(image, dithered);
+	TRACE("   block error without dithering is ", plainError, ", with dithering is ", ditheredError, "\n");
+
+	ASSERT(ditheredError < 1.5);
+	ASSERT(ditheredError < 0.5*plainError);
+
+	// We should get the same result if we use the palette instead of
+	// the image.
+	XColorQuantizer quantizer2(quantizer.GetColors());
+
+	XPixMap dithered2(image.GetSize(), &quantizer.GetColors(), 8);
+	quantizer2.Quantize(image, dithered2, true);
+
+	XLocker lock1(dithered);
+	XLocker lock2(dithered2);
+	for (int32 v = 0; v < image.GetHeight(); ++v)
+		ASSERT(EqualMemory(dithered.GetBufferAt(0, v), dithered2.GetBufferAt(0, v), (uint32) image.GetWidth()));
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizerTest::DoTestPacking
+//
+// Checks that quantizing into a shallow image gives the same
+// indices as quantizing into an 8-bit image. The odd width makes
+// sure the partial byte at the end of the rows is handled.
+//
+//---------------------------------------------------------------
+void XColorQuantizerTest::DoTestPacking(int32 depth)
+{
+	XPixMapPtr image = this->DoCreateSynthetic(37, 9);
+
+	XColorQuantizer quantizer(*image.Get(), 1UL << depth);
+
+	XPixMap wide(image->GetSize(), &quantizer.GetColors(), 8);
+	quantizer.Quantize(*image.Get(), wide, true);
+
+	XPixMap packed(image->GetSize(), &quantizer.GetColors(), depth);
+	quantizer.Quantize(*image.Get(), packed, true);
+
+	XLocker lock1(wide);
+	XLocker lock2(packed);
+
+	uint32 perByte = 8/(uint32) depth;
+	uint32 mask = (1UL << depth) - 1;
+	for (int32 v = 0; v < image->GetHeight(); ++v) {
+		const uint8* row = packed.GetBufferAt(0, v);
+
+		for (int32 h = 0; h < image->GetWidth(); ++h) {
+			uint32 shift = 8 - (uint32) depth*((uint32) h % perByte + 1);
+			uint32 index = (row[(uint32) h/perByte] >> shift) & mask;
+			ASSERT(index == wide.GetPixelAt(h, v));
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizerTest::DoCreateSynthetic
+//
+// A grid of flat blocks in a few dozen colors with a little noise
+// added, like a scanned poster. Most of the colors are in tight
+// clusters so the palette should be able to capture them all.
+//
+//---------------------------------------------------------------
+XPixMapPtr XColorQuantizerTest::DoCreateSynthetic(int32 width, int32 height)
+{
+	const int32 kNumBase   = 24;
+	const int32 kBlockSize = 7;
+
+	std::vector<XRGBColor> base((uint32) kNumBase);
+	for (int32 i = 0; i < kNumBase; ++i)
+		base[(uint32) i] = XRGBColor(Random(1.0), Random(1.0), Random(1.0));
+
+	XPixMapPtr image(new XPixMap(XSize(width, height), nil, 32));
+	XLocker lock(*image);
+
+	std::vector<XRGBColor> colors((uint32) width);
+	for (int32 v = 0; v < height; ++v) {
+		for (int32 h = 0; h < width; ++h) {
+			XRGBColor color = base[(uint32) ((h/kBlockSize + 5*(v/kBlockSize)) % kNumBase)];
+			double noise = Random(-0.02, 0.02);
+
+			colors[(uint32) h] = XRGBColor(MinMax(0.0, color.red + noise, 1.0), MinMax(0.0, color.green + noise, 1.0), MinMax(0.0, color.blue - noise, 1.0));
+		}
+
+		image->SetColorsAt(0, v, &colors[0], (uint32) width);
+	}
+
+	return image;
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizerTest::DoCreateRendered
+//
+// A Mandelbrot set with smooth coloring which has the long gradients
+// and sharp edges typical of HyperMandella renders.
+//
+//---------------------------------------------------------------
+XPixMapPtr XColorQuantizerTest::DoCreateRendered(int32 width, int32 height)
+{
+	const int32 kMaxDwell = 64;
+
+	XPixMapPtr image(new XPixMap(XSize(width, height), nil, 32));
+	XLocker lock(*image);
+
+	double scale = 3.0/width;
+
+	std::vector<XRGBColor> colors((uint32) width);
+	for (int32 v = 0; v < height; ++v) {
+		double ci = (v - height/2)*scale;
+
+		for (int32 h = 0; h < width; ++h) {
+			double cr = (h - 2*width/3)*scale;
+
+			double zr = 0.0, zi = 0.0;
+			int32 dwell = 0;
+			while (dwell < kMaxDwell && zr*zr + zi*zi < 16.0) {
+				double temp = zr*zr - zi*zi + cr;
+				zi = 2.0*zr*zi + ci;
+				zr = temp;
+				++dwell;
+			}
+
+			if (dwell < kMaxDwell) {
+				double t = (dwell - std::log(std::log(std::sqrt(zr*zr + zi*zi))))/kMaxDwell;
+				colors[(uint32) h] = XRGBColor(0.5 + 0.5*std::cos(6.0*t), 0.5 + 0.5*std::cos(6.0*t + 2.0), 0.5 + 0.5*std::cos(6.0*t + 4.0));
+			} else
+				colors[(uint32) h] = kRGBBlack;
+		}
+
+		image->SetColorsAt(0, v, &colors[0], (uint32) width);
+	}
+
+	return image;
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizerTest::DoTime
+//
+//---------------------------------------------------------------
+void XColorQuantizerTest::DoTime(const XPixMap& image, const char* name)
+{
+	MilliSecond start = GetMilliSeconds();
+	XColorQuantizer quantizer(image, 256);
+	MilliSecond paletteTime = GetMilliSeconds() - start;
+
+	XPixMap result(image.GetSize(), &quantizer.GetColors(), 8);
+
+	start = GetMilliSeconds();
+	quantizer.Quantize(image, result, false);
+	MilliSecond mapTime = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	quantizer.Quantize(image, result, true);
+	MilliSecond ditherTime = GetMilliSeconds() - start;
+
+	double pixels = (double) image.GetWidth()*image.GetHeight();
+
+	TRACE("   ", name, ": palette ", paletteTime, " ms, map ", mapTime, " ms (", GetRate(pixels, mapTime, 1.0e6), " MP/s)\n");
+	TRACE("      dither ", ditherTime, " ms (", GetRate(pixels, ditherTime, 1.0e6), " MP/s), ", quantizer.GetNumColors(), " colors\n");
+}
+
+
+#endif	// DEBUG
+}		// namespace Whisper
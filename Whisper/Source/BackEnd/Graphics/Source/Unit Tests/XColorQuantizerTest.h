@@ -0,0 +1,66 @@
+/*
+ *  File:       XColorQuantizerTest.h
+ *  Summary:	Unit test and benchmark for XColorQuantizer.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XColorQuantizerTest.h,v $
+ */
+
+#pragma once
+
+#include <XPixMap.h>
+#include <XUnitTest.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class XColorQuantizerTest
+// ===================================================================================	
+#if DEBUG
+class XColorQuantizerTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~XColorQuantizerTest();
+	
+						XColorQuantizerTest();
+						
+//-----------------------------------
+//	Inherited API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		DoTestExact(int32 depth);
+			void 		DoTestDither();
+			void 		DoTestPacking(int32 depth);
+			
+			XPixMapPtr 	DoCreateSynthetic(int32 width, int32 height);
+			XPixMapPtr 	DoCreateRendered(int32 width, int32 height);
+			void 		DoTime(const XPixMap& image, const char* name);
+};
+#endif
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
+
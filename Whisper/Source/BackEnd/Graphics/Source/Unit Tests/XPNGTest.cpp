@@ -22,14 +22,19 @@
 #include <XWhisperHeader.h>
 #include <XPNGTest.h>
 
+#include <cmath>
+#include <vector>
+
 #include <XColorTable.h>
 #include <XDrawContexts.h>
+#include <XFile.h>
 #include <XFileSystem.h>
 #include <XFolderSpec.h>
 #include <XImageExporters.h>
 #include <XImageImporters.h>
 #include <XIntConversions.h>
 #include <XMemUtils.h>
+#include <XNumbers.h>
 #include <XPixMap.h>
 #include <XResource.h>
 #include <XShapes.h>
@@ -38,6 +43,21 @@ namespace Whisper {
 #if DEBUG
 
 
+//-----------------------------------
+//	Internal Constants
+//
+const int32 kTimingWidth  = 1920;
+const int32 kTimingHeight = 1080;
+
+const XPNGExporter::ECompression kCompressions[] = {XPNGExporter::kFastCompression, XPNGExporter::kDefaultCompression, XPNGExporter::kSmallCompression};
+const char* kCompressionNames[] = {"fast", "default", "small"};
+
+const uint32 kNumCompressions = sizeof(kCompressions)/sizeof(kCompressions[0]);
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
 // ===================================================================================
 //	class XPNGTest
 // ===================================================================================	
@@ -79,6 +99,38 @@ void XPNGTest::OnTest()
 	pixels = this->DoCreate1BitImage();
 	this->DoTest(*pixels.Get());
 
+	// 24 and 16-bit images are imported as 32-bit images so these are
+	// compared by color (this also catches swapped red and blue channels).
+#if WIN
+	pixels = this->DoCreateDirectImage(24);						// QuickDraw doesn't have 24-bit GWorlds
+	this->DoTestDirect(*pixels.Get(), 1.5/255.0, 1);
+	this->DoTestDirect(*pixels.Get(), 1.5/255.0, 3);
+#endif
+
+	pixels = this->DoCreateDirectImage(16);
+	this->DoTestDirect(*pixels.Get(), 8.5/255.0, 1);		// PixelToColor doesn't replicate the low bits of 5-bit channels
+	this->DoTestDirect(*pixels.Get(), 8.5/255.0, 3);
+
+	// Large enough that the threaded exporter uses lots of strips.
+	pixels = this->DoCreateLargeImage(640, 480);
+	for (uint32 i = 0; i < kNumCompressions; ++i) {
+		this->DoTest(*pixels.Get(), kCompressions[i], 1);
+		this->DoTest(*pixels.Get(), kCompressions[i], 3);
+	}
+	this->DoTestStreaming(*pixels.Get(), 1);
+	this->DoTestStreaming(*pixels.Get(), 3);
+
+	pixels = this->DoCreate8BitImage();
+	this->DoTest(*pixels.Get(), XPNGExporter::kSmallCompression, 2);
+
+	// Timings
+	TRACE("   exporting ", kTimingWidth, "x", kTimingHeight, " 32-bit image:\n");
+	pixels = this->DoCreateLargeImage(kTimingWidth, kTimingHeight);
+	for (uint32 i = 0; i < kNumCompressions; ++i) {
+		this->DoTimeExport(*pixels.Get(), kCompressions[i], 1);
+		this->DoTimeExport(*pixels.Get(), kCompressions[i], 0);
+	}
+
 	TRACE("Completed PNG export/import test.\n\n");
 }
 
@@ -157,16 +209,80 @@ XPixMapPtr XPNGTest::DoCreate1BitImage()
 }
 
 
+//---------------------------------------------------------------
+//
+// XPNGTest::DoCreateDirectImage
+//
+// Red increases to the right and blue to the left so that swapping
+// the channels is easy to spot.
+//
+//---------------------------------------------------------------
+XPixMapPtr XPNGTest::DoCreateDirectImage(int32 depth)
+{
+	PRECONDITION(depth == 16 || depth == 24);
+	
+	const int32 kWidth  = 37;									// odd width so the 24-bit rows need padding
+	const int32 kHeight = 9;
+	
+	XPixMapPtr pixels(new XPixMap(XSize(kWidth, kHeight), nil, depth));
+	XLocker lock(*pixels);
+	
+	XRGBColor colors[kWidth];
+	for (int32 v = 0; v < kHeight; ++v) {
+		for (int32 h = 0; h < kWidth; ++h) {
+			double x = (double) h/(kWidth - 1);
+			double y = (double) v/(kHeight - 1);
+			
+			colors[h] = XRGBColor(x, y, 1.0 - x);
+		}
+		
+		pixels->SetColorsAt(0, v, colors, (uint32) kWidth);
+	}
+	
+	return pixels;
+}
+
+
+//---------------------------------------------------------------
+//
+// XPNGTest::DoCreateLargeImage
+//
+// Smooth gradients with some noise which is roughly what rendered
+// images look like.
+//
+//---------------------------------------------------------------
+XPixMapPtr XPNGTest::DoCreateLargeImage(int32 width, int32 height)
+{
+	XPixMapPtr pixels(new XPixMap(XSize(width, height), nil, 32));
+	XLocker lock(*pixels);
+	
+	std::vector<XRGBColor> colors((uint32) width);
+	for (int32 v = 0; v < height; ++v) {
+		for (int32 h = 0; h < width; ++h) {
+			double x = (double) h/width;
+			double y = (double) v/height;
+			double noise = Random(0.05f);
+			
+			colors[(uint32) h] = XRGBColor(0.5 + 0.45*std::sin(6.0*x + 2.0*y), 0.5 + 0.45*std::cos(9.0*x*y), Min(y + noise, 1.0));
+		}
+		
+		pixels->SetColorsAt(0, v, &colors[0], (uint32) width);
+	}
+	
+	return pixels;
+}
+
+
 //---------------------------------------------------------------
 //
 // XPNGTest::DoTest
 //
 //---------------------------------------------------------------
-void XPNGTest::DoTest(const XPixMap& lhs)
+void XPNGTest::DoTest(const XPixMap& lhs, XPNGExporter::ECompression compression, uint32 threads)
 {
 	XFileSpec spec(XFolderSpec::GetAppFolder(), L"Import Test.png");
 	
-	XPNGExporter exporter(1.0);
+	XPNGExporter exporter(1.0, false, compression, threads);
 	exporter.Export(spec, &lhs, '????', 'PNGf');
 	
 	try {
@@ -185,6 +301,96 @@ void XPNGTest::DoTest(const XPixMap& lhs)
 }
 	
 
+//---------------------------------------------------------------
+//
+// XPNGTest::DoTestDirect
+//
+//---------------------------------------------------------------
+void XPNGTest::DoTestDirect(const XPixMap& lhs, double tolerance, uint32 threads)
+{
+	XFileSpec spec(XFolderSpec::GetAppFolder(), L"Import Test.png");
+	
+	XPNGExporter exporter(1.0, false, XPNGExporter::kDefaultCompression, threads);
+	exporter.Export(spec, &lhs, '????', 'PNGf');
+	
+	XResource* data = new XResource(spec);
+	XPNGImporter importer(data, 1.0);
+	
+	XPixMap rhs(importer); 
+	this->DoCompareColors(lhs, rhs, tolerance);
+
+	XFileSystem::DeleteFile(spec);
+}
+	
+
+//---------------------------------------------------------------
+//
+// XPNGTest::DoTestStreaming
+//
+//---------------------------------------------------------------
+void XPNGTest::DoTestStreaming(const XPixMap& lhs, uint32 threads)
+{
+	XFileSpec spec(XFolderSpec::GetAppFolder(), L"Import Test.png");
+	
+	XPNGExporter exporter(1.0, false, XPNGExporter::kDefaultCompression, threads);
+	exporter.Begin(spec, lhs.GetWidth(), lhs.GetHeight(), lhs.GetDepth(), nil, '????', 'PNGf');
+	
+	XLocker lock(lhs);
+	std::vector<uint8> band(7*lhs.GetRowBytes());				// use an odd number of rows so the bands don't line up with the strips
+	
+	int32 v = 0;
+	while (v < lhs.GetHeight()) {
+		int32 count = Min(7L, lhs.GetHeight() - v);
+		for (int32 i = 0; i < count; ++i)
+			BlockMoveData(lhs.GetBufferAt(0, v + i), &band[(uint32) i*lhs.GetRowBytes()], lhs.GetRowBytes());
+			
+		exporter.WriteRows(&band[0], (int32) lhs.GetRowBytes(), count);
+		v += count;
+	}
+	
+	exporter.End();
+	
+	XResource* data = new XResource(spec);
+	XPNGImporter importer(data, 1.0);
+	
+	XPixMap rhs(importer); 
+	this->DoCompare(lhs, rhs);
+
+	XFileSystem::DeleteFile(spec);
+}
+
+
+//---------------------------------------------------------------
+//
+// XPNGTest::DoTimeExport
+//
+// If threads is zero one thread per processor is used.
+//
+//---------------------------------------------------------------
+void XPNGTest::DoTimeExport(const XPixMap& pixels, XPNGExporter::ECompression compression, uint32 threads)
+{
+	XFileSpec spec(XFolderSpec::GetAppFolder(), L"Export Timing.png");
+	
+	XPNGExporter exporter(1.0, false, compression, threads);
+	
+	MilliSecond start = GetMilliSeconds();
+	exporter.Export(spec, &pixels, '????', 'PNGf');
+	MilliSecond elapsed = Max(GetMilliSeconds() - start, 1L);
+	
+	XFile file(spec);
+	file.Open(kReadPermission);
+	uint32 bytes = file.GetLength();
+	file.Close();
+
+	XFileSystem::DeleteFile(spec);
+	
+	double megabytes = 4.0*pixels.GetWidth()*pixels.GetHeight()/(1024.0*1024.0);
+	const char* name = kCompressionNames[compression - XPNGExporter::kFastCompression];
+	
+	TRACE("      ", name, " with ", exporter.GetThreads(), " threads: ", megabytes/(elapsed/1000.0), " MB/s, ", bytes/1024, " KB\n");
+}
+
+
 //---------------------------------------------------------------
 //
 // XPNGTest::DoDumpPixels
@@ -237,6 +443,40 @@ void XPNGTest::DoCompare(const XPixMap& lhs, const XPixMap& rhs)
 }
 
 
+//---------------------------------------------------------------
+//
+// XPNGTest::DoCompareColors
+//
+//---------------------------------------------------------------
+void XPNGTest::DoCompareColors(const XPixMap& lhs, const XPixMap& rhs, double tolerance)
+{
+	ASSERT(lhs.GetSize() == rhs.GetSize());
+
+	XLocker lock1(lhs);
+	XLocker lock2(rhs);
+	
+	bool matches = true;
+	for (int32 v = 0; v < lhs.GetHeight() && matches; ++v) {
+		for (int32 h = 0; h < lhs.GetWidth() && matches; ++h) {
+			XRGBColor left  = lhs.PixelToColor(lhs.GetPixelAt(h, v));
+			XRGBColor right = rhs.PixelToColor(rhs.GetPixelAt(h, v));
+			
+			matches = std::fabs(left.red - right.red) <= tolerance && std::fabs(left.green - right.green) <= tolerance && std::fabs(left.blue - right.blue) <= tolerance;
+		}
+	}
+	
+	if (!matches) {
+		TRACE("lhs:\n");
+		this->DoDumpPixels(lhs);
+
+		TRACE("rhs:\n");
+		this->DoDumpPixels(rhs);
+		
+		DEBUGSTR("colors differ");
+	}
+}
+
+
 #endif	// DEBUG
 }		// namespace Whisper
 
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <XImageExporters.h>
 #include <XPixMap.h>
 #include <XUnitTest.h>
 
@@ -60,10 +61,16 @@ protected:
 			XPixMapPtr 	DoCreate32BitImage();
 			XPixMapPtr 	DoCreate8BitImage();
 			XPixMapPtr 	DoCreate1BitImage();
+			XPixMapPtr 	DoCreateDirectImage(int32 depth);
+			XPixMapPtr 	DoCreateLargeImage(int32 width, int32 height);
 	
 			void 		DoDumpPixels(const XPixMap& pixels);
 			void 		DoCompare(const XPixMap& lhs, const XPixMap& rhs);
-			void 		DoTest(const XPixMap& lhs);
+			void 		DoCompareColors(const XPixMap& lhs, const XPixMap& rhs, double tolerance);
+			void 		DoTest(const XPixMap& lhs, XPNGExporter::ECompression compression = XPNGExporter::kDefaultCompression, uint32 threads = 1);
+			void 		DoTestDirect(const XPixMap& lhs, double tolerance, uint32 threads);
+			void 		DoTestStreaming(const XPixMap& lhs, uint32 threads);
+			void 		DoTimeExport(const XPixMap& pixels, XPNGExporter::ECompression compression, uint32 threads);
 };
 #endif
 
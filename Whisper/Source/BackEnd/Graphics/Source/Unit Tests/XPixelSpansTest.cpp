@@ -0,0 +1,197 @@
+/*
+ *  File:       XPixelSpansTest.cpp
+ *  Summary:	Unit test and benchmark for the XBaseImage span functions.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XPixelSpansTest.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XPixelSpansTest.h>
+
+#include <vector>
+
+#include <XNumbers.h>
+#include <XPixMap.h>
+#include <XUnitTestUtils.h>
+
+namespace Whisper {
+#if DEBUG
+
+
+//-----------------------------------
+//	Internal Constants
+//
+const int32 kTimingWidth  = 3840;			// 4K UHD
+const int32 kTimingHeight = 2160;
+const double kTimingPixels = (double) kTimingWidth*kTimingHeight;
+
+#if WIN
+	const int32 kDepths[] = {16, 24, 32};
+#else
+	const int32 kDepths[] = {16, 32};		// QuickDraw doesn't have 24-bit GWorlds
+#endif
+
+const uint32 kNumDepths = sizeof(kDepths)/sizeof(kDepths[0]);
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// FillRandom
+//
+//---------------------------------------------------------------
+static void FillRandom(std::vector<XRGBColor>& colors)
+{
+	for (uint32 i = 0; i < colors.size(); ++i)
+		colors[i] = XRGBColor(Random(256L)/255.0, Random(256L)/255.0, Random(1.0f));
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class XPixelSpansTest
+// ===================================================================================	
+
+//---------------------------------------------------------------
+//
+// XPixelSpansTest::~XPixelSpansTest
+//
+//---------------------------------------------------------------
+XPixelSpansTest::~XPixelSpansTest()
+{
+}
+
+	
+//---------------------------------------------------------------
+//
+// XPixelSpansTest::XPixelSpansTest
+//
+//---------------------------------------------------------------
+XPixelSpansTest::XPixelSpansTest() : XUnitTest(L"Graphics", L"Pixel Spans")
+{
+}
+
+						
+//---------------------------------------------------------------
+//
+// XPixelSpansTest::OnTest
+//
+//---------------------------------------------------------------
+void XPixelSpansTest::OnTest()
+{
+	for (uint32 i = 0; i < kNumDepths; ++i)
+		this->DoTestSpans(kDepths[i]);
+
+	TRACE("Filling a ", kTimingWidth, "x", kTimingHeight, " image:\n");
+	for (uint32 i = 0; i < kNumDepths; ++i)
+		this->DoTimeFill(kDepths[i]);
+
+	TRACE("Completed pixel spans test.\n\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// XPixelSpansTest::DoTestSpans
+//
+// Writes spans with odd offsets and lengths (so the SIMD loops
+// and their scalar tails are both used) and checks that the pixels 
+// match what SetPixelAt would have written.
+//
+//---------------------------------------------------------------
+void XPixelSpansTest::DoTestSpans(int32 depth)
+{
+	const int32 kWidth = 37;
+	
+	XPixMap image(XSize(kWidth, 4), nil, depth);
+	XLocker lock(image);
+	
+	std::vector<XRGBColor> colors(kWidth);
+	FillRandom(colors);
+	colors[0] = kRGBBlack;
+	colors[1] = kRGBWhite;
+	
+	std::vector<uint32> pixels(kWidth);
+	image.ColorsToPixels(&colors[0], &pixels[0], kWidth);
+	for (int32 h = 0; h < kWidth; ++h)
+		ASSERT(pixels[(uint32) h] == image.ColorToPixel(colors[(uint32) h].GetOSColor()));
+
+	for (int32 v = 0; v < 4; ++v) {
+		int32 left  = v;						
+		int32 count = kWidth - 2*v;
+		
+		image.Erase();
+		image.SetColorsAt(left, v, &colors[0], (uint32) count);
+		
+		for (int32 h = 0; h < kWidth; ++h) {
+			uint32 expected = h >= left && h < left + count ? pixels[(uint32) (h - left)] : 0;
+			ASSERT(image.GetPixelAt(h, v) == expected);
+		}
+	}
+	
+	image.Erase();
+	image.SetPixelsAt(1, 2, &pixels[0], kWidth - 1);
+	for (int32 h = 1; h < kWidth; ++h)
+		ASSERT(image.GetPixelAt(h, 2) == pixels[(uint32) (h - 1)]);
+	ASSERT(image.GetPixelAt(0, 2) == 0);
+		
+	const uint8* row = image.GetRowBuffer(3);
+	ASSERT(row == image.GetBufferAt(0, 3));
+}
+
+
+//---------------------------------------------------------------
+//
+// XPixelSpansTest::DoTimeFill
+//
+// Compares filling an image a pixel at a time (the way the renderer
+// used to) with filling it a row at a time.
+//
+//---------------------------------------------------------------
+void XPixelSpansTest::DoTimeFill(int32 depth)
+{
+	XPixMap image(XSize(kTimingWidth, kTimingHeight), nil, depth);
+	XLocker lock(image);
+	
+	std::vector<XRGBColor> colors(kTimingWidth);
+	FillRandom(colors);
+	
+	MilliSecond start = GetMilliSeconds();
+	for (int32 v = 0; v < kTimingHeight; ++v) {
+		for (int32 h = 0; h < kTimingWidth; ++h) {
+			uint32 pixel = image.ColorToPixel(colors[(uint32) h].GetOSColor());
+			image.SetPixelAt(h, v, pixel);
+		}
+	}
+	MilliSecond pixelTime = GetMilliSeconds() - start;
+	
+	start = GetMilliSeconds();
+	for (int32 v = 0; v < kTimingHeight; ++v)
+		image.SetColorsAt(0, v, &colors[0], kTimingWidth);
+	MilliSecond spanTime = GetMilliSeconds() - start;
+	
+	std::vector<uint32> pixels(kTimingWidth);
+	image.ColorsToPixels(&colors[0], &pixels[0], kTimingWidth);
+
+	start = GetMilliSeconds();
+	for (int32 v = 0; v < kTimingHeight; ++v)
+		image.SetPixelsAt(0, v, &pixels[0], kTimingWidth);
+	MilliSecond copyTime = GetMilliSeconds() - start;
+	
+	TRACE("   ", depth, "-bit: SetPixelAt ", GetRate(kTimingPixels, pixelTime, 1.0e6), " MP/s, SetColorsAt ", GetRate(kTimingPixels, spanTime, 1.0e6), " MP/s, SetPixelsAt ", GetRate(kTimingPixels, copyTime, 1.0e6), " MP/s\n");
+}
+
+
+#endif	// DEBUG
+}		// namespace Whisper
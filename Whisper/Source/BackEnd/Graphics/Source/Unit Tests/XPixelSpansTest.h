@@ -0,0 +1,60 @@
+/*
+ *  File:       XPixelSpansTest.h
+ *  Summary:	Unit test and benchmark for the XBaseImage span functions.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XPixelSpansTest.h,v $
+ */
+
+#pragma once
+
+#include <XUnitTest.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class XPixelSpansTest
+// ===================================================================================	
+#if DEBUG
+class XPixelSpansTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~XPixelSpansTest();
+	
+						XPixelSpansTest();
+						
+//-----------------------------------
+//	Inherited API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		DoTestSpans(int32 depth);
+			void 		DoTimeFill(int32 depth);
+};
+#endif
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
+
@@ -18,8 +18,11 @@
 #include <XWhisperHeader.h>
 #include <XRegisterGraphicTests.h>
 
+#include <XBandedRegionTest.h>
+#include <XColorQuantizerTest.h>
 #include <XDesktopTest.h>
 #include <XDisplayTest.h>
+#include <XPixelSpansTest.h>
 #include <XPNGTest.h>
 #include <XShapesTest.h>
 
@@ -42,8 +45,11 @@ namespace Whisper {
 //---------------------------------------------------------------
 void RegisterGraphicTests()
 {
+	static XBandedRegionTest sBandedRegionTest;
+	static XColorQuantizerTest sColorQuantizerTest;
 	static XDesktopUnitTest sDesktopTest;
 	static XDisplayUnitTest sDisplayTest;
+	static XPixelSpansTest  sPixelSpansTest;
 	static XPNGTest         sPNGTest;
 	static XShapesUnitTest  sShapesTest;
 }
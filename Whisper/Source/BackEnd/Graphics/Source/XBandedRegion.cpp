@@ -0,0 +1,829 @@
+/*
+ *  File:       XBandedRegion.cpp
+ *  Summary:   	Portable region class that stores the region as y-x banded rectangles.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XBandedRegion.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XBandedRegion.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <XDebug.h>
+#include <XNumbers.h>
+#include <XRegion.h>
+
+namespace Whisper {
+
+
+//-----------------------------------
+//	Internal Constants
+//
+const int32 kMaxCoordinate = 0x7FFFFFFF;
+const int32 kMinCoordinate = -kMaxCoordinate;
+
+
+//-----------------------------------
+//	Internal Types
+//
+struct SCrossing {
+	double	x;
+	int32	winding;			// +1 if the edge goes down, -1 if it goes up
+
+	bool operator<(const SCrossing& rhs) const	{return x < rhs.x;}
+};
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// Apply
+//
+//---------------------------------------------------------------
+inline bool Apply(XBandedRegion::EOperation op, bool inLhs, bool inRhs)
+{
+	bool inside = false;
+
+	switch (op) {
+		case XBandedRegion::kUnion:
+			inside = inLhs || inRhs;
+			break;
+
+		case XBandedRegion::kIntersection:
+			inside = inLhs && inRhs;
+			break;
+
+		case XBandedRegion::kDifference:
+			inside = inLhs && !inRhs;
+			break;
+
+		case XBandedRegion::kExclusiveOr:
+			inside = inLhs != inRhs;
+			break;
+
+		default:
+			DEBUGSTR("Bad operation in XBandedRegion Apply");
+	}
+
+	return inside;
+}
+
+
+//---------------------------------------------------------------
+//
+// MergeSpans
+//
+// Walks the left and right edges of two sorted lists of spans
+// and appends the left and right edges of the combined spans
+// to edges.
+//
+//---------------------------------------------------------------
+static void MergeSpans(const XRect* lhs, uint32 lhsCount, const XRect* rhs, uint32 rhsCount, XBandedRegion::EOperation op, std::vector<int32>& edges)
+{
+	uint32 i = 0, j = 0;
+	bool inLhs = false, inRhs = false, inside = false;
+
+	while (i < lhsCount || j < rhsCount) {
+		int32 lhsEdge = i < lhsCount ? (inLhs ? lhs[i].right : lhs[i].left) : kMaxCoordinate;
+		int32 rhsEdge = j < rhsCount ? (inRhs ? rhs[j].right : rhs[j].left) : kMaxCoordinate;
+		int32 x = Min(lhsEdge, rhsEdge);
+
+		if (lhsEdge == x) {
+			if (inLhs)
+				++i;
+			inLhs = !inLhs;
+		}
+
+		if (rhsEdge == x) {
+			if (inRhs)
+				++j;
+			inRhs = !inRhs;
+		}
+
+		bool now = Apply(op, inLhs, inRhs);
+		if (now != inside) {
+			edges.push_back(x);
+			inside = now;
+		}
+	}
+
+	POSTCONDITION(!inside);
+}
+
+
+//---------------------------------------------------------------
+//
+// GetPixelSpan
+//
+// Returns the pixels whose centers are in [left, right).
+//
+//---------------------------------------------------------------
+inline void GetPixelSpan(double left, double right, int32& first, int32& last)
+{
+	first = (int32) std::ceil(left - 0.5);
+	last  = (int32) std::ceil(right - 0.5);
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	Friend Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// operator+ (XBandedRegion, XBandedRegion)
+//
+//---------------------------------------------------------------
+XBandedRegion operator+(const XBandedRegion& lhs, const XBandedRegion& rhs)
+{
+	return XBandedRegion::DoCombine(lhs, rhs, XBandedRegion::kUnion);
+}
+
+
+//---------------------------------------------------------------
+//
+// operator- (XBandedRegion, XBandedRegion)
+//
+//---------------------------------------------------------------
+XBandedRegion operator-(const XBandedRegion& lhs, const XBandedRegion& rhs)
+{
+	return XBandedRegion::DoCombine(lhs, rhs, XBandedRegion::kDifference);
+}
+
+
+//---------------------------------------------------------------
+//
+// operator& (XBandedRegion, XBandedRegion)
+//
+//---------------------------------------------------------------
+XBandedRegion operator&(const XBandedRegion& lhs, const XBandedRegion& rhs)
+{
+	return XBandedRegion::DoCombine(lhs, rhs, XBandedRegion::kIntersection);
+}
+
+
+//---------------------------------------------------------------
+//
+// operator^ (XBandedRegion, XBandedRegion)
+//
+//---------------------------------------------------------------
+XBandedRegion operator^(const XBandedRegion& lhs, const XBandedRegion& rhs)
+{
+	return XBandedRegion::DoCombine(lhs, rhs, XBandedRegion::kExclusiveOr);
+}
+
+
+//---------------------------------------------------------------
+//
+// operator+ (XBandedRegion, XPoint)
+//
+//---------------------------------------------------------------
+XBandedRegion operator+(const XBandedRegion& rgn, const XPoint& offset)
+{
+	XBandedRegion newRgn = rgn;
+	newRgn += offset;
+
+	return newRgn;
+}
+
+
+//---------------------------------------------------------------
+//
+// operator- (XBandedRegion, XPoint)
+//
+//---------------------------------------------------------------
+XBandedRegion operator-(const XBandedRegion& rgn, const XPoint& offset)
+{
+	XBandedRegion newRgn = rgn;
+	newRgn -= offset;
+
+	return newRgn;
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class XBandedRegion
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::~XBandedRegion
+//
+//---------------------------------------------------------------
+XBandedRegion::~XBandedRegion()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::XBandedRegion ()
+//
+//---------------------------------------------------------------
+XBandedRegion::XBandedRegion() : mBands(1, 0), mBounds(kZeroRect)
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::XBandedRegion (XRect)
+//
+//---------------------------------------------------------------
+XBandedRegion::XBandedRegion(const XRect& rect) : mBands(1, 0)
+{
+	if (!rect.IsEmpty()) {
+		mRects.push_back(rect);
+		mBands.push_back(1);
+	}
+
+	this->DoFinish();
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::XBandedRegion (XRect*, uint32)
+//
+//---------------------------------------------------------------
+XBandedRegion::XBandedRegion(const XRect* rects, uint32 count)
+{
+	PRECONDITION(rects != nil || count == 0);
+
+	*this = DoUnion(rects, count);
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::XBandedRegion (XRect, int32, int32)
+//
+//---------------------------------------------------------------
+XBandedRegion::XBandedRegion(const XRect& rect, int32 ovalWidth, int32 ovalHeight) : mBands(1, 0)
+{
+	PRECONDITION(ovalWidth >= 0);
+	PRECONDITION(ovalHeight >= 0);
+
+	this->DoAddRoundRect(rect, ovalWidth, ovalHeight);
+	this->DoFinish();
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::XBandedRegion (XPoint, int32, int32)
+//
+//---------------------------------------------------------------
+XBandedRegion::XBandedRegion(const XPoint& center, int32 width, int32 height) : mBands(1, 0)
+{
+	PRECONDITION(width >= 0);
+	PRECONDITION(height >= 0);
+
+	XRect rect;
+	rect.left   = center.x - width/2;
+	rect.top    = center.y - height/2;
+	rect.right  = rect.left + width;
+	rect.bottom = rect.top + height;
+
+	this->DoAddRoundRect(rect, width, height);		// an ellipse is a round rect where the corners meet
+	this->DoFinish();
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::XBandedRegion (XPoint*, uint32)
+//
+// Scan converts the polygon a row at a time. Pixels are inside
+// if their centers are inside (so polygons that share an edge
+// don't overlap).
+//
+//---------------------------------------------------------------
+XBandedRegion::XBandedRegion(const XPoint* vertices, uint32 count) : mBands(1, 0)
+{
+	PRECONDITION(vertices != nil || count == 0);
+
+	if (count >= 3) {
+		int32 top = vertices[0].y, bottom = vertices[0].y;
+		for (uint32 i = 1; i < count; ++i) {
+			top    = Min(top, vertices[i].y);
+			bottom = Max(bottom, vertices[i].y);
+		}
+
+		std::vector<SCrossing> crossings;
+		std::vector<int32> edges;
+
+		for (int32 y = top; y < bottom; ++y) {
+			double center = y + 0.5;
+
+			crossings.clear();
+			for (uint32 i = 0; i < count; ++i) {
+				const XPoint& from = vertices[i];
+				const XPoint& to = vertices[(i + 1) % count];
+
+				if ((from.y <= center && to.y > center) || (to.y <= center && from.y > center)) {
+					SCrossing crossing;
+					crossing.x = from.x + (center - from.y)*(to.x - from.x)/(to.y - from.y);
+					crossing.winding = to.y > from.y ? 1 : -1;
+					crossings.push_back(crossing);
+				}
+			}
+
+			std::sort(crossings.begin(), crossings.end());
+
+			edges.clear();
+			int32 winding = 0;
+			double start = 0.0;
+			for (uint32 i = 0; i < crossings.size(); ++i) {
+				int32 old = winding;
+				winding += crossings[i].winding;
+
+				if (old == 0 && winding != 0)
+					start = crossings[i].x;
+
+				else if (old != 0 && winding == 0) {
+					int32 first, last;
+					GetPixelSpan(start, crossings[i].x, first, last);
+
+					if (first < last) {
+						if (!edges.empty() && edges.back() >= first)
+							edges.back() = Max(edges.back(), last);		// spans that round to touching pixels have to be merged
+						else {
+							edges.push_back(first);
+							edges.push_back(last);
+						}
+					}
+				}
+			}
+
+			this->DoAppendBand(y, y + 1, edges);
+		}
+	}
+
+	this->DoFinish();
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::operator+= (XPoint)
+//
+//---------------------------------------------------------------
+XBandedRegion& XBandedRegion::operator+=(const XPoint& offset)
+{
+	for (uint32 i = 0; i < mRects.size(); ++i)
+		mRects[i] += offset;
+
+	if (!mRects.empty())
+		mBounds += offset;
+
+	return *this;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::operator-= (XPoint)
+//
+//---------------------------------------------------------------
+XBandedRegion& XBandedRegion::operator-=(const XPoint& offset)
+{
+	for (uint32 i = 0; i < mRects.size(); ++i)
+		mRects[i] -= offset;
+
+	if (!mRects.empty())
+		mBounds -= offset;
+
+	return *this;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::MakeEmpty
+//
+//---------------------------------------------------------------
+void XBandedRegion::MakeEmpty()
+{
+	mRects.clear();
+	mBands.resize(1);
+	mBounds = kZeroRect;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::MoveTo
+//
+//---------------------------------------------------------------
+void XBandedRegion::MoveTo(const XPoint& pt)
+{
+	XPoint offset(pt.x - mBounds.left, pt.y - mBounds.top);
+
+	this->operator+=(offset);
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::Contains (XPoint)
+//
+//---------------------------------------------------------------
+bool XBandedRegion::Contains(const XPoint& pt) const
+{
+	bool contains = false;
+
+	if (!mRects.empty() && mBounds.Contains(pt)) {
+		uint32 band = this->DoFindBand(pt.y);
+
+		if (band < this->GetNumBands() && mRects[mBands[band]].top <= pt.y) {
+			const XRect* rect = this->DoFindRect(band, pt.x);
+			contains = rect != nil && rect->left <= pt.x;
+		}
+	}
+
+	return contains;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::Contains (XRect)
+//
+// The rectangle is contained if the bands that cover its rows
+// are contiguous and each has a span that covers its columns.
+//
+//---------------------------------------------------------------
+bool XBandedRegion::Contains(const XRect& rect) const
+{
+	if (rect.IsEmpty())
+		return true;
+
+	if (mRects.empty() || !mBounds.Contains(rect))
+		return false;
+
+	uint32 numBands = this->GetNumBands();
+	uint32 band = this->DoFindBand(rect.top);
+
+	int32 y = rect.top;
+	while (y < rect.bottom) {
+		if (band >= numBands || mRects[mBands[band]].top > y)
+			return false;
+
+		const XRect* span = this->DoFindRect(band, rect.left);
+		if (span == nil || span->left > rect.left || span->right < rect.right)
+			return false;
+
+		y = span->bottom;
+		++band;
+	}
+
+	return true;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::Intersects
+//
+//---------------------------------------------------------------
+bool XBandedRegion::Intersects(const XRect& rect) const
+{
+	if (rect.IsEmpty() || mRects.empty())
+		return false;
+
+	if (rect.left >= mBounds.right || rect.right <= mBounds.left || rect.top >= mBounds.bottom || rect.bottom <= mBounds.top)
+		return false;
+
+	uint32 numBands = this->GetNumBands();
+	for (uint32 band = this->DoFindBand(rect.top); band < numBands && mRects[mBands[band]].top < rect.bottom; ++band) {
+		const XRect* span = this->DoFindRect(band, rect.left);
+		if (span != nil && span->left < rect.right)
+			return true;
+	}
+
+	return false;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::GetRegion
+//
+//---------------------------------------------------------------
+XRegion XBandedRegion::GetRegion() const
+{
+	XRegion rgn;
+
+	if (!mRects.empty())
+		rgn = XRegion(&mRects[0], (uint32) mRects.size());
+
+	return rgn;
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::Invariant
+//
+//---------------------------------------------------------------
+void XBandedRegion::Invariant() const
+{
+	ASSERT(!mBands.empty());
+	ASSERT(mBands.front() == 0);
+	ASSERT(mBands.back() == mRects.size());
+
+	for (uint32 band = 0; band < this->GetNumBands(); ++band) {
+		ASSERT(mBands[band] < mBands[band + 1]);
+
+		const XRect& first = mRects[mBands[band]];
+		if (band > 0)
+			ASSERT(mRects[mBands[band] - 1].bottom <= first.top);
+
+		for (uint32 i = mBands[band]; i < mBands[band + 1]; ++i) {
+			ASSERT(!mRects[i].IsEmpty());
+			ASSERT(mRects[i].top == first.top && mRects[i].bottom == first.bottom);
+			if (i > mBands[band])
+				ASSERT(mRects[i - 1].right < mRects[i].left);
+
+			ASSERT(mBounds.Contains(mRects[i]));
+		}
+	}
+
+	if (mRects.empty())
+		ASSERT(mBounds == kZeroRect);
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::DoCombine									[static]
+//
+// Sweeps down both regions at once. Each step handles the rows
+// up to the next place a band starts or stops in either region
+// so within a step each region has at most one band and the
+// spans can be merged with a single pass.
+//
+//---------------------------------------------------------------
+XBandedRegion XBandedRegion::DoCombine(const XBandedRegion& lhs, const XBandedRegion& rhs, EOperation op)
+{
+	XBandedRegion result;
+	result.mRects.reserve(lhs.mRects.size() + rhs.mRects.size());
+	result.mBands.reserve(lhs.mBands.size() + rhs.mBands.size());
+
+	std::vector<int32> edges;
+
+	uint32 numLhs = lhs.GetNumBands();
+	uint32 numRhs = rhs.GetNumBands();
+	uint32 i = 0, j = 0;
+
+	int32 y = kMinCoordinate;
+	while (i < numLhs || j < numRhs) {
+		const XRect* lhsBand = i < numLhs ? &lhs.mRects[lhs.mBands[i]] : nil;
+		const XRect* rhsBand = j < numRhs ? &rhs.mRects[rhs.mBands[j]] : nil;
+
+		int32 top = Max(y, Min(lhsBand != nil ? lhsBand->top : kMaxCoordinate, rhsBand != nil ? rhsBand->top : kMaxCoordinate));
+
+		bool inLhs = lhsBand != nil && lhsBand->top <= top;
+		bool inRhs = rhsBand != nil && rhsBand->top <= top;
+
+		int32 bottom = kMaxCoordinate;
+		if (lhsBand != nil)
+			bottom = Min(bottom, inLhs ? lhsBand->bottom : lhsBand->top);
+		if (rhsBand != nil)
+			bottom = Min(bottom, inRhs ? rhsBand->bottom : rhsBand->top);
+		ASSERT(bottom > top);
+
+		if (Apply(op, inLhs, inRhs) || (inLhs && inRhs)) {		// skip the merge if the result has to be empty
+			uint32 lhsCount = inLhs ? lhs.mBands[i + 1] - lhs.mBands[i] : 0;
+			uint32 rhsCount = inRhs ? rhs.mBands[j + 1] - rhs.mBands[j] : 0;
+
+			edges.clear();
+			MergeSpans(lhsBand, lhsCount, rhsBand, rhsCount, op, edges);
+			result.DoAppendBand(top, bottom, edges);
+		}
+
+		y = bottom;
+		if (lhsBand != nil && lhsBand->bottom <= y)
+			++i;
+		if (rhsBand != nil && rhsBand->bottom <= y)
+			++j;
+	}
+
+	result.DoFinish();
+
+	return result;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::DoUnion									[static]
+//
+// Divide and conquer so building a region from n rectangles is
+// O(n log n) instead of the O(n^2) of adding them one at a time.
+//
+//---------------------------------------------------------------
+XBandedRegion XBandedRegion::DoUnion(const XRect* rects, uint32 count)
+{
+	XBandedRegion result;
+
+	if (count == 1)
+		result = XBandedRegion(rects[0]);
+
+	else if (count > 1) {
+		uint32 half = count/2;
+		result = DoCombine(DoUnion(rects, half), DoUnion(rects + half, count - half), kUnion);
+	}
+
+	return result;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::DoAddRoundRect
+//
+// The corners are quarter ellipses ovalWidth wide and ovalHeight
+// high. Like the polygon code pixels are inside if their centers
+// are inside.
+//
+//---------------------------------------------------------------
+void XBandedRegion::DoAddRoundRect(const XRect& rect, int32 ovalWidth, int32 ovalHeight)
+{
+	PRECONDITION(mRects.empty());
+
+	if (rect.IsEmpty())
+		return;
+
+	double rx = Min(ovalWidth, rect.GetWidth())/2.0;
+	double ry = Min(ovalHeight, rect.GetHeight())/2.0;
+
+	std::vector<int32> edges(2);
+
+	for (int32 y = rect.top; y < rect.bottom; ++y) {
+		double center = y + 0.5;
+		double dy = Max(rect.top + ry - center, center - (rect.bottom - ry));		// distance into the corner ellipse
+
+		double inset = 0.0;
+		if (dy > 0.0 && ry > 0.0)
+			inset = rx - rx*std::sqrt(Max(1.0 - (dy*dy)/(ry*ry), 0.0));
+
+		int32 first, last;
+		GetPixelSpan(rect.left + inset, rect.right - inset, first, last);
+
+		if (first < last) {
+			edges[0] = first;
+			edges[1] = last;
+			this->DoAppendBand(y, y + 1, edges);
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::DoAppendBand
+//
+// Adds a band below the existing bands. edges contains the left
+// and right sides of the band's spans. If the band is just below
+// the last band and has the same spans the last band is extended
+// instead.
+//
+//---------------------------------------------------------------
+void XBandedRegion::DoAppendBand(int32 top, int32 bottom, const std::vector<int32>& edges)
+{
+	PRECONDITION(top < bottom);
+	PRECONDITION(edges.size() % 2 == 0);
+	PRECONDITION(mRects.empty() || mRects.back().bottom <= top);
+
+	if (edges.empty())
+		return;
+
+	uint32 count = (uint32) edges.size()/2;
+
+	uint32 numBands = this->GetNumBands();
+	if (numBands > 0) {
+		uint32 first = mBands[numBands - 1];
+
+		if (mRects[first].bottom == top && mRects.size() - first == count) {
+			bool same = true;
+			for (uint32 i = 0; i < count && same; ++i)
+				same = mRects[first + i].left == edges[2*i] && mRects[first + i].right == edges[2*i + 1];
+
+			if (same) {
+				for (uint32 i = first; i < mRects.size(); ++i)
+					mRects[i].bottom = bottom;
+				return;
+			}
+		}
+	}
+
+	for (uint32 i = 0; i < count; ++i)
+		mRects.push_back(XRect(edges[2*i], top, edges[2*i + 1], bottom));
+	mBands.push_back((uint32) mRects.size());
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::DoFinish
+//
+//---------------------------------------------------------------
+void XBandedRegion::DoFinish()
+{
+	if (mRects.empty())
+		mBounds = kZeroRect;
+
+	else {
+		mBounds.top    = mRects.front().top;
+		mBounds.bottom = mRects.back().bottom;
+		mBounds.left   = mRects.front().left;
+		mBounds.right  = mRects.front().right;
+
+		for (uint32 band = 0; band < this->GetNumBands(); ++band) {
+			mBounds.left  = Min(mBounds.left, mRects[mBands[band]].left);
+			mBounds.right = Max(mBounds.right, mRects[mBands[band + 1] - 1].right);
+		}
+	}
+
+	CALL_INVARIANT;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::DoFindBand
+//
+// Returns the first band whose bottom is below y (or the number
+// of bands if there isn't one).
+//
+//---------------------------------------------------------------
+uint32 XBandedRegion::DoFindBand(int32 y) const
+{
+	uint32 lo = 0;
+	uint32 hi = this->GetNumBands();
+
+	while (lo < hi) {
+		uint32 mid = (lo + hi)/2;
+
+		if (mRects[mBands[mid]].bottom <= y)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBandedRegion::DoFindRect
+//
+// Returns the first rectangle in band whose right side is past
+// x or nil if there isn't one.
+//
+//---------------------------------------------------------------
+const XRect* XBandedRegion::DoFindRect(uint32 band, int32 x) const
+{
+	PRECONDITION(band < this->GetNumBands());
+
+	uint32 lo = mBands[band];
+	uint32 hi = mBands[band + 1];
+	uint32 end = hi;
+
+	while (lo < hi) {
+		uint32 mid = (lo + hi)/2;
+
+		if (mRects[mid].right <= x)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo < end ? &mRects[lo] : nil;
+}
+
+
+}	// namespace Whisper
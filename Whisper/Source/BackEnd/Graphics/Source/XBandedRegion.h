@@ -0,0 +1,181 @@
+/*
+ *  File:       XBandedRegion.h
+ *  Summary:   	Portable region class that stores the region as y-x banded rectangles.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XBandedRegion.h,v $
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <XRect.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+//-----------------------------------
+//	Forward References
+//
+class XRegion;
+
+
+// ===================================================================================
+//	class XBandedRegion
+//!		Portable region class that stores the region as y-x banded rectangles.
+/*!		The region is kept as a list of rectangles sorted by top and then left. Rectangles
+ *		with the same top and bottom form a band, bands don't overlap, rectangles within
+ *		a band don't touch, and vertically adjacent bands with the same spans are merged.
+ *		This makes the representation canonical so comparisons are a simple walk over
+ *		the rectangles. Set operations sweep down both regions at once so they're linear
+ *		in the number of rectangles and hit tests use a binary search over the bands and
+ *		then over the rectangles within a band.
+ *
+ *		The API mirrors XRegion. Unlike XRegion the region doesn't wrap an OS object so
+ *		it's fast to copy and combine and it's a good choice when building up an update
+ *		region or doing hit testing with thousands of rectangles. Use GetRegion when a
+ *		region is needed for clipping. On platforms without an OS region XRegion is
+ *		implemented with this class. */
+// ===================================================================================
+class GRAPHICS_EXPORT XBandedRegion {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+						~XBandedRegion();
+
+						XBandedRegion();
+
+						XBandedRegion(const XRect& rect);
+						/**< rectangle */
+
+						XBandedRegion(const XRect* rects, uint32 count);
+						/**< union of a list of (possibly overlapping) rectangles */
+
+						XBandedRegion(const XRect& rect, int32 ovalWidth, int32 ovalHeight);
+						/**< round rectangle */
+
+						XBandedRegion(const XPoint& center, int32 width, int32 height);
+						/**< ellipse */
+
+						XBandedRegion(const XPoint* vertices, uint32 count);
+						/**< polygon (uses the non-zero winding rule like XRegion on Windows) */
+
+//-----------------------------------
+//	API
+//
+public:
+	//! @name Assignment
+	//@{
+			XBandedRegion& operator+=(const XBandedRegion& rhs)		{*this = *this + rhs; return *this;}
+			XBandedRegion& operator-=(const XBandedRegion& rhs)		{*this = *this - rhs; return *this;}
+			XBandedRegion& operator&=(const XBandedRegion& rhs)		{*this = *this & rhs; return *this;}
+			XBandedRegion& operator^=(const XBandedRegion& rhs)		{*this = *this ^ rhs; return *this;}
+
+			XBandedRegion& operator+=(const XPoint& offset);
+			XBandedRegion& operator-=(const XPoint& offset);
+	//@}
+
+	//! @name Arithmetic
+	//@{
+	friend 	GRAPHICS_EXPORT XBandedRegion operator+(const XBandedRegion& lhs, const XBandedRegion& rhs);
+	friend 	GRAPHICS_EXPORT XBandedRegion operator-(const XBandedRegion& lhs, const XBandedRegion& rhs);
+	friend 	GRAPHICS_EXPORT XBandedRegion operator&(const XBandedRegion& lhs, const XBandedRegion& rhs);
+	friend 	GRAPHICS_EXPORT XBandedRegion operator^(const XBandedRegion& lhs, const XBandedRegion& rhs);
+
+			void 		MakeEmpty();
+	//@}
+
+	//! @name Moving
+	//@{
+	friend 	GRAPHICS_EXPORT XBandedRegion operator+(const XBandedRegion& lhs, const XPoint& offset);
+	friend 	GRAPHICS_EXPORT XBandedRegion operator-(const XBandedRegion& lhs, const XPoint& offset);
+
+			void 		MoveTo(const XPoint& pt);
+						/**< Moves region so that origin is at pt. */
+	//@}
+
+	//! @name Comparison
+	//@{
+			bool 		operator==(const XBandedRegion& rhs) const		{return mRects == rhs.mRects;}
+			bool 		operator!=(const XBandedRegion& rhs) const		{return mRects != rhs.mRects;}
+	//@}
+
+	//! @name Inquiry
+	//@{
+			bool		IsEmpty() const									{return mRects.empty();}
+
+			XRect 		GetEnclosingRect() const						{return mBounds;}
+						/**< This is cached so it's very fast. */
+
+			bool 		Contains(const XPoint& pt) const;
+			bool 		Contains(const XRect& rect) const;
+						/**< Empty rectangles are contained by every region. */
+
+			bool 		Intersects(const XRect& rect) const;
+	//@}
+
+	//! @name Rectangles
+	//@{
+			uint32		GetNumRects() const								{return (uint32) mRects.size();}
+			const XRect* GetRects() const								{return mRects.empty() ? nil : &mRects[0];}
+						/**< Returns the rectangles sorted by top and then left. The
+						rectangles don't overlap. */
+
+			uint32		GetNumBands() const								{return (uint32) mBands.size() - 1;}
+	//@}
+
+	//! @name Conversion
+	//@{
+			XRegion		GetRegion() const;
+						/**< Returns an OS region with the same pixels. */
+	//@}
+
+//-----------------------------------
+//	Types
+//
+public:
+	enum EOperation {kUnion, kIntersection, kDifference, kExclusiveOr};
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		Invariant() const;
+
+	static	XBandedRegion DoCombine(const XBandedRegion& lhs, const XBandedRegion& rhs, EOperation op);
+	static	XBandedRegion DoUnion(const XRect* rects, uint32 count);
+
+			void 		DoAddRoundRect(const XRect& rect, int32 ovalWidth, int32 ovalHeight);
+			void 		DoAppendBand(int32 top, int32 bottom, const std::vector<int32>& edges);
+			void 		DoFinish();
+
+			uint32 		DoFindBand(int32 y) const;
+			const XRect* DoFindRect(uint32 band, int32 x) const;
+
+//-----------------------------------
+//	Member Data
+//
+protected:
+	std::vector<XRect>	mRects;
+	std::vector<uint32>	mBands;			// index of the first rectangle in each band followed by mRects.size()
+	XRect				mBounds;
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
@@ -40,9 +40,36 @@
 #include <XMemUtils.h>
 #include <XNumbers.h>
 
+#if WHISPER_SSE2
+	#include <emmintrin.h>
+#endif
+
 namespace Whisper {
 
 
+//-----------------------------------
+//	Internal Constants
+//
+#if MAC
+	const double kComponentScale = 65535.0;			// these match XRGBColor::GetOSColor
+	const uint32 kComponentBits  = 16;
+#elif WIN
+	const double kComponentScale = 255.0;
+	const uint32 kComponentBits  = 8;
+#endif
+
+const uint32 kSpanChunk = 256;						// SetColorsAt converts this many pixels at a time into a stack buffer
+
+
+//-----------------------------------
+//	Internal Types
+//
+struct SChannelLayout {
+	uint32	rightShift[3];							// drops the low bits of the red, green, and blue OS color components
+	uint32	leftShift[3];							// moves the components to their position within the pixel
+};
+
+
 // ===================================================================================
 //	Internal Functions
 // ===================================================================================
@@ -97,6 +124,107 @@ static uint32 GetBits(uint32 mask)
 	return count;
 }
 
+
+//---------------------------------------------------------------
+//
+// GetLayout
+//
+//---------------------------------------------------------------
+static SChannelLayout GetLayout(const XBaseImage& image)
+{
+	PRECONDITION(image.GetDepth() > 8);
+	
+	uint32 masks[3];
+	masks[0] = image.GetRedMask();
+	masks[1] = image.GetGreenMask();
+	masks[2] = image.GetBlueMask();
+	
+	SChannelLayout layout;
+	for (uint32 i = 0; i < 3; ++i) {
+		layout.rightShift[i] = kComponentBits - GetBits(masks[i]);
+		layout.leftShift[i]  = GetShift(masks[i]);
+	}
+	
+	return layout;
+}
+
+
+//---------------------------------------------------------------
+//
+// ToPixel
+//
+// Same as XBaseImage::ColorToPixel(color.GetOSColor()).
+//
+//---------------------------------------------------------------
+inline uint32 ToPixel(const float* rgb, const SChannelLayout& layout)
+{
+	uint32 pixel = 0;
+	
+	for (uint32 i = 0; i < 3; ++i) {
+		uint32 component = (uint32) (rgb[i]*kComponentScale);
+		pixel |= (component >> layout.rightShift[i]) << layout.leftShift[i];
+	}
+	
+	return pixel;
+}
+
+
+//---------------------------------------------------------------
+//
+// ToComponents
+//
+// Returns the four floats scaled by kComponentScale and truncated.
+// The math is done with doubles so that the results match ToPixel.
+//
+//---------------------------------------------------------------
+#if WHISPER_SSE2
+inline __m128i ToComponents(__m128 values)
+{
+	__m128d scale = _mm_set1_pd(kComponentScale);
+	
+	__m128i lo = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtps_pd(values), scale));
+	__m128i hi = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(values, values)), scale));
+	
+	return _mm_unpacklo_epi64(lo, hi);
+}
+#endif
+
+
+//---------------------------------------------------------------
+//
+// ToPixels4
+//
+// Converts four red, green, blue triples into four pixels.
+//
+//---------------------------------------------------------------
+#if WHISPER_SSE2
+inline __m128i ToPixels4(const float* rgb, const SChannelLayout& layout)
+{
+	__m128 a = _mm_loadu_ps(rgb);										// r0 g0 b0 r1
+	__m128 b = _mm_loadu_ps(rgb + 4);									// g1 b1 r2 g2
+	__m128 c = _mm_loadu_ps(rgb + 8);									// b2 r3 g3 b3
+	
+	__m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 3, 2));			// r2 g2 b2 r3
+	__m128 p = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));			// g0 b0 g1 b1
+	__m128 q = _mm_shuffle_ps(t, c, _MM_SHUFFLE(3, 2, 2, 1));			// g2 b2 g3 b3
+	
+	__m128 channels[3];
+	channels[0] = _mm_shuffle_ps(a, t, _MM_SHUFFLE(3, 0, 3, 0));		// r0 r1 r2 r3
+	channels[1] = _mm_shuffle_ps(p, q, _MM_SHUFFLE(2, 0, 2, 0));		// g0 g1 g2 g3
+	channels[2] = _mm_shuffle_ps(p, q, _MM_SHUFFLE(3, 1, 3, 1));		// b0 b1 b2 b3
+	
+	__m128i pixels = _mm_setzero_si128();
+	for (uint32 i = 0; i < 3; ++i) {
+		__m128i component = ToComponents(channels[i]);
+		component = _mm_srl_epi32(component, _mm_cvtsi32_si128((int) layout.rightShift[i]));
+		component = _mm_sll_epi32(component, _mm_cvtsi32_si128((int) layout.leftShift[i]));
+		pixels = _mm_or_si128(pixels, component);
+	}
+	
+	return pixels;
+}
+#endif
+
 #if __MWERKS__
 #pragma mark -
 #endif
@@ -331,7 +459,7 @@ uint32 XBaseImage::GetPixelAt(int32 h, int32 v) const
 		result = *((uint16 *) buffer);
 	
 	else if (mDepth == 24)
-		result = (uint32) ((*((uint32 *) buffer)) >> 8);
+		result = ((uint32) buffer[0] << 16) | ((uint32) buffer[1] << 8) | buffer[2];	// byte at a time so we don't read past the end of the row
 	
 	else if (mDepth == 32)
 		result = *((uint32 *) buffer);	
@@ -364,9 +492,10 @@ void XBaseImage::SetPixelAt(int32 h, int32 v, uint32 value)
 		*buffer = (uint16) value;
 
 	} else if (mDepth == 24) {
-		uint32* buffer = (uint32 *) this->GetUnsafeBufferAt(h, v);
-		*buffer &= 0x000F;
-		*buffer |= value << 8;
+		uint8* buffer = this->GetUnsafeBufferAt(h, v);		// byte at a time so the next pixel isn't touched
+		buffer[0] = (uint8) (value >> 16);
+		buffer[1] = (uint8) (value >> 8);
+		buffer[2] = (uint8) value;
 
 	} else if (mDepth == 32) {
 		uint32* buffer = (uint32 *) this->GetUnsafeBufferAt(h, v);
@@ -377,6 +506,182 @@ void XBaseImage::SetPixelAt(int32 h, int32 v, uint32 value)
 }
 
 
+//---------------------------------------------------------------
+//
+// XBaseImage::GetRowBuffer
+//
+//---------------------------------------------------------------
+uint8* XBaseImage::GetRowBuffer(int32 v)
+{
+	PRECONDITION(v >= 0 && v < mSize.height);
+	PRECONDITION(this->IsLocked());
+	
+	uint8* buffer = this->GetUnsafeBuffer() + v*mRowBytes;
+	
+	return buffer;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBaseImage::GetRowBuffer const
+//
+//---------------------------------------------------------------
+const uint8* XBaseImage::GetRowBuffer(int32 v) const
+{
+	PRECONDITION(v >= 0 && v < mSize.height);
+	PRECONDITION(this->IsLocked());
+	
+	const uint8* buffer = this->GetUnsafeBuffer() + v*mRowBytes;
+	
+	return buffer;
+}
+
+
+//---------------------------------------------------------------
+//
+// XBaseImage::ColorsToPixels (XRGBColor*, uint32*, uint32)
+//
+//---------------------------------------------------------------
+void XBaseImage::ColorsToPixels(const XRGBColor* colors, uint32* pixels, uint32 count) const
+{
+	COMPILE_CHECK(sizeof(XRGBColor) == 3*sizeof(float));		// so we can treat colors as an array of floats
+	
+	this->ColorsToPixels(reinterpret_cast<const float*>(colors), pixels, count);
+}
+
+
+//---------------------------------------------------------------
+//
+// XBaseImage::ColorsToPixels (float*, uint32*, uint32)
+//
+//---------------------------------------------------------------
+void XBaseImage::ColorsToPixels(const float* rgb, uint32* pixels, uint32 count) const
+{
+	PRECONDITION(mDepth > 8);
+	PRECONDITION(rgb != nil || count == 0);
+	PRECONDITION(pixels != nil || count == 0);
+	CHECK_INVARIANT;
+	
+#if DEBUG
+	for (uint32 i = 0; i < 3*count; ++i)
+		PRECONDITION(rgb[i] >= 0.0f && rgb[i] <= 1.0f);
+#endif
+
+	SChannelLayout layout = GetLayout(*this);
+	
+	uint32 i = 0;
+	
+#if WHISPER_SSE2
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128((__m128i*) (pixels + i), ToPixels4(rgb + 3*i, layout));
+#endif
+
+	for (; i < count; ++i)
+		pixels[i] = ToPixel(rgb + 3*i, layout);
+}
+
+
+//---------------------------------------------------------------
+//
+// XBaseImage::SetPixelsAt
+//
+//---------------------------------------------------------------
+void XBaseImage::SetPixelsAt(int32 h, int32 v, const uint32* pixels, uint32 count)
+{
+	PRECONDITION(mDepth >= 8);
+	PRECONDITION(h >= 0 && h + (int32) count <= mSize.width);
+	PRECONDITION(pixels != nil || count == 0);
+	
+	if (count == 0)
+		return;
+		
+	uint8* buffer = this->GetUnsafeBufferAt(h, v);
+	uint32 i = 0;
+
+	if (mDepth == 8) {
+		for (; i < count; ++i)
+			buffer[i] = (uint8) pixels[i];
+
+	} else if (mDepth == 16) {
+		uint16* dst = reinterpret_cast<uint16*>(buffer);
+		
+#if WHISPER_SSE2
+		for (; i + 8 <= count; i += 8) {
+			__m128i lo = _mm_loadu_si128((const __m128i*) (pixels + i));
+			__m128i hi = _mm_loadu_si128((const __m128i*) (pixels + i + 4));
+			
+			lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);		// sign extend the low 16 bits so the saturating pack doesn't change them
+			hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+			_mm_storeu_si128((__m128i*) (dst + i), _mm_packs_epi32(lo, hi));
+		}
+#endif
+
+		for (; i < count; ++i)
+			dst[i] = (uint16) pixels[i];
+
+	} else if (mDepth == 24) {
+		for (; i < count; ++i, buffer += 3) {
+			buffer[0] = (uint8) (pixels[i] >> 16);
+			buffer[1] = (uint8) (pixels[i] >> 8);
+			buffer[2] = (uint8) pixels[i];
+		}
+
+	} else if (mDepth == 32) {
+		BlockMoveData(pixels, buffer, (int32) (count*sizeof(uint32)));
+	
+	} else
+		DEBUGSTR("Bad depth in XBaseImage::SetPixelsAt");
+}
+
+
+//---------------------------------------------------------------
+//
+// XBaseImage::SetColorsAt (int32, int32, XRGBColor*, uint32)
+//
+//---------------------------------------------------------------
+void XBaseImage::SetColorsAt(int32 h, int32 v, const XRGBColor* colors, uint32 count)
+{
+	COMPILE_CHECK(sizeof(XRGBColor) == 3*sizeof(float));
+	
+	this->SetColorsAt(h, v, reinterpret_cast<const float*>(colors), count);
+}
+
+
+//---------------------------------------------------------------
+//
+// XBaseImage::SetColorsAt (int32, int32, float*, uint32)
+//
+//---------------------------------------------------------------
+void XBaseImage::SetColorsAt(int32 h, int32 v, const float* rgb, uint32 count)
+{
+	PRECONDITION(mDepth > 8);
+	PRECONDITION(h >= 0 && h + (int32) count <= mSize.width);
+	
+	if (count == 0)
+		return;
+		
+	if (mDepth == 32) {
+		uint32* dst = reinterpret_cast<uint32*>(this->GetUnsafeBufferAt(h, v));
+		this->ColorsToPixels(rgb, dst, count);			// pixels are already in the right format so we can skip the copy
+	
+	} else {
+		uint32 pixels[kSpanChunk];
+		
+		while (count > 0) {
+			uint32 n = Min(count, kSpanChunk);
+			
+			this->ColorsToPixels(rgb, pixels, n);
+			this->SetPixelsAt(h, v, pixels, n);
+			
+			h     += (int32) n;
+			rgb   += 3*n;
+			count -= n;
+		}
+	}
+}
+
+
 //---------------------------------------------------------------
 //
 // XBaseImage::Erase
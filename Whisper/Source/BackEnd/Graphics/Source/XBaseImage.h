@@ -116,6 +116,29 @@ public:
 			void 		SetPixelAt(int32 h, int32 v, uint32 value);
 	//@}
 
+	//! @name Spans
+	//@{
+			uint8* 		GetRowBuffer(int32 v);
+			const uint8* GetRowBuffer(int32 v) const;
+						/**< Returns a pointer to the start of row v. The image must be locked.
+						Fetching this once per row is a lot cheaper than calling GetBufferAt
+						or SetPixelAt for every pixel. */
+
+			void 		ColorsToPixels(const XRGBColor* colors, uint32* pixels, uint32 count) const;
+			void 		ColorsToPixels(const float* rgb, uint32* pixels, uint32 count) const;
+						/**< Returns the same pixel values as ColorToPixel(colors[i].GetOSColor())
+						but four colors are converted at a time when SSE2 is available. rgb
+						points to count red, green, blue triples in [0, 1]. Depth must be 16,
+						24, or 32. */
+
+			void 		SetPixelsAt(int32 h, int32 v, const uint32* pixels, uint32 count);
+						/**< Writes count pixel values into row v starting at h. */
+
+			void 		SetColorsAt(int32 h, int32 v, const XRGBColor* colors, uint32 count);
+			void 		SetColorsAt(int32 h, int32 v, const float* rgb, uint32 count);
+						/**< Converts count colors and writes them into row v starting at h. */
+	//@}
+
 	//! @name Color Channels
 	//@{
 	virtual	uint32		GetAlphaMask() const = 0;
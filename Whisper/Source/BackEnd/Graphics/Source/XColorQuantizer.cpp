@@ -0,0 +1,682 @@
+/*
+ *  File:       XColorQuantizer.cpp
+ *  Summary:   	Picks a palette for a direct color image and maps images onto a palette.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XColorQuantizer.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XColorQuantizer.h>
+
+#include <algorithm>
+#include <climits>
+
+#include <XBaseImage.h>
+#include <XMemUtils.h>
+#include <XNumbers.h>
+
+namespace Whisper {
+
+
+//-----------------------------------
+//	Internal Constants
+//
+const int32 kCells[3] = {32, 64, 32};		// the histogram and inverse colormap use 5 bits of red, 6 of green, and 5 of blue
+const int32 kShift[3] = {3, 2, 3};			// 8 - bits
+const int32 kScale[3] = {2, 3, 1};			// weights used when comparing box sizes (the eye is most sensitive to green and least to blue)
+
+const uint32 kNumCells = 32*64*32L;
+
+const uint16 kUnknownIndex = 0xFFFF;
+
+const int32 kRangeOffset = 256;				// dithered components can range from -255 to 510
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// GetCell
+//
+// Takes cell coordinates.
+//
+//---------------------------------------------------------------
+inline uint32 GetCell(int32 red, int32 green, int32 blue)
+{
+	return ((uint32) red << 11) | ((uint32) green << 5) | (uint32) blue;
+}
+
+
+//---------------------------------------------------------------
+//
+// GetColorCell
+//
+// Takes 8-bit components.
+//
+//---------------------------------------------------------------
+inline uint32 GetColorCell(int32 red, int32 green, int32 blue)
+{
+	return ((uint32) (red >> 3) << 11) | ((uint32) (green >> 2) << 5) | (uint32) (blue >> 3);
+}
+
+
+//---------------------------------------------------------------
+//
+// GetRangeTable
+//
+// Used to clamp dithered components to [0, 255] without branching.
+//
+//---------------------------------------------------------------
+static const uint8* GetRangeTable()
+{
+	static uint8 table[3*256];
+	static bool inited = false;
+
+	if (!inited) {
+		for (int32 i = 0; i < 3*256; ++i)
+			table[i] = (uint8) MinMax(0L, i - kRangeOffset, 255L);
+		inited = true;
+	}
+
+	return table + kRangeOffset;
+}
+
+
+//---------------------------------------------------------------
+//
+// DecodeRow
+//
+// Converts a row of 16, 24, or 32-bit pixels into red, green, blue
+// triples.
+//
+//---------------------------------------------------------------
+static void DecodeRow(const XBaseImage& image, int32 v, uint8* rgb)
+{
+	int32 width = image.GetWidth();
+	int32 depth = image.GetDepth();
+	const uint8* src = image.GetBufferAt(0, v);
+
+	if (depth == 24) {
+#if WIN
+		for (int32 h = 0; h < width; ++h) {					// Windows uses blue, green, red ordering
+			*rgb++ = src[2];
+			*rgb++ = src[1];
+			*rgb++ = src[0];
+			src += 3;
+		}
+#else
+		BlockMoveData(src, rgb, 3*(uint32) width);			// red, green, blue bytes (QuickDraw doesn't have 24-bit GWorlds so this is only used for raw buffers)
+#endif
+
+	} else if (depth == 16) {
+		const uint16* pixels = reinterpret_cast<const uint16*>(src);
+
+		for (int32 h = 0; h < width; ++h) {
+			uint32 pixel = pixels[h];
+			uint32 red   = (pixel >> 10) & 0x1F;
+			uint32 green = (pixel >> 5) & 0x1F;
+			uint32 blue  = pixel & 0x1F;
+
+			*rgb++ = (uint8) ((red << 3) | (red >> 2));
+			*rgb++ = (uint8) ((green << 3) | (green >> 2));
+			*rgb++ = (uint8) ((blue << 3) | (blue >> 2));
+		}
+
+	} else {
+		const uint32* pixels = reinterpret_cast<const uint32*>(src);
+
+		for (int32 h = 0; h < width; ++h) {
+			uint32 pixel = pixels[h];
+			*rgb++ = (uint8) (pixel >> 16);
+			*rgb++ = (uint8) (pixel >> 8);
+			*rgb++ = (uint8) pixel;
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// PackRow
+//
+//---------------------------------------------------------------
+static void PackRow(const uint8* indices, uint8* dst, int32 width, int32 depth)
+{
+	if (depth == 8) {
+		BlockMoveData(indices, dst, (uint32) width);
+
+	} else {
+		int32 shift = 8 - depth;						// pixels are packed most significant bits first
+		uint8 byte = 0;
+
+		for (int32 h = 0; h < width; ++h) {
+			byte |= (uint8) (indices[h] << shift);
+			shift -= depth;
+
+			if (shift < 0) {
+				*dst++ = byte;
+				byte = 0;
+				shift = 8 - depth;
+			}
+		}
+
+		if (shift != 8 - depth)
+			*dst = byte;
+	}
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class XColorQuantizer
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::~XColorQuantizer
+//
+//---------------------------------------------------------------
+XColorQuantizer::~XColorQuantizer()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::XColorQuantizer (XBaseImage, uint32)
+//
+//---------------------------------------------------------------
+XColorQuantizer::XColorQuantizer(const XBaseImage& image, uint32 numColors)
+{
+	PRECONDITION(image.GetDepth() == 16 || image.GetDepth() == 24 || image.GetDepth() == 32);
+	PRECONDITION(numColors >= 2 && numColors <= 256);
+
+	XLocker lock(image);
+
+	std::vector<uint32> histogram, offsets;
+	this->DoBuildHistogram(image, histogram, offsets);
+
+	std::vector<SBox> boxes;
+	boxes.reserve(numColors);
+	this->DoMedianCut(histogram, boxes, numColors);
+
+	this->DoAverageBoxes(histogram, offsets, boxes);
+	this->DoInitColors(numColors);
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::XColorQuantizer (XColorTable)
+//
+//---------------------------------------------------------------
+XColorQuantizer::XColorQuantizer(const XColorTable& colors) : mColors(colors)
+{
+	PRECONDITION(colors.GetSize() >= 1 && colors.GetSize() <= 256);
+
+	mNumColors = colors.GetSize();
+	mPalette.resize(3*mNumColors);
+
+	for (uint32 i = 0; i < mNumColors; ++i) {
+		XRGBColor color = colors.GetColor(i);
+
+		mPalette[3*i + 0] = (uint8) (255.0*color.red + 0.5);
+		mPalette[3*i + 1] = (uint8) (255.0*color.green + 0.5);
+		mPalette[3*i + 2] = (uint8) (255.0*color.blue + 0.5);
+	}
+
+	mInverse.assign(kNumCells, kUnknownIndex);
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::GetIndex
+//
+//---------------------------------------------------------------
+uint32 XColorQuantizer::GetIndex(const XRGBColor& color) const
+{
+	int32 red   = (int32) (255.0*MinMax(0.0, (double) color.red, 1.0) + 0.5);
+	int32 green = (int32) (255.0*MinMax(0.0, (double) color.green, 1.0) + 0.5);
+	int32 blue  = (int32) (255.0*MinMax(0.0, (double) color.blue, 1.0) + 0.5);
+
+	return this->DoGetIndex(red, green, blue);
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::Quantize
+//
+//---------------------------------------------------------------
+void XColorQuantizer::Quantize(const XBaseImage& src, XBaseImage& dst, bool dither) const
+{
+	PRECONDITION(src.GetDepth() == 16 || src.GetDepth() == 24 || src.GetDepth() == 32);
+	PRECONDITION(dst.GetDepth() <= 8);
+	PRECONDITION(src.GetWidth() == dst.GetWidth());
+	PRECONDITION(src.GetHeight() == dst.GetHeight());
+	PRECONDITION(mNumColors <= (1UL << dst.GetDepth()));
+
+	XLocker srcLock(src);
+	XLocker dstLock(dst);
+
+	int32 width = src.GetWidth();
+	std::vector<uint8> rgb(3*(uint32) width);
+	std::vector<uint8> indices((uint32) width);
+
+	std::vector<int32> errors;							// error terms for the next row (with a pad pixel at each end)
+	if (dither)
+		errors.resize(3*(uint32) (width + 2));
+
+	for (int32 v = 0; v < src.GetHeight(); ++v) {
+		DecodeRow(src, v, &rgb[0]);
+
+		if (dither) {
+			this->DoDitherRow(&rgb[0], &indices[0], width, (v & 1) != 0, &errors[0]);
+
+		} else
+			this->DoMapRow(&rgb[0], &indices[0], width);
+
+		PackRow(&indices[0], dst.GetBufferAt(0, v), width, dst.GetDepth());
+	}
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::DoBuildHistogram
+//
+// Along with the pixel counts we sum the offsets of the pixels from
+// the corner of their cell so that the palette can be built without
+// making another pass over the image. (The offsets are at most 7 so
+// the sums won't overflow unless a cell has more than 600 million
+// pixels).
+//
+//---------------------------------------------------------------
+void XColorQuantizer::DoBuildHistogram(const XBaseImage& image, std::vector<uint32>& histogram, std::vector<uint32>& offsets) const
+{
+	histogram.assign(kNumCells, 0);
+	offsets.assign(3*kNumCells, 0);
+
+	int32 width = image.GetWidth();
+	std::vector<uint8> rgb(3*(uint32) width);
+
+	for (int32 v = 0; v < image.GetHeight(); ++v) {
+		DecodeRow(image, v, &rgb[0]);
+
+		const uint8* pixel = &rgb[0];
+		for (int32 h = 0; h < width; ++h, pixel += 3) {
+			uint32 cell = GetColorCell(pixel[0], pixel[1], pixel[2]);
+			++histogram[cell];
+
+			uint32* offset = &offsets[3*cell];
+			offset[0] += pixel[0] & 0x07;
+			offset[1] += pixel[1] & 0x03;
+			offset[2] += pixel[2] & 0x07;
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::DoMedianCut
+//
+// Until half the colors have been allocated we split the box with
+// the most pixels. After that we split the largest box so that
+// small clusters of colors that are far from everything else get
+// their own entries.
+//
+//---------------------------------------------------------------
+void XColorQuantizer::DoMedianCut(std::vector<uint32>& histogram, std::vector<SBox>& boxes, uint32 numColors) const
+{
+	SBox box;
+	for (uint32 axis = 0; axis < 3; ++axis) {
+		box.min[axis] = 0;
+		box.max[axis] = kCells[axis] - 1;
+	}
+	this->DoShrinkBox(histogram, box);
+	boxes.push_back(box);
+
+	while (boxes.size() < numColors) {
+		bool byPixels = 2*boxes.size() <= numColors;
+
+		int32 best = -1;
+		uint32 bestPixels = 0;
+		int32 bestVolume = 0;
+		for (uint32 i = 0; i < boxes.size(); ++i) {
+			const SBox& candidate = boxes[i];
+
+			if (candidate.volume > 0) {						// boxes with one cell can't be split
+				if (byPixels && candidate.pixels > bestPixels) {
+					best = (int32) i;
+					bestPixels = candidate.pixels;
+
+				} else if (!byPixels && candidate.volume > bestVolume) {
+					best = (int32) i;
+					bestVolume = candidate.volume;
+				}
+			}
+		}
+
+		if (best < 0)
+			break;											// fewer colors than numColors
+
+		SBox other;
+		this->DoSplitBox(histogram, boxes[(uint32) best], other);
+		boxes.push_back(other);
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::DoShrinkBox
+//
+// Shrinks the box so that it tightly encloses the non-empty cells
+// and updates the pixel count and volume.
+//
+//---------------------------------------------------------------
+void XColorQuantizer::DoShrinkBox(const std::vector<uint32>& histogram, SBox& box) const
+{
+	int32 newMin[3] = {kCells[0], kCells[1], kCells[2]};
+	int32 newMax[3] = {-1, -1, -1};
+	uint32 pixels = 0;
+
+	for (int32 r = box.min[0]; r <= box.max[0]; ++r) {
+		for (int32 g = box.min[1]; g <= box.max[1]; ++g) {
+			const uint32* cells = &histogram[GetCell(r, g, 0)];
+
+			for (int32 b = box.min[2]; b <= box.max[2]; ++b) {
+				if (cells[b] != 0) {
+					pixels += cells[b];
+
+					newMin[0] = Min(newMin[0], r);
+					newMax[0] = Max(newMax[0], r);
+					newMin[1] = Min(newMin[1], g);
+					newMax[1] = Max(newMax[1], g);
+					newMin[2] = Min(newMin[2], b);
+					newMax[2] = Max(newMax[2], b);
+				}
+			}
+		}
+	}
+
+	box.pixels = pixels;
+	box.volume = 0;
+
+	if (pixels > 0) {
+		for (uint32 axis = 0; axis < 3; ++axis) {
+			box.min[axis] = newMin[axis];
+			box.max[axis] = newMax[axis];
+
+			int32 extent = ((box.max[axis] - box.min[axis]) << kShift[axis])*kScale[axis];
+			box.volume += extent*extent;
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::DoSplitBox
+//
+// Splits box along its longest (scaled) axis at the median pixel.
+// Because shrunk boxes have pixels on their faces both halves are
+// non-empty.
+//
+//---------------------------------------------------------------
+void XColorQuantizer::DoSplitBox(const std::vector<uint32>& histogram, SBox& box, SBox& other) const
+{
+	PRECONDITION(box.volume > 0);
+
+	uint32 axis = 0;
+	int32 longest = -1;
+	for (uint32 i = 0; i < 3; ++i) {
+		int32 extent = ((box.max[i] - box.min[i]) << kShift[i])*kScale[i];
+		if (extent > longest) {
+			axis = i;
+			longest = extent;
+		}
+	}
+
+	// Count the pixels in each plane perpendicular to the axis.
+	std::vector<uint32> planes((uint32) (box.max[axis] - box.min[axis] + 1));
+
+	int32 index[3];
+	for (index[0] = box.min[0]; index[0] <= box.max[0]; ++index[0]) {
+		for (index[1] = box.min[1]; index[1] <= box.max[1]; ++index[1]) {
+			const uint32* cells = &histogram[GetCell(index[0], index[1], 0)];
+
+			for (index[2] = box.min[2]; index[2] <= box.max[2]; ++index[2])
+				planes[(uint32) (index[axis] - box.min[axis])] += cells[index[2]];
+		}
+	}
+
+	// Find the median.
+	uint32 count = 0;
+	int32 split = box.min[axis];
+	for (uint32 i = 0; i < planes.size(); ++i) {
+		count += planes[i];
+		if (2*count >= box.pixels) {
+			split = box.min[axis] + (int32) i;
+			break;
+		}
+	}
+	split = Min(split, box.max[axis] - 1);
+
+	other = box;
+	box.max[axis]   = split;
+	other.min[axis] = split + 1;
+
+	this->DoShrinkBox(histogram, box);
+	this->DoShrinkBox(histogram, other);
+
+	POSTCONDITION(box.pixels > 0 && other.pixels > 0);
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::DoAverageBoxes
+//
+// Sets the palette to the average of the pixels within each box.
+// Because we use the actual pixel values (instead of the centers
+// of the cells) images with just a few colors are reproduced exactly.
+//
+//---------------------------------------------------------------
+void XColorQuantizer::DoAverageBoxes(const std::vector<uint32>& histogram, const std::vector<uint32>& offsets, const std::vector<SBox>& boxes)
+{
+	mNumColors = (uint32) boxes.size();
+	mPalette.resize(3*mNumColors);
+
+	for (uint32 i = 0; i < mNumColors; ++i) {
+		const SBox& box = boxes[i];
+		double sum[3] = {0.0, 0.0, 0.0};
+
+		for (int32 r = box.min[0]; r <= box.max[0]; ++r) {
+			for (int32 g = box.min[1]; g <= box.max[1]; ++g) {
+				for (int32 b = box.min[2]; b <= box.max[2]; ++b) {
+					uint32 cell = GetCell(r, g, b);
+					double count = histogram[cell];
+
+					if (count > 0.0) {
+						const uint32* offset = &offsets[3*cell];
+						sum[0] += count*(r << kShift[0]) + offset[0];
+						sum[1] += count*(g << kShift[1]) + offset[1];
+						sum[2] += count*(b << kShift[2]) + offset[2];
+					}
+				}
+			}
+		}
+
+		ASSERT(box.pixels > 0);
+		for (uint32 c = 0; c < 3; ++c)
+			mPalette[3*i + c] = (uint8) (sum[c]/box.pixels + 0.5);
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::DoInitColors
+//
+//---------------------------------------------------------------
+void XColorQuantizer::DoInitColors(uint32 numColors)
+{
+	PRECONDITION(mNumColors <= numColors);
+
+	mColors.SetSize(numColors);
+
+	for (uint32 i = 0; i < numColors; ++i) {
+		if (i < mNumColors)
+			mColors.SetColor(i, XRGBColor(mPalette[3*i]/255.0, mPalette[3*i + 1]/255.0, mPalette[3*i + 2]/255.0));
+		else
+			mColors.SetColor(i, kRGBBlack);
+	}
+
+	mInverse.assign(kNumCells, kUnknownIndex);
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::DoGetIndex
+//
+//---------------------------------------------------------------
+uint8 XColorQuantizer::DoGetIndex(int32 red, int32 green, int32 blue) const
+{
+	PRECONDITION(red >= 0 && red <= 255);
+	PRECONDITION(green >= 0 && green <= 255);
+	PRECONDITION(blue >= 0 && blue <= 255);
+
+	uint32 cell = GetColorCell(red, green, blue);
+
+	uint16 index = mInverse[cell];
+	if (index == kUnknownIndex) {
+		index = this->DoFindNearest(cell);
+		mInverse[cell] = index;
+	}
+
+	return (uint8) index;
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::DoFindNearest
+//
+// Returns the palette entry closest to the center of the cell.
+//
+//---------------------------------------------------------------
+uint8 XColorQuantizer::DoFindNearest(uint32 cell) const
+{
+	int32 red   = (int32) ((cell >> 11) << kShift[0]) + (1 << (kShift[0] - 1));
+	int32 green = (int32) (((cell >> 5) & 0x3F) << kShift[1]) + (1 << (kShift[1] - 1));
+	int32 blue  = (int32) ((cell & 0x1F) << kShift[2]) + (1 << (kShift[2] - 1));
+
+	uint32 best = 0;
+	int32 bestDistance = LONG_MAX;
+
+	const uint8* color = &mPalette[0];
+	for (uint32 i = 0; i < mNumColors; ++i, color += 3) {
+		int32 dr = red - color[0];
+		int32 dg = green - color[1];
+		int32 db = blue - color[2];
+
+		int32 distance = dr*dr + dg*dg + db*db;
+		if (distance < bestDistance) {
+			best = i;
+			bestDistance = distance;
+		}
+	}
+
+	return (uint8) best;
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::DoMapRow
+//
+//---------------------------------------------------------------
+void XColorQuantizer::DoMapRow(const uint8* rgb, uint8* indices, int32 width) const
+{
+	for (int32 h = 0; h < width; ++h, rgb += 3)
+		indices[h] = this->DoGetIndex(rgb[0], rgb[1], rgb[2]);
+}
+
+
+//---------------------------------------------------------------
+//
+// XColorQuantizer::DoDitherRow
+//
+// Floyd-Steinberg error diffusion. Each pixel's error is pushed
+// 7/16 to the next pixel, 3/16 below and behind, 5/16 below, and
+// 1/16 below and ahead. Rows alternate direction to avoid the
+// diagonal artifacts a raster scan produces.
+//
+// Like libjpeg we only keep one row of error terms (in sixteenths):
+// the entries behind the current pixel are for the next row and the
+// entries ahead are from the previous row. The errors going to the
+// right of the current pixel and below it are carried in locals so
+// each entry is only written once. The error array has a pad pixel
+// at each end so the edges don't need special cases.
+//
+//---------------------------------------------------------------
+void XColorQuantizer::DoDitherRow(const uint8* rgb, uint8* indices, int32 width, bool reverse, int32* errors) const
+{
+	const uint8* range = GetRangeTable();
+
+	int32 step = reverse ? -1 : 1;
+	int32 h = reverse ? width - 1 : 0;
+
+	int32* error = errors + 3*(h + 1);
+	int32 offset = 3*step;
+
+	int32 current[3]  = {0, 0, 0};						// error carried to the next pixel
+	int32 below[3]    = {0, 0, 0};						// error accumulated for the pixel below this one
+	int32 behind[3]   = {0, 0, 0};						// error accumulated for the pixel below the previous one
+
+	for (int32 i = 0; i < width; ++i, h += step, error += offset) {
+		const uint8* pixel = rgb + 3*h;
+
+		int32 value[3];
+		for (int32 c = 0; c < 3; ++c) {
+			int32 total = (current[c] + error[c] + 8) >> 4;	// error[c] is from the previous row
+			value[c] = range[pixel[c] + total];
+		}
+
+		uint8 index = this->DoGetIndex(value[0], value[1], value[2]);
+		indices[h] = index;
+
+		const uint8* color = &mPalette[3*index];
+		for (int32 c = 0; c < 3; ++c) {
+			int32 err = value[c] - color[c];
+
+			error[c - offset] = behind[c] + 3*err;			// the pixel below and behind is done
+			behind[c]  = below[c] + 5*err;
+			below[c]   = err;
+			current[c] = 7*err;
+		}
+	}
+
+	for (int32 c = 0; c < 3; ++c)
+		error[c - offset] = behind[c];
+}
+
+
+}	// namespace Whisper
@@ -0,0 +1,139 @@
+/*
+ *  File:       XColorQuantizer.h
+ *  Summary:   	Picks a palette for a direct color image and maps images onto a palette.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XColorQuantizer.h,v $
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <XColorTable.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+//-----------------------------------
+//	Forward References
+//
+class XBaseImage;
+
+
+// ===================================================================================
+//	class XColorQuantizer
+//!		Picks a palette for a direct color image and maps images onto a palette.
+/*!		The palette is built using Heckbert's median cut algorithm: colors are binned
+ *		into a 5-6-5 bit histogram and the box with the most pixels (or the largest
+ *		volume once half the colors have been allocated) is split at its median until
+ *		there are enough boxes. Each palette entry is the average of the pixels that
+ *		fell into its box.
+ *
+ *		Mapping uses an inverse colormap: a 5-6-5 grid of palette indices that's filled
+ *		in lazily the first time a cell is hit so the nearest color search is only done
+ *		once per cell instead of once per pixel. Floyd-Steinberg dithering is done a row
+ *		at a time (with a serpentine scan) so only one row of error terms is needed.
+ *
+ *		Note that because the inverse colormap is filled in lazily quantizers shouldn't
+ *		be shared between threads. */
+// ===================================================================================
+class GRAPHICS_EXPORT XColorQuantizer {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+						~XColorQuantizer();
+
+						XColorQuantizer(const XBaseImage& image, uint32 numColors = 256);
+						/**< Image should be 16, 24, or 32 bits deep. numColors may
+						be 2 to 256. */
+
+	explicit			XColorQuantizer(const XColorTable& colors);
+						/**< Maps images onto an existing palette. */
+
+private:
+						XColorQuantizer(const XColorQuantizer& rhs);
+
+			XColorQuantizer& operator=(const XColorQuantizer& rhs);
+
+//-----------------------------------
+//	API
+//
+public:
+	//! @name Palette
+	//@{
+			const XColorTable& GetColors() const						{return mColors;}
+						/**< Has numColors entries. */
+
+			uint32 		GetNumColors() const							{return mNumColors;}
+						/**< Number of colors actually used. This will be smaller than
+						GetColors().GetSize() if the image didn't have enough colors
+						(the extra entries are black). */
+	//@}
+
+	//! @name Mapping
+	//@{
+			uint32 		GetIndex(const XRGBColor& color) const;
+						/**< Returns the index of the palette entry closest to color. */
+
+			void 		Quantize(const XBaseImage& src, XBaseImage& dst, bool dither = true) const;
+						/**< Src should be 16, 24, or 32 bits deep. Dst should be the
+						same size as src with a depth of 8 or less. The dst color table
+						isn't changed: normally it's set to GetColors(). */
+	//@}
+
+//-----------------------------------
+//	Internal Types
+//
+protected:
+	struct SBox {
+		int32	min[3];						// inclusive cell bounds
+		int32	max[3];
+		uint32	pixels;						// number of pixels within the box
+		int32	volume;						// scaled squared diagonal
+	};
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		DoBuildHistogram(const XBaseImage& image, std::vector<uint32>& histogram, std::vector<uint32>& offsets) const;
+			void 		DoMedianCut(std::vector<uint32>& histogram, std::vector<SBox>& boxes, uint32 numColors) const;
+			void 		DoShrinkBox(const std::vector<uint32>& histogram, SBox& box) const;
+			void 		DoSplitBox(const std::vector<uint32>& histogram, SBox& box, SBox& other) const;
+			void 		DoAverageBoxes(const std::vector<uint32>& histogram, const std::vector<uint32>& offsets, const std::vector<SBox>& boxes);
+			void 		DoInitColors(uint32 numColors);
+
+			uint8 		DoGetIndex(int32 red, int32 green, int32 blue) const;
+			uint8 		DoFindNearest(uint32 cell) const;
+
+			void 		DoMapRow(const uint8* rgb, uint8* indices, int32 width) const;
+			void 		DoDitherRow(const uint8* rgb, uint8* indices, int32 width, bool reverse, int32* errors) const;
+
+//-----------------------------------
+//	Member Data
+//
+protected:
+	XColorTable				mColors;
+	uint32					mNumColors;
+	std::vector<uint8>		mPalette;		// red, green, blue triples
+	mutable std::vector<uint16>	mInverse;	// palette index for each 5-6-5 cell (or kUnknownIndex)
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
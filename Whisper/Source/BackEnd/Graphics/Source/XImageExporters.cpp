@@ -37,18 +37,57 @@
 #include <XWhisperHeader.h>
 #include <XImageExporters.h>
 
+#include <algorithm>
+#include <climits>
+
 #include <png.h>
+#include <XBind.h>
 #include <XColorTable.h>
 #include <XExceptions.h>
 #include <XBaseImage.h>
 #include <XFileSpec.h>
+#include <XIOU.h>
+#include <XMemUtils.h>
 #include <XNumbers.h>
 #include <XStringUtils.h>
+#include <XSystemInfo.h>
+#include <XThread.h>
 #include <XTinyVector.h>
 
 namespace Whisper {
 
 
+// ===================================================================================
+//	Constants
+// ===================================================================================
+const uint32 kMinStripBytes = 64*1024L;		// smaller strips compress noticeably worse
+const uint32 kMaxStripBytes = 1024*1024L;
+
+const uint32 kHaveIDAT = 0x04;				// PNG_HAVE_IDAT (png.h only defines this when building libpng)
+
+static png_byte kIDAT[5] = {73, 68, 65, 84, '\0'};
+
+
+// ===================================================================================
+//	struct XPNGExporter::SStrip
+// ===================================================================================
+struct XPNGExporter::SStrip {
+	std::vector<uint8>	rows;				// packed rows (without filter bytes)
+	std::vector<uint8>	prior;				// row above the first row (empty for the first strip)
+	uint32				rowBytes;
+	uint32				pixelBytes;			// bytes per pixel rounded up (used by the filters)
+	uint32				filters;			// PNG_FILTER_NONE, PNG_FILTER_SUB, etc
+	int					level;				// zlib compression level
+	bool				first;				// if true the zlib header is written out
+	bool				last;				// if true the deflate stream is finished
+	
+	std::vector<uint8>	output;				// compressed rows
+	uint32				adler;				// adler32 of the filtered rows
+	uint32				length;				// number of filtered bytes
+	XIOU<uint32>		done;
+};
+
+
 // ===================================================================================
 //	Internal Functions
 // ===================================================================================
@@ -110,6 +149,173 @@ static void PngWarning(png_structp info, png_const_charp message)
 }
 
 
+//---------------------------------------------------------------
+//
+// GetLevel
+//
+//---------------------------------------------------------------
+static int GetLevel(XPNGExporter::ECompression compression)
+{
+	int level = Z_DEFAULT_COMPRESSION;
+	
+	if (compression == XPNGExporter::kFastCompression)
+		level = Z_BEST_SPEED;
+	else if (compression == XPNGExporter::kSmallCompression)
+		level = Z_BEST_COMPRESSION;
+		
+	return level;
+}
+
+
+//---------------------------------------------------------------
+//
+// GetFilters
+//
+// Palette images compress best without filtering. For RGB images 
+// the sub filter is cheap and catches most of the redundancy in
+// smooth images. The other presets use the same adaptive filtering
+// that libpng defaults to.
+//
+//---------------------------------------------------------------
+static uint32 GetFilters(XPNGExporter::ECompression compression, int32 depth)
+{
+	uint32 filters = PNG_ALL_FILTERS;
+	
+	if (depth <= 8)
+		filters = PNG_FILTER_NONE;
+	else if (compression == XPNGExporter::kFastCompression)
+		filters = PNG_FILTER_SUB;
+		
+	return filters;
+}
+
+
+//---------------------------------------------------------------
+//
+// Paeth
+//
+//---------------------------------------------------------------
+inline uint8 Paeth(int32 a, int32 b, int32 c)
+{
+	int32 p = b - c;
+	int32 q = a - c;
+	
+	int32 pa = p >= 0 ? p : -p;
+	int32 pb = q >= 0 ? q : -q;
+	int32 pc = p + q >= 0 ? p + q : -(p + q);
+	
+	if (pa <= pb && pa <= pc)
+		return (uint8) a;
+	else if (pb <= pc)
+		return (uint8) b;
+	else
+		return (uint8) c;
+}
+
+
+//---------------------------------------------------------------
+//
+// FilterRow
+//
+// Writes the filter type followed by the filtered row into dst.
+//
+//---------------------------------------------------------------
+static void FilterRow(uint8 type, const uint8* row, const uint8* prior, uint32 bytes, uint32 bpp, uint8* dst)
+{
+	*dst++ = type;
+	
+	uint32 i = 0;
+	switch (type) {
+		case PNG_FILTER_VALUE_NONE:
+			BlockMoveData(row, dst, bytes);
+			break;
+			
+		case PNG_FILTER_VALUE_SUB:
+			for (; i < bpp; ++i)
+				dst[i] = row[i];
+			for (; i < bytes; ++i)
+				dst[i] = (uint8) (row[i] - row[i - bpp]);
+			break;
+			
+		case PNG_FILTER_VALUE_UP:
+			for (; i < bytes; ++i)
+				dst[i] = (uint8) (row[i] - prior[i]);
+			break;
+			
+		case PNG_FILTER_VALUE_AVG:
+			for (; i < bpp; ++i)
+				dst[i] = (uint8) (row[i] - (prior[i] >> 1));
+			for (; i < bytes; ++i)
+				dst[i] = (uint8) (row[i] - ((row[i - bpp] + prior[i]) >> 1));
+			break;
+			
+		case PNG_FILTER_VALUE_PAETH:
+			for (; i < bpp; ++i)
+				dst[i] = (uint8) (row[i] - prior[i]);
+			for (; i < bytes; ++i)
+				dst[i] = (uint8) (row[i] - Paeth(row[i - bpp], prior[i], prior[i - bpp]));
+			break;
+			
+		default:
+			DEBUGSTR("Bad filter type in FilterRow");
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// GetFilterCost
+//
+// This is the heuristic libpng uses to pick a filter: the sum of
+// the filtered bytes treated as signed values.
+//
+//---------------------------------------------------------------
+static uint32 GetFilterCost(const uint8* filtered, uint32 bytes)
+{
+	uint32 cost = 0;
+	
+	for (uint32 i = 0; i < bytes; ++i) {
+		uint32 value = filtered[i];
+		cost += value < 128 ? value : 256 - value;
+	}
+	
+	return cost;
+}
+
+
+//---------------------------------------------------------------
+//
+// AdlerCombine
+//
+// Returns the adler32 checksum of the concatenation of two buffers
+// given the checksums of the buffers and the length of the second
+// buffer. (zlib 1.1.3 doesn't have adler32_combine).
+//
+//---------------------------------------------------------------
+static uint32 AdlerCombine(uint32 adler1, uint32 adler2, uint32 length2)
+{
+	const uint32 kBase = 65521;				// largest prime smaller than 65536
+	
+	uint32 rem  = length2 % kBase;
+	uint32 sum1 = adler1 & 0xFFFF;
+	uint32 sum2 = (rem*sum1) % kBase;
+	
+	sum1 += (adler2 & 0xFFFF) + kBase - 1;
+	sum2 += (adler1 >> 16) + (adler2 >> 16) + kBase - rem;
+	
+	if (sum1 >= kBase)
+		sum1 -= kBase;
+	if (sum1 >= kBase)
+		sum1 -= kBase;
+	if (sum2 >= 2*kBase)
+		sum2 -= 2*kBase;
+	if (sum2 >= kBase)
+		sum2 -= kBase;
+		
+	return sum1 | (sum2 << 16);
+}
+
+
 //---------------------------------------------------------------
 //
 // FSp_fopen
@@ -185,6 +391,11 @@ static FILE* FSp_fopen(ConstFSSpecPtr spec, const char* open_mode, OSType creato
 //---------------------------------------------------------------
 XPNGExporter::~XPNGExporter()
 {	
+	this->DoDeleteStrips();
+	
+	if (mFile != nil)
+		std::fclose(mFile);
+
 	png_destroy_write_struct(&mPngPtr, &mInfoPtr);
 }
 
@@ -194,15 +405,28 @@ XPNGExporter::~XPNGExporter()
 // XPNGExporter::XPNGExporter
 //
 //---------------------------------------------------------------
-XPNGExporter::XPNGExporter(double gamma, bool saveAlpha) 
+XPNGExporter::XPNGExporter(double gamma, bool saveAlpha, ECompression compression, uint32 threads) 
 {	
 	PRECONDITION(gamma >= 0.0);
 
 	mPngPtr  = nil;	
 	mInfoPtr = nil;
 	
-	mGamma     = gamma;
-	mSaveAlpha = saveAlpha;
+	mGamma       = gamma;
+	mSaveAlpha   = saveAlpha;
+	mCompression = compression;
+	this->SetThreads(threads);
+	
+	mFile        = nil;
+	mWidth       = 0;
+	mHeight      = 0;
+	mDepth       = 0;
+	mRow         = 0;
+	mPackedBytes = 0;
+	
+	mStripRows = 0;
+	mStrip     = nil;
+	mAdler     = 1;
 	
 	// Allocate the private png struct.
 	mPngPtr = png_create_write_struct_2(PNG_LIBPNG_VER_STRING, 
@@ -228,6 +452,19 @@ XPNGExporter::XPNGExporter(double gamma, bool saveAlpha)
 }
 
 
+//---------------------------------------------------------------
+//
+// XPNGExporter::SetThreads
+//
+//---------------------------------------------------------------
+void XPNGExporter::SetThreads(uint32 threads)
+{
+	PRECONDITION(mFile == nil);
+	
+	mThreads = threads > 0 ? threads : XSystemInfo::GetProcessorCount();
+}
+
+
 //---------------------------------------------------------------
 //
 // XPNGExporter::Export
@@ -236,111 +473,483 @@ XPNGExporter::XPNGExporter(double gamma, bool saveAlpha)
 void XPNGExporter::Export(const XFileSpec& spec, const XBaseImage* image, OSType creator, OSType type)
 {	
 	PRECONDITION(image != nil);
+		
+	int32 depth = image->GetDepth();
+	this->Begin(spec, image->GetWidth(), image->GetHeight(), depth, depth <= 8 ? image->GetColors() : nil, creator, type);
+	
+	XLocker lock(image);
+	
+	int32 rowBytes = (int32) image->GetRowBytes();
+	for (int32 row = 0; row < image->GetHeight(); ++row)
+		this->WriteRows(image->GetBufferAt(0, row), rowBytes, 1);	// rows may be stored bottom up so we go one at a time
+
+	this->End();
+}
+
+
+//---------------------------------------------------------------
+//
+// XPNGExporter::Begin
+//
+//---------------------------------------------------------------
+void XPNGExporter::Begin(const XFileSpec& spec, int32 width, int32 height, int32 depth, const XColorTable* colors, OSType creator, OSType type)
+{
+	PRECONDITION(mFile == nil);
+	PRECONDITION(width > 0);
+	PRECONDITION(height > 0);
+	PRECONDITION(depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16 || depth == 24 || depth == 32);
+	PRECONDITION(depth > 8 || colors != nil);
 	UNUSED(creator);
 	UNUSED(type);
 		
-#if WIN
-	mSaveAlpha = true;		// $$$
-#endif
-
 #if MAC
-	FILE* file = FSp_fopen(&spec.GetOSSpec(), "wb", creator, type);
+	mFile = FSp_fopen(&spec.GetOSSpec(), "wb", creator, type);
 #else
-	FILE* file = std::fopen(ToPlatformStr(spec.GetOSSpec()).c_str(), "wb");
+	mFile = std::fopen(ToPlatformStr(spec.GetOSSpec()).c_str(), "wb");
 #endif
-	if (file == nil)
+	if (mFile == nil)
 		throw std::runtime_error(ToUTF8Str((LoadWhisperString(L"Couldn't open '#1'.", spec.GetName()))));
 		
-	try {
-		int32 depth = image->GetDepth();
-		
-		// Tell the png_struct_def which file we're writing to.
-		png_init_io(mPngPtr, file);
-	
-  		// Initialize the mandatory fields in png_info_struct. 
-  		int colorType = PNG_COLOR_TYPE_PALETTE;
-  		if (depth == 32)
-  			colorType = mSaveAlpha ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB;
-  			
-		png_set_IHDR(mPngPtr, mInfoPtr, 
-					 (uint32) image->GetWidth(), 
-					 (uint32) image->GetHeight(),
-					 depth == 32 ? 8 : depth, 
-					 colorType, 		
-					 PNG_INTERLACE_NONE,
-					 PNG_COMPRESSION_TYPE_DEFAULT, 
-					 PNG_FILTER_TYPE_DEFAULT);
-				
-		png_color palette[256];							// PNG writes this out in png_write_info so we need to define it outside the if block
-		if (depth <= 8) {
-			const XColorTable* colors = image->GetColors();
-			uint32 numColors = colors->GetSize();
+	mWidth  = width;
+	mHeight = height;
+	mDepth  = depth;
+	mRow    = 0;
+	
+	bool alpha = depth == 32 && mSaveAlpha;
+	if (depth <= 8)
+		mPackedBytes = ((uint32) (width*depth) + 7) >> 3;
+	else
+		mPackedBytes = (uint32) width*(alpha ? 4 : 3);
+	mPacked.resize(mPackedBytes);
+		
+	// Tell the png_struct_def which file we're writing to.
+	png_init_io(mPngPtr, mFile);
+
+	// Initialize the mandatory fields in png_info_struct. (We always
+	// write out 8-bit palette entries or channels so DoPackRow is used
+	// to convert the rows).
+	int colorType = PNG_COLOR_TYPE_PALETTE;
+	if (depth > 8)
+		colorType = alpha ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB;
+		
+	png_set_IHDR(mPngPtr, mInfoPtr, 
+				 (uint32) width, 
+				 (uint32) height,
+				 depth <= 8 ? depth : 8, 
+				 colorType, 		
+				 PNG_INTERLACE_NONE,
+				 PNG_COMPRESSION_TYPE_DEFAULT, 
+				 PNG_FILTER_TYPE_DEFAULT);
 			
-			for (uint32 i = 0; i < numColors; ++i) {
-				XRGBColor color = colors->GetColor(i);
-				
-				palette[i].red   = numeric_cast<uint8>(255.0*color.red);
-				palette[i].green = numeric_cast<uint8>(255.0*color.green);
-				palette[i].blue  = numeric_cast<uint8>(255.0*color.blue);
-			}
+	png_color palette[256];							// PNG writes this out in png_write_info so we need to define it outside the if block
+	if (depth <= 8) {
+		uint32 numColors = colors->GetSize();
+		
+		for (uint32 i = 0; i < numColors; ++i) {
+			XRGBColor color = colors->GetColor(i);
 			
-			png_set_PLTE(mPngPtr, mInfoPtr, palette, (int) numColors);
+			palette[i].red   = numeric_cast<uint8>(255.0*color.red);
+			palette[i].green = numeric_cast<uint8>(255.0*color.green);
+			palette[i].blue  = numeric_cast<uint8>(255.0*color.blue);
 		}
+		
+		png_set_PLTE(mPngPtr, mInfoPtr, palette, (int) numColors);
+	}
 
-  		// Initialize some optional fields in png_info_struct. 
-		if (!Equal(mGamma, 0.0)) {
-			if (Equal(mGamma, 0.0)) {
+	// Initialize some optional fields in png_info_struct. 
+	if (!Equal(mGamma, 0.0)) {
+		if (Equal(mGamma, 0.0)) {
 #if WIN
-				const char* str = std::getenv("SCREEN_GAMMA");
-				if (str != nil)
-					mGamma = std::atof(str);
-				else
-					mGamma = 2.2; 
+			const char* str = std::getenv("SCREEN_GAMMA");
+			if (str != nil)
+				mGamma = std::atof(str);
+			else
+				mGamma = 2.2; 
 #elif MAC
-				mGamma = 1.7;							// $$$ presumbably there's a way to get this using ColorSync, but the documentation isn't much help...
+			mGamma = 1.7;							// $$$ presumbably there's a way to get this using ColorSync, but the documentation isn't much help...
 #endif		
+		}
+		png_set_gAMA(mPngPtr, mInfoPtr, mGamma);
+	}
+		
+	png_time time;
+	png_convert_from_time_t(&time, std::time(nil));
+	png_set_tIME(mPngPtr, mInfoPtr, &time);
+	
+	// Set up the compression. If we're using a single thread libpng
+	// does all the work (and uses the same defaults as before for 
+	// kDefaultCompression). Otherwise we'll compress strips ourselves.
+	if (mThreads == 1) {
+		if (mCompression != kDefaultCompression) {
+			png_set_filter(mPngPtr, PNG_FILTER_TYPE_BASE, (int) GetFilters(mCompression, depth));
+			png_set_compression_level(mPngPtr, GetLevel(mCompression));
+		}
+		
+	} else {
+		int32 rows = height/(int32) (4*mThreads);	// enough strips to keep the threads busy if the rows arrive all at once
+		rows = Max(rows, (int32) ((kMinStripBytes + mPackedBytes - 1)/mPackedBytes));
+		rows = Min(rows, (int32) (kMaxStripBytes/mPackedBytes));
+		mStripRows = Max(rows, 1L);
+		mAdler = 1;
+	}
+
+	// Write out the header.
+	png_write_info(mPngPtr, mInfoPtr);	
+}
+
+
+//---------------------------------------------------------------
+//
+// XPNGExporter::WriteRows
+//
+//---------------------------------------------------------------
+void XPNGExporter::WriteRows(const uint8* pixels, int32 rowBytes, int32 count)
+{
+	PRECONDITION(mFile != nil);
+	PRECONDITION(pixels != nil || count == 0);
+	PRECONDITION(count >= 0);
+	PRECONDITION(mRow + count <= mHeight);
+	
+	for (int32 i = 0; i < count; ++i) {
+		const uint8* src = pixels + i*rowBytes;
+		
+		if (mThreads == 1) {
+			this->DoPackRow(src, &mPacked[0]);
+			png_write_row(mPngPtr, &mPacked[0]);
+			++mRow;
+		
+		} else {
+			if (mStrip == nil) {
+				mStrip = new SStrip;
+				mStrip->rows.reserve((uint32) mStripRows*mPackedBytes);
+				if (mRow > 0)
+					mStrip->prior = mPacked;
+				mStrip->rowBytes   = mPackedBytes;
+				mStrip->pixelBytes = mDepth <= 8 ? 1 : (mSaveAlpha && mDepth == 32 ? 4 : 3);
+				mStrip->filters    = GetFilters(mCompression, mDepth);
+				mStrip->level      = GetLevel(mCompression);
+				mStrip->first      = mRow == 0;
+				mStrip->last       = false;
+				mStrip->adler      = 0;
+				mStrip->length     = 0;
 			}
-			png_set_gAMA(mPngPtr, mInfoPtr, mGamma);
+		
+			uint32 offset = (uint32) mStrip->rows.size();
+			mStrip->rows.resize(offset + mPackedBytes);
+			this->DoPackRow(src, &mStrip->rows[offset]);
+			++mRow;
+			
+			if (mStrip->rows.size() == (uint32) mStripRows*mPackedBytes || mRow == mHeight)
+				this->DoQueueStrip();
 		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XPNGExporter::End
+//
+//---------------------------------------------------------------
+void XPNGExporter::End()
+{
+	PRECONDITION(mFile != nil);
+	PRECONDITION(mRow == mHeight);
+	PRECONDITION(mStrip == nil);
+	
+	if (mThreads > 1) {
+		while (!mPending.empty()) {
+			SStrip* strip = mPending.front();
+			this->DoWriteStrip(strip);
 			
-		png_time time;
-		png_convert_from_time_t(&time, std::time(nil));
-   		png_set_tIME(mPngPtr, mInfoPtr, &time);
-   		
-   		// Write out the header.
-    	png_write_info(mPngPtr, mInfoPtr);	
-    	
-		// Tell the PNG library about our pixels
-#if !BIG_ENDIAN
-		if (depth > 8)
-			png_set_swap(mPngPtr);
-#endif
-//		png_set_swap_alpha(mPngPtr);					// Win and Mac have alpha in the high byte
+			mPending.pop_front();
+			delete strip;
+		}
 		
-		if (!mSaveAlpha)
-			png_set_filler(mPngPtr, 0, PNG_FILLER_BEFORE);	// get rid of the alpha byte
+		mPngPtr->mode |= kHaveIDAT;					// we wrote the IDAT chunks so libpng doesn't know about them
+	}
+	
+	png_write_end(mPngPtr, mInfoPtr);
 
-#if WIN
-		png_set_bgr(mPngPtr);							// Windows uses blue, green, red ordering
+	std::FILE* file = mFile;
+	mFile = nil;
+	if (std::fclose(file) != 0)
+		throw std::runtime_error(ToUTF8Str((LoadWhisperString(L"Couldn't write out the PNG file."))));
+}
+
+#if __MWERKS__
+#pragma mark ~
 #endif
 
-		// Write the pixels out
-		XLocker lock(image);
+//---------------------------------------------------------------
+//
+// XPNGExporter::DoPackRow
+//
+// Converts a row of XBaseImage pixels into a PNG row.
+//
+//---------------------------------------------------------------
+void XPNGExporter::DoPackRow(const uint8* src, uint8* dst) const
+{
+	if (mDepth <= 8) {
+		BlockMoveData(src, dst, mPackedBytes);
+	
+	} else if (mDepth == 24) {
+#if WIN
+		for (int32 h = 0; h < mWidth; ++h) {				// Windows uses blue, green, red ordering (we can't use png_set_bgr because the threads compress the rows themselves)
+			*dst++ = src[2];
+			*dst++ = src[1];
+			*dst++ = src[0];
+			src += 3;
+		}
+#else
+		BlockMoveData(src, dst, mPackedBytes);		// red, green, blue bytes (QuickDraw doesn't have 24-bit GWorlds so this is only used for raw buffers)
+#endif
+	
+	} else if (mDepth == 16) {
+		const uint16* pixels = reinterpret_cast<const uint16*>(src);
 		
-		for (int32 row = 0; row < image->GetHeight(); ++row) {
-			const uint8* pixels = image->GetBufferAt(0, row);
-			png_write_row(mPngPtr, const_cast<uint8*>(pixels));
+		for (int32 h = 0; h < mWidth; ++h) {
+			uint32 pixel = pixels[h];
+			uint32 red   = (pixel >> 10) & 0x1F;
+			uint32 green = (pixel >> 5) & 0x1F;
+			uint32 blue  = pixel & 0x1F;
+			
+			*dst++ = (uint8) ((red << 3) | (red >> 2));
+			*dst++ = (uint8) ((green << 3) | (green >> 2));
+			*dst++ = (uint8) ((blue << 3) | (blue >> 2));
 		}
+	
+	} else {
+		const uint32* pixels = reinterpret_cast<const uint32*>(src);
+		
+		if (mSaveAlpha) {
+			for (int32 h = 0; h < mWidth; ++h) {
+				uint32 pixel = pixels[h];						// Win and Mac have alpha in the high byte
+				*dst++ = (uint8) (pixel >> 16);
+				*dst++ = (uint8) (pixel >> 8);
+				*dst++ = (uint8) pixel;
+				*dst++ = (uint8) (pixel >> 24);
+			}
+		
+		} else {
+			for (int32 h = 0; h < mWidth; ++h) {
+				uint32 pixel = pixels[h];
+				*dst++ = (uint8) (pixel >> 16);
+				*dst++ = (uint8) (pixel >> 8);
+				*dst++ = (uint8) pixel;
+			}
+		}
+	}
+}
 
-		// Clean up
-		png_write_end(mPngPtr, mInfoPtr);
 
-		std::fclose(file);
+//---------------------------------------------------------------
+//
+// XPNGExporter::DoQueueStrip
+//
+// Spins off a thread to compress mStrip. If all the threads are
+// busy we'll block until the oldest strip is done and write it out.
+//
+//---------------------------------------------------------------
+void XPNGExporter::DoQueueStrip()
+{
+	PRECONDITION(mStrip != nil);
+	
+	std::copy(mStrip->rows.end() - mPackedBytes, mStrip->rows.end(), mPacked.begin());	// next strip's filters need this
+	mStrip->last = mRow == mHeight;
 
+	while (mPending.size() >= mThreads) {
+		SStrip* strip = mPending.front();
+		this->DoWriteStrip(strip);
+		
+		mPending.pop_front();
+		delete strip;
+	}
+	
+	SStrip* strip = mStrip;
+	mPending.push_back(strip);
+	mStrip = nil;
+	
+	try {
+		XCallback1<void, SStrip*> function(XPNGExporter::DoCompressStrip);
+		XThread::ErrorHandler errors(&strip->done, &XIOU<uint32>::Abort);
+		
+		XThread* thread = XThread::Create(Bind1(function, strip), errors);
+		thread->Start();
+		thread->RemoveReference();
+	
+	} catch (const std::exception& e) {
+		strip->done.Abort(&e);						// so DoDeleteStrips doesn't wait forever
+		throw;
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XPNGExporter::DoWriteStrip
+//
+//---------------------------------------------------------------
+void XPNGExporter::DoWriteStrip(SStrip* strip)
+{
+	PRECONDITION(strip != nil);
+	
+	strip->done.Wait();
+	if (!strip->done.Redeemable())
+		throw std::runtime_error(ToUTF8Str(strip->done.GetAbortText()));
+		
+	mAdler = AdlerCombine(mAdler, strip->adler, strip->length);
+	
+	if (strip->last) {
+		strip->output.push_back((uint8) (mAdler >> 24));	// zlib trailer is the big endian adler32 of all the filtered rows
+		strip->output.push_back((uint8) (mAdler >> 16));
+		strip->output.push_back((uint8) (mAdler >> 8));
+		strip->output.push_back((uint8) mAdler);
+	}
+
+	png_write_chunk(mPngPtr, kIDAT, &strip->output[0], strip->output.size());
+}
+
+
+//---------------------------------------------------------------
+//
+// XPNGExporter::DoDeleteStrips
+//
+//---------------------------------------------------------------
+void XPNGExporter::DoDeleteStrips()
+{
+	while (!mPending.empty()) {
+		SStrip* strip = mPending.front();
+		strip->done.Wait();							// can't delete the strip until its thread is done with it
+		
+		mPending.pop_front();
+		delete strip;
+	}
+	
+	delete mStrip;
+	mStrip = nil;
+}
+
+
+//---------------------------------------------------------------
+//
+// XPNGExporter::DoCompressStrip							[static]
+//
+// Filters the rows and deflates them into a raw deflate stream.
+// Strips other than the last end with a sync flush so they stop 
+// on a byte boundary and don't set the final block bit which 
+// allows the strips to be concatenated.
+//
+//---------------------------------------------------------------
+void XPNGExporter::DoCompressStrip(SStrip* strip)
+{
+	PRECONDITION(strip != nil);
+	PRECONDITION(strip->rowBytes > 0);
+	
+	uint32 bytes = strip->rowBytes;
+	uint32 numRows = (uint32) strip->rows.size()/bytes;
+	
+	// Filter the rows.
+	std::vector<uint8> filtered(numRows*(bytes + 1));
+	
+	std::vector<uint8> scratch(bytes + 1);
+	std::vector<uint8> zeros;
+	const uint8* prior = nil;
+	if (strip->prior.empty()) {
+		zeros.resize(bytes);						// the row above the first row is treated as zeros
+		prior = &zeros[0];
+	} else
+		prior = &strip->prior[0];
+	
+	for (uint32 r = 0; r < numRows; ++r) {
+		const uint8* row = &strip->rows[r*bytes];
+		uint8* dst = &filtered[r*(bytes + 1)];
+		
+		if (strip->filters == PNG_FILTER_NONE) {
+			FilterRow(PNG_FILTER_VALUE_NONE, row, prior, bytes, strip->pixelBytes, dst);
+		
+		} else if (strip->filters == PNG_FILTER_SUB) {
+			FilterRow(PNG_FILTER_VALUE_SUB, row, prior, bytes, strip->pixelBytes, dst);
+		
+		} else {
+			uint32 bestCost = ULONG_MAX;
+			for (uint8 type = PNG_FILTER_VALUE_NONE; type < PNG_FILTER_VALUE_LAST; ++type) {
+				if ((strip->filters & (PNG_FILTER_NONE << type)) != 0) {
+					FilterRow(type, row, prior, bytes, strip->pixelBytes, &scratch[0]);
+					
+					uint32 cost = GetFilterCost(&scratch[1], bytes);
+					if (cost < bestCost) {
+						bestCost = cost;
+						BlockMoveData(&scratch[0], dst, bytes + 1);
+					}
+				}
+			}
+		}
+		
+		prior = row;
+	}
+	
+	strip->length = (uint32) filtered.size();
+	strip->adler = adler32(adler32(0, nil, 0), &filtered[0], strip->length);
+	
+	std::vector<uint8>().swap(strip->rows);			// we're done with the unfiltered rows so free up the memory
+	std::vector<uint8>().swap(strip->prior);
+	
+	// Deflate them.
+	z_stream stream;
+	ClearMemory(&stream, sizeof(stream));
+	
+	int strategy = strip->filters == PNG_FILTER_NONE ? Z_DEFAULT_STRATEGY : Z_FILTERED;	// same as libpng
+	int err = deflateInit2(&stream, strip->level, Z_DEFLATED, -MAX_WBITS, 8, strategy);	// negative window bits suppress the zlib header and trailer
+	if (err != Z_OK)
+		throw std::runtime_error(ToUTF8Str((LoadWhisperString(L"Couldn't write out the PNG file."))));
+		
+	try {
+		std::vector<uint8>& output = strip->output;
+		output.resize(strip->length + strip->length/1000 + 64);
+		
+		uint32 offset = 0;
+		if (strip->first) {
+			int level = strip->level == Z_DEFAULT_COMPRESSION ? 6 : strip->level;
+			uint32 header = (Z_DEFLATED + ((MAX_WBITS - 8) << 4)) << 8;
+			header |= (uint32) Min((level - 1) >> 1, 3) << 6;
+			header += 31 - header % 31;
+			
+			output[offset++] = (uint8) (header >> 8);
+			output[offset++] = (uint8) header;
+		}
+		
+		stream.next_in   = &filtered[0];
+		stream.avail_in  = strip->length;
+		stream.next_out  = &output[offset];
+		stream.avail_out = (uInt) (output.size() - offset);
+		
+		int flush = strip->last ? Z_FINISH : Z_SYNC_FLUSH;
+		while (true) {
+			err = deflate(&stream, flush);
+			if (strip->last && err == Z_STREAM_END)
+				break;
+			else if (!strip->last && err == Z_OK && stream.avail_out > 0)
+				break;
+			else if (err != Z_OK)
+				throw std::runtime_error(ToUTF8Str((LoadWhisperString(L"Couldn't write out the PNG file."))));
+				
+			uint32 used = (uint32) output.size() - stream.avail_out;
+			output.resize(2*output.size());
+			stream.next_out  = &output[used];
+			stream.avail_out = (uInt) output.size() - used;
+		}
+		
+		output.resize(output.size() - stream.avail_out);
+		
 	} catch (...) {
-		std::fclose(file);
+		deflateEnd(&stream);
 		throw;
 	}
+	
+	deflateEnd(&stream);
+	
+	strip->done.Fulfill((uint32) strip->output.size());
 }
 
 
@@ -23,6 +23,10 @@
 
 #pragma once
 
+#include <cstdio>
+#include <deque>
+#include <vector>
+
 #include <XImageExporter.h>
 
 struct png_info_struct;
@@ -35,24 +39,52 @@ namespace Whisper {
 #endif
 
 
+//-----------------------------------
+//	Forward References
+//
+class XColorTable;
+
+
 // ===================================================================================
 //	class XPNGExporter
 //!		Writes out a PNG file.
+/*!		Images can be written all at once using Export or a row at a time using Begin,
+ *		WriteRows, and End. The latter is handy when the image is being generated a band
+ *		at a time (eg by a renderer) and you don't want to wait for the whole thing to
+ *		be finished before compressing it.
+ *
+ *		If more than one thread is used the image is split into horizontal strips which
+ *		are filtered and deflated independently on worker threads. The strips are ended
+ *		with a zlib sync flush so the raw deflate data can be concatenated into a single
+ *		zlib stream and written out as a run of IDAT chunks (the adler32 checksums of
+ *		the strips are combined for the zlib trailer). The resulting file is an ordinary
+ *		PNG, but it's typically a bit larger than one written using a single thread
+ *		because each strip starts with an empty dictionary. */
 // ===================================================================================
 class GRAPHICS_EXPORT XPNGExporter : public XImageExporter {
 
 	typedef XImageExporter Inherited;
 
+//-----------------------------------
+//	Types
+//
+public:
+	enum ECompression {
+		kFastCompression,			//!< sub filter and zlib level 1
+		kDefaultCompression,		//!< libpng's default filters and zlib level 6
+		kSmallCompression			//!< adaptive filters and zlib level 9
+	};
+
 //-----------------------------------
 //	Initialization/Destruction
 //
 public:
 	virtual				~XPNGExporter();
 						
-						XPNGExporter(double gamma = 0.0, bool saveAlphaChannel = false);
+						XPNGExporter(double gamma = 0.0, bool saveAlphaChannel = false, ECompression compression = kDefaultCompression, uint32 threads = 1);
 						/**< Two values for gamma are special cases: 0.0 means use the
 						computer's default gamma correction, 1.0 means do no gamma
-						correction. */
+						correction. If threads is zero one thread per processor is used. */
 
 //-----------------------------------
 //	Inherited API
@@ -60,6 +92,54 @@ public:
 public:
 	virtual void 		Export(const XFileSpec& spec, const XBaseImage* image, OSType creator, OSType type);
 
+//-----------------------------------
+//	New API
+//
+public:
+	//! @name Streaming
+	//@{
+			void 		Begin(const XFileSpec& spec, int32 width, int32 height, int32 depth, const XColorTable* colors, OSType creator, OSType type);
+						/**< Opens the file and writes out the header. Depth may be 1, 2, 4,
+						8, 16, 24, or 32 (colors is only used if depth is 8 or less). */
+						
+			void 		WriteRows(const uint8* pixels, int32 rowBytes, int32 count);
+						/**< Pixels are in the same format as an XBaseImage with the
+						specified depth. The rows are copied so the buffer can be reused
+						as soon as this returns. */
+			
+			void 		End();
+						/**< Call this after all height rows have been written. */
+	//@}
+
+	//! @name Options
+	//@{
+			ECompression GetCompression() const						{return mCompression;}
+			void 		SetCompression(ECompression compression)	{mCompression = compression;}
+						/**< Must be called before Begin. */
+
+			uint32		GetThreads() const							{return mThreads;}
+			void 		SetThreads(uint32 threads);
+						/**< Must be called before Begin. */
+	//@}
+
+//-----------------------------------
+//	Internal Types
+//
+protected:
+	struct SStrip;
+	
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		DoPackRow(const uint8* src, uint8* dst) const;
+			
+			void 		DoQueueStrip();
+			void 		DoWriteStrip(SStrip* strip);
+			void 		DoDeleteStrips();
+			
+	static	void 		DoCompressStrip(SStrip* strip);
+
 //-----------------------------------
 //	Member Data
 //
@@ -69,6 +149,21 @@ protected:
 	
 	double				mGamma;
 	bool 				mSaveAlpha;
+	ECompression		mCompression;
+	uint32				mThreads;
+	
+	std::FILE*			mFile;
+	int32				mWidth;
+	int32				mHeight;
+	int32				mDepth;
+	int32				mRow;				// number of rows passed into WriteRows
+	uint32				mPackedBytes;		// bytes in a PNG row (not counting the filter byte)
+	std::vector<uint8>	mPacked;			// last row passed into WriteRows in PNG format
+	
+	int32				mStripRows;
+	SStrip*				mStrip;				// strip being filled by WriteRows
+	std::deque<SStrip*>	mPending;			// strips being compressed (in file order)
+	uint32				mAdler;				// adler32 of the strips written so far
 };
 
 
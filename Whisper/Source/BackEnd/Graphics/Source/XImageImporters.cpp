@@ -271,7 +271,7 @@ XPNGImporter::XPNGImporter(XResource* data, double gamma) : mBuffer(data)
 				mDepth = bitDepth;
 
 				uint32 numColors = 1UL << bitDepth;
-				XTinyVector<OSColor> colors(numColors);
+				XTinyVector<OSColor, 256> colors(numColors);
 				
 				uint8 value = 0;
 				uint8 delta = numeric_cast<uint8>(255/(numColors - 1));
@@ -308,7 +308,7 @@ XPNGImporter::XPNGImporter(XResource* data, double gamma) : mBuffer(data)
 					
 //					png_set_dither(mPngPtr, palette, (int) numColors, (int) numColors, histogram, 0);
 
-					XTinyVector<OSColor> colors(numColors);
+					XTinyVector<OSColor, 256> colors(numColors);
 					for (uint32 index = 0; index < numColors; ++index) {
 #if MAC
 						colors[index].red   = numeric_cast<uint16>((palette[index].red << 8) + palette[index].red);
@@ -399,7 +399,7 @@ void XPNGImporter::Unpack(XBaseImage* sink, const XPoint& where) const
 		throw std::runtime_error(ToUTF8Str((LoadWhisperString(L"<#1> couldn't be read.", temp2->GetURI().GetAddress()))));
 	}
 
-	XTinyVector<uint8*> rowPointers((uint32) mHeight);
+	XTinyVector<uint8*, 256> rowPointers((uint32) mHeight);	// small images don't need to touch the heap
 	
 	uint8* rowStart = sink->GetBufferAt(where.x, where.y);
 	for (uint32 index = 0; index < (uint32) mHeight; ++index) {
@@ -31,6 +31,10 @@
 #include <XNumbers.h>
 #include <XRect.h>
 
+#if !MAC && !WIN
+	#include <XBandedRegion.h>
+#endif
+
 namespace Whisper {
 
 #if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
@@ -41,6 +45,8 @@ namespace Whisper {
 // ===================================================================================
 //	class XRegion
 //!		Cross platform region class.
+/*!		On the Mac and Windows this wraps the OS region. On other platforms it's
+ *		implemented with XBandedRegion. */
 // ===================================================================================
 class GRAPHICS_EXPORT XRegion {
 
@@ -67,8 +73,12 @@ public:
 						XRegion(const XPoint* vertices, uint32 count);	// ($$$ may want to use template member function here)
 						/**< polygon */
 								
+#if MAC || WIN
 						XRegion(OSRegion rgn);
 						/**< copy of OS region */
+#else
+						XRegion(const XBandedRegion& rgn);
+#endif
 						
 						XRegion(const XRegion& rhs);
 						
@@ -78,7 +88,11 @@ public:
 public:
 	//! @name Conversion Operators
 	//@{
+#if MAC || WIN
 						operator OSRegion() const					{return mRgn;}
+#else
+						operator const XBandedRegion&() const		{return mRgn;}
+#endif
 	//@}
 
 	//! @name Assignment
@@ -149,7 +163,11 @@ public:
 //	Member Data
 //
 private:
-	OSRegion	mRgn;
+#if MAC || WIN
+	OSRegion		mRgn;
+#else
+	XBandedRegion	mRgn;
+#endif
 };
 
 
@@ -208,6 +226,42 @@ private:
 	{
 		return ::RectInRegion(mRgn, rect) != 0;
 	}
+
+#else
+	inline XRegion::~XRegion()												{}
+	inline XRegion::XRegion()												{}
+	inline XRegion::XRegion(const XRect& rect) : mRgn(rect)					{}
+	inline XRegion::XRegion(const XRect* rects, uint32 count) : mRgn(rects, count)	{}
+	inline XRegion::XRegion(const XRect& rect, int32 ovalWidth, int32 ovalHeight) : mRgn(rect, ovalWidth, ovalHeight)	{}
+	inline XRegion::XRegion(const XPoint& center, int32 width, int32 height) : mRgn(center, width, height)	{}
+	inline XRegion::XRegion(const XPoint* vertices, uint32 count) : mRgn(vertices, count)	{}
+	inline XRegion::XRegion(const XBandedRegion& rgn) : mRgn(rgn)			{}
+	inline XRegion::XRegion(const XRegion& rhs) : mRgn(rhs.mRgn)			{}
+
+	inline XRegion& XRegion::operator=(const XRegion& rhs)					{mRgn = rhs.mRgn; return *this;}
+	inline XRegion& XRegion::operator+=(const XRegion& rhs)					{mRgn += rhs.mRgn; return *this;}
+	inline XRegion& XRegion::operator-=(const XRegion& rhs)					{mRgn -= rhs.mRgn; return *this;}
+	inline XRegion& XRegion::operator&=(const XRegion& rhs)					{mRgn &= rhs.mRgn; return *this;}
+	inline XRegion& XRegion::operator^=(const XRegion& rhs)					{mRgn ^= rhs.mRgn; return *this;}
+	inline XRegion& XRegion::operator+=(const XPoint& offset)				{mRgn += offset; return *this;}
+	inline XRegion& XRegion::operator-=(const XPoint& offset)				{mRgn -= offset; return *this;}
+
+	inline XRegion operator+(const XRegion& lhs, const XRegion& rhs)		{return lhs.mRgn + rhs.mRgn;}
+	inline XRegion operator-(const XRegion& lhs, const XRegion& rhs)		{return lhs.mRgn - rhs.mRgn;}
+	inline XRegion operator&(const XRegion& lhs, const XRegion& rhs)		{return lhs.mRgn & rhs.mRgn;}
+	inline XRegion operator^(const XRegion& lhs, const XRegion& rhs)		{return lhs.mRgn ^ rhs.mRgn;}
+	inline XRegion operator+(const XRegion& lhs, const XPoint& offset)		{return lhs.mRgn + offset;}
+	inline XRegion operator-(const XRegion& lhs, const XPoint& offset)		{return lhs.mRgn - offset;}
+
+	inline void XRegion::MakeEmpty()										{mRgn.MakeEmpty();}
+	inline void XRegion::MoveTo(const XPoint& pt)							{mRgn.MoveTo(pt);}
+
+	inline bool XRegion::operator==(const XRegion& rhs) const				{return mRgn == rhs.mRgn;}
+	inline bool XRegion::IsEmpty() const									{return mRgn.IsEmpty();}
+	inline XRect XRegion::GetEnclosingRect() const							{return mRgn.GetEnclosingRect();}
+	inline bool XRegion::Contains(const XPoint& pt) const					{return mRgn.Contains(pt);}
+	inline bool XRegion::Contains(const XRect& rect) const					{return mRgn.Contains(rect);}
+	inline bool XRegion::Intersects(const XRect& rect) const				{return mRgn.Intersects(rect);}
 #endif
 
 
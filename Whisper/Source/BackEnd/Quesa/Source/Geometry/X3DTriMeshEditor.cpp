@@ -0,0 +1,1109 @@
+/*
+ *  File:       X3DTriMeshEditor.cpp
+ *  Summary:	Editable copy of a tri mesh's data with welding, normal generation, and reordering.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: X3DTriMeshEditor.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <X3DTriMeshEditor.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <X3DTriMesh.h>
+#include <X3DUtils.h>
+#include <XDebug.h>
+#include <XIntConversions.h>
+#include <XStringUtils.h>
+
+namespace Whisper {
+
+
+//-----------------------------------
+//	Internal Constants
+//
+const uint32 kNone = 0xFFFFFFFF;
+
+const uint32 kMaxCacheSize = 64;
+
+const float kCacheDecayPower   = 1.5f;			// these are the values from Tom Forsyth's paper
+const float kLastTriangleScore = 0.75f;
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+
+const uint32 kMaxValence = 32;					// valence scores above this are computed on the fly
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// GetAttributeSize
+//
+//---------------------------------------------------------------
+static uint32 GetAttributeSize(TQ3AttributeType type)
+{
+	uint32 size = 0;
+
+	switch (type) {
+		case kQ3AttributeTypeSurfaceUV:
+		case kQ3AttributeTypeShadingUV:
+			size = sizeof(TQ3Param2D);
+			break;
+
+		case kQ3AttributeTypeNormal:
+			size = sizeof(TQ3Vector3D);
+			break;
+
+		case kQ3AttributeTypeAmbientCoefficient:
+		case kQ3AttributeTypeSpecularControl:
+			size = sizeof(float);
+			break;
+
+		case kQ3AttributeTypeDiffuseColor:
+		case kQ3AttributeTypeSpecularColor:
+		case kQ3AttributeTypeTransparencyColor:
+			size = sizeof(TQ3ColorRGB);
+			break;
+
+		case kQ3AttributeTypeSurfaceTangent:
+			size = sizeof(TQ3Tangent2D);
+			break;
+
+		case kQ3AttributeTypeHighlightState:
+			size = sizeof(TQ3Switch);
+			break;
+
+		default:
+			throw std::invalid_argument(ToUTF8Str(L"Internal Error: X3DTriMeshEditor can't handle attribute type " + Int32ToStr(type) + L"."));
+	}
+
+	return size;
+}
+
+
+//---------------------------------------------------------------
+//
+// GetCell
+//
+// If tolerance is zero the cell is just the coordinate's bits
+// (with -0 mapped to 0). Otherwise space is divided into cubes
+// tolerance on a side.
+//
+//---------------------------------------------------------------
+inline int32 GetCell(float value, float scale)
+{
+	int32 cell = 0;
+
+	if (scale > 0.0f) {
+		cell = (int32) std::floor(value*scale);
+
+	} else if (value != 0.0f) {
+		ASSERT(sizeof(cell) >= sizeof(value));
+		std::memcpy(&cell, &value, sizeof(value));
+	}
+
+	return cell;
+}
+
+
+//---------------------------------------------------------------
+//
+// HashCell
+//
+// The final mixing step is needed because the low bits of exact
+// cells (ie float bits) are usually zero.
+//
+//---------------------------------------------------------------
+inline uint32 HashCell(int32 x, int32 y, int32 z)
+{
+	uint32 hash = ((uint32) x*73856093UL) ^ ((uint32) y*19349663UL) ^ ((uint32) z*83492791UL);
+
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6BUL;
+	hash ^= hash >> 13;
+
+	return hash;
+}
+
+
+//---------------------------------------------------------------
+//
+// IsNear
+//
+//---------------------------------------------------------------
+inline bool IsNear(const X3DPoint& lhs, const X3DPoint& rhs, float tolerance)
+{
+	return std::fabs(lhs.x - rhs.x) <= tolerance && std::fabs(lhs.y - rhs.y) <= tolerance && std::fabs(lhs.z - rhs.z) <= tolerance;
+}
+
+
+//---------------------------------------------------------------
+//
+// GetVertexScore
+//
+// Vertices near the front of the cache and vertices with only a
+// few triangles left score highest (so isolated triangles don't
+// get left behind).
+//
+//---------------------------------------------------------------
+inline float GetVertexScore(int32 cachePos, uint32 remaining, const float* cacheScores, const float* valenceScores)
+{
+	float score = -1.0f;
+
+	if (remaining > 0) {
+		score = cachePos >= 0 ? cacheScores[cachePos] : 0.0f;
+		score += remaining <= kMaxValence ? valenceScores[remaining] : kValenceBoostScale*std::pow((float) remaining, -kValenceBoostPower);
+	}
+
+	return score;
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class X3DTriMeshEditor
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::~X3DTriMeshEditor
+//
+//---------------------------------------------------------------
+X3DTriMeshEditor::~X3DTriMeshEditor()
+{
+	if (mMeshAttributes != nil)
+		(void) Q3Object_Dispose(mMeshAttributes);
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::X3DTriMeshEditor ()
+//
+//---------------------------------------------------------------
+X3DTriMeshEditor::X3DTriMeshEditor()
+{
+	mMeshAttributes = nil;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::X3DTriMeshEditor (X3DTriMesh)
+//
+//---------------------------------------------------------------
+X3DTriMeshEditor::X3DTriMeshEditor(const X3DTriMesh& mesh)
+{
+	mMeshAttributes = nil;
+
+	TQ3TriMeshData data = mesh.GetData();
+
+	try {
+		this->SetData(data);
+
+	} catch (...) {
+		Q3TriMesh_EmptyData(&data);
+		throw;
+	}
+
+	Q3TriMesh_EmptyData(&data);
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::X3DTriMeshEditor (TQ3TriMeshData)
+//
+//---------------------------------------------------------------
+X3DTriMeshEditor::X3DTriMeshEditor(const TQ3TriMeshData& data)
+{
+	mMeshAttributes = nil;
+
+	this->SetData(data);
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::X3DTriMeshEditor (X3DTriMeshEditor)
+//
+//---------------------------------------------------------------
+X3DTriMeshEditor::X3DTriMeshEditor(const X3DTriMeshEditor& rhs) : mPoints(rhs.mPoints), mTriangles(rhs.mTriangles), mVertexAttributes(rhs.mVertexAttributes), mTriangleAttributes(rhs.mTriangleAttributes)
+{
+	mMeshAttributes = rhs.mMeshAttributes;
+	if (mMeshAttributes != nil)
+		(void) Q3Shared_GetReference(mMeshAttributes);
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::operator=
+//
+//---------------------------------------------------------------
+X3DTriMeshEditor& X3DTriMeshEditor::operator=(const X3DTriMeshEditor& rhs)
+{
+	if (this != &rhs) {
+		mPoints             = rhs.mPoints;
+		mTriangles          = rhs.mTriangles;
+		mVertexAttributes   = rhs.mVertexAttributes;
+		mTriangleAttributes = rhs.mTriangleAttributes;
+
+		if (rhs.mMeshAttributes != nil)
+			(void) Q3Shared_GetReference(rhs.mMeshAttributes);
+		if (mMeshAttributes != nil)
+			(void) Q3Object_Dispose(mMeshAttributes);
+		mMeshAttributes = rhs.mMeshAttributes;
+	}
+
+	return *this;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::SetData
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::SetData(const TQ3TriMeshData& data)
+{
+	PRECONDITION(data.points != nil || data.numPoints == 0);
+	PRECONDITION(data.triangles != nil || data.numTriangles == 0);
+
+	std::vector<X3DPoint> points(data.points, data.points + data.numPoints);
+	std::vector<TQ3TriMeshTriangleData> triangles(data.triangles, data.triangles + data.numTriangles);
+
+	Attributes vertexAttributes, triangleAttributes;
+	DoCopyAttributes(vertexAttributes, data.vertexAttributeTypes, data.numVertexAttributeTypes, data.numPoints);
+	DoCopyAttributes(triangleAttributes, data.triangleAttributeTypes, data.numTriangleAttributeTypes, data.numTriangles);
+
+	mPoints.swap(points);
+	mTriangles.swap(triangles);
+	mVertexAttributes.swap(vertexAttributes);
+	mTriangleAttributes.swap(triangleAttributes);
+
+	if (data.triMeshAttributeSet != nil)
+		(void) Q3Shared_GetReference(data.triMeshAttributeSet);
+	if (mMeshAttributes != nil)
+		(void) Q3Object_Dispose(mMeshAttributes);
+	mMeshAttributes = data.triMeshAttributeSet;
+
+	CALL_INVARIANT;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::CopyTo
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::CopyTo(X3DTriMesh& mesh) const
+{
+	TQ3TriMeshData data;
+	std::vector<TQ3TriMeshAttributeData> vertexAttributes, triangleAttributes;
+	this->DoGetData(data, vertexAttributes, triangleAttributes);
+
+	mesh.SetData(data);
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::CreateMesh
+//
+//---------------------------------------------------------------
+X3DTriMesh X3DTriMeshEditor::CreateMesh() const
+{
+	TQ3TriMeshData data;
+	std::vector<TQ3TriMeshAttributeData> vertexAttributes, triangleAttributes;
+	this->DoGetData(data, vertexAttributes, triangleAttributes);
+
+	return X3DTriMesh(data);
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::HasVertexAttribute
+//
+//---------------------------------------------------------------
+bool X3DTriMeshEditor::HasVertexAttribute(TQ3AttributeType type) const
+{
+	return this->GetVertexAttribute(type) != nil;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::GetVertexAttribute
+//
+//---------------------------------------------------------------
+const void* X3DTriMeshEditor::GetVertexAttribute(TQ3AttributeType type) const
+{
+	const void* data = nil;
+
+	for (uint32 i = 0; i < mVertexAttributes.size() && data == nil; ++i)
+		if (mVertexAttributes[i].type == type && !mVertexAttributes[i].data.empty())
+			data = &mVertexAttributes[i].data[0];
+
+	return data;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::WeldVertices
+//
+// Vertices are hashed by the cell their position falls into. If
+// tolerance is non-zero a vertex may match one in a neighboring
+// cell so all 27 cells around the vertex are searched. Each vertex
+// is compared against the first vertex of each group (so the
+// result doesn't depend on chains of nearly equal vertices).
+//
+//---------------------------------------------------------------
+uint32 X3DTriMeshEditor::WeldVertices(float tolerance)
+{
+	PRECONDITION(tolerance >= 0.0f);
+
+	uint32 oldCount = mPoints.size();
+
+	uint32 numBuckets = 1;
+	while (numBuckets < 2*oldCount)
+		numBuckets *= 2;
+
+	std::vector<uint32> buckets(numBuckets, kNone);
+	std::vector<uint32> next(oldCount, kNone);			// chains the representatives in each bucket
+	std::vector<uint32> oldToNew(oldCount);
+	std::vector<uint32> newToOld;
+	newToOld.reserve(oldCount);
+
+	float scale = tolerance > 0.0f ? 1.0f/tolerance : 0.0f;
+	int32 range = tolerance > 0.0f ? 1 : 0;
+
+	for (uint32 vertex = 0; vertex < oldCount; ++vertex) {
+		const X3DPoint& pt = mPoints[vertex];
+		int32 x = GetCell(pt.x, scale);
+		int32 y = GetCell(pt.y, scale);
+		int32 z = GetCell(pt.z, scale);
+
+		uint32 match = kNone;
+		for (int32 dx = -range; dx <= range && match == kNone; ++dx) {
+			for (int32 dy = -range; dy <= range && match == kNone; ++dy) {
+				for (int32 dz = -range; dz <= range && match == kNone; ++dz) {
+					uint32 bucket = HashCell(x + dx, y + dy, z + dz) & (numBuckets - 1);
+
+					for (uint32 candidate = buckets[bucket]; candidate != kNone && match == kNone; candidate = next[candidate])
+						if (IsNear(mPoints[candidate], pt, tolerance) && this->DoSameAttributes(candidate, vertex))
+							match = candidate;
+				}
+			}
+		}
+
+		if (match != kNone) {
+			oldToNew[vertex] = oldToNew[match];
+
+		} else {
+			oldToNew[vertex] = newToOld.size();
+			newToOld.push_back(vertex);
+
+			uint32 bucket = HashCell(x, y, z) & (numBuckets - 1);
+			next[vertex] = buckets[bucket];
+			buckets[bucket] = vertex;
+		}
+	}
+
+	// Point the triangles at the merged vertices and drop the ones
+	// that collapsed.
+	std::vector<uint32> order;
+	order.reserve(mTriangles.size());
+
+	for (uint32 i = 0; i < mTriangles.size(); ++i) {
+		TQ3TriMeshTriangleData& triangle = mTriangles[i];
+		for (uint32 j = 0; j < 3; ++j)
+			triangle.pointIndices[j] = oldToNew[triangle.pointIndices[j]];
+
+		if (triangle.pointIndices[0] != triangle.pointIndices[1] && triangle.pointIndices[1] != triangle.pointIndices[2] && triangle.pointIndices[2] != triangle.pointIndices[0])
+			order.push_back(i);
+	}
+
+	this->DoGatherVertices(newToOld);
+	if (order.size() < mTriangles.size())
+		this->DoPermuteTriangles(order);
+	this->DoRemoveUnusedVertices();
+
+	CALL_INVARIANT;
+
+	return oldCount - mPoints.size();
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::ComputeSmoothNormals
+//
+// Each vertex's triangles are split into clusters: a triangle joins
+// the first cluster whose initial triangle it's within creaseAngle
+// of. The first cluster keeps the vertex, the others get copies.
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::ComputeSmoothNormals(double creaseAngle)
+{
+	PRECONDITION(creaseAngle >= 0.0);
+
+	uint32 numTriangles = mTriangles.size();
+	uint32 numVertices  = mPoints.size();
+
+	std::vector<X3DVector> weighted(numTriangles);				// length is proportional to the area
+	std::vector<X3DVector> units(numTriangles);
+	for (uint32 i = 0; i < numTriangles; ++i) {
+		weighted[i] = this->DoGetTriangleNormal(i);
+		units[i] = weighted[i].LengthSquared() > 0.0 ? Normalize(weighted[i]) : weighted[i];
+	}
+
+	// Find the corners (triangle*3 + index) that use each vertex.
+	std::vector<uint32> offsets(numVertices + 1, 0);
+	for (uint32 i = 0; i < numTriangles; ++i)
+		for (uint32 j = 0; j < 3; ++j)
+			++offsets[mTriangles[i].pointIndices[j] + 1];
+
+	for (uint32 v = 0; v < numVertices; ++v)
+		offsets[v + 1] += offsets[v];
+
+	std::vector<uint32> corners(3*numTriangles);
+	std::vector<uint32> fill(offsets.begin(), offsets.end() - 1);
+	for (uint32 i = 0; i < numTriangles; ++i)
+		for (uint32 j = 0; j < 3; ++j)
+			corners[fill[mTriangles[i].pointIndices[j]]++] = 3*i + j;
+
+	double minCos = creaseAngle >= kPi ? -2.0 : std::cos(creaseAngle);
+
+	std::vector<X3DVector> normals(numVertices, X3DVector(0.0f, 0.0f, 0.0f));
+	std::vector<X3DVector> clusterNormals;
+	std::vector<uint32> clusterVertices;
+
+	for (uint32 v = 0; v < numVertices; ++v) {
+		clusterNormals.clear();
+		clusterVertices.clear();
+
+		for (uint32 c = offsets[v]; c < offsets[v + 1]; ++c) {
+			uint32 triangle = corners[c]/3;
+			const X3DVector& unit = units[triangle];
+
+			uint32 cluster = kNone;
+			for (uint32 k = 0; k < clusterNormals.size() && cluster == kNone; ++k) {
+				if (clusterNormals[k].LengthSquared() == 0.0)
+					clusterNormals[k] = unit;							// first triangle was degenerate
+				if (unit.LengthSquared() == 0.0 || DotProduct(unit, clusterNormals[k]) >= minCos)
+					cluster = k;
+			}
+
+			if (cluster == kNone) {
+				cluster = clusterNormals.size();
+				clusterNormals.push_back(unit);
+
+				if (cluster == 0) {
+					clusterVertices.push_back(v);
+				} else {
+					clusterVertices.push_back(this->DoAppendVertex(v));
+					normals.push_back(X3DVector(0.0f, 0.0f, 0.0f));
+				}
+			}
+
+			uint32 vertex = clusterVertices[cluster];
+			normals[vertex] = X3DVector(normals[vertex].x + weighted[triangle].x, normals[vertex].y + weighted[triangle].y, normals[vertex].z + weighted[triangle].z);
+			mTriangles[triangle].pointIndices[corners[c] % 3] = vertex;
+		}
+	}
+
+	for (uint32 i = 0; i < normals.size(); ++i)
+		normals[i] = normals[i].LengthSquared() > 0.0 ? Normalize(normals[i]) : X3DVector(0.0f, 0.0f, 1.0f);	// unused (or degenerate) vertices get an arbitrary normal
+
+	this->DoSetNormals(normals);
+
+	CALL_INVARIANT;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::ComputeFacetedNormals
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::ComputeFacetedNormals()
+{
+	uint32 numTriangles = mTriangles.size();
+
+	std::vector<uint32> newToOld(3*numTriangles);
+	std::vector<X3DVector> normals(3*numTriangles);
+
+	for (uint32 i = 0; i < numTriangles; ++i) {
+		X3DVector normal = this->DoGetTriangleNormal(i);
+		normal = normal.LengthSquared() > 0.0 ? Normalize(normal) : X3DVector(0.0f, 0.0f, 1.0f);
+
+		for (uint32 j = 0; j < 3; ++j) {
+			newToOld[3*i + j] = mTriangles[i].pointIndices[j];
+			normals[3*i + j] = normal;
+
+			mTriangles[i].pointIndices[j] = 3*i + j;
+		}
+	}
+
+	this->DoGatherVertices(newToOld);
+	this->DoSetNormals(normals);
+
+	CALL_INVARIANT;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::OptimizeVertexCache
+//
+// Greedily adds the triangle with the highest score where a
+// triangle's score is the sum of its vertices' scores. Only the
+// triangles using vertices in the simulated cache have their
+// scores change so only they need to be considered for the next
+// triangle. If none of them are left we fall back to scanning for
+// the next unadded triangle.
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::OptimizeVertexCache(uint32 cacheSize)
+{
+	PRECONDITION(cacheSize > 3 && cacheSize <= kMaxCacheSize);
+
+	uint32 numTriangles = mTriangles.size();
+	uint32 numVertices  = mPoints.size();
+	if (numTriangles == 0)
+		return;
+
+	float cacheScores[kMaxCacheSize];
+	for (uint32 i = 0; i < cacheSize; ++i)
+		cacheScores[i] = i < 3 ? kLastTriangleScore : std::pow(1.0f - (i - 3)/(float) (cacheSize - 3), kCacheDecayPower);
+
+	float valenceScores[kMaxValence + 1];
+	valenceScores[0] = 0.0f;
+	for (uint32 i = 1; i <= kMaxValence; ++i)
+		valenceScores[i] = kValenceBoostScale*std::pow((float) i, -kValenceBoostPower);
+
+	// Build the vertex to triangle lists. The first remaining[v]
+	// entries in each list are the triangles that haven't been added.
+	std::vector<uint32> offsets(numVertices + 1, 0);
+	for (uint32 i = 0; i < numTriangles; ++i)
+		for (uint32 j = 0; j < 3; ++j)
+			++offsets[mTriangles[i].pointIndices[j] + 1];
+
+	for (uint32 v = 0; v < numVertices; ++v)
+		offsets[v + 1] += offsets[v];
+
+	std::vector<uint32> adjacency(3*numTriangles);
+	std::vector<uint32> remaining(numVertices, 0);
+	for (uint32 i = 0; i < numTriangles; ++i) {
+		for (uint32 j = 0; j < 3; ++j) {
+			uint32 v = mTriangles[i].pointIndices[j];
+			adjacency[offsets[v] + remaining[v]++] = i;
+		}
+	}
+
+	std::vector<int32> cachePos(numVertices, -1);
+	std::vector<float> vertexScores(numVertices);
+	for (uint32 v = 0; v < numVertices; ++v)
+		vertexScores[v] = GetVertexScore(-1, remaining[v], cacheScores, valenceScores);
+
+	std::vector<float> triangleScores(numTriangles);
+	std::vector<bool> added(numTriangles, false);
+	uint32 best = 0;
+	for (uint32 i = 0; i < numTriangles; ++i) {
+		const TQ3TriMeshTriangleData& triangle = mTriangles[i];
+		triangleScores[i] = vertexScores[triangle.pointIndices[0]] + vertexScores[triangle.pointIndices[1]] + vertexScores[triangle.pointIndices[2]];
+		if (triangleScores[i] > triangleScores[best])
+			best = i;
+	}
+
+	std::vector<uint32> order;
+	order.reserve(numTriangles);
+
+	uint32 cache[kMaxCacheSize + 3];
+	uint32 cacheCount = 0;
+	uint32 scan = 0;
+
+	while (order.size() < numTriangles) {
+		if (best == kNone) {
+			while (added[scan])
+				++scan;
+			best = scan;
+		}
+
+		added[best] = true;
+		order.push_back(best);
+
+		// Remove the triangle from its vertices' lists.
+		const TQ3TriMeshTriangleData& triangle = mTriangles[best];
+		for (uint32 j = 0; j < 3; ++j) {
+			uint32 v = triangle.pointIndices[j];
+			uint32* first = &adjacency[offsets[v]];
+			uint32* last = first + remaining[v] - 1;
+
+			uint32* entry = first;
+			while (*entry != best)
+				++entry;
+			ASSERT(entry <= last);
+
+			std::swap(*entry, *last);
+			--remaining[v];
+		}
+
+		// Move the triangle's vertices to the front of the cache.
+		uint32 newCache[kMaxCacheSize + 3];
+		uint32 newCount = 0;
+		for (uint32 j = 0; j < 3; ++j) {
+			uint32 v = triangle.pointIndices[j];
+			if (std::find(newCache, newCache + newCount, v) == newCache + newCount)
+				newCache[newCount++] = v;
+		}
+
+		for (uint32 i = 0; i < cacheCount; ++i) {
+			uint32 v = cache[i];
+			if (std::find(newCache, newCache + newCount, v) == newCache + newCount)
+				newCache[newCount++] = v;
+		}
+
+		// Update the scores of everything that was in the cache (vertices
+		// pushed out of the cache lose their cache score).
+		for (uint32 i = 0; i < newCount; ++i) {
+			uint32 v = newCache[i];
+			cachePos[v] = i < cacheSize ? (int32) i : -1;
+
+			float score = GetVertexScore(cachePos[v], remaining[v], cacheScores, valenceScores);
+			float delta = score - vertexScores[v];
+			vertexScores[v] = score;
+
+			for (uint32 k = offsets[v]; k < offsets[v] + remaining[v]; ++k)
+				triangleScores[adjacency[k]] += delta;
+		}
+
+		cacheCount = Min(newCount, cacheSize);
+		std::copy(newCache, newCache + cacheCount, cache);
+
+		// The best triangle is probably one that uses a cached vertex.
+		best = kNone;
+		float bestScore = -1.0f;
+		for (uint32 i = 0; i < cacheCount; ++i) {
+			uint32 v = cache[i];
+			for (uint32 k = offsets[v]; k < offsets[v] + remaining[v]; ++k) {
+				uint32 candidate = adjacency[k];
+				if (triangleScores[candidate] > bestScore) {
+					bestScore = triangleScores[candidate];
+					best = candidate;
+				}
+			}
+		}
+	}
+
+	this->DoPermuteTriangles(order);
+
+	CALL_INVARIANT;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::OptimizeVertexFetch
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::OptimizeVertexFetch()
+{
+	std::vector<uint32> oldToNew(mPoints.size(), kNone);
+	std::vector<uint32> newToOld;
+	newToOld.reserve(mPoints.size());
+
+	for (uint32 i = 0; i < mTriangles.size(); ++i) {
+		for (uint32 j = 0; j < 3; ++j) {
+			TQ3Uns32& index = mTriangles[i].pointIndices[j];
+			if (oldToNew[index] == kNone) {
+				oldToNew[index] = newToOld.size();
+				newToOld.push_back(index);
+			}
+			index = oldToNew[index];
+		}
+	}
+
+	this->DoGatherVertices(newToOld);
+
+	CALL_INVARIANT;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::GetACMR
+//
+// A vertex is in the FIFO cache if fewer than cacheSize vertices
+// have been transformed since it was.
+//
+//---------------------------------------------------------------
+double X3DTriMeshEditor::GetACMR(uint32 cacheSize) const
+{
+	PRECONDITION(cacheSize > 0);
+
+	if (mTriangles.empty())
+		return 0.0;
+
+	std::vector<uint32> stamps(mPoints.size(), 0);
+	uint32 misses = 0;
+
+	for (uint32 i = 0; i < mTriangles.size(); ++i) {
+		for (uint32 j = 0; j < 3; ++j) {
+			uint32 v = mTriangles[i].pointIndices[j];
+			if (stamps[v] == 0 || misses - stamps[v] >= cacheSize)
+				stamps[v] = ++misses;
+		}
+	}
+
+	return (double) misses/mTriangles.size();
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::Invariant
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::Invariant() const
+{
+	for (uint32 i = 0; i < mTriangles.size(); ++i)
+		for (uint32 j = 0; j < 3; ++j)
+			ASSERT(mTriangles[i].pointIndices[j] < mPoints.size());
+
+	for (uint32 i = 0; i < mVertexAttributes.size(); ++i) {
+		const SAttribute& attribute = mVertexAttributes[i];
+		ASSERT(attribute.data.size() == attribute.size*mPoints.size());
+		ASSERT(attribute.used.empty() || attribute.used.size() == mPoints.size());
+	}
+
+	for (uint32 i = 0; i < mTriangleAttributes.size(); ++i) {
+		const SAttribute& attribute = mTriangleAttributes[i];
+		ASSERT(attribute.data.size() == attribute.size*mTriangles.size());
+		ASSERT(attribute.used.empty() || attribute.used.size() == mTriangles.size());
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::DoGetData
+//
+// The data points into our vectors so it's only valid until the
+// editor is changed.
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::DoGetData(TQ3TriMeshData& data, std::vector<TQ3TriMeshAttributeData>& vertexAttributes, std::vector<TQ3TriMeshAttributeData>& triangleAttributes) const
+{
+	DoGetAttributes(mVertexAttributes, vertexAttributes);
+	DoGetAttributes(mTriangleAttributes, triangleAttributes);
+
+	data.triMeshAttributeSet       = mMeshAttributes;
+	data.numTriangles              = mTriangles.size();
+	data.triangles                 = mTriangles.empty() ? nil : const_cast<TQ3TriMeshTriangleData*>(&mTriangles[0]);
+	data.numTriangleAttributeTypes = triangleAttributes.size();
+	data.triangleAttributeTypes    = triangleAttributes.empty() ? nil : &triangleAttributes[0];
+	data.numEdges                  = 0;
+	data.edges                     = nil;
+	data.numEdgeAttributeTypes     = 0;
+	data.edgeAttributeTypes        = nil;
+	data.numPoints                 = mPoints.size();
+	data.points                    = mPoints.empty() ? nil : const_cast<TQ3Point3D*>(static_cast<const TQ3Point3D*>(mPoints[0]));
+	data.numVertexAttributeTypes   = vertexAttributes.size();
+	data.vertexAttributeTypes      = vertexAttributes.empty() ? nil : &vertexAttributes[0];
+
+	data.bBox.min     = kZero3DPt;
+	data.bBox.max     = kZero3DPt;
+	data.bBox.isEmpty = mPoints.empty() ? kQ3True : kQ3False;
+
+	if (!mPoints.empty()) {
+		X3DPoint minPt = mPoints[0];
+		X3DPoint maxPt = mPoints[0];
+		for (uint32 i = 1; i < mPoints.size(); ++i) {
+			const X3DPoint& pt = mPoints[i];
+			minPt.Set(Min(minPt.x, pt.x), Min(minPt.y, pt.y), Min(minPt.z, pt.z));
+			maxPt.Set(Max(maxPt.x, pt.x), Max(maxPt.y, pt.y), Max(maxPt.z, pt.z));
+		}
+
+		data.bBox.min = minPt;
+		data.bBox.max = maxPt;
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::DoAppendVertex
+//
+// Adds a copy of the vertex and returns the new vertex's index.
+//
+//---------------------------------------------------------------
+uint32 X3DTriMeshEditor::DoAppendVertex(uint32 vertex)
+{
+	PRECONDITION(vertex < mPoints.size());
+
+	X3DPoint pt = mPoints[vertex];
+	mPoints.push_back(pt);
+
+	for (uint32 i = 0; i < mVertexAttributes.size(); ++i) {
+		SAttribute& attribute = mVertexAttributes[i];
+
+		uint32 offset = attribute.data.size();
+		attribute.data.resize(offset + attribute.size);
+		std::memcpy(&attribute.data[offset], &attribute.data[vertex*attribute.size], attribute.size);
+
+		if (!attribute.used.empty()) {
+			char used = attribute.used[vertex];
+			attribute.used.push_back(used);
+		}
+	}
+
+	return mPoints.size() - 1;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::DoGatherVertices
+//
+// New vertex i is a copy of old vertex newToOld[i]. The caller is
+// responsible for fixing up the triangles.
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::DoGatherVertices(const std::vector<uint32>& newToOld)
+{
+	uint32 count = newToOld.size();
+
+	std::vector<X3DPoint> points(count);
+	for (uint32 i = 0; i < count; ++i)
+		points[i] = mPoints[newToOld[i]];
+	mPoints.swap(points);
+
+	for (uint32 j = 0; j < mVertexAttributes.size(); ++j) {
+		SAttribute& attribute = mVertexAttributes[j];
+
+		std::vector<uint8> data(count*attribute.size);
+		for (uint32 i = 0; i < count; ++i)
+			std::memcpy(&data[i*attribute.size], &attribute.data[newToOld[i]*attribute.size], attribute.size);
+		attribute.data.swap(data);
+
+		if (!attribute.used.empty()) {
+			std::vector<char> used(count);
+			for (uint32 i = 0; i < count; ++i)
+				used[i] = attribute.used[newToOld[i]];
+			attribute.used.swap(used);
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::DoRemoveUnusedVertices
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::DoRemoveUnusedVertices()
+{
+	std::vector<uint32> oldToNew(mPoints.size(), kNone);
+	for (uint32 i = 0; i < mTriangles.size(); ++i)
+		for (uint32 j = 0; j < 3; ++j)
+			oldToNew[mTriangles[i].pointIndices[j]] = 0;
+
+	std::vector<uint32> newToOld;
+	newToOld.reserve(mPoints.size());
+	for (uint32 v = 0; v < mPoints.size(); ++v) {
+		if (oldToNew[v] != kNone) {
+			oldToNew[v] = newToOld.size();
+			newToOld.push_back(v);
+		}
+	}
+
+	if (newToOld.size() < mPoints.size()) {
+		for (uint32 i = 0; i < mTriangles.size(); ++i)
+			for (uint32 j = 0; j < 3; ++j)
+				mTriangles[i].pointIndices[j] = oldToNew[mTriangles[i].pointIndices[j]];
+
+		this->DoGatherVertices(newToOld);
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::DoPermuteTriangles
+//
+// New triangle i is old triangle order[i] (order may be shorter
+// than the number of triangles).
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::DoPermuteTriangles(const std::vector<uint32>& order)
+{
+	uint32 count = order.size();
+
+	std::vector<TQ3TriMeshTriangleData> triangles(count);
+	for (uint32 i = 0; i < count; ++i)
+		triangles[i] = mTriangles[order[i]];
+	mTriangles.swap(triangles);
+
+	for (uint32 j = 0; j < mTriangleAttributes.size(); ++j) {
+		SAttribute& attribute = mTriangleAttributes[j];
+
+		std::vector<uint8> data(count*attribute.size);
+		for (uint32 i = 0; i < count; ++i)
+			std::memcpy(&data[i*attribute.size], &attribute.data[order[i]*attribute.size], attribute.size);
+		attribute.data.swap(data);
+
+		if (!attribute.used.empty()) {
+			std::vector<char> used(count);
+			for (uint32 i = 0; i < count; ++i)
+				used[i] = attribute.used[order[i]];
+			attribute.used.swap(used);
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::DoSetNormals
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::DoSetNormals(const std::vector<X3DVector>& normals)
+{
+	PRECONDITION(normals.size() == mPoints.size());
+
+	SAttribute* attribute = nil;
+	for (uint32 i = 0; i < mVertexAttributes.size() && attribute == nil; ++i)
+		if (mVertexAttributes[i].type == kQ3AttributeTypeNormal)
+			attribute = &mVertexAttributes[i];
+
+	if (attribute == nil) {
+		mVertexAttributes.push_back(SAttribute());
+		attribute = &mVertexAttributes.back();
+		attribute->type = kQ3AttributeTypeNormal;
+		attribute->size = sizeof(TQ3Vector3D);
+	}
+
+	attribute->data.resize(normals.size()*sizeof(TQ3Vector3D));
+	attribute->used.clear();
+
+	for (uint32 i = 0; i < normals.size(); ++i) {
+		TQ3Vector3D normal = normals[i];
+		std::memcpy(&attribute->data[i*sizeof(TQ3Vector3D)], &normal, sizeof(TQ3Vector3D));
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::DoSameAttributes
+//
+//---------------------------------------------------------------
+bool X3DTriMeshEditor::DoSameAttributes(uint32 lhs, uint32 rhs) const
+{
+	bool same = true;
+
+	for (uint32 i = 0; i < mVertexAttributes.size() && same; ++i) {
+		const SAttribute& attribute = mVertexAttributes[i];
+
+		bool lhsUsed = attribute.used.empty() || attribute.used[lhs] != 0;
+		bool rhsUsed = attribute.used.empty() || attribute.used[rhs] != 0;
+
+		if (lhsUsed != rhsUsed)
+			same = false;
+		else if (lhsUsed)
+			same = std::memcmp(&attribute.data[lhs*attribute.size], &attribute.data[rhs*attribute.size], attribute.size) == 0;
+	}
+
+	return same;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::DoGetTriangleNormal
+//
+// Returns the unnormalized normal (its length is twice the area).
+// Front faces are counter-clockwise.
+//
+//---------------------------------------------------------------
+X3DVector X3DTriMeshEditor::DoGetTriangleNormal(uint32 triangle) const
+{
+	const TQ3TriMeshTriangleData& data = mTriangles[triangle];
+
+	const X3DPoint& pt0 = mPoints[data.pointIndices[0]];
+	const X3DPoint& pt1 = mPoints[data.pointIndices[1]];
+	const X3DPoint& pt2 = mPoints[data.pointIndices[2]];
+
+	return CrossProduct(X3DVector(pt0, pt1), X3DVector(pt0, pt2));
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::DoCopyAttributes							[static]
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::DoCopyAttributes(Attributes& attributes, const TQ3TriMeshAttributeData* data, uint32 numTypes, uint32 count)
+{
+	PRECONDITION(data != nil || numTypes == 0);
+
+	attributes.resize(numTypes);
+
+	for (uint32 i = 0; i < numTypes; ++i) {
+		SAttribute& attribute = attributes[i];
+		attribute.type = data[i].attributeType;
+		attribute.size = GetAttributeSize(attribute.type);
+
+		const uint8* bytes = static_cast<const uint8*>(data[i].data);
+		ASSERT(bytes != nil || count == 0);
+		attribute.data.assign(bytes, bytes + count*attribute.size);
+
+		if (data[i].attributeUseArray != nil)
+			attribute.used.assign(data[i].attributeUseArray, data[i].attributeUseArray + count);
+		else
+			attribute.used.clear();
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditor::DoGetAttributes							[static]
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditor::DoGetAttributes(const Attributes& attributes, std::vector<TQ3TriMeshAttributeData>& data)
+{
+	data.resize(attributes.size());
+
+	for (uint32 i = 0; i < attributes.size(); ++i) {
+		const SAttribute& attribute = attributes[i];
+
+		data[i].attributeType     = attribute.type;
+		data[i].data              = attribute.data.empty() ? nil : const_cast<uint8*>(&attribute.data[0]);
+		data[i].attributeUseArray = attribute.used.empty() ? nil : const_cast<char*>(&attribute.used[0]);
+	}
+}
+
+
+}	// namespace Whisper
@@ -0,0 +1,198 @@
+/*
+ *  File:       X3DTriMeshEditor.h
+ *  Summary:	Editable copy of a tri mesh's data with welding, normal generation, and reordering.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: X3DTriMeshEditor.h,v $
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <Quesa.h>
+
+#include <X3DPrimitives.h>
+#include <X3DVectors.h>
+#include <XNumbers.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+//-----------------------------------
+//	Forward References
+//
+class X3DTriMesh;
+
+
+// ===================================================================================
+//	class X3DTriMeshEditor
+//!		Editable copy of a tri mesh's data with welding, normal generation, and reordering.
+/*!		X3DTriMesh is a thin wrapper around the Quesa object so the only way to change a
+ *		mesh is to get its data, edit it, and set it again. This class holds the points,
+ *		triangles, and vertex and triangle attributes in std::vectors and provides the
+ *		usual mesh optimizations. All of them run in (close to) linear time:
+ *
+ *		WeldVertices merges vertices with the same position (within a tolerance) and the
+ *		same attributes and removes the triangles that become degenerate.
+ *
+ *		ComputeSmoothNormals and ComputeFacetedNormals add (or replace) the vertex normal
+ *		attribute. Vertices are split where the normals need to differ.
+ *
+ *		OptimizeVertexCache reorders the triangles so that the vertices are reused while
+ *		they're still in the GPU's post-transform cache (this uses Tom Forsyth's linear
+ *		speed algorithm). GetACMR returns the average cache miss ratio (the number of
+ *		vertices transformed per triangle) for a FIFO cache so the result can be measured.
+ *
+ *		OptimizeVertexFetch renumbers the vertices in the order the triangles use them
+ *		so memory is read sequentially. It should be called after OptimizeVertexCache.
+ *
+ *		Edges aren't preserved. Vertex and triangle attributes must be one of the standard
+ *		data types (eg normals, uvs, colors), custom attributes and surface shaders aren't
+ *		supported. */
+// ===================================================================================
+class QUESA_EXPORT X3DTriMeshEditor {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+						~X3DTriMeshEditor();
+
+						X3DTriMeshEditor();
+
+	explicit			X3DTriMeshEditor(const X3DTriMesh& mesh);
+
+	explicit			X3DTriMeshEditor(const TQ3TriMeshData& data);
+
+						X3DTriMeshEditor(const X3DTriMeshEditor& rhs);
+
+			X3DTriMeshEditor& operator=(const X3DTriMeshEditor& rhs);
+
+//-----------------------------------
+//	API
+//
+public:
+	//! @name Data
+	//@{
+			void 		SetData(const TQ3TriMeshData& data);
+						/**< Copies the data (and adds a reference to the mesh's attribute
+						set). */
+
+			void 		CopyTo(X3DTriMesh& mesh) const;
+
+			X3DTriMesh 	CreateMesh() const;
+
+			uint32 		GetNumPoints() const							{return mPoints.size();}
+
+			uint32 		GetNumTriangles() const							{return mTriangles.size();}
+
+			const std::vector<X3DPoint>& GetPoints() const				{return mPoints;}
+
+			const std::vector<TQ3TriMeshTriangleData>& GetTriangles() const	{return mTriangles;}
+
+			bool 		HasVertexAttribute(TQ3AttributeType type) const;
+
+			const void* GetVertexAttribute(TQ3AttributeType type) const;
+						/**< Returns a pointer to the attribute array (eg an array of
+						TQ3Vector3D for normals) or nil if the vertices don't have the
+						attribute. */
+	//@}
+
+	//! @name Welding
+	//@{
+			uint32 		WeldVertices(float tolerance = 0.0f);
+						/**< Vertices are merged if their coordinates are all within tolerance
+						and their attributes are identical. Unused vertices and degenerate
+						triangles are removed. Returns the number of vertices removed. */
+	//@}
+
+	//! @name Normals
+	//@{
+			void 		ComputeSmoothNormals(double creaseAngle = kPi);
+						/**< Vertex normals are the area weighted average of the normals
+						of the triangles that share the vertex. If two of those triangles
+						meet at more than creaseAngle (in radians) the vertex is split so
+						that the edge stays sharp. */
+
+			void 		ComputeFacetedNormals();
+						/**< Each triangle gets its own vertices with the triangle's normal.
+						Call WeldVertices afterwards to re-share vertices between coplanar
+						triangles. */
+	//@}
+
+	//! @name Reordering
+	//@{
+			void 		OptimizeVertexCache(uint32 cacheSize = 32);
+						/**< Reorders the triangles so that vertices are reused while they're
+						in a post-transform cache of the given size. */
+
+			void 		OptimizeVertexFetch();
+						/**< Renumbers the vertices in the order they're first used by the
+						triangles. Unused vertices are removed. */
+
+			double 		GetACMR(uint32 cacheSize = 16) const;
+						/**< Returns the average cache miss ratio for a FIFO post-transform
+						cache with cacheSize entries. This ranges from 0.5 (for a very large
+						regular mesh) to 3.0 (no reuse at all). */
+	//@}
+
+//-----------------------------------
+//	Internal Types
+//
+protected:
+	struct SAttribute {
+		TQ3AttributeType	type;
+		uint32				size;			// number of bytes in each element
+		std::vector<uint8>	data;
+		std::vector<char>	used;			// empty if every element has the attribute
+	};
+
+	typedef std::vector<SAttribute> Attributes;
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		Invariant() const;
+
+			void 		DoGetData(TQ3TriMeshData& data, std::vector<TQ3TriMeshAttributeData>& vertexAttributes, std::vector<TQ3TriMeshAttributeData>& triangleAttributes) const;
+
+			uint32 		DoAppendVertex(uint32 vertex);
+			void 		DoGatherVertices(const std::vector<uint32>& newToOld);
+			void 		DoRemoveUnusedVertices();
+			void 		DoPermuteTriangles(const std::vector<uint32>& order);
+			void 		DoSetNormals(const std::vector<X3DVector>& normals);
+
+			bool 		DoSameAttributes(uint32 lhs, uint32 rhs) const;
+			X3DVector 	DoGetTriangleNormal(uint32 triangle) const;
+
+	static	void 		DoCopyAttributes(Attributes& attributes, const TQ3TriMeshAttributeData* data, uint32 numTypes, uint32 count);
+	static	void 		DoGetAttributes(const Attributes& attributes, std::vector<TQ3TriMeshAttributeData>& data);
+
+//-----------------------------------
+//	Member Data
+//
+protected:
+	std::vector<X3DPoint>				mPoints;
+	std::vector<TQ3TriMeshTriangleData>	mTriangles;
+	Attributes							mVertexAttributes;
+	Attributes							mTriangleAttributes;
+	TQ3AttributeSet						mMeshAttributes;		// may be nil
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
@@ -0,0 +1,597 @@
+/*
+ *  File:       X3DMath.h
+ *  Summary:   	Inlined matrix, point, vector, and quaternion math (using SSE2 if possible).
+ *  Written by: Jesse Jones
+ *
+ *	Abstract:	These functions do the same thing as the corresponding Q3Matrix4x4_*,
+ *				Q3Point3D_*, and Q3Vector3D_* functions but they're inlined so the
+ *				compiler can keep everything in registers and they use SSE2 if
+ *				WHISPER_SSE2 is set. X3DMatrix uses these so the math classes no
+ *				longer pay for a cross library call per vector.
+ *
+ *				Like Quesa, points and vectors are row vectors so v' = v*M and the
+ *				translation lives in the bottom row. Matrices and points are loaded
+ *				with unaligned loads because TQ3Matrix4x4s and TQ3Point3Ds handed
+ *				to us by Quesa (or embedded in other structs) have no alignment
+ *				guarantees. On the processors that have SSE2 an unaligned load of
+ *				aligned data is as fast as an aligned load so matrices that happen
+ *				to be aligned don't lose anything.
+ *
+ *  Copyright  2001 Jesse Jones.
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).
+ *
+ *  Change History (most recent first):
+ *
+ *		$Log: X3DMath.h,v $
+ */
+
+#pragma once
+
+#include <Quesa.h>
+
+#include <XDebug.h>
+
+#if WHISPER_SSE2
+	#include <emmintrin.h>
+#endif
+
+namespace Whisper {
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+#if WHISPER_SSE2
+
+#define WHISPER_SWIZZLE(v, x, y, z, w)	_mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(v), _MM_SHUFFLE(w, z, y, x)))
+#define WHISPER_SHUFFLE(a, b, x, y, z, w)	_mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+
+//---------------------------------------------------------------
+//
+// DoLoad3
+//
+// Loads a point or vector into the low three lanes (the high lane
+// is zero).
+//
+//---------------------------------------------------------------
+inline __m128 DoLoad3(const float* values)
+{
+	__m128 xy = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(values)));
+	__m128 z  = _mm_load_ss(values + 2);
+
+	return _mm_movelh_ps(xy, z);
+}
+
+
+//---------------------------------------------------------------
+//
+// DoStore3
+//
+//---------------------------------------------------------------
+inline void DoStore3(float* values, __m128 v)
+{
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(values), _mm_castps_si128(v));
+	_mm_store_ss(values + 2, _mm_movehl_ps(v, v));
+}
+
+
+//---------------------------------------------------------------
+//
+// DoMat2Mul
+//
+// The 2x2 matrices used by the inverse code are stored row major
+// in one register. Returns lhs*rhs.
+//
+//---------------------------------------------------------------
+inline __m128 DoMat2Mul(__m128 lhs, __m128 rhs)
+{
+	return _mm_add_ps(_mm_mul_ps(lhs, WHISPER_SWIZZLE(rhs, 0, 3, 0, 3)), _mm_mul_ps(WHISPER_SWIZZLE(lhs, 1, 0, 3, 2), WHISPER_SWIZZLE(rhs, 2, 1, 2, 1)));
+}
+
+
+//---------------------------------------------------------------
+//
+// DoMat2AdjMul
+//
+// Returns adjugate(lhs)*rhs.
+//
+//---------------------------------------------------------------
+inline __m128 DoMat2AdjMul(__m128 lhs, __m128 rhs)
+{
+	return _mm_sub_ps(_mm_mul_ps(WHISPER_SWIZZLE(lhs, 3, 3, 0, 0), rhs), _mm_mul_ps(WHISPER_SWIZZLE(lhs, 1, 1, 2, 2), WHISPER_SWIZZLE(rhs, 2, 3, 0, 1)));
+}
+
+
+//---------------------------------------------------------------
+//
+// DoMat2MulAdj
+//
+// Returns lhs*adjugate(rhs).
+//
+//---------------------------------------------------------------
+inline __m128 DoMat2MulAdj(__m128 lhs, __m128 rhs)
+{
+	return _mm_sub_ps(_mm_mul_ps(lhs, WHISPER_SWIZZLE(rhs, 3, 0, 3, 0)), _mm_mul_ps(WHISPER_SWIZZLE(lhs, 1, 0, 3, 2), WHISPER_SWIZZLE(rhs, 2, 1, 2, 1)));
+}
+
+
+//---------------------------------------------------------------
+//
+// DoInvert4x4
+//
+// Inverts the matrix by splitting it into four 2x2 blocks:
+//
+//		M = |A B|		M^-1 = 1/|M| |X Y|
+//			|C D|					 |Z W|
+//
+// where, writing # for the adjugate, X# = |D|A - B(D#C),
+// W# = |A|D - C(A#B), Y# = |B|C - D(A#B)#, Z# = |C|B - A(D#C)#,
+// and |M| = |A||D| + |B||C| - tr((A#B)(D#C)). Returns the
+// determinant. If it's zero the result is garbage.
+//
+//---------------------------------------------------------------
+inline float DoInvert4x4(const TQ3Matrix4x4& matrix, TQ3Matrix4x4* result)
+{
+	__m128 row0 = _mm_loadu_ps(matrix.value[0]);
+	__m128 row1 = _mm_loadu_ps(matrix.value[1]);
+	__m128 row2 = _mm_loadu_ps(matrix.value[2]);
+	__m128 row3 = _mm_loadu_ps(matrix.value[3]);
+
+	__m128 A = _mm_movelh_ps(row0, row1);
+	__m128 B = _mm_movehl_ps(row1, row0);
+	__m128 C = _mm_movelh_ps(row2, row3);
+	__m128 D = _mm_movehl_ps(row3, row2);
+
+	// (|A|, |B|, |C|, |D|)
+	__m128 dets = _mm_sub_ps(_mm_mul_ps(WHISPER_SHUFFLE(row0, row2, 0, 2, 0, 2), WHISPER_SHUFFLE(row1, row3, 1, 3, 1, 3)),
+							 _mm_mul_ps(WHISPER_SHUFFLE(row0, row2, 1, 3, 1, 3), WHISPER_SHUFFLE(row1, row3, 0, 2, 0, 2)));
+	__m128 detA = WHISPER_SWIZZLE(dets, 0, 0, 0, 0);
+	__m128 detB = WHISPER_SWIZZLE(dets, 1, 1, 1, 1);
+	__m128 detC = WHISPER_SWIZZLE(dets, 2, 2, 2, 2);
+	__m128 detD = WHISPER_SWIZZLE(dets, 3, 3, 3, 3);
+
+	__m128 DC = DoMat2AdjMul(D, C);
+	__m128 AB = DoMat2AdjMul(A, B);
+
+	__m128 trace = _mm_mul_ps(AB, WHISPER_SWIZZLE(DC, 0, 2, 1, 3));
+	trace = _mm_add_ps(trace, WHISPER_SWIZZLE(trace, 2, 3, 0, 1));
+	trace = _mm_add_ps(trace, WHISPER_SWIZZLE(trace, 1, 0, 3, 2));
+
+	__m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+
+	if (result != nil) {
+		__m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), DoMat2Mul(B, DC));
+		__m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), DoMat2Mul(C, AB));
+		__m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), DoMat2MulAdj(D, AB));
+		__m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), DoMat2MulAdj(A, DC));
+
+		__m128 scale = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);	// the signs turn the adjugates back into the blocks
+		X = _mm_mul_ps(X, scale);
+		Y = _mm_mul_ps(Y, scale);
+		Z = _mm_mul_ps(Z, scale);
+		W = _mm_mul_ps(W, scale);
+
+		_mm_storeu_ps(result->value[0], WHISPER_SHUFFLE(X, Y, 3, 1, 3, 1));
+		_mm_storeu_ps(result->value[1], WHISPER_SHUFFLE(X, Y, 2, 0, 2, 0));
+		_mm_storeu_ps(result->value[2], WHISPER_SHUFFLE(Z, W, 3, 1, 3, 1));
+		_mm_storeu_ps(result->value[3], WHISPER_SHUFFLE(Z, W, 2, 0, 2, 0));
+	}
+
+	return _mm_cvtss_f32(det);
+}
+
+
+//---------------------------------------------------------------
+//
+// DoTransform4
+//
+// Transforms four points (or vectors) that have been transposed
+// into x, y, and z registers. Each entry in m is one matrix element
+// broadcast to all four lanes.
+//
+//---------------------------------------------------------------
+inline void DoTransform4(const __m128 m[4][4], __m128& x, __m128& y, __m128& z, bool translate, bool project)
+{
+	__m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][0]), _mm_mul_ps(y, m[1][0])), _mm_mul_ps(z, m[2][0]));
+	__m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][1]), _mm_mul_ps(y, m[1][1])), _mm_mul_ps(z, m[2][1]));
+	__m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][2]), _mm_mul_ps(y, m[1][2])), _mm_mul_ps(z, m[2][2]));
+
+	if (translate) {
+		rx = _mm_add_ps(rx, m[3][0]);
+		ry = _mm_add_ps(ry, m[3][1]);
+		rz = _mm_add_ps(rz, m[3][2]);
+	}
+
+	if (project) {
+		__m128 w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][3]), _mm_mul_ps(y, m[1][3])), _mm_add_ps(_mm_mul_ps(z, m[2][3]), m[3][3]));
+		rx = _mm_div_ps(rx, w);
+		ry = _mm_div_ps(ry, w);
+		rz = _mm_div_ps(rz, w);
+	}
+
+	x = rx;
+	y = ry;
+	z = rz;
+}
+
+
+//---------------------------------------------------------------
+//
+// DoTransformArray
+//
+// Four points at a time are loaded as three registers, transposed
+// into x, y, and z registers, transformed, and transposed back.
+//
+//---------------------------------------------------------------
+inline void DoTransformArray(const TQ3Matrix4x4& matrix, const float* src, float* dst, uint32 count, bool translate)
+{
+	bool project = translate && (matrix.value[0][3] != 0.0f || matrix.value[1][3] != 0.0f || matrix.value[2][3] != 0.0f || matrix.value[3][3] != 1.0f);
+
+	__m128 m[4][4];
+	for (int i = 0; i < 4; ++i)
+		for (int j = 0; j < 4; ++j)
+			m[i][j] = _mm_set1_ps(matrix.value[i][j]);
+
+	uint32 i = 0;
+	for (; i + 4 <= count; i += 4, src += 12, dst += 12) {
+		__m128 a = _mm_loadu_ps(src);					// x0 y0 z0 x1
+		__m128 b = _mm_loadu_ps(src + 4);				// y1 z1 x2 y2
+		__m128 c = _mm_loadu_ps(src + 8);				// z2 x3 y3 z3
+
+		__m128 x = WHISPER_SHUFFLE(a, WHISPER_SHUFFLE(b, c, 2, 2, 1, 1), 0, 3, 0, 2);
+		__m128 y = WHISPER_SHUFFLE(WHISPER_SHUFFLE(a, b, 1, 1, 0, 0), WHISPER_SHUFFLE(b, c, 3, 3, 2, 2), 0, 2, 0, 2);
+		__m128 z = WHISPER_SHUFFLE(WHISPER_SHUFFLE(a, b, 2, 2, 1, 1), WHISPER_SHUFFLE(c, c, 0, 0, 3, 3), 0, 2, 0, 2);
+
+		DoTransform4(m, x, y, z, translate, project);
+
+		__m128 xyLo = _mm_unpacklo_ps(x, y);			// x0 y0 x1 y1
+		__m128 xyHi = _mm_unpackhi_ps(x, y);			// x2 y2 x3 y3
+
+		_mm_storeu_ps(dst,     WHISPER_SHUFFLE(xyLo, WHISPER_SHUFFLE(z, x, 0, 0, 1, 1), 0, 1, 0, 2));
+		_mm_storeu_ps(dst + 4, WHISPER_SHUFFLE(WHISPER_SHUFFLE(y, z, 1, 1, 1, 1), xyHi, 0, 2, 0, 1));
+		_mm_storeu_ps(dst + 8, WHISPER_SHUFFLE(WHISPER_SHUFFLE(z, x, 2, 2, 3, 3), WHISPER_SHUFFLE(y, z, 3, 3, 3, 3), 0, 2, 0, 2));
+	}
+
+	for (; i < count; ++i, src += 3, dst += 3) {
+		__m128 v = DoLoad3(src);
+		__m128 x = WHISPER_SWIZZLE(v, 0, 0, 0, 0);
+		__m128 y = WHISPER_SWIZZLE(v, 1, 1, 1, 1);
+		__m128 z = WHISPER_SWIZZLE(v, 2, 2, 2, 2);
+
+		DoTransform4(m, x, y, z, translate, project);
+
+		DoStore3(dst, _mm_movelh_ps(_mm_unpacklo_ps(x, y), z));
+	}
+}
+
+#else
+
+//---------------------------------------------------------------
+//
+// DoDeterminant3x3
+//
+//---------------------------------------------------------------
+inline float DoDeterminant3x3(float a, float b, float c, float d, float e, float f, float g, float h, float i)
+{
+	return a*(e*i - f*h) - b*(d*i - f*g) + c*(d*h - e*g);
+}
+
+
+//---------------------------------------------------------------
+//
+// DoInvert4x4
+//
+// Inverts using the adjugate. Returns the determinant. If it's
+// zero the result is garbage.
+//
+//---------------------------------------------------------------
+inline float DoInvert4x4(const TQ3Matrix4x4& matrix, TQ3Matrix4x4* result)
+{
+	const float (*m)[4] = matrix.value;
+
+	float cofactors[4][4];
+	for (int i = 0; i < 4; ++i) {
+		int r0 = i == 0 ? 1 : 0, r1 = i <= 1 ? 2 : 1, r2 = i <= 2 ? 3 : 2;
+
+		for (int j = 0; j < 4; ++j) {
+			int c0 = j == 0 ? 1 : 0, c1 = j <= 1 ? 2 : 1, c2 = j <= 2 ? 3 : 2;
+
+			float minor = DoDeterminant3x3(m[r0][c0], m[r0][c1], m[r0][c2],
+										   m[r1][c0], m[r1][c1], m[r1][c2],
+										   m[r2][c0], m[r2][c1], m[r2][c2]);
+			cofactors[i][j] = (i + j) & 1 ? -minor : minor;
+		}
+	}
+
+	float det = m[0][0]*cofactors[0][0] + m[0][1]*cofactors[0][1] + m[0][2]*cofactors[0][2] + m[0][3]*cofactors[0][3];
+
+	if (result != nil) {
+		float scale = 1.0f/det;
+		for (int i = 0; i < 4; ++i)
+			for (int j = 0; j < 4; ++j)
+				result->value[i][j] = scale*cofactors[j][i];
+	}
+
+	return det;
+}
+
+#endif	// WHISPER_SSE2
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	Matrix Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// Multiply4x4
+//
+// Result = lhs*rhs. Result may alias lhs or rhs.
+//
+//---------------------------------------------------------------
+inline void Multiply4x4(const TQ3Matrix4x4& lhs, const TQ3Matrix4x4& rhs, TQ3Matrix4x4& result)
+{
+#if WHISPER_SSE2
+	__m128 row0 = _mm_loadu_ps(rhs.value[0]);
+	__m128 row1 = _mm_loadu_ps(rhs.value[1]);
+	__m128 row2 = _mm_loadu_ps(rhs.value[2]);
+	__m128 row3 = _mm_loadu_ps(rhs.value[3]);
+
+	for (int i = 0; i < 4; ++i) {
+		__m128 row = _mm_loadu_ps(lhs.value[i]);
+
+		__m128 sum = _mm_add_ps(_mm_mul_ps(WHISPER_SWIZZLE(row, 0, 0, 0, 0), row0), _mm_mul_ps(WHISPER_SWIZZLE(row, 1, 1, 1, 1), row1));
+		sum = _mm_add_ps(sum, _mm_add_ps(_mm_mul_ps(WHISPER_SWIZZLE(row, 2, 2, 2, 2), row2), _mm_mul_ps(WHISPER_SWIZZLE(row, 3, 3, 3, 3), row3)));
+
+		_mm_storeu_ps(result.value[i], sum);
+	}
+
+#else
+	TQ3Matrix4x4 temp;
+	for (int i = 0; i < 4; ++i)
+		for (int j = 0; j < 4; ++j)
+			temp.value[i][j] = lhs.value[i][0]*rhs.value[0][j] + lhs.value[i][1]*rhs.value[1][j] + lhs.value[i][2]*rhs.value[2][j] + lhs.value[i][3]*rhs.value[3][j];
+
+	result = temp;
+#endif
+}
+
+
+//---------------------------------------------------------------
+//
+// Transpose4x4
+//
+// Result may alias matrix.
+//
+//---------------------------------------------------------------
+inline void Transpose4x4(const TQ3Matrix4x4& matrix, TQ3Matrix4x4& result)
+{
+#if WHISPER_SSE2
+	__m128 row0 = _mm_loadu_ps(matrix.value[0]);
+	__m128 row1 = _mm_loadu_ps(matrix.value[1]);
+	__m128 row2 = _mm_loadu_ps(matrix.value[2]);
+	__m128 row3 = _mm_loadu_ps(matrix.value[3]);
+
+	_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+	_mm_storeu_ps(result.value[0], row0);
+	_mm_storeu_ps(result.value[1], row1);
+	_mm_storeu_ps(result.value[2], row2);
+	_mm_storeu_ps(result.value[3], row3);
+
+#else
+	TQ3Matrix4x4 temp;
+	for (int i = 0; i < 4; ++i)
+		for (int j = 0; j < 4; ++j)
+			temp.value[i][j] = matrix.value[j][i];
+
+	result = temp;
+#endif
+}
+
+
+//---------------------------------------------------------------
+//
+// Invert4x4
+//
+// Returns the determinant. If it's zero the result is garbage so
+// callers should check (X3DMatrix's Invert does so in debug builds).
+// Result may alias matrix.
+//
+//---------------------------------------------------------------
+inline float Invert4x4(const TQ3Matrix4x4& matrix, TQ3Matrix4x4& result)
+{
+	return DoInvert4x4(matrix, &result);
+}
+
+
+//---------------------------------------------------------------
+//
+// Determinant4x4
+//
+//---------------------------------------------------------------
+inline float Determinant4x4(const TQ3Matrix4x4& matrix)
+{
+	return DoInvert4x4(matrix, nil);
+}
+
+
+//---------------------------------------------------------------
+//
+// QuaternionTo4x4
+//
+// Same as Q3Matrix4x4_SetQuaternion: the quaternion should be
+// normalized.
+//
+//---------------------------------------------------------------
+inline void QuaternionTo4x4(const TQ3Quaternion& q, TQ3Matrix4x4& result)
+{
+	float xx = q.x*q.x, yy = q.y*q.y, zz = q.z*q.z;
+	float xy = q.x*q.y, xz = q.x*q.z, yz = q.y*q.z;
+	float wx = q.w*q.x, wy = q.w*q.y, wz = q.w*q.z;
+
+	result.value[0][0] = 1.0f - 2.0f*(yy + zz);
+	result.value[0][1] = 2.0f*(xy + wz);
+	result.value[0][2] = 2.0f*(xz - wy);
+	result.value[0][3] = 0.0f;
+
+	result.value[1][0] = 2.0f*(xy - wz);
+	result.value[1][1] = 1.0f - 2.0f*(xx + zz);
+	result.value[1][2] = 2.0f*(yz + wx);
+	result.value[1][3] = 0.0f;
+
+	result.value[2][0] = 2.0f*(xz + wy);
+	result.value[2][1] = 2.0f*(yz - wx);
+	result.value[2][2] = 1.0f - 2.0f*(xx + yy);
+	result.value[2][3] = 0.0f;
+
+	result.value[3][0] = 0.0f;
+	result.value[3][1] = 0.0f;
+	result.value[3][2] = 0.0f;
+	result.value[3][3] = 1.0f;
+}
+
+
+//---------------------------------------------------------------
+//
+// MultiplyQuaternion
+//
+// Result = lhs*rhs (the Hamilton product) which rotates by rhs and
+// then by lhs. Result may alias lhs or rhs.
+//
+//---------------------------------------------------------------
+inline void MultiplyQuaternion(const TQ3Quaternion& lhs, const TQ3Quaternion& rhs, TQ3Quaternion& result)
+{
+	float w = lhs.w*rhs.w - lhs.x*rhs.x - lhs.y*rhs.y - lhs.z*rhs.z;
+	float x = lhs.w*rhs.x + lhs.x*rhs.w + lhs.y*rhs.z - lhs.z*rhs.y;
+	float y = lhs.w*rhs.y - lhs.x*rhs.z + lhs.y*rhs.w + lhs.z*rhs.x;
+	float z = lhs.w*rhs.z + lhs.x*rhs.y - lhs.y*rhs.x + lhs.z*rhs.w;
+
+	result.w = w;
+	result.x = x;
+	result.y = y;
+	result.z = z;
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	Transform Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// TransformPoint3D
+//
+// Same as Q3Point3D_Transform: the point is extended with w = 1,
+// multiplied by the matrix, and divided by the resulting w.
+//
+//---------------------------------------------------------------
+inline void TransformPoint3D(const TQ3Point3D& point, const TQ3Matrix4x4& m, TQ3Point3D& result)
+{
+#if WHISPER_SSE2
+	__m128 sum = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(point.x), _mm_loadu_ps(m.value[0])), _mm_mul_ps(_mm_set1_ps(point.y), _mm_loadu_ps(m.value[1])));
+	sum = _mm_add_ps(sum, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(point.z), _mm_loadu_ps(m.value[2])), _mm_loadu_ps(m.value[3])));
+
+	__m128 w = WHISPER_SWIZZLE(sum, 3, 3, 3, 3);
+	ASSERT(_mm_cvtss_f32(w) != 0.0f);
+
+	DoStore3(&result.x, _mm_div_ps(sum, w));
+
+#else
+	float x = point.x*m.value[0][0] + point.y*m.value[1][0] + point.z*m.value[2][0] + m.value[3][0];
+	float y = point.x*m.value[0][1] + point.y*m.value[1][1] + point.z*m.value[2][1] + m.value[3][1];
+	float z = point.x*m.value[0][2] + point.y*m.value[1][2] + point.z*m.value[2][2] + m.value[3][2];
+	float w = point.x*m.value[0][3] + point.y*m.value[1][3] + point.z*m.value[2][3] + m.value[3][3];
+	ASSERT(w != 0.0f);
+
+	result.x = x/w;
+	result.y = y/w;
+	result.z = z/w;
+#endif
+}
+
+
+//---------------------------------------------------------------
+//
+// TransformVector3D
+//
+// Same as Q3Vector3D_Transform: only the upper 3x3 part of the
+// matrix is used.
+//
+//---------------------------------------------------------------
+inline void TransformVector3D(const TQ3Vector3D& vector, const TQ3Matrix4x4& m, TQ3Vector3D& result)
+{
+#if WHISPER_SSE2
+	__m128 sum = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(vector.x), _mm_loadu_ps(m.value[0])), _mm_mul_ps(_mm_set1_ps(vector.y), _mm_loadu_ps(m.value[1])));
+	sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(vector.z), _mm_loadu_ps(m.value[2])));
+
+	DoStore3(&result.x, sum);
+
+#else
+	float x = vector.x*m.value[0][0] + vector.y*m.value[1][0] + vector.z*m.value[2][0];
+	float y = vector.x*m.value[0][1] + vector.y*m.value[1][1] + vector.z*m.value[2][1];
+	float z = vector.x*m.value[0][2] + vector.y*m.value[1][2] + vector.z*m.value[2][2];
+
+	result.x = x;
+	result.y = y;
+	result.z = z;
+#endif
+}
+
+
+//---------------------------------------------------------------
+//
+// TransformPoints3D
+//
+// Transforms count points. If the last column of the matrix is
+// (0, 0, 0, 1), which is the case for everything except projections,
+// the divide by w is skipped. Src and dst may be the same array.
+//
+//---------------------------------------------------------------
+inline void TransformPoints3D(const TQ3Point3D* src, TQ3Point3D* dst, uint32 count, const TQ3Matrix4x4& m)
+{
+	PRECONDITION(count == 0 || (src != nil && dst != nil));
+
+#if WHISPER_SSE2
+	DoTransformArray(m, &src->x, &dst->x, count, true);
+
+#else
+	for (uint32 i = 0; i < count; ++i)
+		TransformPoint3D(src[i], m, dst[i]);
+#endif
+}
+
+
+//---------------------------------------------------------------
+//
+// TransformVectors3D
+//
+// Src and dst may be the same array.
+//
+//---------------------------------------------------------------
+inline void TransformVectors3D(const TQ3Vector3D* src, TQ3Vector3D* dst, uint32 count, const TQ3Matrix4x4& m)
+{
+	PRECONDITION(count == 0 || (src != nil && dst != nil));
+
+#if WHISPER_SSE2
+	DoTransformArray(m, &src->x, &dst->x, count, false);
+
+#else
+	for (uint32 i = 0; i < count; ++i)
+		TransformVector3D(src[i], m, dst[i]);
+#endif
+}
+
+#if WHISPER_SSE2
+	#undef WHISPER_SWIZZLE
+	#undef WHISPER_SHUFFLE
+#endif
+
+
+}	// namespace Whisper
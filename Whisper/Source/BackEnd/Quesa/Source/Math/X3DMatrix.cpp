@@ -200,21 +200,6 @@ X3DMatrix X3DMatrix::operator-(const X3DMatrix& rhs) const
 }
 
 
-//---------------------------------------------------------------
-//
-// X3DMatrix::operator*
-//
-//---------------------------------------------------------------
-X3DMatrix X3DMatrix::operator*(const X3DMatrix& rhs) const
-{
-	X3DMatrix temp;
-	
-	::Q3Matrix4x4_Multiply(*this, rhs, temp);
-			
-	return temp;
-}
-
-
 //---------------------------------------------------------------
 //
 // X3DMatrix::operator+=
@@ -245,18 +230,6 @@ X3DMatrix& X3DMatrix::operator-=(const X3DMatrix& rhs)
 }
 
 
-//---------------------------------------------------------------
-//
-// X3DMatrix::operator*=
-//
-//---------------------------------------------------------------
-X3DMatrix& X3DMatrix::operator*=(const X3DMatrix& rhs)
-{
-	::Q3Matrix4x4_Multiply(*this, rhs, *this);
-			
-	return *this;
-}
-
 #pragma mark 
 
 //---------------------------------------------------------------
@@ -276,83 +249,6 @@ X3DMatrix operator*(float alpha, const X3DMatrix& rhs)
 }
 
 
-//---------------------------------------------------------------
-//
-// operator* (X3DVector, X3DMatrix)
-//
-//---------------------------------------------------------------
-X3DVector operator*(const X3DVector& lhs, const X3DMatrix& rhs)
-{
-	X3DVector temp;
-	
-	::Q3Vector3D_Transform(lhs, rhs, temp);
-
-	return temp;
-}
-
-
-//---------------------------------------------------------------
-//
-// operator* (X3DPoint, X3DMatrix)
-//
-//---------------------------------------------------------------
-X3DPoint operator*(const X3DPoint& lhs, const X3DMatrix& rhs)
-{
-	X3DPoint temp;
-	
-	::Q3Point3D_Transform(lhs, rhs, temp);
-
-	return temp;
-}
-
-
-//---------------------------------------------------------------
-//
-// Transpose
-//
-//---------------------------------------------------------------
-X3DMatrix Transpose(const X3DMatrix& rhs)
-{
-	X3DMatrix temp;
-	
-	for (int i = 0; i < 4; i++)
-		for (int j = 0; j < 4; j++)
-			temp.value[i][j] = rhs.value[j][i];
-			
-	return temp;
-}
-
-
-//---------------------------------------------------------------
-//
-// Invert
-//
-//---------------------------------------------------------------
-X3DMatrix Invert(const X3DMatrix& rhs)
-{
-	PRECONDITION(Abs(Determinant(rhs)) > 1.0e-6);		// matrices are only invertible if determinant is non-zero
-	
-	X3DMatrix temp;
-	
-	Q3Matrix4x4_Invert(rhs, temp);
-	
-	return temp;
-}
-
-
-//---------------------------------------------------------------
-//
-// Determinant
-//
-//---------------------------------------------------------------
-float Determinant(const X3DMatrix& rhs)
-{
-	float det = Q3Matrix4x4_Determinant(rhs);
-	
-	return det;
-}
-
-
 //---------------------------------------------------------------
 //
 // Equal (X3DMatrix, X3DMatrix, double)
@@ -21,9 +21,11 @@
 
 #pragma once
 
+#include <cmath>
 #include <Quesa.h>
 #include <QuesaMath.h>
 
+#include <X3DMath.h>
 #include <X3DPrimitives.h>
 #include <X3DVectors.h>
 
@@ -53,6 +55,8 @@ extern QUESA_EXPORT const X3DMatrix kIdentity3DMatrix;
 //		Note that these matrices use homogeneous coordinates: an extra dimension has
 //		been added so that translations can be expressed in matrix form. When multiplying
 //		a 3D vector or point to a matrix a fourth coordinate with value 1.0 is assumed.
+//		The multiplies, inverse, and transforms are inlined (see X3DMath.h) so they don't
+//		call into Quesa.
 // ===================================================================================
 class QUESA_EXPORT X3DMatrix : public TQ3Matrix4x4 {
 
@@ -97,6 +101,12 @@ public:
 	friend	X3DVector	operator*(const X3DVector& lhs, const X3DMatrix& rhs);
 	friend	X3DPoint	operator*(const X3DPoint& lhs, const X3DMatrix& rhs);
 						/**< Transforms the vector or point by the given matrix. */
+
+	friend	void		Transform(const X3DVector* vectors, X3DVector* result, uint32 count, const X3DMatrix& matrix);
+	friend	void		Transform(const X3DPoint* points, X3DPoint* result, uint32 count, const X3DMatrix& matrix);
+						/**< Transforms an array of vectors or points. This is a good
+						deal faster than transforming them one at a time. Result may
+						be the same array as the input. */
 	//@}
 
 	//! @name Matrix Arithmetic
@@ -147,7 +157,7 @@ public:
 			void 		SetRotateVectorToVector(const X3DVector& v1, const X3DVector& v2)	{Q3Matrix4x4_SetRotateVectorToVector(*this, v1, v2);}
 						/**< Sets 'this' so that v1*this == v2. */
 
-			void 		SetQuaternion(const TQ3Quaternion& quaternion)					{Q3Matrix4x4_SetQuaternion(*this, &quaternion);}
+			void 		SetQuaternion(const TQ3Quaternion& quaternion)					{QuaternionTo4x4(quaternion, *this);}
 	//@}
 
 	//! @name Comparisons
@@ -164,6 +174,74 @@ public:
 };
 
 
+// ===================================================================================
+//	Inlines
+// ===================================================================================
+
+inline X3DMatrix X3DMatrix::operator*(const X3DMatrix& rhs) const
+{
+	X3DMatrix temp;
+	Multiply4x4(*this, rhs, temp);
+			
+	return temp;
+}
+
+inline X3DMatrix& X3DMatrix::operator*=(const X3DMatrix& rhs)
+{
+	Multiply4x4(*this, rhs, *this);
+			
+	return *this;
+}
+
+inline X3DVector operator*(const X3DVector& lhs, const X3DMatrix& rhs)
+{
+	X3DVector temp;
+	TransformVector3D(*static_cast<const TQ3Vector3D*>(lhs), rhs, *static_cast<TQ3Vector3D*>(temp));
+
+	return temp;
+}
+
+inline X3DPoint operator*(const X3DPoint& lhs, const X3DMatrix& rhs)
+{
+	X3DPoint temp;
+	TransformPoint3D(*static_cast<const TQ3Point3D*>(lhs), rhs, *static_cast<TQ3Point3D*>(temp));
+
+	return temp;
+}
+
+inline void Transform(const X3DVector* vectors, X3DVector* result, uint32 count, const X3DMatrix& matrix)
+{
+	TransformVectors3D(reinterpret_cast<const TQ3Vector3D*>(vectors), reinterpret_cast<TQ3Vector3D*>(result), count, matrix);
+}
+
+inline void Transform(const X3DPoint* points, X3DPoint* result, uint32 count, const X3DMatrix& matrix)
+{
+	TransformPoints3D(reinterpret_cast<const TQ3Point3D*>(points), reinterpret_cast<TQ3Point3D*>(result), count, matrix);
+}
+
+inline X3DMatrix Transpose(const X3DMatrix& rhs)
+{
+	X3DMatrix temp;
+	Transpose4x4(rhs, temp);
+			
+	return temp;
+}
+
+inline X3DMatrix Invert(const X3DMatrix& rhs)
+{
+	X3DMatrix temp;
+	float det = Invert4x4(rhs, temp);
+	ASSERT(std::fabs(det) > 1.0e-6);		// matrices are only invertible if determinant is non-zero
+	
+	return temp;
+}
+
+inline float Determinant(const X3DMatrix& rhs)
+{
+	return Determinant4x4(rhs);
+}
+
+
 #if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
 	#pragma export reset
 #endif
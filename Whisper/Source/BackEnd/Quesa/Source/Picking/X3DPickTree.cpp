@@ -0,0 +1,1096 @@
+/*
+ *  File:       X3DPickTree.cpp
+ *  Summary:   	Software picking using a bounding volume hierarchy over triangles.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: X3DPickTree.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <X3DPickTree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <QuesaCustomElements.h>
+#include <QuesaGroup.h>
+#include <QuesaSet.h>
+#include <QuesaStyle.h>
+#include <QuesaTransform.h>
+
+#include <X3DCamera.h>
+#include <X3DGroup.h>
+#include <X3DTriGrid.h>
+#include <X3DTriMesh.h>
+#include <X3DUtils.h>
+#include <XDebug.h>
+#include <XExceptions.h>
+#include <XNumbers.h>
+
+namespace Whisper {
+
+
+//-----------------------------------
+//	Internal Constants
+//
+const uint32 kLeafSize   = 4;			// nodes with this many triangles or fewer aren't split
+const uint32 kNumBins    = 16;			// number of buckets used when evaluating the SAH
+const uint32 kMaxSAHDepth = 64;			// below this we switch to median splits so the depth is bounded
+const uint32 kStackSize  = 128;
+
+const float kInfinity = std::numeric_limits<float>::max();
+
+
+//-----------------------------------
+//	Internal Types
+//
+struct SBounds {
+	float	min[3];
+	float	max[3];
+
+			SBounds()								{min[0] = min[1] = min[2] = kInfinity; max[0] = max[1] = max[2] = -kInfinity;}
+
+	void 	Add(const X3DPoint& pt)					{this->Add(pt.x, 0); this->Add(pt.y, 1); this->Add(pt.z, 2);}
+	void 	Add(const SBounds& rhs)					{for (int i = 0; i < 3; ++i) {this->Add(rhs.min[i], i); this->Add(rhs.max[i], i);}}
+	void 	Add(float value, int axis)				{if (value < min[axis]) min[axis] = value; if (value > max[axis]) max[axis] = value;}
+
+	float 	GetArea() const							{float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2]; return dx < 0.0f ? 0.0f : dx*dy + dy*dz + dz*dx;}
+};
+
+struct SBin {
+	SBounds	bounds;
+	uint32	count;
+
+			SBin() : count(0)						{}
+};
+
+struct SCompareCentroids {
+			SCompareCentroids(const std::vector<X3DPoint>& centroids, int axis) : mCentroids(centroids), mAxis(axis) {}
+
+	bool 	operator()(uint32 lhs, uint32 rhs) const	{return (&mCentroids[lhs].x)[mAxis] < (&mCentroids[rhs].x)[mAxis];}
+
+	const std::vector<X3DPoint>&	mCentroids;
+	int								mAxis;
+};
+
+struct SInLeftBins {
+			SInLeftBins(const std::vector<X3DPoint>& centroids, int axis, float min, float scale, uint32 split) : mCentroids(centroids), mAxis(axis), mMin(min), mScale(scale), mSplit(split) {}
+
+	bool 	operator()(uint32 index) const;
+
+	const std::vector<X3DPoint>&	mCentroids;
+	int								mAxis;
+	float							mMin;
+	float							mScale;
+	uint32							mSplit;
+};
+
+struct SCompareDistance {
+	template <class T>
+	bool 	operator()(const T& lhs, const T& rhs) const	{return lhs.distance < rhs.distance;}
+};
+
+struct SStackEntry {
+	uint32	node;
+	float	distance;						// where the ray enters the node
+};
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// GetBin
+//
+//---------------------------------------------------------------
+inline uint32 GetBin(float value, float min, float scale)
+{
+	int32 bin = (int32) ((value - min)*scale);
+
+	return (uint32) MinMax(0L, bin, (int32) kNumBins - 1);
+}
+
+
+//---------------------------------------------------------------
+//
+// SInLeftBins::operator()
+//
+//---------------------------------------------------------------
+bool SInLeftBins::operator()(uint32 index) const
+{
+	float value = (&mCentroids[index].x)[mAxis];
+
+	return GetBin(value, mMin, mScale) <= mSplit;
+}
+
+
+//---------------------------------------------------------------
+//
+// HitBox
+//
+// Slab test. If the ray enters the box before maxDistance the
+// entry distance is returned via distance.
+//
+//---------------------------------------------------------------
+inline bool HitBox(const float* min, const float* max, const float* origin, const float* invDirection, float maxDistance, float& distance)
+{
+	float t0 = 0.0f;
+	float t1 = maxDistance;
+
+	for (int axis = 0; axis < 3; ++axis) {
+		float tNear = (min[axis] - origin[axis])*invDirection[axis];
+		float tFar  = (max[axis] - origin[axis])*invDirection[axis];
+		if (tNear > tFar)
+			std::swap(tNear, tFar);
+
+		if (tNear > t0)
+			t0 = tNear;
+		if (tFar < t1)
+			t1 = tFar;
+
+		if (t0 > t1)
+			return false;
+	}
+
+	distance = t0;
+
+	return true;
+}
+
+
+//---------------------------------------------------------------
+//
+// HitTriangle
+//
+// Moller-Trumbore ray/triangle test. Both sides of the triangle
+// are hit (like Quesa's pick objects).
+//
+//---------------------------------------------------------------
+inline bool HitTriangle(const X3DPoint& pt0, const X3DPoint& pt1, const X3DPoint& pt2, const float* origin, const float* direction, float maxDistance, float& distance, float& u, float& v)
+{
+	float e1[3] = {pt1.x - pt0.x, pt1.y - pt0.y, pt1.z - pt0.z};
+	float e2[3] = {pt2.x - pt0.x, pt2.y - pt0.y, pt2.z - pt0.z};
+
+	float p[3] = {direction[1]*e2[2] - direction[2]*e2[1], direction[2]*e2[0] - direction[0]*e2[2], direction[0]*e2[1] - direction[1]*e2[0]};
+	float det = e1[0]*p[0] + e1[1]*p[1] + e1[2]*p[2];
+	if (det == 0.0f)
+		return false;							// ray is parallel to the triangle (or the triangle is degenerate)
+
+	float invDet = 1.0f/det;
+
+	float t[3] = {origin[0] - pt0.x, origin[1] - pt0.y, origin[2] - pt0.z};
+	u = (t[0]*p[0] + t[1]*p[1] + t[2]*p[2])*invDet;
+	if (u < 0.0f || u > 1.0f)
+		return false;
+
+	float q[3] = {t[1]*e1[2] - t[2]*e1[1], t[2]*e1[0] - t[0]*e1[2], t[0]*e1[1] - t[1]*e1[0]};
+	v = (direction[0]*q[0] + direction[1]*q[1] + direction[2]*q[2])*invDet;
+	if (v < 0.0f || u + v > 1.0f)
+		return false;
+
+	distance = (e2[0]*q[0] + e2[1]*q[1] + e2[2]*q[2])*invDet;
+
+	return distance >= 0.0f && distance < maxDistance;
+}
+
+
+//---------------------------------------------------------------
+//
+// GetVertexAttribute
+//
+//---------------------------------------------------------------
+static bool GetVertexAttribute(TQ3AttributeSet attributes, TQ3AttributeType type, void* data)
+{
+	bool found = false;
+
+	if (attributes != nil && Q3AttributeSet_Contains(attributes, type)) {
+		TQ3Status status = Q3AttributeSet_Get(attributes, type, data);
+		ThrowIf3DError(status);
+
+		found = true;
+	}
+
+	return found;
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class X3DPickTree
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::~X3DPickTree
+//
+//---------------------------------------------------------------
+X3DPickTree::~X3DPickTree()
+{
+	this->RemoveAll();
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::X3DPickTree
+//
+//---------------------------------------------------------------
+X3DPickTree::X3DPickTree()
+{
+	mBuilt = false;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::AddTriMesh
+//
+//---------------------------------------------------------------
+uint32 X3DPickTree::AddTriMesh(const X3DTriMesh& mesh, const X3DMatrix& localToWorld, uint32 pickID)
+{
+	TQ3TriMeshData data = mesh.GetData();
+
+	uint32 index = 0;
+	try {
+		index = this->DoAddInstance(localToWorld, pickID, data.numPoints);
+		SInstance& instance = mInstances.back();
+
+		for (uint32 i = 0; i < data.numPoints; ++i)
+			mLocalPoints[instance.firstPoint + i] = data.points[i];
+
+		for (uint32 j = 0; j < data.numVertexAttributeTypes; ++j) {
+			const TQ3TriMeshAttributeData& attribute = data.vertexAttributeTypes[j];
+			const char* used = attribute.attributeUseArray;		// if present only vertices with non-zero entries have the attribute
+
+			if (attribute.attributeType == kQ3AttributeTypeNormal) {
+				const TQ3Vector3D* normals = static_cast<const TQ3Vector3D*>(attribute.data);
+				for (uint32 i = 0; i < data.numPoints; ++i)
+					if (used == nil || used[i] != 0)
+						mNormals[instance.firstPoint + i] = normals[i];
+				instance.hasNormals = true;
+
+			} else if ((attribute.attributeType == kQ3AttributeTypeSurfaceUV || attribute.attributeType == kQ3AttributeTypeShadingUV) && !instance.hasUVs) {
+				const TQ3Param2D* uvs = static_cast<const TQ3Param2D*>(attribute.data);
+				for (uint32 i = 0; i < data.numPoints; ++i)
+					if (used == nil || used[i] != 0)
+						mUVs[instance.firstPoint + i] = uvs[i];
+				instance.hasUVs = true;
+			}
+		}
+
+		mTriangles.reserve(mTriangles.size() + data.numTriangles);
+		for (uint32 i = 0; i < data.numTriangles; ++i) {
+			STriangle triangle;
+			triangle.points[0] = instance.firstPoint + data.triangles[i].pointIndices[0];
+			triangle.points[1] = instance.firstPoint + data.triangles[i].pointIndices[1];
+			triangle.points[2] = instance.firstPoint + data.triangles[i].pointIndices[2];
+			triangle.instance  = index;
+			triangle.index     = i;
+			mTriangles.push_back(triangle);
+		}
+
+		this->DoTransformInstance(instance);
+
+		instance.geometry = Q3Shared_GetReference(mesh);
+
+	} catch (...) {
+		Q3TriMesh_EmptyData(&data);
+		throw;
+	}
+
+	Q3TriMesh_EmptyData(&data);
+
+	return index;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::AddTriGrid
+//
+// Each quad is split into two triangles with the diagonal
+// alternating like a checkerboard. Triangle indices match the
+// facet indices: quad (row, col) has facets 2*(row*(numColumns - 1)
+// + col) and the one after it.
+//
+//---------------------------------------------------------------
+uint32 X3DPickTree::AddTriGrid(const X3DTriGrid& grid, const X3DMatrix& localToWorld, uint32 pickID)
+{
+	TQ3TriGridData data = grid.GetData();
+
+	uint32 index = 0;
+	try {
+		uint32 numPoints = data.numRows*data.numColumns;
+
+		index = this->DoAddInstance(localToWorld, pickID, numPoints);
+		SInstance& instance = mInstances.back();
+
+		for (uint32 i = 0; i < numPoints; ++i) {
+			uint32 pt = instance.firstPoint + i;
+			mLocalPoints[pt] = data.vertices[i].point;
+
+			TQ3Vector3D normal;
+			if (GetVertexAttribute(data.vertices[i].attributeSet, kQ3AttributeTypeNormal, &normal)) {
+				mNormals[pt] = normal;
+				instance.hasNormals = true;
+			}
+
+			TQ3Param2D uv;
+			if (GetVertexAttribute(data.vertices[i].attributeSet, kQ3AttributeTypeSurfaceUV, &uv) || GetVertexAttribute(data.vertices[i].attributeSet, kQ3AttributeTypeShadingUV, &uv)) {
+				mUVs[pt] = uv;
+				instance.hasUVs = true;
+			}
+		}
+
+		if (data.numRows > 1 && data.numColumns > 1) {
+			mTriangles.reserve(mTriangles.size() + 2*(data.numRows - 1)*(data.numColumns - 1));
+
+			uint32 facet = 0;
+			for (uint32 row = 0; row + 1 < data.numRows; ++row) {
+				for (uint32 col = 0; col + 1 < data.numColumns; ++col) {
+					uint32 topLeft     = instance.firstPoint + row*data.numColumns + col;
+					uint32 topRight    = topLeft + 1;
+					uint32 bottomLeft  = topLeft + data.numColumns;
+					uint32 bottomRight = bottomLeft + 1;
+
+					STriangle first, second;
+					if (((row + col) & 1) == 0) {
+						first.points[0] = topLeft;  first.points[1] = bottomLeft;  first.points[2] = topRight;
+						second.points[0] = topRight; second.points[1] = bottomLeft; second.points[2] = bottomRight;
+					} else {
+						first.points[0] = topLeft;  first.points[1] = bottomLeft;  first.points[2] = bottomRight;
+						second.points[0] = topLeft; second.points[1] = bottomRight; second.points[2] = topRight;
+					}
+
+					first.instance = second.instance = index;
+					first.index = facet++;
+					second.index = facet++;
+
+					mTriangles.push_back(first);
+					mTriangles.push_back(second);
+				}
+			}
+		}
+
+		this->DoTransformInstance(instance);
+
+		instance.geometry = Q3Shared_GetReference(grid);
+
+	} catch (...) {
+		Q3TriGrid_EmptyData(&data);
+		throw;
+	}
+
+	Q3TriGrid_EmptyData(&data);
+
+	return index;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::AddGroup
+//
+//---------------------------------------------------------------
+void X3DPickTree::AddGroup(const X3DGroup& group, const X3DMatrix& localToWorld)
+{
+	X3DMatrix matrix = localToWorld;
+	uint32 pickID = 0;
+
+	this->DoAddGroup(group, matrix, pickID);
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::AddTriangles
+//
+//---------------------------------------------------------------
+uint32 X3DPickTree::AddTriangles(const X3DPoint* points, uint32 numPoints, const uint32* indices, uint32 numTriangles, const X3DMatrix& localToWorld, uint32 pickID)
+{
+	PRECONDITION(points != nil || numPoints == 0);
+	PRECONDITION(indices != nil || numTriangles == 0);
+
+	uint32 index = this->DoAddInstance(localToWorld, pickID, numPoints);
+	SInstance& instance = mInstances.back();
+
+	std::copy(points, points + numPoints, mLocalPoints.begin() + instance.firstPoint);
+
+	mTriangles.reserve(mTriangles.size() + numTriangles);
+	for (uint32 i = 0; i < numTriangles; ++i) {
+		STriangle triangle;
+		for (uint32 j = 0; j < 3; ++j) {
+			PRECONDITION(indices[3*i + j] < numPoints);
+			triangle.points[j] = instance.firstPoint + indices[3*i + j];
+		}
+		triangle.instance = index;
+		triangle.index    = i;
+		mTriangles.push_back(triangle);
+	}
+
+	this->DoTransformInstance(instance);
+
+	return index;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::RemoveAll
+//
+//---------------------------------------------------------------
+void X3DPickTree::RemoveAll()
+{
+	for (uint32 i = 0; i < mInstances.size(); ++i) {
+		if (mInstances[i].geometry != nil) {
+			TQ3Status status = Q3Object_Dispose(mInstances[i].geometry);
+			ASSERT(status == kQ3Success);
+		}
+	}
+
+	mInstances.clear();
+	mLocalPoints.clear();
+	mWorldPoints.clear();
+	mNormals.clear();
+	mUVs.clear();
+	mTriangles.clear();
+	mNodes.clear();
+
+	mBuilt = false;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::Build
+//
+// Builds the tree top down using a binned surface area heuristic
+// and then computes the node bounds with a refit.
+//
+//---------------------------------------------------------------
+void X3DPickTree::Build()
+{
+	mNodes.clear();
+
+	uint32 count = mTriangles.size();
+	if (count > 0) {
+		std::vector<X3DPoint> centroids(count);
+		std::vector<uint32> order(count);
+		for (uint32 i = 0; i < count; ++i) {
+			const STriangle& triangle = mTriangles[i];
+			const X3DPoint& pt0 = mWorldPoints[triangle.points[0]];
+			const X3DPoint& pt1 = mWorldPoints[triangle.points[1]];
+			const X3DPoint& pt2 = mWorldPoints[triangle.points[2]];
+
+			centroids[i].Set((pt0.x + pt1.x + pt2.x)/3.0f, (pt0.y + pt1.y + pt2.y)/3.0f, (pt0.z + pt1.z + pt2.z)/3.0f);
+			order[i] = i;
+		}
+
+		mNodes.reserve(2*count/kLeafSize + 1);
+		mNodes.push_back(SNode());
+		this->DoBuildNode(0, 0, count, 0, order, centroids);
+
+		std::vector<STriangle> triangles(count);
+		for (uint32 i = 0; i < count; ++i)
+			triangles[i] = mTriangles[order[i]];
+		mTriangles.swap(triangles);
+
+		this->DoRefit();
+	}
+
+	mBuilt = true;
+
+	CALL_INVARIANT;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::GetTransform
+//
+//---------------------------------------------------------------
+const X3DMatrix& X3DPickTree::GetTransform(uint32 instance) const
+{
+	PRECONDITION(instance < mInstances.size());
+
+	return mInstances[instance].localToWorld;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::SetTransform
+//
+//---------------------------------------------------------------
+void X3DPickTree::SetTransform(uint32 instance, const X3DMatrix& localToWorld)
+{
+	PRECONDITION(instance < mInstances.size());
+
+	SInstance& entry = mInstances[instance];
+	entry.localToWorld = localToWorld;
+
+	this->DoTransformInstance(entry);
+
+	if (mBuilt)
+		this->DoRefit();
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::Pick (TQ3Ray3D, SHit)
+//
+//---------------------------------------------------------------
+bool X3DPickTree::Pick(const TQ3Ray3D& ray, SHit& hit) const
+{
+	PRECONDITION(mBuilt);
+
+	SCandidate candidate;
+	bool found = this->DoPick(ray, &candidate, 1) == 1;
+	if (found)
+		this->DoGetHit(candidate, hit);
+
+	return found;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::Pick (TQ3Ray3D, vector<SHit>, uint32)
+//
+//---------------------------------------------------------------
+uint32 X3DPickTree::Pick(const TQ3Ray3D& ray, std::vector<SHit>& hits, uint32 maxHits) const
+{
+	PRECONDITION(mBuilt);
+
+	hits.clear();
+
+	if (maxHits > 0) {
+		std::vector<SCandidate> candidates(Min(maxHits, (uint32) mTriangles.size()) + 1);
+		uint32 count = this->DoPick(ray, &candidates[0], candidates.size() - 1);
+
+		hits.resize(count);
+		for (uint32 i = 0; i < count; ++i)
+			this->DoGetHit(candidates[i], hits[i]);
+	}
+
+	return hits.size();
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::Pick (X2DPoint, X2DRect, X3DCamera, SHit)
+//
+//---------------------------------------------------------------
+bool X3DPickTree::Pick(const X2DPoint& pt, const X2DRect& pane, const X3DCamera& camera, SHit& hit) const
+{
+	TQ3Ray3D ray = GetWindowRay(pt, pane, camera);
+
+	return this->Pick(ray, hit);
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::GetWindowRay								[static]
+//
+// Maps the point into the camera's frustum coordinates (x and y
+// range from -1 to 1 and z ranges from 0 at hither to -1 at yon)
+// and then back into world coordinates.
+//
+//---------------------------------------------------------------
+TQ3Ray3D X3DPickTree::GetWindowRay(const X2DPoint& pt, const X2DRect& pane, const X3DCamera& camera)
+{
+	PRECONDITION(pane.GetWidth() > 0.0 && pane.GetHeight() > 0.0);
+
+	X3DMatrix frustumToWorld = Invert(camera.GetWorldToFrustum());
+
+	float x = (float) (2.0*(pt.x - pane.left)/pane.GetWidth() - 1.0);
+	float y = (float) (1.0 - 2.0*(pt.y - pane.top)/pane.GetHeight());
+
+	X3DPoint start = X3DPoint(x, y, 0.0f)*frustumToWorld;
+	X3DPoint end   = X3DPoint(x, y, -1.0f)*frustumToWorld;
+
+	TQ3Ray3D ray;
+	ray.origin    = start;
+	ray.direction = Normalize(X3DVector(start, end));
+
+	return ray;
+}
+
+#if __MWERKS__
+#pragma mark ~
+#endif
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::Invariant
+//
+//---------------------------------------------------------------
+void X3DPickTree::Invariant() const
+{
+	ASSERT(mWorldPoints.size() == mLocalPoints.size());
+	ASSERT(mNormals.size() == mLocalPoints.size());
+	ASSERT(mUVs.size() == mLocalPoints.size());
+
+	if (mBuilt) {
+		ASSERT(mNodes.empty() == mTriangles.empty());
+
+		uint32 count = 0;
+		for (uint32 i = 0; i < mNodes.size(); ++i) {
+			const SNode& node = mNodes[i];
+			if (node.count > 0) {
+				ASSERT(node.first + node.count <= mTriangles.size());
+				count += node.count;
+			} else {
+				ASSERT(node.first > i);
+				ASSERT(node.first + 1 < mNodes.size());
+			}
+		}
+		ASSERT(count == mTriangles.size());
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::DoAddInstance
+//
+//---------------------------------------------------------------
+uint32 X3DPickTree::DoAddInstance(const X3DMatrix& localToWorld, uint32 pickID, uint32 numPoints)
+{
+	SInstance instance;
+	instance.geometry     = nil;
+	instance.pickID       = pickID;
+	instance.localToWorld = localToWorld;
+	instance.normalMatrix = kIdentity3DMatrix;
+	instance.firstPoint   = mLocalPoints.size();
+	instance.numPoints    = numPoints;
+	instance.hasNormals   = false;
+	instance.hasUVs       = false;
+
+	TQ3Param2D zeroUV = {0.0f, 0.0f};
+
+	mLocalPoints.resize(mLocalPoints.size() + numPoints, kZero3DPt);
+	mWorldPoints.resize(mWorldPoints.size() + numPoints, kZero3DPt);
+	mNormals.resize(mNormals.size() + numPoints, X3DVector(0.0f, 0.0f, 0.0f));
+	mUVs.resize(mUVs.size() + numPoints, zeroUV);
+
+	mInstances.push_back(instance);
+	mBuilt = false;
+
+	return mInstances.size() - 1;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::DoAddGroup
+//
+// Walks the group the same way a view would when the group is
+// submitted: transforms and pick ID styles affect the objects that
+// follow them and subgroups get their own copy of the state.
+//
+//---------------------------------------------------------------
+void X3DPickTree::DoAddGroup(TQ3GroupObject group, X3DMatrix& localToWorld, uint32& pickID)
+{
+	TQ3GroupPosition pos = nil;
+	TQ3Status status = Q3Group_GetFirstPosition(group, &pos);
+	ThrowIf3DError(status);
+
+	while (pos != nil) {
+		TQ3Object object = nil;
+		status = Q3Group_GetPositionObject(group, pos, &object);
+		ThrowIf3DError(status);
+
+		if (Q3Object_IsType(object, kQ3GeometryTypeTriMesh)) {
+			X3DTriMesh mesh(object);								// adopts the reference we were given
+			(void) this->AddTriMesh(mesh, localToWorld, pickID);
+
+		} else if (Q3Object_IsType(object, kQ3GeometryTypeTriGrid)) {
+			X3DTriGrid grid(object);
+			(void) this->AddTriGrid(grid, localToWorld, pickID);
+
+		} else {
+			try {
+				if (Q3Object_IsType(object, kQ3ShapeTypeGroup)) {
+					X3DMatrix matrix = localToWorld;
+					uint32 id = pickID;
+					this->DoAddGroup(object, matrix, id);
+
+				} else if (Q3Object_IsType(object, kQ3ShapeTypeTransform)) {
+					X3DMatrix matrix;
+					status = Q3Transform_GetMatrix(object, &matrix);
+					ThrowIf3DError(status);
+
+					localToWorld = matrix*localToWorld;
+
+				} else if (Q3Object_IsType(object, kQ3StyleTypePickID)) {
+					TQ3Uns32 id = 0;
+					status = Q3PickIDStyle_Get(object, &id);
+					ThrowIf3DError(status);
+
+					pickID = id;
+				}
+
+			} catch (...) {
+				(void) Q3Object_Dispose(object);
+				throw;
+			}
+
+			(void) Q3Object_Dispose(object);
+		}
+
+		status = Q3Group_GetNextPosition(group, &pos);
+		ThrowIf3DError(status);
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::DoTransformInstance
+//
+//---------------------------------------------------------------
+void X3DPickTree::DoTransformInstance(SInstance& instance)
+{
+	if (instance.numPoints > 0)
+		Transform(&mLocalPoints[instance.firstPoint], &mWorldPoints[instance.firstPoint], instance.numPoints, instance.localToWorld);
+
+	if (instance.hasNormals)
+		instance.normalMatrix = Transpose(Invert(instance.localToWorld));
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::DoBuildNode
+//
+// Splits order[first, first + count) into two children. The split
+// is the bin boundary with the lowest surface area heuristic cost
+// (the sum of each child's triangle count times its surface area).
+// If every centroid lands in the same bin, or the tree is getting
+// too deep, we fall back to splitting at the median centroid.
+//
+//---------------------------------------------------------------
+void X3DPickTree::DoBuildNode(uint32 node, uint32 first, uint32 count, uint32 depth, std::vector<uint32>& order, const std::vector<X3DPoint>& centroids)
+{
+	PRECONDITION(count > 0);
+
+	if (count <= kLeafSize) {
+		mNodes[node].first = first;
+		mNodes[node].count = count;
+		return;
+	}
+
+	SBounds centroidBounds;
+	for (uint32 i = first; i < first + count; ++i)
+		centroidBounds.Add(centroids[order[i]]);
+
+	int bestAxis = 0;
+	uint32 bestSplit = kNumBins;
+	float bestCost = kInfinity;
+	float bestScale = 0.0f;
+
+	if (depth < kMaxSAHDepth) {
+		for (int axis = 0; axis < 3; ++axis) {
+			float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+			if (extent <= 0.0f)
+				continue;
+
+			float scale = kNumBins/extent;
+
+			SBin bins[kNumBins];
+			for (uint32 i = first; i < first + count; ++i) {
+				const STriangle& triangle = mTriangles[order[i]];
+				uint32 bin = GetBin((&centroids[order[i]].x)[axis], centroidBounds.min[axis], scale);
+
+				bins[bin].bounds.Add(mWorldPoints[triangle.points[0]]);
+				bins[bin].bounds.Add(mWorldPoints[triangle.points[1]]);
+				bins[bin].bounds.Add(mWorldPoints[triangle.points[2]]);
+				++bins[bin].count;
+			}
+
+			float leftArea[kNumBins];
+			uint32 leftCount[kNumBins];
+			SBounds bounds;
+			uint32 total = 0;
+			for (uint32 i = 0; i + 1 < kNumBins; ++i) {
+				bounds.Add(bins[i].bounds);
+				total += bins[i].count;
+				leftArea[i] = bounds.GetArea();
+				leftCount[i] = total;
+			}
+
+			bounds = SBounds();
+			total = 0;
+			for (uint32 i = kNumBins - 1; i > 0; --i) {
+				bounds.Add(bins[i].bounds);
+				total += bins[i].count;
+
+				uint32 split = i - 1;								// split is the last bin on the left side
+				if (leftCount[split] > 0 && total > 0) {
+					float cost = leftCount[split]*leftArea[split] + total*bounds.GetArea();
+					if (cost < bestCost) {
+						bestCost  = cost;
+						bestAxis  = axis;
+						bestSplit = split;
+						bestScale = scale;
+					}
+				}
+			}
+		}
+	}
+
+	uint32 middle;
+	if (bestSplit < kNumBins) {
+		std::vector<uint32>::iterator iter = std::partition(order.begin() + first, order.begin() + first + count, SInLeftBins(centroids, bestAxis, centroidBounds.min[bestAxis], bestScale, bestSplit));
+		middle = iter - order.begin();
+
+	} else {
+		int axis = 0;
+		for (int i = 1; i < 3; ++i)
+			if (centroidBounds.max[i] - centroidBounds.min[i] > centroidBounds.max[axis] - centroidBounds.min[axis])
+				axis = i;
+
+		middle = first + count/2;
+		std::nth_element(order.begin() + first, order.begin() + middle, order.begin() + first + count, SCompareCentroids(centroids, axis));
+	}
+	ASSERT(middle > first && middle < first + count);
+
+	uint32 left = mNodes.size();
+	mNodes[node].first = left;
+	mNodes[node].count = 0;
+
+	mNodes.push_back(SNode());
+	mNodes.push_back(SNode());
+
+	this->DoBuildNode(left, first, middle - first, depth + 1, order, centroids);
+	this->DoBuildNode(left + 1, middle, first + count - middle, depth + 1, order, centroids);
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::DoRefit
+//
+// Children always come after their parent so we can compute the
+// bounds bottom up by walking the nodes backwards.
+//
+//---------------------------------------------------------------
+void X3DPickTree::DoRefit()
+{
+	for (uint32 i = mNodes.size(); i > 0; --i) {
+		SNode& node = mNodes[i - 1];
+
+		if (node.count > 0) {
+			this->DoComputeBounds(node.first, node.count, node);
+
+		} else {
+			const SNode& left  = mNodes[node.first];
+			const SNode& right = mNodes[node.first + 1];
+
+			for (int axis = 0; axis < 3; ++axis) {
+				node.min[axis] = Min(left.min[axis], right.min[axis]);
+				node.max[axis] = Max(left.max[axis], right.max[axis]);
+			}
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::DoComputeBounds
+//
+//---------------------------------------------------------------
+void X3DPickTree::DoComputeBounds(uint32 first, uint32 count, SNode& node) const
+{
+	SBounds bounds;
+
+	for (uint32 i = first; i < first + count; ++i) {
+		const STriangle& triangle = mTriangles[i];
+
+		bounds.Add(mWorldPoints[triangle.points[0]]);
+		bounds.Add(mWorldPoints[triangle.points[1]]);
+		bounds.Add(mWorldPoints[triangle.points[2]]);
+	}
+
+	for (int axis = 0; axis < 3; ++axis) {
+		node.min[axis] = bounds.min[axis];
+		node.max[axis] = bounds.max[axis];
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::DoPick
+//
+// Candidates is kept as a max heap on distance so that once it's
+// full we can skip everything farther than the worst hit so far.
+// Nodes are visited nearest child first. Returns the number of
+// candidates sorted from near to far.
+//
+//---------------------------------------------------------------
+uint32 X3DPickTree::DoPick(const TQ3Ray3D& ray, SCandidate* candidates, uint32 maxHits) const
+{
+	PRECONDITION(candidates != nil);
+	PRECONDITION(maxHits > 0);
+
+	if (mNodes.empty())
+		return 0;
+
+	X3DVector dir(ray.direction);
+	double length = dir.Length();
+	if (length == 0.0)
+		return 0;
+
+	float origin[3]    = {ray.origin.x, ray.origin.y, ray.origin.z};
+	float direction[3] = {(float) (dir.x/length), (float) (dir.y/length), (float) (dir.z/length)};
+	float invDirection[3] = {1.0f/direction[0], 1.0f/direction[1], 1.0f/direction[2]};	// infinite if a component is zero which the slab test handles
+
+	uint32 numHits = 0;
+	float maxDistance = kInfinity;
+
+	SStackEntry stack[kStackSize];
+	uint32 top = 0;
+
+	float distance;
+	if (HitBox(mNodes[0].min, mNodes[0].max, origin, invDirection, maxDistance, distance)) {
+		stack[0].node = 0;
+		stack[0].distance = distance;
+		top = 1;
+	}
+
+	while (top > 0) {
+		SStackEntry entry = stack[--top];
+		if (entry.distance > maxDistance)
+			continue;										// a closer hit was found after this was pushed
+
+		const SNode& node = mNodes[entry.node];
+		if (node.count > 0) {
+			for (uint32 i = node.first; i < node.first + node.count; ++i) {
+				const STriangle& triangle = mTriangles[i];
+
+				SCandidate candidate;
+				if (HitTriangle(mWorldPoints[triangle.points[0]], mWorldPoints[triangle.points[1]], mWorldPoints[triangle.points[2]], origin, direction, maxDistance, candidate.distance, candidate.u, candidate.v)) {
+					candidate.triangle = i;
+
+					if (numHits < maxHits) {
+						candidates[numHits++] = candidate;
+						std::push_heap(candidates, candidates + numHits, SCompareDistance());
+					} else {
+						std::pop_heap(candidates, candidates + numHits, SCompareDistance());
+						candidates[numHits - 1] = candidate;
+						std::push_heap(candidates, candidates + numHits, SCompareDistance());
+					}
+
+					if (numHits == maxHits)
+						maxDistance = candidates[0].distance;
+				}
+			}
+
+		} else {
+			const SNode& left  = mNodes[node.first];
+			const SNode& right = mNodes[node.first + 1];
+
+			float leftDistance, rightDistance;
+			bool hitLeft  = HitBox(left.min, left.max, origin, invDirection, maxDistance, leftDistance);
+			bool hitRight = HitBox(right.min, right.max, origin, invDirection, maxDistance, rightDistance);
+
+			if (hitLeft && hitRight) {
+				ASSERT(top + 2 <= kStackSize);
+				bool leftFirst = leftDistance <= rightDistance;
+
+				stack[top].node     = leftFirst ? node.first + 1 : node.first;		// push the far child first so the near one is popped first
+				stack[top].distance = leftFirst ? rightDistance : leftDistance;
+				++top;
+
+				stack[top].node     = leftFirst ? node.first : node.first + 1;
+				stack[top].distance = leftFirst ? leftDistance : rightDistance;
+				++top;
+
+			} else if (hitLeft || hitRight) {
+				ASSERT(top < kStackSize);
+				stack[top].node     = hitLeft ? node.first : node.first + 1;
+				stack[top].distance = hitLeft ? leftDistance : rightDistance;
+				++top;
+			}
+		}
+	}
+
+	std::sort_heap(candidates, candidates + numHits, SCompareDistance());
+
+	return numHits;
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTree::DoGetHit
+//
+//---------------------------------------------------------------
+void X3DPickTree::DoGetHit(const SCandidate& candidate, SHit& hit) const
+{
+	const STriangle& triangle = mTriangles[candidate.triangle];
+	const SInstance& instance = mInstances[triangle.instance];
+
+	uint32 i0 = triangle.points[0];
+	uint32 i1 = triangle.points[1];
+	uint32 i2 = triangle.points[2];
+
+	float w = 1.0f - candidate.u - candidate.v;
+	float u = candidate.u;
+	float v = candidate.v;
+
+	const X3DPoint& pt0 = mWorldPoints[i0];
+	const X3DPoint& pt1 = mWorldPoints[i1];
+	const X3DPoint& pt2 = mWorldPoints[i2];
+
+	hit.pickID    = instance.pickID;
+	hit.shapePart = instance.geometry;
+	hit.instance  = triangle.instance;
+	hit.triangle  = triangle.index;
+	hit.distance  = candidate.distance;
+	hit.xyz.Set(w*pt0.x + u*pt1.x + v*pt2.x, w*pt0.y + u*pt1.y + v*pt2.y, w*pt0.z + u*pt1.z + v*pt2.z);
+
+	X3DVector normal;
+	if (instance.hasNormals) {
+		const X3DVector& n0 = mNormals[i0];
+		const X3DVector& n1 = mNormals[i1];
+		const X3DVector& n2 = mNormals[i2];
+
+		normal = X3DVector(w*n0.x + u*n1.x + v*n2.x, w*n0.y + u*n1.y + v*n2.y, w*n0.z + u*n1.z + v*n2.z)*instance.normalMatrix;
+	} else
+		normal = CrossProduct(X3DVector(pt0, pt1), X3DVector(pt0, pt2));
+
+	hit.normal = normal.LengthSquared() > 0.0 ? Normalize(normal) : normal;
+
+	if (instance.hasUVs) {
+		const TQ3Param2D& uv0 = mUVs[i0];
+		const TQ3Param2D& uv1 = mUVs[i1];
+		const TQ3Param2D& uv2 = mUVs[i2];
+
+		hit.uv.u = w*uv0.u + u*uv1.u + v*uv2.u;
+		hit.uv.v = w*uv0.v + u*uv1.v + v*uv2.v;
+
+	} else {
+		hit.uv.u = 0.0f;
+		hit.uv.v = 0.0f;
+	}
+}
+
+
+}	// namespace Whisper
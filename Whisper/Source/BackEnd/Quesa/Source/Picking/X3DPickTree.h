@@ -0,0 +1,217 @@
+/*
+ *  File:       X3DPickTree.h
+ *  Summary:   	Software picking using a bounding volume hierarchy over triangles.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: X3DPickTree.h,v $
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <Quesa.h>
+
+#include <X2DPrimitives.h>
+#include <X3DMatrix.h>
+#include <X3DPrimitives.h>
+#include <X3DVectors.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+//-----------------------------------
+//	Forward References
+//
+class X3DCamera;
+class X3DGroup;
+class X3DTriGrid;
+class X3DTriMesh;
+
+
+// ===================================================================================
+//	class X3DPickTree
+//!		Software picking using a bounding volume hierarchy over triangles.
+/*!		X3DPick asks Quesa to hit test the scene which means submitting every object
+ *		and testing every triangle. X3DPickTree copies the triangles of tri meshes and
+ *		tri grids into a bounding volume hierarchy (built using a binned surface area
+ *		heuristic) so a pick only has to look at a handful of nodes and triangles.
+ *
+ *		Each geometry is an instance with its own local to world matrix. Changing the
+ *		matrix re-transforms the instance's points and refits the node bounds without
+ *		changing the tree's topology. This is a lot faster than rebuilding but the tree
+ *		gets looser as objects move so call Build again if things have moved a long way.
+ *
+ *		The tree doesn't track changes to the geometry: if a mesh is edited it has to be
+ *		removed and re-added. Unlike Quesa, triangles are the only things that can be
+ *		picked (tolerances aren't used). */
+// ===================================================================================
+class QUESA_EXPORT X3DPickTree {
+
+//-----------------------------------
+//	Types
+//
+public:
+	struct SHit {
+		uint32				pickID;			// from the instance (or the last pick ID style in the group)
+		TQ3GeometryObject	shapePart;		// the tri mesh or tri grid (nil for AddTriangles)
+		uint32				instance;
+		uint32				triangle;		// index of the triangle (or facet) within the geometry
+		float				distance;		// distance along the ray from its origin
+		X3DPoint			xyz;			// world coordinates
+		X3DVector			normal;			// world coordinates (interpolated if the geometry has vertex normals)
+		TQ3Param2D			uv;				// (0, 0) if the geometry doesn't have uvs
+	};
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+						~X3DPickTree();
+
+						X3DPickTree();
+
+private:
+						X3DPickTree(const X3DPickTree& rhs);
+
+			X3DPickTree& operator=(const X3DPickTree& rhs);
+
+//-----------------------------------
+//	API
+//
+public:
+	//! @name Geometry
+	//@{
+			uint32 		AddTriMesh(const X3DTriMesh& mesh, const X3DMatrix& localToWorld = kIdentity3DMatrix, uint32 pickID = 0);
+			uint32 		AddTriGrid(const X3DTriGrid& grid, const X3DMatrix& localToWorld = kIdentity3DMatrix, uint32 pickID = 0);
+						/**< Returns the new instance's index. Vertex normals and uvs are
+						used if the geometry has them. */
+
+			void 		AddGroup(const X3DGroup& group, const X3DMatrix& localToWorld = kIdentity3DMatrix);
+						/**< Adds the tri meshes and tri grids in group and its subgroups.
+						Transforms and pick ID styles are applied the same way they are
+						when the group is submitted. Other objects are ignored. */
+
+			uint32 		AddTriangles(const X3DPoint* points, uint32 numPoints, const uint32* indices, uint32 numTriangles, const X3DMatrix& localToWorld = kIdentity3DMatrix, uint32 pickID = 0);
+						/**< Indices has three entries for each triangle. */
+
+			void 		RemoveAll();
+
+			uint32		GetNumInstances() const							{return (uint32) mInstances.size();}
+			uint32		GetNumTriangles() const							{return (uint32) mTriangles.size();}
+	//@}
+
+	//! @name Building
+	//@{
+			void 		Build();
+						/**< Must be called after adding geometry and before picking. */
+
+			bool		IsBuilt() const									{return mBuilt;}
+	//@}
+
+	//! @name Transforms
+	//@{
+			const X3DMatrix& GetTransform(uint32 instance) const;
+
+			void 		SetTransform(uint32 instance, const X3DMatrix& localToWorld);
+						/**< Refits the tree so this is linear in the number of triangles
+						(and the tree doesn't have to be rebuilt). */
+	//@}
+
+	//! @name Picking
+	//@{
+			bool 		Pick(const TQ3Ray3D& ray, SHit& hit) const;
+						/**< Finds the closest triangle hit by the ray. Returns false if
+						nothing was hit. The ray's direction needn't be normalized. */
+
+			uint32 		Pick(const TQ3Ray3D& ray, std::vector<SHit>& hits, uint32 maxHits) const;
+						/**< Returns up to maxHits hits sorted from near to far. */
+
+			bool 		Pick(const X2DPoint& pt, const X2DRect& pane, const X3DCamera& camera, SHit& hit) const;
+						/**< Pt is in window coordinates and pane is the area the camera
+						is drawing into (eg the draw context's pane). */
+
+	static	TQ3Ray3D 	GetWindowRay(const X2DPoint& pt, const X2DRect& pane, const X3DCamera& camera);
+						/**< Returns the world space ray that passes through pt. */
+	//@}
+
+//-----------------------------------
+//	Internal Types
+//
+protected:
+	struct SInstance {
+		TQ3GeometryObject	geometry;		// we own a reference (nil for AddTriangles and until the geometry has been added)
+		uint32				pickID;
+		X3DMatrix			localToWorld;
+		X3DMatrix			normalMatrix;	// inverse transpose of localToWorld
+		uint32				firstPoint;		// index into mLocalPoints, mWorldPoints, mNormals, and mUVs
+		uint32				numPoints;
+		bool				hasNormals;
+		bool				hasUVs;
+	};
+
+	struct STriangle {
+		uint32	points[3];					// indexes into mWorldPoints
+		uint32	instance;
+		uint32	index;						// index within the instance's geometry
+	};
+
+	struct SNode {
+		float	min[3];
+		float	max[3];
+		uint32	first;						// first triangle for leafs, left child for interior nodes (right child is first + 1)
+		uint32	count;						// number of triangles (zero for interior nodes)
+	};
+
+	struct SCandidate {
+		uint32	triangle;					// index into mTriangles
+		float	distance;
+		float	u, v;						// barycentric coordinates of the hit
+	};
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		Invariant() const;
+
+			uint32 		DoAddInstance(const X3DMatrix& localToWorld, uint32 pickID, uint32 numPoints);
+			void 		DoAddGroup(TQ3GroupObject group, X3DMatrix& localToWorld, uint32& pickID);
+			void 		DoTransformInstance(SInstance& instance);
+
+			void 		DoBuildNode(uint32 node, uint32 first, uint32 count, uint32 depth, std::vector<uint32>& order, const std::vector<X3DPoint>& centroids);
+			void 		DoRefit();
+			void 		DoComputeBounds(uint32 first, uint32 count, SNode& node) const;
+
+			uint32 		DoPick(const TQ3Ray3D& ray, SCandidate* candidates, uint32 maxHits) const;
+			void 		DoGetHit(const SCandidate& candidate, SHit& hit) const;
+
+//-----------------------------------
+//	Member Data
+//
+protected:
+	std::vector<SInstance>	mInstances;
+	std::vector<X3DPoint>	mLocalPoints;
+	std::vector<X3DPoint>	mWorldPoints;
+	std::vector<X3DVector>	mNormals;		// local vertex normals (zero if the instance has none)
+	std::vector<TQ3Param2D>	mUVs;
+	std::vector<STriangle>	mTriangles;		// sorted so that each leaf's triangles are contiguous
+	std::vector<SNode>		mNodes;			// root is first, children come after their parent
+	bool					mBuilt;
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
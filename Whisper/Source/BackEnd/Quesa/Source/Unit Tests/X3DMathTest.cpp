@@ -0,0 +1,345 @@
+/*
+ *  File:       X3DMathTest.cpp
+ *  Summary:	Unit test and benchmark for the inlined 3D math functions.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: X3DMathTest.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <X3DMathTest.h>
+
+#include <cmath>
+#include <vector>
+
+#include <X3DMath.h>
+#include <X3DMatrix.h>
+#include <XMiscUtils.h>
+#include <XNumbers.h>
+#include <XUnitTestUtils.h>
+
+namespace Whisper {
+#if DEBUG
+
+
+//-----------------------------------
+//	Internal Constants
+//
+const uint32 kNumMatrices = 100000;
+const uint32 kNumPoints   = 1000000;
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// GetRandomMatrix
+//
+// Returns a matrix with entries in [-1, 1]. If affine is set the
+// last column is (0, 0, 0, 1).
+//
+//---------------------------------------------------------------
+static X3DMatrix GetRandomMatrix(bool affine)
+{
+	X3DMatrix matrix;
+
+	for (int i = 0; i < 4; ++i)
+		for (int j = 0; j < 4; ++j)
+			matrix.value[i][j] = Random(-1.0f, 1.0f);
+
+	if (affine) {
+		matrix.value[0][3] = 0.0f;
+		matrix.value[1][3] = 0.0f;
+		matrix.value[2][3] = 0.0f;
+		matrix.value[3][3] = 1.0f;
+	}
+
+	return matrix;
+}
+
+
+//---------------------------------------------------------------
+//
+// GetRandomPoint
+//
+//---------------------------------------------------------------
+static X3DPoint GetRandomPoint()
+{
+	return X3DPoint(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f));
+}
+
+
+//---------------------------------------------------------------
+//
+// IsClose
+//
+//---------------------------------------------------------------
+static bool IsClose(const TQ3Matrix4x4& lhs, const TQ3Matrix4x4& rhs, float tolerance)
+{
+	for (int i = 0; i < 4; ++i)
+		for (int j = 0; j < 4; ++j)
+			if (std::fabs(lhs.value[i][j] - rhs.value[i][j]) > tolerance)
+				return false;
+
+	return true;
+}
+
+static bool IsClose(const TQ3Point3D& lhs, const TQ3Point3D& rhs, float tolerance)
+{
+	return std::fabs(lhs.x - rhs.x) <= tolerance && std::fabs(lhs.y - rhs.y) <= tolerance && std::fabs(lhs.z - rhs.z) <= tolerance;
+}
+
+static bool IsClose(const TQ3Vector3D& lhs, const TQ3Vector3D& rhs, float tolerance)
+{
+	return std::fabs(lhs.x - rhs.x) <= tolerance && std::fabs(lhs.y - rhs.y) <= tolerance && std::fabs(lhs.z - rhs.z) <= tolerance;
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class X3DMathTest
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// X3DMathTest::~X3DMathTest
+//
+//---------------------------------------------------------------
+X3DMathTest::~X3DMathTest()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DMathTest::X3DMathTest
+//
+//---------------------------------------------------------------
+X3DMathTest::X3DMathTest() : XUnitTest(L"Quesa", L"3D Math")
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DMathTest::OnTest
+//
+//---------------------------------------------------------------
+void X3DMathTest::OnTest()
+{
+	this->DoTestMatrices();
+	this->DoTestTransforms();
+	this->DoTestQuaternions();
+
+	TRACE("Inlined math vs Quesa (millions per second):\n");
+	this->DoTimeMatrices();
+	this->DoTimeTransforms();
+
+	TRACE("Completed 3D math test.\n\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DMathTest::DoTestMatrices
+//
+// Checks the inlined functions against Quesa.
+//
+//---------------------------------------------------------------
+void X3DMathTest::DoTestMatrices()
+{
+	for (uint32 i = 0; i < 1000; ++i) {
+		X3DMatrix lhs = GetRandomMatrix(false);
+		X3DMatrix rhs = GetRandomMatrix(false);
+
+		TQ3Matrix4x4 expected, actual;
+		Q3Matrix4x4_Multiply(&lhs, &rhs, &expected);
+		Multiply4x4(lhs, rhs, actual);
+		ASSERT(IsClose(expected, actual, 1.0e-5f));
+
+		Multiply4x4(lhs, rhs, lhs);							// result can alias the inputs
+		ASSERT(IsClose(expected, lhs, 1.0e-5f));
+
+		Transpose4x4(rhs, actual);
+		for (int r = 0; r < 4; ++r)
+			for (int c = 0; c < 4; ++c)
+				ASSERT(actual.value[r][c] == rhs.value[c][r]);
+
+		float det = Q3Matrix4x4_Determinant(&rhs);
+		ASSERT(std::fabs(det - Determinant4x4(rhs)) < 1.0e-5f);
+
+		if (std::fabs(det) > 0.01f) {
+			float det2 = Invert4x4(rhs, actual);
+			ASSERT(std::fabs(det - det2) < 1.0e-5f);
+
+			X3DMatrix product = rhs*actual;
+			ASSERT(IsClose(product, kIdentity3DMatrix, 1.0e-3f));
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DMathTest::DoTestTransforms
+//
+// Uses counts that aren't multiples of four to exercise the tail
+// loop and a non-affine matrix to exercise the divide by w.
+//
+//---------------------------------------------------------------
+void X3DMathTest::DoTestTransforms()
+{
+	for (uint32 pass = 0; pass < 2; ++pass) {
+		X3DMatrix matrix = GetRandomMatrix(pass == 0);
+		if (pass == 1)
+			matrix.value[3][3] = 5.0f;						// keeps w away from zero
+
+		for (uint32 count = 0; count < 11; ++count) {
+			std::vector<X3DPoint> points(count + 1);
+			std::vector<X3DVector> vectors(count + 1);
+			for (uint32 i = 0; i < count; ++i) {
+				points[i] = GetRandomPoint();
+				vectors[i] = X3DVector(points[i]);
+			}
+
+			std::vector<X3DPoint> newPoints(count + 1, kZero3DPt);
+			std::vector<X3DVector> newVectors(count + 1, kZero3DVector);
+			Transform(&points[0], &newPoints[0], count, matrix);
+			Transform(&vectors[0], &newVectors[0], count, matrix);
+			ASSERT(newPoints[count] == kZero3DPt);			// make sure we don't write past the end
+			ASSERT(newVectors[count] == kZero3DVector);
+
+			for (uint32 i = 0; i < count; ++i) {
+				TQ3Point3D expected;
+				Q3Point3D_Transform(points[i], &matrix, &expected);
+				ASSERT(IsClose(expected, newPoints[i], 1.0e-5f));
+				ASSERT(IsClose(expected, points[i]*matrix, 1.0e-5f));
+
+				TQ3Vector3D expected2;
+				Q3Vector3D_Transform(vectors[i], &matrix, &expected2);
+				ASSERT(IsClose(expected2, newVectors[i], 1.0e-5f));
+				ASSERT(IsClose(expected2, vectors[i]*matrix, 1.0e-5f));
+			}
+
+			Transform(&points[0], &points[0], count, matrix);	// in place
+			for (uint32 i = 0; i < count; ++i)
+				ASSERT(IsClose(points[i], newPoints[i], 0.0f));
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DMathTest::DoTestQuaternions
+//
+//---------------------------------------------------------------
+void X3DMathTest::DoTestQuaternions()
+{
+	TQ3Quaternion lhs = {0.8f, 0.36f, 0.48f, 0.0f};			// w, x, y, z (both are unit length)
+	TQ3Quaternion rhs = {0.6f, 0.0f, 0.0f, 0.8f};
+
+	TQ3Matrix4x4 expected, actual;
+	Q3Matrix4x4_SetQuaternion(&expected, &lhs);
+	QuaternionTo4x4(lhs, actual);
+	ASSERT(IsClose(expected, actual, 1.0e-6f));
+
+	// Rotating by lhs*rhs is the same as rotating by rhs and then lhs.
+	TQ3Quaternion product;
+	MultiplyQuaternion(lhs, rhs, product);
+
+	X3DMatrix first, second, composite;
+	first.SetQuaternion(rhs);
+	second.SetQuaternion(lhs);
+	composite.SetQuaternion(product);
+	ASSERT(IsClose(composite, first*second, 1.0e-5f));
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DMathTest::DoTimeMatrices
+//
+//---------------------------------------------------------------
+void X3DMathTest::DoTimeMatrices()
+{
+	std::vector<X3DMatrix> matrices(kNumMatrices);
+	for (uint32 i = 0; i < kNumMatrices; ++i)
+		matrices[i] = GetRandomMatrix(false);
+
+	TQ3Matrix4x4 result = kIdentity3DMatrix;
+
+	MilliSecond start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumMatrices; ++i)
+		Q3Matrix4x4_Multiply(&matrices[i], &result, &result);
+	MilliSecond quesaMultiply = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumMatrices; ++i)
+		Multiply4x4(matrices[i], result, result);
+	MilliSecond inlineMultiply = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumMatrices; ++i)
+		Q3Matrix4x4_Invert(&matrices[i], &result);
+	MilliSecond quesaInvert = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumMatrices; ++i)
+		(void) Invert4x4(matrices[i], result);
+	MilliSecond inlineInvert = GetMilliSeconds() - start;
+
+	TRACE("   multiply: Quesa ", GetRate(kNumMatrices, quesaMultiply, 1.0e6), ", inlined ", GetRate(kNumMatrices, inlineMultiply, 1.0e6), "\n");
+	TRACE("   invert: Quesa ", GetRate(kNumMatrices, quesaInvert, 1.0e6), ", inlined ", GetRate(kNumMatrices, inlineInvert, 1.0e6), "\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DMathTest::DoTimeTransforms
+//
+//---------------------------------------------------------------
+void X3DMathTest::DoTimeTransforms()
+{
+	X3DMatrix matrix = GetRandomMatrix(true);
+
+	std::vector<X3DPoint> points(kNumPoints);
+	for (uint32 i = 0; i < kNumPoints; ++i)
+		points[i] = GetRandomPoint();
+
+	std::vector<X3DPoint> result(kNumPoints);
+
+	MilliSecond start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumPoints; ++i)
+		Q3Point3D_Transform(points[i], &matrix, result[i]);
+	MilliSecond quesaPoint = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	Q3Point3D_To3DTransformArray(points[0], &matrix, result[0], (TQ3Int32) kNumPoints, sizeof(X3DPoint), sizeof(X3DPoint));
+	MilliSecond quesaArray = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumPoints; ++i)
+		result[i] = points[i]*matrix;
+	MilliSecond inlinePoint = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	Transform(&points[0], &result[0], kNumPoints, matrix);
+	MilliSecond inlineArray = GetMilliSeconds() - start;
+
+	TRACE("   point transform: Quesa ", GetRate(kNumPoints, quesaPoint, 1.0e6), ", inlined ", GetRate(kNumPoints, inlinePoint, 1.0e6), "\n");
+	TRACE("   array transform: Quesa ", GetRate(kNumPoints, quesaArray, 1.0e6), ", inlined ", GetRate(kNumPoints, inlineArray, 1.0e6), "\n");
+}
+
+
+#endif	// DEBUG
+}		// namespace Whisper
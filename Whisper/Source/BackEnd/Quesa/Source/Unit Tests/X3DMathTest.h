@@ -0,0 +1,63 @@
+/*
+ *  File:       X3DMathTest.h
+ *  Summary:	Unit test and benchmark for the inlined 3D math functions.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: X3DMathTest.h,v $
+ */
+
+#pragma once
+
+#include <XUnitTest.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class X3DMathTest
+// ===================================================================================
+#if DEBUG
+class X3DMathTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~X3DMathTest();
+
+						X3DMathTest();
+
+//-----------------------------------
+//	Inherited API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		DoTestMatrices();
+			void 		DoTestTransforms();
+			void 		DoTestQuaternions();
+
+			void 		DoTimeMatrices();
+			void 		DoTimeTransforms();
+};
+#endif
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
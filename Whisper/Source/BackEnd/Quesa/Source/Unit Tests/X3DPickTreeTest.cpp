@@ -0,0 +1,480 @@
+/*
+ *  File:       X3DPickTreeTest.cpp
+ *  Summary:	Unit test and benchmark for X3DPickTree.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: X3DPickTreeTest.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <X3DPickTreeTest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <X3DGroups.h>
+#include <X3DPickTree.h>
+#include <X3DStyles.h>
+#include <X3DTransforms.h>
+#include <X3DTriMesh.h>
+#include <X3DUniformTriGrid.h>
+#include <XMiscUtils.h>
+#include <XNumbers.h>
+#include <XUnitTestUtils.h>
+
+namespace Whisper {
+#if DEBUG
+
+
+//-----------------------------------
+//	Internal Constants
+//
+const uint32 kBenchmarkSize = 708;				// 2*707*707 is just under a million triangles
+const uint32 kNumPicks      = 100000;
+const uint32 kNumScans      = 20;
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// GetHeight
+//
+//---------------------------------------------------------------
+static float GetHeight(float x, float z, float phase)
+{
+	return (float) (0.2*std::sin(6.0*x + phase)*std::cos(5.0*z));
+}
+
+
+//---------------------------------------------------------------
+//
+// GetHeightField
+//
+// Returns a size x size grid of points spanning [-1, 1] in x and z.
+//
+//---------------------------------------------------------------
+static void GetHeightField(uint32 size, float phase, std::vector<X3DPoint>& points, std::vector<uint32>& indices)
+{
+	points.clear();
+	indices.clear();
+
+	for (uint32 row = 0; row < size; ++row) {
+		for (uint32 col = 0; col < size; ++col) {
+			float x = 2.0f*col/(size - 1) - 1.0f;
+			float z = 2.0f*row/(size - 1) - 1.0f;
+			points.push_back(X3DPoint(x, GetHeight(x, z, phase), z));
+		}
+	}
+
+	for (uint32 row = 0; row + 1 < size; ++row) {
+		for (uint32 col = 0; col + 1 < size; ++col) {
+			uint32 index = row*size + col;
+
+			indices.push_back(index);
+			indices.push_back(index + size);
+			indices.push_back(index + 1);
+
+			indices.push_back(index + 1);
+			indices.push_back(index + size);
+			indices.push_back(index + size + 1);
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// GetRandomRay
+//
+// Returns a ray pointing down at the height fields.
+//
+//---------------------------------------------------------------
+static TQ3Ray3D GetRandomRay()
+{
+	TQ3Ray3D ray;
+
+	ray.origin.x    = Random(-1.5f, 1.5f);
+	ray.origin.y    = Random(1.0f, 3.0f);
+	ray.origin.z    = Random(-1.5f, 1.5f);
+	ray.direction.x = Random(-0.5f, 0.5f);
+	ray.direction.y = -1.0f;
+	ray.direction.z = Random(-0.5f, 0.5f);
+
+	return ray;
+}
+
+
+//---------------------------------------------------------------
+//
+// FindHits
+//
+// Brute force version of X3DPickTree::Pick: appends the distance
+// to every triangle the ray hits.
+//
+//---------------------------------------------------------------
+static void FindHits(const TQ3Ray3D& ray, const X3DPoint* points, const uint32* indices, uint32 numTriangles, const X3DMatrix& localToWorld, std::vector<float>& distances)
+{
+	X3DVector direction = Normalize(X3DVector(ray.direction));
+
+	for (uint32 i = 0; i < numTriangles; ++i) {
+		X3DPoint pt0 = points[indices[3*i]]*localToWorld;
+		X3DPoint pt1 = points[indices[3*i + 1]]*localToWorld;
+		X3DPoint pt2 = points[indices[3*i + 2]]*localToWorld;
+
+		X3DVector e1(pt0, pt1);
+		X3DVector e2(pt0, pt2);
+		X3DVector p = CrossProduct(direction, e2);
+
+		double det = DotProduct(e1, p);
+		if (det != 0.0) {
+			X3DVector t(pt0, ray.origin);
+			double u = DotProduct(t, p)/det;
+
+			X3DVector q = CrossProduct(t, e1);
+			double v = DotProduct(direction, q)/det;
+
+			double distance = DotProduct(e2, q)/det;
+			if (u >= 0.0 && v >= 0.0 && u + v <= 1.0 && distance >= 0.0)
+				distances.push_back((float) distance);
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CreateQuad
+//
+// Returns a unit square in the xy plane with vertex normals and
+// uvs (the uvs are the same as the xy coordinates).
+//
+//---------------------------------------------------------------
+static X3DTriMesh CreateQuad()
+{
+	static TQ3Point3D points[4] = {{0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}};
+	static TQ3Vector3D normals[4] = {{0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}};
+	static TQ3Param2D uvs[4] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}};
+	static TQ3TriMeshTriangleData triangles[2] = {{0, 1, 2}, {0, 2, 3}};
+
+	TQ3TriMeshAttributeData attributes[2];
+	attributes[0].attributeType     = kQ3AttributeTypeNormal;
+	attributes[0].data              = normals;
+	attributes[0].attributeUseArray = nil;
+	attributes[1].attributeType     = kQ3AttributeTypeSurfaceUV;
+	attributes[1].data              = uvs;
+	attributes[1].attributeUseArray = nil;
+
+	TQ3TriMeshData data;
+	data.triMeshAttributeSet       = nil;
+	data.numTriangles              = 2;
+	data.triangles                 = triangles;
+	data.numTriangleAttributeTypes = 0;
+	data.triangleAttributeTypes    = nil;
+	data.numEdges                  = 0;
+	data.edges                     = nil;
+	data.numEdgeAttributeTypes     = 0;
+	data.edgeAttributeTypes        = nil;
+	data.numPoints                 = 4;
+	data.points                    = points;
+	data.numVertexAttributeTypes   = 2;
+	data.vertexAttributeTypes      = attributes;
+	data.bBox.min                  = points[0];
+	data.bBox.max                  = points[2];
+	data.bBox.isEmpty              = kQ3False;
+
+	return X3DTriMesh(data);
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class X3DPickTreeTest
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// X3DPickTreeTest::~X3DPickTreeTest
+//
+//---------------------------------------------------------------
+X3DPickTreeTest::~X3DPickTreeTest()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTreeTest::X3DPickTreeTest
+//
+//---------------------------------------------------------------
+X3DPickTreeTest::X3DPickTreeTest() : XUnitTest(L"Quesa", L"Pick Tree")
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTreeTest::OnTest
+//
+//---------------------------------------------------------------
+void X3DPickTreeTest::OnTest()
+{
+	this->DoTestTriangles();
+	this->DoTestDetails();
+	this->DoTestGroup();
+
+	this->DoTime();
+
+	TRACE("Completed pick tree test.\n\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTreeTest::DoTestTriangles
+//
+// Compares the tree against a brute force search using several
+// overlapping height fields. The second pass moves one of them
+// so the refit gets tested.
+//
+//---------------------------------------------------------------
+void X3DPickTreeTest::DoTestTriangles()
+{
+	const uint32 kNumFields = 3;
+
+	X3DPickTree tree;
+	std::vector<X3DPoint> points[kNumFields];
+	std::vector<uint32> indices[kNumFields];
+	X3DMatrix transforms[kNumFields];
+
+	for (uint32 i = 0; i < kNumFields; ++i) {
+		GetHeightField(30 + 7*i, (float) i, points[i], indices[i]);
+
+		transforms[i] = kIdentity3DMatrix;
+		transforms[i].value[3][0] = 0.2f*i;
+		transforms[i].value[3][1] = 0.3f*i;
+
+		uint32 instance = tree.AddTriangles(&points[i][0], points[i].size(), &indices[i][0], indices[i].size()/3, transforms[i], 100 + i);
+		ASSERT(instance == i);
+	}
+	tree.Build();
+
+	for (uint32 pass = 0; pass < 2; ++pass) {
+		if (pass == 1) {
+			transforms[1].SetRotateAboutAxis(kZero3DPt, X3DVector(0.0f, 0.0f, 1.0f), 0.4f);
+			transforms[1].value[3][1] = 0.5f;
+			transforms[1].value[3][2] = 0.3f;
+			tree.SetTransform(1, transforms[1]);
+			ASSERT(tree.GetTransform(1) == transforms[1]);
+		}
+
+		for (uint32 i = 0; i < 1000; ++i) {
+			TQ3Ray3D ray = GetRandomRay();
+
+			std::vector<float> expected;
+			for (uint32 j = 0; j < kNumFields; ++j)
+				FindHits(ray, &points[j][0], &indices[j][0], indices[j].size()/3, transforms[j], expected);
+			std::sort(expected.begin(), expected.end());
+
+			X3DPickTree::SHit hit;
+			bool found = tree.Pick(ray, hit);
+			ASSERT(found == !expected.empty());
+
+			if (found) {
+				ASSERT(std::fabs(hit.distance - expected[0]) < 1.0e-4f);
+				ASSERT(hit.pickID == 100 + hit.instance);
+				ASSERT(hit.shapePart == nil);
+
+				X3DPoint pt = X3DPoint(ray.origin) + hit.distance*Normalize(X3DVector(ray.direction));
+				ASSERT(Equal(pt, hit.xyz, 1.0e-4));
+			}
+
+			std::vector<X3DPickTree::SHit> hits;
+			uint32 count = tree.Pick(ray, hits, 3);
+			ASSERT(count == Min((uint32) 3, (uint32) expected.size()));
+
+			for (uint32 j = 0; j < count; ++j)
+				ASSERT(std::fabs(hits[j].distance - expected[j]) < 1.0e-4f);
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTreeTest::DoTestDetails
+//
+// Checks the normal, uv, and shape part of a hit.
+//
+//---------------------------------------------------------------
+void X3DPickTreeTest::DoTestDetails()
+{
+	X3DTriMesh quad = CreateQuad();
+
+	X3DPickTree tree;
+	(void) tree.AddTriMesh(quad);
+	tree.Build();
+	ASSERT(tree.GetNumTriangles() == 2);
+
+	TQ3Ray3D ray;
+	ray.origin    = X3DPoint(0.25f, 0.5f, 5.0f);
+	ray.direction = X3DVector(0.0f, 0.0f, -2.0f);			// needn't be normalized
+
+	X3DPickTree::SHit hit;
+	VERIFY(tree.Pick(ray, hit));
+	ASSERT(hit.shapePart == (TQ3GeometryObject) quad);
+	ASSERT(hit.triangle == 1);
+	ASSERT(std::fabs(hit.distance - 5.0f) < 1.0e-5f);
+	ASSERT(Equal(hit.xyz, X3DPoint(0.25f, 0.5f, 0.0f), 1.0e-5));
+	ASSERT(Equal(hit.normal, X3DVector(0.0f, 0.0f, 1.0f), 1.0e-5));
+	ASSERT(std::fabs(hit.uv.u - 0.25f) < 1.0e-5f && std::fabs(hit.uv.v - 0.5f) < 1.0e-5f);
+
+	// Stretch the quad along x and tip it towards the ray. The uvs
+	// should still be in terms of the original quad and the normal
+	// should still be perpendicular to the quad.
+	X3DMatrix matrix, rotate;
+	matrix.SetScale(2.0f, 1.0f, 1.0f);
+	rotate.SetRotateX(0.3f);
+	matrix *= rotate;
+	tree.SetTransform(0, matrix);
+
+	ray.origin = X3DPoint(0.5f, 0.5f, 0.0f)*matrix + 5.0f*X3DVector(0.0f, 0.0f, 1.0f);
+	VERIFY(tree.Pick(ray, hit));
+	ASSERT(std::fabs(hit.uv.u - 0.25f) < 1.0e-4f && std::fabs(hit.uv.v - 0.5f) < 1.0e-4f);
+
+	X3DVector normal = Normalize(CrossProduct(X3DVector(1.0f, 0.0f, 0.0f)*matrix, X3DVector(0.0f, 1.0f, 0.0f)*matrix));
+	ASSERT(Equal(hit.normal, normal, 1.0e-4));
+
+	ray.origin = X3DPoint(5.0f, 5.0f, 5.0f);					// misses
+	ASSERT(!tree.Pick(ray, hit));
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTreeTest::DoTestGroup
+//
+// Transforms and pick ids inside a subgroup shouldn't affect the
+// objects that follow the subgroup.
+//
+//---------------------------------------------------------------
+void X3DPickTreeTest::DoTestGroup()
+{
+	X3DTriMesh quad = CreateQuad();
+
+	X3DDisplayGroup inner;
+	inner.AddObject(X3DPickIDStyle(3));
+	inner.AddObject(X3DTranslateTransform(0.0f, 0.0f, 1.0f));
+	inner.AddObject(quad);
+
+	X3DDisplayGroup outer;
+	outer.AddObject(inner);
+	outer.AddObject(X3DPickIDStyle(7));
+	outer.AddObject(X3DTranslateTransform(0.0f, 0.0f, 2.0f));
+	outer.AddObject(quad);
+
+	X3DPickTree tree;
+	tree.AddGroup(outer);
+	tree.Build();
+	ASSERT(tree.GetNumInstances() == 2);
+
+	TQ3Ray3D ray;
+	ray.origin    = X3DPoint(0.5f, 0.25f, 5.0f);
+	ray.direction = X3DVector(0.0f, 0.0f, -1.0f);
+
+	std::vector<X3DPickTree::SHit> hits;
+	VERIFY(tree.Pick(ray, hits, 10) == 2);
+
+	ASSERT(std::fabs(hits[0].distance - 3.0f) < 1.0e-5f);
+	ASSERT(hits[0].pickID == 7);
+	ASSERT(hits[0].triangle == 0);
+
+	ASSERT(std::fabs(hits[1].distance - 4.0f) < 1.0e-5f);
+	ASSERT(hits[1].pickID == 3);
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DPickTreeTest::DoTime
+//
+// Picks against a million triangle height field.
+//
+//---------------------------------------------------------------
+void X3DPickTreeTest::DoTime()
+{
+	X3DUniformTriGrid grid(XSize(kBenchmarkSize, kBenchmarkSize));
+	for (uint32 row = 0; row < kBenchmarkSize; ++row) {
+		for (uint32 col = 0; col < kBenchmarkSize; ++col) {
+			float x = 2.0f*col/(kBenchmarkSize - 1) - 1.0f;
+			float z = 2.0f*row/(kBenchmarkSize - 1) - 1.0f;
+			grid.SetVertexPosition(XPoint(col, row), X3DPoint(x, GetHeight(x, z, 0.0f), z));
+		}
+	}
+	grid.Reset();
+
+	X3DPickTree tree;
+	(void) tree.AddTriMesh(grid);
+
+	MilliSecond start = GetMilliSeconds();
+	tree.Build();
+	MilliSecond build = GetMilliSeconds() - start;
+
+	X3DMatrix matrix;
+	matrix.SetTranslate(0.0f, 0.1f, 0.0f);
+
+	start = GetMilliSeconds();
+	tree.SetTransform(0, matrix);
+	MilliSecond refit = GetMilliSeconds() - start;
+
+	std::vector<TQ3Ray3D> rays(kNumPicks);
+	for (uint32 i = 0; i < kNumPicks; ++i)
+		rays[i] = GetRandomRay();
+
+	uint32 numHits = 0;
+	X3DPickTree::SHit hit;
+
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumPicks; ++i)
+		if (tree.Pick(rays[i], hit))
+			++numHits;
+	MilliSecond picks = GetMilliSeconds() - start;
+
+	// Linear scan over the same triangles for comparison.
+	TQ3TriMeshData data = grid.GetData();
+	std::vector<uint32> indices(3*data.numTriangles);
+	for (uint32 i = 0; i < data.numTriangles; ++i)
+		for (uint32 j = 0; j < 3; ++j)
+			indices[3*i + j] = data.triangles[i].pointIndices[j];
+	std::vector<X3DPoint> points(data.points, data.points + data.numPoints);
+	Q3TriMesh_EmptyData(&data);
+
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumScans; ++i) {
+		std::vector<float> distances;
+		FindHits(rays[i], &points[0], &indices[0], indices.size()/3, matrix, distances);
+
+		bool found = tree.Pick(rays[i], hit);
+		ASSERT(found == !distances.empty());
+		ASSERT(!found || std::fabs(hit.distance - *std::min_element(distances.begin(), distances.end())) < 1.0e-4f);
+	}
+	MilliSecond scans = GetMilliSeconds() - start;
+
+	TRACE("Pick tree with ", tree.GetNumTriangles(), " triangles:\n");
+	TRACE("   build: ", build, " ms, refit: ", refit, " ms\n");
+	TRACE("   picks per second: tree ", GetRate(kNumPicks, picks), " (", numHits, " hits), linear scan ", GetRate(kNumScans, scans), "\n");
+}
+
+
+#endif	// DEBUG
+}		// namespace Whisper
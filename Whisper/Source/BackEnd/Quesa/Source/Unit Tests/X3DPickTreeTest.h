@@ -0,0 +1,62 @@
+/*
+ *  File:       X3DPickTreeTest.h
+ *  Summary:	Unit test and benchmark for X3DPickTree.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: X3DPickTreeTest.h,v $
+ */
+
+#pragma once
+
+#include <XUnitTest.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class X3DPickTreeTest
+// ===================================================================================
+#if DEBUG
+class X3DPickTreeTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~X3DPickTreeTest();
+
+						X3DPickTreeTest();
+
+//-----------------------------------
+//	Inherited API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		DoTestTriangles();
+			void 		DoTestDetails();
+			void 		DoTestGroup();
+
+			void 		DoTime();
+};
+#endif
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
@@ -0,0 +1,435 @@
+/*
+ *  File:       X3DTriMeshEditorTest.cpp
+ *  Summary:	Unit test and benchmark for X3DTriMeshEditor.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: X3DTriMeshEditorTest.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <X3DTriMeshEditorTest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <X3DTriMesh.h>
+#include <X3DTriMeshEditor.h>
+#include <XMiscUtils.h>
+#include <XNumbers.h>
+#include <XUnitTestUtils.h>
+
+namespace Whisper {
+#if DEBUG
+
+
+//-----------------------------------
+//	Internal Constants
+//
+const uint32 kBenchmarkSize = 707;				// 2*707*707 is just under a million triangles
+
+
+// ===================================================================================
+//	Internal Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// CreateEditor
+//
+// The points are indexed by the triangles (three per triangle).
+//
+//---------------------------------------------------------------
+static X3DTriMeshEditor CreateEditor(const std::vector<X3DPoint>& points, const std::vector<uint32>& indices)
+{
+	std::vector<TQ3TriMeshTriangleData> triangles(indices.size()/3);
+	for (uint32 i = 0; i < triangles.size(); ++i)
+		for (uint32 j = 0; j < 3; ++j)
+			triangles[i].pointIndices[j] = indices[3*i + j];
+
+	TQ3TriMeshData data;
+	data.triMeshAttributeSet       = nil;
+	data.numTriangles              = triangles.size();
+	data.triangles                 = &triangles[0];
+	data.numTriangleAttributeTypes = 0;
+	data.triangleAttributeTypes    = nil;
+	data.numEdges                  = 0;
+	data.edges                     = nil;
+	data.numEdgeAttributeTypes     = 0;
+	data.edgeAttributeTypes        = nil;
+	data.numPoints                 = points.size();
+	data.points                    = const_cast<TQ3Point3D*>(static_cast<const TQ3Point3D*>(points[0]));
+	data.numVertexAttributeTypes   = 0;
+	data.vertexAttributeTypes      = nil;
+	data.bBox.min                  = kZero3DPt;
+	data.bBox.max                  = kZero3DPt;
+	data.bBox.isEmpty              = kQ3True;
+
+	return X3DTriMeshEditor(data);
+}
+
+
+//---------------------------------------------------------------
+//
+// GetSoup
+//
+// Returns a size x size grid of quads in the xz plane where every
+// triangle has its own vertices. Each coordinate is moved by up
+// to jitter.
+//
+//---------------------------------------------------------------
+static void GetSoup(uint32 size, float jitter, std::vector<X3DPoint>& points, std::vector<uint32>& indices)
+{
+	points.clear();
+	indices.clear();
+
+	for (uint32 row = 0; row < size; ++row) {
+		for (uint32 col = 0; col < size; ++col) {
+			const uint32 corners[6][2] = {{0, 0}, {0, 1}, {1, 0}, {1, 0}, {0, 1}, {1, 1}};
+
+			for (uint32 i = 0; i < 6; ++i) {
+				float x = (float) (col + corners[i][0]) + Random(-jitter, jitter);
+				float z = (float) (row + corners[i][1]) + Random(-jitter, jitter);
+
+				indices.push_back(points.size());
+				points.push_back(X3DPoint(x, Random(-jitter, jitter), z));
+			}
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// GetGrid
+//
+// Returns a size x size grid of quads with shared vertices and
+// the triangles in random order.
+//
+//---------------------------------------------------------------
+static void GetGrid(uint32 size, std::vector<X3DPoint>& points, std::vector<uint32>& indices)
+{
+	points.clear();
+	indices.clear();
+
+	for (uint32 row = 0; row <= size; ++row)
+		for (uint32 col = 0; col <= size; ++col)
+			points.push_back(X3DPoint((float) col, 0.0f, (float) row));
+
+	for (uint32 row = 0; row < size; ++row) {
+		for (uint32 col = 0; col < size; ++col) {
+			uint32 index = row*(size + 1) + col;
+
+			indices.push_back(index);
+			indices.push_back(index + size + 1);
+			indices.push_back(index + 1);
+
+			indices.push_back(index + 1);
+			indices.push_back(index + size + 1);
+			indices.push_back(index + size + 2);
+		}
+	}
+
+	uint32 numTriangles = indices.size()/3;
+	for (uint32 i = numTriangles - 1; i > 0; --i) {
+		uint32 j = Random(i + 1);
+		for (uint32 k = 0; k < 3; ++k)
+			std::swap(indices[3*i + k], indices[3*j + k]);
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// GetCube
+//
+// Returns a unit cube with counter-clockwise faces and unshared
+// vertices.
+//
+//---------------------------------------------------------------
+static void GetCube(std::vector<X3DPoint>& points, std::vector<uint32>& indices)
+{
+	const float corners[8][3] = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}};
+	const uint32 faces[6][4] = {{0, 3, 2, 1}, {4, 5, 6, 7}, {0, 1, 5, 4}, {3, 7, 6, 2}, {0, 4, 7, 3}, {1, 2, 6, 5}};
+
+	points.clear();
+	indices.clear();
+
+	for (uint32 i = 0; i < 6; ++i) {
+		const uint32 quad[6] = {0, 1, 2, 0, 2, 3};
+
+		for (uint32 j = 0; j < 6; ++j) {
+			const float* corner = corners[faces[i][quad[j]]];
+
+			indices.push_back(points.size());
+			points.push_back(X3DPoint(corner[0], corner[1], corner[2]));
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// CheckNormals
+//
+// Normals should be unit length and point away from the center of
+// the cube.
+//
+//---------------------------------------------------------------
+static void CheckNormals(const X3DTriMeshEditor& editor)
+{
+	const TQ3Vector3D* normals = static_cast<const TQ3Vector3D*>(editor.GetVertexAttribute(kQ3AttributeTypeNormal));
+	ASSERT(normals != nil);
+
+	for (uint32 i = 0; i < editor.GetNumPoints(); ++i) {
+		X3DVector normal(normals[i]);
+		ASSERT(std::fabs(normal.Length() - 1.0) < 1.0e-4);
+
+		const X3DPoint& pt = editor.GetPoints()[i];
+		X3DVector outward(pt.x - 0.5f, pt.y - 0.5f, pt.z - 0.5f);
+		ASSERT(DotProduct(normal, outward) > 0.0);
+	}
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class X3DTriMeshEditorTest
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditorTest::~X3DTriMeshEditorTest
+//
+//---------------------------------------------------------------
+X3DTriMeshEditorTest::~X3DTriMeshEditorTest()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditorTest::X3DTriMeshEditorTest
+//
+//---------------------------------------------------------------
+X3DTriMeshEditorTest::X3DTriMeshEditorTest() : XUnitTest(L"Quesa", L"Tri Mesh Editor")
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditorTest::OnTest
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditorTest::OnTest()
+{
+	this->DoTestWelding();
+	this->DoTestNormals();
+	this->DoTestReordering();
+
+	this->DoTime();
+
+	TRACE("Completed tri mesh editor test.\n\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditorTest::DoTestWelding
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditorTest::DoTestWelding()
+{
+	std::vector<X3DPoint> points;
+	std::vector<uint32> indices;
+
+	// Exact matches
+	GetSoup(10, 0.0f, points, indices);
+	X3DTriMeshEditor editor = CreateEditor(points, indices);
+
+	uint32 removed = editor.WeldVertices();
+	ASSERT(editor.GetNumPoints() == 11*11);
+	ASSERT(removed == points.size() - 11*11);
+	ASSERT(editor.GetNumTriangles() == 2*10*10);
+	ASSERT(editor.WeldVertices() == 0);
+
+	// Nearby matches
+	GetSoup(10, 0.001f, points, indices);
+	editor = CreateEditor(points, indices);
+
+	(void) editor.WeldVertices(0.0f);
+	ASSERT(editor.GetNumPoints() > 11*11);
+
+	(void) editor.WeldVertices(0.005f);
+	ASSERT(editor.GetNumPoints() == 11*11);
+
+	// Triangles that collapse are removed.
+	GetSoup(2, 0.0f, points, indices);
+	points[indices[0]] = points[indices[1]];
+	editor = CreateEditor(points, indices);
+
+	(void) editor.WeldVertices();
+	ASSERT(editor.GetNumTriangles() == 2*2*2 - 1);
+
+	// Vertices with different attributes aren't welded.
+	GetCube(points, indices);
+	editor = CreateEditor(points, indices);
+	editor.ComputeFacetedNormals();
+	ASSERT(editor.GetNumPoints() == 36);
+
+	(void) editor.WeldVertices();
+	ASSERT(editor.GetNumPoints() == 24);
+	CheckNormals(editor);
+
+	X3DTriMesh mesh = editor.CreateMesh();
+	X3DTriMeshEditor copy(mesh);
+	ASSERT(copy.GetNumPoints() == 24);
+	ASSERT(copy.GetNumTriangles() == 12);
+	ASSERT(copy.HasVertexAttribute(kQ3AttributeTypeNormal));
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditorTest::DoTestNormals
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditorTest::DoTestNormals()
+{
+	std::vector<X3DPoint> points;
+	std::vector<uint32> indices;
+	GetCube(points, indices);
+
+	X3DTriMeshEditor editor = CreateEditor(points, indices);
+	(void) editor.WeldVertices();
+	ASSERT(editor.GetNumPoints() == 8);
+
+	X3DTriMeshEditor smooth = editor;
+	smooth.ComputeSmoothNormals();
+	ASSERT(smooth.GetNumPoints() == 8);
+	CheckNormals(smooth);
+
+	X3DTriMeshEditor creased = editor;
+	creased.ComputeSmoothNormals(kPi/4.0);
+	ASSERT(creased.GetNumPoints() == 24);
+	CheckNormals(creased);
+
+	// Every vertex of a creased cube should be aligned with an axis.
+	const TQ3Vector3D* normals = static_cast<const TQ3Vector3D*>(creased.GetVertexAttribute(kQ3AttributeTypeNormal));
+	for (uint32 i = 0; i < creased.GetNumPoints(); ++i)
+		ASSERT(std::fabs(std::fabs(normals[i].x) + std::fabs(normals[i].y) + std::fabs(normals[i].z) - 1.0f) < 1.0e-4f);
+
+	X3DTriMeshEditor faceted = editor;
+	faceted.ComputeFacetedNormals();
+	ASSERT(faceted.GetNumPoints() == 36);
+	CheckNormals(faceted);
+
+	// Recomputing replaces the old normals.
+	faceted.ComputeSmoothNormals();
+	ASSERT(faceted.GetNumPoints() == 36);
+	CheckNormals(faceted);
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditorTest::DoTestReordering
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditorTest::DoTestReordering()
+{
+	std::vector<X3DPoint> points;
+	std::vector<uint32> indices;
+	GetGrid(40, points, indices);
+
+	X3DTriMeshEditor editor = CreateEditor(points, indices);
+	double before = editor.GetACMR();
+	ASSERT(before > 1.5);
+
+	editor.OptimizeVertexCache();
+	double after = editor.GetACMR();
+	ASSERT(after < 0.8);
+	ASSERT(editor.GetNumTriangles() == indices.size()/3);
+
+	// The triangles should be the same (apart from their order).
+	std::vector<uint32> counts(points.size(), 0);
+	for (uint32 i = 0; i < editor.GetNumTriangles(); ++i)
+		for (uint32 j = 0; j < 3; ++j)
+			++counts[editor.GetTriangles()[i].pointIndices[j]];
+	for (uint32 i = 0; i < indices.size(); ++i)
+		--counts[indices[i]];
+	for (uint32 i = 0; i < counts.size(); ++i)
+		ASSERT(counts[i] == 0);
+
+	std::vector<X3DPoint> oldPoints = editor.GetPoints();
+	std::vector<TQ3TriMeshTriangleData> oldTriangles = editor.GetTriangles();
+
+	editor.OptimizeVertexFetch();
+	ASSERT(editor.GetACMR() == after);
+
+	uint32 next = 0;
+	for (uint32 i = 0; i < editor.GetNumTriangles(); ++i) {
+		for (uint32 j = 0; j < 3; ++j) {
+			uint32 index = editor.GetTriangles()[i].pointIndices[j];
+			ASSERT(index <= next);
+			if (index == next)
+				++next;
+
+			ASSERT(editor.GetPoints()[index] == oldPoints[oldTriangles[i].pointIndices[j]]);
+		}
+	}
+	ASSERT(next == editor.GetNumPoints());
+}
+
+
+//---------------------------------------------------------------
+//
+// X3DTriMeshEditorTest::DoTime
+//
+//---------------------------------------------------------------
+void X3DTriMeshEditorTest::DoTime()
+{
+	std::vector<X3DPoint> points;
+	std::vector<uint32> indices;
+	GetSoup(kBenchmarkSize, 0.0f, points, indices);
+
+	X3DTriMeshEditor editor = CreateEditor(points, indices);
+	uint32 numTriangles = editor.GetNumTriangles();
+
+	MilliSecond start = GetMilliSeconds();
+	(void) editor.WeldVertices();
+	MilliSecond weld = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	editor.ComputeSmoothNormals();
+	MilliSecond normals = GetMilliSeconds() - start;
+
+	GetGrid(kBenchmarkSize, points, indices);
+	editor = CreateEditor(points, indices);
+	double before = editor.GetACMR();
+
+	start = GetMilliSeconds();
+	editor.OptimizeVertexCache();
+	MilliSecond cache = GetMilliSeconds() - start;
+
+	start = GetMilliSeconds();
+	editor.OptimizeVertexFetch();
+	MilliSecond fetch = GetMilliSeconds() - start;
+
+	TRACE("Tri mesh editor with ", numTriangles, " triangles (triangles per second):\n");
+	TRACE("   weld: ", GetRate(numTriangles, weld), ", smooth normals: ", GetRate(numTriangles, normals), "\n");
+	TRACE("   vertex cache: ", GetRate(numTriangles, cache), ", vertex fetch: ", GetRate(numTriangles, fetch), "\n");
+	TRACE("   ACMR (16 entry FIFO): ", before, " before, ", editor.GetACMR(), " after\n");
+}
+
+
+#endif	// DEBUG
+}		// namespace Whisper
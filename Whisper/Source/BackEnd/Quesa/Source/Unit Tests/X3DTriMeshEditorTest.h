@@ -0,0 +1,62 @@
+/*
+ *  File:       X3DTriMeshEditorTest.h
+ *  Summary:	Unit test and benchmark for X3DTriMeshEditor.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: X3DTriMeshEditorTest.h,v $
+ */
+
+#pragma once
+
+#include <XUnitTest.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class X3DTriMeshEditorTest
+// ===================================================================================
+#if DEBUG
+class X3DTriMeshEditorTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~X3DTriMeshEditorTest();
+
+						X3DTriMeshEditorTest();
+
+//-----------------------------------
+//	Inherited API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			void 		DoTestWelding();
+			void 		DoTestNormals();
+			void 		DoTestReordering();
+
+			void 		DoTime();
+};
+#endif
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
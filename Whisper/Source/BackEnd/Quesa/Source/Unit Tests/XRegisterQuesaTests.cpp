@@ -0,0 +1,47 @@
+/*
+ *  File:       XRegisterQuesaTests.cpp
+ *  Summary:   	Entry point used to install all the Quesa unit tests.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XRegisterQuesaTests.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XRegisterQuesaTests.h>
+
+#include <X3DMathTest.h>
+#include <X3DPickTreeTest.h>
+#include <X3DTriMeshEditorTest.h>
+
+#if DEBUG
+namespace Whisper {
+
+
+// ===================================================================================
+//	Global Functions
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// RegisterQuesaTests
+//
+// Like the other libraries the tests are registered explicitly
+// so the static ctors aren't dead-stripped. Note that Quesa has
+// to be initialized before the tests are run.
+//
+//---------------------------------------------------------------
+void RegisterQuesaTests()
+{
+	static X3DMathTest s3DMathTest;
+	static X3DPickTreeTest s3DPickTreeTest;
+	static X3DTriMeshEditorTest s3DTriMeshEditorTest;
+}
+
+
+}		// namespace Whisper
+#endif	// DEBUG
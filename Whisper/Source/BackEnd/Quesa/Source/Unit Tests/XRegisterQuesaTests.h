@@ -0,0 +1,37 @@
+/*
+ *  File:       XRegisterQuesaTests.h
+ *  Summary:   	Entry point used to install all the Quesa unit tests.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XRegisterQuesaTests.h,v $
+ */
+
+#pragma once
+
+#include <XTypes.h>
+
+#if DEBUG
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	Global Functions
+// ===================================================================================
+QUESA_EXPORT void 	RegisterQuesaTests();
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}		// namespace Whisper
+#endif	// DEBUG
\ No newline at end of file
@@ -26,8 +26,10 @@
 
 #include <X3DUtils.h>
 #include <XError.h>
+#include <XRegisterQuesaTests.h>
 #include <XTrace.h>
 #include <XTraceSinks.h>
+#include <XUnitTests.h>
 
 #include "CRollerCoaster.h"
 
@@ -168,6 +170,9 @@ void main()
 #if DEBUG
 		XDebuggerSink sink;
 		XTrace::Instance()->AddSink(&sink);
+		
+		RegisterQuesaTests();					// the tests use Quesa so they have to run after Init3D
+		XUnitTests::Instance()->RunAllTests();
 #endif
 
 		sCoaster = new CRollerCoaster;
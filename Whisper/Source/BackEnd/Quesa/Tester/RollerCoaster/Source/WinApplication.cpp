@@ -23,8 +23,10 @@
 #include <X3DUtils.h>
 #include <XError.h>
 #include <XExceptions.h>
+#include <XRegisterQuesaTests.h>
 #include <XTrace.h>
 #include <XTraceSinks.h>
+#include <XUnitTests.h>
 
 #include "CRollerCoaster.h"
 
@@ -109,6 +111,12 @@ int CALLBACK WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 		ThrowIf(err != noErr);
 		
 		Init3D();
+		
+#if DEBUG
+		RegisterQuesaTests();					// the tests use Quesa so they have to run after Init3D
+		XUnitTests::Instance()->RunAllTests();
+#endif
+
 		sCoaster = new CRollerCoaster;
 
 		StartTimer();
@@ -148,6 +148,7 @@
 #include <IUndoActionHelper.h>
 #include <IUndoActions.h>
 #include <IUndoContext.h>
+#include <IUndoFootprint.h>
 #include <IUserControl.h>
 #include <IValidate.h>
 #include <IValueChanged.h>
@@ -576,6 +577,7 @@ void RegisterUIInterfaces()
 	REGISTER_INTERFACE_NAME(IUndoActionHelper, L"IUndoActionHelper");
 	REGISTER_INTERFACE_NAME(IUndoCallbackAction, L"IUndoCallbackAction");
 	REGISTER_INTERFACE_NAME(IUndoContext, L"IUndoContext");
+	REGISTER_INTERFACE_NAME(IUndoFootprint, L"IUndoFootprint");
 	REGISTER_INTERFACE_NAME(IUserControl, L"IUserControl");
 	
 	REGISTER_INTERFACE_NAME(IValidate, L"IValidate");
@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include <climits>
+
 #include <XInterfacePtr.h>
 #include <XUnknown.h>
 
@@ -38,9 +40,26 @@ class ICommand;
 typedef XInterfacePtr<ICommand> ICommandPtr;
 
 
+//-----------------------------------
+//	Constants
+//
+const int32 kLowCommandPriority		= -100;
+const int32 kNormalCommandPriority	= 0;
+const int32 kHighCommandPriority	= 100;
+
+const MilliSecond kNoCommandDeadline = LONG_MAX;
+
+
 // ===================================================================================
 //	class ICommandQueue
 //!		A list of ICommand objects.
+/*!		Commands may be posted from any thread. Commands are executed by the thread that 
+ *		calls ExecuteCommands (normally the main thread) in priority order. Commands that 
+ *		have been waiting longer than their deadline are executed first. 
+ *
+ *		Commands can also be posted with a key. If a command with the same key is still 
+ *		in the queue the new command replaces it. This is useful for things like redraws 
+ *		and resizes where only the latest request matters. */
 // ===================================================================================
 class ICommandQueue : public XUnknown {
 
@@ -51,18 +70,29 @@ class ICommandQueue : public XUnknown {
 //
 public:
 	virtual void 		Post(const ICommandPtr& command) = 0;
-						/**< Call this to place a command in the queue. */
+						/**< Call this to place a command in the queue. This is the same as
+						Post(command, kNormalCommandPriority). */
+
+	virtual void 		Post(const ICommandPtr& command, int32 priority, uint32 key = 0, MilliSecond maxDelay = kNoCommandDeadline) = 0;
+						/**< Commands with higher priorities are executed first. If key isn't
+						zero and a command with the same key is queued the new command
+						replaces the old command (and uses the higher priority and the
+						earlier deadline). If the command hasn't executed within maxDelay
+						milliseconds it's executed before commands that aren't overdue. */
 							
 	virtual bool		ExecuteCommands() = 0;
 						/**< Iterates through all the commands and executes all the ones
 						that are ready to be executed. Returns true if a command was
-						executed. */
+						executed. Commands posted while this executes won't execute until
+						the next call. */
 						
 	virtual bool 		HasCommands() const = 0;
-						/**< Returns true if there's a command that's ready to execute. */
+						/**< Returns true if there's a command that's ready to execute. This
+						should be called from the thread that executes the commands. */
 						
 	virtual void 		Clear() = 0;
-						/**< Release all the commands in the queue. */
+						/**< Release all the commands in the queue. This should be called 
+						from the thread that executes the commands. */
 };
 
 typedef XInterfacePtr<ICommandQueue> ICommandQueuePtr;
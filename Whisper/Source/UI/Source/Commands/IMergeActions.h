@@ -46,7 +46,7 @@ class IMergeActions : public XUnknown {
 //
 public:
 	virtual bool 		CanMerge(const IConstUndoActionPtr& newAction) const = 0;
-						/**< After newAction is executed XUndoAction will check to see
+						/**< After newAction is executed IUndoContext will check to see
 						if the action on the top of the undo stack has the same boss as
 						newAction. If the bosses match it will query for an IMergeActions
 						interface and call CanMerge on the action on the top of the undo
@@ -76,6 +76,15 @@ public:
 	virtual void		SetMaxCommands(uint32 newMax) = 0;
 						/**< Defaults to 32. */
 			
+	virtual void		SetMaxBytes(uint32 newMax) = 0;
+						/**< The oldest undo actions are discarded when the actions on the
+						undo and redo stacks use more than this many bytes (the most recent
+						action is always kept). Actions report their size using the optional
+						IUndoFootprint interface. Defaults to 8 MB. */
+			
+	virtual uint32		GetNumBytes() const = 0;
+						/**< Returns the number of bytes used by the undo and redo stacks. */
+			
 	virtual IUndoActionPtr GetUndoCommand() const = 0;
 						/**< Returns the command that will be executed when the user selects Undo.
 						This is useful for accumulating commands (eg typing characters). */
@@ -90,6 +99,10 @@ public:
 //
 public:
 	virtual void		AddCommand(const IUndoActionPtr& action) = 0;
+						/**< Called after the action has been executed. If the action on the
+						top of the undo stack has the same boss and its IMergeActions
+						interface OKs the merge the two actions are merged. Otherwise the
+						action is pushed onto the undo stack. */
 						
 	virtual bool		HasCommand(const IUndoActionPtr& action) const = 0;
 };
@@ -0,0 +1,59 @@
+/*
+ *  File:       IUndoFootprint.h
+ *  Summary:   	Optional interface used by IUndoContext to keep the undo history within a memory budget.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: IUndoFootprint.h,v $
+ */
+
+#pragma once
+
+#include <XInterfacePtr.h>
+#include <XUnknown.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class IUndoFootprint
+//!		Optional interface used by IUndoContext to keep the undo history within a memory budget.
+/*!		Undo actions that save a lot of state (eg the pixels under a paint stroke) should
+ *		add this interface to their boss. Actions without it are assumed to be small. */
+// ===================================================================================
+class IUndoFootprint : public XUnknown {
+
+//-----------------------------------
+//	API
+//
+public:
+	virtual uint32 		GetFootprint() const = 0;
+						/**< Returns the approximate number of bytes used to undo and redo
+						the action. The context calls this after the action is executed,
+						merged, compacted, undone, and redone so the value may change. */
+
+	virtual void 		Compact() = 0;
+						/**< Called when the action has been pushed a few levels down the
+						undo stack and is unlikely to be undone soon. Actions can use this
+						to compress their state (see XUndoPayload) or to write it to a temp
+						file. The state should be restored when the action is undone or
+						redone. Note that this may be called more than once. */
+};
+
+typedef XInterfacePtr<IUndoFootprint> IUndoFootprintPtr;
+typedef XInterfacePtr<const IUndoFootprint> IConstUndoFootprintPtr;
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper
@@ -22,22 +22,95 @@
  *		1) Removed double CRs introduced during the initial checkin. 2) Changed the header comments to make it clearer that Whisper is using the zlib license agreement. 3) Added the Log keyword.
  */
 
+
 #include <XWhisperHeader.h>
 #include <ICommandQueue.h>
 
-#include <list>
+#include <algorithm>
+#include <map>
+#include <vector>
 
 #include <ICommand.h>
+#include <XCriticalSection.h>
 #include <XInterfaceMacros.h>
 #include <XMiscUtils.h>
+#include <XNumbers.h>
 #include <XStringUtils.h>
 
+#if DEBUG
+	#include <ICommands.h>
+	#include <XBind.h>
+	#include <XIOU.h>
+	#include <XThread.h>
+	#include <XUnitTest.h>
+#endif
+
+#if DEBUG && MAC
+	#include <MSystemInfo.h>
+#endif
+
 namespace Whisper {
 
 
+// ===================================================================================
+//	Internal Types
+// ===================================================================================
+struct SQueuedCommand {
+	ICommandPtr		command;
+	int32			priority;
+	uint32			key;				// 0 if the command isn't coalesced
+	bool			hasDeadline;
+	MilliSecond		deadline;
+	uint32			sequence;			// commands with the same priority execute in the order they were posted
+	SQueuedCommand*	next;				// used by the posted list
+};
+
+
+//---------------------------------------------------------------
+//
+// SExecutesBefore
+//
+// Overdue commands go first (earliest deadline first), then the
+// other commands by priority and post order. Times and sequence 
+// numbers are compared with subtraction so they can wrap.
+//
+//---------------------------------------------------------------
+struct SExecutesBefore {
+			SExecutesBefore(MilliSecond now) : mNow(now)	{}
+
+	bool 	IsOverdue(const SQueuedCommand* entry) const	{return entry->hasDeadline && mNow - entry->deadline >= 0;}
+
+	bool 	operator()(const SQueuedCommand* lhs, const SQueuedCommand* rhs) const
+	{
+		bool lhsOverdue = this->IsOverdue(lhs);
+		bool rhsOverdue = this->IsOverdue(rhs);
+		
+		if (lhsOverdue != rhsOverdue)
+			return lhsOverdue;
+		
+		if (lhsOverdue && lhs->deadline != rhs->deadline)
+			return lhs->deadline - rhs->deadline < 0;
+		
+		if (lhs->priority != rhs->priority)
+			return lhs->priority > rhs->priority;
+		
+		return (int32) (lhs->sequence - rhs->sequence) < 0;
+	}
+	
+	MilliSecond	mNow;
+};
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
 // ===================================================================================
 //	class XCommandQueue
 //!		A list of ICommand objects.
+/*!		Posting only takes the lock long enough to append to a linked list so threads
+ *		that post commands don't wait for commands to execute. ExecuteCommands swaps
+ *		out the posted list, merges it into the pending commands (replacing commands 
+ *		with the same key), sorts them, and executes them without holding the lock. */
 // ===================================================================================
 class XCommandQueue : public ICommandQueue {
 
@@ -56,6 +129,8 @@ public:
 //
 public:
 	virtual void 		Post(const ICommandPtr& command);
+
+	virtual void 		Post(const ICommandPtr& command, int32 priority, uint32 key = 0, MilliSecond maxDelay = kNoCommandDeadline);
 							
 	virtual bool		ExecuteCommands();
 						
@@ -67,16 +142,31 @@ public:
 //	Internal Types
 //
 protected:
-	typedef std::list<ICommandPtr> CommandQueue;
+	typedef std::vector<SQueuedCommand*> Commands;
+	typedef std::map<uint32, SQueuedCommand*> KeyedCommands;
+
+//-----------------------------------
+//	Internal API
+//
+protected:
+			SQueuedCommand* DoTakePosted();
+			void 		DoMerge(SQueuedCommand* posted);
+			void 		DoDelete(SQueuedCommand* entry);
 
 //-----------------------------------
 //	Member Data
 //
 private:
 	bool						mExecutingCommands;
+	bool						mCleared;			// true if Clear was called while commands were executing
 	
-	CommandQueue				mCommands;
-	CommandQueue				mTempQueue;
+	Commands					mPending;			// these are only touched by the thread executing commands
+	Commands					mBatch;
+	KeyedCommands				mKeyed;
+
+	SQueuedCommand*				mPostedHead;		// these are protected by mMutex
+	SQueuedCommand*				mPostedTail;
+	uint32						mSequence;
 	mutable XCriticalSection	mMutex;
 };
 
@@ -89,6 +179,9 @@ DEFINE_INTERFACE_FACTORY(XCommandQueue)
 //---------------------------------------------------------------
 XCommandQueue::~XCommandQueue()
 {
+	PRECONDITION(!mExecutingCommands);
+	
+	this->Clear();
 }
 
 
@@ -102,22 +195,52 @@ XCommandQueue::XCommandQueue(XBoss* boss)
 	this->DoSetBoss(boss);
 
 	mExecutingCommands = false;
+	mCleared = false;
+	
+	mPostedHead = nil;
+	mPostedTail = nil;
+	mSequence = 0;
 }
 
 
 //---------------------------------------------------------------
 //
-// XCommandQueue::Post
+// XCommandQueue::Post (ICommandPtr)
 //
 //---------------------------------------------------------------
 void XCommandQueue::Post(const ICommandPtr& command)				
 {
+	this->Post(command, kNormalCommandPriority);
+}
+
+
+//---------------------------------------------------------------
+//
+// XCommandQueue::Post (ICommandPtr, int32, uint32, MilliSecond)
+//
+//---------------------------------------------------------------
+void XCommandQueue::Post(const ICommandPtr& command, int32 priority, uint32 key, MilliSecond maxDelay)				
+{
+	PRECONDITION(command.IsValid());
+	PRECONDITION(maxDelay >= 0);
+	
+	SQueuedCommand* entry = new SQueuedCommand;
+	entry->command     = command;
+	entry->priority    = priority;
+	entry->key         = key;
+	entry->hasDeadline = maxDelay != kNoCommandDeadline;
+	entry->deadline    = entry->hasDeadline ? GetMilliSeconds() + maxDelay : 0;
+	entry->next        = nil;
+
 	XEnterCriticalSection enter(mMutex);
 
-	if (mExecutingCommands)
-		mTempQueue.push_back(command);
+	entry->sequence = mSequence++;
+	
+	if (mPostedTail != nil)
+		mPostedTail->next = entry;
 	else 
-		mCommands.push_back(command);
+		mPostedHead = entry;
+	mPostedTail = entry;
 }
 
 
@@ -130,16 +253,19 @@ bool XCommandQueue::HasCommands() const
 {
 	bool has = false;
 	
-	XEnterCriticalSection enter(mMutex);
-
-	CommandQueue::const_iterator iter = mCommands.begin();
-	while (iter != mCommands.end() && !has) {
-		const ICommandPtr& command = *iter;
-		++iter;
+	for (Commands::const_iterator iter = mPending.begin(); iter != mPending.end() && !has; ++iter) {
+		const SQueuedCommand* entry = *iter;
 		
-		has = command->IsReadyToExecute();
+		has = entry->command->IsReadyToExecute();
 	}	
 	
+	if (!has) {
+		XEnterCriticalSection enter(mMutex);
+
+		for (const SQueuedCommand* entry = mPostedHead; entry != nil && !has; entry = entry->next) 
+			has = entry->command->IsReadyToExecute();
+	}
+	
 	return has;
 }
 
@@ -151,7 +277,21 @@ bool XCommandQueue::HasCommands() const
 //---------------------------------------------------------------
 void XCommandQueue::Clear()
 {
-	mCommands.clear();
+	SQueuedCommand* posted = this->DoTakePosted();
+	while (posted != nil) {
+		SQueuedCommand* next = posted->next;
+		delete posted;
+		posted = next;
+	}
+	
+	for (Commands::iterator iter = mPending.begin(); iter != mPending.end(); ++iter) 
+		delete *iter;
+	
+	mPending.clear();
+	mKeyed.clear();
+	
+	if (mExecutingCommands)
+		mCleared = true;					// ExecuteCommands will delete the rest of the batch
 }
 
 
@@ -165,37 +305,399 @@ bool XCommandQueue::ExecuteCommands()
 	bool didOne = false;
 	
 	PRECONDITION(!mExecutingCommands);
-	mExecutingCommands = true;
+
+	this->DoMerge(this->DoTakePosted());
 	
-	// Execute all the available commands.
+	if (!mPending.empty()) {
+		mExecutingCommands = true;
+		mCleared = false;
+		
+		std::sort(mPending.begin(), mPending.end(), SExecutesBefore(GetMilliSeconds()));
+		mBatch.swap(mPending);
+		
+		// Execute all the available commands. Commands that are posted
+		// while we're doing this go into the posted list so they won't
+		// execute until the next time we're called.
+		for (Commands::iterator iter = mBatch.begin(); iter != mBatch.end(); ++iter) {
+			SQueuedCommand* entry = *iter;
+			
+			if (!mCleared && entry->command->IsReadyToExecute()) {
+				bool completed = entry->command->HandleExecute();	// returns false if an exception is thrown
+				didOne = true;
+				
+				if (completed && entry->command->KeepInQueue() && !mCleared)
+					mPending.push_back(entry);
+				else
+					this->DoDelete(entry);
+			
+			} else if (mCleared) 
+				this->DoDelete(entry);
+			
+			else
+				mPending.push_back(entry);
+		}	
+		
+		mBatch.clear();
+		mExecutingCommands = false;
+	}
+			
+	return didOne;
+}
+
+
+//---------------------------------------------------------------
+//
+// XCommandQueue::DoTakePosted
+//
+// This is the only place (besides Post) where the lock is taken.
+//
+//---------------------------------------------------------------
+SQueuedCommand* XCommandQueue::DoTakePosted()
+{
 	XEnterCriticalSection enter(mMutex);
+	
+	SQueuedCommand* posted = mPostedHead;
+	mPostedHead = nil;
+	mPostedTail = nil;
+	
+	return posted;
+}
 
-	CommandQueue::iterator iter = mCommands.begin();
-	while (!mCommands.empty() && iter != mCommands.end()) {
-		CommandQueue::iterator temp = iter;
 
-		ICommandPtr command = *iter;
-		++iter;
+//---------------------------------------------------------------
+//
+// XCommandQueue::DoMerge
+//
+//---------------------------------------------------------------
+void XCommandQueue::DoMerge(SQueuedCommand* posted)
+{
+	while (posted != nil) {
+		SQueuedCommand* entry = posted;
+		posted = posted->next;
+		entry->next = nil;
 		
-		if (command->IsReadyToExecute()) {
-			bool completed = command->HandleExecute();	// returns false if an exception is thrown
+		KeyedCommands::iterator iter = entry->key != 0 ? mKeyed.find(entry->key) : mKeyed.end();
+		if (iter != mKeyed.end()) {
+			SQueuedCommand* old = iter->second;			// the old command keeps its place in line
+			old->command  = entry->command;
+			old->priority = Max(old->priority, entry->priority);
 			
-			if (!completed || !command->KeepInQueue())
-				mCommands.erase(temp);
-				
-			didOne = true;
+			if (entry->hasDeadline && (!old->hasDeadline || entry->deadline - old->deadline < 0)) {
+				old->hasDeadline = true;
+				old->deadline    = entry->deadline;
+			}
+			
+			delete entry;
+		
+		} else {
+			mPending.push_back(entry);
+			
+			if (entry->key != 0)
+				mKeyed.insert(KeyedCommands::value_type(entry->key, entry));
 		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XCommandQueue::DoDelete
+//
+//---------------------------------------------------------------
+void XCommandQueue::DoDelete(SQueuedCommand* entry)
+{
+	if (entry->key != 0) {
+		KeyedCommands::iterator iter = mKeyed.find(entry->key);
+		if (iter != mKeyed.end() && iter->second == entry)
+			mKeyed.erase(iter);
+	}
+	
+	delete entry;
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class ZCommandQueueTest
+// ===================================================================================	
+#if DEBUG
+const uint32 kNumPostThreads = 4;
+const uint32 kNumPosts       = 25000;			// per thread
+const uint32 kNumKeys        = 8;
+
+class ZCommandQueueTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~ZCommandQueueTest();
+	
+						ZCommandQueueTest();
+						
+//-----------------------------------
+//	API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+private:
+			void 		DoTestOrdering(XCommandQueue& queue);
+			void 		DoTestCoalescing(XCommandQueue& queue);
+			void 		DoTime(XCommandQueue& queue);
+
+			void 		DoPostLoop(XIOU<uint32>& result, uint32 index);
+
+			void 		DoRecord(int32 id)					{mOrder.push_back(id);}
+			void 		DoCount()							{++mCount;}
+			void 		DoCountKeyed()						{++mKeyedCount;}
+			
+	static	ICommandPtr DoCreateCommand(const XCallback0<void>& callback);
+
+//-----------------------------------
+//	Member Data
+//
+private:
+	std::vector<int32>	mOrder;
+	uint32				mCount;
+	uint32				mKeyedCount;
+	
+	XCommandQueue*		mQueue;
+	ICommandPtr			mCommands[kNumPostThreads];
+	ICommandPtr			mKeyedCommands[kNumPostThreads];
+};
+
+static ZCommandQueueTest sCommandQueueTest;
+
+//---------------------------------------------------------------
+//
+// ZCommandQueueTest::~ZCommandQueueTest
+//
+//---------------------------------------------------------------
+ZCommandQueueTest::~ZCommandQueueTest()
+{
+}
+
+	
+//---------------------------------------------------------------
+//
+// ZCommandQueueTest::ZCommandQueueTest
+//
+//---------------------------------------------------------------
+ZCommandQueueTest::ZCommandQueueTest() : XUnitTest(L"UI", L"Command Queue")
+{
+	mCount = 0;
+	mKeyedCount = 0;
+	mQueue = nil;
+}
+
+						
+//---------------------------------------------------------------
+//
+// ZCommandQueueTest::OnTest
+//
+// Uses its own queue (on the app boss) so that the app's commands 
+// aren't affected.
+//
+//---------------------------------------------------------------
+void ZCommandQueueTest::OnTest()
+{
+	ICommandQueuePtr app(L"Application");
+	XCommandQueue queue(app->GetBoss());
+	
+	this->DoTestOrdering(queue);
+	this->DoTestCoalescing(queue);
+
+#if MAC
+	if (!MSystemInfo::HasThreadMgr()) {
+		TRACE("Skipped the command queue benchmark (the Thread Manager isn't installed).\n\n");
+		return;
 	}	
+#endif
+
+	this->DoTime(queue);
 	
-	// Move commands from mTempQueue to mCommands. (New commands 
-	// are placed in mTempQueue to prevent them from executing while
-	// we're processing the original command queue).
-	mCommands.splice(mCommands.end(), mTempQueue);
+	TRACE("Completed command queue test.\n\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// ZCommandQueueTest::DoTestOrdering
+//
+//---------------------------------------------------------------
+void ZCommandQueueTest::DoTestOrdering(XCommandQueue& queue)
+{
+	XCallback1<void, int32> record(this, &ZCommandQueueTest::DoRecord);
 	
-	mExecutingCommands = false;
+	mOrder.clear();
+	queue.Post(DoCreateCommand(Bind1(record, 1)), kLowCommandPriority);
+	queue.Post(DoCreateCommand(Bind1(record, 2)));
+	queue.Post(DoCreateCommand(Bind1(record, 3)), kHighCommandPriority);
+	queue.Post(DoCreateCommand(Bind1(record, 4)));
+	queue.Post(DoCreateCommand(Bind1(record, 5)), kLowCommandPriority, 0, 0);	// already overdue
+	ASSERT(queue.HasCommands());
+	
+	VERIFY(queue.ExecuteCommands());
+	ASSERT(!queue.HasCommands());
+	ASSERT(!queue.ExecuteCommands());
+	
+	ASSERT(mOrder.size() == 5);
+	ASSERT(mOrder[0] == 5);
+	ASSERT(mOrder[1] == 3);
+	ASSERT(mOrder[2] == 2);
+	ASSERT(mOrder[3] == 4);
+	ASSERT(mOrder[4] == 1);
+	
+	queue.Post(DoCreateCommand(Bind1(record, 6)));
+	queue.Clear();
+	ASSERT(!queue.ExecuteCommands());
+}
+
+
+//---------------------------------------------------------------
+//
+// ZCommandQueueTest::DoTestCoalescing
+//
+//---------------------------------------------------------------
+void ZCommandQueueTest::DoTestCoalescing(XCommandQueue& queue)
+{
+	XCallback1<void, int32> record(this, &ZCommandQueueTest::DoRecord);
+	
+	mOrder.clear();
+	queue.Post(DoCreateCommand(Bind1(record, 1)), kNormalCommandPriority, 'Drw1');
+	queue.Post(DoCreateCommand(Bind1(record, 2)));
+	queue.Post(DoCreateCommand(Bind1(record, 3)), kNormalCommandPriority, 'Drw1');
+	queue.Post(DoCreateCommand(Bind1(record, 4)), kHighCommandPriority, 'Drw2');
+	queue.Post(DoCreateCommand(Bind1(record, 5)), kLowCommandPriority, 'Drw1');
+	
+	VERIFY(queue.ExecuteCommands());
+	
+	ASSERT(mOrder.size() == 3);
+	ASSERT(mOrder[0] == 4);
+	ASSERT(mOrder[1] == 5);					// latest command but the first command's place and priority
+	ASSERT(mOrder[2] == 2);
+	
+	// Once the command has executed the key can be reused.
+	queue.Post(DoCreateCommand(Bind1(record, 6)), kNormalCommandPriority, 'Drw1');
+	VERIFY(queue.ExecuteCommands());
+	ASSERT(mOrder.size() == 4);
+	ASSERT(mOrder[3] == 6);
+}
+
+
+//---------------------------------------------------------------
+//
+// ZCommandQueueTest::DoTime
+//
+// Several threads post commands (half of them coalesced) while 
+// this thread executes them.
+//
+//---------------------------------------------------------------
+void ZCommandQueueTest::DoTime(XCommandQueue& queue)
+{
+	for (uint32 i = 0; i < kNumPostThreads; ++i) {
+		mCommands[i] = DoCreateCommand(XCallback0<void>(this, &ZCommandQueueTest::DoCount));
+		mKeyedCommands[i] = DoCreateCommand(XCallback0<void>(this, &ZCommandQueueTest::DoCountKeyed));
+	}
+	
+	mQueue = &queue;
+	mCount = 0;
+	mKeyedCount = 0;
+
+	std::vector<XIOU<uint32> > posts;
+	for (uint32 i = 0; i < kNumPostThreads; ++i)
+		posts.push_back(XIOU<uint32>());			// XIOU's are references so we can't use the vector fill ctor
+
+	MilliSecond start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumPostThreads; ++i) {
+		XCallback2<void, XIOU<uint32>&, uint32> temp(this, &ZCommandQueueTest::DoPostLoop);
+		XThread::ErrorHandler errors(&posts[i], &XIOU<uint32>::Abort);
+
+		XThread* thread = XThread::Create(Bind2(temp, posts[i], i), errors);
+		thread->Start();
+		thread->RemoveReference();
+	}
+	
+	uint32 batches = 0;
+	uint32 done = 0;
+	while (done < kNumPostThreads) {
+		if (queue.ExecuteCommands())
+			++batches;
+		XThread::Yield();
 		
-	return didOne;
+		done = 0;
+		for (uint32 i = 0; i < kNumPostThreads; ++i)
+			if (posts[i].Redeemable() || posts[i].Aborted())
+				++done;
+	}
+	
+	while (queue.ExecuteCommands())
+		++batches;
+	MilliSecond elapsed = GetMilliSeconds() - start;
+	
+	uint32 total = 0;
+	for (uint32 i = 0; i < kNumPostThreads; ++i) {
+		ASSERT(posts[i].Redeemable());
+		total += posts[i].Redeem();
+	}
+	
+	ASSERT(mCount == total/2);
+	ASSERT(mKeyedCount >= kNumKeys);
+	ASSERT(mKeyedCount <= total/2);
+
+	for (uint32 i = 0; i < kNumPostThreads; ++i) {
+		mCommands[i] = ICommandPtr();
+		mKeyedCommands[i] = ICommandPtr();
+	}
+	mQueue = nil;
+	
+	TRACE("Posted ", total, " commands from ", kNumPostThreads, " threads in ", elapsed, " ms (", 1000.0*total/Max(elapsed, 1L), " per second)\n");
+	TRACE("   executed ", mCount, " commands and ", mKeyedCount, " of ", total/2, " coalesced commands in ", batches, " batches\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// ZCommandQueueTest::DoPostLoop
+//
+//---------------------------------------------------------------
+void ZCommandQueueTest::DoPostLoop(XIOU<uint32>& result, uint32 index)
+{
+	for (uint32 i = 0; i < kNumPosts; ++i) {
+		if ((i & 1) == 0)
+			mQueue->Post(mCommands[index]);
+		else
+			mQueue->Post(mKeyedCommands[index], kNormalCommandPriority, 1 + (i/2) % kNumKeys);
+		
+		if ((i & 0xFF) == 0)
+			XThread::Yield();
+	}
+	
+	result.Fulfill(kNumPosts);
+}
+
+
+//---------------------------------------------------------------
+//
+// ZCommandQueueTest::DoCreateCommand						[static]
+//
+//---------------------------------------------------------------
+ICommandPtr ZCommandQueueTest::DoCreateCommand(const XCallback0<void>& callback)
+{
+	ICommandPtr command(L"Callback Command");
+	
+	ICallbackCommandPtr init(command);
+	init->Init(callback);
+	
+	return command;
 }
+#endif	// DEBUG
 
 
 }	// namespace Whisper
@@ -35,7 +35,6 @@
 #include <IUndoAction.h>
 
 #include <IActiveUndoContext.h>
-#include <IMergeActions.h>
 #include <IUndoActionHelper.h>
 #include <IUndoActions.h>
 #include <IUndoContext.h>
@@ -74,7 +73,6 @@ public:
 //	Internal API
 //
 private:
-			bool 		DoMerge();
 			bool 		DoSequence();
 	
 //-----------------------------------
@@ -160,8 +158,7 @@ void XUndoAction::HandleDo()
 		helper->OnDo();			
 
 		if (mContext)
-			if (!this->DoMerge())
-				mContext->AddCommand(this);		// 'this' is saved on the undo stack so it will stick around
+			mContext->AddCommand(this);			// 'this' is saved on the undo stack (unless it's merged) so it will stick around
 	}
 }
 
@@ -206,29 +203,6 @@ std::wstring XUndoAction::GetText() const
 #pragma mark ~
 #endif
 
-//---------------------------------------------------------------
-//
-// XUndoAction::DoMerge
-//
-// Join the two actions iff we find the merge interface, the 
-// bosses match, and the action OKs the merge.
-//
-//---------------------------------------------------------------
-bool XUndoAction::DoMerge()
-{
-	bool merged = false;
-	
-	IMergeActionsPtr merge = mContext->GetUndoCommand();
-	
-	if (merge && merge->GetBoss()->GetName() == this->GetBoss()->GetName() && merge->CanMerge(this)) {
-		merge->Merge(this);				// 'this' will be deleted when we return
-		merged = true;
-	}
-		
-	return merged;
-}
-
-
 //---------------------------------------------------------------
 //
 // XUndoAction::DoSequence
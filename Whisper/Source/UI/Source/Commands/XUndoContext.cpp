@@ -19,25 +19,54 @@
  *		1) Removed double CRs introduced during the initial checkin. 2) Changed the header comments to make it clearer that Whisper is using the zlib license agreement. 3) Added the Log keyword.
  */
 
+
 #include <XWhisperHeader.h>
 #include <IUndoContext.h>
 
-#include <list>
+#include <deque>
+#include <set>
 
 #include <IActiveUndoContext.h>
+#include <IMergeActions.h>
 #include <IUndoAction.h>
+#include <IUndoFootprint.h>
 #include <XError.h>
 #include <XExceptions.h>
 #include <XInterfaceMacros.h>
 #include <XMiscUtils.h>
 #include <XStringUtils.h>
 
+#if DEBUG
+	#include <algorithm>
+	#include <vector>
+
+	#include <IUndoActions.h>
+	#include <XBoss.h>
+	#include <XNumbers.h>
+	#include <XTranscode.h>
+	#include <XUndoPayload.h>
+	#include <XUnitTest.h>
+#endif
+
 namespace Whisper {
 
 
+//-----------------------------------
+//	Internal Constants
+//
+const uint32 kDefaultMaxCommands = 32;
+const uint32 kDefaultMaxBytes    = 8*1024L*1024L;
+
+const uint32 kDefaultFootprint   = 256;		// used for actions without an IUndoFootprint interface
+const uint32 kCompactDepth       = 8;		// actions this far down the undo stack are compacted
+
+
 // ===================================================================================
 //	class XUndoContext
 //!		A context for undo (each window and the app typically have one of these).
+/*!		The undo history is bounded by both a command count and a byte budget. Actions
+ *		that implement IUndoFootprint are asked for their size whenever they change and
+ *		are compacted once they're kCompactDepth actions down the undo stack. */
 // ===================================================================================
 class XUndoContext : public IUndoContext {
 
@@ -46,7 +75,7 @@ class XUndoContext : public IUndoContext {
 //
 public:
 	virtual 			~XUndoContext();
-	
+
 						XUndoContext(XBoss* boss);
 
 //-----------------------------------
@@ -54,39 +83,73 @@ public:
 //
 public:
 	virtual bool		CanUndo() const;
-			
+
 	virtual void		Undo();
-			
+
 	virtual std::wstring GetUndoText() const;
-			
+
 	virtual bool		CanRedo() const;
-			
+
 	virtual void		Redo();
-			
+
 	virtual std::wstring GetRedoText() const;
-			
+
 	virtual void		ClearRedoHistory();
 
 	virtual void		ClearHistory();
-			
+
 	virtual void		SetMaxCommands(uint32 newMax);
-			
+
+	virtual void		SetMaxBytes(uint32 newMax);
+
+	virtual uint32		GetNumBytes() const						{return mNumBytes;}
+
 	virtual IUndoActionPtr GetUndoCommand() const;
-			
+
 	virtual IUndoActionPtr GetRedoCommand() const;
 
 	virtual void		AddCommand(const IUndoActionPtr& action);
-						
+
 	virtual bool		HasCommand(const IUndoActionPtr& action) const;
 
+//-----------------------------------
+//	Internal Types
+//
+private:
+	struct SEntry {
+		IUndoActionPtr	action;
+		uint32			bytes;
+		bool			compacted;
+
+				SEntry(const IUndoActionPtr& a) : action(a), bytes(0), compacted(false) {}
+	};
+
+	typedef std::deque<SEntry> Stack;
+
+//-----------------------------------
+//	Internal API
+//
+private:
+			void 		DoPush(Stack& stack, const IUndoActionPtr& action);
+			void 		DoRemove(const SEntry& entry);
+			void 		DoClear(Stack& stack);
+
+			bool 		DoMerge(const IUndoActionPtr& action);
+			void 		DoCompact(SEntry& entry);
+			void 		DoMeasure(SEntry& entry);
+			void 		DoTrim();
+
 //-----------------------------------
 //	Member Data
 //
 private:
-	uint32 						mMaxCommands;
-	
-	std::list<IUndoActionPtr>	mUndoStack;
-	std::list<IUndoActionPtr>	mRedoStack;
+	uint32 					mMaxCommands;
+	uint32 					mMaxBytes;
+	uint32 					mNumBytes;			// total for both stacks
+
+	Stack					mUndoStack;
+	Stack					mRedoStack;
+	std::set<const XBoss*>	mActions;			// the actions on both stacks (so HasCommand is fast)
 };
 
 DEFINE_INTERFACE_FACTORY(XUndoContext)
@@ -118,7 +181,9 @@ XUndoContext::XUndoContext(XBoss* boss)
 {
 	this->DoSetBoss(boss);
 
-	mMaxCommands = 32;			
+	mMaxCommands = kDefaultMaxCommands;
+	mMaxBytes = kDefaultMaxBytes;
+	mNumBytes = 0;
 }
 
 
@@ -130,7 +195,7 @@ XUndoContext::XUndoContext(XBoss* boss)
 bool XUndoContext::CanUndo() const
 {
 	bool can = !mUndoStack.empty();
-	
+
 	return can;
 }
 
@@ -143,23 +208,24 @@ bool XUndoContext::CanUndo() const
 void XUndoContext::Undo()
 {
 	PRECONDITION(this->CanUndo());
-	
+
 	IUndoActionPtr action;
-		
+
 	try {
-		action = mUndoStack.back();
+		action = mUndoStack.back().action;
+		this->DoRemove(mUndoStack.back());
 		mUndoStack.pop_back();
-	
+
 		action->HandleUndo();
-		
-		mRedoStack.push_back(action);
+
+		this->DoPush(mRedoStack, action);
 
 	} catch (const std::exception& e) {
 		XError::Instance()->ReportError(LoadWhisperString(L"Couldn't undo."), e);
-	
+
 	} catch (...) {
 		XError::Instance()->ReportError(LoadWhisperString(L"Couldn't undo."));
-	}			
+	}
 }
 
 
@@ -171,14 +237,14 @@ void XUndoContext::Undo()
 std::wstring XUndoContext::GetUndoText() const
 {
 	std::wstring text;
-	
+
 	if (this->CanUndo()) {
-		const IUndoActionPtr& action = mUndoStack.back();
+		const IUndoActionPtr& action = mUndoStack.back().action;
 		text = LoadWhisperString(L"Undo #1", action->GetText());
-		
+
 	} else
 		text = LoadWhisperString(L"Can't Undo");
-		
+
 	return text;
 }
 
@@ -191,10 +257,10 @@ std::wstring XUndoContext::GetUndoText() const
 IUndoActionPtr XUndoContext::GetUndoCommand() const
 {
 	IUndoActionPtr action;
-	
+
 	if (!mUndoStack.empty())
-		action = mUndoStack.back();
-		
+		action = mUndoStack.back().action;
+
 	return action;
 }
 
@@ -207,7 +273,7 @@ IUndoActionPtr XUndoContext::GetUndoCommand() const
 bool XUndoContext::CanRedo() const
 {
 	bool can = !mRedoStack.empty();
-	
+
 	return can;
 }
 
@@ -220,23 +286,24 @@ bool XUndoContext::CanRedo() const
 void XUndoContext::Redo()
 {
 	PRECONDITION(this->CanRedo());
-	
+
 	IUndoActionPtr action;
-		
+
 	try {
-		action = mRedoStack.back();
+		action = mRedoStack.back().action;
+		this->DoRemove(mRedoStack.back());
 		mRedoStack.pop_back();
 
 		action->HandleRedo();
-		
-		mUndoStack.push_back(action);
+
+		this->DoPush(mUndoStack, action);
 
 	} catch (const std::exception& e) {
 		XError::Instance()->ReportError(LoadWhisperString(L"Couldn't redo."), e);
-	
+
 	} catch (...) {
 		XError::Instance()->ReportError(LoadWhisperString(L"Couldn't redo."));
-	}			
+	}
 }
 
 
@@ -248,14 +315,14 @@ void XUndoContext::Redo()
 std::wstring XUndoContext::GetRedoText() const
 {
 	std::wstring text;
-	
+
 	if (this->CanRedo()) {
-		const IUndoActionPtr& action = mRedoStack.back();
+		const IUndoActionPtr& action = mRedoStack.back().action;
 		text = LoadWhisperString(L"Redo #1", action->GetText());
-		
+
 	} else
 		text = LoadWhisperString(L"Can't Redo");
-		
+
 	return text;
 }
 
@@ -268,10 +335,10 @@ std::wstring XUndoContext::GetRedoText() const
 IUndoActionPtr XUndoContext::GetRedoCommand() const
 {
 	IUndoActionPtr action;
-	
+
 	if (!mRedoStack.empty())
-		action = mRedoStack.back();
-		
+		action = mRedoStack.back().action;
+
 	return action;
 }
 
@@ -283,7 +350,7 @@ IUndoActionPtr XUndoContext::GetRedoCommand() const
 //---------------------------------------------------------------
 void XUndoContext::ClearRedoHistory()
 {
-	mRedoStack.clear();
+	this->DoClear(mRedoStack);
 }
 
 
@@ -294,8 +361,11 @@ void XUndoContext::ClearRedoHistory()
 //---------------------------------------------------------------
 void XUndoContext::ClearHistory()
 {
-	mRedoStack.clear();
-	mUndoStack.clear();
+	this->DoClear(mRedoStack);
+	this->DoClear(mUndoStack);
+
+	ASSERT(mNumBytes == 0);
+	ASSERT(mActions.empty());
 }
 
 
@@ -307,8 +377,23 @@ void XUndoContext::ClearHistory()
 void XUndoContext::SetMaxCommands(uint32 newMax)
 {
 	PRECONDITION(newMax >= 1);
-	
+
 	mMaxCommands = newMax;
+
+	this->DoTrim();
+}
+
+
+//---------------------------------------------------------------
+//
+// XUndoContext::SetMaxBytes
+//
+//---------------------------------------------------------------
+void XUndoContext::SetMaxBytes(uint32 newMax)
+{
+	mMaxBytes = newMax;
+
+	this->DoTrim();
 }
 
 #if __MWERKS__
@@ -319,19 +404,29 @@ void XUndoContext::SetMaxCommands(uint32 newMax)
 //
 // XUndoContext::AddCommand
 //
+// Note that the redo history is cleared even if the action is
+// merged (otherwise redo would restore state that's older than
+// the merged action).
+//
 //---------------------------------------------------------------
 void XUndoContext::AddCommand(const IUndoActionPtr& action)
 {
 	PRECONDITION(action);
-	PRECONDITION(std::find(mUndoStack.begin(), mUndoStack.end(), action) == mUndoStack.end());
-	PRECONDITION(std::find(mRedoStack.begin(), mRedoStack.end(), action) == mRedoStack.end());
-	
-	mUndoStack.push_back(action);				
-	
+	PRECONDITION(!this->HasCommand(action));
+
 	this->ClearRedoHistory();
-		
-	while (mUndoStack.size() > mMaxCommands)
-		mUndoStack.pop_front();
+
+	if (!this->DoMerge(action)) {				// if the action was merged it will be deleted when our caller releases it
+		this->DoPush(mUndoStack, action);
+
+		if (mUndoStack.size() > kCompactDepth) {
+			SEntry& entry = mUndoStack[mUndoStack.size() - kCompactDepth - 1];
+			if (!entry.compacted)
+				this->DoCompact(entry);
+		}
+	}
+
+	this->DoTrim();
 }
 
 
@@ -341,17 +436,601 @@ void XUndoContext::AddCommand(const IUndoActionPtr& action)
 //
 //---------------------------------------------------------------
 bool XUndoContext::HasCommand(const IUndoActionPtr& action) const
-{	
-	bool has = false;
-
-	if (std::find(mUndoStack.begin(), mUndoStack.end(), action) != mUndoStack.end())
-		has = true;
-		
-	else if (std::find(mRedoStack.begin(), mRedoStack.end(), action) != mRedoStack.end())
-		has = true;
- 
+{
+	bool has = action && mActions.find(action->GetBoss()) != mActions.end();
+
 	return has;
 }
 
 
+//---------------------------------------------------------------
+//
+// XUndoContext::DoPush
+//
+//---------------------------------------------------------------
+void XUndoContext::DoPush(Stack& stack, const IUndoActionPtr& action)
+{
+	stack.push_back(SEntry(action));
+	this->DoMeasure(stack.back());			// undo and redo will typically expand compacted actions
+
+	mActions.insert(action->GetBoss());
+}
+
+
+//---------------------------------------------------------------
+//
+// XUndoContext::DoRemove
+//
+// Removes the entry's bytes and membership (the caller removes the
+// entry from the stack).
+//
+//---------------------------------------------------------------
+void XUndoContext::DoRemove(const SEntry& entry)
+{
+	PRECONDITION(entry.bytes <= mNumBytes);
+
+	mNumBytes -= entry.bytes;
+	VERIFY(mActions.erase(entry.action->GetBoss()) == 1);
+}
+
+
+//---------------------------------------------------------------
+//
+// XUndoContext::DoClear
+//
+//---------------------------------------------------------------
+void XUndoContext::DoClear(Stack& stack)
+{
+	for (Stack::const_iterator iter = stack.begin(); iter != stack.end(); ++iter)
+		this->DoRemove(*iter);
+
+	stack.clear();
+}
+
+
+//---------------------------------------------------------------
+//
+// XUndoContext::DoMerge
+//
+// Join the two actions iff we find the merge interface, the
+// bosses match, and the action OKs the merge.
+//
+//---------------------------------------------------------------
+bool XUndoContext::DoMerge(const IUndoActionPtr& action)
+{
+	bool merged = false;
+
+	if (!mUndoStack.empty()) {
+		SEntry& top = mUndoStack.back();
+		IMergeActionsPtr merge = top.action;
+
+		if (merge && merge->GetBoss()->GetName() == action->GetBoss()->GetName() && merge->CanMerge(action)) {
+			merge->Merge(action);
+			this->DoMeasure(top);			// the merged action may have grown
+			merged = true;
+		}
+	}
+
+	return merged;
+}
+
+
+//---------------------------------------------------------------
+//
+// XUndoContext::DoCompact
+//
+// Compaction is just an optimization so errors (eg running out of
+// memory while zipping) are ignored.
+//
+//---------------------------------------------------------------
+void XUndoContext::DoCompact(SEntry& entry)
+{
+	IUndoFootprintPtr footprint = entry.action;
+
+	if (footprint) {
+		try {
+			footprint->Compact();
+
+		} catch (...) {
+			DEBUGSTR("Couldn't compact an undo action.");
+		}
+
+		this->DoMeasure(entry);
+	}
+
+	entry.compacted = true;
+}
+
+
+//---------------------------------------------------------------
+//
+// XUndoContext::DoMeasure
+//
+//---------------------------------------------------------------
+void XUndoContext::DoMeasure(SEntry& entry)
+{
+	IConstUndoFootprintPtr footprint = entry.action;
+	uint32 bytes = footprint ? footprint->GetFootprint() : kDefaultFootprint;
+
+	ASSERT(entry.bytes <= mNumBytes);
+	mNumBytes += bytes - entry.bytes;
+	entry.bytes = bytes;
+	entry.compacted = false;
+}
+
+
+//---------------------------------------------------------------
+//
+// XUndoContext::DoTrim
+//
+// Discards the oldest undo actions until we're within our limits.
+// The most recent action is always kept so that the user can undo
+// the last thing he did, even if it was huge.
+//
+//---------------------------------------------------------------
+void XUndoContext::DoTrim()
+{
+	while (mUndoStack.size() > 1 && (mUndoStack.size() > mMaxCommands || mNumBytes > mMaxBytes)) {
+		this->DoRemove(mUndoStack.front());
+		mUndoStack.pop_front();
+	}
+}
+
+#if __MWERKS__
+#pragma mark -
+#endif
+
+// ===================================================================================
+//	class ZUndoContextTest
+// ===================================================================================
+#if DEBUG
+const uint32 kNumSessionActions = 20000;
+const uint32 kNumStrokes        = 64;
+const uint32 kStrokeBytes       = 64*1024L;
+
+//---------------------------------------------------------------
+//
+// ZFootprintAction
+//
+// IUndoFootprint and IMergeActions implementation that the test
+// adds to callback actions so that it can check the byte budget.
+// Merging appends the new action's bytes to ours.
+//
+//---------------------------------------------------------------
+class ZFootprintAction : public IUndoFootprint, public IMergeActions {
+
+public:
+	virtual				~ZFootprintAction()						{}
+
+						ZFootprintAction(XBoss* boss)			{IUndoFootprint::DoSetBoss(boss); IMergeActions::DoSetBoss(boss); mMergeable = false;}
+
+	virtual uint32 		GetFootprint() const					{return mPayload.GetFootprint();}
+	virtual void 		Compact()								{mPayload.Compact();}
+
+	virtual bool		CanMerge(const IConstUndoActionPtr& newAction) const;
+	virtual void		Merge(const IConstUndoActionPtr& newAction);
+
+			void 		SetData(uint32 bytes, bool mergeable);
+			bool 		IsCompacted() const						{return mPayload.IsCompacted();}
+
+private:
+	static const ZFootprintAction* DoGetAction(const IConstUndoActionPtr& action);
+
+private:
+	XUndoPayload		mPayload;
+	bool				mMergeable;
+};
+
+DEFINE_INTERFACE_FACTORY(ZFootprintAction)
+
+
+//---------------------------------------------------------------
+//
+// ZFootprintAction::CanMerge
+//
+//---------------------------------------------------------------
+bool ZFootprintAction::CanMerge(const IConstUndoActionPtr& newAction) const
+{
+	const ZFootprintAction* action = DoGetAction(newAction);	// plain callback actions have the same boss name but no footprint
+
+	return action != nil && action->mMergeable;
+}
+
+
+//---------------------------------------------------------------
+//
+// ZFootprintAction::Merge
+//
+//---------------------------------------------------------------
+void ZFootprintAction::Merge(const IConstUndoActionPtr& newAction)
+{
+	const ZFootprintAction* action = DoGetAction(newAction);
+	PRECONDITION(action != nil);
+
+	this->SetData(mPayload.GetSize() + action->mPayload.GetSize(), mMergeable);
+}
+
+
+//---------------------------------------------------------------
+//
+// ZFootprintAction::SetData
+//
+//---------------------------------------------------------------
+void ZFootprintAction::SetData(uint32 bytes, bool mergeable)
+{
+	std::vector<uint8> data(bytes);
+	for (uint32 i = 0; i < bytes; ++i)
+		data[i] = (uint8) (i/256 + (Random(4L) == 0 ? Random(8L) : 0));	// noisy gradient so that Compact shrinks it
+
+	mPayload.SetData(&data[0], bytes);
+	mMergeable = mergeable;
+}
+
+
+//---------------------------------------------------------------
+//
+// ZFootprintAction::DoGetAction
+//
+//---------------------------------------------------------------
+const ZFootprintAction* ZFootprintAction::DoGetAction(const IConstUndoActionPtr& action)
+{
+	IConstUndoFootprintPtr footprint(action);
+	const ZFootprintAction* result = footprint ? dynamic_cast<const ZFootprintAction*>(footprint.Get()) : nil;
+
+	return result;
+}
+
+
+class ZUndoContextTest : public XUnitTest {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+	virtual				~ZUndoContextTest();
+
+						ZUndoContextTest();
+
+//-----------------------------------
+//	API
+//
+protected:
+	virtual void 		OnTest();
+
+//-----------------------------------
+//	Internal API
+//
+private:
+			void 		DoTestBudget(XUndoContext& context);
+			void 		DoTestFootprint(XUndoContext& context);
+			void 		DoTestPayload();
+			void 		DoTime(XUndoContext& context);
+
+			void 		DoCount()							{++mCount;}
+
+			IUndoActionPtr DoCreateAction();
+			IUndoActionPtr DoCreateFootprintAction(uint32 bytes, bool mergeable = false);
+
+//-----------------------------------
+//	Member Data
+//
+private:
+	uint32				mCount;
+};
+
+static ZUndoContextTest sUndoContextTest;
+
+//---------------------------------------------------------------
+//
+// ZUndoContextTest::~ZUndoContextTest
+//
+//---------------------------------------------------------------
+ZUndoContextTest::~ZUndoContextTest()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// ZUndoContextTest::ZUndoContextTest
+//
+//---------------------------------------------------------------
+ZUndoContextTest::ZUndoContextTest() : XUnitTest(L"UI", L"Undo Context")
+{
+	mCount = 0;
+}
+
+
+//---------------------------------------------------------------
+//
+// ZUndoContextTest::OnTest
+//
+// Uses its own context (on the app boss) so that the app's undo
+// history isn't affected.
+//
+//---------------------------------------------------------------
+void ZUndoContextTest::OnTest()
+{
+	IUndoContextPtr app(L"Application");
+	XUndoContext context(app->GetBoss());
+
+	this->DoTestBudget(context);
+	this->DoTestFootprint(context);
+	this->DoTestPayload();
+	this->DoTime(context);
+
+	TRACE("Completed undo context test.\n\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// ZUndoContextTest::DoTestBudget
+//
+//---------------------------------------------------------------
+void ZUndoContextTest::DoTestBudget(XUndoContext& context)
+{
+	context.SetMaxBytes(10*kDefaultFootprint);
+
+	IUndoActionPtr first = this->DoCreateAction();
+	ASSERT(!context.HasCommand(IUndoActionPtr()));
+	context.AddCommand(first);
+	ASSERT(context.HasCommand(first));
+	ASSERT(context.GetNumBytes() == kDefaultFootprint);
+
+	for (uint32 i = 0; i < 20; ++i)
+		context.AddCommand(this->DoCreateAction());
+	ASSERT(!context.HasCommand(first));
+	ASSERT(context.GetNumBytes() == 10*kDefaultFootprint);
+
+	// Undo and redo move actions between the stacks without changing the total.
+	IUndoActionPtr last = context.GetUndoCommand();
+	mCount = 0;
+	context.Undo();
+	context.Undo();
+	ASSERT(mCount == 2);
+	ASSERT(context.HasCommand(last));
+	ASSERT(context.GetRedoCommand() != last);
+	ASSERT(context.GetNumBytes() == 10*kDefaultFootprint);
+
+	context.Redo();
+	ASSERT(mCount == 3);
+	ASSERT(context.GetRedoCommand() == last);
+
+	// Adding a new action discards the redo history.
+	context.AddCommand(this->DoCreateAction());
+	ASSERT(!context.CanRedo());
+	ASSERT(!context.HasCommand(last));
+	ASSERT(context.GetNumBytes() == 10*kDefaultFootprint);
+
+	// The most recent action is kept even if it's over budget.
+	context.SetMaxBytes(kDefaultFootprint/2);
+	ASSERT(context.CanUndo());
+	ASSERT(context.GetNumBytes() == kDefaultFootprint);
+
+	context.ClearHistory();
+	ASSERT(context.GetNumBytes() == 0);
+
+	context.SetMaxBytes(kDefaultMaxBytes);
+}
+
+
+//---------------------------------------------------------------
+//
+// ZUndoContextTest::DoTestFootprint
+//
+// Checks that actions with an IUndoFootprint are compacted once
+// they're kCompactDepth down the stack, are remeasured after a
+// merge, and are trimmed when they use too many bytes.
+//
+//---------------------------------------------------------------
+void ZUndoContextTest::DoTestFootprint(XUndoContext& context)
+{
+	// Compaction
+	IUndoActionPtr stroke = this->DoCreateFootprintAction(kStrokeBytes);
+	IConstUndoFootprintPtr footprint(stroke);
+	const ZFootprintAction* action = dynamic_cast<const ZFootprintAction*>(footprint.Get());
+	uint32 strokeBytes = footprint->GetFootprint();
+
+	context.AddCommand(stroke);
+	ASSERT(context.GetNumBytes() == strokeBytes);
+
+	for (uint32 i = 0; i < kCompactDepth; ++i) {
+		ASSERT(!action->IsCompacted());
+		context.AddCommand(this->DoCreateAction());
+	}
+	ASSERT(action->IsCompacted());
+	ASSERT(footprint->GetFootprint() < strokeBytes);
+	ASSERT(context.GetNumBytes() == footprint->GetFootprint() + kCompactDepth*kDefaultFootprint);
+
+	context.ClearHistory();
+
+	// Merging
+	stroke = this->DoCreateFootprintAction(kStrokeBytes);
+	context.AddCommand(stroke);
+
+	IUndoActionPtr more = this->DoCreateFootprintAction(kStrokeBytes, true);
+	context.AddCommand(more);
+	ASSERT(context.GetUndoCommand() == stroke);
+	ASSERT(!context.HasCommand(more));
+	ASSERT(context.GetNumBytes() == IConstUndoFootprintPtr(stroke)->GetFootprint());
+	ASSERT(context.GetNumBytes() > strokeBytes);
+
+	context.ClearHistory();
+
+	// Trimming
+	context.SetMaxBytes(4*strokeBytes);
+
+	IUndoActionPtr oldest = this->DoCreateFootprintAction(kStrokeBytes);
+	context.AddCommand(oldest);
+	for (uint32 i = 0; i < 3; ++i)
+		context.AddCommand(this->DoCreateFootprintAction(kStrokeBytes));
+	ASSERT(context.HasCommand(oldest));
+	ASSERT(context.GetNumBytes() == 4*strokeBytes);
+
+	context.AddCommand(this->DoCreateFootprintAction(kStrokeBytes));
+	ASSERT(!context.HasCommand(oldest));
+	ASSERT(context.GetNumBytes() == 4*strokeBytes);
+
+	context.AddCommand(this->DoCreateFootprintAction(8*kStrokeBytes));	// the most recent action is kept even if it's over budget
+	ASSERT(context.CanUndo());
+	ASSERT(context.GetNumBytes() == IConstUndoFootprintPtr(context.GetUndoCommand())->GetFootprint());
+
+	context.ClearHistory();
+	context.SetMaxBytes(kDefaultMaxBytes);
+}
+
+
+//---------------------------------------------------------------
+//
+// ZUndoContextTest::DoTestPayload
+//
+// Compacts a bunch of paint strokes (the saved pixels are a noisy
+// gradient so they compress about as well as real images).
+//
+//---------------------------------------------------------------
+void ZUndoContextTest::DoTestPayload()
+{
+	std::vector<uint8> pixels(kStrokeBytes);
+
+	std::vector<XUndoPayload> strokes(kNumStrokes);
+	for (uint32 i = 0; i < kNumStrokes; ++i) {
+		for (uint32 j = 0; j < kStrokeBytes; ++j)
+			pixels[j] = (uint8) (j/256 + i + (Random(4L) == 0 ? Random(8L) : 0));
+		strokes[i].SetData(&pixels[0], kStrokeBytes);
+	}
+
+	uint32 rawBytes = 0;
+	for (uint32 i = 0; i < kNumStrokes; ++i)
+		rawBytes += strokes[i].GetFootprint();
+
+	MilliSecond start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumStrokes; ++i)
+		strokes[i].Compact();
+	MilliSecond compactTime = GetMilliSeconds() - start;
+
+	uint32 compactedBytes = 0;
+	for (uint32 i = 0; i < kNumStrokes; ++i) {
+		ASSERT(strokes[i].IsCompacted());
+		compactedBytes += strokes[i].GetFootprint();
+	}
+	ASSERT(compactedBytes < rawBytes);
+
+	start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumStrokes; ++i)
+		(void) strokes[i].GetData();
+	MilliSecond expandTime = GetMilliSeconds() - start;
+
+	ASSERT(!strokes.back().IsCompacted());
+	ASSERT(strokes.back().GetSize() == kStrokeBytes);
+	ASSERT(std::equal(pixels.begin(), pixels.end(), strokes.back().GetData()));
+
+	XUndoPayload tiny("abc", 3);
+	tiny.Compact();
+	ASSERT(!tiny.IsCompacted());
+
+	TRACE("Compacted ", kNumStrokes, " undo payloads from ", rawBytes/1024, "K to ", compactedBytes/1024, "K\n");
+	TRACE("   compact: ", compactTime, " ms, expand: ", expandTime, " ms\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// ZUndoContextTest::DoTime
+//
+// Simulates a long editing session: actions are added one at a
+// time with an occasional burst of undos and redos.
+//
+//---------------------------------------------------------------
+void ZUndoContextTest::DoTime(XUndoContext& context)
+{
+	std::vector<IUndoActionPtr> actions;
+	actions.reserve(kNumSessionActions);
+	for (uint32 i = 0; i < kNumSessionActions; ++i)
+		actions.push_back(this->DoCreateAction());
+
+	uint32 maxBytes = 0;
+
+	MilliSecond start = GetMilliSeconds();
+	for (uint32 i = 0; i < kNumSessionActions; ++i) {
+		context.AddCommand(actions[i]);
+
+		if (i % 100 == 99) {
+			for (uint32 j = 0; j < 10; ++j)
+				context.Undo();
+			for (uint32 j = 0; j < 10; ++j)
+				context.Redo();
+		}
+
+		maxBytes = Max(maxBytes, context.GetNumBytes());
+	}
+	MilliSecond sessionTime = GetMilliSeconds() - start;
+	ASSERT(maxBytes <= kDefaultMaxBytes);
+	ASSERT(context.HasCommand(actions.back()));
+	ASSERT(!context.HasCommand(actions.front()));
+
+	// Undo and redo the entire history.
+	uint32 numUndos = 0;
+	start = GetMilliSeconds();
+	while (context.CanUndo()) {
+		context.Undo();
+		++numUndos;
+	}
+	while (context.CanRedo())
+		context.Redo();
+	MilliSecond undoTime = GetMilliSeconds() - start;
+
+	context.ClearHistory();
+
+	TRACE("Added ", kNumSessionActions, " undo actions (with ", kNumSessionActions/5, " undos and redos) in ", sessionTime, " ms (", 1000.0*kNumSessionActions/Max(sessionTime, 1L), " actions per second)\n");
+	TRACE("   undid and redid ", numUndos, " actions in ", undoTime, " ms (", 2000.0*numUndos/Max(undoTime, 1L), " per second)\n");
+	TRACE("   the history never used more than ", maxBytes/1024, "K\n");
+}
+
+
+//---------------------------------------------------------------
+//
+// ZUndoContextTest::DoCreateAction
+//
+//---------------------------------------------------------------
+IUndoActionPtr ZUndoContextTest::DoCreateAction()
+{
+	IUndoActionPtr action(L"Undo Callback Action");
+	action->Init(L"Test Action");
+
+	IUndoCallbackActionPtr callbacks(action);
+	XCallback0<void> count(this, &ZUndoContextTest::DoCount);
+	callbacks->SetCallbacks(count, count);
+
+	return action;
+}
+
+
+//---------------------------------------------------------------
+//
+// ZUndoContextTest::DoCreateFootprintAction
+//
+// Adds a ZFootprintAction to a callback action (the same way the
+// extensible interfaces add extensions to their boss).
+//
+//---------------------------------------------------------------
+IUndoActionPtr ZUndoContextTest::DoCreateFootprintAction(uint32 bytes, bool mergeable)
+{
+	IUndoActionPtr action = this->DoCreateAction();
+
+	XBoss* boss = action->GetBoss();
+	XImplementation* implementation = new XImplementation(CreateZFootprintAction, true, L"ZFootprintAction");
+	boss->AddInterface(FromAsciiStr(typeid(IUndoFootprint).name()), implementation);
+	boss->AddInterface(FromAsciiStr(typeid(IMergeActions).name()), implementation);
+
+	IUndoFootprintPtr footprint(action);
+	ZFootprintAction* footprintAction = dynamic_cast<ZFootprintAction*>(footprint.Get());
+	ASSERT(footprintAction != nil);
+	footprintAction->SetData(bytes, mergeable);
+
+	return action;
+}
+#endif	// DEBUG
+
+
 }	// namespace Whisper
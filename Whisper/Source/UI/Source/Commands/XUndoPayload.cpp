@@ -0,0 +1,139 @@
+/*
+ *  File:       XUndoPayload.cpp
+ *  Summary:   	Buffer for undo state that can be compressed while it's deep in the undo stack.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XUndoPayload.cpp,v $
+ */
+
+#include <XWhisperHeader.h>
+#include <XUndoPayload.h>
+
+namespace Whisper {
+
+
+//-----------------------------------
+//	Internal Constants
+//
+const uint32 kMinCompactBytes = 256;		// smaller payloads aren't worth zipping
+
+
+// ===================================================================================
+//	class XUndoPayload
+// ===================================================================================
+
+//---------------------------------------------------------------
+//
+// XUndoPayload::~XUndoPayload
+//
+//---------------------------------------------------------------
+XUndoPayload::~XUndoPayload()
+{
+}
+
+
+//---------------------------------------------------------------
+//
+// XUndoPayload::XUndoPayload ()
+//
+//---------------------------------------------------------------
+XUndoPayload::XUndoPayload()
+{
+	mSize = 0;
+	mCompacted = false;
+}
+
+
+//---------------------------------------------------------------
+//
+// XUndoPayload::XUndoPayload (void*, uint32)
+//
+//---------------------------------------------------------------
+XUndoPayload::XUndoPayload(const void* data, uint32 bytes)
+{
+	mSize = 0;
+	mCompacted = false;
+
+	this->SetData(data, bytes);
+}
+
+
+//---------------------------------------------------------------
+//
+// XUndoPayload::SetData
+//
+//---------------------------------------------------------------
+void XUndoPayload::SetData(const void* data, uint32 bytes)
+{
+	PRECONDITION(data != nil || bytes == 0);
+
+	const uint8* begin = static_cast<const uint8*>(data);
+	std::vector<uint8>(begin, begin + bytes).swap(mData);
+
+	mSize = bytes;
+	mCompacted = false;
+}
+
+
+//---------------------------------------------------------------
+//
+// XUndoPayload::GetData
+//
+//---------------------------------------------------------------
+const uint8* XUndoPayload::GetData()
+{
+	this->Expand();
+
+	const uint8* data = mData.empty() ? nil : &mData[0];
+
+	return data;
+}
+
+
+//---------------------------------------------------------------
+//
+// XUndoPayload::Compact
+//
+//---------------------------------------------------------------
+void XUndoPayload::Compact(int16 level)
+{
+	if (!mCompacted && mSize >= kMinCompactBytes) {
+		std::vector<uint8> buffer(GetMaxZippedBytes(mSize));
+
+		uint32 bytes = buffer.size();
+		Zip(&mData[0], mSize, &buffer[0], &bytes, level);
+
+		if (bytes < mSize) {
+			std::vector<uint8>(buffer.begin(), buffer.begin() + bytes).swap(mData);	// swap so the capacity shrinks too
+			mCompacted = true;
+		}
+	}
+}
+
+
+//---------------------------------------------------------------
+//
+// XUndoPayload::Expand
+//
+//---------------------------------------------------------------
+void XUndoPayload::Expand()
+{
+	if (mCompacted) {
+		std::vector<uint8> buffer(mSize);
+
+		uint32 bytes = mSize;
+		Unzip(&mData[0], mData.size(), &buffer[0], &bytes);
+		ASSERT(bytes == mSize);
+
+		mData.swap(buffer);
+		mCompacted = false;
+	}
+}
+
+
+}	// namespace Whisper
@@ -0,0 +1,89 @@
+/*
+ *  File:       XUndoPayload.h
+ *  Summary:   	Buffer for undo state that can be compressed while it's deep in the undo stack.
+ *  Written by: Jesse Jones
+ *
+ *  Copyright  2001 Jesse Jones. 
+ *	This code is distributed under the zlib/libpng license (see License.txt for details).  
+ *
+ *  Change History (most recent first):	
+ *
+ *		$Log: XUndoPayload.h,v $
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <XCompress.h>
+
+namespace Whisper {
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export on
+#endif
+
+
+// ===================================================================================
+//	class XUndoPayload
+//!		Buffer for undo state that can be compressed while it's deep in the undo stack.
+/*!		Undo actions that save large blocks of memory can use this to implement
+ *		IUndoFootprint: GetFootprint and Compact simply forward to the payload and
+ *		GetData transparently unzips the data when the action is undone or redone. */
+// ===================================================================================
+class UI_EXPORT XUndoPayload {
+
+//-----------------------------------
+//	Initialization/Destruction
+//
+public:
+						~XUndoPayload();
+
+						XUndoPayload();
+
+						XUndoPayload(const void* data, uint32 bytes);
+
+//-----------------------------------
+//	API
+//
+public:
+	//! @name Data
+	//@{
+			void 		SetData(const void* data, uint32 bytes);
+
+			const uint8* GetData();
+						/**< Expands the data if it's been compacted. Returns nil if the
+						payload is empty. */
+
+			uint32 		GetSize() const								{return mSize;}
+						/**< Returns the number of bytes in the uncompressed data. */
+	//@}
+
+	//! @name Compaction
+	//@{
+			uint32 		GetFootprint() const						{return mData.capacity();}
+						/**< Returns the number of bytes currently used by the payload. */
+
+			void 		Compact(int16 level = kFastestCompress);
+						/**< Zips the data (if it's large enough and actually shrinks). */
+
+			void 		Expand();
+
+			bool 		IsCompacted() const							{return mCompacted;}
+	//@}
+
+//-----------------------------------
+//	Member Data
+//
+protected:
+	std::vector<uint8>	mData;
+	uint32				mSize;
+	bool				mCompacted;
+};
+
+
+#if MULTI_FRAGMENT_APP && PRAGMA_EXPORT_SUPPORTED
+	#pragma export reset
+#endif
+
+}	// namespace Whisper